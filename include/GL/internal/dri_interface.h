@@ -978,6 +978,12 @@ struct __DRIdri2LoaderExtensionRec {
  */
 #define __DRI_CTX_FLAG_ROBUST_BUFFER_ACCESS	0x00000004
 
+/**
+ * Context created without error checking (KHR_no_error).  The driver may
+ * skip parameter and state validation in the entry points it hands out.
+ */
+#define __DRI_CTX_FLAG_NO_ERROR			0x00000008
+
 /**
  * \name Context reset strategies.
  */
@@ -1444,6 +1450,7 @@ typedef struct __DRIDriverVtableExtensionRec {
 #define __DRI2_RENDERER_OPENGL_COMPATIBILITY_PROFILE_VERSION  0x0008
 #define __DRI2_RENDERER_OPENGL_ES_PROFILE_VERSION             0x0009
 #define __DRI2_RENDERER_OPENGL_ES2_PROFILE_VERSION            0x000a
+#define __DRI2_RENDERER_HAS_NO_ERROR_CONTEXT                  0x000b
 
 typedef struct __DRI2rendererQueryExtensionRec __DRI2rendererQueryExtension;
 struct __DRI2rendererQueryExtensionRec {
@@ -500,6 +500,23 @@ dri2_load_driver_swrast(_EGLDisplay *disp)
    return EGL_TRUE;
 }
 
+/**
+ * Query an integer renderer property of the driver, or return 0 if the
+ * driver does not know about it.
+ */
+static unsigned
+dri2_renderer_query_integer(struct dri2_egl_display *dri2_dpy, int param)
+{
+   unsigned int value = 0;
+
+   if (!dri2_dpy->rendererQuery ||
+       dri2_dpy->rendererQuery->queryInteger(dri2_dpy->dri_screen,
+                                             param, &value) == -1)
+      return 0;
+
+   return value;
+}
+
 void
 dri2_setup_screen(_EGLDisplay *disp)
 {
@@ -532,6 +549,10 @@ dri2_setup_screen(_EGLDisplay *disp)
 
    if (dri2_dpy->dri2 && dri2_dpy->dri2->base.version >= 3) {
       disp->Extensions.KHR_create_context = EGL_TRUE;
+      /* Some classic drivers reject __DRI_CTX_FLAG_NO_ERROR */
+      disp->Extensions.KHR_create_context_no_error =
+         dri2_renderer_query_integer(dri2_dpy,
+                                     __DRI2_RENDERER_HAS_NO_ERROR_CONTEXT);
 
       if (dri2_dpy->robustness)
          disp->Extensions.EXT_create_context_robustness = EGL_TRUE;
@@ -644,6 +665,9 @@ dri2_create_screen(_EGLDisplay *disp)
       if (strcmp(extensions[i]->name, __DRI2_FENCE) == 0) {
          dri2_dpy->fence = (__DRI2fenceExtension *) extensions[i];
       }
+      if (strcmp(extensions[i]->name, __DRI2_RENDERER_QUERY) == 0) {
+         dri2_dpy->rendererQuery = (__DRI2rendererQueryExtension *) extensions[i];
+      }
    }
 
    dri2_setup_screen(disp);
@@ -865,6 +889,17 @@ dri2_create_context(_EGLDriver *drv, _EGLDisplay *disp, _EGLConfig *conf,
    if (!_eglInitContext(&dri2_ctx->base, disp, conf, attrib_list))
       goto cleanup;
 
+   /* The EGL_KHR_create_context_no_error spec says:
+    *
+    *     "BAD_MATCH is generated if the value of EGL_CONTEXT_OPENGL_NO_ERROR_KHR
+    *     used to create <share_context> does not match the value of
+    *     EGL_CONTEXT_OPENGL_NO_ERROR_KHR for the context being created."
+    */
+   if (share_list && share_list->NoError != dri2_ctx->base.NoError) {
+      _eglError(EGL_BAD_MATCH, "eglCreateContext");
+      goto cleanup;
+   }
+
    switch (dri2_ctx->base.ClientAPI) {
    case EGL_OPENGL_ES_API:
       switch (dri2_ctx->base.ClientMajorVersion) {
@@ -931,7 +966,12 @@ dri2_create_context(_EGLDriver *drv, _EGLDisplay *disp, _EGLConfig *conf,
          ctx_attribs[num_attribs++] = __DRI_CTX_ATTRIB_MINOR_VERSION;
          ctx_attribs[num_attribs++] = dri2_ctx->base.ClientMinorVersion;
 
-         if (dri2_ctx->base.Flags != 0) {
+         if (dri2_ctx->base.Flags != 0 || dri2_ctx->base.NoError) {
+            /* The EGL_CONTEXT_OPENGL_*_BIT_KHR flags have the same values as
+             * the corresponding __DRI_CTX_FLAG_* bits.
+             */
+            uint32_t flags = dri2_ctx->base.Flags;
+
             /* If the implementation doesn't support the __DRI2_ROBUSTNESS
              * extension, don't even try to send it the robust-access flag.
              * It may explode.  Instead, generate the required EGL error here.
@@ -942,8 +982,11 @@ dri2_create_context(_EGLDriver *drv, _EGLDisplay *disp, _EGLConfig *conf,
                goto cleanup;
             }
 
+            if (dri2_ctx->base.NoError)
+               flags |= __DRI_CTX_FLAG_NO_ERROR;
+
             ctx_attribs[num_attribs++] = __DRI_CTX_ATTRIB_FLAGS;
-            ctx_attribs[num_attribs++] = dri2_ctx->base.Flags;
+            ctx_attribs[num_attribs++] = flags;
          }
 
          if (dri2_ctx->base.ResetNotificationStrategy != EGL_NO_RESET_NOTIFICATION_KHR) {
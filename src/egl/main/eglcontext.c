@@ -228,6 +228,20 @@ _eglParseContextAttribList(_EGLContext *ctx, _EGLDisplay *dpy,
             ctx->Flags |= EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE_BIT_KHR;
          break;
 
+      case EGL_CONTEXT_OPENGL_NO_ERROR_KHR:
+         if (!dpy->Extensions.KHR_create_context_no_error) {
+            err = EGL_BAD_ATTRIBUTE;
+            break;
+         }
+
+         if (val != EGL_TRUE && val != EGL_FALSE) {
+            err = EGL_BAD_ATTRIBUTE;
+            break;
+         }
+
+         ctx->NoError = !!val;
+         break;
+
       default:
          err = EGL_BAD_ATTRIBUTE;
          break;
@@ -380,6 +394,16 @@ _eglParseContextAttribList(_EGLContext *ctx, _EGLDisplay *dpy,
       err = EGL_BAD_ATTRIBUTE;
    }
 
+   /* The EGL_KHR_create_context_no_error spec says:
+    *
+    *     "BAD_MATCH is generated if the EGL_CONTEXT_OPENGL_NO_ERROR_KHR is TRUE
+    *     at the same time as a debug or robustness context is specified."
+    */
+   if (ctx->NoError && (ctx->Flags & (EGL_CONTEXT_OPENGL_DEBUG_BIT_KHR
+                                      | EGL_CONTEXT_OPENGL_ROBUST_ACCESS_BIT_KHR))) {
+      err = EGL_BAD_MATCH;
+   }
+
    return err;
 }
 
@@ -409,6 +433,7 @@ _eglInitContext(_EGLContext *ctx, _EGLDisplay *dpy, _EGLConfig *conf,
    ctx->ClientMajorVersion = 1; /* the default, per EGL spec */
    ctx->ClientMinorVersion = 0;
    ctx->Flags = 0;
+   ctx->NoError = EGL_FALSE;
    ctx->Profile = EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR;
    ctx->ResetNotificationStrategy = EGL_NO_RESET_NOTIFICATION_KHR;
 
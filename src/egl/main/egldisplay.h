@@ -115,6 +115,7 @@ struct _egl_extensions
 
    EGLBoolean KHR_surfaceless_context;
    EGLBoolean KHR_create_context;
+   EGLBoolean KHR_create_context_no_error;
 
    EGLBoolean NOK_swap_region;
    EGLBoolean NOK_texture_from_pixmap;
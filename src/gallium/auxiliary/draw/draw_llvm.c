@@ -50,6 +50,7 @@
 
 #include "tgsi/tgsi_exec.h"
 #include "tgsi/tgsi_dump.h"
+#include "tgsi/tgsi_parse.h"
 
 #include "util/u_math.h"
 #include "util/u_pointer.h"
@@ -562,6 +563,26 @@ draw_llvm_create_variant(struct draw_llvm *llvm,
 
    variant->gallivm = gallivm_create(module_name, llvm->context);
 
+   /* The variants are per vertex shader, whose outputs and tokens decide
+    * the code along with the key, and so does the vertex layout.
+    */
+   {
+      const struct draw_context *draw = llvm->draw;
+      const struct tgsi_token *tokens = draw->vs.vertex_shader->state.tokens;
+
+      gallivm_add_cache_key(variant->gallivm, tokens,
+                            tgsi_num_tokens(tokens) * sizeof *tokens);
+      gallivm_add_cache_key(variant->gallivm, key, shader->variant_key_size);
+      gallivm_add_cache_key(variant->gallivm, &num_inputs, sizeof num_inputs);
+      gallivm_add_cache_key(variant->gallivm, &draw->vs.position_output,
+                            sizeof draw->vs.position_output);
+      gallivm_add_cache_key(variant->gallivm, &draw->vs.clipvertex_output,
+                            sizeof draw->vs.clipvertex_output);
+      gallivm_add_cache_key(variant->gallivm, draw->pt.vertex_element,
+                            draw->pt.nr_vertex_elements *
+                            sizeof draw->pt.vertex_element[0]);
+   }
+
    create_jit_types(variant);
 
    memcpy(&variant->key, key, shader->variant_key_size);
@@ -627,6 +648,7 @@ generate_vs(struct draw_llvm_variant *variant,
                      context_ptr,
                      draw_sampler,
                      &llvm->draw->vs.vertex_shader->info,
+                     NULL,
                      NULL);
 
    {
@@ -2195,7 +2217,8 @@ draw_gs_llvm_generate(struct draw_llvm *llvm,
                      context_ptr,
                      sampler,
                      &llvm->draw->gs.geometry_shader->info,
-                     (const struct lp_build_tgsi_gs_iface *)&gs_iface);
+                     (const struct lp_build_tgsi_gs_iface *)&gs_iface,
+                     NULL);
 
    sampler->destroy(sampler);
 
@@ -2232,6 +2255,16 @@ draw_gs_llvm_create_variant(struct draw_llvm *llvm,
 
    variant->gallivm = gallivm_create(module_name, llvm->context);
 
+   {
+      const struct tgsi_token *tokens = shader->base.state.tokens;
+
+      gallivm_add_cache_key(variant->gallivm, tokens,
+                            tgsi_num_tokens(tokens) * sizeof *tokens);
+      gallivm_add_cache_key(variant->gallivm, key, shader->variant_key_size);
+      gallivm_add_cache_key(variant->gallivm, &num_outputs,
+                            sizeof num_outputs);
+   }
+
    create_gs_jit_types(variant);
 
    memcpy(&variant->key, key, shader->variant_key_size);
@@ -25,6 +25,7 @@
  *
  **************************************************************************/
 
+#include "util/u_cpu_detect.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_prim.h"
@@ -36,9 +37,38 @@
 #include "draw/draw_prim_assembler.h"
 #include "draw/draw_vs.h"
 #include "draw/draw_llvm.h"
+#include "draw/draw_threads.h"
 #include "gallivm/lp_bld_init.h"
 
 
+DEBUG_GET_ONCE_NUM_OPTION(draw_num_threads, "DRAW_NUM_THREADS", -1)
+/* The vsplit front end hands indexed draws to the middle end in chunks of
+ * at most 1024 vertices (1023 for triangle lists), so the threshold has to
+ * stay well below that for those draws to be split at all.
+ */
+DEBUG_GET_ONCE_NUM_OPTION(draw_mt_threshold, "DRAW_MT_THRESHOLD", 256)
+
+
+/**
+ * Number of extra threads to shade vertices with: DRAW_NUM_THREADS, or by
+ * default one less than the number of CPUs when there are more than two,
+ * as the calling thread also shades and drivers have threads of their own.
+ */
+static unsigned
+draw_get_num_threads(void)
+{
+   long num_threads = debug_get_option_draw_num_threads();
+
+   if (num_threads < 0) {
+      util_cpu_detect();
+      num_threads = util_cpu_caps.nr_cpus > 2 ?
+                    (long) util_cpu_caps.nr_cpus - 1 : 0;
+   }
+
+   return (unsigned) CLAMP(num_threads, 0, DRAW_MAX_THREADS);
+}
+
+
 struct llvm_middle_end {
    struct draw_pt_middle_end base;
    struct draw_context *draw;
@@ -56,6 +86,26 @@ struct llvm_middle_end {
 
    struct draw_llvm *llvm;
    struct draw_llvm_variant *current_variant;
+
+   /* Vertex shading of large draws is split across these threads,
+    * created on first use.
+    */
+   struct draw_thread_pool *threads;
+   unsigned num_threads;
+   unsigned mt_threshold;   /**< min vertex count to go multi-threaded */
+};
+
+
+/**
+ * One parallel vertex shading run: job i shades vertices
+ * [i * chunk, (i + 1) * chunk) of the fetch.
+ */
+struct llvm_shade_job {
+   struct llvm_middle_end *fpme;
+   const struct draw_fetch_info *fetch_info;
+   struct vertex_header *verts;
+   unsigned chunk;
+   int clipped[DRAW_MAX_THREADS + 1];
 };
 
 
@@ -336,6 +386,112 @@ emit(struct pt_emit *emit,
 }
 
 
+/**
+ * Fetch and shade count vertices of the fetch, starting at first.
+ * Only touches the output vertices in that range, so disjoint ranges
+ * can be shaded concurrently.
+ */
+static int
+llvm_shade_range(struct llvm_middle_end *fpme,
+                 const struct draw_fetch_info *fetch_info,
+                 struct vertex_header *verts,
+                 unsigned first,
+                 unsigned count)
+{
+   struct draw_context *draw = fpme->draw;
+   struct vertex_header *io = (struct vertex_header *)
+      ((char *)verts + first * fpme->vertex_size);
+
+   if (fetch_info->linear)
+      return fpme->current_variant->jit_func( &fpme->llvm->jit_context,
+                                       io,
+                                       draw->pt.user.vbuffer,
+                                       fetch_info->start + first,
+                                       count,
+                                       fpme->vertex_size,
+                                       draw->pt.vertex_buffer,
+                                       draw->instance_id,
+                                       draw->start_index,
+                                       draw->start_instance);
+   else
+      return fpme->current_variant->jit_func_elts( &fpme->llvm->jit_context,
+                                            io,
+                                            draw->pt.user.vbuffer,
+                                            fetch_info->elts + first,
+                                            draw->pt.user.eltMax -
+                                               MIN2(first, draw->pt.user.eltMax),
+                                            count,
+                                            fpme->vertex_size,
+                                            draw->pt.vertex_buffer,
+                                            draw->instance_id,
+                                            draw->pt.user.eltBias,
+                                            draw->start_instance);
+}
+
+
+static void
+llvm_shade_job_run(void *data, unsigned job)
+{
+   struct llvm_shade_job *shade = (struct llvm_shade_job *) data;
+   unsigned first = job * shade->chunk;
+   unsigned count = MIN2(shade->chunk, shade->fetch_info->count - first);
+
+   shade->clipped[job] = llvm_shade_range(shade->fpme, shade->fetch_info,
+                                          shade->verts, first, count);
+}
+
+
+/**
+ * Fetch and shade all vertices of the fetch, splitting the work across
+ * the worker threads for large draws.  The vertices end up in the same
+ * place whichever thread shaded them, so primitive order is unaffected.
+ * Returns non-zero if any vertex needs clipping.
+ */
+static int
+llvm_shade(struct llvm_middle_end *fpme,
+           const struct draw_fetch_info *fetch_info,
+           struct vertex_header *verts)
+{
+   const unsigned vector_length = lp_native_vector_width / 32;
+   struct llvm_shade_job shade;
+   unsigned num_jobs, i;
+   int clipped = 0;
+
+   if (fpme->num_threads == 0 ||
+       fetch_info->count < MAX2(fpme->mt_threshold, 2 * vector_length)) {
+      return llvm_shade_range(fpme, fetch_info, verts, 0, fetch_info->count);
+   }
+
+   if (!fpme->threads) {
+      fpme->threads = draw_thread_pool_create(fpme->num_threads);
+      if (!fpme->threads) {
+         fpme->num_threads = 0;
+         return llvm_shade_range(fpme, fetch_info, verts, 0, fetch_info->count);
+      }
+   }
+
+   /* The shader writes whole vectors of vertices, so chunks must be
+    * multiples of the vector length for jobs not to overlap.
+    */
+   num_jobs = draw_thread_pool_size(fpme->threads);
+   shade.chunk = align(DIV_ROUND_UP(fetch_info->count, num_jobs),
+                       vector_length);
+   num_jobs = DIV_ROUND_UP(fetch_info->count, shade.chunk);
+
+   shade.fpme = fpme;
+   shade.fetch_info = fetch_info;
+   shade.verts = verts;
+
+   draw_thread_pool_run(fpme->threads, llvm_shade_job_run, &shade, num_jobs);
+
+   for (i = 0; i < num_jobs; i++) {
+      clipped |= shade.clipped[i];
+   }
+
+   return clipped;
+}
+
+
 static void
 llvm_pipeline_generic(struct draw_pt_middle_end *middle,
                       const struct draw_fetch_info *fetch_info,
@@ -373,29 +529,7 @@ llvm_pipeline_generic(struct draw_pt_middle_end *middle,
       draw->statistics.vs_invocations += fetch_info->count;
    }
 
-   if (fetch_info->linear)
-      clipped = fpme->current_variant->jit_func( &fpme->llvm->jit_context,
-                                       llvm_vert_info.verts,
-                                       draw->pt.user.vbuffer,
-                                       fetch_info->start,
-                                       fetch_info->count,
-                                       fpme->vertex_size,
-                                       draw->pt.vertex_buffer,
-                                       draw->instance_id,
-                                       draw->start_index,
-                                       draw->start_instance);
-   else
-      clipped = fpme->current_variant->jit_func_elts( &fpme->llvm->jit_context,
-                                            llvm_vert_info.verts,
-                                            draw->pt.user.vbuffer,
-                                            fetch_info->elts,
-                                            draw->pt.user.eltMax,
-                                            fetch_info->count,
-                                            fpme->vertex_size,
-                                            draw->pt.vertex_buffer,
-                                            draw->instance_id,
-                                            draw->pt.user.eltBias,
-                                            draw->start_instance);
+   clipped = llvm_shade(fpme, fetch_info, llvm_vert_info.verts);
 
    /* Finished with fetch and vs:
     */
@@ -575,6 +709,8 @@ llvm_middle_end_destroy(struct draw_pt_middle_end *middle)
 {
    struct llvm_middle_end *fpme = llvm_middle_end(middle);
 
+   draw_thread_pool_destroy( fpme->threads );
+
    if (fpme->fetch)
       draw_pt_fetch_destroy( fpme->fetch );
 
@@ -635,6 +771,9 @@ draw_pt_fetch_pipeline_or_emit_llvm(struct draw_context *draw)
 
    fpme->current_variant = NULL;
 
+   fpme->num_threads = draw_get_num_threads();
+   fpme->mt_threshold = debug_get_option_draw_mt_threshold();
+
    return &fpme->base;
 
  fail:
@@ -0,0 +1,201 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "util/u_string.h"
+#include "os/os_thread.h"
+#include "draw/draw_threads.h"
+
+
+struct draw_thread_task
+{
+   struct draw_thread_pool *pool;
+   unsigned index;
+
+   pipe_semaphore work_ready;
+   pipe_semaphore work_done;
+};
+
+
+struct draw_thread_pool
+{
+   unsigned num_threads;
+   boolean exit_flag;
+
+   /* The current job, only valid between work_ready and work_done */
+   draw_thread_job_func func;
+   void *data;
+   unsigned fpstate;
+
+   struct draw_thread_task tasks[DRAW_MAX_THREADS];
+   pipe_thread threads[DRAW_MAX_THREADS];
+};
+
+
+static PIPE_THREAD_ROUTINE( thread_function, init_data )
+{
+   struct draw_thread_task *task = (struct draw_thread_task *) init_data;
+   struct draw_thread_pool *pool = task->pool;
+   char thread_name[16];
+
+   util_snprintf(thread_name, sizeof thread_name, "draw-%u", task->index);
+   pipe_thread_setname(thread_name);
+
+   while (1) {
+      pipe_semaphore_wait(&task->work_ready);
+
+      if (pool->exit_flag)
+         break;
+
+      /* Shade with the same denorm/rounding behaviour as the caller, so
+       * results don't depend on which thread a vertex ended up on.
+       */
+      util_fpstate_set(pool->fpstate);
+
+      pool->func(pool->data, task->index + 1);
+
+      pipe_semaphore_signal(&task->work_done);
+   }
+
+#ifdef _WIN32
+   pipe_semaphore_signal(&task->work_done);
+#endif
+
+   return 0;
+}
+
+
+/**
+ * Create a pool of num_threads worker threads.
+ * Returns NULL if num_threads is zero.
+ */
+struct draw_thread_pool *
+draw_thread_pool_create(unsigned num_threads)
+{
+   struct draw_thread_pool *pool;
+   unsigned i;
+
+   num_threads = MIN2(num_threads, DRAW_MAX_THREADS);
+   if (!num_threads)
+      return NULL;
+
+   pool = CALLOC_STRUCT(draw_thread_pool);
+   if (!pool)
+      return NULL;
+
+   pool->num_threads = num_threads;
+
+   for (i = 0; i < num_threads; i++) {
+      pool->tasks[i].pool = pool;
+      pool->tasks[i].index = i;
+      pipe_semaphore_init(&pool->tasks[i].work_ready, 0);
+      pipe_semaphore_init(&pool->tasks[i].work_done, 0);
+      pool->threads[i] = pipe_thread_create(thread_function,
+                                            (void *) &pool->tasks[i]);
+   }
+
+   return pool;
+}
+
+
+void
+draw_thread_pool_destroy(struct draw_thread_pool *pool)
+{
+   unsigned i;
+
+   if (!pool)
+      return;
+
+   pool->exit_flag = TRUE;
+   for (i = 0; i < pool->num_threads; i++) {
+      pipe_semaphore_signal(&pool->tasks[i].work_ready);
+   }
+
+   /* See lp_rast_destroy() for why we don't use pipe_thread_wait on Windows */
+   for (i = 0; i < pool->num_threads; i++) {
+#ifdef _WIN32
+      pipe_semaphore_wait(&pool->tasks[i].work_done);
+#else
+      pipe_thread_wait(pool->threads[i]);
+#endif
+   }
+
+   for (i = 0; i < pool->num_threads; i++) {
+      pipe_semaphore_destroy(&pool->tasks[i].work_ready);
+      pipe_semaphore_destroy(&pool->tasks[i].work_done);
+   }
+
+   FREE(pool);
+}
+
+
+/**
+ * Max number of jobs which can run concurrently, including the caller.
+ */
+unsigned
+draw_thread_pool_size(const struct draw_thread_pool *pool)
+{
+   return pool ? pool->num_threads + 1 : 1;
+}
+
+
+/**
+ * Run func(data, job) for every job in [0, num_jobs), job 0 on the
+ * calling thread and the others on the workers, and wait for all of them.
+ * num_jobs must not exceed draw_thread_pool_size().
+ */
+void
+draw_thread_pool_run(struct draw_thread_pool *pool,
+                     draw_thread_job_func func,
+                     void *data,
+                     unsigned num_jobs)
+{
+   unsigned i;
+
+   assert(num_jobs <= draw_thread_pool_size(pool));
+
+   if (num_jobs == 0)
+      return;
+
+   if (num_jobs > 1) {
+      pool->func = func;
+      pool->data = data;
+      pool->fpstate = util_fpstate_get();
+
+      for (i = 1; i < num_jobs; i++) {
+         pipe_semaphore_signal(&pool->tasks[i - 1].work_ready);
+      }
+   }
+
+   func(data, 0);
+
+   for (i = 1; i < num_jobs; i++) {
+      pipe_semaphore_wait(&pool->tasks[i - 1].work_done);
+   }
+}
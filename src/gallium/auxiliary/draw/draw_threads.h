@@ -0,0 +1,68 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/*
+ * A small pool of worker threads used to run the vertex shader of large
+ * draws in parallel.  Jobs are independent; the caller takes part in the
+ * work and returns only once all jobs are done, so anything order
+ * dependent (primitive assembly, clipping, emit) stays on the calling
+ * thread.
+ */
+
+#ifndef DRAW_THREADS_H
+#define DRAW_THREADS_H
+
+#include "pipe/p_compiler.h"
+
+
+/** Max number of worker threads, in addition to the calling thread */
+#define DRAW_MAX_THREADS 8
+
+
+struct draw_thread_pool;
+
+typedef void (*draw_thread_job_func)(void *data, unsigned job);
+
+
+struct draw_thread_pool *
+draw_thread_pool_create(unsigned num_threads);
+
+void
+draw_thread_pool_destroy(struct draw_thread_pool *pool);
+
+unsigned
+draw_thread_pool_size(const struct draw_thread_pool *pool);
+
+void
+draw_thread_pool_run(struct draw_thread_pool *pool,
+                     draw_thread_job_func func,
+                     void *data,
+                     unsigned num_jobs);
+
+
+#endif /* DRAW_THREADS_H */
@@ -143,6 +143,18 @@ lp_build_min_simple(struct lp_build_context *bld,
          intrinsic = "llvm.ppc.altivec.vminfp";
          intr_size = 128;
       }
+   } else if (util_cpu_caps.has_avx2 && !type.floating &&
+              type.width * type.length >= 256) {
+      intr_size = 256;
+      if (type.width == 8) {
+         intrinsic = type.sign ? "llvm.x86.avx2.pmins.b" : "llvm.x86.avx2.pminu.b";
+      }
+      else if (type.width == 16) {
+         intrinsic = type.sign ? "llvm.x86.avx2.pmins.w" : "llvm.x86.avx2.pminu.w";
+      }
+      else if (type.width == 32) {
+         intrinsic = type.sign ? "llvm.x86.avx2.pmins.d" : "llvm.x86.avx2.pminu.d";
+      }
    } else if (util_cpu_caps.has_sse2 && type.length >= 2) {
       intr_size = 128;
       if ((type.width == 8 || type.width == 16) &&
@@ -324,6 +336,18 @@ lp_build_max_simple(struct lp_build_context *bld,
          intrinsic = "llvm.ppc.altivec.vmaxfp";
          intr_size = 128;
       }
+   } else if (util_cpu_caps.has_avx2 && !type.floating &&
+              type.width * type.length >= 256) {
+      intr_size = 256;
+      if (type.width == 8) {
+         intrinsic = type.sign ? "llvm.x86.avx2.pmaxs.b" : "llvm.x86.avx2.pmaxu.b";
+      }
+      else if (type.width == 16) {
+         intrinsic = type.sign ? "llvm.x86.avx2.pmaxs.w" : "llvm.x86.avx2.pmaxu.w";
+      }
+      else if (type.width == 32) {
+         intrinsic = type.sign ? "llvm.x86.avx2.pmaxs.d" : "llvm.x86.avx2.pmaxu.d";
+      }
    } else if (util_cpu_caps.has_sse2 && type.length >= 2) {
       intr_size = 128;
       if ((type.width == 8 || type.width == 16) &&
@@ -503,7 +527,15 @@ lp_build_add(struct lp_build_context *bld,
       if(a == bld->one || b == bld->one)
         return bld->one;
 
-      if (type.width * type.length == 128 &&
+      if (type.width * type.length == 256 &&
+          !type.floating && !type.fixed &&
+          util_cpu_caps.has_avx2) {
+         if(type.width == 8)
+            intrinsic = type.sign ? "llvm.x86.avx2.padds.b" : "llvm.x86.avx2.paddus.b";
+         if(type.width == 16)
+            intrinsic = type.sign ? "llvm.x86.avx2.padds.w" : "llvm.x86.avx2.paddus.w";
+      }
+      else if (type.width * type.length == 128 &&
           !type.floating && !type.fixed) {
          if(util_cpu_caps.has_sse2) {
            if(type.width == 8)
@@ -795,7 +827,15 @@ lp_build_sub(struct lp_build_context *bld,
       if(b == bld->one)
         return bld->zero;
 
-      if (type.width * type.length == 128 &&
+      if (type.width * type.length == 256 &&
+          !type.floating && !type.fixed &&
+          util_cpu_caps.has_avx2) {
+         if(type.width == 8)
+            intrinsic = type.sign ? "llvm.x86.avx2.psubs.b" : "llvm.x86.avx2.psubus.b";
+         if(type.width == 16)
+            intrinsic = type.sign ? "llvm.x86.avx2.psubs.w" : "llvm.x86.avx2.psubus.w";
+      }
+      else if (type.width * type.length == 128 &&
           !type.floating && !type.fixed) {
          if (util_cpu_caps.has_sse2) {
            if(type.width == 8)
@@ -1023,6 +1063,55 @@ lp_build_mul(struct lp_build_context *bld,
 }
 
 
+/**
+ * Generate a * b + c
+ *
+ * For floats this uses a fused multiply-add when the cpu has FMA. The
+ * result is not rounded after the multiply, so it can differ from a
+ * separate mul + add; only use it where that is allowed.
+ */
+LLVMValueRef
+lp_build_mad(struct lp_build_context *bld,
+             LLVMValueRef a,
+             LLVMValueRef b,
+             LLVMValueRef c)
+{
+   const struct lp_type type = bld->type;
+
+   assert(lp_check_value(type, a));
+   assert(lp_check_value(type, b));
+   assert(lp_check_value(type, c));
+
+   if (type.floating &&
+       util_cpu_caps.has_fma &&
+       (type.width == 32 || type.width == 64) &&
+       !(LLVMIsConstant(a) && LLVMIsConstant(b)) &&
+       a != bld->zero && a != bld->one && a != bld->undef &&
+       b != bld->zero && b != bld->one && b != bld->undef &&
+       c != bld->zero && c != bld->undef) {
+      LLVMValueRef args[3];
+      char intrinsic[32];
+
+      if (type.length == 1) {
+         util_snprintf(intrinsic, sizeof intrinsic, "llvm.fmuladd.f%u",
+                       type.width);
+      }
+      else {
+         util_snprintf(intrinsic, sizeof intrinsic, "llvm.fmuladd.v%uf%u",
+                       type.length, type.width);
+      }
+
+      args[0] = a;
+      args[1] = b;
+      args[2] = c;
+      return lp_build_intrinsic(bld->gallivm->builder, intrinsic,
+                                bld->vec_type, args, 3);
+   }
+
+   return lp_build_add(bld, lp_build_mul(bld, a, b), c);
+}
+
+
 /**
  * Small vector x scale multiplication optimization.
  */
@@ -1512,6 +1601,16 @@ lp_build_abs(struct lp_build_context *bld,
          return lp_build_intrinsic_unary(builder, "llvm.x86.ssse3.pabs.d.128", vec_type, a);
       }
    }
+   else if (type.width*type.length == 256 && util_cpu_caps.has_avx2) {
+      switch(type.width) {
+      case 8:
+         return lp_build_intrinsic_unary(builder, "llvm.x86.avx2.pabs.b", vec_type, a);
+      case 16:
+         return lp_build_intrinsic_unary(builder, "llvm.x86.avx2.pabs.w", vec_type, a);
+      case 32:
+         return lp_build_intrinsic_unary(builder, "llvm.x86.avx2.pabs.d", vec_type, a);
+      }
+   }
    else if (type.width*type.length == 256 && util_cpu_caps.has_ssse3 &&
             (gallivm_debug & GALLIVM_DEBUG_PERF) &&
             (type.width == 8 || type.width == 16 || type.width == 32)) {
@@ -460,7 +460,9 @@ lp_build_const_string(struct gallivm_state *gallivm,
  * Build a callable function pointer.
  *
  * We use function pointer constants instead of LLVMAddGlobalMapping()
- * to work around a bug in LLVM 2.6, and for efficiency/simplicity.
+ * to work around a bug in LLVM 2.6, and for efficiency/simplicity, except
+ * in modules whose code goes to the on-disk cache, see
+ * gallivm_declare_function().
  */
 LLVMValueRef
 lp_build_const_func_pointer(struct gallivm_state *gallivm,
@@ -471,10 +473,29 @@ lp_build_const_func_pointer(struct gallivm_state *gallivm,
                             const char *name)
 {
    LLVMTypeRef function_type;
-   LLVMValueRef function;
 
    function_type = LLVMFunctionType(ret_type, arg_types, num_args, 0);
 
+   return lp_build_const_func_pointer_from_type(gallivm, ptr,
+                                                function_type, name);
+}
+
+
+/**
+ * Same as lp_build_const_func_pointer(), for an existing function type.
+ */
+LLVMValueRef
+lp_build_const_func_pointer_from_type(struct gallivm_state *gallivm,
+                                      const void *ptr,
+                                      LLVMTypeRef function_type,
+                                      const char *name)
+{
+   LLVMValueRef function;
+
+   function = gallivm_declare_function(gallivm, ptr, function_type, name);
+   if (function)
+      return function;
+
    function = lp_build_const_int_pointer(gallivm, ptr);
 
    function = LLVMBuildBitCast(gallivm->builder, function,
@@ -553,13 +553,9 @@ lp_build_fetch_rgba_aos(struct gallivm_state *gallivm,
                                           Elements(arg_types), 0);
 
          /* make const pointer for the C fetch_rgba_8unorm function */
-         function = lp_build_const_int_pointer(gallivm,
-            func_to_pointer((func_pointer) format_desc->fetch_rgba_8unorm));
-
-         /* cast the callee pointer to the function's type */
-         function = LLVMBuildBitCast(builder, function,
-                                     LLVMPointerType(function_type, 0),
-                                     "cast callee");
+         function = lp_build_const_func_pointer_from_type(gallivm,
+            func_to_pointer((func_pointer) format_desc->fetch_rgba_8unorm),
+            function_type, format_desc->short_name);
       }
 
       tmp_ptr = lp_build_alloca(gallivm, i32t, "");
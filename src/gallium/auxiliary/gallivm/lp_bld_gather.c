@@ -27,12 +27,16 @@
 
 
 #include "util/u_debug.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_memory.h"
 #include "lp_bld_debug.h"
 #include "lp_bld_const.h"
 #include "lp_bld_format.h"
 #include "lp_bld_gather.h"
 #include "lp_bld_init.h"
 #include "lp_bld_intr.h"
+#include "lp_bld_pack.h"
+#include "lp_bld_type.h"
 
 
 /**
@@ -132,6 +136,60 @@ lp_build_gather_elem(struct gallivm_state *gallivm,
 }
 
 
+/**
+ * Gather 32bit elements with the AVX2 vpgatherdd instruction.
+ *
+ * The hw gather handles at most 8 elements, so longer vectors get split
+ * into 8-wide pieces which are gathered separately and concatenated again.
+ * Unlike the scalar path there are no alignment requirements at all.
+ */
+static LLVMValueRef
+lp_build_gather_avx2(struct gallivm_state *gallivm,
+                     unsigned length,
+                     LLVMValueRef base_ptr,
+                     LLVMValueRef offsets)
+{
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMTypeRef i8t = LLVMInt8TypeInContext(gallivm->context);
+   LLVMTypeRef i32t = LLVMInt32TypeInContext(gallivm->context);
+
+   if (length > 8) {
+      struct lp_type part_type = lp_type_int_vec(32, 32 * 8);
+      LLVMValueRef parts[LP_MAX_VECTOR_LENGTH / 8];
+      unsigned num_parts = length / 8;
+      unsigned i;
+
+      assert(length % 8 == 0);
+      assert(num_parts <= Elements(parts));
+
+      for (i = 0; i < num_parts; i++) {
+         LLVMValueRef part_offsets;
+         part_offsets = lp_build_extract_range(gallivm, offsets, i * 8, 8);
+         parts[i] = lp_build_gather_avx2(gallivm, 8, base_ptr, part_offsets);
+      }
+      return lp_build_concat(gallivm, parts, part_type, num_parts);
+   }
+   else {
+      LLVMTypeRef vec_type = LLVMVectorType(i32t, length);
+      const char *intrinsic = length == 8 ? "llvm.x86.avx2.gather.d.d.256" :
+                                            "llvm.x86.avx2.gather.d.d";
+      LLVMValueRef args[5];
+
+      assert(length == 4 || length == 8);
+
+      args[0] = LLVMGetUndef(vec_type);
+      args[1] = base_ptr;
+      args[2] = offsets;
+      /* all lanes enabled (only the sign bit of the mask matters) */
+      args[3] = LLVMConstAllOnes(vec_type);
+      /* offsets are in bytes */
+      args[4] = LLVMConstInt(i8t, 1, 0);
+
+      return lp_build_intrinsic(builder, intrinsic, vec_type, args, 5);
+   }
+}
+
+
 /**
  * Gather elements from scatter positions in memory into a single vector.
  * Use for fetching texels from a texture.
@@ -170,6 +228,14 @@ lp_build_gather(struct gallivm_state *gallivm,
       return lp_build_gather_elem(gallivm, length,
                                   src_width, dst_width, aligned,
                                   base_ptr, offsets, 0, vector_justify);
+   } else if (util_cpu_caps.has_avx2 &&
+              src_width == 32 && dst_width == 32 &&
+              length % 4 == 0 && (length <= 8 || length % 8 == 0)) {
+      /*
+       * Only do full 32bit elements, narrower fetches would need to
+       * read past the element (and potentially the end of the buffer).
+       */
+      return lp_build_gather_avx2(gallivm, length, base_ptr, offsets);
    } else {
       /* Vector */
 
@@ -28,10 +28,13 @@
 
 #include "pipe/p_config.h"
 #include "pipe/p_compiler.h"
+#include "util/u_atomic.h"
 #include "util/u_cpu_detect.h"
 #include "util/u_debug.h"
 #include "util/u_memory.h"
 #include "util/simple_list.h"
+#include "util/disk_cache.h"
+#include "util/mesa-sha1.h"
 #include "os/os_time.h"
 #include "lp_bld.h"
 #include "lp_bld_debug.h"
@@ -56,6 +59,20 @@
 void LLVMLinkInMCJIT();
 #endif
 
+/* The on-disk cache stores MCJIT objects, whose calls to C functions must
+ * be bound by name with global mappings, which MCJIT honors since LLVM 3.6
+ */
+#if defined(ENABLE_SHADER_CACHE) && USE_MCJIT && HAVE_LLVM >= 0x0306
+#  define USE_OBJECT_CACHE 1
+#else
+#  define USE_OBJECT_CACHE 0
+#endif
+
+#if USE_OBJECT_CACHE && defined(HAVE_DLOPEN)
+#include <dlfcn.h>
+#include <sys/stat.h>
+#endif
+
 #ifdef DEBUG
 unsigned gallivm_debug = 0;
 
@@ -80,6 +97,20 @@ static boolean gallivm_initialized = FALSE;
 
 unsigned lp_native_vector_width;
 
+boolean lp_fuse_mad;
+
+#if USE_OBJECT_CACHE
+static struct disk_cache *gallivm_cache = NULL;
+
+/** Size and modification time of the shared object gallivm is part of */
+static struct {
+   uint64_t size;
+   uint64_t mtime;
+} gallivm_build_id;
+#endif
+
+static struct gallivm_cache_stats gallivm_cache_stats;
+
 
 /*
  * Optimization values are:
@@ -170,6 +201,18 @@ gallivm_free_ir(struct gallivm_state *gallivm)
       LLVMDisposeModule(gallivm->module);
    }
 
+   if (gallivm->object_cache) {
+      lp_free_object_cache(gallivm->object_cache);
+   }
+
+   if (gallivm->cache_key) {
+      /* Never compiled, finalizing is the only way to free the context */
+      unsigned char unused[20];
+      _mesa_sha1_final(gallivm->cache_key, unused);
+   }
+
+   FREE(gallivm->mappings);
+
 #if !USE_MCJIT
    /* Don't free the TargetData, it's owned by the exec engine */
 #else
@@ -184,6 +227,10 @@ gallivm_free_ir(struct gallivm_state *gallivm)
    /* The LLVMContext should be owned by the parent of gallivm. */
 
    gallivm->engine = NULL;
+   gallivm->object_cache = NULL;
+   gallivm->cache_key = NULL;
+   gallivm->mappings = NULL;
+   gallivm->num_mappings = 0;
    gallivm->target = NULL;
    gallivm->module = NULL;
    gallivm->passmgr = NULL;
@@ -385,9 +432,13 @@ lp_build_init(void)
     *
     * See also:
     * - http://www.anandtech.com/show/4955/the-bulldozer-review-amd-fx8150-tested/2
+    *
+    * AVX2 (Haswell, Excavator and later) also brings 256-bit integer ops and
+    * hardware gathers, so 8-wide is a win there regardless of the vendor.
     */
-   if (util_cpu_caps.has_avx &&
-       util_cpu_caps.has_intel) {
+   if ((util_cpu_caps.has_avx &&
+        util_cpu_caps.has_intel) ||
+       util_cpu_caps.has_avx2) {
       lp_native_vector_width = 256;
    } else {
       /* Leave it at 128, even when no SIMD extensions are available.
@@ -399,6 +450,9 @@ lp_build_init(void)
    lp_native_vector_width = debug_get_num_option("LP_NATIVE_VECTOR_WIDTH",
                                                  lp_native_vector_width);
 
+   /* Fusing TGSI MADs changes results in the last bit, so it is opt-in. */
+   lp_fuse_mad = debug_get_bool_option("GALLIVM_FUSE_MAD", FALSE);
+
    if (lp_native_vector_width <= 128) {
       /* Hide AVX support, as often LLVM AVX intrinsics are only guarded by
        * "util_cpu_caps.has_avx" predicate, and lack the
@@ -409,6 +463,7 @@ lp_build_init(void)
        */
       util_cpu_caps.has_avx = 0;
       util_cpu_caps.has_avx2 = 0;
+      util_cpu_caps.has_fma = 0;
    }
 
 #ifdef PIPE_ARCH_PPC_64
@@ -433,6 +488,30 @@ lp_build_init(void)
    }
 #endif
 
+#if USE_OBJECT_CACHE
+   {
+      const char *cache_dir = debug_get_option("GALLIVM_CACHE_DIR", NULL);
+      if (cache_dir) {
+         /* in megabytes */
+         uint64_t cache_size = debug_get_num_option("GALLIVM_CACHE_SIZE", 256);
+#ifdef HAVE_DLOPEN
+         Dl_info info;
+         struct stat st;
+
+         /* Two builds with the same version can still generate different
+          * code for the same key.
+          */
+         if (dladdr((void *) lp_build_init, &info) && info.dli_fname &&
+             stat(info.dli_fname, &st) == 0) {
+            gallivm_build_id.size = st.st_size;
+            gallivm_build_id.mtime = st.st_mtime;
+         }
+#endif
+         gallivm_cache = disk_cache_create(cache_dir, cache_size << 20);
+      }
+   }
+#endif
+
    gallivm_initialized = TRUE;
 
 #if 0
@@ -441,7 +520,9 @@ lp_build_init(void)
    util_cpu_caps.has_ssse3 = 0;
    util_cpu_caps.has_sse4_1 = 0;
    util_cpu_caps.has_avx = 0;
+   util_cpu_caps.has_avx2 = 0;
    util_cpu_caps.has_f16c = 0;
+   util_cpu_caps.has_fma = 0;
 #endif
 
    return TRUE;
@@ -506,6 +587,190 @@ gallivm_verify_function(struct gallivm_state *gallivm,
 }
 
 
+/**
+ * A C function the module calls through a named declaration, so that the
+ * machine code doesn't embed its address.
+ */
+struct gallivm_function_mapping
+{
+   LLVMValueRef function;
+   const void *ptr;
+};
+
+
+/**
+ * Add data identifying the module to its key in the on-disk cache, which
+ * is only used for modules this is called for.  The data must determine the
+ * IR built afterwards, like the shader tokens and the variant key, and must
+ * not contain pointers, which differ between processes.
+ */
+void
+gallivm_add_cache_key(struct gallivm_state *gallivm,
+                      const void *data, size_t size)
+{
+#if USE_OBJECT_CACHE
+   assert(!gallivm->compiled);
+
+   if (!gallivm_cache)
+      return;
+
+   if (!gallivm->cache_key) {
+      gallivm->cache_key = _mesa_sha1_init();
+      if (!gallivm->cache_key)
+         return;
+   }
+
+   _mesa_sha1_update(gallivm->cache_key, data, size);
+#endif
+}
+
+
+/**
+ * Declare an external C function for modules with a cache key.
+ *
+ * The declaration is bound to the function when the module is compiled,
+ * so cached machine code refers to it by name, and can be loaded by
+ * processes where it lives at another address.  Returns NULL for other
+ * modules, which call the address directly.
+ */
+LLVMValueRef
+gallivm_declare_function(struct gallivm_state *gallivm,
+                         const void *ptr,
+                         LLVMTypeRef function_type,
+                         const char *name)
+{
+#if USE_OBJECT_CACHE
+   struct gallivm_function_mapping *mappings;
+   LLVMValueRef function;
+   unsigned i;
+
+   if (!gallivm->cache_key)
+      return NULL;
+
+   for (i = 0; i < gallivm->num_mappings; i++) {
+      if (gallivm->mappings[i].ptr == ptr) {
+         return LLVMBuildBitCast(gallivm->builder,
+                                 gallivm->mappings[i].function,
+                                 LLVMPointerType(function_type, 0), "");
+      }
+   }
+
+   mappings = REALLOC(gallivm->mappings,
+                      gallivm->num_mappings * sizeof *mappings,
+                      (gallivm->num_mappings + 1) * sizeof *mappings);
+   if (!mappings)
+      return NULL;
+   gallivm->mappings = mappings;
+
+   /* LLVM makes the name unique within the module, in a repeatable way */
+   function = LLVMAddFunction(gallivm->module, name, function_type);
+   mappings[gallivm->num_mappings].function = function;
+   mappings[gallivm->num_mappings].ptr = ptr;
+   gallivm->num_mappings++;
+
+   return function;
+#else
+   return NULL;
+#endif
+}
+
+
+#if USE_OBJECT_CACHE
+
+/**
+ * Compute the key of the module's machine code in the on-disk cache.
+ *
+ * The data callers added with gallivm_add_cache_key() identifies the IR,
+ * and the rest is what turns it into code: the build of gallivm and LLVM,
+ * the options and the CPU code is generated for.
+ */
+static boolean
+compute_cache_key(struct gallivm_state *gallivm, cache_key key)
+{
+   struct {
+      uint64_t build_size;
+      uint64_t build_mtime;
+      unsigned llvm_version;
+      unsigned llvm_version_patch;
+      unsigned pointer_size;
+      unsigned native_vector_width;
+      unsigned debug_flags;
+      unsigned fuse_mad;
+      unsigned debug_build;
+      struct util_cpu_caps cpu_caps;
+      char mesa_version[32];
+      char cpu_name[64];
+   } target;
+   boolean ret;
+
+   if (!gallivm->cache_key)
+      return FALSE;
+
+   memset(&target, 0, sizeof target);
+   target.build_size = gallivm_build_id.size;
+   target.build_mtime = gallivm_build_id.mtime;
+   target.llvm_version = HAVE_LLVM;
+#ifdef MESA_LLVM_VERSION_PATCH
+   target.llvm_version_patch = MESA_LLVM_VERSION_PATCH;
+#endif
+   target.pointer_size = sizeof(void *);
+   target.native_vector_width = lp_native_vector_width;
+   /* These select different code paths, not only debug output */
+   target.debug_flags = gallivm_debug;
+   target.fuse_mad = lp_fuse_mad;
+#ifdef DEBUG
+   target.debug_build = 1;
+#endif
+   memcpy(&target.cpu_caps, &util_cpu_caps, sizeof target.cpu_caps);
+   target.cpu_caps.nr_cpus = 0; /* doesn't affect the code */
+   strncpy(target.mesa_version, PACKAGE_VERSION,
+           sizeof target.mesa_version - 1);
+   lp_get_host_cpu_name(target.cpu_name, sizeof target.cpu_name);
+
+   _mesa_sha1_update(gallivm->cache_key, &target, sizeof target);
+   ret = _mesa_sha1_final(gallivm->cache_key, key);
+   gallivm->cache_key = NULL;
+
+   return ret;
+}
+
+
+/**
+ * Give the functions the module defines names that only depend on their
+ * order, which is the same wherever the module is built from the same key,
+ * while the names callers choose often count variants.  The code loaded
+ * from the cache is looked up by these names.
+ */
+static void
+name_functions_for_cache(struct gallivm_state *gallivm)
+{
+   LLVMValueRef func = LLVMGetFirstFunction(gallivm->module);
+   unsigned i = 0;
+
+   while (func) {
+      if (!LLVMIsDeclaration(func)) {
+         char name[32];
+         util_snprintf(name, sizeof name, "gallivm_cached_func%u", i++);
+         LLVMSetValueName(func, name);
+      }
+      func = LLVMGetNextFunction(func);
+   }
+}
+
+#endif /* USE_OBJECT_CACHE */
+
+
+/**
+ * Get the on-disk cache statistics of all gallivm_states so far.
+ */
+void
+gallivm_get_cache_stats(struct gallivm_cache_stats *stats)
+{
+   stats->hits = p_atomic_read(&gallivm_cache_stats.hits);
+   stats->misses = p_atomic_read(&gallivm_cache_stats.misses);
+}
+
+
 /**
  * Compile a module.
  * This does IR optimization on all functions in the module.
@@ -515,6 +780,13 @@ gallivm_compile_module(struct gallivm_state *gallivm)
 {
    LLVMValueRef func;
    int64_t time_begin = 0;
+   void *cached_code = NULL;
+#if USE_OBJECT_CACHE
+   size_t cached_size = 0;
+   cache_key key;
+   boolean have_key = FALSE;
+   unsigned i;
+#endif
 
    assert(!gallivm->compiled);
 
@@ -526,33 +798,47 @@ gallivm_compile_module(struct gallivm_state *gallivm)
    if (gallivm_debug & GALLIVM_DEBUG_PERF)
       time_begin = os_time_get();
 
-   /* Run optimization passes */
-   LLVMInitializeFunctionPassManager(gallivm->passmgr);
-   func = LLVMGetFirstFunction(gallivm->module);
-   while (func) {
-      if (0) {
-         debug_printf("optimizing func %s...\n", LLVMGetValueName(func));
-      }
+#if USE_OBJECT_CACHE
+   if (gallivm_cache && compute_cache_key(gallivm, key)) {
+      have_key = TRUE;
+      name_functions_for_cache(gallivm);
+      cached_code = disk_cache_get(gallivm_cache, key, &cached_size);
+      if (cached_code)
+         p_atomic_inc(&gallivm_cache_stats.hits);
+      else
+         p_atomic_inc(&gallivm_cache_stats.misses);
+   }
+#endif
 
-   /* Disable frame pointer omission on debug/profile builds */
-   /* XXX: And workaround http://llvm.org/PR21435 */
+   /* Run optimization passes, unless we already have the code */
+   if (!cached_code) {
+      LLVMInitializeFunctionPassManager(gallivm->passmgr);
+      func = LLVMGetFirstFunction(gallivm->module);
+      while (func) {
+         if (0) {
+            debug_printf("optimizing func %s...\n", LLVMGetValueName(func));
+         }
+
+      /* Disable frame pointer omission on debug/profile builds */
+      /* XXX: And workaround http://llvm.org/PR21435 */
 #if HAVE_LLVM >= 0x0307 && \
     (defined(DEBUG) || defined(PROFILE) || \
      defined(PIPE_ARCH_X86) || defined(PIPE_ARCH_X86_64))
-      LLVMAddTargetDependentFunctionAttr(func, "no-frame-pointer-elim", "true");
-      LLVMAddTargetDependentFunctionAttr(func, "no-frame-pointer-elim-non-leaf", "true");
+         LLVMAddTargetDependentFunctionAttr(func, "no-frame-pointer-elim", "true");
+         LLVMAddTargetDependentFunctionAttr(func, "no-frame-pointer-elim-non-leaf", "true");
 #endif
 
-      LLVMRunFunctionPassManager(gallivm->passmgr, func);
-      func = LLVMGetNextFunction(func);
-   }
-   LLVMFinalizeFunctionPassManager(gallivm->passmgr);
+         LLVMRunFunctionPassManager(gallivm->passmgr, func);
+         func = LLVMGetNextFunction(func);
+      }
+      LLVMFinalizeFunctionPassManager(gallivm->passmgr);
 
-   if (gallivm_debug & GALLIVM_DEBUG_PERF) {
-      int64_t time_end = os_time_get();
-      int time_msec = (int)(time_end - time_begin) / 1000;
-      debug_printf("optimizing module %s took %d msec\n",
-                   lp_get_module_id(gallivm->module), time_msec);
+      if (gallivm_debug & GALLIVM_DEBUG_PERF) {
+         int64_t time_end = os_time_get();
+         int time_msec = (int)(time_end - time_begin) / 1000;
+         debug_printf("optimizing module %s took %d msec\n",
+                      lp_get_module_id(gallivm->module), time_msec);
+      }
    }
 
    /* Dump byte code to a file */
@@ -570,6 +856,21 @@ gallivm_compile_module(struct gallivm_state *gallivm)
 #endif
    assert(gallivm->engine);
 
+#if USE_OBJECT_CACHE
+   for (i = 0; i < gallivm->num_mappings; i++) {
+      LLVMAddGlobalMapping(gallivm->engine, gallivm->mappings[i].function,
+                           (void *) gallivm->mappings[i].ptr);
+   }
+
+   /* Code is only generated by the first gallivm_jit_function() call. */
+   if (have_key) {
+      gallivm->object_cache = lp_build_set_object_cache(gallivm->engine,
+                                                        gallivm_cache, key,
+                                                        cached_code,
+                                                        cached_size);
+   }
+#endif
+
    ++gallivm->compiled;
 
    if (gallivm_debug & GALLIVM_DEBUG_ASM) {
@@ -36,6 +36,10 @@
 #include <llvm-c/ExecutionEngine.h>
 
 
+struct mesa_sha1;
+struct gallivm_function_mapping;
+
+
 struct gallivm_state
 {
    LLVMModuleRef module;
@@ -46,10 +50,25 @@ struct gallivm_state
    LLVMBuilderRef builder;
    LLVMMCJITMemoryManagerRef memorymgr;
    struct lp_generated_code *code;
+   struct lp_object_cache *object_cache;
+   struct mesa_sha1 *cache_key;         /**< see gallivm_add_cache_key() */
+   struct gallivm_function_mapping *mappings;
+   unsigned num_mappings;
    unsigned compiled;
 };
 
 
+/**
+ * Number of modules whose machine code was found in, or had to be added
+ * to, the on-disk cache enabled with GALLIVM_CACHE_DIR.
+ */
+struct gallivm_cache_stats
+{
+   unsigned hits;
+   unsigned misses;
+};
+
+
 boolean
 lp_build_init(void);
 
@@ -67,6 +86,16 @@ void
 gallivm_verify_function(struct gallivm_state *gallivm,
                         LLVMValueRef func);
 
+void
+gallivm_add_cache_key(struct gallivm_state *gallivm,
+                      const void *data, size_t size);
+
+LLVMValueRef
+gallivm_declare_function(struct gallivm_state *gallivm,
+                         const void *ptr,
+                         LLVMTypeRef function_type,
+                         const char *name);
+
 void
 gallivm_compile_module(struct gallivm_state *gallivm);
 
@@ -74,6 +103,9 @@ func_pointer
 gallivm_jit_function(struct gallivm_state *gallivm,
                      LLVMValueRef func);
 
+void
+gallivm_get_cache_stats(struct gallivm_cache_stats *stats);
+
 void
 lp_set_load_alignment(LLVMValueRef Inst,
                        unsigned Align);
@@ -60,6 +60,10 @@
 #include <llvm-c/ExecutionEngine.h>
 #include <llvm/Target/TargetOptions.h>
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
+#if HAVE_LLVM >= 0x0303
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/Support/MemoryBuffer.h>
+#endif
 #include <llvm/ADT/Triple.h>
 #if HAVE_LLVM < 0x0306
 #include <llvm/ExecutionEngine/JITMemoryManager.h>
@@ -84,6 +88,7 @@
 #include "pipe/p_config.h"
 #include "util/u_debug.h"
 #include "util/u_cpu_detect.h"
+#include "util/disk_cache.h"
 
 #include "lp_bld_misc.h"
 
@@ -474,7 +479,7 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
 #endif
    }
 
-   llvm::SmallVector<std::string, 1> MAttrs;
+   llvm::SmallVector<std::string, 4> MAttrs;
    if (util_cpu_caps.has_avx) {
       /*
        * AVX feature is not automatically detected from CPUID by the X86 target
@@ -486,6 +491,12 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
       if (util_cpu_caps.has_f16c) {
          MAttrs.push_back("+f16c");
       }
+      if (util_cpu_caps.has_fma) {
+         MAttrs.push_back("+fma");
+      }
+      if (util_cpu_caps.has_avx2) {
+         MAttrs.push_back("+avx2");
+      }
       builder.setMAttrs(MAttrs);
    }
 
@@ -573,3 +584,110 @@ lp_free_memory_manager(LLVMMCJITMemoryManagerRef memorymgr)
 {
    delete reinterpret_cast<BaseMemoryManager*>(memorymgr);
 }
+
+
+#if HAVE_LLVM >= 0x0303
+
+/*
+ * Object cache for a single module: hands MCJIT the object code that was
+ * found in the on-disk cache, or stores the code MCJIT generates there.
+ */
+class ShaderObjectCache : public llvm::ObjectCache {
+
+   struct disk_cache *cache;
+   cache_key key;
+   void *data;
+   size_t size;
+
+   public:
+
+      ShaderObjectCache(struct disk_cache *Cache, const uint8_t *Key,
+                        void *Data, size_t Size) :
+         cache(Cache), data(Data), size(Size) {
+         memcpy(key, Key, sizeof key);
+      }
+
+      virtual ~ShaderObjectCache() {
+         free(data);
+      }
+
+#if HAVE_LLVM >= 0x0306
+      virtual void notifyObjectCompiled(const llvm::Module *M,
+                                        llvm::MemoryBufferRef Obj) {
+         disk_cache_put(cache, key, Obj.getBufferStart(), Obj.getBufferSize());
+      }
+
+      virtual std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *M) {
+         if (!data)
+            return NULL;
+         return llvm::MemoryBuffer::getMemBufferCopy(
+                   llvm::StringRef((const char *)data, size));
+      }
+#else
+      virtual void notifyObjectCompiled(const llvm::Module *M,
+                                        const llvm::MemoryBuffer *Obj) {
+         disk_cache_put(cache, key, Obj->getBufferStart(), Obj->getBufferSize());
+      }
+
+      virtual llvm::MemoryBuffer *getObject(const llvm::Module *M) {
+         if (!data)
+            return NULL;
+         return llvm::MemoryBuffer::getMemBufferCopy(
+                   llvm::StringRef((const char *)data, size));
+      }
+#endif
+};
+
+#endif /* HAVE_LLVM >= 0x0303 */
+
+
+/**
+ * Make the engine load its code from the on-disk cache, if data is not
+ * NULL, or store the code it generates there under key otherwise.
+ * Takes ownership of data.
+ */
+extern "C"
+struct lp_object_cache *
+lp_build_set_object_cache(LLVMExecutionEngineRef JIT,
+                          struct disk_cache *cache,
+                          const uint8_t *key,
+                          void *data,
+                          size_t size)
+{
+#if HAVE_LLVM >= 0x0303
+   ShaderObjectCache *objcache =
+      new ShaderObjectCache(cache, key, data, size);
+   llvm::unwrap(JIT)->setObjectCache(objcache);
+   return (struct lp_object_cache *) objcache;
+#else
+   free(data);
+   return NULL;
+#endif
+}
+
+
+/**
+ * Free the object cache, once the engine using it is destroyed.
+ */
+extern "C"
+void
+lp_free_object_cache(struct lp_object_cache *objcache)
+{
+#if HAVE_LLVM >= 0x0303
+   delete (ShaderObjectCache *) objcache;
+#endif
+}
+
+
+/**
+ * Get the name of the CPU code is generated for, as picked by LLVM.
+ */
+extern "C"
+void
+lp_get_host_cpu_name(char *name, size_t size)
+{
+   std::string cpu = llvm::sys::getHostCPUName().str();
+
+   strncpy(name, cpu.c_str(), size);
+   name[size - 1] = '\0';
+}
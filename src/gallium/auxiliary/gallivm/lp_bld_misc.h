@@ -40,6 +40,8 @@ extern "C" {
 
 
 struct lp_generated_code;
+struct lp_object_cache;
+struct disk_cache;
 
 
 extern void
@@ -68,6 +70,19 @@ lp_get_default_memory_manager();
 extern void
 lp_free_memory_manager(LLVMMCJITMemoryManagerRef memorymgr);
 
+extern struct lp_object_cache *
+lp_build_set_object_cache(LLVMExecutionEngineRef JIT,
+                          struct disk_cache *cache,
+                          const uint8_t *key,
+                          void *data,
+                          size_t size);
+
+extern void
+lp_free_object_cache(struct lp_object_cache *objcache);
+
+extern void
+lp_get_host_cpu_name(char *name, size_t size);
+
 #ifdef __cplusplus
 }
 #endif
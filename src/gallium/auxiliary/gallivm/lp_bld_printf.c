@@ -65,8 +65,9 @@ lp_build_print_args(struct gallivm_state* gallivm,
    }
 
    printf_type = LLVMFunctionType(LLVMInt32TypeInContext(context), NULL, 0, 1);
-   func_printf = lp_build_const_int_pointer(gallivm, func_to_pointer((func_pointer)debug_printf));
-   func_printf = LLVMBuildBitCast(builder, func_printf, LLVMPointerType(printf_type, 0), "debug_printf");
+   func_printf = lp_build_const_func_pointer_from_type(gallivm,
+                    func_to_pointer((func_pointer)debug_printf),
+                    printf_type, "debug_printf");
 
    return LLVMBuildCall(builder, func_printf, args, argcount, "");
 }
@@ -118,6 +118,9 @@ lp_sampler_static_texture_state(struct lp_static_texture_state *state,
    state->pot_height        = util_is_power_of_two(texture->height0);
    state->pot_depth         = util_is_power_of_two(texture->depth0);
    state->level_zero_only   = !view->u.tex.last_level;
+   state->tiled             = (texture->flags & LP_RESOURCE_FLAG_TILED) &&
+                              util_format_get_blockwidth(view->format) == 1 &&
+                              util_format_get_blockheight(view->format) == 1;
 
    /*
     * the layer / element / level parameters are all either dynamic
@@ -2019,16 +2022,64 @@ lp_build_sample_partial_offset(struct lp_build_context *bld,
 }
 
 
+/**
+ * Compute the offset of a texel in a texture stored in tiles.
+ *
+ * The x and y parts are still independent of each other, see
+ * LP_RESOURCE_FLAG_TILED for the layout.
+ */
+static void
+lp_build_sample_tiled_offset(struct lp_build_context *bld,
+                             LLVMValueRef x,
+                             LLVMValueRef y,
+                             LLVMValueRef x_stride,
+                             LLVMValueRef y_stride,
+                             LLVMValueRef *out_offset)
+{
+   LLVMBuilderRef builder = bld->gallivm->builder;
+   LLVMValueRef tile_mask;
+   LLVMValueRef sub, tile;
+   LLVMValueRef offset;
+
+   tile_mask = lp_build_const_int_vec(bld->gallivm, bld->type,
+                                      LP_TEX_TILE_SIZE - 1);
+
+   /* (x & ~3) * 4 * bpp + (x & 3) * bpp */
+   sub = LLVMBuildAnd(builder, x, tile_mask, "");
+   tile = LLVMBuildXor(builder, x, sub, "");
+   offset = lp_build_mul_imm(bld, tile, LP_TEX_TILE_SIZE);
+   offset = lp_build_add(bld, offset, sub);
+   offset = lp_build_mul(bld, offset, x_stride);
+
+   if (y && y_stride) {
+      /* (y & ~3) * row_stride + (y & 3) * 4 * bpp */
+      LLVMValueRef y_offset;
+      sub = LLVMBuildAnd(builder, y, tile_mask, "");
+      tile = LLVMBuildXor(builder, y, sub, "");
+      sub = lp_build_mul(bld, sub, x_stride);
+      sub = lp_build_mul_imm(bld, sub, LP_TEX_TILE_SIZE);
+      y_offset = lp_build_mul(bld, tile, y_stride);
+      y_offset = lp_build_add(bld, y_offset, sub);
+      offset = lp_build_add(bld, offset, y_offset);
+   }
+
+   *out_offset = offset;
+}
+
+
 /**
  * Compute the offset of a pixel block.
  *
  * x, y, z, y_stride, z_stride are vectors, and they refer to pixels.
  *
  * Returns the relative offset and i,j sub-block coordinates
+ *
+ * @param tiled  whether the texture uses the LP_RESOURCE_FLAG_TILED layout
  */
 void
 lp_build_sample_offset(struct lp_build_context *bld,
                        const struct util_format_description *format_desc,
+                       boolean tiled,
                        LLVMValueRef x,
                        LLVMValueRef y,
                        LLVMValueRef z,
@@ -2044,21 +2095,31 @@ lp_build_sample_offset(struct lp_build_context *bld,
    x_stride = lp_build_const_vec(bld->gallivm, bld->type,
                                  format_desc->block.bits/8);
 
-   lp_build_sample_partial_offset(bld,
-                                  format_desc->block.width,
-                                  x, x_stride,
-                                  &offset, out_i);
+   if (tiled) {
+      assert(format_desc->block.width == 1);
+      assert(format_desc->block.height == 1);
 
-   if (y && y_stride) {
-      LLVMValueRef y_offset;
-      lp_build_sample_partial_offset(bld,
-                                     format_desc->block.height,
-                                     y, y_stride,
-                                     &y_offset, out_j);
-      offset = lp_build_add(bld, offset, y_offset);
+      lp_build_sample_tiled_offset(bld, x, y, x_stride, y_stride, &offset);
+      *out_i = bld->zero;
+      *out_j = bld->zero;
    }
    else {
-      *out_j = bld->zero;
+      lp_build_sample_partial_offset(bld,
+                                     format_desc->block.width,
+                                     x, x_stride,
+                                     &offset, out_i);
+
+      if (y && y_stride) {
+         LLVMValueRef y_offset;
+         lp_build_sample_partial_offset(bld,
+                                        format_desc->block.height,
+                                        y, y_stride,
+                                        &y_offset, out_j);
+         offset = lp_build_add(bld, offset, y_offset);
+      }
+      else {
+         *out_j = bld->zero;
+      }
    }
 
    if (z && z_stride) {
@@ -37,6 +37,7 @@
 
 
 #include "pipe/p_format.h"
+#include "pipe/p_defines.h"
 #include "util/u_debug.h"
 #include "gallivm/lp_bld.h"
 #include "gallivm/lp_bld_type.h"
@@ -92,6 +93,22 @@ enum lp_sampler_op_type {
 #define LP_SAMPLER_LOD_PROPERTY_SHIFT       6
 #define LP_SAMPLER_LOD_PROPERTY_MASK  (3 << 6)
 
+
+/**
+ * Resource flag for textures which the driver stores in tiles of
+ * LP_TEX_TILE_SIZE x LP_TEX_TILE_SIZE texels instead of linearly.
+ *
+ * The texels of a tile are consecutive in memory, and a row of tiles takes
+ * up the same space as LP_TEX_TILE_SIZE linear rows, so row_stride and
+ * img_stride keep their usual meaning. Texel (x, y) of an image lives at
+ *
+ *   (y & ~3) * row_stride + (y & 3) * 4 * bpp + (x & ~3) * 4 * bpp + (x & 3) * bpp
+ *
+ * Only used for formats with 1x1 pixel blocks.
+ */
+#define LP_RESOURCE_FLAG_TILED  (PIPE_RESOURCE_FLAG_DRV_PRIV << 0)
+#define LP_TEX_TILE_SIZE        4
+
 struct lp_sampler_params
 {
    struct lp_type type;
@@ -128,6 +145,7 @@ struct lp_static_texture_state
    unsigned pot_height:1;
    unsigned pot_depth:1;
    unsigned level_zero_only:1;
+   unsigned tiled:1;         /**< see LP_RESOURCE_FLAG_TILED */
 };
 
 
@@ -559,6 +577,7 @@ lp_build_sample_partial_offset(struct lp_build_context *bld,
 void
 lp_build_sample_offset(struct lp_build_context *bld,
                        const struct util_format_description *format_desc,
+                       boolean tiled,
                        LLVMValueRef x,
                        LLVMValueRef y,
                        LLVMValueRef z,
@@ -797,6 +797,7 @@ lp_build_sample_image_nearest_afloat(struct lp_build_sample_context *bld,
     */
    lp_build_sample_offset(&bld->int_coord_bld,
                           bld->format_desc,
+                          FALSE,
                           x_icoord, y_icoord,
                           z_icoord,
                           row_stride_vec, img_stride_vec,
@@ -138,6 +138,7 @@ lp_build_sample_texel_soa(struct lp_build_sample_context *bld,
    /* convert x,y,z coords to linear offset from start of texture, in bytes */
    lp_build_sample_offset(&bld->int_coord_bld,
                           bld->format_desc,
+                          bld->static_texture_state->tiled,
                           x, y, z, y_stride, z_stride,
                           &offset, &i, &j);
    if (mipoffsets) {
@@ -2372,6 +2373,7 @@ lp_build_fetch_texel(struct lp_build_sample_context *bld,
 
    lp_build_sample_offset(int_coord_bld,
                           bld->format_desc,
+                          bld->static_texture_state->tiled,
                           x, y, z, row_stride_vec, img_stride_vec,
                           &offset, &i, &j);
 
@@ -2780,6 +2782,8 @@ lp_build_sample_soa_code(struct gallivm_state *gallivm,
                 derived_sampler_state.compare_mode == PIPE_TEX_COMPARE_NONE &&
                 lp_is_simple_wrap_mode(derived_sampler_state.wrap_s);
 
+      /* the AoS path only knows about the linear layout */
+      use_aos &= !static_texture_state->tiled;
       use_aos &= bld.num_lods <= num_quads ||
                  derived_sampler_state.min_img_filter ==
                     derived_sampler_state.mag_img_filter;
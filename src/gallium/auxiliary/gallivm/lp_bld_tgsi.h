@@ -63,6 +63,7 @@ struct lp_build_mask_context;
 struct gallivm_state;
 struct lp_derivatives;
 struct lp_build_tgsi_gs_iface;
+struct lp_build_tgsi_cs_iface;
 
 
 enum lp_build_tex_modifier {
@@ -166,6 +167,11 @@ struct lp_bld_tgsi_system_values {
    LLVMValueRef prim_id;
    LLVMValueRef basevertex;
    LLVMValueRef invocation_id;
+   /* compute shaders: thread_id is a vector, the others are scalars */
+   LLVMValueRef thread_id[3];
+   LLVMValueRef block_id[3];
+   LLVMValueRef block_size[3];
+   LLVMValueRef grid_size[3];
 };
 
 
@@ -232,7 +238,16 @@ lp_build_tgsi_soa(struct gallivm_state *gallivm,
                   LLVMValueRef context_ptr,
                   struct lp_build_sampler_soa *sampler,
                   const struct tgsi_shader_info *info,
-                  const struct lp_build_tgsi_gs_iface *gs_iface);
+                  const struct lp_build_tgsi_gs_iface *gs_iface,
+                  const struct lp_build_tgsi_cs_iface *cs_iface);
+
+
+unsigned
+lp_build_tgsi_cs_state_length(const struct tgsi_shader_info *info);
+
+
+boolean
+lp_build_tgsi_has_divergent_barrier(const struct tgsi_token *tokens);
 
 
 void
@@ -383,6 +398,9 @@ struct lp_build_tgsi_context
 
    boolean soa;
 
+   /** Whether TGSI MAD may use a fused multiply-add. */
+   boolean fuse_mad;
+
    int pc;
 
    struct tgsi_full_instruction *instructions;
@@ -395,6 +413,12 @@ struct lp_build_tgsi_context
      */
    void (*emit_prologue)(struct lp_build_tgsi_context*);
 
+   /** This function allows the user to insert some instructions after the
+     * declarations and immediates have been processed, right before the
+     * first instruction of the program.  It is optional.
+     */
+   void (*emit_prologue_post_decl)(struct lp_build_tgsi_context*);
+
    /** This function allows the user to insert some instructions at the end of
      * the program.  This callback is intended to be used for emitting
      * instructions to handle the export for the output registers, but it can
@@ -427,6 +451,46 @@ struct lp_build_tgsi_gs_iface
                        LLVMValueRef emitted_prims_vec);
 };
 
+/**
+ * Compute shader code generation interface.
+ *
+ * The memory resources (RES[n], RLOCAL, RINPUT, ...) live in the driver's
+ * own structures, so LOAD/STORE are emitted through these callbacks.
+ * Offsets are per-lane byte offsets, values are in the float vector type.
+ */
+struct lp_build_tgsi_cs_iface
+{
+   void (*emit_load)(const struct lp_build_tgsi_cs_iface *cs_iface,
+                     struct lp_build_tgsi_context * bld_base,
+                     unsigned resource,
+                     LLVMValueRef offset,
+                     LLVMValueRef exec_mask,
+                     unsigned writemask,
+                     LLVMValueRef result[4]);
+   void (*emit_store)(const struct lp_build_tgsi_cs_iface *cs_iface,
+                      struct lp_build_tgsi_context * bld_base,
+                      unsigned resource,
+                      LLVMValueRef offset,
+                      LLVMValueRef exec_mask,
+                      unsigned writemask,
+                      LLVMValueRef values[4]);
+
+   /*
+    * BARRIER support.  The function being built must return an i32: each
+    * barrier returns its (non-zero) index, and calling the function again
+    * with that value in 'phase' resumes execution right after the barrier.
+    * Registers live across barriers are kept in the memory pointed to by
+    * 'state_ptr', which must hold lp_build_tgsi_cs_state_length() vectors.
+    * Barriers are only supported outside of flow control, see
+    * lp_build_tgsi_has_divergent_barrier().
+    */
+   LLVMValueRef phase;
+   LLVMValueRef state_ptr;
+
+   /** Index of the instruction to start execution at */
+   unsigned entry_pc;
+};
+
 struct lp_build_tgsi_soa_context
 {
    struct lp_build_tgsi_context bld_base;
@@ -440,6 +504,11 @@ struct lp_build_tgsi_soa_context
    LLVMValueRef emitted_vertices_vec_ptr;
    LLVMValueRef max_output_vertices_vec;
 
+   const struct lp_build_tgsi_cs_iface *cs_iface;
+   boolean use_phase_state;
+   LLVMValueRef phase_switch;
+   unsigned num_phases;
+
    LLVMValueRef consts_ptr;
    LLVMValueRef const_sizes_ptr;
    LLVMValueRef consts[LP_MAX_TGSI_CONST_BUFFERS];
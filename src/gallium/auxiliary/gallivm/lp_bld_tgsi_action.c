@@ -1495,6 +1495,29 @@ log_emit_cpu(
 
 }
 
+/* TGSI_OPCODE_MAD (CPU Only) */
+
+static void
+mad_emit_cpu(
+   const struct lp_build_tgsi_action * action,
+   struct lp_build_tgsi_context * bld_base,
+   struct lp_build_emit_data * emit_data)
+{
+   struct lp_build_context *bld = &bld_base->base;
+   LLVMValueRef res;
+
+   if (bld_base->fuse_mad) {
+      res = lp_build_mad(bld, emit_data->args[0], emit_data->args[1],
+                         emit_data->args[2]);
+   }
+   else {
+      res = lp_build_add(bld, lp_build_mul(bld, emit_data->args[0],
+                                           emit_data->args[1]),
+                         emit_data->args[2]);
+   }
+   emit_data->output[emit_data->chan] = res;
+}
+
 /* TGSI_OPCODE_MAX (CPU Only) */
 
 static void
@@ -2063,6 +2086,7 @@ lp_set_default_actions_cpu(
 
    bld_base->op_actions[TGSI_OPCODE_LG2].emit = lg2_emit_cpu;
    bld_base->op_actions[TGSI_OPCODE_LOG].emit = log_emit_cpu;
+   bld_base->op_actions[TGSI_OPCODE_MAD].emit = mad_emit_cpu;
    bld_base->op_actions[TGSI_OPCODE_MAX].emit = max_emit_cpu;
    bld_base->op_actions[TGSI_OPCODE_MIN].emit = min_emit_cpu;
    bld_base->op_actions[TGSI_OPCODE_MOD].emit = mod_emit_cpu;
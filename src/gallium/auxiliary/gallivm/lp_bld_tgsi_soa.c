@@ -840,6 +840,12 @@ static void lp_exec_mask_endsub(struct lp_exec_mask *mask, int *pc)
 {
    struct function_ctx *ctx;
 
+   if (mask->function_stack_size == 1) {
+      /* end of the subroutine a compute kernel was entered at */
+      *pc = -1;
+      return;
+   }
+
    assert(mask->function_stack_size > 1);
    assert(mask->function_stack_size <= LP_MAX_NUM_FUNCS);
 
@@ -1670,6 +1676,41 @@ emit_fetch_system_value(
       atype = TGSI_TYPE_UNSIGNED;
       break;
 
+   case TGSI_SEMANTIC_THREAD_ID:
+      assert(swizzle < 4);
+      if (swizzle < 3)
+         res = bld->system_values.thread_id[swizzle];
+      else
+         res = bld_base->uint_bld.zero;
+      atype = TGSI_TYPE_UNSIGNED;
+      break;
+
+   case TGSI_SEMANTIC_BLOCK_ID:
+      assert(swizzle < 4);
+      if (swizzle < 3)
+         res = lp_build_broadcast_scalar(&bld_base->uint_bld,
+                                         bld->system_values.block_id[swizzle]);
+      else
+         res = bld_base->uint_bld.zero;
+      atype = TGSI_TYPE_UNSIGNED;
+      break;
+
+   case TGSI_SEMANTIC_BLOCK_SIZE:
+   case TGSI_SEMANTIC_GRID_SIZE:
+   {
+      const LLVMValueRef *size =
+         info->system_value_semantic_name[reg->Register.Index] ==
+            TGSI_SEMANTIC_BLOCK_SIZE ? bld->system_values.block_size :
+                                       bld->system_values.grid_size;
+      assert(swizzle < 4);
+      if (swizzle < 3)
+         res = lp_build_broadcast_scalar(&bld_base->uint_bld, size[swizzle]);
+      else
+         res = bld_base->uint_bld.one;
+      atype = TGSI_TYPE_UNSIGNED;
+      break;
+   }
+
    default:
       assert(!"unexpected semantic in emit_fetch_system_value");
       res = bld_base->base.zero;
@@ -2020,6 +2061,11 @@ emit_store(
    unsigned chan_index;
    struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
    enum tgsi_opcode_type dtype = tgsi_opcode_infer_dst_type(inst->Instruction.Opcode);
+
+   /* STORE/MFENCE name a memory resource, which is written by the opcode */
+   if (info->num_dst && inst->Dst[0].Register.File == TGSI_FILE_RESOURCE)
+      return;
+
    if(info->num_dst) {
       LLVMValueRef pred[TGSI_NUM_CHANNELS];
 
@@ -2940,6 +2986,12 @@ lp_emit_declaration_soa(
       break;
 
    case TGSI_FILE_OUTPUT:
+      if (decl->Declaration.Invariant) {
+         /* Fusing would give different results than other shaders
+          * computing the same output.
+          */
+         bld_base->fuse_mad = FALSE;
+      }
       if (!(bld->indirect_files & (1 << TGSI_FILE_OUTPUT))) {
          for (idx = first; idx <= last; ++idx) {
             for (i = 0; i < TGSI_NUM_CHANNELS; i++)
@@ -3719,12 +3771,213 @@ cont_emit(
    lp_exec_continue(&bld->exec_mask);
 }
 
+static void
+load_emit(
+   const struct lp_build_tgsi_action * action,
+   struct lp_build_tgsi_context * bld_base,
+   struct lp_build_emit_data * emit_data)
+{
+   struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
+   LLVMBuilderRef builder = bld_base->base.gallivm->builder;
+   const struct tgsi_full_instruction *inst = emit_data->inst;
+   LLVMValueRef offset;
+
+   if (inst->Src[0].Register.File != TGSI_FILE_RESOURCE ||
+       inst->Src[0].Register.Indirect) {
+      debug_printf("%s: unsupported resource operand\n", __FUNCTION__);
+      return;
+   }
+
+   offset = lp_build_emit_fetch(bld_base, inst, 1, TGSI_CHAN_X);
+   offset = LLVMBuildBitCast(builder, offset, bld_base->uint_bld.vec_type, "");
+
+   bld->cs_iface->emit_load(bld->cs_iface, bld_base,
+                            inst->Src[0].Register.Index,
+                            offset, mask_vec(bld_base),
+                            inst->Dst[0].Register.WriteMask,
+                            emit_data->output);
+}
+
+static void
+store_emit(
+   const struct lp_build_tgsi_action * action,
+   struct lp_build_tgsi_context * bld_base,
+   struct lp_build_emit_data * emit_data)
+{
+   struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
+   LLVMBuilderRef builder = bld_base->base.gallivm->builder;
+   const struct tgsi_full_instruction *inst = emit_data->inst;
+   LLVMValueRef values[TGSI_NUM_CHANNELS] = { NULL };
+   LLVMValueRef offset;
+   unsigned chan;
+
+   if (inst->Dst[0].Register.File != TGSI_FILE_RESOURCE ||
+       inst->Dst[0].Register.Indirect) {
+      debug_printf("%s: unsupported resource operand\n", __FUNCTION__);
+      return;
+   }
+
+   offset = lp_build_emit_fetch(bld_base, inst, 0, TGSI_CHAN_X);
+   offset = LLVMBuildBitCast(builder, offset, bld_base->uint_bld.vec_type, "");
+
+   TGSI_FOR_EACH_DST0_ENABLED_CHANNEL(inst, chan) {
+      values[chan] = lp_build_emit_fetch(bld_base, inst, 1, chan);
+      values[chan] = LLVMBuildBitCast(builder, values[chan],
+                                      bld_base->base.vec_type, "");
+   }
+
+   bld->cs_iface->emit_store(bld->cs_iface, bld_base,
+                             inst->Dst[0].Register.Index,
+                             offset, mask_vec(bld_base),
+                             inst->Dst[0].Register.WriteMask,
+                             values);
+}
+
+static void
+mfence_emit(
+   const struct lp_build_tgsi_action * action,
+   struct lp_build_tgsi_context * bld_base,
+   struct lp_build_emit_data * emit_data)
+{
+   /*
+    * All the invocations of a block run on the same thread and memory
+    * accesses are emitted in program order, so there's nothing to do.
+    */
+}
+
+/**
+ * Get a pointer to the given vector slot of the barrier state.
+ */
+static LLVMValueRef
+get_phase_state_ptr(struct lp_build_tgsi_soa_context *bld,
+                    unsigned index)
+{
+   struct gallivm_state *gallivm = bld->bld_base.base.gallivm;
+   LLVMValueRef lindex = lp_build_const_int32(gallivm, index);
+
+   return LLVMBuildGEP(gallivm->builder, bld->temps_array, &lindex, 1, "");
+}
+
+/**
+ * Spill the registers which aren't already kept in the barrier state
+ * (address registers and the return mask of main).
+ */
+static void
+save_phase_state(struct lp_build_tgsi_soa_context *bld)
+{
+   const struct tgsi_shader_info *info = bld->bld_base.info;
+   LLVMBuilderRef builder = bld->bld_base.base.gallivm->builder;
+   LLVMTypeRef vec_type = bld->bld_base.base.vec_type;
+   unsigned base = (info->file_max[TGSI_FILE_TEMPORARY] + 1) * 4;
+   int idx;
+   unsigned chan;
+
+   for (idx = 0; idx <= info->file_max[TGSI_FILE_ADDRESS]; idx++) {
+      for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+         LLVMValueRef val;
+         if (!bld->addr[idx][chan])
+            continue;
+         val = LLVMBuildLoad(builder, bld->addr[idx][chan], "");
+         val = LLVMBuildBitCast(builder, val, vec_type, "");
+         LLVMBuildStore(builder, val,
+                        get_phase_state_ptr(bld, base + idx * 4 + chan));
+      }
+   }
+
+   if (bld->exec_mask.ret_in_main) {
+      LLVMValueRef val = LLVMBuildBitCast(builder, bld->exec_mask.ret_mask,
+                                          vec_type, "");
+      LLVMBuildStore(builder, val,
+                     get_phase_state_ptr(bld,
+                                         lp_build_tgsi_cs_state_length(info) - 1));
+   }
+}
+
+static void
+restore_phase_state(struct lp_build_tgsi_soa_context *bld)
+{
+   const struct tgsi_shader_info *info = bld->bld_base.info;
+   LLVMBuilderRef builder = bld->bld_base.base.gallivm->builder;
+   LLVMTypeRef int_vec_type = bld->bld_base.base.int_vec_type;
+   unsigned base = (info->file_max[TGSI_FILE_TEMPORARY] + 1) * 4;
+   int idx;
+   unsigned chan;
+
+   for (idx = 0; idx <= info->file_max[TGSI_FILE_ADDRESS]; idx++) {
+      for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+         LLVMValueRef val;
+         if (!bld->addr[idx][chan])
+            continue;
+         val = LLVMBuildLoad(builder,
+                             get_phase_state_ptr(bld, base + idx * 4 + chan),
+                             "");
+         val = LLVMBuildBitCast(builder, val, int_vec_type, "");
+         LLVMBuildStore(builder, val, bld->addr[idx][chan]);
+      }
+   }
+
+   if (bld->exec_mask.ret_in_main) {
+      LLVMValueRef val;
+      val = LLVMBuildLoad(builder,
+                          get_phase_state_ptr(bld,
+                                              lp_build_tgsi_cs_state_length(info) - 1),
+                          "");
+      bld->exec_mask.ret_mask = LLVMBuildBitCast(builder, val,
+                                                 bld->exec_mask.int_vec_type,
+                                                 "");
+      lp_exec_mask_update(&bld->exec_mask);
+   }
+}
+
+/**
+ * Suspend the invocation: return the barrier's phase to the caller, which
+ * calls us again once all the invocations of the block have got there.
+ */
+static void
+barrier_emit(
+   const struct lp_build_tgsi_action * action,
+   struct lp_build_tgsi_context * bld_base,
+   struct lp_build_emit_data * emit_data)
+{
+   struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
+   struct gallivm_state * gallivm = bld_base->base.gallivm;
+   struct lp_exec_mask *mask = &bld->exec_mask;
+   struct function_ctx *ctx = func_ctx(mask);
+   LLVMBasicBlockRef resume_block;
+   LLVMValueRef phase;
+
+   /* Shaders for which lp_build_tgsi_has_divergent_barrier() is true must
+    * have been rejected before getting here.
+    */
+   assert(!ctx->cond_stack_size && !ctx->loop_stack_size &&
+          !ctx->switch_stack_size && mask->function_stack_size == 1);
+   (void)ctx;
+
+   phase = lp_build_const_int32(gallivm, ++bld->num_phases);
+
+   save_phase_state(bld);
+   LLVMBuildRet(gallivm->builder, phase);
+
+   resume_block = lp_build_insert_new_block(gallivm, "resume");
+   LLVMAddCase(bld->phase_switch, phase, resume_block);
+   LLVMPositionBuilderAtEnd(gallivm->builder, resume_block);
+
+   restore_phase_state(bld);
+}
+
 static void emit_prologue(struct lp_build_tgsi_context * bld_base)
 {
    struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
    struct gallivm_state * gallivm = bld_base->base.gallivm;
 
-   if (bld->indirect_files & (1 << TGSI_FILE_TEMPORARY)) {
+   if (bld->use_phase_state) {
+      /* temporaries must survive barriers, keep them in the caller's state */
+      bld->temps_array =
+         LLVMBuildBitCast(gallivm->builder, bld->cs_iface->state_ptr,
+                          LLVMPointerType(bld_base->base.vec_type, 0),
+                          "temp_array");
+   }
+   else if (bld->indirect_files & (1 << TGSI_FILE_TEMPORARY)) {
       LLVMValueRef array_size =
          lp_build_const_int32(gallivm,
                          bld_base->info->file_max[TGSI_FILE_TEMPORARY] * 4 + 4);
@@ -3810,6 +4063,24 @@ static void emit_prologue(struct lp_build_tgsi_context * bld_base)
    }
 }
 
+static void emit_prologue_post_decl(struct lp_build_tgsi_context * bld_base)
+{
+   struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
+   struct gallivm_state * gallivm = bld_base->base.gallivm;
+
+   bld_base->pc = bld->cs_iface->entry_pc;
+
+   if (bld->use_phase_state) {
+      /* everything above runs on each call, now jump to the current phase */
+      LLVMBasicBlockRef phase0_block =
+         lp_build_insert_new_block(gallivm, "phase0");
+      bld->phase_switch =
+         LLVMBuildSwitch(gallivm->builder, bld->cs_iface->phase, phase0_block,
+                         bld_base->info->opcode_count[TGSI_OPCODE_BARRIER]);
+      LLVMPositionBuilderAtEnd(gallivm->builder, phase0_block);
+   }
+}
+
 static void emit_epilogue(struct lp_build_tgsi_context * bld_base)
 {
    struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
@@ -3861,7 +4132,8 @@ lp_build_tgsi_soa(struct gallivm_state *gallivm,
                   LLVMValueRef context_ptr,
                   struct lp_build_sampler_soa *sampler,
                   const struct tgsi_shader_info *info,
-                  const struct lp_build_tgsi_gs_iface *gs_iface)
+                  const struct lp_build_tgsi_gs_iface *gs_iface,
+                  const struct lp_build_tgsi_cs_iface *cs_iface)
 {
    struct lp_build_tgsi_soa_context bld;
 
@@ -3916,6 +4188,7 @@ lp_build_tgsi_soa(struct gallivm_state *gallivm,
 
 
    bld.bld_base.soa = TRUE;
+   bld.bld_base.fuse_mad = lp_fuse_mad;
    bld.bld_base.emit_debug = emit_debug;
    bld.bld_base.emit_fetch_funcs[TGSI_FILE_CONSTANT] = emit_fetch_constant;
    bld.bld_base.emit_fetch_funcs[TGSI_FILE_IMMEDIATE] = emit_fetch_immediate;
@@ -4000,6 +4273,21 @@ lp_build_tgsi_soa(struct gallivm_state *gallivm,
                                 max_output_vertices);
    }
 
+   if (cs_iface) {
+      bld.cs_iface = cs_iface;
+      bld.bld_base.op_actions[TGSI_OPCODE_LOAD].emit = load_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_STORE].emit = store_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_MFENCE].emit = mfence_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_BARRIER].emit = barrier_emit;
+
+      bld.bld_base.emit_prologue_post_decl = emit_prologue_post_decl;
+
+      if (info->opcode_count[TGSI_OPCODE_BARRIER]) {
+         bld.use_phase_state = TRUE;
+         bld.indirect_files |= (1 << TGSI_FILE_TEMPORARY);
+      }
+   }
+
    lp_exec_mask_init(&bld.exec_mask, &bld.bld_base.int_bld);
 
    bld.system_values = *system_values;
@@ -4023,3 +4311,67 @@ lp_build_tgsi_soa(struct gallivm_state *gallivm,
    }
    lp_exec_mask_fini(&bld.exec_mask);
 }
+
+
+/**
+ * Number of vectors of barrier state needed per invocation of a compute
+ * shader built with lp_build_tgsi_soa(), or zero if it has no barriers.
+ */
+unsigned
+lp_build_tgsi_cs_state_length(const struct tgsi_shader_info *info)
+{
+   if (!info->opcode_count[TGSI_OPCODE_BARRIER])
+      return 0;
+
+   return (info->file_max[TGSI_FILE_TEMPORARY] + 1) * 4 +
+          (info->file_max[TGSI_FILE_ADDRESS] + 1) * 4 + 1;
+}
+
+
+/**
+ * Whether the shader has a BARRIER within flow control or a subroutine.
+ * lp_build_tgsi_soa() can only suspend the invocation at barriers in the
+ * top level of main, so such shaders can't be built.
+ */
+boolean
+lp_build_tgsi_has_divergent_barrier(const struct tgsi_token *tokens)
+{
+   struct tgsi_parse_context parse;
+   unsigned depth = 0;
+   boolean divergent = FALSE;
+
+   if (tgsi_parse_init(&parse, tokens) != TGSI_PARSE_OK)
+      return FALSE;
+
+   while (!tgsi_parse_end_of_tokens(&parse) && !divergent) {
+      tgsi_parse_token(&parse);
+
+      if (parse.FullToken.Token.Type != TGSI_TOKEN_TYPE_INSTRUCTION)
+         continue;
+
+      switch (parse.FullToken.FullInstruction.Instruction.Opcode) {
+      case TGSI_OPCODE_IF:
+      case TGSI_OPCODE_UIF:
+      case TGSI_OPCODE_BGNLOOP:
+      case TGSI_OPCODE_SWITCH:
+      case TGSI_OPCODE_BGNSUB:
+         depth++;
+         break;
+      case TGSI_OPCODE_ENDIF:
+      case TGSI_OPCODE_ENDLOOP:
+      case TGSI_OPCODE_ENDSWITCH:
+      case TGSI_OPCODE_ENDSUB:
+         if (depth)
+            depth--;
+         break;
+      case TGSI_OPCODE_BARRIER:
+         divergent = depth != 0;
+         break;
+      default:
+         break;
+      }
+   }
+
+   tgsi_parse_free(&parse);
+   return divergent;
+}
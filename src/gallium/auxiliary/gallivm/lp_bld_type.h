@@ -49,6 +49,12 @@
  */
 extern unsigned lp_native_vector_width;
 
+/**
+ * Whether TGSI MAD may be emitted as a fused multiply-add, as set with
+ * GALLIVM_FUSE_MAD.  Shaders with invariant outputs never fuse.
+ */
+extern boolean lp_fuse_mad;
+
 /**
  * Maximum supported vector width (not necessarily supported at run-time).
  *
@@ -59,6 +59,11 @@
 #error unexpected platform in os_sysinfo.c
 #endif
 
+#if defined(PIPE_OS_LINUX)
+#  include "c11/threads.h"
+#  include "util/u_math.h"
+#endif
+
 
 void
 os_log_message(const char *message)
@@ -155,3 +160,124 @@ os_get_total_physical_memory(uint64_t *size)
    return false;
 #endif
 }
+
+
+#if defined(PIPE_OS_LINUX)
+
+/**
+ * CPU to NUMA node table, read from sysfs the first time it's needed.
+ * The topology doesn't change while we're running, so it is never freed.
+ */
+static int *cpu_numa_nodes;
+static unsigned num_cpu_numa_nodes;
+static once_flag cpu_numa_nodes_once = ONCE_FLAG_INIT;
+
+
+/**
+ * Parse a sysfs list file like "0-3,8,10-11".
+ * If table is not NULL, table[i] is set to value for every member i that is
+ * less than table_size.
+ * \return the highest member plus one, or 0 if the file can't be read
+ */
+static unsigned
+read_sysfs_list(const char *path, int *table, unsigned table_size, int value)
+{
+   char buf[4096];
+   const char *str = buf;
+   unsigned end = 0;
+   FILE *f;
+
+   f = fopen(path, "r");
+   if (!f)
+      return 0;
+
+   if (!fgets(buf, sizeof buf, f)) {
+      fclose(f);
+      return 0;
+   }
+   fclose(f);
+
+   while (*str) {
+      unsigned first, last, i;
+      char *next;
+
+      first = last = strtoul(str, &next, 10);
+      if (next == str)
+         break;
+      if (*next == '-') {
+         str = next + 1;
+         last = strtoul(str, &next, 10);
+         if (next == str || last < first)
+            break;
+      }
+
+      if (table) {
+         for (i = first; i <= last && i < table_size; i++)
+            table[i] = value;
+      }
+      end = MAX2(end, last + 1);
+
+      if (*next != ',')
+         break;
+      str = next + 1;
+   }
+
+   return end;
+}
+
+
+static void
+init_cpu_numa_nodes(void)
+{
+   unsigned num_nodes, num_cpus, cpu, node;
+   char path[64];
+   int *nodes;
+
+   num_nodes = read_sysfs_list("/sys/devices/system/node/possible",
+                               NULL, 0, 0);
+   num_cpus = read_sysfs_list("/sys/devices/system/cpu/possible",
+                              NULL, 0, 0);
+   if (!num_nodes || !num_cpus)
+      return;
+
+   nodes = malloc(num_cpus * sizeof *nodes);
+   if (!nodes)
+      return;
+
+   for (cpu = 0; cpu < num_cpus; cpu++)
+      nodes[cpu] = -1;
+
+   /* Possible but offline nodes have no directory, so they're skipped. */
+   for (node = 0; node < num_nodes; node++) {
+      snprintf(path, sizeof path,
+               "/sys/devices/system/node/node%u/cpulist", node);
+      read_sysfs_list(path, nodes, num_cpus, node);
+   }
+
+   cpu_numa_nodes = nodes;
+   num_cpu_numa_nodes = num_cpus;
+}
+
+#endif /* PIPE_OS_LINUX */
+
+
+/**
+ * Return the NUMA node the given CPU belongs to.
+ * \param cpu  the CPU number, as used for thread affinity
+ * \return the node number, or -1 if unknown
+ */
+int
+os_get_cpu_numa_node(unsigned cpu)
+{
+#if defined(PIPE_OS_LINUX)
+   call_once(&cpu_numa_nodes_once, init_cpu_numa_nodes);
+
+   if (cpu >= num_cpu_numa_nodes)
+      return -1;
+
+   return cpu_numa_nodes[cpu];
+#else
+   (void)cpu;
+   return -1;
+#endif
+}
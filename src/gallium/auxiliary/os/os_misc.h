@@ -94,6 +94,13 @@ bool
 os_get_total_physical_memory(uint64_t *size);
 
 
+/*
+ * Get the NUMA node the given CPU belongs to, or -1 if unknown.
+ */
+int
+os_get_cpu_numa_node(unsigned cpu);
+
+
 #ifdef	__cplusplus
 }
 #endif
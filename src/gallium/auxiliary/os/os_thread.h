@@ -97,6 +97,65 @@ static INLINE void pipe_thread_setname( const char *name )
 }
 
 
+/**
+ * Restrict the calling thread to run on the given CPUs only.
+ * Returns FALSE if that isn't supported on this platform or failed.
+ */
+static INLINE boolean pipe_thread_setaffinity( const unsigned *cpus,
+                                               unsigned num_cpus )
+{
+#if defined(HAVE_PTHREAD) && defined(PIPE_OS_LINUX) && defined(CPU_SETSIZE)
+   cpu_set_t set;
+   unsigned i;
+
+   CPU_ZERO(&set);
+   for (i = 0; i < num_cpus; i++) {
+      if (cpus[i] < CPU_SETSIZE)
+         CPU_SET(cpus[i], &set);
+   }
+
+   return pthread_setaffinity_np(pthread_self(), sizeof set, &set) == 0;
+#else
+   (void)cpus;
+   (void)num_cpus;
+   return FALSE;
+#endif
+}
+
+
+/**
+ * Get the CPUs the calling thread may run on, e.g. as restricted by the
+ * process' affinity mask or cpuset, in increasing order.  Stores at most
+ * max_cpus of them to cpus, and returns how many there are, or 0 if that
+ * isn't supported on this platform or failed.
+ */
+static INLINE unsigned pipe_thread_getaffinity( unsigned *cpus,
+                                                unsigned max_cpus )
+{
+#if defined(HAVE_PTHREAD) && defined(PIPE_OS_LINUX) && defined(CPU_SETSIZE)
+   cpu_set_t set;
+   unsigned i, n = 0;
+
+   if (pthread_getaffinity_np(pthread_self(), sizeof set, &set) != 0)
+      return 0;
+
+   for (i = 0; i < CPU_SETSIZE; i++) {
+      if (CPU_ISSET(i, &set)) {
+         if (n < max_cpus)
+            cpus[n] = i;
+         n++;
+      }
+   }
+
+   return n;
+#else
+   (void)cpus;
+   (void)max_cpus;
+   return 0;
+#endif
+}
+
+
 /* pipe_mutex
  */
 typedef mtx_t pipe_mutex;
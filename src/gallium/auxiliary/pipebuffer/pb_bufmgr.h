@@ -166,6 +166,17 @@ pb_cache_manager_create(struct pb_manager *provider,
                         unsigned bypass_usage,
                         uint64_t maximum_cache_size);
 
+/**
+ * Statistics of a buffer cache: the number of buffer requests it served
+ * from the cache and of those it passed on to the provider, and the size
+ * of the buffers it holds.
+ */
+void
+pb_cache_manager_get_stats(struct pb_manager *mgr,
+                           uint64_t *num_hits,
+                           uint64_t *num_misses,
+                           uint64_t *cache_size);
+
 
 struct pb_fence_ops;
 
@@ -37,6 +37,7 @@
 #include "pipe/p_compiler.h"
 #include "util/u_debug.h"
 #include "os/os_thread.h"
+#include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/list.h"
 #include "util/u_time.h"
@@ -51,6 +52,18 @@
 #define SUPER(__derived) (&(__derived)->base)
 
 
+/**
+ * Number of size classes per power of two.
+ */
+#define PB_CACHE_CLASSES_PER_POT 4
+
+/**
+ * Number of buckets, which must be a power of two.  Each bucket holds the
+ * buffers of the size classes and usages which hash to it.
+ */
+#define PB_CACHE_NUM_BUCKETS 256
+
+
 struct pb_cache_manager;
 
 
@@ -64,10 +77,17 @@ struct pb_cache_buffer
    struct pb_buffer *buffer;
    struct pb_cache_manager *mgr;
 
+   /** Usage the buffer was requested with */
+   unsigned desc_usage;
+
    /** Caching time interval */
    int64_t start, end;
 
+   /** Link in pb_cache_manager::delayed */
    struct list_head head;
+
+   /** Link in the bucket of the buffer's size class and usage */
+   struct list_head bucket_head;
 };
 
 
@@ -80,11 +100,22 @@ struct pb_cache_manager
    
    pipe_mutex mutex;
    
+   /**
+    * All the cached buffers, least recently destroyed first, which is also
+    * the order they expire in.
+    */
    struct list_head delayed;
+
+   /** The same buffers, least recently destroyed first in each bucket */
+   struct list_head buckets[PB_CACHE_NUM_BUCKETS];
+
    pb_size numDelayed;
    float size_factor;
    unsigned bypass_usage;
    uint64_t cache_size, max_cache_size;
+
+   /** Buffer requests served from the cache, and those which weren't */
+   uint64_t num_hits, num_misses;
 };
 
 
@@ -104,6 +135,34 @@ pb_cache_manager(struct pb_manager *mgr)
 }
 
 
+/**
+ * Size class of a buffer size: PB_CACHE_CLASSES_PER_POT classes per power
+ * of two, so that the sizes in a class are within 25% of each other.
+ */
+static INLINE unsigned
+pb_cache_size_class(pb_size size)
+{
+   unsigned log2;
+
+   if (size < PB_CACHE_CLASSES_PER_POT)
+      return size;
+
+   log2 = util_logbase2(size);
+   return log2 * PB_CACHE_CLASSES_PER_POT +
+          ((size >> (log2 - 2)) & (PB_CACHE_CLASSES_PER_POT - 1));
+}
+
+
+static INLINE struct list_head *
+pb_cache_bucket(struct pb_cache_manager *mgr, unsigned size_class,
+                unsigned usage)
+{
+   unsigned hash = size_class * 0x9e3779b1 ^ usage * 0x85ebca6b;
+
+   return &mgr->buckets[(hash >> 16) & (PB_CACHE_NUM_BUCKETS - 1)];
+}
+
+
 /**
  * Actually destroy the buffer.
  */
@@ -113,6 +172,7 @@ _pb_cache_buffer_destroy(struct pb_cache_buffer *buf)
    struct pb_cache_manager *mgr = buf->mgr;
 
    LIST_DEL(&buf->head);
+   LIST_DEL(&buf->bucket_head);
    assert(mgr->numDelayed);
    --mgr->numDelayed;
    mgr->cache_size -= buf->base.size;
@@ -124,6 +184,8 @@ _pb_cache_buffer_destroy(struct pb_cache_buffer *buf)
 
 /**
  * Free as many cache buffers from the list head as possible. 
+ *
+ * Every buffer is freed at most once, so this takes amortized constant time.
  */
 static void
 _pb_cache_buffer_list_check_free(struct pb_cache_manager *mgr)
@@ -172,6 +234,9 @@ pb_cache_buffer_destroy(struct pb_buffer *_buf)
    buf->start = os_time_get();
    buf->end = buf->start + mgr->usecs;
    LIST_ADDTAIL(&buf->head, &mgr->delayed);
+   LIST_ADDTAIL(&buf->bucket_head,
+                pb_cache_bucket(mgr, pb_cache_size_class(buf->base.size),
+                                buf->desc_usage));
    ++mgr->numDelayed;
    mgr->cache_size += buf->base.size;
    pipe_mutex_unlock(mgr->mutex);
@@ -240,9 +305,6 @@ pb_cache_is_buffer_compat(struct pb_cache_buffer *buf,
                           pb_size size,
                           const struct pb_desc *desc)
 {
-   if (desc->usage & buf->mgr->bypass_usage)
-      return 0;
-
    if(buf->base.size < size)
       return 0;
 
@@ -272,69 +334,83 @@ pb_cache_is_buffer_compat(struct pb_cache_buffer *buf,
 }
 
 
+/**
+ * Find a cached buffer for a request, looking only at the buckets of the
+ * size classes the size factor allows, with the requested usage.
+ */
+static struct pb_cache_buffer *
+pb_cache_find_buffer(struct pb_cache_manager *mgr,
+                     pb_size size,
+                     const struct pb_desc *desc)
+{
+   const uint64_t max_size = (uint64_t) (mgr->size_factor * size);
+   const unsigned first = pb_cache_size_class(size);
+   const unsigned last =
+      pb_cache_size_class(MIN2(max_size, (uint64_t) ~(pb_size) 0));
+   unsigned size_class;
+
+   for (size_class = first; size_class <= last; size_class++) {
+      struct list_head *bucket =
+         pb_cache_bucket(mgr, size_class, desc->usage);
+      struct list_head *curr;
+
+      for (curr = bucket->next; curr != bucket; curr = curr->next) {
+         struct pb_cache_buffer *buf =
+            LIST_ENTRY(struct pb_cache_buffer, curr, bucket_head);
+         int ret;
+
+         /* Skip the other size classes and usages hashing to this bucket. */
+         if (buf->desc_usage != desc->usage ||
+             pb_cache_size_class(buf->base.size) != size_class)
+            continue;
+
+         ret = pb_cache_is_buffer_compat(buf, size, desc);
+         if (ret > 0)
+            return buf;
+
+         /* The buffers destroyed after a busy one are likely busy too. */
+         if (ret < 0)
+            return NULL;
+      }
+   }
+
+   return NULL;
+}
+
+
 static struct pb_buffer *
 pb_cache_manager_create_buffer(struct pb_manager *_mgr, 
                                pb_size size,
                                const struct pb_desc *desc)
 {
    struct pb_cache_manager *mgr = pb_cache_manager(_mgr);
-   struct pb_cache_buffer *buf;
-   struct pb_cache_buffer *curr_buf;
-   struct list_head *curr, *next;
-   int64_t now;
-   int ret = 0;
+   struct pb_cache_buffer *buf = NULL;
 
    pipe_mutex_lock(mgr->mutex);
 
-   buf = NULL;
-   curr = mgr->delayed.next;
-   next = curr->next;
-   
-   /* search in the expired buffers, freeing them in the process */
-   now = os_time_get();
-   while(curr != &mgr->delayed) {
-      curr_buf = LIST_ENTRY(struct pb_cache_buffer, curr, head);
-      if(!buf && (ret = pb_cache_is_buffer_compat(curr_buf, size, desc) > 0))
-         buf = curr_buf;
-      else if(os_time_timeout(curr_buf->start, curr_buf->end, now))
-         _pb_cache_buffer_destroy(curr_buf);
-      else
-         /* This buffer (and all hereafter) are still hot in cache */
-         break;
-      if (ret == -1)
-         break;
-      curr = next; 
-      next = curr->next;
-   }
+   if (!(desc->usage & mgr->bypass_usage))
+      buf = pb_cache_find_buffer(mgr, size, desc);
 
-   /* keep searching in the hot buffers */
-   if(!buf && ret != -1) {
-      while(curr != &mgr->delayed) {
-         curr_buf = LIST_ENTRY(struct pb_cache_buffer, curr, head);
-         ret = pb_cache_is_buffer_compat(curr_buf, size, desc);
-         if (ret > 0) {
-            buf = curr_buf;
-            break;
-         }
-         if (ret == -1)
-            break;
-         /* no need to check the timeout here */
-         curr = next;
-         next = curr->next;
-      }
-   }
-   
    if(buf) {
       mgr->cache_size -= buf->base.size;
       LIST_DEL(&buf->head);
+      LIST_DEL(&buf->bucket_head);
       --mgr->numDelayed;
-      pipe_mutex_unlock(mgr->mutex);
+      ++mgr->num_hits;
+   } else {
+      ++mgr->num_misses;
+   }
+
+   /* Free the expired buffers, if any. */
+   _pb_cache_buffer_list_check_free(mgr);
+
+   pipe_mutex_unlock(mgr->mutex);
+
+   if(buf) {
       /* Increase refcount */
       pipe_reference_init(&buf->base.reference, 1);
       return &buf->base;
    }
-   
-   pipe_mutex_unlock(mgr->mutex);
 
    buf = CALLOC_STRUCT(pb_cache_buffer);
    if(!buf)
@@ -365,6 +441,7 @@ pb_cache_manager_create_buffer(struct pb_manager *_mgr,
    
    buf->base.vtbl = &pb_cache_buffer_vtbl;
    buf->mgr = mgr;
+   buf->desc_usage = desc->usage;
    
    return &buf->base;
 }
@@ -401,6 +478,22 @@ pb_cache_manager_destroy(struct pb_manager *mgr)
    FREE(mgr);
 }
 
+
+void
+pb_cache_manager_get_stats(struct pb_manager *_mgr,
+                           uint64_t *num_hits,
+                           uint64_t *num_misses,
+                           uint64_t *cache_size)
+{
+   struct pb_cache_manager *mgr = pb_cache_manager(_mgr);
+
+   pipe_mutex_lock(mgr->mutex);
+   *num_hits = mgr->num_hits;
+   *num_misses = mgr->num_misses;
+   *cache_size = mgr->cache_size;
+   pipe_mutex_unlock(mgr->mutex);
+}
+
 /**
  * Create a caching buffer manager
  *
@@ -423,6 +516,7 @@ pb_cache_manager_create(struct pb_manager *provider,
                         uint64_t maximum_cache_size)
 {
    struct pb_cache_manager *mgr;
+   unsigned i;
 
    if(!provider)
       return NULL;
@@ -439,6 +533,8 @@ pb_cache_manager_create(struct pb_manager *provider,
    mgr->size_factor = size_factor;
    mgr->bypass_usage = bypass_usage;
    LIST_INITHEAD(&mgr->delayed);
+   for (i = 0; i < PB_CACHE_NUM_BUCKETS; i++)
+      LIST_INITHEAD(&mgr->buckets[i]);
    mgr->numDelayed = 0;
    mgr->max_cache_size = maximum_cache_size;
    pipe_mutex_init(mgr->mutex);
@@ -58,8 +58,10 @@
 #include "tgsi/tgsi_parse.h"
 #include "tgsi/tgsi_util.h"
 #include "tgsi_exec.h"
+#include "util/u_debug.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
+#include "util/u_sse.h"
 
 
 #define DEBUG_EXECUTION 0
@@ -843,6 +845,10 @@ tgsi_check_soa_dependencies(const struct tgsi_full_instruction *inst)
 }
 
 
+static void
+micro_ops_build(struct tgsi_exec_machine *mach);
+
+
 /**
  * Initialize machine state by expanding tokens to full instructions,
  * allocating temporary storage, setting up constants, etc.
@@ -881,6 +887,9 @@ tgsi_exec_machine_bind_shader(
       mach->Instructions = NULL;
       mach->NumInstructions = 0;
 
+      FREE(mach->MicroOps);
+      mach->MicroOps = NULL;
+
       return;
    }
 
@@ -1020,9 +1029,13 @@ tgsi_exec_machine_bind_shader(
    FREE(mach->Instructions);
    mach->Instructions = instructions;
    mach->NumInstructions = numInstructions;
+
+   micro_ops_build(mach);
 }
 
 
+DEBUG_GET_ONCE_BOOL_OPTION(no_micro_ops, "TGSI_EXEC_NO_MICRO_OPS", FALSE)
+
 struct tgsi_exec_machine *
 tgsi_exec_machine_create( void )
 {
@@ -1038,6 +1051,7 @@ tgsi_exec_machine_create( void )
    mach->Addrs = &mach->Temps[TGSI_EXEC_TEMP_ADDR];
    mach->MaxGeometryShaderOutputs = TGSI_MAX_TOTAL_VERTICES;
    mach->Predicates = &mach->Temps[TGSI_EXEC_TEMP_P0];
+   mach->UseMicroOps = !debug_get_option_no_micro_ops();
 
    mach->Inputs = align_malloc(sizeof(struct tgsi_exec_vector) * PIPE_MAX_SHADER_INPUTS, 16);
    mach->Outputs = align_malloc(sizeof(struct tgsi_exec_vector) * PIPE_MAX_SHADER_OUTPUTS, 16);
@@ -1082,6 +1096,7 @@ tgsi_exec_machine_destroy(struct tgsi_exec_machine *mach)
    if (mach) {
       FREE(mach->Instructions);
       FREE(mach->Declarations);
+      FREE(mach->MicroOps);
 
       align_free(mach->Inputs);
       align_free(mach->Outputs);
@@ -1209,6 +1224,532 @@ micro_sub(union tgsi_exec_channel *dst,
    dst->f[3] = src0->f[3] - src1->f[3];
 }
 
+/*
+ * Pre-decoded instructions.
+ *
+ * Most of the time spent in simple ALU instructions goes to decoding their
+ * operands: fetch_source() and store_dest() look at the register file,
+ * indirection, dimension and modifiers of every operand, channel by
+ * channel, each time the instruction runs.  So when a shader is bound, the
+ * instructions whose operands are all direct are lowered into micro-ops
+ * holding pointers to the swizzled source channels and to the destination
+ * register, which tgsi_exec_machine_run() calls instead of going through
+ * exec_instruction().  The micro-ops compute the four lanes of a channel at
+ * once, with SSE where available.
+ */
+
+struct tgsi_exec_micro_src {
+   const uint *chan[TGSI_NUM_CHANNELS];  /**< lane 0 of each swizzled channel */
+   boolean broadcast;   /**< one value for all lanes (IMM, CONST) */
+   boolean absolute;
+   boolean negate;
+
+   /* For re-resolving constants when the constant buffers change. */
+   uint file;
+   uint index;
+   uint dimension;
+   ubyte swizzle[TGSI_NUM_CHANNELS];
+};
+
+struct tgsi_exec_micro_op {
+   /** NULL if the instruction has to go through exec_instruction() */
+   void (*exec)(struct tgsi_exec_machine *mach,
+                const struct tgsi_exec_micro_op *op);
+   struct tgsi_exec_micro_src src[3];
+   union tgsi_exec_channel *dst;   /**< channel X of the dest register */
+   boolean dst_output;  /**< dst is relative to the current output vertex */
+   boolean saturate;
+   uint writemask;
+};
+
+#if defined(PIPE_ARCH_SSE)
+typedef __m128 micro_op_vec;
+#else
+typedef union tgsi_exec_channel micro_op_vec;
+#endif
+
+static const uint micro_op_zero = 0;
+
+static INLINE micro_op_vec
+micro_op_fetch(const struct tgsi_exec_micro_src *src, uint chan)
+{
+   const uint *p = src->chan[chan];
+   micro_op_vec v;
+#if defined(PIPE_ARCH_SSE)
+   const __m128 sign = _mm_set1_ps(-0.0f);
+
+   v = src->broadcast ? _mm_set1_ps(*(const float *) p)
+                      : _mm_loadu_ps((const float *) p);
+   if (src->absolute)
+      v = _mm_andnot_ps(sign, v);
+   if (src->negate)
+      v = _mm_xor_ps(v, sign);
+#else
+   uint i;
+
+   for (i = 0; i < TGSI_QUAD_SIZE; i++)
+      v.u[i] = src->broadcast ? p[0] : p[i];
+   if (src->absolute)
+      micro_abs(&v, &v);
+   if (src->negate)
+      micro_neg(&v, &v);
+#endif
+   return v;
+}
+
+#if defined(PIPE_ARCH_SSE)
+
+#define micro_op_add(a, b) _mm_add_ps(a, b)
+#define micro_op_sub(a, b) _mm_sub_ps(a, b)
+#define micro_op_mul(a, b) _mm_mul_ps(a, b)
+#define micro_op_min(a, b) _mm_min_ps(a, b)
+#define micro_op_max(a, b) _mm_max_ps(a, b)
+#define micro_op_slt(a, b) _mm_and_ps(_mm_cmplt_ps(a, b), _mm_set1_ps(1.0f))
+#define micro_op_sge(a, b) _mm_and_ps(_mm_cmpge_ps(a, b), _mm_set1_ps(1.0f))
+
+#else
+
+static INLINE micro_op_vec
+micro_op_add(micro_op_vec a, micro_op_vec b)
+{
+   micro_op_vec v;
+   micro_add(&v, &a, &b);
+   return v;
+}
+
+static INLINE micro_op_vec
+micro_op_sub(micro_op_vec a, micro_op_vec b)
+{
+   micro_op_vec v;
+   micro_sub(&v, &a, &b);
+   return v;
+}
+
+static INLINE micro_op_vec
+micro_op_mul(micro_op_vec a, micro_op_vec b)
+{
+   micro_op_vec v;
+   micro_mul(&v, &a, &b);
+   return v;
+}
+
+static INLINE micro_op_vec
+micro_op_min(micro_op_vec a, micro_op_vec b)
+{
+   micro_op_vec v;
+   micro_min(&v, &a, &b);
+   return v;
+}
+
+static INLINE micro_op_vec
+micro_op_max(micro_op_vec a, micro_op_vec b)
+{
+   micro_op_vec v;
+   micro_max(&v, &a, &b);
+   return v;
+}
+
+static INLINE micro_op_vec
+micro_op_slt(micro_op_vec a, micro_op_vec b)
+{
+   micro_op_vec v;
+   micro_slt(&v, &a, &b);
+   return v;
+}
+
+static INLINE micro_op_vec
+micro_op_sge(micro_op_vec a, micro_op_vec b)
+{
+   micro_op_vec v;
+   micro_sge(&v, &a, &b);
+   return v;
+}
+
+#endif
+
+/**
+ * Like store_dest(), for the channels in the writemask of \p op.
+ */
+static INLINE void
+micro_op_store(struct tgsi_exec_machine *mach,
+               const struct tgsi_exec_micro_op *op,
+               const micro_op_vec *values)
+{
+   const uint execmask = mach->ExecMask;
+   union tgsi_exec_channel *dst = op->dst;
+   uint chan;
+
+   if (op->dst_output)
+      dst += mach->Temps[TEMP_OUTPUT_I].xyzw[TEMP_OUTPUT_C].u[0] *
+             TGSI_NUM_CHANNELS;
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      if (op->writemask & (1 << chan)) {
+#if defined(PIPE_ARCH_SSE)
+         __m128 v = values[chan];
+
+         if (op->saturate) {
+            /* Not min/max, which would turn NaN into 0. */
+            const __m128 lt0 = _mm_cmplt_ps(v, _mm_setzero_ps());
+            const __m128 gt1 = _mm_cmpgt_ps(v, _mm_set1_ps(1.0f));
+
+            v = _mm_andnot_ps(lt0, v);
+            v = _mm_or_ps(_mm_andnot_ps(gt1, v),
+                          _mm_and_ps(gt1, _mm_set1_ps(1.0f)));
+         }
+
+         if (execmask == 0xf) {
+            _mm_storeu_ps(dst[chan].f, v);
+         } else {
+            const __m128i bits = _mm_setr_epi32(1, 2, 4, 8);
+            const __m128 mask = _mm_castsi128_ps(
+               _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(execmask), bits),
+                               bits));
+            const __m128 old = _mm_loadu_ps(dst[chan].f);
+
+            _mm_storeu_ps(dst[chan].f, _mm_or_ps(_mm_and_ps(mask, v),
+                                                 _mm_andnot_ps(mask, old)));
+         }
+#else
+         const union tgsi_exec_channel *v = &values[chan];
+         uint i;
+
+         for (i = 0; i < TGSI_QUAD_SIZE; i++) {
+            if (execmask & (1 << i)) {
+               if (op->saturate && v->f[i] < 0.0f)
+                  dst[chan].f[i] = 0.0f;
+               else if (op->saturate && v->f[i] > 1.0f)
+                  dst[chan].f[i] = 1.0f;
+               else
+                  dst[chan].u[i] = v->u[i];
+            }
+         }
+#endif
+      }
+   }
+}
+
+static void
+micro_op_exec_mov(struct tgsi_exec_machine *mach,
+                  const struct tgsi_exec_micro_op *op)
+{
+   micro_op_vec dst[TGSI_NUM_CHANNELS];
+   uint chan;
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      if (op->writemask & (1 << chan))
+         dst[chan] = micro_op_fetch(&op->src[0], chan);
+   }
+   micro_op_store(mach, op, dst);
+}
+
+#define MICRO_OP_BINARY(NAME)                                           \
+static void                                                             \
+micro_op_exec_##NAME(struct tgsi_exec_machine *mach,                    \
+                     const struct tgsi_exec_micro_op *op)               \
+{                                                                       \
+   micro_op_vec dst[TGSI_NUM_CHANNELS];                                 \
+   uint chan;                                                           \
+                                                                        \
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {                   \
+      if (op->writemask & (1 << chan))                                  \
+         dst[chan] = micro_op_##NAME(micro_op_fetch(&op->src[0], chan), \
+                                     micro_op_fetch(&op->src[1], chan)); \
+   }                                                                    \
+   micro_op_store(mach, op, dst);                                       \
+}
+
+MICRO_OP_BINARY(add)
+MICRO_OP_BINARY(sub)
+MICRO_OP_BINARY(mul)
+MICRO_OP_BINARY(min)
+MICRO_OP_BINARY(max)
+MICRO_OP_BINARY(slt)
+MICRO_OP_BINARY(sge)
+
+static void
+micro_op_exec_mad(struct tgsi_exec_machine *mach,
+                  const struct tgsi_exec_micro_op *op)
+{
+   micro_op_vec dst[TGSI_NUM_CHANNELS];
+   uint chan;
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      if (op->writemask & (1 << chan))
+         dst[chan] = micro_op_add(
+            micro_op_mul(micro_op_fetch(&op->src[0], chan),
+                         micro_op_fetch(&op->src[1], chan)),
+            micro_op_fetch(&op->src[2], chan));
+   }
+   micro_op_store(mach, op, dst);
+}
+
+static void
+micro_op_exec_lrp(struct tgsi_exec_machine *mach,
+                  const struct tgsi_exec_micro_op *op)
+{
+   micro_op_vec dst[TGSI_NUM_CHANNELS];
+   uint chan;
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      if (op->writemask & (1 << chan)) {
+         const micro_op_vec c = micro_op_fetch(&op->src[2], chan);
+
+         dst[chan] = micro_op_add(
+            micro_op_mul(micro_op_fetch(&op->src[0], chan),
+                         micro_op_sub(micro_op_fetch(&op->src[1], chan), c)),
+            c);
+      }
+   }
+   micro_op_store(mach, op, dst);
+}
+
+static INLINE void
+micro_op_dp(struct tgsi_exec_machine *mach,
+            const struct tgsi_exec_micro_op *op,
+            uint num_chans)
+{
+   micro_op_vec dst[TGSI_NUM_CHANNELS];
+   micro_op_vec sum;
+   uint chan;
+
+   sum = micro_op_mul(micro_op_fetch(&op->src[0], TGSI_CHAN_X),
+                      micro_op_fetch(&op->src[1], TGSI_CHAN_X));
+   for (chan = TGSI_CHAN_Y; chan < num_chans; chan++)
+      sum = micro_op_add(micro_op_mul(micro_op_fetch(&op->src[0], chan),
+                                      micro_op_fetch(&op->src[1], chan)),
+                         sum);
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++)
+      dst[chan] = sum;
+   micro_op_store(mach, op, dst);
+}
+
+static void
+micro_op_exec_dp3(struct tgsi_exec_machine *mach,
+                  const struct tgsi_exec_micro_op *op)
+{
+   micro_op_dp(mach, op, 3);
+}
+
+static void
+micro_op_exec_dp4(struct tgsi_exec_machine *mach,
+                  const struct tgsi_exec_micro_op *op)
+{
+   micro_op_dp(mach, op, 4);
+}
+
+/**
+ * Point the constant operands of the micro-ops at the current constant
+ * buffers, with the bounds check of fetch_src_file_channel().
+ */
+static void
+micro_ops_resolve_consts(struct tgsi_exec_machine *mach)
+{
+   uint i, j, chan;
+
+   for (i = 0; i < mach->NumInstructions; i++) {
+      struct tgsi_exec_micro_op *op = &mach->MicroOps[i];
+
+      if (!op->exec)
+         continue;
+
+      for (j = 0; j < Elements(op->src); j++) {
+         struct tgsi_exec_micro_src *src = &op->src[j];
+
+         if (src->file != TGSI_FILE_CONSTANT)
+            continue;
+
+         for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+            const uint *buf = (const uint *) mach->Consts[src->dimension];
+            const int pos = src->index * 4 + src->swizzle[chan];
+
+            if (buf && pos < (int) mach->ConstsSize[src->dimension])
+               src->chan[chan] = &buf[pos];
+            else
+               src->chan[chan] = &micro_op_zero;
+         }
+      }
+   }
+
+   memcpy(mach->MicroOpConsts, mach->Consts, sizeof(mach->Consts));
+   memcpy(mach->MicroOpConstsSize, mach->ConstsSize, sizeof(mach->ConstsSize));
+}
+
+static boolean
+micro_op_decode_src(struct tgsi_exec_machine *mach,
+                    struct tgsi_exec_micro_src *src,
+                    const struct tgsi_full_src_register *reg)
+{
+   const uint index = reg->Register.Index;
+   uint chan;
+
+   if (reg->Register.Indirect)
+      return FALSE;
+
+   src->file = reg->Register.File;
+   src->index = index;
+   src->dimension = 0;
+   src->absolute = reg->Register.Absolute;
+   src->negate = reg->Register.Negate;
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++)
+      src->swizzle[chan] = tgsi_util_get_full_src_register_swizzle(reg, chan);
+
+   if (reg->Register.Dimension) {
+      if (reg->Register.File != TGSI_FILE_CONSTANT ||
+          reg->Dimension.Indirect ||
+          reg->Dimension.Index >= PIPE_MAX_CONSTANT_BUFFERS)
+         return FALSE;
+      src->dimension = reg->Dimension.Index;
+   }
+
+   switch (reg->Register.File) {
+   case TGSI_FILE_TEMPORARY:
+      if (index >= TGSI_EXEC_NUM_TEMPS)
+         return FALSE;
+      for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++)
+         src->chan[chan] = mach->Temps[index].xyzw[src->swizzle[chan]].u;
+      src->broadcast = FALSE;
+      return TRUE;
+
+   case TGSI_FILE_INPUT:
+      if (mach->Processor == TGSI_PROCESSOR_GEOMETRY ||
+          index >= PIPE_MAX_SHADER_INPUTS)
+         return FALSE;
+      for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++)
+         src->chan[chan] = mach->Inputs[index].xyzw[src->swizzle[chan]].u;
+      src->broadcast = FALSE;
+      return TRUE;
+
+   case TGSI_FILE_IMMEDIATE:
+      if (index >= mach->ImmLimit)
+         return FALSE;
+      for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++)
+         src->chan[chan] = (const uint *) &mach->Imms[index][src->swizzle[chan]];
+      src->broadcast = TRUE;
+      return TRUE;
+
+   case TGSI_FILE_CONSTANT:
+      /* Resolved by micro_ops_resolve_consts(). */
+      src->broadcast = TRUE;
+      return TRUE;
+
+   default:
+      return FALSE;
+   }
+}
+
+static void
+micro_op_decode(struct tgsi_exec_machine *mach,
+                struct tgsi_exec_micro_op *op,
+                const struct tgsi_full_instruction *inst)
+{
+   const struct tgsi_full_dst_register *dst = &inst->Dst[0];
+   uint i;
+
+   switch (inst->Instruction.Opcode) {
+   case TGSI_OPCODE_MOV:
+      op->exec = micro_op_exec_mov;
+      break;
+   case TGSI_OPCODE_ADD:
+      op->exec = micro_op_exec_add;
+      break;
+   case TGSI_OPCODE_SUB:
+      op->exec = micro_op_exec_sub;
+      break;
+   case TGSI_OPCODE_MUL:
+      op->exec = micro_op_exec_mul;
+      break;
+   case TGSI_OPCODE_MIN:
+      op->exec = micro_op_exec_min;
+      break;
+   case TGSI_OPCODE_MAX:
+      op->exec = micro_op_exec_max;
+      break;
+   case TGSI_OPCODE_SLT:
+      op->exec = micro_op_exec_slt;
+      break;
+   case TGSI_OPCODE_SGE:
+      op->exec = micro_op_exec_sge;
+      break;
+   case TGSI_OPCODE_MAD:
+      op->exec = micro_op_exec_mad;
+      break;
+   case TGSI_OPCODE_LRP:
+      op->exec = micro_op_exec_lrp;
+      break;
+   case TGSI_OPCODE_DP3:
+      op->exec = micro_op_exec_dp3;
+      break;
+   case TGSI_OPCODE_DP4:
+      op->exec = micro_op_exec_dp4;
+      break;
+   default:
+      return;
+   }
+
+   if (inst->Instruction.Predicate ||
+       inst->Instruction.NumDstRegs != 1 ||
+       inst->Instruction.NumSrcRegs > Elements(op->src) ||
+       dst->Register.Indirect ||
+       dst->Register.Dimension)
+      goto fallback;
+
+   switch (dst->Register.File) {
+   case TGSI_FILE_TEMPORARY:
+      if (dst->Register.Index >= TGSI_EXEC_NUM_TEMPS)
+         goto fallback;
+      op->dst = mach->Temps[dst->Register.Index].xyzw;
+      op->dst_output = FALSE;
+      break;
+   case TGSI_FILE_OUTPUT:
+      op->dst = mach->Outputs[dst->Register.Index].xyzw;
+      op->dst_output = TRUE;
+      break;
+   default:
+      goto fallback;
+   }
+
+   op->saturate = inst->Instruction.Saturate;
+   op->writemask = dst->Register.WriteMask;
+
+   for (i = 0; i < inst->Instruction.NumSrcRegs; i++) {
+      if (!micro_op_decode_src(mach, &op->src[i], &inst->Src[i]))
+         goto fallback;
+   }
+   return;
+
+fallback:
+   op->exec = NULL;
+}
+
+/**
+ * Lower the instructions of the bound shader into micro-ops, for the
+ * instructions that can be.
+ */
+static void
+micro_ops_build(struct tgsi_exec_machine *mach)
+{
+   uint i;
+
+   FREE(mach->MicroOps);
+   mach->MicroOps = NULL;
+
+   if (!mach->UseMicroOps || !mach->NumInstructions)
+      return;
+
+   mach->MicroOps = (struct tgsi_exec_micro_op *)
+      CALLOC(mach->NumInstructions, sizeof(struct tgsi_exec_micro_op));
+   if (!mach->MicroOps)
+      return;
+
+   for (i = 0; i < mach->NumInstructions; i++)
+      micro_op_decode(mach, &mach->MicroOps[i], &mach->Instructions[i]);
+
+   micro_ops_resolve_consts(mach);
+}
+
+
 static void
 fetch_src_file_channel(const struct tgsi_exec_machine *mach,
                        const uint chan_index,
@@ -5126,6 +5667,12 @@ tgsi_exec_machine_run( struct tgsi_exec_machine *mach )
       exec_declaration( mach, mach->Declarations+i );
    }
 
+   if (mach->MicroOps &&
+       (memcmp(mach->MicroOpConsts, mach->Consts, sizeof(mach->Consts)) ||
+        memcmp(mach->MicroOpConstsSize, mach->ConstsSize,
+               sizeof(mach->ConstsSize))))
+      micro_ops_resolve_consts(mach);
+
    {
 #if DEBUG_EXECUTION
       struct tgsi_exec_vector temps[TGSI_EXEC_NUM_TEMPS + TGSI_EXEC_NUM_TEMP_EXTRAS];
@@ -5148,7 +5695,12 @@ tgsi_exec_machine_run( struct tgsi_exec_machine *mach )
 #endif
 
          assert(pc < (int) mach->NumInstructions);
-         exec_instruction(mach, mach->Instructions + pc, &pc);
+         if (mach->MicroOps && mach->MicroOps[pc].exec) {
+            mach->MicroOps[pc].exec(mach, &mach->MicroOps[pc]);
+            pc++;
+         }
+         else
+            exec_instruction(mach, mach->Instructions + pc, &pc);
 
 #if DEBUG_EXECUTION
          for (i = 0; i < TGSI_EXEC_NUM_TEMPS + TGSI_EXEC_NUM_TEMP_EXTRAS; i++) {
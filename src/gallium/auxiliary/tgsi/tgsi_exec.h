@@ -259,6 +259,10 @@ enum tgsi_break_type {
 #define TGSI_EXEC_MAX_BREAK_STACK (TGSI_EXEC_MAX_LOOP_NESTING + TGSI_EXEC_MAX_SWITCH_NESTING)
 
 
+/** An instruction pre-decoded by tgsi_exec_machine_bind_shader() */
+struct tgsi_exec_micro_op;
+
+
 /**
  * Run-time virtual machine state for executing TGSI shader.
  */
@@ -354,6 +358,17 @@ struct tgsi_exec_machine
    struct tgsi_full_declaration *Declarations;
    uint NumDeclarations;
 
+   /**
+    * Instructions with direct operands only, pre-decoded with their
+    * register pointers resolved; one per instruction.  Set UseMicroOps
+    * before binding the shader to run them.
+    */
+   struct tgsi_exec_micro_op *MicroOps;
+   boolean UseMicroOps;
+   /** The constant buffers the constant operands of MicroOps point into */
+   const void *MicroOpConsts[PIPE_MAX_CONSTANT_BUFFERS];
+   unsigned MicroOpConstsSize[PIPE_MAX_CONSTANT_BUFFERS];
+
    struct tgsi_declaration_sampler_view
       SamplerViews[PIPE_MAX_SHADER_SAMPLER_VIEWS];
 
@@ -37,6 +37,7 @@
 #include "util/u_prim.h"
 
 #include "lp_context.h"
+#include "lp_flush.h"
 #include "lp_state.h"
 #include "lp_query.h"
 
@@ -44,6 +45,50 @@
 
 
 
+/**
+ * The draw module reads the vertex, index and constant buffers, and the
+ * vertex and geometry shader textures, right away on this thread.  Wait for
+ * any queued rendering or compute grid that writes to one of them.
+ */
+static void
+llvmpipe_finish_draw_resources(struct llvmpipe_context *lp,
+                               const struct pipe_draw_info *info)
+{
+   static const unsigned shaders[] = {
+      PIPE_SHADER_VERTEX, PIPE_SHADER_GEOMETRY
+   };
+   struct pipe_context *pipe = &lp->pipe;
+   unsigned i, j;
+
+   for (i = 0; i < lp->num_vertex_buffers; i++) {
+      if (lp->vertex_buffer[i].buffer)
+         llvmpipe_flush_resource(pipe, lp->vertex_buffer[i].buffer, 0,
+                                 TRUE, TRUE, FALSE, "draw_vbo");
+   }
+
+   if (info->indexed && lp->index_buffer.buffer)
+      llvmpipe_flush_resource(pipe, lp->index_buffer.buffer, 0,
+                              TRUE, TRUE, FALSE, "draw_vbo");
+
+   for (i = 0; i < Elements(shaders); i++) {
+      const unsigned shader = shaders[i];
+
+      for (j = 0; j < LP_MAX_TGSI_CONST_BUFFERS; j++) {
+         if (lp->constants[shader][j].buffer)
+            llvmpipe_flush_resource(pipe, lp->constants[shader][j].buffer, 0,
+                                    TRUE, TRUE, FALSE, "draw_vbo");
+      }
+
+      for (j = 0; j < lp->num_sampler_views[shader]; j++) {
+         if (lp->sampler_views[shader][j])
+            llvmpipe_flush_resource(pipe,
+                                    lp->sampler_views[shader][j]->texture, 0,
+                                    TRUE, TRUE, FALSE, "draw_vbo");
+      }
+   }
+}
+
+
 /**
  * Draw vertex arrays, with optional indexing, optional instancing.
  * All the other drawing functions are implemented in terms of this function.
@@ -69,6 +114,8 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
    if (lp->dirty)
       llvmpipe_update_derived( lp );
 
+   llvmpipe_finish_draw_resources(lp, info);
+
    /*
     * Map vertex buffers
     */
@@ -38,6 +38,7 @@
 #include "gallivm/lp_bld_debug.h"
 #include "lp_context.h"
 #include "lp_jit.h"
+#include "lp_state_cs.h"
 
 
 static void
@@ -244,3 +245,58 @@ lp_jit_init_types(struct lp_fragment_shader_variant *lp)
    if (!lp->jit_context_ptr_type)
       lp_jit_create_types(lp);
 }
+
+
+void
+lp_jit_init_cs_types(struct lp_compute_shader_variant *variant)
+{
+   struct gallivm_state *gallivm = variant->gallivm;
+   LLVMContextRef lc = gallivm->context;
+   LLVMTypeRef elem_types[LP_JIT_CS_CTX_COUNT];
+   LLVMTypeRef context_type;
+
+   if (variant->jit_context_ptr_type)
+      return;
+
+   elem_types[LP_JIT_CS_CTX_RESOURCES] =
+      LLVMArrayType(LLVMPointerType(LLVMInt8TypeInContext(lc), 0),
+                    PIPE_MAX_SHADER_RESOURCES);
+   elem_types[LP_JIT_CS_CTX_RESOURCE_SIZES] =
+      LLVMArrayType(LLVMInt32TypeInContext(lc), PIPE_MAX_SHADER_RESOURCES);
+   elem_types[LP_JIT_CS_CTX_INPUT] =
+      LLVMPointerType(LLVMInt8TypeInContext(lc), 0);
+   elem_types[LP_JIT_CS_CTX_INPUT_SIZE] =
+   elem_types[LP_JIT_CS_CTX_LOCAL_SIZE] = LLVMInt32TypeInContext(lc);
+   elem_types[LP_JIT_CS_CTX_BLOCK_SIZE] =
+   elem_types[LP_JIT_CS_CTX_GRID_SIZE] =
+      LLVMArrayType(LLVMInt32TypeInContext(lc), 3);
+
+   context_type = LLVMStructTypeInContext(lc, elem_types,
+                                          Elements(elem_types), 0);
+
+   LP_CHECK_MEMBER_OFFSET(struct lp_jit_cs_context, resources,
+                          gallivm->target, context_type,
+                          LP_JIT_CS_CTX_RESOURCES);
+   LP_CHECK_MEMBER_OFFSET(struct lp_jit_cs_context, resource_sizes,
+                          gallivm->target, context_type,
+                          LP_JIT_CS_CTX_RESOURCE_SIZES);
+   LP_CHECK_MEMBER_OFFSET(struct lp_jit_cs_context, input,
+                          gallivm->target, context_type,
+                          LP_JIT_CS_CTX_INPUT);
+   LP_CHECK_MEMBER_OFFSET(struct lp_jit_cs_context, input_size,
+                          gallivm->target, context_type,
+                          LP_JIT_CS_CTX_INPUT_SIZE);
+   LP_CHECK_MEMBER_OFFSET(struct lp_jit_cs_context, local_size,
+                          gallivm->target, context_type,
+                          LP_JIT_CS_CTX_LOCAL_SIZE);
+   LP_CHECK_MEMBER_OFFSET(struct lp_jit_cs_context, block_size,
+                          gallivm->target, context_type,
+                          LP_JIT_CS_CTX_BLOCK_SIZE);
+   LP_CHECK_MEMBER_OFFSET(struct lp_jit_cs_context, grid_size,
+                          gallivm->target, context_type,
+                          LP_JIT_CS_CTX_GRID_SIZE);
+   LP_CHECK_STRUCT_SIZE(struct lp_jit_cs_context,
+                        gallivm->target, context_type);
+
+   variant->jit_context_ptr_type = LLVMPointerType(context_type, 0);
+}
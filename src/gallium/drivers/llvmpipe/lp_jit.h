@@ -44,6 +44,7 @@
 
 
 struct lp_fragment_shader_variant;
+struct lp_compute_shader_variant;
 struct llvmpipe_screen;
 
 
@@ -248,6 +249,92 @@ typedef void
                     unsigned depth_stride);
 
 
+/**
+ * This structure is passed directly to the generated compute shader.
+ *
+ * Changes here must be reflected in the lp_jit_cs_context_* macros and
+ * lp_jit_init_cs_types function.
+ */
+struct lp_jit_cs_context
+{
+   uint8_t *resources[PIPE_MAX_SHADER_RESOURCES];
+   uint32_t resource_sizes[PIPE_MAX_SHADER_RESOURCES];
+
+   const uint8_t *input;
+   uint32_t input_size;
+
+   uint32_t local_size;
+
+   uint32_t block_size[3];
+   uint32_t grid_size[3];
+};
+
+
+/**
+ * These enum values must match the position of the fields in the
+ * lp_jit_cs_context struct above.
+ */
+enum {
+   LP_JIT_CS_CTX_RESOURCES = 0,
+   LP_JIT_CS_CTX_RESOURCE_SIZES,
+   LP_JIT_CS_CTX_INPUT,
+   LP_JIT_CS_CTX_INPUT_SIZE,
+   LP_JIT_CS_CTX_LOCAL_SIZE,
+   LP_JIT_CS_CTX_BLOCK_SIZE,
+   LP_JIT_CS_CTX_GRID_SIZE,
+   LP_JIT_CS_CTX_COUNT
+};
+
+
+#define lp_jit_cs_context_resources(_gallivm, _ptr) \
+   lp_build_struct_get_ptr(_gallivm, _ptr, LP_JIT_CS_CTX_RESOURCES, "resources")
+
+#define lp_jit_cs_context_resource_sizes(_gallivm, _ptr) \
+   lp_build_struct_get_ptr(_gallivm, _ptr, LP_JIT_CS_CTX_RESOURCE_SIZES, "resource_sizes")
+
+#define lp_jit_cs_context_input(_gallivm, _ptr) \
+   lp_build_struct_get(_gallivm, _ptr, LP_JIT_CS_CTX_INPUT, "input")
+
+#define lp_jit_cs_context_input_size(_gallivm, _ptr) \
+   lp_build_struct_get(_gallivm, _ptr, LP_JIT_CS_CTX_INPUT_SIZE, "input_size")
+
+#define lp_jit_cs_context_local_size(_gallivm, _ptr) \
+   lp_build_struct_get(_gallivm, _ptr, LP_JIT_CS_CTX_LOCAL_SIZE, "local_size")
+
+#define lp_jit_cs_context_block_size(_gallivm, _ptr) \
+   lp_build_struct_get_ptr(_gallivm, _ptr, LP_JIT_CS_CTX_BLOCK_SIZE, "block_size")
+
+#define lp_jit_cs_context_grid_size(_gallivm, _ptr) \
+   lp_build_struct_get_ptr(_gallivm, _ptr, LP_JIT_CS_CTX_GRID_SIZE, "grid_size")
+
+
+/**
+ * typedef for compute shader function
+ *
+ * Runs one vector worth of invocations of a block.
+ *
+ * @param context       jit context
+ * @param block_x       block id x
+ * @param block_y       block id y
+ * @param block_z       block id z
+ * @param first_thread  linear id, within the block, of the first invocation
+ * @param local_mem     block's local memory
+ * @param state         registers preserved across barriers
+ * @param phase         0 to start, or the value returned by a previous call
+ * @return              0 when done, otherwise the barrier the invocations
+ *                      are waiting on
+ */
+typedef uint32_t
+(*lp_jit_cs_func)(const struct lp_jit_cs_context *context,
+                  uint32_t block_x,
+                  uint32_t block_y,
+                  uint32_t block_z,
+                  uint32_t first_thread,
+                  uint8_t *local_mem,
+                  void *state,
+                  uint32_t phase);
+
+
 void
 lp_jit_screen_cleanup(struct llvmpipe_screen *screen);
 
@@ -260,4 +347,8 @@ void
 lp_jit_init_types(struct lp_fragment_shader_variant *lp);
 
 
+void
+lp_jit_init_cs_types(struct lp_compute_shader_variant *variant);
+
+
 #endif /* LP_JIT_H */
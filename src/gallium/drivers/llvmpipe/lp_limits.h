@@ -61,7 +61,17 @@
 #define LP_MAX_WIDTH  (1 << (LP_MAX_TEXTURE_LEVELS - 1))
 
 
-#define LP_MAX_THREADS 16
+/**
+ * Max number of rasterizer threads.  This is only a sanity limit for the
+ * per-thread arrays; the default number of threads is the number of CPUs.
+ */
+#define LP_MAX_THREADS 128
+
+
+/**
+ * Max number of scenes a context may have in flight at once.
+ */
+#define LP_MAX_SCENES 4
 
 
 /**
@@ -93,4 +103,13 @@
  */
 #define LP_MAX_SETUP_VARIANTS 64
 
+
+/**
+ * Compute shader limits: invocations per block, and bytes of local
+ * (per block) and input (per grid) memory.
+ */
+#define LP_MAX_CS_BLOCK_SIZE 1024
+#define LP_MAX_CS_LOCAL_SIZE (32 * 1024)
+#define LP_MAX_CS_INPUT_SIZE 4096
+
 #endif /* LP_LIMITS_H */
@@ -46,6 +46,7 @@ lp_print_counters(void)
 {
    if (LP_DEBUG & DEBUG_COUNTERS) {
       unsigned total_64, total_16, total_4;
+      unsigned i;
       float p1, p2, p3, p4, p5, p6;
 
       debug_printf("llvmpipe: nr_triangles:                 %9u\n", lp_count.nr_tris);
@@ -102,6 +103,18 @@ lp_print_counters(void)
       debug_printf("llvmpipe: nr_color_tile_load:           %9u\n", lp_count.nr_color_tile_load);
       debug_printf("llvmpipe: nr_color_tile_store:          %9u\n", lp_count.nr_color_tile_store);
 
+      for (i = 0; i < LP_MAX_THREADS; i++) {
+         int64_t busy = lp_count.rast_busy_time[i];
+         int64_t idle = lp_count.rast_idle_time[i];
+
+         if (busy + idle == 0)
+            continue;
+
+         debug_printf("llvmpipe: thread %2u busy/idle:         %.3f / %.3f sec (%3.0f%% idle)\n",
+                      i, busy / 1000000.0, idle / 1000000.0,
+                      100.0 * (float) idle / (float) (busy + idle));
+      }
+
       debug_printf("llvmpipe: nr_llvm_compiles:             %u\n", lp_count.nr_llvm_compiles);
       debug_printf("llvmpipe: total LLVM compile time:      %.2f sec\n", lp_count.llvm_compile_time / 1000000.0);
       debug_printf("llvmpipe: average LLVM compile time:    %.2f sec\n", lp_count.llvm_compile_time / 1000000.0 / lp_count.nr_llvm_compiles);
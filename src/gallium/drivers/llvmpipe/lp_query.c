@@ -34,6 +34,7 @@
 #include "pipe/p_defines.h"
 #include "util/u_memory.h"
 #include "os/os_time.h"
+#include "gallivm/lp_bld_init.h"
 #include "lp_context.h"
 #include "lp_flush.h"
 #include "lp_fence.h"
@@ -55,7 +56,9 @@ llvmpipe_create_query(struct pipe_context *pipe,
 {
    struct llvmpipe_query *pq;
 
-   assert(type < PIPE_QUERY_TYPES);
+   assert(type < PIPE_QUERY_TYPES ||
+          type == LP_QUERY_SHADER_CACHE_HITS ||
+          type == LP_QUERY_SHADER_CACHE_MISSES);
 
    pq = CALLOC_STRUCT( llvmpipe_query );
 
@@ -89,6 +92,28 @@ llvmpipe_destroy_query(struct pipe_context *pipe, struct pipe_query *q)
 }
 
 
+/**
+ * Get the current value of a driver-specific query's counter.
+ */
+static uint64_t
+get_driver_query_value(unsigned type)
+{
+   struct gallivm_cache_stats cache_stats;
+
+   gallivm_get_cache_stats(&cache_stats);
+
+   switch (type) {
+   case LP_QUERY_SHADER_CACHE_HITS:
+      return cache_stats.hits;
+   case LP_QUERY_SHADER_CACHE_MISSES:
+      return cache_stats.misses;
+   default:
+      assert(0);
+      return 0;
+   }
+}
+
+
 static boolean
 llvmpipe_get_query_result(struct pipe_context *pipe, 
                           struct pipe_query *q,
@@ -164,6 +189,10 @@ llvmpipe_get_query_result(struct pipe_context *pipe,
       stats->primitives_storage_needed = pq->num_primitives_generated;
    }
       break;
+   case LP_QUERY_SHADER_CACHE_HITS:
+   case LP_QUERY_SHADER_CACHE_MISSES:
+      *result = pq->end[0] - pq->start[0];
+      break;
    case PIPE_QUERY_PIPELINE_STATISTICS: {
       struct pipe_query_data_pipeline_statistics *stats =
          (struct pipe_query_data_pipeline_statistics *)vresult;
@@ -201,6 +230,15 @@ llvmpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
 
    memset(pq->start, 0, sizeof(pq->start));
    memset(pq->end, 0, sizeof(pq->end));
+
+   /* Driver-specific queries count things done at state-change time,
+    * so there is nothing to bin.
+    */
+   if (pq->type >= PIPE_QUERY_DRIVER_SPECIFIC) {
+      pq->start[0] = get_driver_query_value(pq->type);
+      return true;
+   }
+
    lp_setup_begin_query(llvmpipe->setup, pq);
 
    switch (pq->type) {
@@ -245,6 +283,11 @@ llvmpipe_end_query(struct pipe_context *pipe, struct pipe_query *q)
    struct llvmpipe_context *llvmpipe = llvmpipe_context( pipe );
    struct llvmpipe_query *pq = llvmpipe_query(q);
 
+   if (pq->type >= PIPE_QUERY_DRIVER_SPECIFIC) {
+      pq->end[0] = get_driver_query_value(pq->type);
+      return;
+   }
+
    lp_setup_end_query(llvmpipe->setup, pq);
 
    switch (pq->type) {
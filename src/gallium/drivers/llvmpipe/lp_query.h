@@ -41,6 +41,11 @@
 struct llvmpipe_context;
 
 
+/** Driver-specific queries */
+#define LP_QUERY_SHADER_CACHE_HITS   (PIPE_QUERY_DRIVER_SPECIFIC + 0)
+#define LP_QUERY_SHADER_CACHE_MISSES (PIPE_QUERY_DRIVER_SPECIFIC + 1)
+
+
 struct llvmpipe_query {
    uint64_t start[LP_MAX_THREADS];  /* start count value for each thread */
    uint64_t end[LP_MAX_THREADS];    /* end count value for each thread */
@@ -33,6 +33,8 @@
 #include "util/u_pack_color.h"
 #include "util/u_string.h"
 
+
+#include "os/os_misc.h"
 #include "os/os_time.h"
 
 #include "lp_scene_queue.h"
@@ -68,15 +70,21 @@ lp_rast_begin( struct lp_rasterizer *rast,
    LP_DBG(DEBUG_RAST, "%s\n", __FUNCTION__);
 
    lp_scene_begin_rasterization( scene );
-   lp_scene_bin_iter_begin( scene );
+   lp_scene_bin_iter_begin( scene, MAX2(1, rast->num_threads) );
 }
 
 
+/**
+ * Finish rasterizing a scene.
+ * Called once per scene by one thread, after all threads are done with it
+ * but before its fence is signalled.  The framebuffer is unmapped right
+ * away, the rest of the scene is released by the setup code, see
+ * lp_setup_release_finished_scenes().
+ */
 static void
 lp_rast_end( struct lp_rasterizer *rast )
 {
-   lp_scene_end_rasterization( rast->curr_scene );
-
+   lp_scene_unmap_framebuffer( rast->curr_scene );
    rast->curr_scene = NULL;
 }
 
@@ -640,23 +648,9 @@ rasterize_bin(struct lp_rasterizer_task *task,
 }
 
 
-/* An empty bin is one that just loads the contents of the tile and
- * stores them again unchanged.  This typically happens when bins have
- * been flushed for some reason in the middle of a frame, or when
- * incremental updates are being made to a render target.
- * 
- * Try to avoid doing pointless work in this case.
- */
-static boolean
-is_empty_bin( const struct cmd_bin *bin )
-{
-   return bin->head == NULL;
-}
-
-
 /**
  * Rasterize/execute all bins within a scene.
- * Called per thread.
+ * Called per thread.  The caller signals the scene's fence.
  */
 static void
 rasterize_scene(struct lp_rasterizer_task *task,
@@ -664,25 +658,29 @@ rasterize_scene(struct lp_rasterizer_task *task,
 {
    task->scene = scene;
 
-   if (!task->rast->no_rast && !scene->discard) {
-      /* loop over scene bins, rasterize each */
+   if (scene->cs_job) {
+      /* a compute grid: run blocks until there are none left */
+      if (!task->rast->no_rast) {
+         lp_cs_job_run(scene->cs_job, &task->cs_data);
+      }
+   }
+   else if (!task->rast->no_rast && !scene->discard) {
+      /* loop over scene bins, rasterize each.
+       * Empty bins, which would just load and store the tile contents
+       * unchanged, are never handed out.
+       */
       {
          struct cmd_bin *bin;
          int i, j;
 
          assert(scene);
-         while ((bin = lp_scene_bin_iter_next(scene, &i, &j))) {
-            if (!is_empty_bin( bin ))
-               rasterize_bin(task, bin, i, j);
+         while ((bin = lp_scene_bin_iter_next(scene, task->thread_index,
+                                              &i, &j))) {
+            rasterize_bin(task, bin, i, j);
          }
       }
    }
 
-
-   if (scene->fence) {
-      lp_fence_signal(scene->fence);
-   }
-
    task->scene = NULL;
 }
 
@@ -711,6 +709,10 @@ lp_rast_queue_scene( struct lp_rasterizer *rast,
 
       lp_rast_end( rast );
 
+      if (scene->fence) {
+         lp_fence_signal(scene->fence);
+      }
+
       util_fpstate_set(fpstate);
 
       rast->curr_scene = NULL;
@@ -731,19 +733,56 @@ lp_rast_queue_scene( struct lp_rasterizer *rast,
 }
 
 
-void
-lp_rast_finish( struct lp_rasterizer *rast )
+/**
+ * Pin the calling rasterizer thread according to rast->affinity.
+ *
+ * Thread i goes to the i-th CPU the process may run on (modulo their
+ * number), or to the ones of them on the same NUMA node.  CPU numbers
+ * needn't be contiguous, and CPUs outside the process' affinity mask or
+ * cpuset are never used.  Memory the thread touches first, like its
+ * stack, will then be allocated on its own node by the OS.
+ */
+static void
+lp_rast_set_thread_affinity(const struct lp_rasterizer_task *task)
 {
-   if (rast->num_threads == 0) {
-      /* nothing to do */
-   }
-   else {
-      int i;
+   const struct lp_rasterizer *rast = task->rast;
+   unsigned cpu, *cpus;
+   unsigned num_cpus = 0;
+   unsigned i;
+   int node;
 
-      /* wait for work to complete */
-      for (i = 0; i < rast->num_threads; i++) {
-         pipe_semaphore_wait(&rast->tasks[i].work_done);
+   if (rast->num_cpus == 0)
+      return;
+
+   cpu = rast->cpus[task->thread_index % rast->num_cpus];
+
+   switch (rast->affinity) {
+   case LP_RAST_AFFINITY_CORE:
+      pipe_thread_setaffinity(&cpu, 1);
+      break;
+
+   case LP_RAST_AFFINITY_NODE:
+      node = os_get_cpu_numa_node(cpu);
+      if (node < 0) {
+         pipe_thread_setaffinity(&cpu, 1);
+         break;
       }
+
+      cpus = MALLOC(rast->num_cpus * sizeof *cpus);
+      if (!cpus)
+         break;
+
+      for (i = 0; i < rast->num_cpus; i++) {
+         if (os_get_cpu_numa_node(rast->cpus[i]) == node)
+            cpus[num_cpus++] = rast->cpus[i];
+      }
+
+      pipe_thread_setaffinity(cpus, num_cpus);
+      FREE(cpus);
+      break;
+
+   default:
+      break;
    }
 }
 
@@ -752,20 +791,23 @@ lp_rast_finish( struct lp_rasterizer *rast )
  * This is the thread's main entrypoint.
  * It's a simple loop:
  *   1. wait for work
- *   2. do work
- *   3. signal that we're done
+ *   2. do work, signalling the scene's fence
  */
 static PIPE_THREAD_ROUTINE( thread_function, init_data )
 {
    struct lp_rasterizer_task *task = (struct lp_rasterizer_task *) init_data;
    struct lp_rasterizer *rast = task->rast;
+   struct lp_scene *scene;
    boolean debug = false;
    char thread_name[16];
    unsigned fpstate;
+   int64_t t0 = 0, t1 = 0;
 
    util_snprintf(thread_name, sizeof thread_name, "llvmpipe-%u", task->thread_index);
    pipe_thread_setname(thread_name);
 
+   lp_rast_set_thread_affinity(task);
+
    /* Make sure that denorms are treated like zeros. This is 
     * the behavior required by D3D10. OpenGL doesn't care.
     */
@@ -795,27 +837,46 @@ static PIPE_THREAD_ROUTINE( thread_function, init_data )
        */
       pipe_barrier_wait( &rast->barrier );
 
+      /* thread[0] clears rast->curr_scene once it's done with it */
+      scene = rast->curr_scene;
+
       /* do work */
       if (debug)
          debug_printf("thread %d doing work\n", task->thread_index);
 
-      rasterize_scene(task,
-                      rast->curr_scene);
-      
+      if (LP_DEBUG & DEBUG_COUNTERS)
+         t0 = os_time_get();
+
+      rasterize_scene(task, scene);
+
+      if (LP_DEBUG & DEBUG_COUNTERS)
+         t1 = os_time_get();
+
       /* wait for all threads to finish with this scene */
       pipe_barrier_wait( &rast->barrier );
 
-      /* XXX: shouldn't be necessary:
+      if (LP_DEBUG & DEBUG_COUNTERS) {
+         LP_COUNT_ADD(rast_busy_time[task->thread_index], t1 - t0);
+         LP_COUNT_ADD(rast_idle_time[task->thread_index], os_time_get() - t1);
+      }
+
+      /* thread[0]:
+       *  - unmap the framebuffer surfaces
        */
       if (task->thread_index == 0) {
          lp_rast_end( rast );
       }
 
-      /* signal done with work */
+      /* Nobody waits for individual scenes to be done, the setup code
+       * uses the scene fences for that.  The fence is only complete once
+       * thread[0] has signalled it too, i.e. after the unmap above.
+       */
+      if (scene->fence) {
+         lp_fence_signal(scene->fence);
+      }
+
       if (debug)
          debug_printf("thread %d done working\n", task->thread_index);
-
-      pipe_semaphore_signal(&task->work_done);
    }
 
 #ifdef _WIN32
@@ -849,17 +910,20 @@ create_rast_threads(struct lp_rasterizer *rast)
  * Create new lp_rasterizer.  If num_threads is zero, don't create any
  * new threads, do rendering synchronously.
  * \param num_threads  number of rasterizer threads to create
+ * \param affinity  how to place the threads on the CPUs
  */
 struct lp_rasterizer *
-lp_rast_create( unsigned num_threads )
+lp_rast_create( unsigned num_threads, enum lp_rast_affinity affinity )
 {
    struct lp_rasterizer *rast;
    unsigned i;
 
-   rast = CALLOC_STRUCT(lp_rasterizer);
+   /* The tasks are cache line aligned */
+   rast = align_malloc(sizeof *rast, 64);
    if (!rast) {
       goto no_rast;
    }
+   memset(rast, 0, sizeof *rast);
 
    rast->full_scenes = lp_scene_queue_create();
    if (!rast->full_scenes) {
@@ -873,6 +937,17 @@ lp_rast_create( unsigned num_threads )
    }
 
    rast->num_threads = num_threads;
+   rast->affinity = affinity;
+
+   /* The threads inherit our affinity, only place them within it. */
+   if (affinity != LP_RAST_AFFINITY_NONE) {
+      unsigned num_cpus = pipe_thread_getaffinity(NULL, 0);
+
+      rast->cpus = num_cpus ? MALLOC(num_cpus * sizeof *rast->cpus) : NULL;
+      if (rast->cpus)
+         rast->num_cpus = MIN2(pipe_thread_getaffinity(rast->cpus, num_cpus),
+                               num_cpus);
+   }
 
    rast->no_rast = debug_get_bool_option("LP_NO_RAST", FALSE);
 
@@ -886,7 +961,7 @@ lp_rast_create( unsigned num_threads )
    return rast;
 
 no_full_scenes:
-   FREE(rast);
+   align_free(rast);
 no_rast:
    return NULL;
 }
@@ -923,13 +998,17 @@ void lp_rast_destroy( struct lp_rasterizer *rast )
       pipe_semaphore_destroy(&rast->tasks[i].work_ready);
       pipe_semaphore_destroy(&rast->tasks[i].work_done);
    }
+   for (i = 0; i < MAX2(1, rast->num_threads); i++) {
+      lp_cs_thread_data_fini(&rast->tasks[i].cs_data);
+   }
 
    /* for synchronizing rasterization threads */
    pipe_barrier_destroy( &rast->barrier );
 
    lp_scene_queue_destroy(rast->full_scenes);
 
-   FREE(rast);
+   FREE(rast->cpus);
+   align_free(rast);
 }
 
 
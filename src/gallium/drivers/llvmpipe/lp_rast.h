@@ -150,8 +150,19 @@ struct lp_rast_clear_rb {
 
 
 
+/**
+ * Placement of the rasterizer threads on the CPUs.
+ */
+enum lp_rast_affinity {
+   LP_RAST_AFFINITY_NONE,   /**< leave it to the OS scheduler */
+   LP_RAST_AFFINITY_CORE,   /**< pin thread i to allowed CPU i */
+   LP_RAST_AFFINITY_NODE    /**< pin thread i to the NUMA node of allowed
+                                 CPU i */
+};
+
+
 struct lp_rasterizer *
-lp_rast_create( unsigned num_threads );
+lp_rast_create( unsigned num_threads, enum lp_rast_affinity affinity );
 
 void
 lp_rast_destroy( struct lp_rasterizer * );
@@ -160,9 +171,6 @@ void
 lp_rast_queue_scene( struct lp_rasterizer *rast,
                      struct lp_scene *scene );
 
-void
-lp_rast_finish( struct lp_rasterizer *rast );
-
 
 union lp_rast_cmd_arg {
    const struct lp_rast_shader_inputs *shade_tile;
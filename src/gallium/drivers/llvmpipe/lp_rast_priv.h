@@ -35,6 +35,7 @@
 #include "lp_rast.h"
 #include "lp_scene.h"
 #include "lp_state.h"
+#include "lp_state_cs.h"
 #include "lp_texture.h"
 #include "lp_limits.h"
 
@@ -81,7 +82,10 @@ struct cmd_bin;
  */
 struct lp_rasterizer_task
 {
-   const struct cmd_bin *bin;
+   /* Keep each task on its own cache lines, as the tasks of different
+    * threads are written concurrently, possibly from different sockets.
+    */
+   PIPE_ALIGN_VAR(64) const struct cmd_bin *bin;
    const struct lp_rast_state *state;
 
    struct lp_scene *scene;
@@ -102,8 +106,11 @@ struct lp_rasterizer_task
    uint64_t ps_invocations;
    uint8_t ps_inv_multiplier;
 
+   /** Memory for running compute blocks */
+   struct lp_cs_thread_data cs_data;
+
    pipe_semaphore work_ready;
-   pipe_semaphore work_done;
+   pipe_semaphore work_done;   /**< signalled on thread exit */
 };
 
 
@@ -129,6 +136,12 @@ struct lp_rasterizer
    unsigned num_threads;
    pipe_thread threads[LP_MAX_THREADS];
 
+   enum lp_rast_affinity affinity;
+
+   /** CPUs the process may run on, that threads are placed on */
+   unsigned *cpus;
+   unsigned num_cpus;
+
    /** For synchronizing the rasterization threads */
    pipe_barrier barrier;
 };
@@ -31,6 +31,7 @@
 #include "util/u_inlines.h"
 #include "util/simple_list.h"
 #include "util/u_format.h"
+#include "util/u_atomic.h"
 #include "lp_scene.h"
 #include "lp_fence.h"
 #include "lp_debug.h"
@@ -62,8 +63,6 @@ lp_scene_create( struct pipe_context *pipe )
    scene->data.head =
       CALLOC_STRUCT(data_block);
 
-   pipe_mutex_init(scene->mutex);
-
 #ifdef DEBUG
    /* Do some scene limit sanity checks here */
    {
@@ -90,7 +89,6 @@ void
 lp_scene_destroy(struct lp_scene *scene)
 {
    lp_fence_reference(&scene->fence, NULL);
-   pipe_mutex_destroy(scene->mutex);
    assert(scene->data.head->next == NULL);
    FREE(scene->data.head);
    FREE(scene);
@@ -204,12 +202,14 @@ lp_scene_begin_rasterization(struct lp_scene *scene)
 
 
 /**
- * Free all the temporary data in a scene.
+ * Unmap the framebuffer surfaces mapped by lp_scene_begin_rasterization().
+ * Called by the rasterizer as soon as it is done with the scene, so that
+ * display targets aren't kept mapped until the scene is reused.
  */
 void
-lp_scene_end_rasterization(struct lp_scene *scene )
+lp_scene_unmap_framebuffer(struct lp_scene *scene)
 {
-   int i, j;
+   int i;
 
    /* Unmap color buffers */
    for (i = 0; i < scene->fb.nr_cbufs; i++) {
@@ -232,6 +232,19 @@ lp_scene_end_rasterization(struct lp_scene *scene )
                               zsbuf->u.tex.first_layer);
       scene->zsbuf.map = NULL;
    }
+}
+
+
+/**
+ * Free all the temporary data in a scene.
+ */
+void
+lp_scene_end_rasterization(struct lp_scene *scene )
+{
+   int i, j;
+
+   /* Normally done by the rasterizer already */
+   lp_scene_unmap_framebuffer(scene);
 
    /* Reset all command lists:
     */
@@ -296,6 +309,7 @@ lp_scene_end_rasterization(struct lp_scene *scene )
    scene->resource_reference_size = 0;
 
    scene->alloc_failed = FALSE;
+   scene->cs_job = NULL;
 
    util_unreference_framebuffer_state( &scene->fb );
 }
@@ -449,61 +463,139 @@ lp_scene_is_resource_referenced(const struct lp_scene *scene,
 
 
 
-/** advance curr_x,y to the next bin */
-static boolean
-next_bin(struct lp_scene *scene)
+/**
+ * Extract the even bits of a Morton code.
+ */
+static INLINE unsigned
+morton_compact(unsigned v)
 {
-   scene->curr_x++;
-   if (scene->curr_x >= scene->tiles_x) {
-      scene->curr_x = 0;
-      scene->curr_y++;
+   v &= 0x55555555;
+   v = (v | (v >> 1)) & 0x33333333;
+   v = (v | (v >> 2)) & 0x0f0f0f0f;
+   v = (v | (v >> 4)) & 0x00ff00ff;
+   v = (v | (v >> 8)) & 0x0000ffff;
+   return v;
+}
+
+
+/**
+ * Estimate the cost of rasterizing a bin from the number of commands
+ * in it.  Every non-empty bin also pays for loading/storing its tile.
+ */
+static unsigned
+bin_cost(const struct cmd_bin *bin)
+{
+   const struct cmd_block *block;
+   unsigned cost = 1;
+
+   for (block = bin->head; block; block = block->next)
+      cost += block->count;
+
+   return cost;
+}
+
+
+/**
+ * Prepare iterating over the scene's bins with the given number of threads.
+ *
+ * The non-empty bins are sorted in Morton order, so that bins which are
+ * close in the list are also close on screen, and the list is cut into
+ * num_queues ranges of about the same estimated cost.  Must be called by
+ * a single thread before any thread calls lp_scene_bin_iter_next().
+ */
+void
+lp_scene_bin_iter_begin( struct lp_scene *scene, unsigned num_queues )
+{
+   unsigned size = util_next_power_of_two(MAX2(scene->tiles_x,
+                                                scene->tiles_y));
+   unsigned total_cost = 0, cost = 0;
+   unsigned d, i, q;
+
+   assert(num_queues >= 1 && num_queues <= LP_MAX_THREADS);
+
+   scene->num_bins = 0;
+   for (d = 0; d < size * size; d++) {
+      unsigned x = morton_compact(d);
+      unsigned y = morton_compact(d >> 1);
+      const struct cmd_bin *bin;
+
+      if (x >= scene->tiles_x || y >= scene->tiles_y)
+         continue;
+
+      bin = lp_scene_get_bin(scene, x, y);
+      if (bin->head == NULL)
+         continue;
+
+      total_cost += bin_cost(bin);
+      scene->bin_order[scene->num_bins++] = x | (y << 16);
    }
-   if (scene->curr_y >= scene->tiles_y) {
-      /* no more bins */
-      return FALSE;
+
+   /* Give each queue the bins up to its share of the total cost. */
+   i = 0;
+   for (q = 0; q < num_queues; q++) {
+      unsigned limit = (unsigned)((uint64_t)total_cost * (q + 1) / num_queues);
+
+      scene->queues[q].next = i;
+      while (i < scene->num_bins && (cost < limit || q == num_queues - 1)) {
+         unsigned x = scene->bin_order[i] & 0xffff;
+         unsigned y = scene->bin_order[i] >> 16;
+         cost += bin_cost(lp_scene_get_bin(scene, x, y));
+         i++;
+      }
+      scene->queues[q].end = i;
    }
-   return TRUE;
+
+   scene->num_queues = num_queues;
 }
 
 
-void
-lp_scene_bin_iter_begin( struct lp_scene *scene )
+/**
+ * Take the next bin from the given queue, if any is left.
+ */
+static INLINE struct cmd_bin *
+bin_queue_next(struct lp_scene *scene, struct lp_bin_queue *queue,
+               int *x, int *y)
 {
-   scene->curr_x = scene->curr_y = -1;
+   int i;
+
+   if (p_atomic_read(&queue->next) >= queue->end)
+      return NULL;
+
+   i = p_atomic_inc_return(&queue->next) - 1;
+   if (i >= queue->end)
+      return NULL;
+
+   *x = scene->bin_order[i] & 0xffff;
+   *y = scene->bin_order[i] >> 16;
+   return lp_scene_get_bin(scene, *x, *y);
 }
 
 
 /**
- * Return pointer to next bin to be rendered.
- * The lp_scene::curr_x and ::curr_y fields will be advanced.
+ * Return pointer to next bin to be rendered by the thread owning the
+ * given queue, or NULL when all bins have been handed out.
  * Multiple rendering threads will call this function to get a chunk
- * of work (a bin) to work on.
+ * of work (a bin) to work on.  Once a thread's own queue is exhausted it
+ * steals bins from the other queues.
  */
 struct cmd_bin *
-lp_scene_bin_iter_next( struct lp_scene *scene , int *x, int *y)
+lp_scene_bin_iter_next( struct lp_scene *scene, unsigned queue,
+                        int *x, int *y )
 {
-   struct cmd_bin *bin = NULL;
+   struct cmd_bin *bin;
+   unsigned i;
 
-   pipe_mutex_lock(scene->mutex);
+   assert(queue < scene->num_queues);
 
-   if (scene->curr_x < 0) {
-      /* first bin */
-      scene->curr_x = 0;
-      scene->curr_y = 0;
-   }
-   else if (!next_bin(scene)) {
-      /* no more bins left */
-      goto end;
-   }
+   for (i = 0; i < scene->num_queues; i++) {
+      unsigned q = (queue + i) % scene->num_queues;
 
-   bin = lp_scene_get_bin(scene, scene->curr_x, scene->curr_y);
-   *x = scene->curr_x;
-   *y = scene->curr_y;
+      bin = bin_queue_next(scene, &scene->queues[q], x, y);
+      if (bin)
+         return bin;
+   }
 
-end:
-   /*printf("return bin %p at %d, %d\n", (void *) bin, *bin_x, *bin_y);*/
-   pipe_mutex_unlock(scene->mutex);
-   return bin;
+   return NULL;
 }
 
 
@@ -38,9 +38,11 @@
 #include "os/os_thread.h"
 #include "lp_rast.h"
 #include "lp_debug.h"
+#include "lp_limits.h"
 
 struct lp_scene_queue;
 struct lp_rast_state;
+struct lp_cs_job;
 
 /* We're limited to 2K by 2K for 32bit fixed point rasterization.
  * Will need a 64-bit version for larger framebuffers.
@@ -117,6 +119,22 @@ struct data_block_list {
 
 struct resource_ref;
 
+
+/**
+ * Queue of bins for one rasterizer thread.
+ *
+ * A queue covers a contiguous range of lp_scene::bin_order, so each
+ * thread works on a compact region of the framebuffer.  Bins are taken by
+ * atomically incrementing 'next', which is also how idle threads steal
+ * bins from the queues of busy ones.
+ */
+struct lp_bin_queue {
+   int next;   /**< next index into bin_order to hand out */
+   int end;    /**< one past the last index of this queue */
+   char pad[64 - 2 * sizeof(int)];   /**< avoid false sharing */
+};
+
+
 /**
  * All bins and bin data are contained here.
  * Per-bin data goes into the 'tile' bins.
@@ -167,14 +185,23 @@ struct lp_scene {
 
    boolean alloc_failed;
    boolean discard;
+
+   /** Compute grid to run instead of rasterizing bins, if not NULL */
+   struct lp_cs_job *cs_job;
+
    /**
     * Number of active tiles in each dimension.
     * This basically the framebuffer size divided by tile size
     */
    unsigned tiles_x, tiles_y;
 
-   int curr_x, curr_y;  /**< for iterating over bins */
-   pipe_mutex mutex;
+   /** Non-empty bins in Morton order, packed as x | y << 16 */
+   unsigned bin_order[TILES_X * TILES_Y];
+   unsigned num_bins;
+
+   /** Per-thread ranges of bin_order, for iterating over bins */
+   struct lp_bin_queue queues[LP_MAX_THREADS];
+   unsigned num_queues;
 
    struct cmd_bin tile[TILES_X][TILES_Y];
    struct data_block_list data;
@@ -379,10 +406,11 @@ lp_scene_get_num_bins( const struct lp_scene *scene )
 
 
 void
-lp_scene_bin_iter_begin( struct lp_scene *scene );
+lp_scene_bin_iter_begin( struct lp_scene *scene, unsigned num_queues );
 
 struct cmd_bin *
-lp_scene_bin_iter_next( struct lp_scene *scene, int *x, int *y );
+lp_scene_bin_iter_next( struct lp_scene *scene, unsigned queue,
+                        int *x, int *y );
 
 
 
@@ -402,6 +430,9 @@ lp_scene_end_binning( struct lp_scene *scene );
 void
 lp_scene_begin_rasterization(struct lp_scene *scene);
 
+void
+lp_scene_unmap_framebuffer(struct lp_scene *scene);
+
 void
 lp_scene_end_rasterization(struct lp_scene *scene );
 
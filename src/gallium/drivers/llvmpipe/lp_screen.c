@@ -46,6 +46,7 @@
 #include "lp_context.h"
 #include "lp_debug.h"
 #include "lp_public.h"
+#include "lp_query.h"
 #include "lp_limits.h"
 #include "lp_rast.h"
 
@@ -210,7 +211,7 @@ llvmpipe_get_param(struct pipe_screen *screen, enum pipe_cap param)
    case PIPE_CAP_QUADS_FOLLOW_PROVOKING_VERTEX_CONVENTION:
       return 0;
    case PIPE_CAP_COMPUTE:
-      return 0;
+      return 1;
    case PIPE_CAP_USER_VERTEX_BUFFERS:
    case PIPE_CAP_USER_INDEX_BUFFERS:
       return 1;
@@ -329,6 +330,17 @@ llvmpipe_get_shader_param(struct pipe_screen *screen, unsigned shader, enum pipe
       default:
          return draw_get_shader_param(shader, param);
       }
+   case PIPE_SHADER_COMPUTE:
+      switch (param) {
+      case PIPE_SHADER_CAP_MAX_TEXTURE_SAMPLERS:
+      case PIPE_SHADER_CAP_MAX_SAMPLER_VIEWS:
+      case PIPE_SHADER_CAP_MAX_CONST_BUFFER_SIZE:
+      case PIPE_SHADER_CAP_MAX_CONST_BUFFERS:
+         /* only memory resources for now */
+         return 0;
+      default:
+         return gallivm_get_shader_param(param);
+      }
    default:
       return 0;
    }
@@ -362,6 +374,110 @@ llvmpipe_get_paramf(struct pipe_screen *screen, enum pipe_capf param)
 }
 
 
+static int
+llvmpipe_get_compute_param(struct pipe_screen *_screen,
+                           enum pipe_compute_cap param,
+                           void *ret)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(_screen);
+   union {
+      uint64_t u64[3];
+      uint32_t u32;
+   } val;
+   const char *ir_target = "tgsi";
+   const void *ptr = &val;
+   int size;
+
+   memset(&val, 0, sizeof val);
+
+   switch (param) {
+   case PIPE_COMPUTE_CAP_IR_TARGET:
+      ptr = ir_target;
+      size = strlen(ir_target) + 1;
+      break;
+   case PIPE_COMPUTE_CAP_GRID_DIMENSION:
+      val.u64[0] = 3;
+      size = sizeof(uint64_t);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_GRID_SIZE:
+      val.u64[0] = val.u64[1] = val.u64[2] = 65535;
+      size = 3 * sizeof(uint64_t);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_BLOCK_SIZE:
+      val.u64[0] = val.u64[1] = val.u64[2] = LP_MAX_CS_BLOCK_SIZE;
+      size = 3 * sizeof(uint64_t);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_THREADS_PER_BLOCK:
+      val.u64[0] = LP_MAX_CS_BLOCK_SIZE;
+      size = sizeof(uint64_t);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_GLOBAL_SIZE:
+   case PIPE_COMPUTE_CAP_MAX_MEM_ALLOC_SIZE:
+      val.u64[0] = LP_MAX_TEXTURE_SIZE;
+      size = sizeof(uint64_t);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_LOCAL_SIZE:
+      val.u64[0] = LP_MAX_CS_LOCAL_SIZE;
+      size = sizeof(uint64_t);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_PRIVATE_SIZE:
+      /* private memory is not supported */
+      val.u64[0] = 0;
+      size = sizeof(uint64_t);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_INPUT_SIZE:
+      val.u64[0] = LP_MAX_CS_INPUT_SIZE;
+      size = sizeof(uint64_t);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_CLOCK_FREQUENCY:
+      val.u32 = 0; /* unknown */
+      size = sizeof(uint32_t);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_COMPUTE_UNITS:
+      /* blocks are spread over the rasterizer threads */
+      val.u32 = MAX2(1, screen->num_threads);
+      size = sizeof(uint32_t);
+      break;
+   case PIPE_COMPUTE_CAP_IMAGES_SUPPORTED:
+      val.u32 = 0;
+      size = sizeof(uint32_t);
+      break;
+   case PIPE_COMPUTE_CAP_SUBGROUP_SIZE:
+      val.u32 = lp_native_vector_width / 32;
+      size = sizeof(uint32_t);
+      break;
+   default:
+      return 0;
+   }
+
+   if (ret)
+      memcpy(ret, ptr, size);
+
+   return size;
+}
+
+
+static int
+llvmpipe_get_driver_query_info(struct pipe_screen *screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info)
+{
+   static const struct pipe_driver_query_info queries[] = {
+      {"shader-cache-hits", LP_QUERY_SHADER_CACHE_HITS, {0}},
+      {"shader-cache-misses", LP_QUERY_SHADER_CACHE_MISSES, {0}},
+   };
+
+   if (!info)
+      return Elements(queries);
+
+   if (index >= Elements(queries))
+      return 0;
+
+   *info = queries[index];
+   return 1;
+}
+
+
 /**
  * Query format support for creating a texture, drawing surface, etc.
  * \param format  the format to test
@@ -560,6 +676,24 @@ llvmpipe_get_timestamp(struct pipe_screen *_screen)
    return os_time_get_nano();
 }
 
+/**
+ * Parse the LP_THREAD_AFFINITY environment variable.
+ */
+static enum lp_rast_affinity
+lp_get_thread_affinity(void)
+{
+   const char *affinity = debug_get_option("LP_THREAD_AFFINITY", "none");
+
+   if (strcmp(affinity, "core") == 0)
+      return LP_RAST_AFFINITY_CORE;
+   if (strcmp(affinity, "node") == 0)
+      return LP_RAST_AFFINITY_NODE;
+   if (strcmp(affinity, "none") != 0)
+      debug_printf("llvmpipe: unknown LP_THREAD_AFFINITY value %s\n", affinity);
+   return LP_RAST_AFFINITY_NONE;
+}
+
+
 /**
  * Create a new pipe_screen object
  * Note: we're not presently subclassing pipe_screen (no llvmpipe_screen).
@@ -596,6 +730,8 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->base.get_param = llvmpipe_get_param;
    screen->base.get_shader_param = llvmpipe_get_shader_param;
    screen->base.get_paramf = llvmpipe_get_paramf;
+   screen->base.get_compute_param = llvmpipe_get_compute_param;
+   screen->base.get_driver_query_info = llvmpipe_get_driver_query_info;
    screen->base.is_format_supported = llvmpipe_is_format_supported;
 
    screen->base.context_create = llvmpipe_create_context;
@@ -615,7 +751,19 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->num_threads = debug_get_num_option("LP_NUM_THREADS", screen->num_threads);
    screen->num_threads = MIN2(screen->num_threads, LP_MAX_THREADS);
 
-   screen->rast = lp_rast_create(screen->num_threads);
+   /* Binning can only overlap with rasterization if there are rasterizer
+    * threads to do the latter.
+    */
+   screen->num_scenes = screen->num_threads ? 2 : 1;
+   screen->num_scenes = debug_get_num_option("LP_NUM_SCENES", screen->num_scenes);
+   screen->num_scenes = CLAMP(screen->num_scenes, 1, LP_MAX_SCENES);
+
+   screen->thread_affinity = lp_get_thread_affinity();
+
+   screen->tiled_textures = debug_get_bool_option("LP_TILED_TEXTURES", FALSE);
+
+   screen->rast = lp_rast_create(screen->num_threads,
+                                 screen->thread_affinity);
    if (!screen->rast) {
       lp_jit_screen_cleanup(screen);
       FREE(screen);
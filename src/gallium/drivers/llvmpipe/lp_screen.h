@@ -50,6 +50,13 @@ struct llvmpipe_screen
    struct sw_winsys *winsys;
 
    unsigned num_threads;
+   unsigned thread_affinity;  /**< enum lp_rast_affinity */
+
+   /* Max number of scenes each context may have in flight */
+   unsigned num_scenes;
+
+   /* Store sampler-only textures in tiles, see LP_RESOURCE_FLAG_TILED */
+   boolean tiled_textures;
 
    /* Increments whenever textures are modified.  Contexts can track this.
     */
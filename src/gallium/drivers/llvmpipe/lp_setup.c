@@ -52,6 +52,7 @@
 #include "lp_setup_context.h"
 #include "lp_screen.h"
 #include "lp_state.h"
+#include "lp_state_cs.h"
 #include "state_tracker/sw_winsys.h"
 
 #include "draw/draw_context.h"
@@ -63,26 +64,57 @@ static boolean set_scene_state( struct lp_setup_context *, enum setup_state,
 static boolean try_update_scene_state( struct lp_setup_context *setup );
 
 
-static void
-lp_setup_get_empty_scene(struct lp_setup_context *setup)
+/**
+ * Get the next scene of the ring.
+ *
+ * Scenes are recycled in the order they were queued, so the scene we get
+ * is the oldest one, which the rasterizer is most likely done with.  If it
+ * is still being rasterized we have to wait on its fence.  Only then can
+ * the references and data it holds be released.
+ */
+static struct lp_scene *
+lp_setup_recycle_scene(struct lp_setup_context *setup)
 {
-   assert(setup->scene == NULL);
+   struct lp_scene *scene;
 
    setup->scene_idx++;
-   setup->scene_idx %= Elements(setup->scenes);
+   setup->scene_idx %= setup->num_scenes;
+
+   if (!setup->scenes[setup->scene_idx]) {
+      setup->scenes[setup->scene_idx] = lp_scene_create( setup->pipe );
+      if (!setup->scenes[setup->scene_idx]) {
+         /* Make do with the scenes we already have. */
+         setup->num_scenes = setup->scene_idx;
+         setup->scene_idx = 0;
+      }
+   }
 
-   setup->scene = setup->scenes[setup->scene_idx];
+   scene = setup->scenes[setup->scene_idx];
 
-   if (setup->scene->fence) {
+   if (scene->fence) {
       if (LP_DEBUG & DEBUG_SETUP)
          debug_printf("%s: wait for scene %d\n",
-                      __FUNCTION__, setup->scene->fence->id);
+                      __FUNCTION__, scene->fence->id);
 
-      lp_fence_wait(setup->scene->fence);
+      lp_fence_wait(scene->fence);
+      lp_scene_end_rasterization(scene);
    }
 
-   lp_scene_begin_binning(setup->scene, &setup->fb, setup->rasterizer_discard);
+   return scene;
+}
+
 
+/**
+ * Get a scene to bin the current framebuffer's rendering into.
+ */
+static void
+lp_setup_get_empty_scene(struct lp_setup_context *setup)
+{
+   assert(setup->scene == NULL);
+
+   setup->scene = lp_setup_recycle_scene(setup);
+
+   lp_scene_begin_binning(setup->scene, &setup->fb, setup->rasterizer_discard);
 }
 
 
@@ -146,6 +178,29 @@ void lp_setup_reset( struct lp_setup_context *setup )
 }
 
 
+/**
+ * Release the references and data of the scenes the rasterizer is done
+ * with, rather than keeping them until the scenes are reused.  The
+ * rasterizer has already unmapped their framebuffers.
+ */
+static void
+lp_setup_release_finished_scenes(struct lp_setup_context *setup)
+{
+   unsigned i;
+
+   for (i = 0; i < setup->num_scenes; i++) {
+      struct lp_scene *scene = setup->scenes[i];
+
+      if (scene && scene != setup->scene &&
+          scene->fence && lp_fence_signalled(scene->fence)) {
+         /* doesn't block, but orders us after the rasterizer's writes */
+         lp_fence_wait(scene->fence);
+         lp_scene_end_rasterization(scene);
+      }
+   }
+}
+
+
 /** Rasterize all scene's bins */
 static void
 lp_setup_rasterize_scene( struct lp_setup_context *setup )
@@ -164,25 +219,20 @@ lp_setup_rasterize_scene( struct lp_setup_context *setup )
    if (setup->last_fence)
       setup->last_fence->issued = TRUE;
 
-   pipe_mutex_lock(screen->rast_mutex);
-
-   /* FIXME: We enqueue the scene then wait on the rasterizer to finish.
-    * This means we never actually run any vertex stuff in parallel to
-    * rasterization (not in the same context at least) which is what the
-    * multiple scenes per setup is about - when we get a new empty scene
-    * any old one is already empty again because we waited here for
-    * raster tasks to be finished. Ideally, we shouldn't need to wait here
-    * and rely on fences elsewhere when waiting is necessary.
-    * Certainly, lp_scene_end_rasterization() would need to be deferred too
-    * and there's probably other bits why this doesn't actually work.
+   /* Don't wait for the rasterizer here: the scene keeps its resource
+    * references and data until it is found finished by a later call, or
+    * lp_setup_get_empty_scene() recycles it, so we can start binning the
+    * next scene right away.  Anything which needs the results waits on the
+    * scene's fence.
     */
+   pipe_mutex_lock(screen->rast_mutex);
    lp_rast_queue_scene(screen->rast, scene);
-   lp_rast_finish(screen->rast);
    pipe_mutex_unlock(screen->rast_mutex);
 
-   lp_scene_end_rasterization(setup->scene);
    lp_setup_reset( setup );
 
+   lp_setup_release_finished_scenes(setup);
+
    LP_DBG(DEBUG_SETUP, "%s done \n", __FUNCTION__);
 }
 
@@ -964,7 +1014,7 @@ unsigned
 lp_setup_is_resource_referenced( const struct lp_setup_context *setup,
                                 const struct pipe_resource *texture )
 {
-   unsigned i;
+   unsigned i, j;
 
    /* check the render targets */
    for (i = 0; i < setup->fb.nr_cbufs; i++) {
@@ -975,10 +1025,27 @@ lp_setup_is_resource_referenced( const struct lp_setup_context *setup,
       return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
    }
 
-   /* check textures referenced by the scene */
-   for (i = 0; i < Elements(setup->scenes); i++) {
-      if (lp_scene_is_resource_referenced(setup->scenes[i], texture)) {
-         return LP_REFERENCED_FOR_READ;
+   /* check the scenes which are being binned or rasterized */
+   for (i = 0; i < setup->num_scenes; i++) {
+      const struct lp_scene *scene = setup->scenes[i];
+
+      if (!scene || !scene->fence || lp_fence_signalled(scene->fence))
+         continue;
+
+      /* a queued scene may render to a since-unbound framebuffer */
+      for (j = 0; j < scene->fb.nr_cbufs; j++) {
+         if (scene->fb.cbufs[j] && scene->fb.cbufs[j]->texture == texture)
+            return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
+      }
+      if (scene->fb.zsbuf && scene->fb.zsbuf->texture == texture) {
+         return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
+      }
+
+      if (lp_scene_is_resource_referenced(scene, texture)) {
+         /* compute grids may write to any of their resources */
+         return scene->cs_job ?
+            LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE :
+            LP_REFERENCED_FOR_READ;
       }
    }
 
@@ -986,6 +1053,70 @@ lp_setup_is_resource_referenced( const struct lp_setup_context *setup,
 }
 
 
+/**
+ * Queue a compute grid.
+ *
+ * The grid gets a scene of its own, so it runs on the rasterizer threads
+ * after all the rendering queued so far, and the resources it uses stay
+ * referenced until it is done.  The job (and its input data) is copied.
+ */
+boolean
+lp_setup_launch_grid(struct lp_setup_context *setup,
+                     const struct lp_cs_job *job,
+                     struct pipe_resource **resources,
+                     unsigned num_resources)
+{
+   struct pipe_framebuffer_state no_fb;
+   struct lp_scene *scene;
+   struct lp_cs_job *scene_job;
+   unsigned i;
+
+   LP_DBG(DEBUG_SETUP, "%s\n", __FUNCTION__);
+
+   set_scene_state( setup, SETUP_FLUSHED, __FUNCTION__ );
+
+   assert(setup->scene == NULL);
+   scene = setup->scene = lp_setup_recycle_scene(setup);
+
+   memset(&no_fb, 0, sizeof no_fb);
+   lp_scene_begin_binning(scene, &no_fb, FALSE);
+
+   scene->fence = lp_fence_create(MAX2(1, setup->num_threads));
+   if (!scene->fence)
+      goto fail;
+
+   scene_job = lp_scene_alloc(scene, sizeof *scene_job);
+   if (!scene_job)
+      goto fail;
+
+   *scene_job = *job;
+
+   if (job->jit_context.input_size) {
+      void *input = lp_scene_alloc(scene, job->jit_context.input_size);
+      if (!input)
+         goto fail;
+      memcpy(input, job->jit_context.input, job->jit_context.input_size);
+      scene_job->jit_context.input = input;
+   }
+
+   for (i = 0; i < num_resources; i++) {
+      if (resources[i] &&
+          !lp_scene_add_resource_reference(scene, resources[i], TRUE))
+         goto fail;
+   }
+
+   scene->cs_job = scene_job;
+
+   lp_setup_rasterize_scene( setup );
+   return TRUE;
+
+fail:
+   lp_scene_end_rasterization(scene);
+   lp_setup_reset( setup );
+   return FALSE;
+}
+
+
 /**
  * Called by vbuf code when we're about to draw something.
  *
@@ -1277,12 +1408,17 @@ lp_setup_destroy( struct lp_setup_context *setup )
       pipe_resource_reference(&setup->constants[i].current.buffer, NULL);
    }
 
-   /* free the scenes in the 'empty' queue */
-   for (i = 0; i < Elements(setup->scenes); i++) {
+   /* wait for the scenes in flight and free all of them */
+   for (i = 0; i < setup->num_scenes; i++) {
       struct lp_scene *scene = setup->scenes[i];
 
-      if (scene->fence)
+      if (!scene)
+         continue;
+
+      if (scene->fence) {
          lp_fence_wait(scene->fence);
+         lp_scene_end_rasterization(scene);
+      }
 
       lp_scene_destroy(scene);
    }
@@ -1304,7 +1440,6 @@ lp_setup_create( struct pipe_context *pipe,
 {
    struct llvmpipe_screen *screen = llvmpipe_screen(pipe->screen);
    struct lp_setup_context *setup;
-   unsigned i;
 
    setup = CALLOC_STRUCT(lp_setup_context);
    if (!setup) {
@@ -1313,12 +1448,13 @@ lp_setup_create( struct pipe_context *pipe,
 
    lp_setup_init_vbuf(setup);
    
-   /* Used only in update_state():
+   /* Used in update_state() and for creating scenes:
     */
    setup->pipe = pipe;
 
 
    setup->num_threads = screen->num_threads;
+   setup->num_scenes = screen->num_scenes;
    setup->vbuf = draw_vbuf_stage(draw, &setup->base);
    if (!setup->vbuf) {
       goto no_vbuf;
@@ -1327,12 +1463,12 @@ lp_setup_create( struct pipe_context *pipe,
    draw_set_rasterize_stage(draw, setup->vbuf);
    draw_set_render(draw, &setup->base);
 
-   /* create some empty scenes */
-   for (i = 0; i < MAX_SCENES; i++) {
-      setup->scenes[i] = lp_scene_create( pipe );
-      if (!setup->scenes[i]) {
-         goto no_scenes;
-      }
+   /* Create the first empty scene.  The others are created on demand by
+    * lp_setup_get_empty_scene().
+    */
+   setup->scenes[0] = lp_scene_create( pipe );
+   if (!setup->scenes[0]) {
+      goto no_scenes;
    }
 
    setup->triangle = first_triangle;
@@ -1344,12 +1480,6 @@ lp_setup_create( struct pipe_context *pipe,
    return setup;
 
 no_scenes:
-   for (i = 0; i < MAX_SCENES; i++) {
-      if (setup->scenes[i]) {
-         lp_scene_destroy(setup->scenes[i]);
-      }
-   }
-
    setup->vbuf->destroy(setup->vbuf);
 no_vbuf:
    FREE(setup);
@@ -46,6 +46,7 @@ struct llvmpipe_query;
 struct pipe_fence_handle;
 struct lp_setup_variant;
 struct lp_setup_context;
+struct lp_cs_job;
 
 void lp_setup_reset( struct lp_setup_context *setup );
 
@@ -159,6 +160,12 @@ void
 lp_setup_end_query(struct lp_setup_context *setup,
                    struct llvmpipe_query *pq);
 
+boolean
+lp_setup_launch_grid(struct lp_setup_context *setup,
+                     const struct lp_cs_job *job,
+                     struct pipe_resource **resources,
+                     unsigned num_resources);
+
 static INLINE unsigned
 lp_clamp_viewport_idx(int idx)
 {
@@ -0,0 +1,801 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Compute shaders.
+ *
+ * Each invocation of a block is a lane of a SoA vector, so a block is run
+ * as a sequence of calls of the JIT function, each covering vector_length
+ * consecutive (linear) thread ids.  The blocks of a grid are spread over
+ * the rasterizer threads, which fetch them from a shared counter.
+ *
+ * BARRIER makes the JIT function return.  Once all the calls of a block
+ * got there they are called again, to resume after the barrier, with the
+ * registers the shader needs kept in per-call state memory.
+ */
+
+#include "pipe/p_defines.h"
+#include "pipe/p_shader_tokens.h"
+#include "util/u_atomic.h"
+#include "util/u_format.h"
+#include "util/u_inlines.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "util/u_string.h"
+#include "tgsi/tgsi_dump.h"
+#include "tgsi/tgsi_parse.h"
+#include "gallivm/lp_bld_arit.h"
+#include "gallivm/lp_bld_const.h"
+#include "gallivm/lp_bld_debug.h"
+#include "gallivm/lp_bld_flow.h"
+#include "gallivm/lp_bld_init.h"
+#include "gallivm/lp_bld_logic.h"
+#include "gallivm/lp_bld_struct.h"
+#include "gallivm/lp_bld_tgsi.h"
+#include "gallivm/lp_bld_type.h"
+
+#include "lp_context.h"
+#include "lp_debug.h"
+#include "lp_flush.h"
+#include "lp_limits.h"
+#include "lp_setup.h"
+#include "lp_state.h"
+#include "lp_state_cs.h"
+#include "lp_texture.h"
+
+
+/** Compute shader number (for debugging) */
+static unsigned cs_no = 0;
+
+
+/**
+ * Our lp_build_tgsi_cs_iface, with what the memory accesses need.
+ */
+struct lp_cs_iface
+{
+   struct lp_build_tgsi_cs_iface base;
+
+   LLVMValueRef context_ptr;
+   LLVMValueRef local_mem;
+
+   /** Targets of masked or out of bounds loads and stores */
+   LLVMValueRef load_dummy;
+   LLVMValueRef store_dummy;
+};
+
+
+/**
+ * Get the base address and size, in bytes, of a memory resource.
+ * Resources we don't support, or can't write to, get a zero size.
+ */
+static void
+cs_get_resource(const struct lp_cs_iface *iface,
+                struct gallivm_state *gallivm,
+                unsigned resource,
+                boolean write,
+                LLVMValueRef *base,
+                LLVMValueRef *size)
+{
+   LLVMValueRef index;
+
+   switch (resource) {
+   case TGSI_RESOURCE_LOCAL:
+      *base = iface->local_mem;
+      *size = lp_jit_cs_context_local_size(gallivm, iface->context_ptr);
+      return;
+
+   case TGSI_RESOURCE_INPUT:
+      if (!write) {
+         *base = lp_jit_cs_context_input(gallivm, iface->context_ptr);
+         *size = lp_jit_cs_context_input_size(gallivm, iface->context_ptr);
+         return;
+      }
+      break;
+
+   default:
+      if (resource < PIPE_MAX_SHADER_RESOURCES) {
+         index = lp_build_const_int32(gallivm, resource);
+         *base = lp_build_array_get(gallivm,
+                    lp_jit_cs_context_resources(gallivm, iface->context_ptr),
+                    index);
+         *size = lp_build_array_get(gallivm,
+                    lp_jit_cs_context_resource_sizes(gallivm, iface->context_ptr),
+                    index);
+         return;
+      }
+      /* RGLOBAL and RPRIVATE are not supported */
+      break;
+   }
+
+   *base = LLVMConstNull(LLVMPointerType(LLVMInt8TypeInContext(gallivm->context), 0));
+   *size = lp_build_const_int32(gallivm, 0);
+}
+
+
+/**
+ * Mask of the lanes whose dword at offset is active and within size.
+ */
+static LLVMValueRef
+cs_lane_mask(struct lp_build_context *uint_bld,
+             LLVMValueRef offset,
+             LLVMValueRef size,
+             LLVMValueRef exec_mask)
+{
+   LLVMBuilderRef builder = uint_bld->gallivm->builder;
+   LLVMValueRef four = lp_build_const_int_vec(uint_bld->gallivm,
+                                              uint_bld->type, 4);
+   LLVMValueRef mask;
+
+   size = lp_build_broadcast_scalar(uint_bld, size);
+
+   /* offset + 4 <= size, without overflowing */
+   mask = lp_build_cmp(uint_bld, PIPE_FUNC_LESS, offset, size);
+   mask = LLVMBuildAnd(builder, mask,
+                       lp_build_cmp(uint_bld, PIPE_FUNC_GEQUAL,
+                                    LLVMBuildSub(builder, size, offset, ""),
+                                    four), "");
+
+   return LLVMBuildAnd(builder, mask, exec_mask, "");
+}
+
+
+/**
+ * Get the address of the given lane's dword, or of the dummy if the lane
+ * is masked out.
+ */
+static LLVMValueRef
+cs_lane_ptr(struct gallivm_state *gallivm,
+            LLVMValueRef base,
+            LLVMValueRef offset,
+            LLVMValueRef mask,
+            LLVMValueRef dummy,
+            unsigned lane)
+{
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMValueRef index = lp_build_const_int32(gallivm, lane);
+   LLVMValueRef lane_offset, lane_mask, ptr;
+
+   lane_offset = LLVMBuildExtractElement(builder, offset, index, "");
+   lane_mask = LLVMBuildExtractElement(builder, mask, index, "");
+   lane_mask = LLVMBuildICmp(builder, LLVMIntNE, lane_mask,
+                             lp_build_const_int32(gallivm, 0), "");
+
+   ptr = LLVMBuildGEP(builder, base, &lane_offset, 1, "");
+   ptr = LLVMBuildBitCast(builder, ptr, LLVMTypeOf(dummy), "");
+
+   return LLVMBuildSelect(builder, lane_mask, ptr, dummy, "");
+}
+
+
+static void
+cs_emit_load(const struct lp_build_tgsi_cs_iface *cs_iface,
+             struct lp_build_tgsi_context *bld_base,
+             unsigned resource,
+             LLVMValueRef offset,
+             LLVMValueRef exec_mask,
+             unsigned writemask,
+             LLVMValueRef result[4])
+{
+   const struct lp_cs_iface *iface = (const struct lp_cs_iface *)cs_iface;
+   struct gallivm_state *gallivm = bld_base->base.gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   struct lp_build_context *uint_bld = &bld_base->uint_bld;
+   LLVMValueRef base, size;
+   unsigned chan, i;
+
+   cs_get_resource(iface, gallivm, resource, FALSE, &base, &size);
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      LLVMValueRef chan_offset, mask, res;
+
+      if (!(writemask & (1 << chan)))
+         continue;
+
+      chan_offset = lp_build_add(uint_bld, offset,
+                                 lp_build_const_int_vec(gallivm,
+                                                        uint_bld->type,
+                                                        chan * 4));
+      mask = cs_lane_mask(uint_bld, chan_offset, size, exec_mask);
+
+      res = uint_bld->undef;
+      for (i = 0; i < uint_bld->type.length; i++) {
+         LLVMValueRef ptr = cs_lane_ptr(gallivm, base, chan_offset, mask,
+                                        iface->load_dummy, i);
+         res = LLVMBuildInsertElement(builder, res,
+                                      LLVMBuildLoad(builder, ptr, ""),
+                                      lp_build_const_int32(gallivm, i), "");
+      }
+
+      result[chan] = LLVMBuildBitCast(builder, res, bld_base->base.vec_type, "");
+   }
+}
+
+
+static void
+cs_emit_store(const struct lp_build_tgsi_cs_iface *cs_iface,
+              struct lp_build_tgsi_context *bld_base,
+              unsigned resource,
+              LLVMValueRef offset,
+              LLVMValueRef exec_mask,
+              unsigned writemask,
+              LLVMValueRef values[4])
+{
+   const struct lp_cs_iface *iface = (const struct lp_cs_iface *)cs_iface;
+   struct gallivm_state *gallivm = bld_base->base.gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   struct lp_build_context *uint_bld = &bld_base->uint_bld;
+   LLVMValueRef base, size;
+   unsigned chan, i;
+
+   cs_get_resource(iface, gallivm, resource, TRUE, &base, &size);
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      LLVMValueRef chan_offset, mask, value;
+
+      if (!(writemask & (1 << chan)))
+         continue;
+
+      chan_offset = lp_build_add(uint_bld, offset,
+                                 lp_build_const_int_vec(gallivm,
+                                                        uint_bld->type,
+                                                        chan * 4));
+      mask = cs_lane_mask(uint_bld, chan_offset, size, exec_mask);
+      value = LLVMBuildBitCast(builder, values[chan], uint_bld->vec_type, "");
+
+      for (i = 0; i < uint_bld->type.length; i++) {
+         LLVMValueRef ptr = cs_lane_ptr(gallivm, base, chan_offset, mask,
+                                        iface->store_dummy, i);
+         LLVMBuildStore(builder,
+                        LLVMBuildExtractElement(builder, value,
+                                                lp_build_const_int32(gallivm, i),
+                                                ""),
+                        ptr);
+      }
+   }
+}
+
+
+/**
+ * Generate the compute shader function.
+ * Any change here must be reflected in lp_jit.h's lp_jit_cs_func.
+ */
+static void
+generate_compute(struct llvmpipe_context *lp,
+                 struct lp_compute_shader *shader,
+                 struct lp_compute_shader_variant *variant)
+{
+   struct gallivm_state *gallivm = variant->gallivm;
+   LLVMContextRef lc = gallivm->context;
+   LLVMTypeRef int32_type = LLVMInt32TypeInContext(lc);
+   LLVMTypeRef int8_ptr_type = LLVMPointerType(LLVMInt8TypeInContext(lc), 0);
+   LLVMTypeRef arg_types[8];
+   LLVMTypeRef func_type;
+   LLVMValueRef function, context_ptr, first_thread, local_mem, state_ptr;
+   LLVMValueRef phase, block_size_ptr, grid_size_ptr;
+   LLVMValueRef thread_index, num_threads, tmp, mask_val;
+   LLVMValueRef lanes[LP_MAX_VECTOR_LENGTH];
+   LLVMBasicBlockRef block;
+   LLVMBuilderRef builder;
+   struct lp_type cs_type;
+   struct lp_build_context uint_bld;
+   struct lp_build_mask_context mask;
+   struct lp_bld_tgsi_system_values system_values;
+   struct lp_cs_iface iface;
+   char func_name[64];
+   unsigned i;
+
+   memset(&cs_type, 0, sizeof cs_type);
+   cs_type.floating = TRUE;      /* floating point values */
+   cs_type.sign = TRUE;          /* values are signed */
+   cs_type.norm = FALSE;         /* values are not limited to [0,1] or [-1,1] */
+   cs_type.width = 32;           /* 32-bit float */
+   cs_type.length = shader->vector_length;
+
+   lp_build_context_init(&uint_bld, gallivm, lp_uint_type(cs_type));
+
+   util_snprintf(func_name, sizeof(func_name), "cs%u_variant%u",
+                 shader->no, variant->no);
+
+   arg_types[0] = variant->jit_context_ptr_type;       /* context */
+   arg_types[1] = int32_type;                          /* block_x */
+   arg_types[2] = int32_type;                          /* block_y */
+   arg_types[3] = int32_type;                          /* block_z */
+   arg_types[4] = int32_type;                          /* first_thread */
+   arg_types[5] = int8_ptr_type;                       /* local_mem */
+   arg_types[6] = int8_ptr_type;                       /* state */
+   arg_types[7] = int32_type;                          /* phase */
+
+   func_type = LLVMFunctionType(int32_type, arg_types, Elements(arg_types), 0);
+
+   function = LLVMAddFunction(gallivm->module, func_name, func_type);
+   LLVMSetFunctionCallConv(function, LLVMCCallConv);
+
+   variant->function = function;
+
+   for (i = 0; i < Elements(arg_types); ++i)
+      if (LLVMGetTypeKind(arg_types[i]) == LLVMPointerTypeKind)
+         LLVMAddAttribute(LLVMGetParam(function, i), LLVMNoAliasAttribute);
+
+   context_ptr  = LLVMGetParam(function, 0);
+   first_thread = LLVMGetParam(function, 4);
+   local_mem    = LLVMGetParam(function, 5);
+   state_ptr    = LLVMGetParam(function, 6);
+   phase        = LLVMGetParam(function, 7);
+
+   lp_build_name(context_ptr, "context");
+   lp_build_name(LLVMGetParam(function, 1), "block_x");
+   lp_build_name(LLVMGetParam(function, 2), "block_y");
+   lp_build_name(LLVMGetParam(function, 3), "block_z");
+   lp_build_name(first_thread, "first_thread");
+   lp_build_name(local_mem, "local_mem");
+   lp_build_name(state_ptr, "state");
+   lp_build_name(phase, "phase");
+
+   /*
+    * Function body
+    */
+
+   block = LLVMAppendBasicBlockInContext(gallivm->context, function, "entry");
+   builder = gallivm->builder;
+   assert(builder);
+   LLVMPositionBuilderAtEnd(builder, block);
+
+   memset(&system_values, 0, sizeof system_values);
+
+   block_size_ptr = lp_jit_cs_context_block_size(gallivm, context_ptr);
+   grid_size_ptr = lp_jit_cs_context_grid_size(gallivm, context_ptr);
+   for (i = 0; i < 3; i++) {
+      LLVMValueRef index = lp_build_const_int32(gallivm, i);
+      system_values.block_id[i] = LLVMGetParam(function, 1 + i);
+      system_values.block_size[i] =
+         lp_build_array_get(gallivm, block_size_ptr, index);
+      system_values.grid_size[i] =
+         lp_build_array_get(gallivm, grid_size_ptr, index);
+   }
+
+   /* linear thread ids of the lanes, split into x, y, z */
+   for (i = 0; i < cs_type.length; i++)
+      lanes[i] = lp_build_const_int32(gallivm, i);
+   thread_index = lp_build_broadcast_scalar(&uint_bld, first_thread);
+   thread_index = LLVMBuildAdd(builder, thread_index,
+                               LLVMConstVector(lanes, cs_type.length), "");
+
+   tmp = lp_build_broadcast_scalar(&uint_bld, system_values.block_size[0]);
+   system_values.thread_id[0] = LLVMBuildURem(builder, thread_index, tmp, "");
+   tmp = LLVMBuildUDiv(builder, thread_index, tmp, "");
+   system_values.thread_id[1] =
+      LLVMBuildURem(builder, tmp,
+                    lp_build_broadcast_scalar(&uint_bld,
+                                              system_values.block_size[1]), "");
+   system_values.thread_id[2] =
+      LLVMBuildUDiv(builder, tmp,
+                    lp_build_broadcast_scalar(&uint_bld,
+                                              system_values.block_size[1]), "");
+
+   /* the last call of a block may have lanes past the block's end */
+   num_threads = LLVMBuildMul(builder, system_values.block_size[0],
+                              system_values.block_size[1], "");
+   num_threads = LLVMBuildMul(builder, num_threads,
+                              system_values.block_size[2], "");
+   mask_val = lp_build_cmp(&uint_bld, PIPE_FUNC_LESS, thread_index,
+                           lp_build_broadcast_scalar(&uint_bld, num_threads));
+
+   lp_build_mask_begin(&mask, gallivm, cs_type, mask_val);
+
+   memset(&iface, 0, sizeof iface);
+   iface.base.emit_load = cs_emit_load;
+   iface.base.emit_store = cs_emit_store;
+   iface.base.phase = phase;
+   iface.base.state_ptr = state_ptr;
+   iface.base.entry_pc = variant->pc;
+   iface.context_ptr = context_ptr;
+   iface.local_mem = local_mem;
+   iface.load_dummy = lp_build_alloca(gallivm, int32_type, "load_dummy");
+   iface.store_dummy = lp_build_alloca(gallivm, int32_type, "store_dummy");
+
+   lp_build_tgsi_soa(gallivm, shader->base.prog, cs_type, &mask,
+                     NULL, NULL, &system_values,
+                     NULL, NULL, context_ptr,
+                     NULL, &shader->info, NULL, &iface.base);
+
+   lp_build_mask_end(&mask);
+
+   LLVMBuildRet(builder, lp_build_const_int32(gallivm, 0));
+
+   gallivm_verify_function(gallivm, function);
+}
+
+
+static struct lp_compute_shader_variant *
+generate_variant(struct llvmpipe_context *lp,
+                 struct lp_compute_shader *shader,
+                 unsigned pc)
+{
+   struct lp_compute_shader_variant *variant;
+   char module_name[64];
+
+   variant = CALLOC_STRUCT(lp_compute_shader_variant);
+   if (!variant)
+      return NULL;
+
+   util_snprintf(module_name, sizeof(module_name), "cs%u_variant%u",
+                 shader->no, shader->variants_created);
+
+   variant->gallivm = gallivm_create(module_name, lp->context);
+   if (!variant->gallivm) {
+      FREE(variant);
+      return NULL;
+   }
+
+   {
+      const struct tgsi_token *tokens = shader->base.prog;
+      const unsigned mem[3] = {
+         shader->base.req_local_mem,
+         shader->base.req_private_mem,
+         shader->base.req_input_mem
+      };
+
+      gallivm_add_cache_key(variant->gallivm, tokens,
+                            tgsi_num_tokens(tokens) * sizeof *tokens);
+      gallivm_add_cache_key(variant->gallivm, mem, sizeof mem);
+      gallivm_add_cache_key(variant->gallivm, &pc, sizeof pc);
+   }
+
+   variant->shader = shader;
+   variant->pc = pc;
+   variant->no = shader->variants_created++;
+
+   lp_jit_init_cs_types(variant);
+
+   generate_compute(lp, shader, variant);
+
+   gallivm_compile_module(variant->gallivm);
+
+   variant->jit_function = (lp_jit_cs_func)
+      gallivm_jit_function(variant->gallivm, variant->function);
+
+   gallivm_free_ir(variant->gallivm);
+
+   return variant;
+}
+
+
+/**
+ * Get the variant of the shader starting at the given instruction.
+ */
+static struct lp_compute_shader_variant *
+get_variant(struct llvmpipe_context *lp,
+            struct lp_compute_shader *shader,
+            unsigned pc)
+{
+   struct lp_compute_shader_variant *variant;
+
+   for (variant = shader->variants; variant; variant = variant->next) {
+      if (variant->pc == pc)
+         return variant;
+   }
+
+   variant = generate_variant(lp, shader, pc);
+   if (variant) {
+      variant->next = shader->variants;
+      shader->variants = variant;
+   }
+
+   return variant;
+}
+
+
+static void *
+llvmpipe_create_compute_state(struct pipe_context *pipe,
+                              const struct pipe_compute_state *templ)
+{
+   const struct tgsi_token *tokens = templ->prog;
+   struct lp_compute_shader *shader;
+   unsigned state_length;
+
+   if (LP_DEBUG & DEBUG_TGSI) {
+      debug_printf("llvmpipe: Create compute shader:\n");
+      tgsi_dump(tokens, 0);
+   }
+
+   if (templ->req_local_mem > LP_MAX_CS_LOCAL_SIZE ||
+       templ->req_input_mem > LP_MAX_CS_INPUT_SIZE) {
+      debug_printf("llvmpipe: compute shader needs too much memory\n");
+      return NULL;
+   }
+
+   shader = CALLOC_STRUCT(lp_compute_shader);
+   if (!shader)
+      return NULL;
+
+   shader->no = cs_no++;
+   shader->base = *templ;
+
+   tgsi_scan_shader(tokens, &shader->info);
+
+   if (shader->info.file_max[TGSI_FILE_CONSTANT] >= 0 ||
+       shader->info.file_max[TGSI_FILE_SAMPLER] >= 0 ||
+       shader->info.file_max[TGSI_FILE_SAMPLER_VIEW] >= 0) {
+      debug_printf("llvmpipe: compute shaders can only access memory "
+                   "resources\n");
+      FREE(shader);
+      return NULL;
+   }
+
+   /* GLSL only allows barrier() outside of flow control in main(), which
+    * is all the code generator can split the shader at.
+    */
+   if (lp_build_tgsi_has_divergent_barrier(tokens)) {
+      debug_printf("llvmpipe: BARRIER within flow control is not "
+                   "supported\n");
+      FREE(shader);
+      return NULL;
+   }
+
+   /* we need to keep a local copy of the tokens */
+   shader->base.prog = tgsi_dup_tokens(tokens);
+   if (!shader->base.prog) {
+      FREE(shader);
+      return NULL;
+   }
+
+   shader->vector_length = MIN2(lp_native_vector_width / 32, 16);
+
+   state_length = lp_build_tgsi_cs_state_length(&shader->info);
+   shader->state_size = state_length * shader->vector_length * 4;
+
+   return shader;
+}
+
+
+static void
+llvmpipe_bind_compute_state(struct pipe_context *pipe, void *cs)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+
+   llvmpipe->cs = (struct lp_compute_shader *)cs;
+}
+
+
+static void
+llvmpipe_delete_compute_state(struct pipe_context *pipe, void *cs)
+{
+   struct lp_compute_shader *shader = cs;
+   struct lp_compute_shader_variant *variant, *next;
+
+   if (!shader)
+      return;
+
+   /* The shader's variants may still be used by queued grids. */
+   llvmpipe_finish(pipe, __FUNCTION__);
+
+   for (variant = shader->variants; variant; variant = next) {
+      next = variant->next;
+      gallivm_destroy(variant->gallivm);
+      FREE(variant);
+   }
+
+   FREE((void *) shader->base.prog);
+   FREE(shader);
+}
+
+
+static void
+llvmpipe_set_compute_resources(struct pipe_context *pipe,
+                               unsigned start, unsigned count,
+                               struct pipe_surface **resources)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+   unsigned i;
+
+   assert(start + count <= PIPE_MAX_SHADER_RESOURCES);
+
+   for (i = 0; i < count; i++) {
+      pipe_surface_reference(&llvmpipe->cs_resources[start + i],
+                             resources ? resources[i] : NULL);
+   }
+}
+
+
+static void
+llvmpipe_launch_grid(struct pipe_context *pipe,
+                     const uint *block_layout, const uint *grid_layout,
+                     uint32_t pc, const void *input)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+   struct lp_compute_shader *shader = llvmpipe->cs;
+   struct pipe_resource *resources[PIPE_MAX_SHADER_RESOURCES];
+   struct lp_cs_job job;
+   unsigned num_threads;
+   unsigned i;
+
+   if (!shader)
+      return;
+
+   num_threads = block_layout[0] * block_layout[1] * block_layout[2];
+   if (num_threads > LP_MAX_CS_BLOCK_SIZE) {
+      debug_printf("llvmpipe: block size %ux%ux%u too large\n",
+                   block_layout[0], block_layout[1], block_layout[2]);
+      return;
+   }
+
+   memset(&job, 0, sizeof job);
+
+   job.num_blocks = grid_layout[0] * grid_layout[1] * grid_layout[2];
+   if (!job.num_blocks || !num_threads)
+      return;
+
+   job.variant = get_variant(llvmpipe, shader, pc);
+   if (!job.variant)
+      return;
+
+   for (i = 0; i < PIPE_MAX_SHADER_RESOURCES; i++) {
+      struct pipe_surface *surf = llvmpipe->cs_resources[i];
+      unsigned blocksize;
+
+      resources[i] = NULL;
+      if (!surf)
+         continue;
+
+      if (llvmpipe_resource_is_texture(surf->texture)) {
+         debug_printf("llvmpipe: only buffer compute resources are "
+                      "supported\n");
+         continue;
+      }
+
+      blocksize = util_format_get_blocksize(surf->format);
+      job.jit_context.resources[i] =
+         (uint8_t *)llvmpipe_resource_data(surf->texture) +
+         surf->u.buf.first_element * blocksize;
+      job.jit_context.resource_sizes[i] =
+         (surf->u.buf.last_element - surf->u.buf.first_element + 1) *
+         blocksize;
+      resources[i] = surf->texture;
+   }
+
+   job.jit_context.input = input;
+   job.jit_context.input_size = input ? shader->base.req_input_mem : 0;
+   job.jit_context.local_size = shader->base.req_local_mem;
+
+   for (i = 0; i < 3; i++) {
+      job.jit_context.block_size[i] = block_layout[i];
+      job.jit_context.grid_size[i] = grid_layout[i];
+   }
+
+   if (!lp_setup_launch_grid(llvmpipe->setup, &job,
+                             resources, PIPE_MAX_SHADER_RESOURCES)) {
+      debug_printf("llvmpipe: failed to launch grid\n");
+   }
+}
+
+
+/**
+ * Make sure the thread has enough memory for running the job's blocks.
+ */
+static boolean
+reserve_thread_data(struct lp_cs_thread_data *thread_data,
+                    unsigned local_mem_size,
+                    unsigned state_size)
+{
+   if (thread_data->local_mem_size < local_mem_size) {
+      align_free(thread_data->local_mem);
+      thread_data->local_mem = align_malloc(local_mem_size, 64);
+      thread_data->local_mem_size = thread_data->local_mem ?
+                                    local_mem_size : 0;
+      if (!thread_data->local_mem)
+         return FALSE;
+   }
+
+   if (thread_data->state_size < state_size) {
+      align_free(thread_data->state);
+      thread_data->state = align_malloc(state_size, 64);
+      thread_data->state_size = thread_data->state ? state_size : 0;
+      if (!thread_data->state)
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+
+/**
+ * Run blocks of the job until there are none left.
+ * Called by each rasterizer thread.
+ */
+void
+lp_cs_job_run(struct lp_cs_job *job,
+              struct lp_cs_thread_data *thread_data)
+{
+   const struct lp_compute_shader_variant *variant = job->variant;
+   const struct lp_compute_shader *shader = variant->shader;
+   const struct lp_jit_cs_context *context = &job->jit_context;
+   const unsigned *grid_size = context->grid_size;
+   const unsigned *block_size = context->block_size;
+   unsigned num_threads = block_size[0] * block_size[1] * block_size[2];
+   unsigned num_calls = align(num_threads, shader->vector_length) /
+                        shader->vector_length;
+
+   /* Memory is allocated by the thread using it, so that it is local to
+    * the thread's node.
+    */
+   if (!reserve_thread_data(thread_data, context->local_size,
+                            num_calls * shader->state_size))
+      return;
+
+   for (;;) {
+      unsigned block = p_atomic_inc_return(&job->next_block) - 1;
+      unsigned x, y, z, phase;
+
+      if (block >= job->num_blocks)
+         break;
+
+      x = block % grid_size[0];
+      y = block / grid_size[0] % grid_size[1];
+      z = block / grid_size[0] / grid_size[1];
+
+      phase = 0;
+      do {
+         unsigned next_phase = 0;
+         unsigned i;
+
+         /* all calls hit the same barrier, as barriers can't be inside
+          * flow control
+          */
+         for (i = 0; i < num_calls; i++) {
+            next_phase = variant->jit_function(context, x, y, z,
+                                               i * shader->vector_length,
+                                               thread_data->local_mem,
+                                               thread_data->state +
+                                               i * shader->state_size,
+                                               phase);
+         }
+         phase = next_phase;
+      } while (phase);
+   }
+}
+
+
+void
+lp_cs_thread_data_fini(struct lp_cs_thread_data *thread_data)
+{
+   align_free(thread_data->local_mem);
+   align_free(thread_data->state);
+   memset(thread_data, 0, sizeof *thread_data);
+}
+
+
+void
+llvmpipe_init_compute_funcs(struct llvmpipe_context *llvmpipe)
+{
+   llvmpipe->pipe.create_compute_state = llvmpipe_create_compute_state;
+   llvmpipe->pipe.bind_compute_state = llvmpipe_bind_compute_state;
+   llvmpipe->pipe.delete_compute_state = llvmpipe_delete_compute_state;
+   llvmpipe->pipe.set_compute_resources = llvmpipe_set_compute_resources;
+   llvmpipe->pipe.launch_grid = llvmpipe_launch_grid;
+}
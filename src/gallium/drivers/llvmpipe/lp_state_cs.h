@@ -0,0 +1,125 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+
+
+#ifndef LP_STATE_CS_H_
+#define LP_STATE_CS_H_
+
+
+#include "pipe/p_compiler.h"
+#include "pipe/p_state.h"
+#include "tgsi/tgsi_scan.h" /* for tgsi_shader_info */
+#include "gallivm/lp_bld.h"
+#include "lp_jit.h"
+
+
+struct llvmpipe_context;
+struct lp_compute_shader;
+
+
+/**
+ * A compute shader compiled for a given entry point.
+ */
+struct lp_compute_shader_variant
+{
+   struct lp_compute_shader *shader;
+
+   /** Instruction the invocations start at, see pipe_context::launch_grid */
+   unsigned pc;
+
+   struct gallivm_state *gallivm;
+
+   LLVMTypeRef jit_context_ptr_type;
+
+   LLVMValueRef function;
+   lp_jit_cs_func jit_function;
+
+   unsigned no;
+
+   struct lp_compute_shader_variant *next;
+};
+
+
+/** Subclass of pipe_compute_state */
+struct lp_compute_shader
+{
+   struct pipe_compute_state base;   /**< base.prog is our copy of the tokens */
+
+   struct tgsi_shader_info info;
+
+   /** Number of invocations run by each call of a variant's jit_function */
+   unsigned vector_length;
+
+   /** Bytes of barrier state needed by each call of a jit_function */
+   unsigned state_size;
+
+   struct lp_compute_shader_variant *variants;
+   unsigned variants_created;
+
+   unsigned no;
+};
+
+
+/**
+ * A grid launch, executed by the rasterizer threads.
+ */
+struct lp_cs_job
+{
+   const struct lp_compute_shader_variant *variant;
+
+   struct lp_jit_cs_context jit_context;
+
+   unsigned num_blocks;
+
+   /** Next block to run, incremented by all the threads */
+   int next_block;
+};
+
+
+/**
+ * Per-thread memory for running blocks.
+ */
+struct lp_cs_thread_data
+{
+   uint8_t *local_mem;
+   unsigned local_mem_size;
+
+   uint8_t *state;
+   unsigned state_size;
+};
+
+
+void
+lp_cs_job_run(struct lp_cs_job *job,
+              struct lp_cs_thread_data *thread_data);
+
+void
+lp_cs_thread_data_fini(struct lp_cs_thread_data *thread_data);
+
+
+#endif /* LP_STATE_CS_H_ */
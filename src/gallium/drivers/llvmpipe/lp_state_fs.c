@@ -422,7 +422,7 @@ generate_fs_loop(struct gallivm_state *gallivm,
                      consts_ptr, num_consts_ptr, &system_values,
                      interp->inputs,
                      outputs, context_ptr,
-                     sampler, &shader->info.base, NULL);
+                     sampler, &shader->info.base, NULL, NULL);
 
    /* Alpha test */
    if (key->alpha.enabled) {
@@ -2575,6 +2575,12 @@ generate_variant(struct llvmpipe_context *lp,
       return NULL;
    }
 
+   gallivm_add_cache_key(variant->gallivm, shader->base.tokens,
+                         tgsi_num_tokens(shader->base.tokens) *
+                         sizeof *shader->base.tokens);
+   gallivm_add_cache_key(variant->gallivm, key, shader->variant_key_size);
+   gallivm_add_cache_key(variant->gallivm, &LP_PERF, sizeof LP_PERF);
+
    variant->shader = shader;
    variant->list_item_global.base = variant;
    variant->list_item_local.base = variant;
@@ -38,6 +38,7 @@
 #include "lp_screen.h"
 #include "lp_state.h"
 #include "lp_debug.h"
+#include "lp_flush.h"
 #include "state_tracker/sw_winsys.h"
 
 
@@ -253,6 +254,11 @@ prepare_shader_sampling(
          unsigned first_level = 0;
          unsigned last_level = 0;
 
+         /* Scenes still in flight might be rendering to this texture.
+          */
+         llvmpipe_flush_resource(&lp->pipe, tex, 0, TRUE, TRUE, FALSE,
+                                 "vertex/geometry sampling");
+
          /* We're referencing the texture's internal data, so save a
           * reference to it.
           */
@@ -736,6 +736,8 @@ generate_setup_variant(struct lp_setup_variant_key *key,
       goto fail;
    }
 
+   gallivm_add_cache_key(gallivm, key, key->size);
+
    builder = gallivm->builder;
 
    if (LP_DEBUG & DEBUG_COUNTERS) {
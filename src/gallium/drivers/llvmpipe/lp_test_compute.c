@@ -0,0 +1,570 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Compute shader dispatch benchmark.
+ *
+ * Runs the same grid on screens with different numbers of rasterizer
+ * threads, and reports how many invocations per second each one gets
+ * through.  The kernel goes through a barrier, so that resuming blocks
+ * after barriers is measured and checked too.
+ *
+ * Also checks that a draw sees the vertices a grid queued just before
+ * it wrote.
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_defines.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_draw.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+#include "util/u_string.h"
+#include "os/os_time.h"
+#include "tgsi/tgsi_text.h"
+#include "state_tracker/sw_winsys.h"
+
+#include "lp_public.h"
+#include "lp_test.h"
+
+
+#define BLOCK_SIZE 64
+#define GRID_SIZE 4096
+#define NUM_LAUNCHES 8
+
+
+/**
+ * Each invocation writes its thread id to local memory, and after the
+ * barrier stores the id of the mirrored invocation of its block to its
+ * global slot.
+ */
+static const char kernel[] =
+   "COMP\n"
+   "DCL RES[0], BUFFER, RAW, WR\n"
+   "DCL SV[0], BLOCK_ID[0]\n"
+   "DCL SV[1], BLOCK_SIZE[0]\n"
+   "DCL SV[2], THREAD_ID[0]\n"
+   "DCL TEMP[0..3]\n"
+   "IMM UINT32 { 4, 4294967292, 0, 0 }\n"
+   "  0: UMUL TEMP[0].x, SV[2].xxxx, IMM[0].xxxx\n"
+   "  1: STORE RES[32766].x, TEMP[0].xxxx, SV[2].xxxx\n"
+   "  2: BARRIER\n"
+   "  3: UMAD TEMP[1].x, SV[1].xxxx, IMM[0].xxxx, IMM[0].yyyy\n"
+   "  4: INEG TEMP[2].x, TEMP[0].xxxx\n"
+   "  5: UADD TEMP[1].x, TEMP[1].xxxx, TEMP[2].xxxx\n"
+   "  6: LOAD TEMP[2].x, RES[32766], TEMP[1].xxxx\n"
+   "  7: UMAD TEMP[3].x, SV[0].xxxx, SV[1].xxxx, SV[2].xxxx\n"
+   "  8: UMUL TEMP[3].x, TEMP[3].xxxx, IMM[0].xxxx\n"
+   "  9: STORE RES[0].x, TEMP[3].xxxx, TEMP[2].xxxx\n"
+   " 10: END\n";
+
+
+/**
+ * Only some invocations reach the barrier, which the code generator can't
+ * handle, so the shader must be rejected.
+ */
+static const char divergent_barrier_kernel[] =
+   "COMP\n"
+   "DCL RES[0], BUFFER, RAW, WR\n"
+   "DCL SV[0], THREAD_ID[0]\n"
+   "DCL TEMP[0]\n"
+   "IMM UINT32 { 4, 0, 0, 0 }\n"
+   "  0: USEQ TEMP[0].x, SV[0].xxxx, IMM[0].yyyy\n"
+   "  1: UIF TEMP[0].xxxx :3\n"
+   "  2:   BARRIER\n"
+   "  3: ENDIF\n"
+   "  4: UMUL TEMP[0].x, SV[0].xxxx, IMM[0].xxxx\n"
+   "  5: STORE RES[0].x, TEMP[0].xxxx, SV[0].xxxx\n"
+   "  6: END\n";
+
+
+/**
+ * Each invocation writes its global id plus one, as a float, to its slot.
+ */
+static const char vertex_kernel[] =
+   "COMP\n"
+   "DCL RES[0], BUFFER, RAW, WR\n"
+   "DCL SV[0], BLOCK_ID[0]\n"
+   "DCL SV[1], BLOCK_SIZE[0]\n"
+   "DCL SV[2], THREAD_ID[0]\n"
+   "DCL TEMP[0..1]\n"
+   "IMM UINT32 { 4, 1, 0, 0 }\n"
+   "  0: UMAD TEMP[0].x, SV[0].xxxx, SV[1].xxxx, SV[2].xxxx\n"
+   "  1: UADD TEMP[1].x, TEMP[0].xxxx, IMM[0].yyyy\n"
+   "  2: U2F TEMP[1].x, TEMP[1].xxxx\n"
+   "  3: UMUL TEMP[0].x, TEMP[0].xxxx, IMM[0].xxxx\n"
+   "  4: STORE RES[0].x, TEMP[0].xxxx, TEMP[1].xxxx\n"
+   "  5: END\n";
+
+static const char passthrough_vs[] =
+   "VERT\n"
+   "DCL IN[0]\n"
+   "DCL OUT[0], POSITION\n"
+   "  0: MOV OUT[0], IN[0]\n"
+   "  1: END\n";
+
+static const char white_fs[] =
+   "FRAG\n"
+   "DCL OUT[0], COLOR\n"
+   "IMM FLT32 { 1.0, 1.0, 1.0, 1.0 }\n"
+   "  0: MOV OUT[0], IMM[0]\n"
+   "  1: END\n";
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "threads\t"
+           "invocations_per_sec\n");
+
+   fflush(fp);
+}
+
+
+static void
+write_tsv_row(FILE *fp,
+              unsigned num_threads,
+              double rate,
+              boolean success)
+{
+   fprintf(fp, "%s\t", success ? "pass" : "fail");
+   fprintf(fp, "%u\t", num_threads);
+   fprintf(fp, "%.1f\n", rate);
+
+   fflush(fp);
+}
+
+
+static void
+set_num_threads(unsigned num_threads)
+{
+   char value[16];
+
+   util_snprintf(value, sizeof value, "%u", num_threads);
+#ifdef _WIN32
+   _putenv_s("LP_NUM_THREADS", value);
+#else
+   setenv("LP_NUM_THREADS", value, 1);
+#endif
+}
+
+
+static boolean
+check_results(unsigned verbose, const uint32_t *data)
+{
+   unsigned i;
+
+   for (i = 0; i < BLOCK_SIZE * GRID_SIZE; i++) {
+      uint32_t expected = BLOCK_SIZE - 1 - i % BLOCK_SIZE;
+      if (data[i] != expected) {
+         if (verbose)
+            fprintf(stderr, "invocation %u: got %u, expected %u\n",
+                    i, data[i], expected);
+         return FALSE;
+      }
+   }
+
+   return TRUE;
+}
+
+
+static boolean
+test_compute(unsigned verbose, FILE *fp, unsigned num_threads)
+{
+   const unsigned size = BLOCK_SIZE * GRID_SIZE * 4;
+   const uint block_layout[3] = { BLOCK_SIZE, 1, 1 };
+   const uint grid_layout[3] = { GRID_SIZE, 1, 1 };
+   struct sw_winsys winsys;
+   struct pipe_screen *screen;
+   struct pipe_context *pipe;
+   struct pipe_resource *buffer;
+   struct pipe_surface surf_tmpl, *surf;
+   struct pipe_compute_state cs;
+   struct tgsi_token tokens[256];
+   struct pipe_fence_handle *fence = NULL;
+   struct pipe_transfer *transfer;
+   void *cs_state;
+   uint32_t *data;
+   int64_t start, end;
+   double rate;
+   boolean success;
+   unsigned i;
+
+   if (!tgsi_text_translate(kernel, tokens, Elements(tokens)))
+      return FALSE;
+
+   set_num_threads(num_threads);
+
+   /* nothing is ever displayed */
+   memset(&winsys, 0, sizeof winsys);
+   screen = llvmpipe_create_screen(&winsys);
+   if (!screen)
+      return FALSE;
+
+   pipe = screen->context_create(screen, NULL);
+   if (!pipe) {
+      screen->destroy(screen);
+      return FALSE;
+   }
+
+   buffer = pipe_buffer_create(screen, PIPE_BIND_COMPUTE_RESOURCE,
+                               PIPE_USAGE_DEFAULT, size);
+
+   memset(&surf_tmpl, 0, sizeof surf_tmpl);
+   surf_tmpl.format = PIPE_FORMAT_R32_UINT;
+   surf_tmpl.u.buf.first_element = 0;
+   surf_tmpl.u.buf.last_element = BLOCK_SIZE * GRID_SIZE - 1;
+   surf = pipe->create_surface(pipe, buffer, &surf_tmpl);
+
+   memset(&cs, 0, sizeof cs);
+   cs.prog = tokens;
+   cs.req_local_mem = BLOCK_SIZE * 4;
+   cs_state = pipe->create_compute_state(pipe, &cs);
+   pipe->bind_compute_state(pipe, cs_state);
+   pipe->set_compute_resources(pipe, 0, 1, &surf);
+
+   /* compile the kernel and fault the buffer in */
+   pipe->launch_grid(pipe, block_layout, grid_layout, 0, NULL);
+   pipe->flush(pipe, &fence, 0);
+   screen->fence_finish(screen, fence, PIPE_TIMEOUT_INFINITE);
+   screen->fence_reference(screen, &fence, NULL);
+
+   start = os_time_get_nano();
+   for (i = 0; i < NUM_LAUNCHES; i++) {
+      pipe->launch_grid(pipe, block_layout, grid_layout, 0, NULL);
+   }
+   pipe->flush(pipe, &fence, 0);
+   screen->fence_finish(screen, fence, PIPE_TIMEOUT_INFINITE);
+   screen->fence_reference(screen, &fence, NULL);
+   end = os_time_get_nano();
+
+   rate = (double)BLOCK_SIZE * GRID_SIZE * NUM_LAUNCHES /
+          ((double)(end - start) * 1e-9);
+
+   data = pipe_buffer_map(pipe, buffer, PIPE_TRANSFER_READ, &transfer);
+   success = data && check_results(verbose, data);
+   if (data)
+      pipe_buffer_unmap(pipe, transfer);
+
+   if (verbose || !success)
+      fprintf(stderr, "%u threads: %.1f Minvocations/s%s\n",
+              num_threads, rate * 1e-6, success ? "" : " (FAILED)");
+
+   if (fp)
+      write_tsv_row(fp, num_threads, rate, success);
+
+   pipe->set_compute_resources(pipe, 0, 1, NULL);
+   pipe->bind_compute_state(pipe, NULL);
+   pipe->delete_compute_state(pipe, cs_state);
+   pipe_surface_reference(&surf, NULL);
+   pipe_resource_reference(&buffer, NULL);
+   pipe->destroy(pipe);
+   screen->destroy(screen);
+
+   return success;
+}
+
+
+/**
+ * Fill a vertex buffer with a grid, and draw points from it right away,
+ * without flushing.  The positions the vertex shader got are captured with
+ * stream output: they must be the ones the grid wrote, not the zeros the
+ * buffer held before.
+ */
+static boolean
+test_draw_after_grid(unsigned verbose)
+{
+   const unsigned num_verts = BLOCK_SIZE * GRID_SIZE;
+   const uint block_layout[3] = { BLOCK_SIZE, 1, 1 };
+   const uint grid_layout[3] = { GRID_SIZE, 1, 1 };
+   const unsigned so_offset = 0;
+   struct tgsi_token cs_tokens[256], vs_tokens[256], fs_tokens[256];
+   struct sw_winsys winsys;
+   struct pipe_screen *screen;
+   struct pipe_context *pipe;
+   struct pipe_resource *vbuffer, *so_buffer;
+   struct pipe_surface surf_tmpl, *surf;
+   struct pipe_compute_state cs;
+   struct pipe_shader_state vs, fs;
+   struct pipe_rasterizer_state rast;
+   struct pipe_blend_state blend;
+   struct pipe_depth_stencil_alpha_state dsa;
+   struct pipe_framebuffer_state fb;
+   struct pipe_vertex_element velem;
+   struct pipe_vertex_buffer vbuf;
+   struct pipe_stream_output_target *so_target;
+   struct pipe_transfer *transfer;
+   void *cs_state, *vs_state, *fs_state, *rast_state, *blend_state;
+   void *dsa_state, *velem_state;
+   float *zeros;
+   const float *data;
+   boolean success = TRUE;
+   unsigned i;
+
+   if (!tgsi_text_translate(vertex_kernel, cs_tokens, Elements(cs_tokens)) ||
+       !tgsi_text_translate(passthrough_vs, vs_tokens, Elements(vs_tokens)) ||
+       !tgsi_text_translate(white_fs, fs_tokens, Elements(fs_tokens)))
+      return FALSE;
+
+   zeros = CALLOC(num_verts, sizeof *zeros);
+   if (!zeros)
+      return FALSE;
+
+   /* the grid must run on rasterizer threads to race with the draw */
+   set_num_threads(MAX2(1, util_cpu_caps.nr_cpus));
+
+   memset(&winsys, 0, sizeof winsys);
+   screen = llvmpipe_create_screen(&winsys);
+   if (!screen) {
+      FREE(zeros);
+      return FALSE;
+   }
+
+   pipe = screen->context_create(screen, NULL);
+   if (!pipe) {
+      screen->destroy(screen);
+      FREE(zeros);
+      return FALSE;
+   }
+
+   vbuffer = pipe_buffer_create(screen,
+                                PIPE_BIND_COMPUTE_RESOURCE |
+                                PIPE_BIND_VERTEX_BUFFER,
+                                PIPE_USAGE_DEFAULT, num_verts * 4);
+   pipe_buffer_write(pipe, vbuffer, 0, num_verts * 4, zeros);
+
+   memset(&surf_tmpl, 0, sizeof surf_tmpl);
+   surf_tmpl.format = PIPE_FORMAT_R32_FLOAT;
+   surf_tmpl.u.buf.first_element = 0;
+   surf_tmpl.u.buf.last_element = num_verts - 1;
+   surf = pipe->create_surface(pipe, vbuffer, &surf_tmpl);
+
+   memset(&cs, 0, sizeof cs);
+   cs.prog = cs_tokens;
+   cs_state = pipe->create_compute_state(pipe, &cs);
+   pipe->bind_compute_state(pipe, cs_state);
+   pipe->set_compute_resources(pipe, 0, 1, &surf);
+
+   memset(&vs, 0, sizeof vs);
+   vs.tokens = vs_tokens;
+   vs.stream_output.num_outputs = 1;
+   vs.stream_output.stride[0] = 1;
+   vs.stream_output.output[0].register_index = 0;
+   vs.stream_output.output[0].num_components = 1;
+   vs_state = pipe->create_vs_state(pipe, &vs);
+   pipe->bind_vs_state(pipe, vs_state);
+
+   memset(&fs, 0, sizeof fs);
+   fs.tokens = fs_tokens;
+   fs_state = pipe->create_fs_state(pipe, &fs);
+   pipe->bind_fs_state(pipe, fs_state);
+
+   memset(&rast, 0, sizeof rast);
+   rast.rasterizer_discard = 1;
+   rast.half_pixel_center = 1;
+   rast.depth_clip = 1;
+   rast.point_size = 1.0f;
+   rast_state = pipe->create_rasterizer_state(pipe, &rast);
+   pipe->bind_rasterizer_state(pipe, rast_state);
+
+   memset(&blend, 0, sizeof blend);
+   blend_state = pipe->create_blend_state(pipe, &blend);
+   pipe->bind_blend_state(pipe, blend_state);
+
+   memset(&dsa, 0, sizeof dsa);
+   dsa_state = pipe->create_depth_stencil_alpha_state(pipe, &dsa);
+   pipe->bind_depth_stencil_alpha_state(pipe, dsa_state);
+
+   memset(&fb, 0, sizeof fb);
+   fb.width = 64;
+   fb.height = 64;
+   pipe->set_framebuffer_state(pipe, &fb);
+
+   memset(&velem, 0, sizeof velem);
+   velem.src_format = PIPE_FORMAT_R32_FLOAT;
+   velem_state = pipe->create_vertex_elements_state(pipe, 1, &velem);
+   pipe->bind_vertex_elements_state(pipe, velem_state);
+
+   memset(&vbuf, 0, sizeof vbuf);
+   vbuf.stride = 4;
+   vbuf.buffer = vbuffer;
+   pipe->set_vertex_buffers(pipe, 0, 1, &vbuf);
+
+   so_buffer = pipe_buffer_create(screen, PIPE_BIND_STREAM_OUTPUT,
+                                  PIPE_USAGE_DEFAULT, num_verts * 4);
+   so_target = pipe->create_stream_output_target(pipe, so_buffer, 0,
+                                                 num_verts * 4);
+   pipe->set_stream_output_targets(pipe, 1, &so_target, &so_offset);
+
+   pipe->launch_grid(pipe, block_layout, grid_layout, 0, NULL);
+   util_draw_arrays(pipe, PIPE_PRIM_POINTS, 0, num_verts);
+
+   data = pipe_buffer_map(pipe, so_buffer, PIPE_TRANSFER_READ, &transfer);
+   if (!data)
+      success = FALSE;
+
+   for (i = 0; data && i < num_verts; i++) {
+      if (data[i] != (float)(i + 1)) {
+         if (verbose)
+            fprintf(stderr, "vertex %u: got %f, expected %u\n",
+                    i, data[i], i + 1);
+         success = FALSE;
+         break;
+      }
+   }
+
+   if (data)
+      pipe_buffer_unmap(pipe, transfer);
+
+   if (verbose || !success)
+      fprintf(stderr, "draw after grid: %s\n",
+              success ? "vertices written by the grid" : "FAILED");
+
+   pipe->set_stream_output_targets(pipe, 0, NULL, NULL);
+   pipe->stream_output_target_destroy(pipe, so_target);
+   pipe_resource_reference(&so_buffer, NULL);
+   pipe->set_vertex_buffers(pipe, 0, 1, NULL);
+   pipe->bind_vertex_elements_state(pipe, NULL);
+   pipe->delete_vertex_elements_state(pipe, velem_state);
+   pipe->bind_depth_stencil_alpha_state(pipe, NULL);
+   pipe->delete_depth_stencil_alpha_state(pipe, dsa_state);
+   pipe->bind_blend_state(pipe, NULL);
+   pipe->delete_blend_state(pipe, blend_state);
+   pipe->bind_rasterizer_state(pipe, NULL);
+   pipe->delete_rasterizer_state(pipe, rast_state);
+   pipe->bind_fs_state(pipe, NULL);
+   pipe->delete_fs_state(pipe, fs_state);
+   pipe->bind_vs_state(pipe, NULL);
+   pipe->delete_vs_state(pipe, vs_state);
+   pipe->set_compute_resources(pipe, 0, 1, NULL);
+   pipe->bind_compute_state(pipe, NULL);
+   pipe->delete_compute_state(pipe, cs_state);
+   pipe_surface_reference(&surf, NULL);
+   pipe_resource_reference(&vbuffer, NULL);
+   pipe->destroy(pipe);
+   screen->destroy(screen);
+   FREE(zeros);
+
+   return success;
+}
+
+
+static boolean
+test_divergent_barrier(unsigned verbose)
+{
+   struct sw_winsys winsys;
+   struct pipe_screen *screen;
+   struct pipe_context *pipe;
+   struct pipe_compute_state cs;
+   struct tgsi_token tokens[256];
+   void *cs_state;
+
+   if (!tgsi_text_translate(divergent_barrier_kernel, tokens,
+                            Elements(tokens)))
+      return FALSE;
+
+   memset(&winsys, 0, sizeof winsys);
+   screen = llvmpipe_create_screen(&winsys);
+   if (!screen)
+      return FALSE;
+
+   pipe = screen->context_create(screen, NULL);
+   if (!pipe) {
+      screen->destroy(screen);
+      return FALSE;
+   }
+
+   memset(&cs, 0, sizeof cs);
+   cs.prog = tokens;
+   cs_state = pipe->create_compute_state(pipe, &cs);
+   if (cs_state) {
+      if (verbose)
+         fprintf(stderr, "BARRIER within flow control was accepted\n");
+      pipe->delete_compute_state(pipe, cs_state);
+   }
+
+   pipe->destroy(pipe);
+   screen->destroy(screen);
+
+   return cs_state == NULL;
+}
+
+
+boolean
+test_all(unsigned verbose, FILE *fp)
+{
+   unsigned max_threads = MAX2(1, util_cpu_caps.nr_cpus);
+   unsigned num_threads;
+   boolean success = TRUE;
+
+   if (!test_divergent_barrier(verbose))
+      success = FALSE;
+
+   if (!test_draw_after_grid(verbose))
+      success = FALSE;
+
+   /* 0 is the rasterizer running in the calling thread */
+   if (!test_compute(verbose, fp, 0))
+      success = FALSE;
+
+   for (num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+      if (!test_compute(verbose, fp, num_threads))
+         success = FALSE;
+   }
+
+   if (!util_is_power_of_two(max_threads)) {
+      if (!test_compute(verbose, fp, max_threads))
+         success = FALSE;
+   }
+
+   return success;
+}
+
+
+boolean
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   return test_all(verbose, fp);
+}
+
+
+boolean
+test_single(unsigned verbose, FILE *fp)
+{
+   return test_compute(verbose, fp, 0);
+}
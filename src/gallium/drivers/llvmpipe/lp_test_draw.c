@@ -0,0 +1,366 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Multi-threaded vertex shading test.
+ *
+ * Captures the vertex shader outputs of large draws, whose vertex shading
+ * the draw module splits across threads, with stream output, and checks
+ * they are bit-identical to those of the same vertices drawn in small
+ * draws, which are shaded on the calling thread.
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_defines.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "util/u_draw.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+#include "util/u_prim.h"
+#include "tgsi/tgsi_text.h"
+#include "state_tracker/sw_winsys.h"
+
+#include "lp_public.h"
+#include "lp_test.h"
+
+
+#define NUM_VERTS 3000
+
+/** Vertex count of the small draws; below DRAW_MT_THRESHOLD. */
+#define SERIAL_DRAW_SIZE 255
+
+/** Dwords captured per vertex: the position and one generic. */
+#define SO_STRIDE 8
+
+
+static const char vs_text[] =
+   "VERT\n"
+   "DCL IN[0]\n"
+   "DCL OUT[0], POSITION\n"
+   "DCL OUT[1], GENERIC[0]\n"
+   "DCL TEMP[0]\n"
+   "IMM[0] FLT32 { 0.5, 1.5, 2.0, 3.0 }\n"
+   "  0: MAD TEMP[0], IN[0], IMM[0], IMM[0].wzyx\n"
+   "  1: SIN OUT[1].x, TEMP[0].xxxx\n"
+   "  2: EX2 OUT[1].y, TEMP[0].yyyy\n"
+   "  3: MUL OUT[1].zw, TEMP[0], TEMP[0]\n"
+   "  4: MOV OUT[0], IN[0]\n"
+   "  5: END\n";
+
+static const char fs_text[] =
+   "FRAG\n"
+   "DCL OUT[0], COLOR\n"
+   "IMM[0] FLT32 { 1.0, 1.0, 1.0, 1.0 }\n"
+   "  0: MOV OUT[0], IMM[0]\n"
+   "  1: END\n";
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "prim\t"
+           "indexed\n");
+
+   fflush(fp);
+}
+
+
+static void
+write_tsv_row(FILE *fp,
+              unsigned prim,
+              boolean indexed,
+              boolean success)
+{
+   fprintf(fp, "%s\t", success ? "pass" : "fail");
+   fprintf(fp, "%s\t", u_prim_name(prim));
+   fprintf(fp, "%u\n", indexed);
+
+   fflush(fp);
+}
+
+
+/**
+ * Draw NUM_VERTS vertices in draws of at most draw_size vertices, and
+ * return the captured vertex shader outputs.
+ */
+static float *
+draw_and_capture(const float (*verts)[4], const ushort *indices,
+                 unsigned prim, unsigned draw_size)
+{
+   const unsigned size = NUM_VERTS * SO_STRIDE * 4;
+   struct tgsi_token vs_tokens[256], fs_tokens[256];
+   struct sw_winsys winsys;
+   struct pipe_screen *screen;
+   struct pipe_context *pipe;
+   struct pipe_shader_state vs, fs;
+   struct pipe_rasterizer_state rast;
+   struct pipe_blend_state blend;
+   struct pipe_depth_stencil_alpha_state dsa;
+   struct pipe_framebuffer_state fb;
+   struct pipe_viewport_state vp;
+   struct pipe_vertex_element velem;
+   struct pipe_vertex_buffer vbuf;
+   struct pipe_index_buffer ibuf;
+   struct pipe_resource *so_buffer;
+   struct pipe_stream_output_target *so_target;
+   struct pipe_transfer *transfer;
+   void *vs_state, *fs_state, *rast_state, *blend_state, *dsa_state;
+   void *velem_state;
+   const unsigned so_offset = 0;
+   const float *data;
+   float *result = NULL;
+   unsigned start;
+
+   if (!tgsi_text_translate(vs_text, vs_tokens, Elements(vs_tokens)) ||
+       !tgsi_text_translate(fs_text, fs_tokens, Elements(fs_tokens)))
+      return NULL;
+
+   /* nothing is ever displayed */
+   memset(&winsys, 0, sizeof winsys);
+   screen = llvmpipe_create_screen(&winsys);
+   if (!screen)
+      return NULL;
+
+   pipe = screen->context_create(screen, NULL);
+   if (!pipe) {
+      screen->destroy(screen);
+      return NULL;
+   }
+
+   memset(&vs, 0, sizeof vs);
+   vs.tokens = vs_tokens;
+   vs.stream_output.num_outputs = 2;
+   vs.stream_output.stride[0] = SO_STRIDE;
+   vs.stream_output.output[0].register_index = 0;
+   vs.stream_output.output[0].num_components = 4;
+   vs.stream_output.output[1].register_index = 1;
+   vs.stream_output.output[1].num_components = 4;
+   vs.stream_output.output[1].dst_offset = 4;
+   vs_state = pipe->create_vs_state(pipe, &vs);
+   pipe->bind_vs_state(pipe, vs_state);
+
+   memset(&fs, 0, sizeof fs);
+   fs.tokens = fs_tokens;
+   fs_state = pipe->create_fs_state(pipe, &fs);
+   pipe->bind_fs_state(pipe, fs_state);
+
+   memset(&rast, 0, sizeof rast);
+   rast.rasterizer_discard = 1;
+   rast.half_pixel_center = 1;
+   rast.depth_clip = 1;
+   rast.point_size = 1.0f;
+   rast_state = pipe->create_rasterizer_state(pipe, &rast);
+   pipe->bind_rasterizer_state(pipe, rast_state);
+
+   memset(&blend, 0, sizeof blend);
+   blend_state = pipe->create_blend_state(pipe, &blend);
+   pipe->bind_blend_state(pipe, blend_state);
+
+   memset(&dsa, 0, sizeof dsa);
+   dsa_state = pipe->create_depth_stencil_alpha_state(pipe, &dsa);
+   pipe->bind_depth_stencil_alpha_state(pipe, dsa_state);
+
+   memset(&fb, 0, sizeof fb);
+   fb.width = 64;
+   fb.height = 64;
+   pipe->set_framebuffer_state(pipe, &fb);
+
+   vp.scale[0] = vp.scale[1] = 32.0f;
+   vp.scale[2] = 0.5f;
+   vp.translate[0] = vp.translate[1] = 32.0f;
+   vp.translate[2] = 0.5f;
+   pipe->set_viewport_states(pipe, 0, 1, &vp);
+
+   memset(&velem, 0, sizeof velem);
+   velem.src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   velem_state = pipe->create_vertex_elements_state(pipe, 1, &velem);
+   pipe->bind_vertex_elements_state(pipe, velem_state);
+
+   memset(&vbuf, 0, sizeof vbuf);
+   vbuf.stride = 4 * sizeof(float);
+   vbuf.user_buffer = verts;
+   pipe->set_vertex_buffers(pipe, 0, 1, &vbuf);
+
+   if (indices) {
+      memset(&ibuf, 0, sizeof ibuf);
+      ibuf.index_size = sizeof(ushort);
+      ibuf.user_buffer = indices;
+      pipe->set_index_buffer(pipe, &ibuf);
+   }
+
+   so_buffer = pipe_buffer_create(screen, PIPE_BIND_STREAM_OUTPUT,
+                                  PIPE_USAGE_DEFAULT, size);
+   so_target = pipe->create_stream_output_target(pipe, so_buffer, 0, size);
+   pipe->set_stream_output_targets(pipe, 1, &so_target, &so_offset);
+
+   /* Consecutive draws append to the stream output buffer. */
+   for (start = 0; start < NUM_VERTS; start += draw_size) {
+      unsigned count = MIN2(draw_size, NUM_VERTS - start);
+
+      if (indices)
+         util_draw_elements(pipe, 0, prim, start, count);
+      else
+         util_draw_arrays(pipe, prim, start, count);
+   }
+
+   data = pipe_buffer_map(pipe, so_buffer, PIPE_TRANSFER_READ, &transfer);
+   if (data) {
+      result = MALLOC(size);
+      if (result)
+         memcpy(result, data, size);
+      pipe_buffer_unmap(pipe, transfer);
+   }
+
+   pipe->set_stream_output_targets(pipe, 0, NULL, NULL);
+   pipe->stream_output_target_destroy(pipe, so_target);
+   pipe_resource_reference(&so_buffer, NULL);
+   pipe->set_vertex_buffers(pipe, 0, 1, NULL);
+   pipe->bind_vertex_elements_state(pipe, NULL);
+   pipe->delete_vertex_elements_state(pipe, velem_state);
+   pipe->bind_depth_stencil_alpha_state(pipe, NULL);
+   pipe->delete_depth_stencil_alpha_state(pipe, dsa_state);
+   pipe->bind_blend_state(pipe, NULL);
+   pipe->delete_blend_state(pipe, blend_state);
+   pipe->bind_rasterizer_state(pipe, NULL);
+   pipe->delete_rasterizer_state(pipe, rast_state);
+   pipe->bind_fs_state(pipe, NULL);
+   pipe->delete_fs_state(pipe, fs_state);
+   pipe->bind_vs_state(pipe, NULL);
+   pipe->delete_vs_state(pipe, vs_state);
+   pipe->destroy(pipe);
+   screen->destroy(screen);
+
+   return result;
+}
+
+
+static boolean
+test_draw(unsigned verbose, FILE *fp, unsigned prim, boolean indexed)
+{
+   float (*verts)[4];
+   ushort *indices = NULL;
+   float *threaded, *serial;
+   boolean success;
+   unsigned i;
+
+   verts = MALLOC(NUM_VERTS * sizeof *verts);
+   if (!verts)
+      return FALSE;
+
+   for (i = 0; i < NUM_VERTS; i++) {
+      verts[i][0] = (float)i / NUM_VERTS * 2.0f - 1.0f;
+      verts[i][1] = (float)(i % 37) / 37.0f - 0.5f;
+      verts[i][2] = (float)(i % 11) / 11.0f;
+      verts[i][3] = 1.0f;
+   }
+
+   if (indexed) {
+      indices = MALLOC(NUM_VERTS * sizeof *indices);
+      if (!indices) {
+         FREE(verts);
+         return FALSE;
+      }
+
+      /* Every vertex once, so that no fetch is shared between draws. */
+      for (i = 0; i < NUM_VERTS; i++)
+         indices[i] = (i * 7) % NUM_VERTS;
+   }
+
+   threaded = draw_and_capture(verts, indices, prim, NUM_VERTS);
+   serial = draw_and_capture(verts, indices, prim, SERIAL_DRAW_SIZE);
+
+   success = threaded && serial &&
+             memcmp(threaded, serial, NUM_VERTS * SO_STRIDE * 4) == 0;
+
+   if (verbose || !success) {
+      fprintf(stderr, "%s%s: %s\n", u_prim_name(prim),
+              indexed ? " (indexed)" : "",
+              success ? "threaded and serial outputs match" :
+                        "FAILED");
+   }
+
+   if (fp)
+      write_tsv_row(fp, prim, indexed, success);
+
+   FREE(threaded);
+   FREE(serial);
+   FREE(indices);
+   FREE(verts);
+
+   return success;
+}
+
+
+boolean
+test_all(unsigned verbose, FILE *fp)
+{
+   boolean success = TRUE;
+
+   /* Make sure there are worker threads even on a single cpu, unless
+    * the user asked otherwise.
+    */
+   if (!getenv("DRAW_NUM_THREADS")) {
+#ifdef _WIN32
+      _putenv_s("DRAW_NUM_THREADS", "3");
+#else
+      setenv("DRAW_NUM_THREADS", "3", 1);
+#endif
+   }
+
+   if (!test_draw(verbose, fp, PIPE_PRIM_POINTS, FALSE))
+      success = FALSE;
+
+   if (!test_draw(verbose, fp, PIPE_PRIM_TRIANGLES, TRUE))
+      success = FALSE;
+
+   return success;
+}
+
+
+boolean
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   return test_all(verbose, fp);
+}
+
+
+boolean
+test_single(unsigned verbose, FILE *fp)
+{
+   return test_all(verbose, fp);
+}
@@ -0,0 +1,360 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Unit tests and benchmark for lp_build_gather.
+ *
+ * Every gather is built twice, once with whatever the cpu supports (AVX2
+ * hardware gathers if available) and once forcing the scalar load path,
+ * so the cycle counts of both can be compared directly.
+ */
+
+
+#include <string.h>
+
+#include "util/u_memory.h"
+#include "util/u_pointer.h"
+#include "util/u_cpu_detect.h"
+#include "gallivm/lp_bld_init.h"
+#include "gallivm/lp_bld_type.h"
+#include "gallivm/lp_bld_const.h"
+#include "gallivm/lp_bld_flow.h"
+#include "gallivm/lp_bld_gather.h"
+#include "lp_test.h"
+
+
+/** Number of offset vectors gathered per function call */
+#define GATHER_TEST_BATCH 64
+
+/** Size of the memory we gather from */
+#define GATHER_TEST_BUFFER_SIZE (64 * 1024)
+
+
+typedef void (*gather_test_ptr_t)(const uint8_t *base,
+                                  const int32_t *offsets,
+                                  uint32_t *dst,
+                                  int32_t count);
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "cycles_per_element\t"
+           "scalar_cycles_per_element\t"
+           "length\t"
+           "src_width\n");
+
+   fflush(fp);
+}
+
+
+static void
+write_tsv_row(FILE *fp,
+              unsigned length,
+              unsigned src_width,
+              double cycles,
+              double scalar_cycles,
+              boolean success)
+{
+   fprintf(fp, "%s\t", success ? "pass" : "fail");
+
+   fprintf(fp, "%.1f\t", cycles / (length * GATHER_TEST_BATCH));
+   fprintf(fp, "%.1f\t", scalar_cycles / (length * GATHER_TEST_BATCH));
+
+   fprintf(fp, "%u\t%u\n", length, src_width);
+
+   fflush(fp);
+}
+
+
+static LLVMValueRef
+add_gather_test(struct gallivm_state *gallivm,
+                unsigned length,
+                unsigned src_width)
+{
+   LLVMModuleRef module = gallivm->module;
+   LLVMContextRef context = gallivm->context;
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMTypeRef i32t = LLVMInt32TypeInContext(context);
+   LLVMTypeRef vec_type = LLVMVectorType(i32t, length);
+   LLVMTypeRef args[4];
+   LLVMValueRef func;
+   LLVMValueRef base_ptr, offsets_ptr, dst_ptr, count;
+   LLVMValueRef offsets, res, ptr;
+   LLVMBasicBlockRef block;
+   struct lp_build_loop_state loop;
+
+   args[0] = LLVMPointerType(LLVMInt8TypeInContext(context), 0);
+   args[1] = LLVMPointerType(vec_type, 0);
+   args[2] = LLVMPointerType(vec_type, 0);
+   args[3] = i32t;
+
+   func = LLVMAddFunction(module, "test",
+                          LLVMFunctionType(LLVMVoidTypeInContext(context),
+                                           args, 4, 0));
+   LLVMSetFunctionCallConv(func, LLVMCCallConv);
+   base_ptr = LLVMGetParam(func, 0);
+   offsets_ptr = LLVMGetParam(func, 1);
+   dst_ptr = LLVMGetParam(func, 2);
+   count = LLVMGetParam(func, 3);
+
+   block = LLVMAppendBasicBlockInContext(context, func, "entry");
+   LLVMPositionBuilderAtEnd(builder, block);
+
+   lp_build_loop_begin(&loop, gallivm, lp_build_const_int32(gallivm, 0));
+   {
+      ptr = LLVMBuildGEP(builder, offsets_ptr, &loop.counter, 1, "");
+      offsets = LLVMBuildLoad(builder, ptr, "");
+      lp_set_load_alignment(offsets, 4);
+
+      res = lp_build_gather(gallivm, length, src_width, 32, TRUE,
+                            base_ptr, offsets, FALSE);
+
+      ptr = LLVMBuildGEP(builder, dst_ptr, &loop.counter, 1, "");
+      lp_set_store_alignment(LLVMBuildStore(builder, res, ptr), 4);
+   }
+   lp_build_loop_end_cond(&loop, count, NULL, LLVMIntUGE);
+
+   LLVMBuildRetVoid(builder);
+
+   gallivm_verify_function(gallivm, func);
+
+   return func;
+}
+
+
+/**
+ * Build and run one gather variant, returning the average cycle count.
+ */
+PIPE_ALIGN_STACK
+static double
+run_gather(unsigned length,
+           unsigned src_width,
+           const uint8_t *base,
+           const int32_t *offsets,
+           uint32_t *dst)
+{
+   struct gallivm_state *gallivm;
+   LLVMValueRef func;
+   gather_test_ptr_t gather_test_ptr;
+   const unsigned n = LP_TEST_NUM_SAMPLES;
+   int64_t cycles[LP_TEST_NUM_SAMPLES];
+   double sum = 0.0, sum2 = 0.0;
+   double avg, std;
+   unsigned i, m;
+
+   gallivm = gallivm_create("test_module", LLVMGetGlobalContext());
+
+   func = add_gather_test(gallivm, length, src_width);
+
+   gallivm_compile_module(gallivm);
+
+   gather_test_ptr = (gather_test_ptr_t)gallivm_jit_function(gallivm, func);
+
+   gallivm_free_ir(gallivm);
+
+   for (i = 0; i < n; ++i) {
+      int64_t start_counter = rdtsc();
+      gather_test_ptr(base, offsets, dst, GATHER_TEST_BATCH);
+      cycles[i] = rdtsc() - start_counter;
+   }
+
+   gallivm_destroy(gallivm);
+
+   /*
+    * Remove outliers, see lp_test_conv.c.
+    */
+   for (i = 0; i < n; ++i) {
+      sum += cycles[i];
+      sum2 += cycles[i]*cycles[i];
+   }
+
+   avg = sum/n;
+   std = sqrtf((sum2 - n*avg*avg)/n);
+
+   m = 0;
+   sum = 0.0;
+   for (i = 0; i < n; ++i) {
+      if (fabs(cycles[i] - avg) <= 4.0*std) {
+         sum += cycles[i];
+         ++m;
+      }
+   }
+
+   return m ? sum/m : avg;
+}
+
+
+static boolean
+compare_gather(unsigned length,
+               unsigned src_width,
+               const uint8_t *base,
+               const int32_t *offsets,
+               const uint32_t *dst)
+{
+   unsigned i;
+
+   for (i = 0; i < length * GATHER_TEST_BATCH; ++i) {
+      const uint8_t *src = base + offsets[i];
+      uint32_t ref;
+
+      switch (src_width) {
+      case 8:
+         ref = *src;
+         break;
+      case 16:
+      {
+         uint16_t tmp;
+         memcpy(&tmp, src, sizeof tmp);
+         ref = tmp;
+         break;
+      }
+      default:
+         memcpy(&ref, src, sizeof ref);
+         break;
+      }
+
+      if (dst[i] != ref) {
+         fprintf(stderr, "  element %u: offset %i, got 0x%08x, expected 0x%08x\n",
+                 i, offsets[i], dst[i], ref);
+         return FALSE;
+      }
+   }
+
+   return TRUE;
+}
+
+
+static boolean
+test_one(unsigned verbose,
+         FILE *fp,
+         unsigned length,
+         unsigned src_width)
+{
+   const unsigned src_bytes = src_width / 8;
+   const unsigned num_elems = length * GATHER_TEST_BATCH;
+   struct util_cpu_caps saved_caps = util_cpu_caps;
+   uint8_t *base;
+   int32_t *offsets;
+   uint32_t *dst;
+   double cycles, scalar_cycles;
+   boolean success;
+   unsigned i;
+
+   if (verbose >= 1)
+      fprintf(stderr, "length=%u src_width=%u ...\n", length, src_width);
+
+   base = align_malloc(GATHER_TEST_BUFFER_SIZE, 64);
+   offsets = align_malloc(num_elems * sizeof *offsets, 64);
+   dst = align_malloc(num_elems * sizeof *dst, 64);
+
+   for (i = 0; i < GATHER_TEST_BUFFER_SIZE; ++i) {
+      base[i] = rand();
+   }
+   for (i = 0; i < num_elems; ++i) {
+      offsets[i] = (rand() % (GATHER_TEST_BUFFER_SIZE / src_bytes)) * src_bytes;
+   }
+
+   memset(dst, 0, num_elems * sizeof *dst);
+   cycles = run_gather(length, src_width, base, offsets, dst);
+   success = compare_gather(length, src_width, base, offsets, dst);
+
+   /* Same again, but force the scalar fallback */
+   util_cpu_caps.has_avx2 = 0;
+   memset(dst, 0, num_elems * sizeof *dst);
+   scalar_cycles = run_gather(length, src_width, base, offsets, dst);
+   util_cpu_caps = saved_caps;
+   if (!compare_gather(length, src_width, base, offsets, dst))
+      success = FALSE;
+
+   if (!success || verbose >= 3) {
+      if (verbose < 1)
+         fprintf(stderr, "length=%u src_width=%u ...\n", length, src_width);
+      fprintf(stderr, success ? "PASS\n" : "MISMATCH\n");
+   }
+
+   if (fp)
+      write_tsv_row(fp, length, src_width, cycles, scalar_cycles, success);
+
+   align_free(dst);
+   align_free(offsets);
+   align_free(base);
+
+   return success;
+}
+
+
+static const unsigned gather_lengths[] = { 4, 8, 16 };
+
+static const unsigned gather_src_widths[] = { 8, 16, 32 };
+
+
+boolean
+test_all(unsigned verbose, FILE *fp)
+{
+   boolean success = TRUE;
+   unsigned i, j;
+
+   for (i = 0; i < Elements(gather_lengths); ++i) {
+      for (j = 0; j < Elements(gather_src_widths); ++j) {
+         if (!test_one(verbose, fp, gather_lengths[i], gather_src_widths[j]))
+            success = FALSE;
+      }
+   }
+
+   return success;
+}
+
+
+boolean
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   boolean success = TRUE;
+   unsigned long i;
+
+   for (i = 0; i < n; ++i) {
+      unsigned length = gather_lengths[rand() % Elements(gather_lengths)];
+      unsigned src_width = gather_src_widths[rand() % Elements(gather_src_widths)];
+
+      if (!test_one(verbose, fp, length, src_width))
+         success = FALSE;
+   }
+
+   return success;
+}
+
+
+boolean
+test_single(unsigned verbose, FILE *fp)
+{
+   return test_one(verbose, fp, lp_native_vector_width / 32, 32);
+}
@@ -0,0 +1,509 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Texture sampling throughput of linear vs. tiled textures.
+ *
+ * A rotated, minified sweep over a mipmapped texture is sampled once from a
+ * linear copy of the texture and once from a tiled copy (see
+ * LP_RESOURCE_FLAG_TILED). The results must be identical, and the cycle
+ * counts show the effect of the layout on the caches.
+ */
+
+
+#include <string.h>
+
+#include "util/u_memory.h"
+#include "util/u_pointer.h"
+#include "gallivm/lp_bld_init.h"
+#include "gallivm/lp_bld_type.h"
+#include "gallivm/lp_bld_const.h"
+#include "gallivm/lp_bld_flow.h"
+#include "gallivm/lp_bld_sample.h"
+#include "gallivm/lp_bld_tgsi.h"
+#include "lp_jit.h"
+#include "lp_state_fs.h"
+#include "lp_tex_sample.h"
+#include "lp_texture.h"
+#include "lp_test.h"
+
+
+/** Size of the destination area, in pixels */
+#define SAMPLE_TEST_SIZE 256
+
+
+typedef void (*sample_test_ptr_t)(const struct lp_jit_context *context,
+                                  const float *s,
+                                  const float *t,
+                                  float *texels,
+                                  int32_t count);
+
+
+struct sample_test_case
+{
+   enum pipe_format format;
+   unsigned size;       /**< texture width and height */
+   float lod;
+   float angle;         /**< in degrees */
+};
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "linear_cycles_per_pixel\t"
+           "tiled_cycles_per_pixel\t"
+           "format\t"
+           "size\t"
+           "lod\t"
+           "angle\n");
+
+   fflush(fp);
+}
+
+
+static void
+write_tsv_row(FILE *fp,
+              const struct sample_test_case *test,
+              double linear_cycles,
+              double tiled_cycles,
+              boolean success)
+{
+   const unsigned num_pixels = SAMPLE_TEST_SIZE * SAMPLE_TEST_SIZE;
+
+   fprintf(fp, "%s\t", success ? "pass" : "fail");
+
+   fprintf(fp, "%.1f\t", linear_cycles / num_pixels);
+   fprintf(fp, "%.1f\t", tiled_cycles / num_pixels);
+
+   fprintf(fp, "%s\t%u\t%.1f\t%.0f\n",
+           util_format_name(test->format), test->size,
+           test->lod, test->angle);
+
+   fflush(fp);
+}
+
+
+/**
+ * Build a function which samples texture unit 0 at count vectors of
+ * coordinates, writing the rgba texels in SoA layout.
+ */
+static LLVMValueRef
+add_sample_test(struct gallivm_state *gallivm,
+                LLVMTypeRef context_ptr_type,
+                const struct lp_sampler_static_state *static_state,
+                struct lp_type type,
+                float lod)
+{
+   LLVMContextRef context = gallivm->context;
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMTypeRef vec_type = lp_build_vec_type(gallivm, type);
+   LLVMTypeRef vec_ptr_type = LLVMPointerType(vec_type, 0);
+   LLVMTypeRef args[5];
+   LLVMValueRef func;
+   LLVMValueRef context_ptr, s_ptr, t_ptr, texels_ptr, count;
+   LLVMBasicBlockRef block;
+   struct lp_build_sampler_soa *sampler;
+   struct lp_build_loop_state loop;
+
+   args[0] = context_ptr_type;
+   args[1] = vec_ptr_type;
+   args[2] = vec_ptr_type;
+   args[3] = vec_ptr_type;
+   args[4] = LLVMInt32TypeInContext(context);
+
+   func = LLVMAddFunction(gallivm->module, "test",
+                          LLVMFunctionType(LLVMVoidTypeInContext(context),
+                                           args, 5, 0));
+   LLVMSetFunctionCallConv(func, LLVMCCallConv);
+   context_ptr = LLVMGetParam(func, 0);
+   s_ptr = LLVMGetParam(func, 1);
+   t_ptr = LLVMGetParam(func, 2);
+   texels_ptr = LLVMGetParam(func, 3);
+   count = LLVMGetParam(func, 4);
+
+   block = LLVMAppendBasicBlockInContext(context, func, "entry");
+   LLVMPositionBuilderAtEnd(builder, block);
+
+   sampler = lp_llvm_sampler_soa_create(static_state);
+
+   lp_build_loop_begin(&loop, gallivm, lp_build_const_int32(gallivm, 0));
+   {
+      struct lp_sampler_params params;
+      LLVMValueRef coords[5];
+      LLVMValueRef texel[4];
+      LLVMValueRef index;
+      unsigned chan;
+
+      coords[0] = LLVMBuildLoad(builder,
+                                LLVMBuildGEP(builder, s_ptr, &loop.counter, 1, ""),
+                                "");
+      coords[1] = LLVMBuildLoad(builder,
+                                LLVMBuildGEP(builder, t_ptr, &loop.counter, 1, ""),
+                                "");
+      coords[2] = coords[3] = coords[4] = LLVMGetUndef(vec_type);
+
+      memset(&params, 0, sizeof params);
+      params.type = type;
+      params.texture_index = 0;
+      params.sampler_index = 0;
+      params.sample_key =
+         (LP_SAMPLER_OP_TEXTURE << LP_SAMPLER_OP_TYPE_SHIFT) |
+         (LP_SAMPLER_LOD_EXPLICIT << LP_SAMPLER_LOD_CONTROL_SHIFT) |
+         (LP_SAMPLER_LOD_PER_ELEMENT << LP_SAMPLER_LOD_PROPERTY_SHIFT);
+      params.context_ptr = context_ptr;
+      params.coords = coords;
+      params.lod = lp_build_const_vec(gallivm, type, lod);
+      params.texel = texel;
+
+      sampler->emit_tex_sample(sampler, gallivm, &params);
+
+      index = LLVMBuildMul(builder, loop.counter,
+                           lp_build_const_int32(gallivm, 4), "");
+      for (chan = 0; chan < 4; ++chan) {
+         LLVMValueRef ptr;
+         ptr = LLVMBuildAdd(builder, index,
+                            lp_build_const_int32(gallivm, chan), "");
+         ptr = LLVMBuildGEP(builder, texels_ptr, &ptr, 1, "");
+         LLVMBuildStore(builder, texel[chan], ptr);
+      }
+   }
+   lp_build_loop_end_cond(&loop, count, NULL, LLVMIntUGE);
+
+   LLVMBuildRetVoid(builder);
+
+   sampler->destroy(sampler);
+
+   gallivm_verify_function(gallivm, func);
+
+   return func;
+}
+
+
+/**
+ * Compile the sample function for a linear or a tiled texture, run it
+ * and return the average cycle count.
+ */
+PIPE_ALIGN_STACK
+static double
+run_sample(const struct sample_test_case *test,
+           const struct lp_jit_context *jit_context,
+           struct pipe_sampler_view *view,
+           const struct pipe_sampler_state *sampler_state,
+           const float *s,
+           const float *t,
+           float *texels,
+           unsigned num_vectors)
+{
+   struct lp_fragment_shader_variant variant;
+   struct lp_sampler_static_state static_state;
+   struct gallivm_state *gallivm;
+   LLVMValueRef func;
+   sample_test_ptr_t sample_test_ptr;
+   struct lp_type type;
+   const unsigned n = LP_TEST_NUM_SAMPLES;
+   int64_t cycles[LP_TEST_NUM_SAMPLES];
+   double sum = 0.0, sum2 = 0.0;
+   double avg, std;
+   unsigned i, m;
+
+   memset(&type, 0, sizeof type);
+   type.floating = TRUE;
+   type.sign = TRUE;
+   type.width = 32;
+   type.length = lp_native_vector_width / 32;
+
+   lp_sampler_static_texture_state(&static_state.texture_state, view);
+   lp_sampler_static_sampler_state(&static_state.sampler_state, sampler_state);
+
+   gallivm = gallivm_create("test_module", LLVMGetGlobalContext());
+
+   memset(&variant, 0, sizeof variant);
+   variant.gallivm = gallivm;
+   lp_jit_init_types(&variant);
+
+   func = add_sample_test(gallivm, variant.jit_context_ptr_type,
+                          &static_state, type, test->lod);
+
+   gallivm_compile_module(gallivm);
+
+   sample_test_ptr = (sample_test_ptr_t)gallivm_jit_function(gallivm, func);
+
+   gallivm_free_ir(gallivm);
+
+   for (i = 0; i < n; ++i) {
+      int64_t start_counter = rdtsc();
+      sample_test_ptr(jit_context, s, t, texels, num_vectors);
+      cycles[i] = rdtsc() - start_counter;
+   }
+
+   gallivm_destroy(gallivm);
+
+   /*
+    * Remove outliers, see lp_test_conv.c.
+    */
+   for (i = 0; i < n; ++i) {
+      sum += cycles[i];
+      sum2 += cycles[i]*cycles[i];
+   }
+
+   avg = sum/n;
+   std = sqrtf((sum2 - n*avg*avg)/n);
+
+   m = 0;
+   sum = 0.0;
+   for (i = 0; i < n; ++i) {
+      if (fabs(cycles[i] - avg) <= 4.0*std) {
+         sum += cycles[i];
+         ++m;
+      }
+   }
+
+   return m ? sum/m : avg;
+}
+
+
+/**
+ * Lay out a mipmapped 2D texture the way llvmpipe_texture_layout does.
+ * Returns the total size.
+ */
+static unsigned
+layout_texture(struct lp_jit_texture *jit_tex,
+               unsigned size, unsigned last_level, unsigned bpp)
+{
+   unsigned total_size = 0;
+   unsigned level;
+
+   jit_tex->width = size;
+   jit_tex->height = size;
+   jit_tex->depth = 1;
+   jit_tex->first_level = 0;
+   jit_tex->last_level = last_level;
+
+   for (level = 0; level <= last_level; level++) {
+      unsigned width = align(u_minify(size, level), LP_TEX_TILE_SIZE);
+      unsigned height = align(u_minify(size, level), LP_TEX_TILE_SIZE);
+
+      jit_tex->row_stride[level] = align(width * bpp, 64);
+      jit_tex->img_stride[level] = jit_tex->row_stride[level] * height;
+      jit_tex->mip_offsets[level] = total_size;
+      total_size += align(jit_tex->img_stride[level], 64);
+   }
+
+   return total_size;
+}
+
+
+static boolean
+test_one(unsigned verbose,
+         FILE *fp,
+         const struct sample_test_case *test)
+{
+   const unsigned bpp = util_format_get_blocksize(test->format);
+   const unsigned length = lp_native_vector_width / 32;
+   const unsigned num_pixels = SAMPLE_TEST_SIZE * SAMPLE_TEST_SIZE;
+   const unsigned num_vectors = num_pixels / length;
+   const unsigned last_level = util_logbase2(test->size);
+   struct lp_jit_context *jit_context;
+   struct pipe_resource texture;
+   struct pipe_sampler_view view;
+   struct pipe_sampler_state sampler;
+   ubyte *linear_data, *tiled_data;
+   float *s, *t, *linear_texels, *tiled_texels;
+   double linear_cycles, tiled_cycles;
+   double step, cos_a, sin_a;
+   unsigned total_size, level, i;
+   boolean success;
+
+   if (verbose >= 1)
+      fprintf(stderr, "%s size=%u lod=%.1f angle=%.0f ...\n",
+              util_format_name(test->format), test->size,
+              test->lod, test->angle);
+
+   jit_context = align_malloc(sizeof *jit_context, 16);
+   memset(jit_context, 0, sizeof *jit_context);
+   jit_context->samplers[0].min_lod = 0.0f;
+   jit_context->samplers[0].max_lod = (float)last_level;
+
+   total_size = layout_texture(&jit_context->textures[0],
+                               test->size, last_level, bpp);
+
+   linear_data = align_malloc(total_size, 64);
+   tiled_data = align_malloc(total_size, 64);
+   for (i = 0; i < total_size; ++i) {
+      linear_data[i] = rand();
+   }
+
+   for (level = 0; level <= last_level; level++) {
+      unsigned offset = jit_context->textures[0].mip_offsets[level];
+      unsigned row_stride = jit_context->textures[0].row_stride[level];
+      unsigned size = u_minify(test->size, level);
+
+      memset(tiled_data + offset, 0, jit_context->textures[0].img_stride[level]);
+      llvmpipe_tile_image(tiled_data + offset, row_stride,
+                          linear_data + offset, row_stride,
+                          0, 0, size, size, bpp);
+   }
+
+   /*
+    * Coordinates of a rotated, minified quad covering the destination area,
+    * in 2x2 pixel quads as the rasterizer would generate them.
+    */
+   s = align_malloc(num_pixels * sizeof *s, 64);
+   t = align_malloc(num_pixels * sizeof *t, 64);
+   step = pow(2.0, test->lod) / test->size;
+   cos_a = cos(test->angle * M_PI / 180.0);
+   sin_a = sin(test->angle * M_PI / 180.0);
+   for (i = 0; i < num_pixels; ++i) {
+      unsigned quad = i / 4;
+      unsigned quads_per_row = SAMPLE_TEST_SIZE / 2;
+      unsigned x = (quad % quads_per_row) * 2 + (i & 1);
+      unsigned y = (quad / quads_per_row) * 2 + ((i >> 1) & 1);
+      s[i] = (float)((x * cos_a - y * sin_a) * step + 0.1);
+      t[i] = (float)((x * sin_a + y * cos_a) * step + 0.2);
+   }
+
+   linear_texels = align_malloc(num_pixels * 4 * sizeof(float), 64);
+   tiled_texels = align_malloc(num_pixels * 4 * sizeof(float), 64);
+
+   memset(&texture, 0, sizeof texture);
+   texture.target = PIPE_TEXTURE_2D;
+   texture.format = test->format;
+   texture.width0 = test->size;
+   texture.height0 = test->size;
+   texture.depth0 = 1;
+   texture.array_size = 1;
+   texture.last_level = last_level;
+   texture.bind = PIPE_BIND_SAMPLER_VIEW;
+
+   memset(&view, 0, sizeof view);
+   view.texture = &texture;
+   view.target = PIPE_TEXTURE_2D;
+   view.format = test->format;
+   view.u.tex.last_level = last_level;
+   view.swizzle_r = PIPE_SWIZZLE_RED;
+   view.swizzle_g = PIPE_SWIZZLE_GREEN;
+   view.swizzle_b = PIPE_SWIZZLE_BLUE;
+   view.swizzle_a = PIPE_SWIZZLE_ALPHA;
+
+   memset(&sampler, 0, sizeof sampler);
+   sampler.wrap_s = PIPE_TEX_WRAP_REPEAT;
+   sampler.wrap_t = PIPE_TEX_WRAP_REPEAT;
+   sampler.wrap_r = PIPE_TEX_WRAP_REPEAT;
+   sampler.min_img_filter = PIPE_TEX_FILTER_LINEAR;
+   sampler.mag_img_filter = PIPE_TEX_FILTER_LINEAR;
+   sampler.min_mip_filter = PIPE_TEX_MIPFILTER_LINEAR;
+   sampler.normalized_coords = 1;
+   sampler.max_lod = (float)last_level;
+
+   jit_context->textures[0].base = linear_data;
+   linear_cycles = run_sample(test, jit_context, &view, &sampler,
+                              s, t, linear_texels, num_vectors);
+
+   texture.flags |= LP_RESOURCE_FLAG_TILED;
+   jit_context->textures[0].base = tiled_data;
+   tiled_cycles = run_sample(test, jit_context, &view, &sampler,
+                             s, t, tiled_texels, num_vectors);
+
+   success = memcmp(linear_texels, tiled_texels,
+                    num_pixels * 4 * sizeof(float)) == 0;
+
+   if (!success || verbose >= 3) {
+      if (verbose < 1)
+         fprintf(stderr, "%s size=%u lod=%.1f angle=%.0f ...\n",
+                 util_format_name(test->format), test->size,
+                 test->lod, test->angle);
+      fprintf(stderr, success ? "PASS\n" : "MISMATCH\n");
+   }
+
+   if (fp)
+      write_tsv_row(fp, test, linear_cycles, tiled_cycles, success);
+
+   align_free(tiled_texels);
+   align_free(linear_texels);
+   align_free(t);
+   align_free(s);
+   align_free(tiled_data);
+   align_free(linear_data);
+   align_free(jit_context);
+
+   return success;
+}
+
+
+static const struct sample_test_case sample_tests[] = {
+   /*   format,                      size,  lod, angle */
+   { PIPE_FORMAT_B8G8R8A8_UNORM,      256, 0.0f,  0.0f },
+   { PIPE_FORMAT_B8G8R8A8_UNORM,     1024, 0.0f, 30.0f },
+   { PIPE_FORMAT_B8G8R8A8_UNORM,     1024, 1.5f,  0.0f },
+   { PIPE_FORMAT_B8G8R8A8_UNORM,     1024, 1.5f, 30.0f },
+   { PIPE_FORMAT_B8G8R8A8_UNORM,     2048, 2.5f, 80.0f },
+   { PIPE_FORMAT_R32G32B32A32_FLOAT, 1024, 1.5f, 30.0f },
+   { PIPE_FORMAT_R16_UNORM,          2048, 2.5f, 80.0f },
+};
+
+
+boolean
+test_all(unsigned verbose, FILE *fp)
+{
+   boolean success = TRUE;
+   unsigned i;
+
+   for (i = 0; i < Elements(sample_tests); ++i) {
+      if (!test_one(verbose, fp, &sample_tests[i]))
+         success = FALSE;
+   }
+
+   return success;
+}
+
+
+boolean
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   boolean success = TRUE;
+   unsigned long i;
+
+   for (i = 0; i < n; ++i) {
+      if (!test_one(verbose, fp, &sample_tests[rand() % Elements(sample_tests)]))
+         success = FALSE;
+   }
+
+   return success;
+}
+
+
+boolean
+test_single(unsigned verbose, FILE *fp)
+{
+   return test_one(verbose, fp, &sample_tests[3]);
+}
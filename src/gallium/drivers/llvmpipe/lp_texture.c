@@ -198,6 +198,36 @@ llvmpipe_can_create_resource(struct pipe_screen *screen,
 }
 
 
+/**
+ * Whether to store the texture in tiles (see LP_RESOURCE_FLAG_TILED).
+ * Only done for textures which are exclusively sampled from, since
+ * the rasterizer and the display targets want linear images.
+ */
+static boolean
+llvmpipe_texture_use_tiling(const struct llvmpipe_screen *screen,
+                            const struct pipe_resource *pt)
+{
+   const struct util_format_description *desc;
+
+   if (!screen->tiled_textures)
+      return FALSE;
+
+   if (pt->bind != PIPE_BIND_SAMPLER_VIEW ||
+       (pt->flags & (PIPE_RESOURCE_FLAG_MAP_PERSISTENT |
+                     PIPE_RESOURCE_FLAG_MAP_COHERENT)) ||
+       pt->nr_samples > 1 ||
+       llvmpipe_resource_is_1d(pt))
+      return FALSE;
+
+   desc = util_format_description(pt->format);
+   if (desc->block.width != 1 || desc->block.height != 1 ||
+       desc->block.bits < 8 || !util_is_power_of_two(desc->block.bits))
+      return FALSE;
+
+   return TRUE;
+}
+
+
 static boolean
 llvmpipe_displaytarget_layout(struct llvmpipe_screen *screen,
                               struct llvmpipe_resource *lpr)
@@ -220,6 +250,8 @@ llvmpipe_displaytarget_layout(struct llvmpipe_screen *screen,
    if (lpr->dt == NULL)
       return FALSE;
 
+   pipe_mutex_init(lpr->dt_map_mutex);
+
    {
       void *map = winsys->displaytarget_map(winsys, lpr->dt,
                                             PIPE_TRANSFER_WRITE);
@@ -259,6 +291,8 @@ llvmpipe_resource_create(struct pipe_screen *_screen,
       }
       else {
          /* texture map */
+         if (llvmpipe_texture_use_tiling(screen, &lpr->base))
+            lpr->base.flags |= LP_RESOURCE_FLAG_TILED;
          if (!llvmpipe_texture_layout(screen, lpr, true))
             goto fail;
       }
@@ -312,7 +346,9 @@ llvmpipe_resource_destroy(struct pipe_screen *pscreen,
    if (lpr->dt) {
       /* display target */
       struct sw_winsys *winsys = screen->winsys;
+      assert(lpr->dt_map_count == 0);
       winsys->displaytarget_destroy(winsys, lpr->dt);
+      pipe_mutex_destroy(lpr->dt_map_mutex);
    }
    else if (llvmpipe_resource_is_texture(pt)) {
       /* free linear image data */
@@ -370,11 +406,22 @@ llvmpipe_resource_map(struct pipe_resource *resource,
       assert(level == 0);
       assert(layer == 0);
 
-      /* FIXME: keep map count? */
-      map = winsys->displaytarget_map(winsys, lpr->dt, dt_usage);
+      /* Scenes may map it from the rasterizer threads, while transfers map
+       * it from the application's.
+       */
+      pipe_mutex_lock(lpr->dt_map_mutex);
 
-      /* install this linear image in texture data structure */
-      lpr->tex_data = map;
+      if (lpr->dt_map_count == 0) {
+         /* install this linear image in texture data structure */
+         lpr->tex_data = winsys->displaytarget_map(winsys, lpr->dt, dt_usage);
+      }
+
+      /* callers don't unmap a failed map */
+      map = lpr->tex_data;
+      if (map)
+         lpr->dt_map_count++;
+
+      pipe_mutex_unlock(lpr->dt_map_mutex);
 
       return map;
    }
@@ -407,7 +454,15 @@ llvmpipe_resource_unmap(struct pipe_resource *resource,
       assert(level == 0);
       assert(layer == 0);
 
-      winsys->displaytarget_unmap(winsys, lpr->dt);
+      pipe_mutex_lock(lpr->dt_map_mutex);
+
+      assert(lpr->dt_map_count > 0);
+      if (--lpr->dt_map_count == 0) {
+         winsys->displaytarget_unmap(winsys, lpr->dt);
+         lpr->tex_data = NULL;
+      }
+
+      pipe_mutex_unlock(lpr->dt_map_mutex);
    }
 }
 
@@ -459,6 +514,8 @@ llvmpipe_resource_from_handle(struct pipe_screen *screen,
       goto no_dt;
    }
 
+   pipe_mutex_init(lpr->dt_map_mutex);
+
    lpr->id = id_counter++;
 
 #ifdef DEBUG
@@ -490,6 +547,60 @@ llvmpipe_resource_get_handle(struct pipe_screen *screen,
 }
 
 
+/**
+ * Map a box of a tiled texture through a linear staging copy.
+ */
+static void *
+llvmpipe_transfer_map_tiled(struct llvmpipe_transfer *lpt,
+                            unsigned usage,
+                            struct pipe_transfer **transfer)
+{
+   struct pipe_transfer *pt = &lpt->base;
+   struct llvmpipe_resource *lpr = llvmpipe_resource(pt->resource);
+   const struct pipe_box *box = &pt->box;
+   unsigned bpp = util_format_get_blocksize(lpr->base.format);
+   unsigned layer;
+
+   if (usage & PIPE_TRANSFER_MAP_DIRECTLY) {
+      goto fail;
+   }
+
+   pt->stride = align(box->width * bpp, 16);
+   pt->layer_stride = pt->stride * box->height;
+
+   lpt->staging = align_malloc(pt->layer_stride * box->depth, 64);
+   if (!lpt->staging) {
+      goto fail;
+   }
+
+   if (!(usage & (PIPE_TRANSFER_DISCARD_RANGE |
+                  PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE))) {
+      for (layer = 0; layer < box->depth; layer++) {
+         const ubyte *image =
+            llvmpipe_get_texture_image_address(lpr, box->z + layer, pt->level);
+         llvmpipe_untile_image((ubyte *)lpt->staging + layer * pt->layer_stride,
+                               pt->stride,
+                               image, lpr->row_stride[pt->level],
+                               box->x, box->y, box->width, box->height,
+                               bpp);
+      }
+   }
+
+   if (usage & PIPE_TRANSFER_WRITE) {
+      struct llvmpipe_screen *screen = llvmpipe_screen(lpr->base.screen);
+      screen->timestamp++;
+   }
+
+   return lpt->staging;
+
+fail:
+   pipe_resource_reference(&pt->resource, NULL);
+   FREE(lpt);
+   *transfer = NULL;
+   return NULL;
+}
+
+
 static void *
 llvmpipe_transfer_map( struct pipe_context *pipe,
                        struct pipe_resource *resource,
@@ -557,6 +668,10 @@ llvmpipe_transfer_map( struct pipe_context *pipe,
    pt->usage = usage;
    *transfer = pt;
 
+   if (llvmpipe_resource_is_tiled(resource)) {
+      return llvmpipe_transfer_map_tiled(lpt, usage, transfer);
+   }
+
    assert(level < LP_MAX_TEXTURE_LEVELS);
 
    /*
@@ -609,15 +724,43 @@ static void
 llvmpipe_transfer_unmap(struct pipe_context *pipe,
                         struct pipe_transfer *transfer)
 {
+   struct llvmpipe_transfer *lpt = llvmpipe_transfer(transfer);
+
    assert(transfer->resource);
 
-   llvmpipe_resource_unmap(transfer->resource,
-                           transfer->level,
-                           transfer->box.z);
+   if (lpt->staging) {
+      /* write back the linear copy of a tiled texture */
+      struct llvmpipe_resource *lpr = llvmpipe_resource(transfer->resource);
+      const struct pipe_box *box = &transfer->box;
+      unsigned bpp = util_format_get_blocksize(lpr->base.format);
+      unsigned layer;
+
+      if (transfer->usage & PIPE_TRANSFER_WRITE) {
+         for (layer = 0; layer < box->depth; layer++) {
+            ubyte *image =
+               llvmpipe_get_texture_image_address(lpr, box->z + layer,
+                                                  transfer->level);
+            llvmpipe_tile_image(image, lpr->row_stride[transfer->level],
+                                (const ubyte *)lpt->staging +
+                                   layer * transfer->layer_stride,
+                                transfer->stride,
+                                box->x, box->y, box->width, box->height,
+                                bpp);
+         }
+      }
+
+      align_free(lpt->staging);
+   }
+   else {
+      llvmpipe_resource_unmap(transfer->resource,
+                              transfer->level,
+                              transfer->box.z);
+   }
 
    /* Effectively do the texture_update work here - if texture images
     * needed post-processing to put them into hardware layout, this is
-    * where it would happen.  For llvmpipe, nothing to do.
+    * where it would happen.  For llvmpipe, only tiled textures need it
+    * and that was done above.
     */
    assert (transfer->resource);
    pipe_resource_reference(&transfer->resource, NULL);
@@ -639,7 +782,8 @@ llvmpipe_is_resource_referenced( struct pipe_context *pipe,
     */
    if (!(presource->bind & (PIPE_BIND_DEPTH_STENCIL |
                             PIPE_BIND_RENDER_TARGET |
-                            PIPE_BIND_SAMPLER_VIEW)))
+                            PIPE_BIND_SAMPLER_VIEW |
+                            PIPE_BIND_COMPUTE_RESOURCE)))
       return LP_UNREFERENCED;
 
    return lp_setup_is_resource_referenced(llvmpipe->setup, presource);
@@ -739,6 +883,82 @@ llvmpipe_get_texture_image_address(struct llvmpipe_resource *lpr,
 }
 
 
+/**
+ * Byte offset of texel (x, y) in an image stored in tiles.
+ */
+static INLINE unsigned
+tiled_texel_offset(unsigned x, unsigned y,
+                   unsigned row_stride, unsigned bpp)
+{
+   const unsigned mask = LP_TEX_TILE_SIZE - 1;
+
+   return (y & ~mask) * row_stride +
+          (y & mask) * LP_TEX_TILE_SIZE * bpp +
+          (x & ~mask) * LP_TEX_TILE_SIZE * bpp +
+          (x & mask) * bpp;
+}
+
+
+/**
+ * Copy a linear rectangle into an image stored in tiles.
+ *
+ * \param dst  start of the tiled image
+ * \param src  start of the linear rectangle
+ * \param x, y  position of the rectangle in the tiled image
+ */
+void
+llvmpipe_tile_image(ubyte *dst, unsigned dst_row_stride,
+                    const ubyte *src, unsigned src_stride,
+                    unsigned x, unsigned y,
+                    unsigned width, unsigned height,
+                    unsigned bpp)
+{
+   unsigned i, j, n;
+
+   for (j = 0; j < height; j++) {
+      const ubyte *src_row = src + j * src_stride;
+
+      /* texels are contiguous up to the next tile boundary */
+      for (i = 0; i < width; i += n) {
+         unsigned tx = x + i;
+         n = MIN2(LP_TEX_TILE_SIZE - (tx & (LP_TEX_TILE_SIZE - 1)), width - i);
+         memcpy(dst + tiled_texel_offset(tx, y + j, dst_row_stride, bpp),
+                src_row + i * bpp, n * bpp);
+      }
+   }
+}
+
+
+/**
+ * Copy a rectangle of an image stored in tiles into a linear buffer.
+ *
+ * \param dst  start of the linear rectangle
+ * \param src  start of the tiled image
+ * \param x, y  position of the rectangle in the tiled image
+ */
+void
+llvmpipe_untile_image(ubyte *dst, unsigned dst_stride,
+                      const ubyte *src, unsigned src_row_stride,
+                      unsigned x, unsigned y,
+                      unsigned width, unsigned height,
+                      unsigned bpp)
+{
+   unsigned i, j, n;
+
+   for (j = 0; j < height; j++) {
+      ubyte *dst_row = dst + j * dst_stride;
+
+      for (i = 0; i < width; i += n) {
+         unsigned tx = x + i;
+         n = MIN2(LP_TEX_TILE_SIZE - (tx & (LP_TEX_TILE_SIZE - 1)), width - i);
+         memcpy(dst_row + i * bpp,
+                src + tiled_texel_offset(tx, y + j, src_row_stride, bpp),
+                n * bpp);
+      }
+   }
+}
+
+
 /**
  * Return size of resource in bytes
  */
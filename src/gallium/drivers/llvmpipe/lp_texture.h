@@ -30,7 +30,9 @@
 
 
 #include "pipe/p_state.h"
+#include "os/os_thread.h"
 #include "util/u_debug.h"
+#include "gallivm/lp_bld_sample.h"
 #include "lp_limits.h"
 
 
@@ -75,6 +77,14 @@ struct llvmpipe_resource
     */
    struct sw_displaytarget *dt;
 
+   /**
+    * Number of outstanding llvmpipe_resource_map() calls on dt.  Several
+    * scenes may be rasterizing into the same display target, so it is only
+    * unmapped once the last of them is done with it.
+    */
+   unsigned dt_map_count;
+   pipe_mutex dt_map_mutex;  /**< protects dt_map_count and tex_data */
+
    /**
     * Malloc'ed data for regular textures, or a mapping to dt above.
     */
@@ -102,6 +112,9 @@ struct llvmpipe_transfer
    struct pipe_transfer base;
 
    unsigned long offset;
+
+   /** Linear copy of the box, for resources stored in tiles */
+   void *staging;
 };
 
 
@@ -175,6 +188,17 @@ llvmpipe_resource_is_1d(const struct pipe_resource *resource)
 }
 
 
+/**
+ * Whether the texture images are stored in tiles rather than linearly,
+ * see LP_RESOURCE_FLAG_TILED.
+ */
+static INLINE boolean
+llvmpipe_resource_is_tiled(const struct pipe_resource *resource)
+{
+   return (resource->flags & LP_RESOURCE_FLAG_TILED) != 0;
+}
+
+
 static INLINE unsigned
 llvmpipe_layer_stride(struct pipe_resource *resource,
                       unsigned level)
@@ -220,6 +244,21 @@ llvmpipe_get_texture_image_address(struct llvmpipe_resource *lpr,
                                    unsigned face_slice, unsigned level);
 
 
+void
+llvmpipe_tile_image(ubyte *dst, unsigned dst_row_stride,
+                    const ubyte *src, unsigned src_stride,
+                    unsigned x, unsigned y,
+                    unsigned width, unsigned height,
+                    unsigned bpp);
+
+void
+llvmpipe_untile_image(ubyte *dst, unsigned dst_stride,
+                      const ubyte *src, unsigned src_row_stride,
+                      unsigned x, unsigned y,
+                      unsigned width, unsigned height,
+                      unsigned bpp);
+
+
 extern void
 llvmpipe_print_resources(void);
 
@@ -670,6 +670,8 @@ static int r600_get_driver_query_info(struct pipe_screen *screen,
 		{"num-bytes-moved", R600_QUERY_NUM_BYTES_MOVED, {0}, PIPE_DRIVER_QUERY_TYPE_BYTES},
 		{"VRAM-usage", R600_QUERY_VRAM_USAGE, {rscreen->info.vram_size}, PIPE_DRIVER_QUERY_TYPE_BYTES},
 		{"GTT-usage", R600_QUERY_GTT_USAGE, {rscreen->info.gart_size}, PIPE_DRIVER_QUERY_TYPE_BYTES},
+		{"buffer-cache-hit-rate", R600_QUERY_BUFFER_CACHE_HIT_RATE, {100}, PIPE_DRIVER_QUERY_TYPE_PERCENTAGE},
+		{"buffer-cache-size", R600_QUERY_BUFFER_CACHE_SIZE, {0}, PIPE_DRIVER_QUERY_TYPE_BYTES},
 		{"temperature", R600_QUERY_GPU_TEMPERATURE, {100}},
 		{"shader-clock", R600_QUERY_CURRENT_GPU_SCLK, {0}},
 		{"memory-clock", R600_QUERY_CURRENT_GPU_MCLK, {0}},
@@ -680,7 +682,7 @@ static int r600_get_driver_query_info(struct pipe_screen *screen,
 	if (rscreen->info.drm_major == 2 && rscreen->info.drm_minor >= 42)
 		num_queries = Elements(list);
 	else
-		num_queries = 8;
+		num_queries = 10;
 
 	if (!info)
 		return num_queries;
@@ -90,6 +90,8 @@ static struct r600_resource *r600_new_query_buffer(struct r600_common_context *c
 	case R600_QUERY_CURRENT_GPU_SCLK:
 	case R600_QUERY_CURRENT_GPU_MCLK:
 	case R600_QUERY_GPU_LOAD:
+	case R600_QUERY_BUFFER_CACHE_HIT_RATE:
+	case R600_QUERY_BUFFER_CACHE_SIZE:
 		return NULL;
 	}
 
@@ -390,6 +392,8 @@ static struct pipe_query *r600_create_query(struct pipe_context *ctx, unsigned q
 	case R600_QUERY_CURRENT_GPU_SCLK:
 	case R600_QUERY_CURRENT_GPU_MCLK:
 	case R600_QUERY_GPU_LOAD:
+	case R600_QUERY_BUFFER_CACHE_HIT_RATE:
+	case R600_QUERY_BUFFER_CACHE_SIZE:
 		skip_allocation = true;
 		break;
 	default:
@@ -425,6 +429,27 @@ static void r600_destroy_query(struct pipe_context *ctx, struct pipe_query *quer
 	FREE(query);
 }
 
+/* The buffer cache hits are in the lower 32 bits.
+ * The misses are in the upper 32 bits. */
+static uint64_t r600_buffer_cache_read_counters(struct r600_common_context *rctx)
+{
+	return (rctx->ws->query_value(rctx->ws, RADEON_BUFFER_CACHE_HITS) & 0xffffffff) |
+	       (rctx->ws->query_value(rctx->ws, RADEON_BUFFER_CACHE_MISSES) << 32);
+}
+
+static unsigned r600_buffer_cache_hit_rate(struct r600_common_context *rctx,
+					   uint64_t begin)
+{
+	uint64_t end = r600_buffer_cache_read_counters(rctx);
+	unsigned hits = (end & 0xffffffff) - (begin & 0xffffffff);
+	unsigned misses = (end >> 32) - (begin >> 32);
+
+	if (hits || misses)
+		return (uint64_t)hits * 100 / ((uint64_t)hits + misses);
+	else
+		return 0;
+}
+
 static boolean r600_begin_query(struct pipe_context *ctx,
                                 struct pipe_query *query)
 {
@@ -451,6 +476,7 @@ static boolean r600_begin_query(struct pipe_context *ctx,
 	case R600_QUERY_GPU_TEMPERATURE:
 	case R600_QUERY_CURRENT_GPU_SCLK:
 	case R600_QUERY_CURRENT_GPU_MCLK:
+	case R600_QUERY_BUFFER_CACHE_SIZE:
 		rquery->begin_result = 0;
 		return true;
 	case R600_QUERY_BUFFER_WAIT_TIME:
@@ -465,6 +491,9 @@ static boolean r600_begin_query(struct pipe_context *ctx,
 	case R600_QUERY_GPU_LOAD:
 		rquery->begin_result = r600_gpu_load_begin(rctx->screen);
 		return true;
+	case R600_QUERY_BUFFER_CACHE_HIT_RATE:
+		rquery->begin_result = r600_buffer_cache_read_counters(rctx);
+		return true;
 	}
 
 	/* Discard the old query buffers. */
@@ -541,6 +570,12 @@ static void r600_end_query(struct pipe_context *ctx, struct pipe_query *query)
 	case R600_QUERY_GPU_LOAD:
 		rquery->end_result = r600_gpu_load_end(rctx->screen, rquery->begin_result);
 		return;
+	case R600_QUERY_BUFFER_CACHE_HIT_RATE:
+		rquery->end_result = r600_buffer_cache_hit_rate(rctx, rquery->begin_result);
+		return;
+	case R600_QUERY_BUFFER_CACHE_SIZE:
+		rquery->end_result = rctx->ws->query_value(rctx->ws, RADEON_BUFFER_CACHE_SIZE);
+		return;
 	}
 
 	r600_emit_query_end(rctx, rquery);
@@ -601,9 +636,11 @@ static boolean r600_get_query_buffer_result(struct r600_common_context *ctx,
 	case R600_QUERY_GPU_TEMPERATURE:
 	case R600_QUERY_CURRENT_GPU_SCLK:
 	case R600_QUERY_CURRENT_GPU_MCLK:
+	case R600_QUERY_BUFFER_CACHE_SIZE:
 		result->u64 = query->end_result - query->begin_result;
 		return TRUE;
 	case R600_QUERY_GPU_LOAD:
+	case R600_QUERY_BUFFER_CACHE_HIT_RATE:
 		result->u64 = query->end_result;
 		return TRUE;
 	}
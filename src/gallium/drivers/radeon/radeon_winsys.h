@@ -171,7 +171,10 @@ enum radeon_value_id {
     RADEON_GTT_USAGE,
     RADEON_GPU_TEMPERATURE,
     RADEON_CURRENT_SCLK,
-    RADEON_CURRENT_MCLK
+    RADEON_CURRENT_MCLK,
+    RADEON_BUFFER_CACHE_HITS,
+    RADEON_BUFFER_CACHE_MISSES,
+    RADEON_BUFFER_CACHE_SIZE
 };
 
 enum radeon_bo_priority {
@@ -39,6 +39,7 @@
 #include "sp_context.h"
 #include "sp_query.h"
 #include "sp_tile_cache.h"
+#include "sp_tile_threads.h"
 
 
 /**
@@ -67,8 +68,14 @@ softpipe_clear(struct pipe_context *pipe, unsigned buffers,
 #endif
 
    if (buffers & PIPE_CLEAR_COLOR) {
-      for (i = 0; i < softpipe->framebuffer.nr_cbufs; i++) {
-         sp_tile_cache_clear(softpipe->cbuf_cache[i], color, 0);
+      if (softpipe->tile_threads) {
+         sp_tile_threads_clear(softpipe->tile_threads, PIPE_CLEAR_COLOR,
+                               color, 0);
+      }
+      else {
+         for (i = 0; i < softpipe->framebuffer.nr_cbufs; i++) {
+            sp_tile_cache_clear(softpipe->cbuf_cache[i], color, 0);
+         }
       }
    }
 
@@ -83,7 +90,12 @@ softpipe_clear(struct pipe_context *pipe, unsigned buffers,
       static const union pipe_color_union zero;
 
       cv = util_pack64_z_stencil(zsbuf->format, depth, stencil);
-      sp_tile_cache_clear(softpipe->zsbuf_cache, &zero, cv);
+
+      if (softpipe->tile_threads)
+         sp_tile_threads_clear(softpipe->tile_threads,
+                               PIPE_CLEAR_DEPTHSTENCIL, &zero, cv);
+      else
+         sp_tile_cache_clear(softpipe->zsbuf_cache, &zero, cv);
    }
 
    softpipe->dirty_render_cache = TRUE;
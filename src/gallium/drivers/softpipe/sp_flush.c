@@ -38,6 +38,7 @@
 #include "sp_state.h"
 #include "sp_tile_cache.h"
 #include "sp_tex_tile_cache.h"
+#include "sp_tile_threads.h"
 #include "util/u_memory.h"
 #include "util/u_string.h"
 
@@ -62,6 +63,9 @@ softpipe_flush( struct pipe_context *pipe,
       }
    }
 
+   if (softpipe->tile_threads)
+      sp_tile_threads_flush(softpipe->tile_threads, flags);
+
    /* If this is a swapbuffers, just flush color buffers.
     *
     * The zbuffer changes are not discarded, but held in the cache
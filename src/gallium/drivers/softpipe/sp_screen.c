@@ -29,6 +29,7 @@
 #include "util/u_memory.h"
 #include "util/u_format.h"
 #include "util/u_format_s3tc.h"
+#include "util/u_math.h"
 #include "util/u_video.h"
 #include "os/os_misc.h"
 #include "os/os_time.h"
@@ -43,6 +44,7 @@
 #include "sp_screen.h"
 #include "sp_context.h"
 #include "sp_fence.h"
+#include "sp_limits.h"
 #include "sp_public.h"
 
 DEBUG_GET_ONCE_BOOL_OPTION(use_llvm, "SOFTPIPE_USE_LLVM", FALSE)
@@ -443,6 +445,10 @@ softpipe_create_screen(struct sw_winsys *winsys)
 
    screen->use_llvm = debug_get_option_use_llvm();
 
+   /* Threads only pay off for large draws, so they are opt-in. */
+   screen->num_threads = debug_get_num_option("SOFTPIPE_NUM_THREADS", 0);
+   screen->num_threads = MIN2(screen->num_threads, SP_MAX_THREADS);
+
    util_format_s3tc_init();
 
    softpipe_init_screen_texture_funcs(&screen->base);
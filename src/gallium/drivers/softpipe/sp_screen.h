@@ -47,6 +47,9 @@ struct softpipe_screen {
     */
    unsigned timestamp;
    boolean use_llvm;
+
+   /** Number of tile rasterization threads per context, 0 for none */
+   unsigned num_threads;
 };
 
 static INLINE struct softpipe_screen *
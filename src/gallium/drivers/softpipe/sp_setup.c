@@ -37,6 +37,7 @@
 #include "sp_quad_pipe.h"
 #include "sp_setup.h"
 #include "sp_state.h"
+#include "sp_tile_threads.h"
 #include "draw/draw_context.h"
 #include "draw/draw_vertex.h"
 #include "pipe/p_shader_tokens.h"
@@ -60,12 +61,6 @@ struct edge {
 };
 
 
-/**
- * Max number of quads (2x2 pixel blocks) to process per batch.
- * This can't be arbitrarily increased since we depend on some 32-bit
- * bitmasks (two bits per quad).
- */
-#define MAX_QUADS 16
 
 
 /**
@@ -153,6 +148,23 @@ quad_clip(struct setup_context *setup, struct quad_header *quad)
 }
 
 
+/**
+ * Pass a batch of quads to the quad pipeline, or bin them for the tile
+ * rasterization threads.
+ */
+static INLINE void
+emit_quads(struct setup_context *setup, struct quad_header *quads[],
+           unsigned nr)
+{
+   struct softpipe_context *sp = setup->softpipe;
+
+   if (sp->tile_threads)
+      sp_tile_threads_bin_quads(sp->tile_threads, quads, nr);
+   else
+      sp->quad.first->run(sp->quad.first, quads, nr);
+}
+
+
 /**
  * Emit a quad (pass to next stage) with clipping.
  */
@@ -162,13 +174,11 @@ clip_emit_quad(struct setup_context *setup, struct quad_header *quad)
    quad_clip( setup, quad );
 
    if (quad->inout.mask) {
-      struct softpipe_context *sp = setup->softpipe;
-
 #if DEBUG_FRAGS
       setup->numFragsEmitted += util_bitcount(quad->inout.mask);
 #endif
 
-      sp->quad.first->run( sp->quad.first, &quad, 1 );
+      emit_quads( setup, &quad, 1 );
    }
 }
 
@@ -203,8 +213,6 @@ flush_spans(struct setup_context *setup)
    const int xleft1 = setup->span.left[1];
    const int xright0 = setup->span.right[0];
    const int xright1 = setup->span.right[1];
-   struct quad_stage *pipe = setup->softpipe->quad.first;
-
    const int minleft = block_x(MIN2(xleft0, xleft1));
    const int maxright = MAX2(xright0, xright1);
    int x;
@@ -248,7 +256,7 @@ flush_spans(struct setup_context *setup)
             lx += 2;
          } while (mask0 | mask1);
 
-         pipe->run( pipe, setup->quad_ptrs, q );
+         emit_quads( setup, setup->quad_ptrs, q );
       }
    }
 
@@ -816,6 +824,9 @@ sp_setup_tri(struct setup_context *setup,
 
    if (setup->softpipe->no_rast || setup->softpipe->rasterizer->rasterizer_discard)
       return;
+
+   if (setup->softpipe->tile_threads)
+      sp_tile_threads_new_primitive(setup->softpipe->tile_threads);
    
    det = calc_det(v0, v1, v2);
    /*
@@ -1093,6 +1104,9 @@ sp_setup_line(struct setup_context *setup,
    if (setup->softpipe->no_rast || setup->softpipe->rasterizer->rasterizer_discard)
       return;
 
+   if (setup->softpipe->tile_threads)
+      sp_tile_threads_new_primitive(setup->softpipe->tile_threads);
+
    if (dx == 0 && dy == 0)
       return;
 
@@ -1231,6 +1245,9 @@ sp_setup_point(struct setup_context *setup,
    if (setup->softpipe->no_rast || setup->softpipe->rasterizer->rasterizer_discard)
       return;
 
+   if (setup->softpipe->tile_threads)
+      sp_tile_threads_new_primitive(setup->softpipe->tile_threads);
+
    assert(setup->softpipe->reduced_prim == PIPE_PRIM_POINTS);
 
    if (setup->softpipe->layer_slot > 0) {
@@ -31,6 +31,7 @@
 #include "sp_context.h"
 #include "sp_state.h"
 #include "sp_tile_cache.h"
+#include "sp_tile_threads.h"
 
 #include "draw/draw_context.h"
 
@@ -53,6 +54,9 @@ softpipe_set_framebuffer_state(struct pipe_context *pipe,
 
    draw_flush(sp->draw);
 
+   if (sp->tile_threads)
+      sp_tile_threads_set_framebuffer(sp->tile_threads, fb);
+
    for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++) {
       struct pipe_surface *cb = i < fb->nr_cbufs ? fb->cbufs[i] : NULL;
 
@@ -42,16 +42,6 @@ static struct softpipe_cached_tile *
 sp_alloc_tile(struct softpipe_tile_cache *tc);
 
 
-/**
- * Return the position in the cache for the tile that contains win pos (x,y).
- * We currently use a direct mapped cache so this is like a hack key.
- * At some point we should investige something more sophisticated, like
- * a LRU replacement policy.
- */
-#define CACHE_POS(x, y, l)                        \
-   (((x) + (y) * 5 + (l) * 10) % NUM_ENTRIES)
-
-
 static INLINE int addr_to_clear_pos(union tile_address addr)
 {
    int pos;
@@ -85,6 +75,19 @@ clear_clear_flag(uint *bitvec, union tile_address addr, unsigned max)
    assert(pos / 32 < max);
    bitvec[pos / 32] &= ~(1 << (pos & 31));
 }
+
+
+/**
+ * Mark the tile at (x,y) as cleared.
+ */
+static INLINE void
+set_clear_flag(uint *bitvec, union tile_address addr, unsigned max)
+{
+   int pos;
+   pos = addr_to_clear_pos(addr);
+   assert(pos / 32 < max);
+   bitvec[pos / 32] |= (1 << (pos & 31));
+}
    
 
 struct softpipe_tile_cache *
@@ -649,3 +652,45 @@ sp_tile_cache_clear(struct softpipe_tile_cache *tc,
    }
    tc->last_tile_addr.bits.invalid = 1;
 }
+
+
+/**
+ * Like sp_tile_cache_clear(), but only clear the tiles which go in the
+ * cache positions equal to \p part modulo \p num_parts.  Tile caches which
+ * split a surface between them this way can each clear their part of it
+ * without overwriting the tiles of the others when flushed.
+ */
+void
+sp_tile_cache_clear_part(struct softpipe_tile_cache *tc,
+                         const union pipe_color_union *color,
+                         uint64_t clearValue,
+                         unsigned part, unsigned num_parts)
+{
+   uint pos;
+   int layer;
+
+   tc->clear_color = *color;
+
+   tc->clear_val = clearValue;
+
+   /* set flags to indicate the tiles of the part are cleared */
+   for (layer = 0; layer < tc->num_maps; layer++) {
+      const uint w = tc->transfer[layer]->box.width;
+      const uint h = tc->transfer[layer]->box.height;
+      uint x, y;
+
+      for (y = 0; y < h; y += TILE_SIZE) {
+         for (x = 0; x < w; x += TILE_SIZE) {
+            union tile_address addr = tile_address(x, y, layer);
+
+            if (CACHE_POS(addr.bits.x, addr.bits.y, layer) % num_parts == part)
+               set_clear_flag(tc->clear_flags, addr, tc->clear_flags_size);
+         }
+      }
+   }
+
+   for (pos = part; pos < Elements(tc->tile_addrs); pos += num_parts) {
+      tc->tile_addrs[pos].bits.invalid = 1;
+   }
+   tc->last_tile_addr.bits.invalid = 1;
+}
@@ -78,6 +78,15 @@ struct softpipe_cached_tile
 
 #define NUM_ENTRIES 50
 
+/**
+ * Return the position in the cache for the tile that contains win pos (x,y).
+ * We currently use a direct mapped cache so this is like a hack key.
+ * At some point we should investige something more sophisticated, like
+ * a LRU replacement policy.
+ */
+#define CACHE_POS(x, y, l)                        \
+   (((x) + (y) * 5 + (l) * 10) % NUM_ENTRIES)
+
 
 struct softpipe_tile_cache
 {
@@ -123,6 +132,12 @@ sp_tile_cache_clear(struct softpipe_tile_cache *tc,
                     const union pipe_color_union *color,
                     uint64_t clearValue);
 
+extern void
+sp_tile_cache_clear_part(struct softpipe_tile_cache *tc,
+                         const union pipe_color_union *color,
+                         uint64_t clearValue,
+                         unsigned part, unsigned num_parts);
+
 extern struct softpipe_cached_tile *
 sp_find_cached_tile(struct softpipe_tile_cache *tc, 
                     union tile_address addr );
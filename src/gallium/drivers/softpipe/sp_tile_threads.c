@@ -0,0 +1,605 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * Tile-parallel quad rendering, see sp_tile_threads.h.
+ *
+ * The threads only ever run while the context waits for them at the end of
+ * a draw, so they can read the context's state without locking.  What they
+ * write -- shader machines, texture and surface tile caches, query
+ * counters -- is per thread.
+ *
+ * Each thread owns the screen tiles which go in some of the positions of
+ * the direct mapped tile caches, and clears only those in its own caches.
+ * So every thread's caches see the same sequence of tile accesses, clears
+ * and evictions for their positions as the context's caches would when
+ * drawing serially, which keeps even the rounding of the color values kept
+ * in the tiles the same.  The context's own surface tile caches go unused.
+ */
+
+
+#include "pipe/p_defines.h"
+#include "os/os_thread.h"
+#include "tgsi/tgsi_exec.h"
+#include "util/u_memory.h"
+#include "util/u_string.h"
+#include "sp_context.h"
+#include "sp_flush.h"
+#include "sp_limits.h"
+#include "sp_quad.h"
+#include "sp_quad_pipe.h"
+#include "sp_state.h"
+#include "sp_tex_sample.h"
+#include "sp_tex_tile_cache.h"
+#include "sp_texture.h"
+#include "sp_tile_cache.h"
+#include "sp_tile_threads.h"
+
+
+/** Max number of quads binned to each thread before the threads are run */
+#define BIN_SIZE 8192
+
+/** Max number of interpolation coefficients held by the binned primitives */
+#define COEF_ARENA_SIZE 4096
+
+/**
+ * Min number of binned quads, and of threads with quads, for which waking
+ * the threads up is worth it.  Fewer are rendered on the calling thread.
+ */
+#define MIN_THREADED_QUADS 1024
+#define MIN_THREADED_BINS 2
+
+
+/**
+ * A binned quad.  The first quad of each batch also says how many quads
+ * there are in the batch and where the coefficients of its primitive are.
+ */
+struct binned_quad {
+   struct quad_header_input input;
+   unsigned mask;
+   unsigned nr;
+   const struct tgsi_interp_coef *coef;
+   const struct tgsi_interp_coef *posCoef;
+};
+
+
+struct sp_tile_thread {
+   struct sp_tile_threads *threads;
+   unsigned index;
+
+   pipe_thread thread;
+   pipe_semaphore work_ready;
+   pipe_semaphore work_done;
+
+   struct quad_pipeline quad;
+   struct sp_tgsi_sampler *fs_sampler;
+   struct softpipe_tex_tile_cache *tex_cache[PIPE_MAX_SHADER_SAMPLER_VIEWS];
+
+   uint64_t occlusion_count;
+   uint64_t ps_invocations;
+
+   struct binned_quad *bin;
+   unsigned bin_size;
+
+   struct quad_header quads[MAX_QUADS];
+   struct quad_header *quad_ptrs[MAX_QUADS];
+};
+
+
+struct sp_tile_threads {
+   struct softpipe_context *softpipe;
+
+   unsigned num_threads;
+   struct sp_tile_thread thread[SP_MAX_THREADS];
+   boolean exit_flag;
+
+   /** Copies of the coefficients of the binned primitives */
+   struct tgsi_interp_coef *coef_arena;
+   unsigned coef_arena_used;
+
+   /** The copy of the current primitive's coefficients, if made yet */
+   const struct tgsi_interp_coef *prim_coef;
+   const struct tgsi_interp_coef *prim_pos_coef;
+
+   unsigned num_binned;
+};
+
+
+/**
+ * Run the quads binned to the thread through its quad pipeline.
+ */
+static void
+rasterize_bin(struct sp_tile_thread *t)
+{
+   struct quad_stage *first = t->quad.first;
+   const struct binned_quad *bq = t->bin;
+   const struct binned_quad *end = t->bin + t->bin_size;
+
+   while (bq < end) {
+      const unsigned nr = bq->nr;
+      unsigned i;
+
+      for (i = 0; i < nr; i++) {
+         t->quads[i].input = bq[i].input;
+         t->quads[i].inout.mask = bq[i].mask;
+         t->quads[i].coef = bq->coef;
+         t->quads[i].posCoef = bq->posCoef;
+         /* the stages compact this array as they drop quads */
+         t->quad_ptrs[i] = &t->quads[i];
+      }
+
+      first->run(first, t->quad_ptrs, nr);
+      bq += nr;
+   }
+}
+
+
+static PIPE_THREAD_ROUTINE( thread_function, init_data )
+{
+   struct sp_tile_thread *t = (struct sp_tile_thread *) init_data;
+   char thread_name[16];
+
+   util_snprintf(thread_name, sizeof thread_name, "softpipe-%u", t->index);
+   pipe_thread_setname(thread_name);
+
+   while (1) {
+      pipe_semaphore_wait(&t->work_ready);
+
+      if (t->threads->exit_flag)
+         break;
+
+      rasterize_bin(t);
+
+      pipe_semaphore_signal(&t->work_done);
+   }
+
+   return 0;
+}
+
+
+/**
+ * Bring the thread's quad pipeline, shader machine and fragment texture
+ * caches up to date with the context's state.
+ */
+static void
+prepare_thread(struct softpipe_context *sp, struct sp_tile_thread *t)
+{
+   const struct sp_tgsi_sampler *sampler =
+      sp->tgsi.sampler[PIPE_SHADER_FRAGMENT];
+   unsigned i;
+
+   memcpy(t->fs_sampler->sp_sampler, sampler->sp_sampler,
+          sizeof(sampler->sp_sampler));
+   memcpy(t->fs_sampler->sp_sview, sampler->sp_sview,
+          sizeof(sampler->sp_sview));
+
+   for (i = 0; i < PIPE_MAX_SHADER_SAMPLER_VIEWS; i++) {
+      struct softpipe_tex_tile_cache *tc = t->tex_cache[i];
+
+      sp_tex_tile_cache_set_sampler_view(tc,
+                             sp->sampler_views[PIPE_SHADER_FRAGMENT][i]);
+      t->fs_sampler->sp_sview[i].cache = tc;
+
+      if (tc->texture) {
+         struct softpipe_resource *spr = softpipe_resource(tc->texture);
+         if (spr->timestamp != tc->timestamp) {
+            sp_tex_tile_cache_validate_texture(tc);
+            tc->timestamp = spr->timestamp;
+         }
+      }
+   }
+
+   if (t->quad.fs_machine->Tokens != sp->fs_variant->tokens) {
+      sp->fs_variant->prepare(sp->fs_variant, t->quad.fs_machine,
+                              (struct tgsi_sampler *) t->fs_sampler);
+   }
+
+   sp_build_quad_pipeline(sp, &t->quad);
+   t->quad.first->begin(t->quad.first);
+}
+
+
+static boolean
+init_thread(struct softpipe_context *sp, struct sp_tile_thread *t)
+{
+   unsigned i;
+
+   if (!sp_create_quad_pipeline(sp, &t->quad))
+      return FALSE;
+
+   t->quad.fs_machine = tgsi_exec_machine_create();
+   if (!t->quad.fs_machine)
+      return FALSE;
+
+   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++) {
+      t->quad.cbuf_cache[i] = sp_create_tile_cache(&sp->pipe);
+      if (!t->quad.cbuf_cache[i])
+         return FALSE;
+   }
+
+   t->quad.zsbuf_cache = sp_create_tile_cache(&sp->pipe);
+   if (!t->quad.zsbuf_cache)
+      return FALSE;
+
+   t->quad.occlusion_count = &t->occlusion_count;
+   t->quad.ps_invocations = &t->ps_invocations;
+
+   t->fs_sampler = sp_create_tgsi_sampler();
+   if (!t->fs_sampler)
+      return FALSE;
+
+   for (i = 0; i < PIPE_MAX_SHADER_SAMPLER_VIEWS; i++) {
+      t->tex_cache[i] = sp_create_tex_tile_cache(&sp->pipe);
+      if (!t->tex_cache[i])
+         return FALSE;
+   }
+
+   t->bin = MALLOC(BIN_SIZE * sizeof(*t->bin));
+   if (!t->bin)
+      return FALSE;
+
+   return TRUE;
+}
+
+
+static void
+fini_thread(struct sp_tile_thread *t)
+{
+   unsigned i;
+
+   sp_destroy_quad_pipeline(&t->quad);
+   tgsi_exec_machine_destroy(t->quad.fs_machine);
+
+   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++)
+      sp_destroy_tile_cache(t->quad.cbuf_cache[i]);
+   sp_destroy_tile_cache(t->quad.zsbuf_cache);
+
+   for (i = 0; i < PIPE_MAX_SHADER_SAMPLER_VIEWS; i++) {
+      if (t->tex_cache[i]) {
+         sp_tex_tile_cache_set_sampler_view(t->tex_cache[i], NULL);
+         sp_destroy_tex_tile_cache(t->tex_cache[i]);
+      }
+   }
+
+   FREE(t->fs_sampler);
+   FREE(t->bin);
+}
+
+
+/**
+ * Create \p num_threads threads to render the quads of \p sp.
+ * \return NULL if not even one thread could be started.
+ */
+struct sp_tile_threads *
+sp_create_tile_threads(struct softpipe_context *sp, unsigned num_threads)
+{
+   struct sp_tile_threads *threads;
+   unsigned i;
+
+   assert(num_threads <= SP_MAX_THREADS);
+
+   threads = CALLOC_STRUCT(sp_tile_threads);
+   if (!threads)
+      return NULL;
+
+   threads->softpipe = sp;
+
+   threads->coef_arena = MALLOC(COEF_ARENA_SIZE *
+                                sizeof(*threads->coef_arena));
+   if (!threads->coef_arena)
+      goto fail;
+
+   for (i = 0; i < num_threads; i++) {
+      struct sp_tile_thread *t = &threads->thread[i];
+
+      t->threads = threads;
+      t->index = i;
+
+      if (!init_thread(sp, t)) {
+         fini_thread(t);
+         break;
+      }
+
+      pipe_semaphore_init(&t->work_ready, 0);
+      pipe_semaphore_init(&t->work_done, 0);
+
+      t->thread = pipe_thread_create(thread_function, t);
+      if (!t->thread) {
+         pipe_semaphore_destroy(&t->work_ready);
+         pipe_semaphore_destroy(&t->work_done);
+         fini_thread(t);
+         break;
+      }
+
+      threads->num_threads++;
+   }
+
+   if (threads->num_threads)
+      return threads;
+
+fail:
+   FREE(threads->coef_arena);
+   FREE(threads);
+   return NULL;
+}
+
+
+void
+sp_destroy_tile_threads(struct sp_tile_threads *threads)
+{
+   unsigned i;
+
+   assert(!threads->num_binned);
+
+   /* Wake the threads up to find the exit flag set. */
+   threads->exit_flag = TRUE;
+   for (i = 0; i < threads->num_threads; i++)
+      pipe_semaphore_signal(&threads->thread[i].work_ready);
+
+   for (i = 0; i < threads->num_threads; i++) {
+      struct sp_tile_thread *t = &threads->thread[i];
+
+      pipe_thread_wait(t->thread);
+      pipe_semaphore_destroy(&t->work_ready);
+      pipe_semaphore_destroy(&t->work_done);
+      fini_thread(t);
+   }
+
+   FREE(threads->coef_arena);
+   FREE(threads);
+}
+
+
+/**
+ * Called by setup before emitting the quads of a new primitive.
+ */
+void
+sp_tile_threads_new_primitive(struct sp_tile_threads *threads)
+{
+   threads->prim_coef = NULL;
+}
+
+
+/**
+ * Bin a batch of quads of the current primitive to the thread owning the
+ * screen tile they are in.  The batches setup makes never straddle tiles.
+ */
+void
+sp_tile_threads_bin_quads(struct sp_tile_threads *threads,
+                          struct quad_header *quads[], unsigned nr)
+{
+   const unsigned tile_x = quads[0]->input.x0 / TILE_SIZE;
+   const unsigned tile_y = quads[0]->input.y0 / TILE_SIZE;
+   const unsigned pos = CACHE_POS(tile_x, tile_y, quads[0]->input.layer);
+   struct sp_tile_thread *t = &threads->thread[pos % threads->num_threads];
+   struct binned_quad *bq;
+   unsigned i;
+
+   assert(nr > 0 && nr <= MAX_QUADS);
+   assert(quads[nr - 1]->input.x0 / TILE_SIZE == tile_x);
+
+   if (t->bin_size + nr > BIN_SIZE)
+      sp_tile_threads_run(threads);
+
+   if (!threads->prim_coef) {
+      const unsigned num_inputs =
+         threads->softpipe->fs_variant->info.num_inputs;
+      struct tgsi_interp_coef *coef;
+
+      if (threads->coef_arena_used + num_inputs + 1 > COEF_ARENA_SIZE)
+         sp_tile_threads_run(threads);
+
+      coef = threads->coef_arena + threads->coef_arena_used;
+      memcpy(coef, quads[0]->coef, num_inputs * sizeof(*coef));
+      coef[num_inputs] = *quads[0]->posCoef;
+      threads->coef_arena_used += num_inputs + 1;
+
+      threads->prim_coef = coef;
+      threads->prim_pos_coef = coef + num_inputs;
+   }
+
+   bq = t->bin + t->bin_size;
+   for (i = 0; i < nr; i++) {
+      bq[i].input = quads[i]->input;
+      bq[i].mask = quads[i]->inout.mask;
+   }
+   bq[0].nr = nr;
+   bq[0].coef = threads->prim_coef;
+   bq[0].posCoef = threads->prim_pos_coef;
+
+   t->bin_size += nr;
+   threads->num_binned += nr;
+}
+
+
+/**
+ * Render the binned quads, waiting for the threads to finish.
+ *
+ * Small batches are rendered on the calling thread instead.  That goes
+ * through the same per-thread pipelines and tile caches, so the result
+ * doesn't depend on which thread rendered a bin.
+ */
+void
+sp_tile_threads_run(struct sp_tile_threads *threads)
+{
+   struct softpipe_context *sp = threads->softpipe;
+   unsigned num_bins = 0;
+   boolean threaded;
+   unsigned i;
+
+   if (!threads->num_binned)
+      return;
+
+   for (i = 0; i < threads->num_threads; i++) {
+      if (threads->thread[i].bin_size)
+         num_bins++;
+   }
+
+   threaded = threads->num_binned >= MIN_THREADED_QUADS &&
+              num_bins >= MIN_THREADED_BINS;
+
+   for (i = 0; i < threads->num_threads; i++) {
+      struct sp_tile_thread *t = &threads->thread[i];
+
+      if (t->bin_size) {
+         prepare_thread(sp, t);
+         if (threaded)
+            pipe_semaphore_signal(&t->work_ready);
+         else
+            rasterize_bin(t);
+      }
+   }
+
+   for (i = 0; i < threads->num_threads; i++) {
+      struct sp_tile_thread *t = &threads->thread[i];
+
+      if (t->bin_size) {
+         if (threaded)
+            pipe_semaphore_wait(&t->work_done);
+         t->bin_size = 0;
+
+         sp->occlusion_count += t->occlusion_count;
+         sp->pipeline_statistics.ps_invocations += t->ps_invocations;
+         t->occlusion_count = 0;
+         t->ps_invocations = 0;
+      }
+   }
+
+   threads->num_binned = 0;
+   threads->coef_arena_used = 0;
+   threads->prim_coef = NULL;
+}
+
+
+/**
+ * Write the threads' surface tiles back, like softpipe_flush() does with
+ * the context's.
+ */
+void
+sp_tile_threads_flush(struct sp_tile_threads *threads, unsigned flags)
+{
+   struct softpipe_context *sp = threads->softpipe;
+   unsigned i, j;
+
+   assert(!threads->num_binned);
+
+   for (i = 0; i < threads->num_threads; i++) {
+      struct sp_tile_thread *t = &threads->thread[i];
+
+      if (flags & SP_FLUSH_TEXTURE_CACHE) {
+         for (j = 0; j < PIPE_MAX_SHADER_SAMPLER_VIEWS; j++)
+            sp_flush_tex_tile_cache(t->tex_cache[j]);
+      }
+
+      for (j = 0; j < sp->framebuffer.nr_cbufs; j++)
+         sp_flush_tile_cache(t->quad.cbuf_cache[j]);
+
+      sp_flush_tile_cache(t->quad.zsbuf_cache);
+   }
+}
+
+
+/**
+ * Clear the color buffers or the depth-stencil buffer, each thread its own
+ * tiles of them, like sp_tile_cache_clear() does for the context.
+ */
+void
+sp_tile_threads_clear(struct sp_tile_threads *threads, unsigned buffers,
+                      const union pipe_color_union *color,
+                      uint64_t clearValue)
+{
+   struct softpipe_context *sp = threads->softpipe;
+   unsigned i, j;
+
+   assert(!threads->num_binned);
+
+   for (i = 0; i < threads->num_threads; i++) {
+      struct sp_tile_thread *t = &threads->thread[i];
+
+      if (buffers & PIPE_CLEAR_COLOR) {
+         for (j = 0; j < sp->framebuffer.nr_cbufs; j++)
+            sp_tile_cache_clear_part(t->quad.cbuf_cache[j], color, 0,
+                                     i, threads->num_threads);
+      }
+
+      if (buffers & PIPE_CLEAR_DEPTHSTENCIL)
+         sp_tile_cache_clear_part(t->quad.zsbuf_cache, color, clearValue,
+                                  i, threads->num_threads);
+   }
+}
+
+
+/**
+ * Point the threads' surface tile caches at the surfaces of \p fb, writing
+ * back their tiles of the surfaces being unbound.
+ */
+void
+sp_tile_threads_set_framebuffer(struct sp_tile_threads *threads,
+                                const struct pipe_framebuffer_state *fb)
+{
+   unsigned i, j;
+
+   assert(!threads->num_binned);
+
+   for (i = 0; i < threads->num_threads; i++) {
+      struct sp_tile_thread *t = &threads->thread[i];
+
+      for (j = 0; j < PIPE_MAX_COLOR_BUFS; j++) {
+         struct pipe_surface *cb = j < fb->nr_cbufs ? fb->cbufs[j] : NULL;
+         struct softpipe_tile_cache *tc = t->quad.cbuf_cache[j];
+
+         if (sp_tile_cache_get_surface(tc) != cb) {
+            sp_flush_tile_cache(tc);
+            sp_tile_cache_set_surface(tc, cb);
+         }
+      }
+
+      if (sp_tile_cache_get_surface(t->quad.zsbuf_cache) != fb->zsbuf) {
+         sp_flush_tile_cache(t->quad.zsbuf_cache);
+         sp_tile_cache_set_surface(t->quad.zsbuf_cache, fb->zsbuf);
+      }
+   }
+}
+
+
+/**
+ * Unbind a fragment shader variant about to be deleted from the threads'
+ * shader machines.
+ */
+void
+sp_tile_threads_delete_fs_variant(struct sp_tile_threads *threads,
+                                  struct sp_fragment_shader_variant *var)
+{
+   unsigned i;
+
+   for (i = 0; i < threads->num_threads; i++) {
+      struct tgsi_exec_machine *machine = threads->thread[i].quad.fs_machine;
+
+      if (machine->Tokens == var->tokens)
+         tgsi_exec_machine_bind_shader(machine, NULL, NULL);
+   }
+}
@@ -0,0 +1,93 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * Tile-parallel quad rendering.
+ *
+ * Instead of running the quad pipeline as the quads are rasterized, setup
+ * bins each batch of quads to the thread which owns the screen tile it
+ * falls in.  At the end of each draw the threads run their bins through
+ * quad pipelines of their own, each with its own fragment shader machine,
+ * texture caches and color/depth tile caches.  As every tile is drawn by a
+ * single thread in the order its quads were rasterized, the result is the
+ * same as drawing serially.
+ */
+
+#ifndef SP_TILE_THREADS_H
+#define SP_TILE_THREADS_H
+
+
+#include "pipe/p_compiler.h"
+
+
+struct softpipe_context;
+struct sp_fragment_shader_variant;
+struct quad_header;
+struct pipe_framebuffer_state;
+union pipe_color_union;
+
+
+/**
+ * The threads of a context, and the quads binned since they last ran.
+ */
+struct sp_tile_threads;
+
+
+struct sp_tile_threads *
+sp_create_tile_threads(struct softpipe_context *sp, unsigned num_threads);
+
+void
+sp_destroy_tile_threads(struct sp_tile_threads *threads);
+
+void
+sp_tile_threads_new_primitive(struct sp_tile_threads *threads);
+
+void
+sp_tile_threads_bin_quads(struct sp_tile_threads *threads,
+                          struct quad_header *quads[], unsigned nr);
+
+void
+sp_tile_threads_run(struct sp_tile_threads *threads);
+
+void
+sp_tile_threads_flush(struct sp_tile_threads *threads, unsigned flags);
+
+void
+sp_tile_threads_clear(struct sp_tile_threads *threads, unsigned buffers,
+                      const union pipe_color_union *color,
+                      uint64_t clearValue);
+
+void
+sp_tile_threads_set_framebuffer(struct sp_tile_threads *threads,
+                                const struct pipe_framebuffer_state *fb);
+
+void
+sp_tile_threads_delete_fs_variant(struct sp_tile_threads *threads,
+                                  struct sp_fragment_shader_variant *var);
+
+
+#endif /* SP_TILE_THREADS_H */
@@ -42,6 +42,10 @@ dri2_query_renderer_integer(__DRIscreen *_screen, int param,
                                                       PIPE_CAP_UMA);
       return 0;
 
+   case __DRI2_RENDERER_HAS_NO_ERROR_CONTEXT:
+      value[0] = 1;
+      return 0;
+
    default:
       return driQueryRendererIntegerCommon(_screen, param, value);
    }
@@ -0,0 +1,376 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/*
+ * Renders the same blended, depth tested triangles with softpipe once
+ * serially and once on tile threads, and checks that the color and depth
+ * buffers are identical:
+ *
+ *    sp_threads_test [THREADS]
+ *
+ * The triangles are drawn in one large draw, which is rendered on the
+ * threads, followed by many small draws, which are rendered on the calling
+ * thread through the threads' tile caches.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_defines.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "tgsi/tgsi_text.h"
+#include "util/u_draw.h"
+#include "util/u_format.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+#include "util/u_string.h"
+#include "softpipe/sp_public.h"
+#include "sw/null/null_sw_winsys.h"
+
+
+#define WIDTH 128
+#define HEIGHT 128
+
+#define NUM_LARGE_TRIS 200
+#define NUM_SMALL_TRIS 64
+#define NUM_VERTS (3 * (NUM_LARGE_TRIS + NUM_SMALL_TRIS))
+
+
+/** Position and color of each vertex */
+static float verts[NUM_VERTS][2][4];
+
+
+static const char vs_text[] =
+   "VERT\n"
+   "DCL IN[0]\n"
+   "DCL IN[1]\n"
+   "DCL OUT[0], POSITION\n"
+   "DCL OUT[1], COLOR\n"
+   "  0: MOV OUT[0], IN[0]\n"
+   "  1: MOV OUT[1], IN[1]\n"
+   "  2: END\n";
+
+static const char fs_text[] =
+   "FRAG\n"
+   "DCL IN[0], COLOR, COLOR\n"
+   "DCL OUT[0], COLOR\n"
+   "  0: MOV OUT[0], IN[0]\n"
+   "  1: END\n";
+
+
+static float
+rand_float(float min, float max)
+{
+   return min + (max - min) * (float) rand() / (float) RAND_MAX;
+}
+
+
+static void
+init_verts(void)
+{
+   float center[2] = { 0.0f, 0.0f };
+   unsigned i, j;
+
+   srand(0);
+
+   for (i = 0; i < NUM_VERTS; i++) {
+      /* The small triangles cover a few pixels around a random center. */
+      const float size = i >= 3 * NUM_LARGE_TRIS ? 0.05f : 1.0f;
+
+      if (i % 3 == 0) {
+         center[0] = rand_float(-1.0f, 1.0f);
+         center[1] = rand_float(-1.0f, 1.0f);
+      }
+
+      verts[i][0][0] = center[0] + rand_float(-size, size);
+      verts[i][0][1] = center[1] + rand_float(-size, size);
+      verts[i][0][2] = rand_float(0.0f, 1.0f);
+      verts[i][0][3] = 1.0f;
+
+      for (j = 0; j < 4; j++)
+         verts[i][1][j] = rand_float(0.0f, 1.0f);
+   }
+}
+
+
+static void
+set_num_threads(unsigned num_threads)
+{
+   char value[16];
+
+   util_snprintf(value, sizeof value, "%u", num_threads);
+#ifdef _WIN32
+   _putenv_s("SOFTPIPE_NUM_THREADS", value);
+#else
+   setenv("SOFTPIPE_NUM_THREADS", value, 1);
+#endif
+}
+
+
+static boolean
+read_surface(struct pipe_context *pipe, struct pipe_resource *tex,
+             ubyte *dst)
+{
+   const unsigned row_size = util_format_get_stride(tex->format, WIDTH);
+   struct pipe_transfer *transfer;
+   const ubyte *map;
+   unsigned y;
+
+   map = pipe_transfer_map(pipe, tex, 0, 0, PIPE_TRANSFER_READ,
+                           0, 0, WIDTH, HEIGHT, &transfer);
+   if (!map)
+      return FALSE;
+
+   for (y = 0; y < HEIGHT; y++)
+      memcpy(dst + y * row_size, map + y * transfer->stride, row_size);
+
+   pipe_transfer_unmap(pipe, transfer);
+   return TRUE;
+}
+
+
+static struct pipe_resource *
+create_surface_texture(struct pipe_screen *screen, enum pipe_format format,
+                       unsigned bind)
+{
+   struct pipe_resource templ;
+
+   memset(&templ, 0, sizeof templ);
+   templ.target = PIPE_TEXTURE_2D;
+   templ.format = format;
+   templ.width0 = WIDTH;
+   templ.height0 = HEIGHT;
+   templ.depth0 = 1;
+   templ.array_size = 1;
+   templ.bind = bind;
+
+   return screen->resource_create(screen, &templ);
+}
+
+
+/**
+ * Render the triangles with \p num_threads tile threads and read back the
+ * color and depth buffers.
+ */
+static boolean
+render(unsigned num_threads, ubyte *color, ubyte *depth)
+{
+   const union pipe_color_union clear_color = { { 0.2f, 0.3f, 0.4f, 1.0f } };
+   struct tgsi_token vs_tokens[256], fs_tokens[256];
+   struct pipe_screen *screen;
+   struct pipe_context *pipe;
+   struct pipe_resource *cbuf_tex, *zsbuf_tex;
+   struct pipe_surface surf_tmpl, *cbuf, *zsbuf;
+   struct pipe_framebuffer_state fb;
+   struct pipe_shader_state vs, fs;
+   struct pipe_rasterizer_state rast;
+   struct pipe_blend_state blend;
+   struct pipe_depth_stencil_alpha_state dsa;
+   struct pipe_viewport_state vp;
+   struct pipe_vertex_element velems[2];
+   struct pipe_vertex_buffer vbuf;
+   void *vs_state, *fs_state, *rast_state, *blend_state, *dsa_state;
+   void *velem_state;
+   boolean success;
+   unsigned i;
+
+   if (!tgsi_text_translate(vs_text, vs_tokens, Elements(vs_tokens)) ||
+       !tgsi_text_translate(fs_text, fs_tokens, Elements(fs_tokens)))
+      return FALSE;
+
+   set_num_threads(num_threads);
+
+   screen = softpipe_create_screen(null_sw_create());
+   if (!screen)
+      return FALSE;
+
+   pipe = screen->context_create(screen, NULL);
+   if (!pipe) {
+      screen->destroy(screen);
+      return FALSE;
+   }
+
+   cbuf_tex = create_surface_texture(screen, PIPE_FORMAT_B8G8R8A8_UNORM,
+                                     PIPE_BIND_RENDER_TARGET);
+   zsbuf_tex = create_surface_texture(screen, PIPE_FORMAT_Z24_UNORM_S8_UINT,
+                                      PIPE_BIND_DEPTH_STENCIL);
+
+   memset(&surf_tmpl, 0, sizeof surf_tmpl);
+   surf_tmpl.format = cbuf_tex->format;
+   cbuf = pipe->create_surface(pipe, cbuf_tex, &surf_tmpl);
+   surf_tmpl.format = zsbuf_tex->format;
+   zsbuf = pipe->create_surface(pipe, zsbuf_tex, &surf_tmpl);
+
+   memset(&fb, 0, sizeof fb);
+   fb.width = WIDTH;
+   fb.height = HEIGHT;
+   fb.nr_cbufs = 1;
+   fb.cbufs[0] = cbuf;
+   fb.zsbuf = zsbuf;
+   pipe->set_framebuffer_state(pipe, &fb);
+
+   memset(&vs, 0, sizeof vs);
+   vs.tokens = vs_tokens;
+   vs_state = pipe->create_vs_state(pipe, &vs);
+   pipe->bind_vs_state(pipe, vs_state);
+
+   memset(&fs, 0, sizeof fs);
+   fs.tokens = fs_tokens;
+   fs_state = pipe->create_fs_state(pipe, &fs);
+   pipe->bind_fs_state(pipe, fs_state);
+
+   memset(&rast, 0, sizeof rast);
+   rast.half_pixel_center = 1;
+   rast.bottom_edge_rule = 1;
+   rast.depth_clip = 1;
+   rast_state = pipe->create_rasterizer_state(pipe, &rast);
+   pipe->bind_rasterizer_state(pipe, rast_state);
+
+   /* Blending makes the result depend on the order fragments land in. */
+   memset(&blend, 0, sizeof blend);
+   blend.rt[0].blend_enable = 1;
+   blend.rt[0].rgb_func = PIPE_BLEND_ADD;
+   blend.rt[0].rgb_src_factor = PIPE_BLENDFACTOR_SRC_ALPHA;
+   blend.rt[0].rgb_dst_factor = PIPE_BLENDFACTOR_INV_SRC_ALPHA;
+   blend.rt[0].alpha_func = PIPE_BLEND_ADD;
+   blend.rt[0].alpha_src_factor = PIPE_BLENDFACTOR_SRC_ALPHA;
+   blend.rt[0].alpha_dst_factor = PIPE_BLENDFACTOR_INV_SRC_ALPHA;
+   blend.rt[0].colormask = PIPE_MASK_RGBA;
+   blend_state = pipe->create_blend_state(pipe, &blend);
+   pipe->bind_blend_state(pipe, blend_state);
+
+   memset(&dsa, 0, sizeof dsa);
+   dsa.depth.enabled = 1;
+   dsa.depth.writemask = 1;
+   dsa.depth.func = PIPE_FUNC_LESS;
+   dsa_state = pipe->create_depth_stencil_alpha_state(pipe, &dsa);
+   pipe->bind_depth_stencil_alpha_state(pipe, dsa_state);
+
+   vp.scale[0] = WIDTH / 2.0f;
+   vp.scale[1] = HEIGHT / 2.0f;
+   vp.scale[2] = 0.5f;
+   vp.translate[0] = WIDTH / 2.0f;
+   vp.translate[1] = HEIGHT / 2.0f;
+   vp.translate[2] = 0.5f;
+   pipe->set_viewport_states(pipe, 0, 1, &vp);
+
+   memset(velems, 0, sizeof velems);
+   for (i = 0; i < 2; i++) {
+      velems[i].src_offset = i * 4 * sizeof(float);
+      velems[i].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   }
+   velem_state = pipe->create_vertex_elements_state(pipe, 2, velems);
+   pipe->bind_vertex_elements_state(pipe, velem_state);
+
+   memset(&vbuf, 0, sizeof vbuf);
+   vbuf.stride = sizeof(verts[0]);
+   vbuf.user_buffer = verts;
+   pipe->set_vertex_buffers(pipe, 0, 1, &vbuf);
+
+   pipe->clear(pipe, PIPE_CLEAR_COLOR | PIPE_CLEAR_DEPTHSTENCIL,
+               &clear_color, 1.0, 0);
+
+   util_draw_arrays(pipe, PIPE_PRIM_TRIANGLES, 0, 3 * NUM_LARGE_TRIS);
+   for (i = 0; i < NUM_SMALL_TRIS; i++) {
+      util_draw_arrays(pipe, PIPE_PRIM_TRIANGLES,
+                       3 * (NUM_LARGE_TRIS + i), 3);
+   }
+
+   pipe->flush(pipe, NULL, 0);
+
+   success = read_surface(pipe, cbuf_tex, color) &&
+             read_surface(pipe, zsbuf_tex, depth);
+
+   pipe->set_vertex_buffers(pipe, 0, 1, NULL);
+   pipe->bind_vertex_elements_state(pipe, NULL);
+   pipe->delete_vertex_elements_state(pipe, velem_state);
+   pipe->bind_depth_stencil_alpha_state(pipe, NULL);
+   pipe->delete_depth_stencil_alpha_state(pipe, dsa_state);
+   pipe->bind_blend_state(pipe, NULL);
+   pipe->delete_blend_state(pipe, blend_state);
+   pipe->bind_rasterizer_state(pipe, NULL);
+   pipe->delete_rasterizer_state(pipe, rast_state);
+   pipe->bind_fs_state(pipe, NULL);
+   pipe->delete_fs_state(pipe, fs_state);
+   pipe->bind_vs_state(pipe, NULL);
+   pipe->delete_vs_state(pipe, vs_state);
+
+   memset(&fb, 0, sizeof fb);
+   pipe->set_framebuffer_state(pipe, &fb);
+   pipe_surface_reference(&cbuf, NULL);
+   pipe_surface_reference(&zsbuf, NULL);
+   pipe_resource_reference(&cbuf_tex, NULL);
+   pipe_resource_reference(&zsbuf_tex, NULL);
+
+   pipe->destroy(pipe);
+   screen->destroy(screen);
+
+   return success;
+}
+
+
+int
+main(int argc, char **argv)
+{
+   const unsigned num_threads = argc > 1 ? atoi(argv[1]) : 4;
+   const unsigned size = WIDTH * HEIGHT * 4;
+   ubyte *color[2], *depth[2];
+   boolean success;
+   unsigned i;
+
+   init_verts();
+
+   for (i = 0; i < 2; i++) {
+      color[i] = CALLOC(1, size);
+      depth[i] = CALLOC(1, size);
+   }
+
+   success = color[0] && color[1] && depth[0] && depth[1] &&
+             render(0, color[0], depth[0]) &&
+             render(num_threads, color[1], depth[1]);
+   if (!success) {
+      printf("Failed to render\n");
+   } else if (memcmp(color[0], color[1], size) != 0 ||
+              memcmp(depth[0], depth[1], size) != 0) {
+      printf("Rendering with %u threads differs from rendering serially\n",
+             num_threads);
+      success = FALSE;
+   } else {
+      printf("Rendering with %u threads matches rendering serially\n",
+             num_threads);
+   }
+
+   for (i = 0; i < 2; i++) {
+      FREE(color[i]);
+      FREE(depth[i]);
+   }
+
+   return success ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER(S) OR AUTHOR(S) BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/*
+ * Runs a vertex shader with the TGSI interpreter, once decoding every
+ * instruction as it runs and once with the pre-decoded micro-ops, checks
+ * that both give the same outputs and prints the time each took:
+ *
+ *    tgsi_exec_bench [ITERATIONS]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pipe/p_shader_tokens.h"
+#include "tgsi/tgsi_exec.h"
+#include "tgsi/tgsi_text.h"
+#include "os/os_time.h"
+#include "util/u_memory.h"
+
+
+/* Transform and light a vertex, with a branch to exercise partial execution
+ * masks and an RSQ that the micro-ops don't cover.
+ */
+static const char shader_text[] =
+   "VERT\n"
+   "DCL IN[0]\n"
+   "DCL IN[1]\n"
+   "DCL IN[2]\n"
+   "DCL OUT[0], POSITION\n"
+   "DCL OUT[1], COLOR\n"
+   "DCL OUT[2], GENERIC[0]\n"
+   "DCL CONST[0..10]\n"
+   "DCL TEMP[0..3]\n"
+   "IMM[0] FLT32 { 0.0000, 1.0000, 0.5000, 2.0000 }\n"
+   "  0: MUL TEMP[0], IN[0].xxxx, CONST[0]\n"
+   "  1: MAD TEMP[0], IN[0].yyyy, CONST[1], TEMP[0]\n"
+   "  2: MAD TEMP[0], IN[0].zzzz, CONST[2], TEMP[0]\n"
+   "  3: MAD OUT[0], IN[0].wwww, CONST[3], TEMP[0]\n"
+   "  4: DP3 TEMP[1].x, IN[1], CONST[4]\n"
+   "  5: DP3 TEMP[1].y, IN[1], CONST[5]\n"
+   "  6: DP3 TEMP[1].z, IN[1], CONST[6]\n"
+   "  7: DP3 TEMP[2].x, TEMP[1], TEMP[1]\n"
+   "  8: RSQ TEMP[2].x, TEMP[2].xxxx\n"
+   "  9: MUL TEMP[1].xyz, TEMP[1], TEMP[2].xxxx\n"
+   " 10: DP3 TEMP[2].x, TEMP[1], CONST[7]\n"
+   " 11: MAX TEMP[2].x, TEMP[2].xxxx, IMM[0].xxxx\n"
+   " 12: MAD TEMP[3], TEMP[2].xxxx, CONST[8], CONST[9]\n"
+   " 13: SLT TEMP[2].y, -|IN[2].xxxx|, IMM[0].zzzz\n"
+   " 14: LRP TEMP[3], TEMP[2].yyyy, TEMP[3], CONST[10]\n"
+   " 15: MOV_SAT OUT[1], TEMP[3]\n"
+   " 16: SUB TEMP[0], IN[2], IMM[0].zzzz\n"
+   " 17: SGE TEMP[0].w, IN[2].xxxx, IMM[0].zzzz\n"
+   " 18: IF TEMP[0].wwww\n"
+   " 19:   MUL OUT[2], TEMP[0], IMM[0].wwww\n"
+   " 20: ELSE\n"
+   " 21:   MIN OUT[2], TEMP[0].yxwz, IMM[0].yyyy\n"
+   " 22: ENDIF\n"
+   " 23: END\n";
+
+#define NUM_CONSTS 11
+#define NUM_INPUTS 3
+#define NUM_OUTPUTS 3
+#define NUM_QUADS 256
+
+
+static float
+rand_float(void)
+{
+   return (float) rand() / RAND_MAX * 4.0f - 2.0f;
+}
+
+static int64_t
+run(struct tgsi_exec_machine *mach,
+    const struct tgsi_exec_vector inputs[NUM_QUADS][NUM_INPUTS],
+    struct tgsi_exec_vector outputs[NUM_QUADS][NUM_OUTPUTS],
+    unsigned iterations)
+{
+   int64_t start = os_time_get();
+   unsigned i, q;
+
+   for (i = 0; i < iterations; i++) {
+      for (q = 0; q < NUM_QUADS; q++) {
+         memcpy(mach->Inputs, inputs[q], sizeof(inputs[q]));
+         tgsi_exec_machine_run(mach);
+         memcpy(outputs[q], mach->Outputs, sizeof(outputs[q]));
+      }
+   }
+
+   return os_time_get() - start;
+}
+
+int
+main(int argc, char **argv)
+{
+   static struct tgsi_exec_vector inputs[NUM_QUADS][NUM_INPUTS];
+   static struct tgsi_exec_vector outputs[2][NUM_QUADS][NUM_OUTPUTS];
+   struct tgsi_token tokens[1024];
+   float consts[NUM_CONSTS][4];
+   const void *const_bufs[PIPE_MAX_CONSTANT_BUFFERS] = { consts };
+   unsigned const_sizes[PIPE_MAX_CONSTANT_BUFFERS] = { sizeof(consts) };
+   unsigned iterations = argc > 1 ? atoi(argv[1]) : 1000;
+   int64_t usecs[2];
+   unsigned i, j, m;
+
+   if (!tgsi_text_translate(shader_text, tokens, Elements(tokens))) {
+      printf("Failed to translate the shader\n");
+      return 1;
+   }
+
+   srand(0);
+   for (i = 0; i < NUM_CONSTS; i++)
+      for (j = 0; j < 4; j++)
+         consts[i][j] = rand_float();
+   for (i = 0; i < NUM_QUADS; i++)
+      for (j = 0; j < NUM_INPUTS; j++)
+         for (m = 0; m < 4 * TGSI_QUAD_SIZE; m++)
+            inputs[i][j].xyzw[m / 4].f[m % 4] = rand_float();
+
+   for (m = 0; m < 2; m++) {
+      struct tgsi_exec_machine *mach = tgsi_exec_machine_create();
+
+      mach->UseMicroOps = m == 1;
+      tgsi_exec_machine_bind_shader(mach, tokens, NULL);
+      tgsi_exec_set_constant_buffers(mach, PIPE_MAX_CONSTANT_BUFFERS,
+                                     const_bufs, const_sizes);
+
+      usecs[m] = run(mach, (const void *) inputs, outputs[m], iterations);
+
+      tgsi_exec_machine_bind_shader(mach, NULL, NULL);
+      tgsi_exec_machine_destroy(mach);
+   }
+
+   printf("interpreter: %.1f ms\n", usecs[0] / 1000.0);
+   printf("micro-ops:   %.1f ms, speedup %.2f\n",
+          usecs[1] / 1000.0, (double) usecs[0] / usecs[1]);
+
+   if (memcmp(outputs[0], outputs[1], sizeof(outputs[0])) != 0) {
+      printf("Failure! The micro-ops gave different outputs.\n");
+      return 1;
+   }
+
+   printf("Success!\n");
+   return 0;
+}
@@ -567,6 +567,15 @@ static uint64_t radeon_query_value(struct radeon_winsys *rws,
         radeon_get_drm_value(ws->fd, RADEON_INFO_CURRENT_GPU_MCLK,
                              "current-gpu-mclk", (uint32_t*)&retval);
         return retval;
+    case RADEON_BUFFER_CACHE_HITS:
+    case RADEON_BUFFER_CACHE_MISSES:
+    case RADEON_BUFFER_CACHE_SIZE: {
+        uint64_t hits, misses, size;
+
+        pb_cache_manager_get_stats(ws->cman, &hits, &misses, &size);
+        return value == RADEON_BUFFER_CACHE_HITS ? hits :
+               value == RADEON_BUFFER_CACHE_MISSES ? misses : size;
+    }
     }
     return 0;
 }
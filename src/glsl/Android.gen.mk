@@ -132,7 +132,8 @@ $(intermediates)/nir/nir_opcodes.c: $(nir_opcodes_c_deps)
 nir_opt_algebraic_gen := $(LOCAL_PATH)/nir/nir_opt_algebraic.py
 nir_opt_algebraic_deps := \
 	$(LOCAL_PATH)/nir/nir_opt_algebraic.py \
-	$(LOCAL_PATH)/nir/nir_algebraic.py
+	$(LOCAL_PATH)/nir/nir_algebraic.py \
+	$(LOCAL_PATH)/nir/nir_opcodes.py
 
 $(intermediates)/nir/nir_opt_algebraic.c: $(nir_opt_algebraic_deps)
 	@mkdir -p $(dir $@)
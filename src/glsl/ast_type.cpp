@@ -261,7 +261,7 @@ ast_type_qualifier::merge_in_qualifier(YYLTYPE *loc,
                                        ast_type_qualifier q,
                                        ast_node* &node)
 {
-   void *mem_ctx = state;
+   void *lin_ctx = state->linalloc;
    bool create_gs_ast = false;
    bool create_cs_ast = false;
    ast_type_qualifier valid_in_mask;
@@ -346,7 +346,7 @@ ast_type_qualifier::merge_in_qualifier(YYLTYPE *loc,
    }
 
    if (create_gs_ast) {
-      node = new(mem_ctx) ast_gs_input_layout(*loc, q.prim_type);
+      node = new(lin_ctx) ast_gs_input_layout(*loc, q.prim_type);
    } else if (create_cs_ast) {
       /* Infer a local_size of 1 for every unspecified dimension */
       unsigned local_size[3];
@@ -356,7 +356,7 @@ ast_type_qualifier::merge_in_qualifier(YYLTYPE *loc,
          else
             local_size[i] = 1;
       }
-      node = new(mem_ctx) ast_cs_input_layout(*loc, local_size);
+      node = new(lin_ctx) ast_cs_input_layout(*loc, local_size);
    }
 
    return true;
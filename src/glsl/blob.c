@@ -63,6 +63,9 @@ grow_to_fit(struct blob *blob, size_t additional)
  * blob->size) will result in an access aligned to a granularity of \alignment
  * bytes.
  *
+ * The padding is zeroed, so that writing the same values always produces
+ * the same bytes.
+ *
  * \return True unless allocation fails
  */
 static bool
@@ -73,6 +76,7 @@ align_blob(struct blob *blob, size_t alignment)
    if (! grow_to_fit (blob, new_size - blob->size))
       return false;
 
+   memset(blob->data + blob->size, 0, new_size - blob->size);
    blob->size = new_size;
 
    return true;
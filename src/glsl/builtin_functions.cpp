@@ -51,6 +51,15 @@
  *    A few functions the rest of the compiler can use to interact with the
  *    built-in function module.  For example, searching for a built-in by
  *    name and parameters.
+ *
+ * Building the IR for every signature is slow and takes a lot of memory, so
+ * normally it only happens once, at build time: builtin_library_gen runs the
+ * builder and serializes the result (see ir_serialize.h) into the
+ * _mesa_glsl_builtin_library array.  At run time only the index of function
+ * names is read up front; a function's prototypes are read the first time
+ * it is looked up, and a signature's body the first time it is matched.
+ * If the library is empty (e.g. when cross-compiling) everything is built
+ * at startup as before.
  */
 
 #include <stdarg.h>
@@ -58,7 +67,9 @@
 #include "main/core.h" /* for struct gl_shader */
 #include "main/shaderobj.h"
 #include "ir_builder.h"
+#include "ir_serialize.h"
 #include "glsl_parser_extras.h"
+#include "program/hash_table.h"
 #include "program/prog_instruction.h"
 #include <math.h>
 
@@ -417,6 +428,60 @@ barrier_supported(const _mesa_glsl_parse_state *state)
    /* TODO: || stage->state == MESA_SHADER_TESS_CTRL; */
 }
 
+/**
+ * Every predicate above; the serialized library refers to them by index.
+ */
+static const builtin_available_predicate builtin_predicates[] = {
+   always_available,
+   compatibility_vs_only,
+   fs_only,
+   gs_only,
+   v110,
+   v110_fs_only,
+   v120,
+   v130,
+   v130_fs_only,
+   v140,
+   es31,
+   texture_rectangle,
+   texture_external,
+   lod_exists_in_stage,
+   v110_lod,
+   shader_texture_lod,
+   shader_texture_lod_and_rect,
+   shader_bit_encoding,
+   shader_integer_mix,
+   shader_packing_or_es3,
+   shader_packing_or_es3_or_gpu_shader5,
+   gpu_shader5,
+   gpu_shader5_or_es31,
+   shader_packing_or_es31_or_gpu_shader5,
+   fs_gpu_shader5,
+   texture_array_lod,
+   fs_texture_array,
+   texture_array,
+   texture_multisample,
+   fs_texture_cube_map_array,
+   texture_cube_map_array,
+   texture_query_levels,
+   texture_query_lod,
+   texture_gather,
+   texture_gather_or_es31,
+   texture_gather_only_or_es31,
+   fs_oes_derivatives,
+   fs_derivative_control,
+   tex1d_lod,
+   tex3d,
+   fs_tex3d,
+   tex3d_lod,
+   shader_atomic_counters,
+   shader_trinary_minmax,
+   shader_image_load_store,
+   gs_streams,
+   fp64,
+   barrier_supported,
+};
+
 /** @} */
 
 /******************************************************************************/
@@ -430,7 +495,7 @@ namespace {
  * It generates IR for every built-in function signature, and organizes them
  * into functions.
  */
-class builtin_builder {
+class builtin_builder : public ir_deserialize_resolver {
 public:
    builtin_builder();
    ~builtin_builder();
@@ -440,6 +505,20 @@ public:
    ir_function_signature *find(_mesa_glsl_parse_state *state,
                                const char *name, exec_list *actual_parameters);
 
+   /**
+    * Look up a built-in function by name, reading its prototypes from the
+    * serialized library if this is the first time it is asked for.
+    */
+   ir_function *get_function(const char *name);
+
+   /** Write every built-in function to \c blob, for builtin_library_gen. */
+   void serialize(struct blob *blob);
+
+   /** ir_deserialize_resolver methods: */
+   virtual ir_function_signature *get_signature(const char *name,
+                                                unsigned index);
+   virtual ir_variable *get_variable(const char *name);
+
    /**
     * A shader to hold all the built-in signatures; created by this module.
     *
@@ -456,10 +535,29 @@ private:
    ir_variable *gl_ModelViewProjectionMatrix;
    ir_variable *gl_Vertex;
 
+   /** Every function created by add_function(), in order. */
+   exec_list functions;
+
+   /**
+    * Serialized library index: maps function names to the
+    * builtin_library_entry holding their serialized signatures.  NULL if
+    * the functions were built rather than loaded.
+    */
+   struct hash_table *library;
+
+   /**
+    * Maps signatures whose body hasn't been read yet to the
+    * builtin_library_entry holding it.
+    */
+   struct hash_table *pending_bodies;
+
    void create_shader();
    void create_intrinsics();
    void create_builtins();
 
+   bool open_library();
+   bool load_body(ir_function_signature *sig);
+
    /**
     * IR builder helpers:
     *
@@ -733,17 +831,29 @@ private:
  * Core builtin_builder functionality:
  *  @{
  */
+/**
+ * A function's serialized signatures, or one signature's serialized body,
+ * inside _mesa_glsl_builtin_library.
+ */
+struct builtin_library_entry {
+   uint8_t *data;
+   uint32_t size;
+   bool is_defined;
+};
+
 builtin_builder::builtin_builder()
    : shader(NULL),
      gl_ModelViewProjectionMatrix(NULL),
-     gl_Vertex(NULL)
+     gl_Vertex(NULL),
+     library(NULL),
+     pending_bodies(NULL)
 {
    mem_ctx = NULL;
 }
 
 builtin_builder::~builtin_builder()
 {
-   ralloc_free(mem_ctx);
+   release();
 }
 
 ir_function_signature *
@@ -759,7 +869,7 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
     */
    state->uses_builtin_functions = true;
 
-   ir_function *f = shader->symbols->get_function(name);
+   ir_function *f = get_function(name);
    if (f == NULL)
       return NULL;
 
@@ -768,9 +878,160 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
    if (sig == NULL)
       return NULL;
 
+   if (!load_body(sig))
+      return NULL;
+
    return sig;
 }
 
+ir_function *
+builtin_builder::get_function(const char *name)
+{
+   ir_function *f = shader->symbols->get_function(name);
+   if (f != NULL || library == NULL)
+      return f;
+
+   builtin_library_entry *entry =
+      (builtin_library_entry *) hash_table_find(library, name);
+   if (entry == NULL)
+      return NULL;
+
+   struct blob_reader blob;
+   blob_reader_init(&blob, entry->data, entry->size);
+   ir_deserializer deserializer(mem_ctx, &blob, this);
+
+   f = new(mem_ctx) ir_function(name);
+
+   const uint32_t num_sigs = blob_read_uint32(&blob);
+   for (unsigned i = 0; i < num_sigs; i++) {
+      const uint32_t avail = blob_read_uint32(&blob);
+      if (avail >= ARRAY_SIZE(builtin_predicates))
+         return NULL;
+
+      ir_function_signature *sig =
+         deserializer.read_prototype(builtin_predicates[avail]);
+      if (sig == NULL)
+         return NULL;
+
+      builtin_library_entry *body = ralloc(mem_ctx, builtin_library_entry);
+      body->size = blob_read_uint32(&blob);
+      body->data = (uint8_t *) blob_read_bytes(&blob, body->size);
+      if (blob.overrun)
+         return NULL;
+
+      /* Until the body is read, make sure nothing mistakes the signature
+       * for a complete definition.
+       */
+      body->is_defined = sig->is_defined;
+      sig->is_defined = false;
+      hash_table_insert(pending_bodies, body, sig);
+
+      f->add_signature(sig);
+   }
+
+   shader->symbols->add_function(f);
+   return f;
+}
+
+bool
+builtin_builder::load_body(ir_function_signature *sig)
+{
+   if (pending_bodies == NULL)
+      return true;
+
+   builtin_library_entry *body =
+      (builtin_library_entry *) hash_table_find(pending_bodies, sig);
+   if (body == NULL)
+      return true;
+
+   /* Remove it first, reading the body may load other signatures. */
+   hash_table_remove(pending_bodies, sig);
+
+   struct blob_reader blob;
+   blob_reader_init(&blob, body->data, body->size);
+   ir_deserializer deserializer(mem_ctx, &blob, this);
+
+   if (!deserializer.read_detached_body(sig)) {
+      assert(!"Corrupt built-in function library");
+      return false;
+   }
+
+   sig->is_defined = body->is_defined;
+   return true;
+}
+
+ir_function_signature *
+builtin_builder::get_signature(const char *name, unsigned index)
+{
+   ir_function *f = get_function(name);
+   if (f == NULL)
+      return NULL;
+
+   unsigned i = 0;
+   foreach_in_list(ir_function_signature, sig, &f->signatures) {
+      if (i++ == index)
+         return load_body(sig) ? sig : NULL;
+   }
+
+   return NULL;
+}
+
+ir_variable *
+builtin_builder::get_variable(const char *name)
+{
+   return shader->symbols->get_variable(name);
+}
+
+/**
+ * Read the index of the serialized library, if there is one.
+ *
+ * The library starts with the records of all functions, preceded by their
+ * total size, and ends with the number of functions followed by each
+ * function's name and the offset and size of its record.  A record is the
+ * number of signatures, then for each signature the index of its
+ * availability predicate, its serialized prototype, and the size and bytes
+ * of its serialized body.
+ */
+bool
+builtin_builder::open_library()
+{
+   if (_mesa_glsl_builtin_library_size == 0)
+      return false;
+
+   struct blob_reader blob;
+   blob_reader_init(&blob, (uint8_t *) _mesa_glsl_builtin_library,
+                    _mesa_glsl_builtin_library_size);
+
+   const uint32_t records_size = blob_read_uint32(&blob);
+   uint8_t *records = (uint8_t *) blob_read_bytes(&blob, records_size);
+   const uint32_t num_functions = blob_read_uint32(&blob);
+   if (blob.overrun)
+      return false;
+
+   library = hash_table_ctor(num_functions, hash_table_string_hash,
+                             hash_table_string_compare);
+   pending_bodies = hash_table_ctor(0, hash_table_pointer_hash,
+                                    hash_table_pointer_compare);
+
+   builtin_library_entry *entries =
+      ralloc_array(mem_ctx, builtin_library_entry, num_functions);
+
+   for (unsigned i = 0; i < num_functions; i++) {
+      const char *name = blob_read_string(&blob);
+      const uint32_t offset = blob_read_uint32(&blob);
+
+      entries[i].size = blob_read_uint32(&blob);
+      entries[i].data = records + offset;
+      if (name == NULL || offset + entries[i].size > records_size)
+         break;
+
+      hash_table_insert(library, &entries[i], name);
+   }
+
+   assert(!blob.overrun && blob.current == blob.end);
+   return true;
+}
+
 void
 builtin_builder::initialize()
 {
@@ -780,6 +1041,9 @@ builtin_builder::initialize()
 
    mem_ctx = ralloc_context(NULL);
    create_shader();
+   if (open_library())
+      return;
+
    create_intrinsics();
    create_builtins();
 }
@@ -787,6 +1051,14 @@ builtin_builder::initialize()
 void
 builtin_builder::release()
 {
+   if (library != NULL) {
+      hash_table_dtor(library);
+      hash_table_dtor(pending_bodies);
+      library = NULL;
+      pending_bodies = NULL;
+   }
+   functions.make_empty();
+
    ralloc_free(mem_ctx);
    mem_ctx = NULL;
 
@@ -794,6 +1066,63 @@ builtin_builder::release()
    shader = NULL;
 }
 
+void
+builtin_builder::serialize(struct blob *blob)
+{
+   const unsigned num_functions = functions.length();
+   uint32_t *offsets = ralloc_array(NULL, uint32_t, num_functions + 1);
+   struct blob *records = blob_create(offsets);
+   unsigned n = 0;
+
+   foreach_in_list(ir_function, f, &functions) {
+      struct blob *record = blob_create(NULL);
+
+      blob_write_uint32(record, f->signatures.length());
+      foreach_in_list(ir_function_signature, sig, &f->signatures) {
+         const builtin_available_predicate avail =
+            sig->get_builtin_available_predicate();
+         unsigned i;
+
+         for (i = 0; i < ARRAY_SIZE(builtin_predicates); i++) {
+            if (builtin_predicates[i] == avail)
+               break;
+         }
+         assert(i < ARRAY_SIZE(builtin_predicates));
+         blob_write_uint32(record, i);
+
+         /* Both serializers number the parameters the same way, which is
+          * what lets the body be read on its own later.
+          */
+         ir_serializer(record).write_prototype(sig);
+
+         struct blob *body = blob_create(NULL);
+         ir_serializer(body).write_detached_body(sig);
+         blob_write_uint32(record, body->size);
+         blob_write_bytes(record, body->data, body->size);
+         ralloc_free(body);
+      }
+
+      offsets[n++] = records->size;
+      blob_write_bytes(records, record->data, record->size);
+      ralloc_free(record);
+   }
+   offsets[n] = records->size;
+
+   blob_write_uint32(blob, records->size);
+   blob_write_bytes(blob, records->data, records->size);
+
+   blob_write_uint32(blob, num_functions);
+   n = 0;
+   foreach_in_list(ir_function, f, &functions) {
+      blob_write_string(blob, f->name);
+      blob_write_uint32(blob, offsets[n]);
+      blob_write_uint32(blob, offsets[n + 1] - offsets[n]);
+      n++;
+   }
+
+   ralloc_free(offsets);
+}
+
 void
 builtin_builder::create_shader()
 {
@@ -2547,6 +2876,7 @@ builtin_builder::add_function(const char *name, ...)
    va_end(ap);
 
    shader->symbols->add_function(f);
+   functions.push_tail(f);
 }
 
 void
@@ -3258,7 +3588,10 @@ builtin_builder::_isinf(builtin_available_predicate avail, const glsl_type *type
 
    ir_constant_data infinities;
    for (int i = 0; i < type->vector_elements; i++) {
-      infinities.f[i] = INFINITY;
+      if (type->base_type == GLSL_TYPE_DOUBLE)
+         infinities.d[i] = INFINITY;
+      else
+         infinities.f[i] = INFINITY;
    }
 
    body.emit(ret(equal(abs(x), imm(type, infinities))));
@@ -4909,15 +5242,39 @@ _mesa_glsl_find_builtin_function_by_name(_mesa_glsl_parse_state *state,
 {
    ir_function *f;
    mtx_lock(&builtins_lock);
-   f = builtins.shader->symbols->get_function(name);
+   f = builtins.get_function(name);
    mtx_unlock(&builtins_lock);
    return f;
 }
 
-gl_shader *
-_mesa_glsl_get_builtin_function_shader()
+/**
+ * Keep other threads from loading built-ins while the caller reads the
+ * built-in function shader, e.g. to clone a definition into a linked
+ * shader.
+ */
+void
+_mesa_glsl_lock_builtin_functions()
 {
-   return builtins.shader;
+   mtx_lock(&builtins_lock);
+}
+
+void
+_mesa_glsl_unlock_builtin_functions()
+{
+   mtx_unlock(&builtins_lock);
+}
+
+/**
+ * Build every built-in function and write them to \c blob.  Only
+ * builtin_library_gen uses this, with an empty _mesa_glsl_builtin_library.
+ */
+void
+_mesa_glsl_serialize_builtin_functions(struct blob *blob)
+{
+   mtx_lock(&builtins_lock);
+   builtins.initialize();
+   builtins.serialize(blob);
+   mtx_unlock(&builtins_lock);
 }
 
 /** @} */
@@ -0,0 +1,76 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+/**
+ * \file builtin_library_gen.cpp
+ *
+ * Build-time tool that builds the IR of every built-in function and prints
+ * it in serialized form, as the C++ source defining
+ * _mesa_glsl_builtin_library.
+ *
+ * It is linked against builtin_library_stub.cpp, so that the built-in
+ * functions are generated from scratch rather than loaded.
+ */
+
+#include <stdio.h>
+#include "ir.h"
+#include "blob.h"
+
+int
+main(int argc, char **argv)
+{
+   struct blob *blob = blob_create(NULL);
+
+   if (blob == NULL) {
+      fprintf(stderr, "%s: out of memory\n", argv[0]);
+      return 1;
+   }
+
+   _mesa_glsl_serialize_builtin_functions(blob);
+
+   printf("/* Generated by builtin_library_gen, do not edit. */\n"
+          "\n"
+          "#include \"ir.h\"\n"
+          "\n"
+          "#if defined(__GNUC__)\n"
+          "__attribute__((aligned(8)))\n"
+          "#elif defined(_MSC_VER)\n"
+          "__declspec(align(8))\n"
+          "#endif\n"
+          "const uint8_t _mesa_glsl_builtin_library[] = {");
+
+   for (size_t i = 0; i < blob->size; i++)
+      printf("%s0x%02x,", i % 12 ? " " : "\n   ", blob->data[i]);
+
+   printf("\n};\n"
+          "\n"
+          "const size_t _mesa_glsl_builtin_library_size = %lu;\n",
+          (unsigned long) blob->size);
+
+   ralloc_free(blob);
+   _mesa_glsl_release_builtin_functions();
+   _mesa_glsl_release_types();
+
+   return ferror(stdout) ? 1 : 0;
+}
@@ -232,6 +232,13 @@ struct _mesa_glsl_parse_state {
    struct gl_context *const ctx;
    void *scanner;
    exec_list translation_unit;
+
+   /**
+    * Linear parent of the AST and of the strings in it, which are freed
+    * along with the parse state.
+    */
+   void *linalloc;
+
    glsl_symbol_table *symbols;
 
    unsigned num_supported_versions;
@@ -1628,6 +1628,10 @@ ir_variable::ir_variable(const struct glsl_type *type, const char *name,
 
    this->u.max_ifc_array_access = NULL;
 
+   /* Clear the fields that aren't set below as well, including padding, so
+    * that variables can be serialized byte for byte.
+    */
+   memset(&this->data, 0, sizeof(this->data));
    this->data.explicit_location = false;
    this->data.has_initializer = false;
    this->data.location = -1;
@@ -1026,6 +1026,12 @@ public:
    /** Whether or not a built-in is available for this shader. */
    bool is_builtin_available(const _mesa_glsl_parse_state *state) const;
 
+   /** Predicate used by is_builtin_available(), NULL if not a built-in. */
+   builtin_available_predicate get_builtin_available_predicate() const
+   {
+      return builtin_avail;
+   }
+
    /** Body of instructions in the function. */
    struct exec_list body;
 
@@ -2486,8 +2492,11 @@ extern ir_function *
 _mesa_glsl_find_builtin_function_by_name(_mesa_glsl_parse_state *state,
                                          const char *name);
 
-extern gl_shader *
-_mesa_glsl_get_builtin_function_shader(void);
+extern void
+_mesa_glsl_lock_builtin_functions(void);
+
+extern void
+_mesa_glsl_unlock_builtin_functions(void);
 
 extern void
 _mesa_glsl_release_functions(void);
@@ -2495,6 +2504,18 @@ _mesa_glsl_release_functions(void);
 extern void
 _mesa_glsl_release_builtin_functions(void);
 
+struct blob;
+
+extern void
+_mesa_glsl_serialize_builtin_functions(struct blob *blob);
+
+/**
+ * Built-in functions serialized by builtin_library_gen at build time, or
+ * an empty array if they have to be built at run time instead.
+ */
+extern const uint8_t _mesa_glsl_builtin_library[];
+extern const size_t _mesa_glsl_builtin_library_size;
+
 extern void
 reparent_ir(exec_list *list, void *mem_ctx);
 
@@ -0,0 +1,995 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file ir_serialize.cpp
+ *
+ * Every node is written as its ir_node_type followed by its fields in the
+ * order the constructor wants them.  Optional rvalues are written as
+ * ir_type_unset when absent, instruction lists are prefixed with their
+ * length.
+ *
+ * Variables are numbered in the order their declarations are written, and
+ * dereferences refer to them by number.  A dereference of a variable that
+ * was never declared in the stream (e.g. gl_ModelViewProjectionMatrix used
+ * by ftransform()) is written by name and looked up through the
+ * ir_deserialize_resolver when read back.  Calls are written as the callee's
+ * function name and the index of the signature within that function.
+ */
+
+#include <string.h>
+#include "ir_serialize.h"
+#include "main/imports.h"
+#include "program/hash_table.h"
+#include "util/macros.h"
+
+enum type_tag {
+   TYPE_BUILTIN,
+   TYPE_ARRAY,
+   TYPE_RECORD,
+   TYPE_INTERFACE,
+};
+
+/**
+ * Every type that isn't an array or a user-defined structure, in the order
+ * they are declared.
+ */
+static const glsl_type *const builtin_types[] = {
+#define DECL_TYPE(NAME, ...) glsl_type::NAME##_type,
+#define STRUCT_TYPE(NAME) glsl_type::struct_##NAME##_type,
+#include "builtin_type_macros.h"
+#undef DECL_TYPE
+#undef STRUCT_TYPE
+};
+
+
+ir_serializer::ir_serializer(struct blob *blob)
+   : blob(blob), num_vars(0)
+{
+   this->var_ids = hash_table_ctor(0, hash_table_pointer_hash,
+                                   hash_table_pointer_compare);
+}
+
+ir_serializer::~ir_serializer()
+{
+   hash_table_dtor(this->var_ids);
+}
+
+void
+ir_serializer::write_type(const glsl_type *type)
+{
+   for (unsigned i = 0; i < ARRAY_SIZE(builtin_types); i++) {
+      if (builtin_types[i] == type) {
+         blob_write_uint32(blob, TYPE_BUILTIN);
+         blob_write_uint32(blob, i);
+         return;
+      }
+   }
+
+   if (type->is_array()) {
+      blob_write_uint32(blob, TYPE_ARRAY);
+      blob_write_uint32(blob, type->length);
+      write_type(type->fields.array);
+      return;
+   }
+
+   assert(type->is_record() || type->is_interface());
+
+   if (type->is_interface()) {
+      blob_write_uint32(blob, TYPE_INTERFACE);
+      blob_write_uint32(blob, type->interface_packing);
+   } else {
+      blob_write_uint32(blob, TYPE_RECORD);
+   }
+   blob_write_string(blob, type->name);
+   blob_write_uint32(blob, type->length);
+
+   for (unsigned i = 0; i < type->length; i++) {
+      const glsl_struct_field *field = &type->fields.structure[i];
+
+      write_type(field->type);
+      blob_write_string(blob, field->name);
+      blob_write_uint32(blob, field->location);
+      blob_write_uint32(blob, field->interpolation);
+      blob_write_uint32(blob, field->centroid);
+      blob_write_uint32(blob, field->sample);
+      blob_write_uint32(blob, field->matrix_layout);
+      blob_write_uint32(blob, field->stream);
+   }
+}
+
+void
+ir_serializer::write_variable(ir_variable *var)
+{
+   hash_table_insert(var_ids, (void *) (uintptr_t) ++num_vars, var);
+
+   write_type(var->type);
+   blob_write_uint32(blob, var->is_name_ralloced());
+   if (var->is_name_ralloced())
+      blob_write_string(blob, var->name);
+
+   blob_write_bytes(blob, &var->data, sizeof(var->data));
+
+   const glsl_type *ifc_type = var->get_interface_type();
+   blob_write_uint32(blob, ifc_type != NULL);
+   if (ifc_type != NULL) {
+      write_type(ifc_type);
+      if (var->is_interface_instance()) {
+         blob_write_bytes(blob, var->get_max_ifc_array_access(),
+                          ifc_type->length * sizeof(unsigned));
+      }
+   }
+
+   const unsigned num_slots = var->get_num_state_slots();
+   if (num_slots > 0) {
+      blob_write_bytes(blob, var->get_state_slots(),
+                       num_slots * sizeof(ir_state_slot));
+   }
+
+   write_rvalue(var->constant_value);
+   write_rvalue(var->constant_initializer);
+}
+
+void
+ir_serializer::write_constant(ir_constant *c)
+{
+   write_type(c->type);
+
+   if (c->type->is_array()) {
+      for (unsigned i = 0; i < c->type->length; i++)
+         write_constant(c->array_elements[i]);
+      return;
+   }
+
+   if (c->type->is_record()) {
+      foreach_in_list(ir_constant, field, &c->components)
+         write_constant(field);
+      return;
+   }
+
+   for (unsigned i = 0; i < c->type->components(); i++) {
+      switch (c->type->base_type) {
+      case GLSL_TYPE_UINT:
+      case GLSL_TYPE_INT:
+      case GLSL_TYPE_FLOAT:
+         blob_write_uint32(blob, c->value.u[i]);
+         break;
+      case GLSL_TYPE_BOOL:
+         blob_write_uint32(blob, c->value.b[i]);
+         break;
+      case GLSL_TYPE_DOUBLE:
+         blob_write_bytes(blob, &c->value.d[i], sizeof(double));
+         break;
+      default:
+         assert(!"Should not get here.");
+         break;
+      }
+   }
+}
+
+void
+ir_serializer::write_rvalue(ir_rvalue *ir)
+{
+   if (ir == NULL)
+      blob_write_uint32(blob, ir_type_unset);
+   else
+      write_instruction(ir);
+}
+
+void
+ir_serializer::write_prototype(const ir_function_signature *sig)
+{
+   write_type(sig->return_type);
+   blob_write_uint32(blob, sig->is_defined);
+   blob_write_uint32(blob, sig->is_intrinsic);
+
+   blob_write_uint32(blob, sig->parameters.length());
+   foreach_in_list(ir_variable, param, &sig->parameters)
+      write_variable(param);
+}
+
+void
+ir_serializer::write_body(const ir_function_signature *sig)
+{
+   write_instructions(&sig->body);
+}
+
+void
+ir_serializer::write_detached_body(const ir_function_signature *sig)
+{
+   assert(num_vars == 0);
+
+   foreach_in_list(ir_variable, param, &sig->parameters)
+      hash_table_insert(var_ids, (void *) (uintptr_t) ++num_vars, param);
+
+   write_body(sig);
+}
+
+void
+ir_serializer::write_function(ir_function *f)
+{
+   blob_write_string(blob, f->name);
+   blob_write_uint32(blob, f->signatures.length());
+
+   foreach_in_list(ir_function_signature, sig, &f->signatures) {
+      write_prototype(sig);
+      write_body(sig);
+   }
+}
+
+void
+ir_serializer::write_instructions(const exec_list *list)
+{
+   blob_write_uint32(blob, list->length());
+   foreach_in_list(ir_instruction, ir, list)
+      write_instruction(ir);
+}
+
+void
+ir_serializer::write_shader(const exec_list *ir)
+{
+   blob_write_uint32(blob, ir->length());
+   foreach_in_list(ir_instruction, node, ir) {
+      if (node->ir_type != ir_type_function) {
+         write_instruction(node);
+         continue;
+      }
+
+      ir_function *f = (ir_function *) node;
+      blob_write_uint32(blob, ir_type_function);
+      blob_write_string(blob, f->name);
+      blob_write_uint32(blob, f->signatures.length());
+      foreach_in_list(ir_function_signature, sig, &f->signatures)
+         write_prototype(sig);
+   }
+
+   foreach_in_list(ir_instruction, node, ir) {
+      if (node->ir_type != ir_type_function)
+         continue;
+
+      foreach_in_list(ir_function_signature, sig,
+                      &((ir_function *) node)->signatures)
+         write_body(sig);
+   }
+}
+
+void
+ir_serializer::write_instruction(ir_instruction *ir)
+{
+   blob_write_uint32(blob, ir->ir_type);
+
+   switch (ir->ir_type) {
+   case ir_type_dereference_array: {
+      ir_dereference_array *deref = (ir_dereference_array *) ir;
+      write_rvalue(deref->array);
+      write_rvalue(deref->array_index);
+      break;
+   }
+   case ir_type_dereference_record: {
+      ir_dereference_record *deref = (ir_dereference_record *) ir;
+      write_rvalue(deref->record);
+      blob_write_string(blob, deref->field);
+      break;
+   }
+   case ir_type_dereference_variable: {
+      ir_variable *var = ((ir_dereference_variable *) ir)->var;
+      const uintptr_t id = (uintptr_t) hash_table_find(var_ids, var);
+      blob_write_uint32(blob, id);
+      if (id == 0)
+         blob_write_string(blob, var->name);
+      break;
+   }
+   case ir_type_constant:
+      write_constant((ir_constant *) ir);
+      break;
+   case ir_type_expression: {
+      ir_expression *expr = (ir_expression *) ir;
+      const unsigned num_operands = expr->get_num_operands();
+      blob_write_uint32(blob, expr->operation);
+      write_type(expr->type);
+      for (unsigned i = 0; i < 4; i++)
+         write_rvalue(i < num_operands ? expr->operands[i] : NULL);
+      break;
+   }
+   case ir_type_swizzle: {
+      ir_swizzle *swiz = (ir_swizzle *) ir;
+      write_rvalue(swiz->val);
+      blob_write_uint32(blob, swiz->mask.x | swiz->mask.y << 2 |
+                              swiz->mask.z << 4 | swiz->mask.w << 6 |
+                              swiz->mask.num_components << 8);
+      break;
+   }
+   case ir_type_texture: {
+      ir_texture *tex = (ir_texture *) ir;
+      blob_write_uint32(blob, tex->op);
+      write_type(tex->type);
+      write_rvalue(tex->sampler);
+      write_rvalue(tex->coordinate);
+      write_rvalue(tex->projector);
+      write_rvalue(tex->shadow_comparitor);
+      write_rvalue(tex->offset);
+
+      switch (tex->op) {
+      case ir_tex:
+      case ir_lod:
+      case ir_query_levels:
+         break;
+      case ir_txb:
+         write_rvalue(tex->lod_info.bias);
+         break;
+      case ir_txl:
+      case ir_txf:
+      case ir_txs:
+         write_rvalue(tex->lod_info.lod);
+         break;
+      case ir_txf_ms:
+         write_rvalue(tex->lod_info.sample_index);
+         break;
+      case ir_txd:
+         write_rvalue(tex->lod_info.grad.dPdx);
+         write_rvalue(tex->lod_info.grad.dPdy);
+         break;
+      case ir_tg4:
+         write_rvalue(tex->lod_info.component);
+         break;
+      }
+      break;
+   }
+   case ir_type_variable:
+      write_variable((ir_variable *) ir);
+      break;
+   case ir_type_assignment: {
+      ir_assignment *assign = (ir_assignment *) ir;
+      write_rvalue(assign->lhs);
+      write_rvalue(assign->rhs);
+      write_rvalue(assign->condition);
+      blob_write_uint32(blob, assign->write_mask);
+      break;
+   }
+   case ir_type_call: {
+      ir_call *call = (ir_call *) ir;
+      const ir_function *f = call->callee->function();
+      unsigned index = 0;
+
+      foreach_in_list(ir_function_signature, sig, &f->signatures) {
+         if (sig == call->callee)
+            break;
+         index++;
+      }
+
+      blob_write_string(blob, f->name);
+      blob_write_uint32(blob, index);
+      write_rvalue(call->return_deref);
+      write_instructions(&call->actual_parameters);
+      break;
+   }
+   case ir_type_function:
+      write_function((ir_function *) ir);
+      break;
+   case ir_type_if: {
+      ir_if *iff = (ir_if *) ir;
+      write_rvalue(iff->condition);
+      write_instructions(&iff->then_instructions);
+      write_instructions(&iff->else_instructions);
+      break;
+   }
+   case ir_type_loop:
+      write_instructions(&((ir_loop *) ir)->body_instructions);
+      break;
+   case ir_type_loop_jump:
+      blob_write_uint32(blob, ((ir_loop_jump *) ir)->mode);
+      break;
+   case ir_type_return:
+      write_rvalue(((ir_return *) ir)->value);
+      break;
+   case ir_type_discard:
+      write_rvalue(((ir_discard *) ir)->condition);
+      break;
+   case ir_type_emit_vertex:
+      write_rvalue(((ir_emit_vertex *) ir)->stream);
+      break;
+   case ir_type_end_primitive:
+      write_rvalue(((ir_end_primitive *) ir)->stream);
+      break;
+   case ir_type_barrier:
+      break;
+   case ir_type_function_signature:
+   case ir_type_unset:
+      assert(!"Should not get here.");
+      break;
+   }
+}
+
+
+ir_deserializer::ir_deserializer(void *mem_ctx, struct blob_reader *blob,
+                                 ir_deserialize_resolver *resolver)
+   : mem_ctx(mem_ctx), blob(blob), resolver(resolver), error(false),
+     vars(NULL), num_vars(0), vars_size(0)
+{
+   this->functions = hash_table_ctor(0, hash_table_string_hash,
+                                     hash_table_string_compare);
+}
+
+ir_deserializer::~ir_deserializer()
+{
+   hash_table_dtor(this->functions);
+   free(this->vars);
+}
+
+void
+ir_deserializer::add_variable(ir_variable *var)
+{
+   if (num_vars == vars_size) {
+      vars_size = vars_size ? vars_size * 2 : 16;
+      vars = (ir_variable **) realloc(vars, vars_size * sizeof(*vars));
+   }
+   vars[num_vars++] = var;
+}
+
+const glsl_type *
+ir_deserializer::read_type()
+{
+   const uint32_t tag = blob_read_uint32(blob);
+
+   switch (tag) {
+   case TYPE_BUILTIN: {
+      const uint32_t i = blob_read_uint32(blob);
+      if (i >= ARRAY_SIZE(builtin_types))
+         break;
+      return builtin_types[i];
+   }
+   case TYPE_ARRAY: {
+      const uint32_t length = blob_read_uint32(blob);
+      const glsl_type *element = read_type();
+      if (element == NULL)
+         break;
+      return glsl_type::get_array_instance(element, length);
+   }
+   case TYPE_RECORD:
+   case TYPE_INTERFACE: {
+      const uint32_t packing =
+         tag == TYPE_INTERFACE ? blob_read_uint32(blob) : 0;
+      const char *name = blob_read_string(blob);
+      const uint32_t length = blob_read_uint32(blob);
+
+      if (name == NULL || blob->overrun)
+         break;
+
+      glsl_struct_field *fields = ralloc_array(NULL, glsl_struct_field, length);
+      for (unsigned i = 0; i < length; i++) {
+         fields[i].type = read_type();
+         fields[i].name = blob_read_string(blob);
+         fields[i].location = blob_read_uint32(blob);
+         fields[i].interpolation = blob_read_uint32(blob);
+         fields[i].centroid = blob_read_uint32(blob);
+         fields[i].sample = blob_read_uint32(blob);
+         fields[i].matrix_layout = blob_read_uint32(blob);
+         fields[i].stream = blob_read_uint32(blob);
+
+         if (fields[i].type == NULL || fields[i].name == NULL) {
+            ralloc_free(fields);
+            error = true;
+            return NULL;
+         }
+      }
+
+      const glsl_type *type = tag == TYPE_INTERFACE
+         ? glsl_type::get_interface_instance(fields, length,
+                                             (glsl_interface_packing) packing,
+                                             name)
+         : glsl_type::get_record_instance(fields, length, name);
+      ralloc_free(fields);
+      return type;
+   }
+   }
+
+   error = true;
+   return NULL;
+}
+
+ir_variable *
+ir_deserializer::read_variable()
+{
+   const glsl_type *type = read_type();
+   const char *name = NULL;
+
+   if (blob_read_uint32(blob))
+      name = blob_read_string(blob);
+
+   ir_variable::ir_variable_data data;
+   blob_copy_bytes(blob, (uint8_t *) &data, sizeof(data));
+
+   if (type == NULL || failed()) {
+      error = true;
+      return NULL;
+   }
+
+   ir_variable *var =
+      new(mem_ctx) ir_variable(type, name, (ir_variable_mode) data.mode);
+   var->data = data;
+   add_variable(var);
+
+   if (blob_read_uint32(blob)) {
+      const glsl_type *ifc_type = read_type();
+      if (ifc_type == NULL)
+         return NULL;
+
+      /* The constructor already did this for interface instances. */
+      if (var->get_interface_type() == NULL)
+         var->init_interface_type(ifc_type);
+      if (var->is_interface_instance()) {
+         blob_copy_bytes(blob, (uint8_t *) var->get_max_ifc_array_access(),
+                         ifc_type->length * sizeof(unsigned));
+      }
+   }
+
+   const unsigned num_slots = var->get_num_state_slots();
+   if (num_slots > 0) {
+      ir_state_slot *slots = var->allocate_state_slots(num_slots);
+      blob_copy_bytes(blob, (uint8_t *) slots,
+                      num_slots * sizeof(ir_state_slot));
+   }
+
+   ir_rvalue *value = read_rvalue();
+   var->constant_value = value ? value->as_constant() : NULL;
+   value = read_rvalue();
+   var->constant_initializer = value ? value->as_constant() : NULL;
+
+   return var;
+}
+
+ir_constant *
+ir_deserializer::read_constant()
+{
+   const glsl_type *type = read_type();
+
+   if (failed() || type == NULL)
+      return NULL;
+
+   if (type->is_array() || type->is_record()) {
+      exec_list values;
+
+      for (unsigned i = 0; i < type->length; i++) {
+         ir_constant *value = read_constant();
+         if (value == NULL)
+            return NULL;
+         values.push_tail(value);
+      }
+
+      return new(mem_ctx) ir_constant(type, &values);
+   }
+
+   if (type->base_type < GLSL_TYPE_UINT || type->base_type > GLSL_TYPE_BOOL) {
+      error = true;
+      return NULL;
+   }
+
+   ir_constant_data data;
+   memset(&data, 0, sizeof(data));
+
+   for (unsigned i = 0; i < type->components(); i++) {
+      switch (type->base_type) {
+      case GLSL_TYPE_BOOL:
+         data.b[i] = blob_read_uint32(blob) != 0;
+         break;
+      case GLSL_TYPE_DOUBLE:
+         blob_copy_bytes(blob, (uint8_t *) &data.d[i], sizeof(double));
+         break;
+      default:
+         data.u[i] = blob_read_uint32(blob);
+         break;
+      }
+   }
+
+   if (failed())
+      return NULL;
+
+   return new(mem_ctx) ir_constant(type, &data);
+}
+
+ir_rvalue *
+ir_deserializer::read_rvalue()
+{
+   if (failed())
+      return NULL;
+
+   const uint32_t ir_type = blob_read_uint32(blob);
+   if (ir_type == ir_type_unset)
+      return NULL;
+
+   ir_instruction *ir = read_node(ir_type);
+   if (ir == NULL)
+      return NULL;
+
+   if (!ir->is_rvalue()) {
+      error = true;
+      return NULL;
+   }
+
+   return (ir_rvalue *) ir;
+}
+
+ir_function_signature *
+ir_deserializer::read_prototype(builtin_available_predicate avail)
+{
+   const glsl_type *return_type = read_type();
+   const bool is_defined = blob_read_uint32(blob);
+   const bool is_intrinsic = blob_read_uint32(blob);
+   const uint32_t num_params = blob_read_uint32(blob);
+
+   if (return_type == NULL || failed())
+      return NULL;
+
+   ir_function_signature *sig =
+      new(mem_ctx) ir_function_signature(return_type, avail);
+   sig->is_defined = is_defined;
+   sig->is_intrinsic = is_intrinsic;
+
+   exec_list params;
+   for (unsigned i = 0; i < num_params; i++) {
+      ir_variable *param = read_variable();
+      if (param == NULL)
+         return NULL;
+      params.push_tail(param);
+   }
+   sig->replace_parameters(&params);
+
+   return sig;
+}
+
+bool
+ir_deserializer::read_body(ir_function_signature *sig)
+{
+   return read_instructions(&sig->body);
+}
+
+bool
+ir_deserializer::read_detached_body(ir_function_signature *sig)
+{
+   assert(num_vars == 0);
+
+   foreach_in_list(ir_variable, param, &sig->parameters)
+      add_variable(param);
+
+   return read_body(sig);
+}
+
+ir_function *
+ir_deserializer::read_function()
+{
+   const char *name = blob_read_string(blob);
+   const uint32_t num_sigs = blob_read_uint32(blob);
+
+   if (name == NULL || failed())
+      return NULL;
+
+   ir_function *f = new(mem_ctx) ir_function(name);
+   hash_table_insert(functions, f, f->name);
+
+   for (unsigned i = 0; i < num_sigs; i++) {
+      ir_function_signature *sig = read_prototype();
+      if (sig == NULL)
+         return NULL;
+
+      /* Add the signature before reading its body, recursive calls are
+       * rejected by the linker but still have to be representable.
+       */
+      f->add_signature(sig);
+      if (!read_body(sig))
+         return NULL;
+   }
+
+   return f;
+}
+
+ir_function_signature *
+ir_deserializer::read_callee()
+{
+   const char *name = blob_read_string(blob);
+   const uint32_t index = blob_read_uint32(blob);
+
+   if (name == NULL || failed())
+      return NULL;
+
+   ir_function *f = (ir_function *) hash_table_find(functions, name);
+   if (f == NULL)
+      return resolver ? resolver->get_signature(name, index) : NULL;
+
+   unsigned i = 0;
+   foreach_in_list(ir_function_signature, sig, &f->signatures) {
+      if (i++ == index)
+         return sig;
+   }
+
+   return NULL;
+}
+
+bool
+ir_deserializer::read_instructions(exec_list *list)
+{
+   const uint32_t count = blob_read_uint32(blob);
+
+   for (unsigned i = 0; i < count; i++) {
+      ir_instruction *ir = read_instruction();
+      if (ir == NULL) {
+         error = true;
+         return false;
+      }
+      list->push_tail(ir);
+   }
+
+   return !failed();
+}
+
+bool
+ir_deserializer::read_shader(exec_list *ir)
+{
+   const uint32_t count = blob_read_uint32(blob);
+
+   for (unsigned i = 0; i < count; i++) {
+      const uint32_t ir_type = blob_read_uint32(blob);
+      if (failed())
+         return false;
+
+      if (ir_type != ir_type_function) {
+         ir_instruction *node = read_node(ir_type);
+         if (node == NULL) {
+            error = true;
+            return false;
+         }
+         ir->push_tail(node);
+         continue;
+      }
+
+      const char *name = blob_read_string(blob);
+      const uint32_t num_sigs = blob_read_uint32(blob);
+      if (name == NULL || failed())
+         return false;
+
+      ir_function *f = new(mem_ctx) ir_function(name);
+      hash_table_insert(functions, f, f->name);
+      ir->push_tail(f);
+
+      for (unsigned j = 0; j < num_sigs; j++) {
+         ir_function_signature *sig = read_prototype();
+         if (sig == NULL) {
+            error = true;
+            return false;
+         }
+         f->add_signature(sig);
+      }
+   }
+
+   foreach_in_list(ir_instruction, node, ir) {
+      if (node->ir_type != ir_type_function)
+         continue;
+
+      foreach_in_list(ir_function_signature, sig,
+                      &((ir_function *) node)->signatures) {
+         if (!read_body(sig))
+            return false;
+      }
+   }
+
+   return !failed();
+}
+
+ir_instruction *
+ir_deserializer::read_instruction()
+{
+   if (failed())
+      return NULL;
+
+   return read_node(blob_read_uint32(blob));
+}
+
+ir_instruction *
+ir_deserializer::read_node(uint32_t ir_type)
+{
+   switch (ir_type) {
+   case ir_type_dereference_array: {
+      ir_rvalue *array = read_rvalue();
+      ir_rvalue *index = read_rvalue();
+      if (failed() || array == NULL || index == NULL)
+         break;
+      return new(mem_ctx) ir_dereference_array(array, index);
+   }
+   case ir_type_dereference_record: {
+      ir_rvalue *record = read_rvalue();
+      const char *field = blob_read_string(blob);
+      if (failed() || record == NULL || field == NULL)
+         break;
+      return new(mem_ctx) ir_dereference_record(record, field);
+   }
+   case ir_type_dereference_variable: {
+      const uint32_t id = blob_read_uint32(blob);
+      ir_variable *var = NULL;
+
+      if (id == 0) {
+         const char *name = blob_read_string(blob);
+         if (name != NULL && resolver != NULL)
+            var = resolver->get_variable(name);
+      } else if (id <= num_vars) {
+         var = vars[id - 1];
+      }
+
+      if (var == NULL)
+         break;
+      return new(mem_ctx) ir_dereference_variable(var);
+   }
+   case ir_type_constant:
+      return read_constant();
+   case ir_type_expression: {
+      const uint32_t op = blob_read_uint32(blob);
+      const glsl_type *type = read_type();
+      ir_rvalue *operands[4];
+
+      for (unsigned i = 0; i < 4; i++)
+         operands[i] = read_rvalue();
+
+      if (failed() || type == NULL || operands[0] == NULL ||
+          op > ir_last_opcode)
+         break;
+      return new(mem_ctx) ir_expression(op, type, operands[0], operands[1],
+                                        operands[2], operands[3]);
+   }
+   case ir_type_swizzle: {
+      ir_rvalue *val = read_rvalue();
+      const uint32_t bits = blob_read_uint32(blob);
+
+      if (failed() || val == NULL || ((bits >> 8) & 7) == 0 ||
+          ((bits >> 8) & 7) > 4)
+         break;
+
+      const unsigned components[4] = {
+         bits & 3, (bits >> 2) & 3, (bits >> 4) & 3, (bits >> 6) & 3
+      };
+      return new(mem_ctx) ir_swizzle(val, components, (bits >> 8) & 7);
+   }
+   case ir_type_texture: {
+      ir_texture *tex =
+         new(mem_ctx) ir_texture((ir_texture_opcode) blob_read_uint32(blob));
+      const glsl_type *type = read_type();
+      ir_rvalue *sampler = read_rvalue();
+
+      if (type == NULL || sampler == NULL || !sampler->as_dereference())
+         break;
+
+      tex->set_sampler(sampler->as_dereference(), type);
+      tex->coordinate = read_rvalue();
+      tex->projector = read_rvalue();
+      tex->shadow_comparitor = read_rvalue();
+      tex->offset = read_rvalue();
+
+      switch (tex->op) {
+      case ir_tex:
+      case ir_lod:
+      case ir_query_levels:
+         break;
+      case ir_txb:
+         tex->lod_info.bias = read_rvalue();
+         break;
+      case ir_txl:
+      case ir_txf:
+      case ir_txs:
+         tex->lod_info.lod = read_rvalue();
+         break;
+      case ir_txf_ms:
+         tex->lod_info.sample_index = read_rvalue();
+         break;
+      case ir_txd:
+         tex->lod_info.grad.dPdx = read_rvalue();
+         tex->lod_info.grad.dPdy = read_rvalue();
+         break;
+      case ir_tg4:
+         tex->lod_info.component = read_rvalue();
+         break;
+      default:
+         error = true;
+         break;
+      }
+
+      if (failed())
+         break;
+      return tex;
+   }
+   case ir_type_variable:
+      return read_variable();
+   case ir_type_assignment: {
+      ir_rvalue *lhs = read_rvalue();
+      ir_rvalue *rhs = read_rvalue();
+      ir_rvalue *condition = read_rvalue();
+      const uint32_t write_mask = blob_read_uint32(blob);
+
+      if (failed() || lhs == NULL || rhs == NULL || !lhs->as_dereference())
+         break;
+
+      /* The constructor asserts on this, check it up front. */
+      if ((lhs->type->is_scalar() || lhs->type->is_vector()) &&
+          _mesa_bitcount(write_mask & 0xf) != rhs->type->vector_elements)
+         break;
+      return new(mem_ctx) ir_assignment(lhs->as_dereference(), rhs,
+                                        condition, write_mask);
+   }
+   case ir_type_call: {
+      ir_function_signature *callee = read_callee();
+      ir_rvalue *return_deref = read_rvalue();
+      exec_list actual_parameters;
+
+      if (callee == NULL || !read_instructions(&actual_parameters))
+         break;
+      if (return_deref != NULL && !return_deref->as_dereference_variable())
+         break;
+      return new(mem_ctx) ir_call(callee,
+                                  return_deref ?
+                                  return_deref->as_dereference_variable() :
+                                  NULL,
+                                  &actual_parameters);
+   }
+   case ir_type_function:
+      return read_function();
+   case ir_type_if: {
+      ir_if *iff = new(mem_ctx) ir_if(read_rvalue());
+      if (iff->condition == NULL ||
+          !read_instructions(&iff->then_instructions) ||
+          !read_instructions(&iff->else_instructions))
+         break;
+      return iff;
+   }
+   case ir_type_loop: {
+      ir_loop *loop = new(mem_ctx) ir_loop;
+      if (!read_instructions(&loop->body_instructions))
+         break;
+      return loop;
+   }
+   case ir_type_loop_jump: {
+      const uint32_t mode = blob_read_uint32(blob);
+      if (mode > ir_loop_jump::jump_continue)
+         break;
+      return new(mem_ctx) ir_loop_jump((ir_loop_jump::jump_mode) mode);
+   }
+   case ir_type_return:
+      return new(mem_ctx) ir_return(read_rvalue());
+   case ir_type_discard:
+      return new(mem_ctx) ir_discard(read_rvalue());
+   case ir_type_emit_vertex: {
+      ir_rvalue *stream = read_rvalue();
+      if (stream == NULL)
+         break;
+      return new(mem_ctx) ir_emit_vertex(stream);
+   }
+   case ir_type_end_primitive: {
+      ir_rvalue *stream = read_rvalue();
+      if (stream == NULL)
+         break;
+      return new(mem_ctx) ir_end_primitive(stream);
+   }
+   case ir_type_barrier:
+      return new(mem_ctx) ir_barrier;
+   default:
+      break;
+   }
+
+   error = true;
+   return NULL;
+}
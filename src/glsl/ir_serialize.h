@@ -0,0 +1,164 @@
+/* -*- c++ -*- */
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef IR_SERIALIZE_H
+#define IR_SERIALIZE_H
+
+#include "ir.h"
+#include "blob.h"
+
+/**
+ * \file ir_serialize.h
+ *
+ * Translation of GLSL IR to and from the compact binary form written by
+ * blob.h.
+ *
+ * The format is only meant to be read back by the same build of Mesa that
+ * wrote it: types are written as indices into the table of built-in types
+ * and variable data is copied verbatim.
+ */
+
+/**
+ * Resolves references to objects that live outside of the IR being read,
+ * such as calls to built-in functions or uses of global variables that were
+ * not declared in the serialized instruction stream.
+ */
+class ir_deserialize_resolver {
+public:
+   virtual ~ir_deserialize_resolver()
+   {
+   }
+
+   /**
+    * Return the \c index'th signature of the function called \c name, or
+    * NULL if there is no such signature.
+    */
+   virtual ir_function_signature *get_signature(const char *name,
+                                                unsigned index) = 0;
+
+   /** Return the global variable called \c name, or NULL. */
+   virtual ir_variable *get_variable(const char *name) = 0;
+};
+
+
+class ir_serializer {
+public:
+   ir_serializer(struct blob *blob);
+   ~ir_serializer();
+
+   void write_type(const glsl_type *type);
+
+   /** Write the return type, flags and parameters of a signature. */
+   void write_prototype(const ir_function_signature *sig);
+   void write_body(const ir_function_signature *sig);
+
+   /**
+    * Write a signature body so that it can be read back without the
+    * prototype, by ir_deserializer::read_detached_body().
+    *
+    * Must be the first thing written by this serializer, the parameters
+    * take the first variable ids.
+    */
+   void write_detached_body(const ir_function_signature *sig);
+
+   void write_instructions(const exec_list *list);
+
+   /**
+    * Write the top-level instruction list of a shader.
+    *
+    * The prototypes of all the functions are written before any of the
+    * bodies, so calls don't depend on the order of the functions in the
+    * list.
+    */
+   void write_shader(const exec_list *ir);
+
+private:
+   void write_instruction(ir_instruction *ir);
+   void write_rvalue(ir_rvalue *ir);
+   void write_variable(ir_variable *var);
+   void write_constant(ir_constant *c);
+   void write_function(ir_function *f);
+
+   struct blob *blob;
+
+   /** Maps ir_variable pointers to (id + 1) */
+   struct hash_table *var_ids;
+   unsigned num_vars;
+};
+
+
+class ir_deserializer {
+public:
+   ir_deserializer(void *mem_ctx, struct blob_reader *blob,
+                   ir_deserialize_resolver *resolver);
+   ~ir_deserializer();
+
+   const glsl_type *read_type();
+
+   ir_function_signature *
+   read_prototype(builtin_available_predicate avail = NULL);
+   bool read_body(ir_function_signature *sig);
+
+   /**
+    * Read a body written by ir_serializer::write_detached_body() into a
+    * signature whose prototype was read by a different deserializer.
+    */
+   bool read_detached_body(ir_function_signature *sig);
+
+   bool read_instructions(exec_list *list);
+
+   /** Read a list written by ir_serializer::write_shader(). */
+   bool read_shader(exec_list *ir);
+
+   /** Has anything gone wrong so far? */
+   bool failed() const
+   {
+      return error || blob->overrun;
+   }
+
+private:
+   ir_instruction *read_instruction();
+   ir_instruction *read_node(uint32_t ir_type);
+   ir_rvalue *read_rvalue();
+   ir_variable *read_variable();
+   ir_constant *read_constant();
+   ir_function *read_function();
+   ir_function_signature *read_callee();
+   void add_variable(ir_variable *var);
+
+   void *mem_ctx;
+   struct blob_reader *blob;
+   ir_deserialize_resolver *resolver;
+   bool error;
+
+   ir_variable **vars;
+   unsigned num_vars;
+   unsigned vars_size;
+
+   /** Functions read from this stream so far, by name */
+   struct hash_table *functions;
+};
+
+#endif /* IR_SERIALIZE_H */
@@ -85,12 +85,29 @@ public:
 	 return visit_continue;
       }
 
-      /* Try to find the signature in one of the other shaders that is being
-       * linked.  If it's not found there, return an error.
+      /* A call to a built-in function already points at its definition in
+       * the built-in function shader.  Use it as is rather than looking it
+       * up there.  Other threads may be loading built-ins into that shader
+       * while this one links, so hold the built-in lock until the
+       * definition has been cloned.
+       *
+       * Otherwise, try to find the signature in one of the other shaders
+       * that is being linked.  If it's not found there, return an error.
        */
-      sig = find_matching_signature(name, &ir->actual_parameters, shader_list,
-				    num_shaders, ir->use_builtin);
+      if (ir->use_builtin) {
+         _mesa_glsl_lock_builtin_functions();
+         sig = ir->callee;
+         if (!sig->is_defined && !sig->is_intrinsic)
+            sig = NULL;
+      } else {
+         sig = find_matching_signature(name, &ir->actual_parameters,
+                                       shader_list, num_shaders, false);
+      }
+
       if (sig == NULL) {
+         if (ir->use_builtin)
+            _mesa_glsl_unlock_builtin_functions();
+
 	 /* FINISHME: Log the full signature of unresolved function.
 	  */
 	 linker_error(this->prog, "unresolved reference to function `%s'\n",
@@ -165,6 +182,9 @@ public:
          linked_sig->is_defined = true;
       }
 
+      if (ir->use_builtin)
+         _mesa_glsl_unlock_builtin_functions();
+
       hash_table_dtor(ht);
 
       /* Patch references inside the function to things outside the function
@@ -21,6 +21,10 @@
  * DEALINGS IN THE SOFTWARE.
  */
 #include <getopt.h>
+#include <time.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
 
 /** @file main.cpp
  *
@@ -258,12 +262,14 @@ int dump_ast = 0;
 int dump_hir = 0;
 int dump_lir = 0;
 int do_link = 0;
+int print_stats = 0;
 
 const struct option compiler_opts[] = {
    { "dump-ast", no_argument, &dump_ast, 1 },
    { "dump-hir", no_argument, &dump_hir, 1 },
    { "dump-lir", no_argument, &dump_lir, 1 },
    { "link",     no_argument, &do_link,  1 },
+   { "stats",    no_argument, &print_stats, 1 },
    { "version",  required_argument, NULL, 'v' },
    { NULL, 0, NULL, 0 }
 };
@@ -287,13 +293,36 @@ usage_fail(const char *name)
 }
 
 
+static double
+elapsed_ms(clock_t start)
+{
+   return (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+/**
+ * Print the CPU time spent setting up the built-in functions and compiling,
+ * and the peak resident memory of the process.
+ */
+static void
+dump_stats(double builtins_ms, double compile_ms)
+{
+   printf("Built-in functions initialized in %.3f ms\n", builtins_ms);
+   printf("Shaders compiled%s in %.3f ms\n",
+          do_link ? " and linked" : "", compile_ms);
+#ifndef _WIN32
+   struct rusage usage;
+   if (getrusage(RUSAGE_SELF, &usage) == 0)
+      printf("Peak resident memory: %ld KiB\n", (long) usage.ru_maxrss);
+#endif
+}
+
 void
 compile_shader(struct gl_context *ctx, struct gl_shader *shader)
 {
    struct _mesa_glsl_parse_state *state =
       new(shader) _mesa_glsl_parse_state(ctx, shader->Stage, shader);
 
-   _mesa_glsl_compile_shader(ctx, shader, dump_ast, dump_hir);
+   _mesa_glsl_compile_shader(ctx, shader, dump_ast, dump_hir, true, 0);
 
    /* Print out the resulting IR */
    if (!state->error && dump_lir) {
@@ -347,6 +376,15 @@ main(int argc, char **argv)
 
    initialize_context(ctx, (glsl_es) ? API_OPENGLES2 : API_OPENGL_COMPAT);
 
+   /* The compiler would do this on the first call to a built-in function,
+    * do it up front so it can be timed separately.
+    */
+   clock_t start = clock();
+   _mesa_glsl_initialize_builtin_functions();
+   const double builtins_ms = elapsed_ms(start);
+
+   start = clock();
+
    struct gl_shader_program *whole_program;
 
    whole_program = rzalloc (NULL, struct gl_shader_program);
@@ -413,6 +451,9 @@ main(int argc, char **argv)
 	 printf("Info log for linking:\n%s\n", whole_program->InfoLog);
    }
 
+   if (print_stats)
+      dump_stats(builtins_ms, elapsed_ms(start));
+
    for (unsigned i = 0; i < MESA_SHADER_STAGES; i++)
       ralloc_free(whole_program->_LinkedShaders[i]);
 
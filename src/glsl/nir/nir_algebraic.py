@@ -29,6 +29,7 @@ import struct
 import sys
 import mako.template
 import re
+from nir_opcodes import opcodes
 
 # Represents a set of variables, each with a unique id
 class VarSet(object):
@@ -177,6 +178,130 @@ class SearchAndReplace(object):
       else:
          self.replace = Value.create(replace, "replace{0}".format(self.id), varset)
 
+class TreeAutomaton(object):
+   """Bottom-up tree automaton matching the search expressions of a pass.
+
+   Every subexpression of the search expressions is an item: a tuple of the
+   opcode and the items of its sources, where a variable is the wildcard
+   item, and a constant or a variable that only matches constants is the
+   constant item.  The state of an SSA value is the set of items it
+   matches, which depends only on the opcode of the instruction defining it
+   and the states of that instruction's sources.  So the states, and the
+   table mapping an opcode and source states to the resulting state, can be
+   computed up front, as in Chase's "An improvement to bottom-up tree
+   pattern matching" (POPL '87).
+
+   To keep the tables small, the state of each source is first reduced to
+   the items that can appear as a source of the opcode at hand, and it is
+   that filtered state the tables are indexed with.
+
+   The automaton only looks at the shape of the expressions, so a state
+   containing the top item of a search expression means that the
+   expression may match; nir_replace_instr() still has the final word.
+   """
+
+   wildcard = '__wildcard'
+   constant = '__const'
+
+   def __init__(self, xforms):
+      # The items that are expressions, per opcode
+      self.items = {}
+      # The items that appear as a source of an expression, per opcode
+      self.src_items = {}
+
+      self.xform_items = [self._add_item(xform.search) for xform in xforms]
+
+      self.opcodes = sorted(self.items.keys())
+      self._compute_states()
+
+   def _add_item(self, val):
+      if isinstance(val, Expression):
+         item = (val.opcode, tuple(self._add_item(src) for src in val.sources))
+         self.items.setdefault(val.opcode, set()).add(item)
+         self.src_items.setdefault(val.opcode, set()).update(item[1])
+         return item
+      elif isinstance(val, Constant) or val.is_constant:
+         return self.constant
+      else:
+         return self.wildcard
+
+   @staticmethod
+   def _is_commutative(opcode):
+      return 'commutative' in opcodes[opcode].algebraic_properties
+
+   def _item_matches(self, item, src_states):
+      srcs = item[1]
+      if all(src in state for (src, state) in zip(srcs, src_states)):
+         return True
+
+      if self._is_commutative(item[0]):
+         assert len(srcs) == 2
+         return srcs[0] in src_states[1] and srcs[1] in src_states[0]
+
+      return False
+
+   def _compute_states(self):
+      # State 0 is that of anything but a constant or an ALU instruction
+      # that may match, and state 1 is that of a load_const.
+      self.states = [frozenset([self.wildcard]),
+                     frozenset([self.wildcard, self.constant])]
+      state_index = dict((state, i) for (i, state) in enumerate(self.states))
+
+      # Per opcode, the filtered states and the index each state filters to
+      self.filtered_states = dict((op, []) for op in self.opcodes)
+      self.filters = dict((op, []) for op in self.opcodes)
+      self.tables = dict((op, {}) for op in self.opcodes)
+
+      def add_state(state):
+         if state not in state_index:
+            state_index[state] = len(self.states)
+            self.states.append(state)
+
+      done = False
+      while not done:
+         done = True
+
+         for op in self.opcodes:
+            filtered = self.filtered_states[op]
+            filtered_index = dict((f, i) for (i, f) in enumerate(filtered))
+            filt = self.filters[op]
+
+            for state in self.states[len(filt):]:
+               f = state & self.src_items[op]
+               if f not in filtered_index:
+                  filtered_index[f] = len(filtered)
+                  filtered.append(f)
+               filt.append(filtered_index[f])
+
+            num_inputs = opcodes[op].num_inputs
+            for srcs in itertools.product(range(len(filtered)),
+                                          repeat=num_inputs):
+               if srcs in self.tables[op]:
+                  continue
+
+               src_states = [filtered[src] for src in srcs]
+               state = frozenset([self.wildcard] +
+                                 [item for item in self.items[op]
+                                  if self._item_matches(item, src_states)])
+               add_state(state)
+               self.tables[op][srcs] = state_index[state]
+               done = False
+
+      assert len(self.states) < (1 << 16)
+
+   def table(self, op):
+      """The transition table of an opcode, flattened with the filtered
+      state of the first source varying the slowest."""
+      num_filtered = len(self.filtered_states[op])
+      num_inputs = opcodes[op].num_inputs
+      return [self.tables[op][srcs] for srcs in
+              itertools.product(range(num_filtered), repeat=num_inputs)]
+
+   def state_xforms(self, state):
+      """The indices of the transforms that may match in a state."""
+      return [i for (i, item) in enumerate(self.xform_items)
+              if item in self.states[state]]
+
 _algebraic_pass_template = mako.template.Template("""
 #include "nir.h"
 #include "nir_search.h"
@@ -190,27 +315,144 @@ struct transform {
    unsigned condition_offset;
 };
 
+/* The transitions of the matching automaton for one opcode */
+struct per_op_table {
+   /** Maps each state to the index of the filtered state */
+   const uint16_t *filter;
+   /** The state of an instruction, indexed by its filtered source states */
+   const uint16_t *table;
+   uint16_t num_filtered_states;
+};
+
+/* The transforms that may match an instruction in a given state */
+struct state_xforms {
+   const uint16_t *xforms;
+   unsigned num_xforms;
+};
+
+#define AUTOMATON_STATE_UNKNOWN 0xffff
+
 struct opt_state {
    void *mem_ctx;
    bool progress;
    const bool *condition_flags;
+
+   /** The automaton state of each SSA value, indexed by SSA index */
+   uint16_t *states;
+   unsigned num_states;
 };
 
 #endif
 
-% for (opcode, xform_list) in xform_dict.iteritems():
-% for xform in xform_list:
+% for xform in xforms:
    ${xform.search.render()}
    ${xform.replace.render()}
 % endfor
 
-static const struct transform ${pass_name}_${opcode}_xforms[] = {
-% for xform in xform_list:
+static const struct transform ${pass_name}_xforms[] = {
+% for xform in xforms:
    { &${xform.search.name}, ${xform.replace.c_ptr}, ${xform.condition_index} },
 % endfor
 };
+
+% for op in automaton.opcodes:
+static const uint16_t ${pass_name}_${op}_filter[] = {
+% for i in automaton.filters[op]:
+   ${i},
+% endfor
+};
+
+static const uint16_t ${pass_name}_${op}_table[] = {
+% for state in automaton.table(op):
+   ${state},
+% endfor
+};
+
+% endfor
+static const struct per_op_table ${pass_name}_table[nir_num_opcodes] = {
+% for op in automaton.opcodes:
+   [nir_op_${op}] = {
+      ${pass_name}_${op}_filter,
+      ${pass_name}_${op}_table,
+      ${len(automaton.filtered_states[op])},
+   },
+% endfor
+};
+
+% for state in range(len(automaton.states)):
+% if automaton.state_xforms(state):
+static const uint16_t ${pass_name}_state${state}_xforms[] = {
+% for i in automaton.state_xforms(state):
+   ${i},
+% endfor
+};
+% endif
 % endfor
 
+static const struct state_xforms ${pass_name}_state_xforms[] = {
+% for state in range(len(automaton.states)):
+% if automaton.state_xforms(state):
+   { ${pass_name}_state${state}_xforms, ${len(automaton.state_xforms(state))} },
+% else:
+   { NULL, 0 },
+% endif
+% endfor
+};
+
+static uint16_t
+${pass_name}_ssa_state(nir_ssa_def *def, struct opt_state *state);
+
+static uint16_t
+${pass_name}_src_state(const nir_src *src, struct opt_state *state)
+{
+   return src->is_ssa ? ${pass_name}_ssa_state(src->ssa, state) : 0;
+}
+
+/**
+ * Run the automaton on an SSA value, remembering the state of every value,
+ * including those the pass's replacements add.  The pass visits every
+ * instruction after its sources, so those are almost always known.
+ */
+static uint16_t
+${pass_name}_ssa_state(nir_ssa_def *def, struct opt_state *state)
+{
+   if (def->index >= state->num_states) {
+      unsigned num_states = MAX2(def->index + 1, state->num_states * 2);
+
+      state->states = reralloc(NULL, state->states, uint16_t, num_states);
+      memset(state->states + state->num_states, 0xff,
+             (num_states - state->num_states) * sizeof(uint16_t));
+      state->num_states = num_states;
+   } else if (state->states[def->index] != AUTOMATON_STATE_UNKNOWN) {
+      return state->states[def->index];
+   }
+
+   uint16_t result = 0;
+
+   if (def->parent_instr->type == nir_instr_type_load_const) {
+      result = 1;
+   } else if (def->parent_instr->type == nir_instr_type_alu) {
+      nir_alu_instr *alu = nir_instr_as_alu(def->parent_instr);
+      const struct per_op_table *tbl = &${pass_name}_table[alu->op];
+
+      if (tbl->table) {
+         unsigned index = 0;
+
+         for (unsigned i = 0; i < nir_op_infos[alu->op].num_inputs; i++) {
+            uint16_t src_state =
+               ${pass_name}_src_state(&alu->src[i].src, state);
+            index = index * tbl->num_filtered_states + tbl->filter[src_state];
+         }
+
+         result = tbl->table[index];
+      }
+   }
+
+   state->states[def->index] = result;
+
+   return result;
+}
+
 static bool
 ${pass_name}_block(nir_block *block, void *void_state)
 {
@@ -224,22 +466,18 @@ ${pass_name}_block(nir_block *block, void *void_state)
       if (!alu->dest.dest.is_ssa)
          continue;
 
-      switch (alu->op) {
-      % for opcode in xform_dict.keys():
-      case nir_op_${opcode}:
-         for (unsigned i = 0; i < ARRAY_SIZE(${pass_name}_${opcode}_xforms); i++) {
-            const struct transform *xform = &${pass_name}_${opcode}_xforms[i];
-            if (state->condition_flags[xform->condition_offset] &&
-                nir_replace_instr(alu, xform->search, xform->replace,
-                                  state->mem_ctx)) {
-               state->progress = true;
-               break;
-            }
+      const struct state_xforms *xforms =
+         &${pass_name}_state_xforms[${pass_name}_ssa_state(&alu->dest.dest.ssa,
+                                                           state)];
+
+      for (unsigned i = 0; i < xforms->num_xforms; i++) {
+         const struct transform *xform = &${pass_name}_xforms[xforms->xforms[i]];
+         if (state->condition_flags[xform->condition_offset] &&
+             nir_replace_instr(alu, xform->search, xform->replace,
+                               state->mem_ctx)) {
+            state->progress = true;
+            break;
          }
-         break;
-      % endfor
-      default:
-         break;
       }
    }
 
@@ -255,8 +493,14 @@ ${pass_name}_impl(nir_function_impl *impl, const bool *condition_flags)
    state.progress = false;
    state.condition_flags = condition_flags;
 
+   state.num_states = impl->ssa_alloc;
+   state.states = ralloc_array(NULL, uint16_t, state.num_states);
+   memset(state.states, 0xff, state.num_states * sizeof(uint16_t));
+
    nir_foreach_block(impl, ${pass_name}_block, &state);
 
+   ralloc_free(state.states);
+
    if (state.progress)
       nir_metadata_preserve(impl, nir_metadata_block_index |
                                   nir_metadata_dominance);
@@ -287,19 +531,19 @@ ${pass_name}(nir_shader *shader)
 
 class AlgebraicPass(object):
    def __init__(self, pass_name, transforms):
-      self.xform_dict = {}
+      self.xforms = []
       self.pass_name = pass_name
 
       for xform in transforms:
          if not isinstance(xform, SearchAndReplace):
             xform = SearchAndReplace(xform)
 
-         if xform.search.opcode not in self.xform_dict:
-            self.xform_dict[xform.search.opcode] = []
+         self.xforms.append(xform)
 
-         self.xform_dict[xform.search.opcode].append(xform)
+      self.automaton = TreeAutomaton(self.xforms)
 
    def render(self):
       return _algebraic_pass_template.render(pass_name=self.pass_name,
-                                             xform_dict=self.xform_dict,
+                                             xforms=self.xforms,
+                                             automaton=self.automaton,
                                              condition_list=condition_list)
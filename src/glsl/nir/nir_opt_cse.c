@@ -28,11 +28,17 @@
 #include "nir.h"
 
 /*
- * Implements common subexpression elimination
+ * Implements common subexpression elimination as hash-based global value
+ * numbering.  The blocks are walked in dominance-tree order, and every
+ * instruction that can be CSE'd is looked up in a set of the instructions
+ * dominating it, keyed by a hash of its opcode, sources, swizzles and
+ * indices.  The instructions of a block leave the set again when the walk
+ * is done with the part of the tree below that block.
  */
 
 struct cse_state {
    void *mem_ctx;
+   struct set *instr_set;
    bool progress;
 };
 
@@ -225,51 +231,203 @@ nir_instr_get_dest_ssa_def(nir_instr *instr)
    }
 }
 
+#define HASH(hash, data) _mesa_fnv32_1a_accumulate((hash), (data))
+
+static uint32_t
+hash_src(uint32_t hash, const nir_src *src)
+{
+   assert(src->is_ssa);
+   return HASH(hash, src->ssa);
+}
+
+static uint32_t
+hash_alu_src(uint32_t hash, nir_alu_instr *instr, unsigned src)
+{
+   hash = HASH(hash, instr->src[src].abs);
+   hash = HASH(hash, instr->src[src].negate);
+
+   for (unsigned i = 0; i < nir_ssa_alu_instr_src_components(instr, src); i++)
+      hash = HASH(hash, instr->src[src].swizzle[i]);
+
+   return hash_src(hash, &instr->src[src].src);
+}
+
+static uint32_t
+hash_alu(uint32_t hash, nir_alu_instr *instr)
+{
+   hash = HASH(hash, instr->op);
+   hash = HASH(hash, instr->dest.dest.ssa.num_components);
+
+   if (nir_op_infos[instr->op].algebraic_properties & NIR_OP_IS_COMMUTATIVE) {
+      assert(nir_op_infos[instr->op].num_inputs == 2);
+
+      /* Hash the sources in an order that doesn't depend on the order they
+       * appear in, so that a + b and b + a land in the same bucket.
+       */
+      uint32_t hash0 = hash_alu_src(_mesa_fnv32_1a_offset_bias, instr, 0);
+      uint32_t hash1 = hash_alu_src(_mesa_fnv32_1a_offset_bias, instr, 1);
+
+      if (hash0 > hash1) {
+         uint32_t tmp = hash0;
+         hash0 = hash1;
+         hash1 = tmp;
+      }
+
+      hash = HASH(hash, hash0);
+      hash = HASH(hash, hash1);
+   } else {
+      for (unsigned i = 0; i < nir_op_infos[instr->op].num_inputs; i++)
+         hash = hash_alu_src(hash, instr, i);
+   }
+
+   return hash;
+}
+
+static uint32_t
+hash_load_const(uint32_t hash, nir_load_const_instr *instr)
+{
+   hash = HASH(hash, instr->def.num_components);
+
+   return _mesa_fnv32_1a_accumulate_block(hash, instr->value.f,
+                                          instr->def.num_components *
+                                          sizeof(instr->value.f[0]));
+}
+
+static uint32_t
+hash_phi(uint32_t hash, nir_phi_instr *instr)
+{
+   hash = HASH(hash, instr->instr.block);
+
+   /* The sources of a phi aren't in any particular order, so sum up the
+    * hashes of the (predecessor, source) pairs instead of chaining them.
+    */
+   uint32_t srcs_hash = 0;
+   nir_foreach_phi_src(instr, src) {
+      uint32_t src_hash = HASH(_mesa_fnv32_1a_offset_bias, src->pred);
+      srcs_hash += hash_src(src_hash, &src->src);
+   }
+
+   return HASH(hash, srcs_hash);
+}
+
+static uint32_t
+hash_intrinsic(uint32_t hash, nir_intrinsic_instr *instr)
+{
+   const nir_intrinsic_info *info = &nir_intrinsic_infos[instr->intrinsic];
+
+   hash = HASH(hash, instr->intrinsic);
+   hash = HASH(hash, instr->num_components);
+
+   if (info->has_dest)
+      hash = HASH(hash, instr->dest.ssa.num_components);
+
+   for (unsigned i = 0; i < info->num_srcs; i++)
+      hash = hash_src(hash, &instr->src[i]);
+
+   return _mesa_fnv32_1a_accumulate_block(hash, instr->const_index,
+                                          info->num_indices *
+                                          sizeof(instr->const_index[0]));
+}
+
+/**
+ * Hash an instruction consistently with nir_instrs_equal().
+ */
+static uint32_t
+hash_instr(const void *data)
+{
+   nir_instr *instr = (nir_instr *) data;
+   uint32_t hash = _mesa_fnv32_1a_offset_bias;
+
+   hash = HASH(hash, instr->type);
+
+   switch (instr->type) {
+   case nir_instr_type_alu:
+      return hash_alu(hash, nir_instr_as_alu(instr));
+   case nir_instr_type_load_const:
+      return hash_load_const(hash, nir_instr_as_load_const(instr));
+   case nir_instr_type_phi:
+      return hash_phi(hash, nir_instr_as_phi(instr));
+   case nir_instr_type_intrinsic:
+      return hash_intrinsic(hash, nir_instr_as_intrinsic(instr));
+   default:
+      unreachable("We never hash any of these");
+   }
+}
+
+static bool
+cmp_instrs(const void *data1, const void *data2)
+{
+   return nir_instrs_equal((nir_instr *) data1, (nir_instr *) data2);
+}
+
 static void
 nir_opt_cse_instr(nir_instr *instr, struct cse_state *state)
 {
    if (!nir_instr_can_cse(instr))
       return;
 
-   for (struct exec_node *node = instr->node.prev;
-        !exec_node_is_head_sentinel(node); node = node->prev) {
-      nir_instr *other = exec_node_data(nir_instr, node, node);
-      if (nir_instrs_equal(instr, other)) {
-         nir_ssa_def *other_def = nir_instr_get_dest_ssa_def(other);
-         nir_ssa_def_rewrite_uses(nir_instr_get_dest_ssa_def(instr),
-                                  nir_src_for_ssa(other_def),
-                                  state->mem_ctx);
-         nir_instr_remove(instr);
-         state->progress = true;
-         return;
-      }
+   const uint32_t hash = hash_instr(instr);
+   struct set_entry *entry =
+      _mesa_set_search_pre_hashed(state->instr_set, hash, instr);
+
+   if (entry) {
+      nir_instr *other = (nir_instr *) entry->key;
+      nir_ssa_def *other_def = nir_instr_get_dest_ssa_def(other);
+      nir_ssa_def_rewrite_uses(nir_instr_get_dest_ssa_def(instr),
+                               nir_src_for_ssa(other_def),
+                               state->mem_ctx);
+      nir_instr_remove(instr);
+      state->progress = true;
+   } else {
+      _mesa_set_add_pre_hashed(state->instr_set, hash, instr);
    }
+}
 
-   for (nir_block *block = instr->block->imm_dom;
-        block != NULL; block = block->imm_dom) {
-      nir_foreach_instr_reverse(block, other) {
-         if (nir_instrs_equal(instr, other)) {
-            nir_ssa_def *other_def = nir_instr_get_dest_ssa_def(other);
-            nir_ssa_def_rewrite_uses(nir_instr_get_dest_ssa_def(instr),
-                                     nir_src_for_ssa(other_def),
-                                     state->mem_ctx);
-            nir_instr_remove(instr);
-            state->progress = true;
-            return;
-         }
-      }
-   }
+static void
+nir_opt_cse_remove_instr(nir_instr *instr, struct cse_state *state)
+{
+   if (!nir_instr_can_cse(instr))
+      return;
+
+   struct set_entry *entry = _mesa_set_search(state->instr_set, instr);
+   if (entry && entry->key == instr)
+      _mesa_set_remove(state->instr_set, entry);
 }
 
-static bool
-nir_opt_cse_block(nir_block *block, void *void_state)
+static void
+nir_opt_cse_block(nir_block *block, struct cse_state *state)
 {
-   struct cse_state *state = void_state;
+   nir_foreach_instr_safe(block, instr) {
+      if (instr->type != nir_instr_type_phi)
+         break;
 
-   nir_foreach_instr_safe(block, instr)
       nir_opt_cse_instr(instr, state);
+   }
 
-   return true;
+   /* A phi is only ever equal to another phi of its own block, and the
+    * sources of a phi in a loop header get rewritten when the walk reaches
+    * the end of the loop, which would change its hash.  So the phis leave
+    * the set before anything else is visited.
+    */
+   nir_foreach_instr(block, instr) {
+      if (instr->type != nir_instr_type_phi)
+         break;
+
+      nir_opt_cse_remove_instr(instr, state);
+   }
+
+   nir_foreach_instr_safe(block, instr) {
+      if (instr->type != nir_instr_type_phi)
+         nir_opt_cse_instr(instr, state);
+   }
+
+   for (unsigned i = 0; i < block->num_dom_children; i++)
+      nir_opt_cse_block(block->dom_children[i], state);
+
+   nir_foreach_instr(block, instr) {
+      if (instr->type != nir_instr_type_phi)
+         nir_opt_cse_remove_instr(instr, state);
+   }
 }
 
 static bool
@@ -278,11 +436,14 @@ nir_opt_cse_impl(nir_function_impl *impl)
    struct cse_state state;
 
    state.mem_ctx = ralloc_parent(impl);
+   state.instr_set = _mesa_set_create(NULL, hash_instr, cmp_instrs);
    state.progress = false;
 
    nir_metadata_require(impl, nir_metadata_dominance);
 
-   nir_foreach_block(impl, nir_opt_cse_block, &state);
+   nir_opt_cse_block(impl->start_block, &state);
+
+   _mesa_set_destroy(state.instr_set, NULL);
 
    if (state.progress)
       nir_metadata_preserve(impl, nir_metadata_block_index |
@@ -28,9 +28,14 @@
 extern "C" {
 #endif
 
+/**
+ * Compile \c shader with the GLSL_x \c flags, which are passed in rather
+ * than read from ctx->_Shader since this may run on a worker thread.
+ */
 extern void
 _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
-			  bool dump_ast, bool dump_hir);
+			  bool dump_ast, bool dump_hir, bool force_recompile,
+			  GLbitfield flags);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -0,0 +1,1177 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file shader_cache.cpp
+ *
+ * The linked state of a program is written in a fixed order: the program's
+ * scalar fields, each linked shader (its fields, then its IR), and the
+ * program's tables.  Pointers between the tables (uniform storage, the
+ * remap table) are written as indices.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_DLOPEN
+#include <dlfcn.h>
+#include <sys/stat.h>
+#endif
+#include "main/core.h"
+#include "main/shaderobj.h"
+#include "program/hash_table.h"
+#include "util/hash_table.h"
+#include "c11/threads.h"
+#include "ir_serialize.h"
+#include "ir_uniform.h"
+#include "shader_cache.h"
+
+#ifdef ENABLE_SHADER_CACHE
+#include "util/disk_cache.h"
+#include "util/mesa-sha1.h"
+#endif
+
+
+/** Number of gl_constant_value slots link_assign_uniform_locations() gives */
+static unsigned
+uniform_storage_slots(const gl_uniform_storage *uni)
+{
+   const unsigned slots =
+      uni->type->is_sampler() ? 1 : uni->type->component_slots();
+
+   return slots * MAX2(1, uni->array_elements);
+}
+
+static void
+write_uniform_blocks(struct blob *blob, ir_serializer *s,
+                     const gl_uniform_block *blocks, unsigned num_blocks)
+{
+   blob_write_uint32(blob, num_blocks);
+
+   for (unsigned i = 0; i < num_blocks; i++) {
+      const gl_uniform_block *b = &blocks[i];
+
+      blob_write_string(blob, b->Name);
+      blob_write_uint32(blob, b->Binding);
+      blob_write_uint32(blob, b->UniformBufferSize);
+      blob_write_uint32(blob, b->_Packing);
+      blob_write_uint32(blob, b->NumUniforms);
+
+      for (unsigned j = 0; j < b->NumUniforms; j++) {
+         const gl_uniform_buffer_variable *u = &b->Uniforms[j];
+
+         blob_write_string(blob, u->Name);
+         blob_write_uint32(blob, u->IndexName == u->Name);
+         if (u->IndexName != u->Name)
+            blob_write_string(blob, u->IndexName);
+         s->write_type(u->Type);
+         blob_write_uint32(blob, u->Offset);
+         blob_write_uint32(blob, u->RowMajor);
+      }
+   }
+}
+
+static gl_uniform_block *
+read_uniform_blocks(struct blob_reader *blob, ir_deserializer *d,
+                    void *mem_ctx, unsigned *num_blocks)
+{
+   *num_blocks = blob_read_uint32(blob);
+   if (*num_blocks == 0 || d->failed())
+      return NULL;
+
+   gl_uniform_block *blocks =
+      rzalloc_array(mem_ctx, gl_uniform_block, *num_blocks);
+   if (blocks == NULL)
+      return NULL;
+
+   for (unsigned i = 0; i < *num_blocks; i++) {
+      gl_uniform_block *b = &blocks[i];
+      const char *name = blob_read_string(blob);
+
+      b->Binding = blob_read_uint32(blob);
+      b->UniformBufferSize = blob_read_uint32(blob);
+      b->_Packing = (gl_uniform_block_packing) blob_read_uint32(blob);
+      b->NumUniforms = blob_read_uint32(blob);
+      if (name == NULL || d->failed())
+         return NULL;
+
+      b->Name = ralloc_strdup(blocks, name);
+      b->Uniforms = rzalloc_array(blocks, gl_uniform_buffer_variable,
+                                  b->NumUniforms);
+      if (b->Uniforms == NULL && b->NumUniforms != 0)
+         return NULL;
+
+      for (unsigned j = 0; j < b->NumUniforms; j++) {
+         gl_uniform_buffer_variable *u = &b->Uniforms[j];
+         const char *uniform_name = blob_read_string(blob);
+         const bool same_index_name = blob_read_uint32(blob);
+         const char *index_name =
+            same_index_name ? uniform_name : blob_read_string(blob);
+
+         u->Type = d->read_type();
+         u->Offset = blob_read_uint32(blob);
+         u->RowMajor = blob_read_uint32(blob);
+         if (uniform_name == NULL || index_name == NULL || u->Type == NULL ||
+             d->failed())
+            return NULL;
+
+         u->Name = ralloc_strdup(b->Uniforms, uniform_name);
+         u->IndexName = same_index_name ?
+            u->Name : ralloc_strdup(b->Uniforms, index_name);
+      }
+   }
+
+   return blocks;
+}
+
+static void
+write_shader(struct blob *blob, gl_shader *sh)
+{
+   ir_serializer s(blob);
+
+   blob_write_uint32(blob, sh->Type);
+   blob_write_uint32(blob, sh->Version);
+   blob_write_uint32(blob, sh->IsES);
+
+   blob_write_uint32(blob, sh->num_samplers);
+   blob_write_uint32(blob, sh->active_samplers);
+   blob_write_uint32(blob, sh->shadow_samplers);
+   blob_write_bytes(blob, sh->SamplerUnits, sizeof(sh->SamplerUnits));
+   for (unsigned i = 0; i < MAX_SAMPLERS; i++)
+      blob_write_uint32(blob, sh->SamplerTargets[i]);
+
+   blob_write_uint32(blob, sh->num_uniform_components);
+   blob_write_uint32(blob, sh->num_combined_uniform_components);
+   write_uniform_blocks(blob, &s, sh->UniformBlocks, sh->NumUniformBlocks);
+
+   blob_write_uint32(blob, sh->uses_builtin_functions);
+   blob_write_uint32(blob, sh->uses_gl_fragcoord);
+   blob_write_uint32(blob, sh->redeclares_gl_fragcoord);
+   blob_write_uint32(blob, sh->ARB_fragment_coord_conventions_enable);
+   blob_write_uint32(blob, sh->origin_upper_left);
+   blob_write_uint32(blob, sh->pixel_center_integer);
+
+   blob_write_uint32(blob, sh->Geom.VerticesOut);
+   blob_write_uint32(blob, sh->Geom.Invocations);
+   blob_write_uint32(blob, sh->Geom.InputType);
+   blob_write_uint32(blob, sh->Geom.OutputType);
+
+   blob_write_bytes(blob, sh->ImageUnits, sizeof(sh->ImageUnits));
+   for (unsigned i = 0; i < MAX_IMAGE_UNIFORMS; i++)
+      blob_write_uint32(blob, sh->ImageAccess[i]);
+   blob_write_uint32(blob, sh->NumImages);
+   blob_write_uint32(blob, sh->EarlyFragmentTests);
+
+   for (unsigned i = 0; i < 3; i++)
+      blob_write_uint32(blob, sh->Comp.LocalSize[i]);
+
+   s.write_shader(sh->ir);
+}
+
+static gl_shader *
+read_shader(struct blob_reader *blob, struct gl_context *ctx,
+            gl_shader_stage stage)
+{
+   const GLenum type = blob_read_uint32(blob);
+   switch (type) {
+   case GL_VERTEX_SHADER:
+   case GL_GEOMETRY_SHADER:
+   case GL_FRAGMENT_SHADER:
+   case GL_COMPUTE_SHADER:
+      if (_mesa_shader_enum_to_shader_stage(type) == stage)
+         break;
+      /* fallthrough */
+   default:
+      return NULL;
+   }
+
+   gl_shader *sh = ctx->Driver.NewShader(NULL, 0, type);
+   if (sh == NULL)
+      return NULL;
+
+   sh->ir = new(sh) exec_list;
+   ir_deserializer d(sh->ir, blob, NULL);
+
+   sh->Version = blob_read_uint32(blob);
+   sh->IsES = blob_read_uint32(blob);
+
+   sh->num_samplers = blob_read_uint32(blob);
+   sh->active_samplers = blob_read_uint32(blob);
+   sh->shadow_samplers = blob_read_uint32(blob);
+   blob_copy_bytes(blob, sh->SamplerUnits, sizeof(sh->SamplerUnits));
+   for (unsigned i = 0; i < MAX_SAMPLERS; i++)
+      sh->SamplerTargets[i] = (gl_texture_index) blob_read_uint32(blob);
+
+   sh->num_uniform_components = blob_read_uint32(blob);
+   sh->num_combined_uniform_components = blob_read_uint32(blob);
+   sh->UniformBlocks = read_uniform_blocks(blob, &d, sh,
+                                           &sh->NumUniformBlocks);
+   if (sh->UniformBlocks == NULL)
+      sh->NumUniformBlocks = 0;
+
+   sh->uses_builtin_functions = blob_read_uint32(blob);
+   sh->uses_gl_fragcoord = blob_read_uint32(blob);
+   sh->redeclares_gl_fragcoord = blob_read_uint32(blob);
+   sh->ARB_fragment_coord_conventions_enable = blob_read_uint32(blob);
+   sh->origin_upper_left = blob_read_uint32(blob);
+   sh->pixel_center_integer = blob_read_uint32(blob);
+
+   sh->Geom.VerticesOut = blob_read_uint32(blob);
+   sh->Geom.Invocations = blob_read_uint32(blob);
+   sh->Geom.InputType = blob_read_uint32(blob);
+   sh->Geom.OutputType = blob_read_uint32(blob);
+
+   blob_copy_bytes(blob, sh->ImageUnits, sizeof(sh->ImageUnits));
+   for (unsigned i = 0; i < MAX_IMAGE_UNIFORMS; i++)
+      sh->ImageAccess[i] = blob_read_uint32(blob);
+   sh->NumImages = blob_read_uint32(blob);
+   sh->EarlyFragmentTests = blob_read_uint32(blob);
+
+   for (unsigned i = 0; i < 3; i++)
+      sh->Comp.LocalSize[i] = blob_read_uint32(blob);
+
+   if (d.failed() || sh->num_samplers > MAX_SAMPLERS ||
+       sh->NumImages > MAX_IMAGE_UNIFORMS || !d.read_shader(sh->ir)) {
+      ctx->Driver.DeleteShader(ctx, sh);
+      return NULL;
+   }
+
+   return sh;
+}
+
+static void
+write_uniforms(struct blob *blob, ir_serializer *s,
+               struct gl_shader_program *prog)
+{
+   blob_write_uint32(blob, prog->NumUniformStorage);
+   blob_write_uint32(blob, prog->NumHiddenUniforms);
+
+   for (unsigned i = 0; i < prog->NumUniformStorage; i++) {
+      const gl_uniform_storage *uni = &prog->UniformStorage[i];
+
+      blob_write_uint32(blob, uni->name != NULL);
+      if (uni->name != NULL)
+         blob_write_string(blob, uni->name);
+      s->write_type(uni->type);
+      blob_write_uint32(blob, uni->array_elements);
+      blob_write_uint32(blob, uni->initialized);
+      blob_write_bytes(blob, uni->sampler, sizeof(uni->sampler));
+      blob_write_bytes(blob, uni->image, sizeof(uni->image));
+      blob_write_uint32(blob, uni->block_index);
+      blob_write_uint32(blob, uni->offset);
+      blob_write_uint32(blob, uni->matrix_stride);
+      blob_write_uint32(blob, uni->array_stride);
+      blob_write_uint32(blob, uni->row_major);
+      blob_write_uint32(blob, uni->atomic_buffer_index);
+      blob_write_uint32(blob, uni->remap_location);
+      blob_write_uint32(blob, uni->hidden);
+      blob_write_uint32(blob, uni->builtin);
+
+      blob_write_uint32(blob, uni->storage != NULL);
+      if (uni->storage != NULL) {
+         blob_write_bytes(blob, uni->storage,
+                          uniform_storage_slots(uni) *
+                          sizeof(union gl_constant_value));
+      }
+   }
+
+   /* Entries of the remap table are written as 0 for unused locations, 1
+    * for explicit locations of inactive uniforms, and the index of the
+    * uniform plus 2 otherwise.
+    */
+   blob_write_uint32(blob, prog->NumUniformRemapTable);
+   for (unsigned i = 0; i < prog->NumUniformRemapTable; i++) {
+      const gl_uniform_storage *uni = prog->UniformRemapTable[i];
+
+      if (uni == NULL)
+         blob_write_uint32(blob, 0);
+      else if (uni == INACTIVE_UNIFORM_EXPLICIT_LOCATION)
+         blob_write_uint32(blob, 1);
+      else
+         blob_write_uint32(blob, uni - prog->UniformStorage + 2);
+   }
+}
+
+static bool
+read_uniforms(struct blob_reader *blob, ir_deserializer *d,
+              struct gl_shader_program *prog)
+{
+   const unsigned num_uniforms = blob_read_uint32(blob);
+   const unsigned num_hidden = blob_read_uint32(blob);
+   if (d->failed() || num_hidden > num_uniforms)
+      return false;
+
+   prog->UniformHash = new string_to_uint_map;
+
+   if (num_uniforms != 0) {
+      prog->UniformStorage =
+         rzalloc_array(prog, struct gl_uniform_storage, num_uniforms);
+      if (prog->UniformStorage == NULL)
+         return false;
+   }
+
+   /* Unlike the linker, every uniform's storage is allocated separately,
+    * since the total isn't known up front.  Nothing depends on the values
+    * being contiguous.
+    */
+   for (unsigned i = 0; i < num_uniforms; i++) {
+      gl_uniform_storage *uni = &prog->UniformStorage[i];
+      const char *name = blob_read_uint32(blob) ? blob_read_string(blob) : NULL;
+
+      uni->type = d->read_type();
+      uni->array_elements = blob_read_uint32(blob);
+      uni->initialized = blob_read_uint32(blob);
+      blob_copy_bytes(blob, (uint8_t *) uni->sampler, sizeof(uni->sampler));
+      blob_copy_bytes(blob, (uint8_t *) uni->image, sizeof(uni->image));
+      uni->block_index = blob_read_uint32(blob);
+      uni->offset = blob_read_uint32(blob);
+      uni->matrix_stride = blob_read_uint32(blob);
+      uni->array_stride = blob_read_uint32(blob);
+      uni->row_major = blob_read_uint32(blob);
+      uni->atomic_buffer_index = blob_read_uint32(blob);
+      uni->remap_location = blob_read_uint32(blob);
+      uni->hidden = blob_read_uint32(blob);
+      uni->builtin = blob_read_uint32(blob);
+
+      if (uni->type == NULL || d->failed())
+         return false;
+
+      if (name != NULL) {
+         uni->name = ralloc_strdup(prog->UniformStorage, name);
+         prog->UniformHash->put(i, uni->name);
+      }
+
+      if (blob_read_uint32(blob)) {
+         const size_t size =
+            uniform_storage_slots(uni) * sizeof(union gl_constant_value);
+         const void *data = blob_read_bytes(blob, size);
+
+         if (data == NULL)
+            return false;
+
+         uni->storage = (union gl_constant_value *)
+            ralloc_size(prog->UniformStorage, size);
+         memcpy(uni->storage, data, size);
+      }
+   }
+
+   prog->NumUniformStorage = num_uniforms;
+   prog->NumHiddenUniforms = num_hidden;
+
+   const unsigned num_remap = blob_read_uint32(blob);
+   if (d->failed())
+      return false;
+
+   if (num_remap != 0) {
+      prog->UniformRemapTable =
+         ralloc_array(prog, gl_uniform_storage *, num_remap);
+      if (prog->UniformRemapTable == NULL)
+         return false;
+   }
+
+   for (unsigned i = 0; i < num_remap; i++) {
+      const uint32_t index = blob_read_uint32(blob);
+
+      if (index == 0)
+         prog->UniformRemapTable[i] = NULL;
+      else if (index == 1)
+         prog->UniformRemapTable[i] = INACTIVE_UNIFORM_EXPLICIT_LOCATION;
+      else if (index - 2 < num_uniforms)
+         prog->UniformRemapTable[i] = &prog->UniformStorage[index - 2];
+      else
+         return false;
+   }
+
+   prog->NumUniformRemapTable = num_remap;
+
+   return !d->failed();
+}
+
+static void
+write_atomic_buffers(struct blob *blob, struct gl_shader_program *prog)
+{
+   blob_write_uint32(blob, prog->NumAtomicBuffers);
+
+   for (unsigned i = 0; i < prog->NumAtomicBuffers; i++) {
+      const gl_active_atomic_buffer *ab = &prog->AtomicBuffers[i];
+
+      blob_write_uint32(blob, ab->Binding);
+      blob_write_uint32(blob, ab->MinimumSize);
+      for (unsigned j = 0; j < MESA_SHADER_STAGES; j++)
+         blob_write_uint32(blob, ab->StageReferences[j]);
+
+      blob_write_uint32(blob, ab->NumUniforms);
+      for (unsigned j = 0; j < ab->NumUniforms; j++)
+         blob_write_uint32(blob, ab->Uniforms[j]);
+   }
+}
+
+static bool
+read_atomic_buffers(struct blob_reader *blob, struct gl_shader_program *prog)
+{
+   const unsigned num_buffers = blob_read_uint32(blob);
+   if (num_buffers == 0 || blob->overrun)
+      return !blob->overrun;
+
+   prog->AtomicBuffers =
+      rzalloc_array(prog, gl_active_atomic_buffer, num_buffers);
+   if (prog->AtomicBuffers == NULL)
+      return false;
+   prog->NumAtomicBuffers = num_buffers;
+
+   for (unsigned i = 0; i < num_buffers; i++) {
+      gl_active_atomic_buffer *ab = &prog->AtomicBuffers[i];
+
+      ab->Binding = blob_read_uint32(blob);
+      ab->MinimumSize = blob_read_uint32(blob);
+      for (unsigned j = 0; j < MESA_SHADER_STAGES; j++)
+         ab->StageReferences[j] = blob_read_uint32(blob);
+
+      ab->NumUniforms = blob_read_uint32(blob);
+      if (blob->overrun)
+         return false;
+
+      ab->Uniforms = rzalloc_array(prog->AtomicBuffers, GLuint,
+                                   ab->NumUniforms);
+      if (ab->Uniforms == NULL && ab->NumUniforms != 0)
+         return false;
+
+      for (unsigned j = 0; j < ab->NumUniforms; j++)
+         ab->Uniforms[j] = blob_read_uint32(blob);
+   }
+
+   return !blob->overrun;
+}
+
+static void
+write_transform_feedback(struct blob *blob, struct gl_shader_program *prog)
+{
+   const gl_transform_feedback_info *info = &prog->LinkedTransformFeedback;
+
+   blob_write_uint32(blob, info->NumBuffers);
+   for (unsigned i = 0; i < MAX_FEEDBACK_BUFFERS; i++)
+      blob_write_uint32(blob, info->BufferStride[i]);
+
+   blob_write_uint32(blob, info->NumOutputs);
+   for (unsigned i = 0; i < info->NumOutputs; i++) {
+      const gl_transform_feedback_output *out = &info->Outputs[i];
+
+      blob_write_uint32(blob, out->OutputRegister);
+      blob_write_uint32(blob, out->OutputBuffer);
+      blob_write_uint32(blob, out->NumComponents);
+      blob_write_uint32(blob, out->StreamId);
+      blob_write_uint32(blob, out->DstOffset);
+      blob_write_uint32(blob, out->ComponentOffset);
+   }
+
+   blob_write_uint32(blob, info->NumVarying);
+   for (int i = 0; i < info->NumVarying; i++) {
+      const gl_transform_feedback_varying_info *var = &info->Varyings[i];
+
+      blob_write_string(blob, var->Name);
+      blob_write_uint32(blob, var->Type);
+      blob_write_uint32(blob, var->Size);
+   }
+}
+
+static bool
+read_transform_feedback(struct blob_reader *blob,
+                        struct gl_shader_program *prog)
+{
+   gl_transform_feedback_info *info = &prog->LinkedTransformFeedback;
+
+   info->NumBuffers = blob_read_uint32(blob);
+   for (unsigned i = 0; i < MAX_FEEDBACK_BUFFERS; i++)
+      info->BufferStride[i] = blob_read_uint32(blob);
+
+   const unsigned num_outputs = blob_read_uint32(blob);
+   if (blob->overrun)
+      return false;
+
+   info->Outputs = rzalloc_array(prog, struct gl_transform_feedback_output,
+                                 num_outputs);
+   if (info->Outputs == NULL && num_outputs != 0)
+      return false;
+   info->NumOutputs = num_outputs;
+
+   for (unsigned i = 0; i < num_outputs; i++) {
+      gl_transform_feedback_output *out = &info->Outputs[i];
+
+      out->OutputRegister = blob_read_uint32(blob);
+      out->OutputBuffer = blob_read_uint32(blob);
+      out->NumComponents = blob_read_uint32(blob);
+      out->StreamId = blob_read_uint32(blob);
+      out->DstOffset = blob_read_uint32(blob);
+      out->ComponentOffset = blob_read_uint32(blob);
+   }
+
+   const unsigned num_varyings = blob_read_uint32(blob);
+   if (blob->overrun)
+      return false;
+
+   info->Varyings = rzalloc_array(prog,
+                                  struct gl_transform_feedback_varying_info,
+                                  num_varyings);
+   if (info->Varyings == NULL && num_varyings != 0)
+      return false;
+   info->NumVarying = num_varyings;
+
+   for (unsigned i = 0; i < num_varyings; i++) {
+      gl_transform_feedback_varying_info *var = &info->Varyings[i];
+      const char *name = blob_read_string(blob);
+
+      var->Type = blob_read_uint32(blob);
+      var->Size = blob_read_uint32(blob);
+      if (name == NULL || blob->overrun)
+         return false;
+
+      var->Name = ralloc_strdup(prog, name);
+   }
+
+   return true;
+}
+
+/**
+ * Free everything link_shaders() and _mesa_glsl_deserialize_program()
+ * would have set.
+ */
+static void
+clear_linked_program(struct gl_context *ctx, struct gl_shader_program *prog)
+{
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      if (prog->_LinkedShaders[i] != NULL)
+         ctx->Driver.DeleteShader(ctx, prog->_LinkedShaders[i]);
+      prog->_LinkedShaders[i] = NULL;
+   }
+
+   _mesa_clear_shader_program_data(prog);
+
+   ralloc_free(prog->LinkedTransformFeedback.Varyings);
+   ralloc_free(prog->LinkedTransformFeedback.Outputs);
+   memset(&prog->LinkedTransformFeedback, 0,
+          sizeof(prog->LinkedTransformFeedback));
+}
+
+extern "C" void
+_mesa_glsl_serialize_program(struct blob *blob,
+                             struct gl_shader_program *prog)
+{
+   ir_serializer s(blob);
+
+   blob_write_uint32(blob, prog->Version);
+   blob_write_uint32(blob, prog->IsES);
+   blob_write_uint32(blob, prog->ARB_fragment_coord_conventions_enable);
+   blob_write_string(blob, prog->InfoLog ? prog->InfoLog : "");
+
+   blob_write_uint32(blob, prog->Geom.VerticesIn);
+   blob_write_uint32(blob, prog->Geom.VerticesOut);
+   blob_write_uint32(blob, prog->Geom.Invocations);
+   blob_write_uint32(blob, prog->Geom.InputType);
+   blob_write_uint32(blob, prog->Geom.OutputType);
+   blob_write_uint32(blob, prog->Geom.UsesClipDistance);
+   blob_write_uint32(blob, prog->Geom.ClipDistanceArraySize);
+   blob_write_uint32(blob, prog->Geom.UsesEndPrimitive);
+   blob_write_uint32(blob, prog->Geom.UsesStreams);
+   blob_write_uint32(blob, prog->Vert.UsesClipDistance);
+   blob_write_uint32(blob, prog->Vert.ClipDistanceArraySize);
+   for (unsigned i = 0; i < 3; i++)
+      blob_write_uint32(blob, prog->Comp.LocalSize[i]);
+   blob_write_uint32(blob, prog->LastClipDistanceArraySize);
+   blob_write_uint32(blob, prog->FragDepthLayout);
+   blob_write_uint32(blob, prog->SeparateShader);
+
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      blob_write_uint32(blob, prog->_LinkedShaders[i] != NULL);
+      if (prog->_LinkedShaders[i] != NULL)
+         write_shader(blob, prog->_LinkedShaders[i]);
+   }
+
+   write_uniform_blocks(blob, &s, prog->UniformBlocks, prog->NumUniformBlocks);
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      for (unsigned j = 0; j < prog->NumUniformBlocks; j++)
+         blob_write_uint32(blob, prog->UniformBlockStageIndex[i][j]);
+   }
+
+   write_uniforms(blob, &s, prog);
+   write_atomic_buffers(blob, prog);
+   write_transform_feedback(blob, prog);
+}
+
+static bool
+read_program(struct blob_reader *blob, struct gl_context *ctx,
+             struct gl_shader_program *prog)
+{
+   ir_deserializer d(prog, blob, NULL);
+
+   prog->Version = blob_read_uint32(blob);
+   prog->IsES = blob_read_uint32(blob);
+   prog->ARB_fragment_coord_conventions_enable = blob_read_uint32(blob);
+
+   const char *info_log = blob_read_string(blob);
+   if (info_log == NULL)
+      return false;
+   ralloc_free(prog->InfoLog);
+   prog->InfoLog = ralloc_strdup(prog, info_log);
+
+   prog->Geom.VerticesIn = blob_read_uint32(blob);
+   prog->Geom.VerticesOut = blob_read_uint32(blob);
+   prog->Geom.Invocations = blob_read_uint32(blob);
+   prog->Geom.InputType = blob_read_uint32(blob);
+   prog->Geom.OutputType = blob_read_uint32(blob);
+   prog->Geom.UsesClipDistance = blob_read_uint32(blob);
+   prog->Geom.ClipDistanceArraySize = blob_read_uint32(blob);
+   prog->Geom.UsesEndPrimitive = blob_read_uint32(blob);
+   prog->Geom.UsesStreams = blob_read_uint32(blob);
+   prog->Vert.UsesClipDistance = blob_read_uint32(blob);
+   prog->Vert.ClipDistanceArraySize = blob_read_uint32(blob);
+   for (unsigned i = 0; i < 3; i++)
+      prog->Comp.LocalSize[i] = blob_read_uint32(blob);
+   prog->LastClipDistanceArraySize = blob_read_uint32(blob);
+   prog->FragDepthLayout = (gl_frag_depth_layout) blob_read_uint32(blob);
+   prog->SeparateShader = blob_read_uint32(blob);
+
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      if (!blob_read_uint32(blob))
+         continue;
+
+      gl_shader *sh = read_shader(blob, ctx, (gl_shader_stage) i);
+      if (sh == NULL)
+         return false;
+
+      _mesa_reference_shader(ctx, &prog->_LinkedShaders[i], sh);
+   }
+
+   prog->UniformBlocks = read_uniform_blocks(blob, &d, prog,
+                                             &prog->NumUniformBlocks);
+   if (prog->UniformBlocks == NULL && prog->NumUniformBlocks != 0) {
+      prog->NumUniformBlocks = 0;
+      return false;
+   }
+
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      prog->UniformBlockStageIndex[i] =
+         ralloc_array(prog, int, MAX2(1, prog->NumUniformBlocks));
+      if (prog->UniformBlockStageIndex[i] == NULL)
+         return false;
+
+      for (unsigned j = 0; j < prog->NumUniformBlocks; j++)
+         prog->UniformBlockStageIndex[i][j] = blob_read_uint32(blob);
+   }
+
+   return read_uniforms(blob, &d, prog) &&
+          read_atomic_buffers(blob, prog) &&
+          read_transform_feedback(blob, prog) &&
+          !d.failed();
+}
+
+extern "C" bool
+_mesa_glsl_deserialize_program(struct blob_reader *blob,
+                               struct gl_context *ctx,
+                               struct gl_shader_program *prog)
+{
+   clear_linked_program(ctx, prog);
+
+   prog->Validated = false;
+   prog->_Used = false;
+
+   if (!read_program(blob, ctx, prog)) {
+      clear_linked_program(ctx, prog);
+      return false;
+   }
+
+   return true;
+}
+
+/** Bumped whenever the serialized format changes */
+#define PROGRAM_BINARY_VERSION 1
+
+static uint64_t build_id;
+static once_flag build_id_once = ONCE_FLAG_INIT;
+
+/**
+ * Identify the build of the driver this code is part of by the size and
+ * modification time of its shared object.  Two builds with the same version
+ * string can still lay out the linked state differently.
+ */
+static void
+init_build_id(void)
+{
+   uint64_t hash = _mesa_fnv64_1a_offset_bias;
+
+#ifdef HAVE_DLOPEN
+   Dl_info info;
+   struct stat st;
+
+   if (dladdr((void *) init_build_id, &info) && info.dli_fname != NULL &&
+       stat(info.dli_fname, &st) == 0) {
+      hash = _mesa_fnv64_1a_accumulate(hash, st.st_size);
+      hash = _mesa_fnv64_1a_accumulate(hash, st.st_mtime);
+   }
+#endif
+
+   build_id = hash;
+}
+
+/**
+ * Hash everything that has to match between the GL that wrote a program
+ * binary and the one loading it: the version and build of Mesa, the format,
+ * the driver and the limits and extensions link_shaders() was run against.
+ */
+static uint64_t
+program_binary_hash(struct gl_context *ctx)
+{
+   static const char version[] = "Mesa " PACKAGE_VERSION;
+   const unsigned format_version = PROGRAM_BINARY_VERSION;
+   struct gl_constants consts;
+   struct gl_extensions extensions;
+   uint64_t hash = _mesa_fnv64_1a_offset_bias;
+
+   call_once(&build_id_once, init_build_id);
+
+   hash = _mesa_fnv64_1a_accumulate_block(hash, version, sizeof(version));
+   hash = _mesa_fnv64_1a_accumulate(hash, build_id);
+   hash = _mesa_fnv64_1a_accumulate(hash, format_version);
+   hash = _mesa_fnv64_1a_accumulate(hash, ctx->API);
+
+   /* Pointers differ from one run to the next, leave them out */
+   memcpy(&consts, &ctx->Const, sizeof(consts));
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++)
+      consts.ShaderCompilerOptions[i].NirOptions = NULL;
+   hash = _mesa_fnv64_1a_accumulate(hash, consts);
+
+   memcpy(&extensions, &ctx->Extensions, sizeof(extensions));
+   extensions.String = NULL;
+   hash = _mesa_fnv64_1a_accumulate(hash, extensions);
+
+   if (ctx->Driver.GetString != NULL) {
+      static const GLenum names[] = { GL_VENDOR, GL_RENDERER };
+
+      for (unsigned i = 0; i < ARRAY_SIZE(names); i++) {
+         const char *str =
+            (const char *) ctx->Driver.GetString(ctx, names[i]);
+
+         if (str != NULL)
+            hash = _mesa_fnv64_1a_accumulate_block(hash, str, strlen(str) + 1);
+      }
+   }
+
+   return hash;
+}
+
+/**
+ * Write the program binary of \c prog, which must just have been linked by
+ * link_shaders(), to a new blob.
+ */
+static struct blob *
+write_program_binary(struct gl_context *ctx, struct gl_shader_program *prog)
+{
+   struct blob *blob = blob_create(NULL);
+   if (blob == NULL)
+      return NULL;
+
+   blob_write_uint64(blob, program_binary_hash(ctx));
+   _mesa_glsl_serialize_program(blob, prog);
+
+   return blob;
+}
+
+extern "C" void
+_mesa_glsl_save_program_binary(struct gl_context *ctx,
+                               struct gl_shader_program *prog)
+{
+   struct blob *blob;
+
+   ralloc_free(prog->Binary);
+   prog->Binary = NULL;
+   prog->BinaryLength = 0;
+
+   blob = write_program_binary(ctx, prog);
+   if (blob == NULL)
+      return;
+
+   ralloc_steal(prog, blob->data);
+   prog->Binary = blob->data;
+   prog->BinaryLength = blob->size;
+   ralloc_free(blob);
+}
+
+extern "C" bool
+_mesa_glsl_load_program_binary(struct gl_context *ctx,
+                               struct gl_shader_program *prog,
+                               const void *binary, size_t length)
+{
+   struct blob_reader blob;
+
+   blob_reader_init(&blob, (uint8_t *) binary, length);
+
+   if (blob_read_uint64(&blob) != program_binary_hash(ctx) || blob.overrun)
+      return false;
+
+   if (!_mesa_glsl_deserialize_program(&blob, ctx, prog))
+      return false;
+
+   if (blob.current != blob.end) {
+      clear_linked_program(ctx, prog);
+      return false;
+   }
+
+   prog->Binary = (GLubyte *) ralloc_size(prog, length);
+   if (prog->Binary != NULL) {
+      memcpy(prog->Binary, binary, length);
+      prog->BinaryLength = length;
+   }
+
+   return true;
+}
+
+
+#ifdef ENABLE_SHADER_CACHE
+
+static struct disk_cache *cache;
+static once_flag cache_once_flag = ONCE_FLAG_INIT;
+
+static void
+open_cache(void)
+{
+   const char *dir = getenv("MESA_GLSL_CACHE_DIR");
+   const char *max_size = getenv("MESA_GLSL_CACHE_MAX_SIZE");
+   char *path;
+
+   if (getenv("MESA_GLSL_CACHE_DISABLE"))
+      return;
+
+   if (dir != NULL)
+      path = ralloc_strdup(NULL, dir);
+   else if (getenv("XDG_CACHE_HOME") != NULL)
+      path = ralloc_asprintf(NULL, "%s/mesa", getenv("XDG_CACHE_HOME"));
+   else if (getenv("HOME") != NULL)
+      path = ralloc_asprintf(NULL, "%s/.cache/mesa", getenv("HOME"));
+   else
+      return;
+
+   /* in megabytes */
+   const uint64_t size = max_size ? strtoul(max_size, NULL, 10) : 1024;
+
+   cache = disk_cache_create(path, size << 20);
+   ralloc_free(path);
+}
+
+static struct disk_cache *
+get_cache(void)
+{
+   call_once(&cache_once_flag, open_cache);
+   return cache;
+}
+
+/**
+ * Hash everything in the context that can change the result of compiling
+ * or linking a shader, along with the version of the compiler.  \c flags
+ * are the GLSL_x flags the shader is compiled or linked with.
+ */
+static void
+hash_context(struct mesa_sha1 *sha1, struct gl_context *ctx,
+             GLbitfield flags)
+{
+   static const char version[] = "GLSL " PACKAGE_VERSION;
+   const unsigned format_version = PROGRAM_BINARY_VERSION;
+   struct gl_constants consts;
+   struct gl_extensions extensions;
+
+   _mesa_sha1_update(sha1, version, sizeof(version));
+   _mesa_sha1_update(sha1, &format_version, sizeof(format_version));
+   _mesa_sha1_update(sha1, &ctx->API, sizeof(ctx->API));
+   _mesa_sha1_update(sha1, &flags, sizeof(flags));
+
+   /* Pointers differ from one run to the next, leave them out */
+   memcpy(&consts, &ctx->Const, sizeof(consts));
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++)
+      consts.ShaderCompilerOptions[i].NirOptions = NULL;
+   _mesa_sha1_update(sha1, &consts, sizeof(consts));
+
+   memcpy(&extensions, &ctx->Extensions, sizeof(extensions));
+   extensions.String = NULL;
+   _mesa_sha1_update(sha1, &extensions, sizeof(extensions));
+}
+
+struct binding {
+   const char *name;
+   unsigned value;
+};
+
+struct binding_list {
+   void *mem_ctx;
+   struct binding *bindings;
+   unsigned count;
+};
+
+static void
+add_binding(const char *name, unsigned value, void *closure)
+{
+   struct binding_list *list = (struct binding_list *) closure;
+
+   list->bindings = reralloc(list->mem_ctx, list->bindings, struct binding,
+                             list->count + 1);
+   list->bindings[list->count].name = name;
+   list->bindings[list->count].value = value;
+   list->count++;
+}
+
+static int
+compare_bindings(const void *a, const void *b)
+{
+   return strcmp(((const struct binding *) a)->name,
+                 ((const struct binding *) b)->name);
+}
+
+/**
+ * Hash the contents of a string_to_uint_map, independently of the order
+ * the bindings were made in.
+ */
+static void
+hash_bindings(struct mesa_sha1 *sha1, struct string_to_uint_map *map)
+{
+   struct binding_list list = { ralloc_context(NULL), NULL, 0 };
+
+   if (map != NULL)
+      map->iterate(add_binding, &list);
+
+   if (list.count > 0)
+      qsort(list.bindings, list.count, sizeof(struct binding),
+            compare_bindings);
+
+   _mesa_sha1_update(sha1, &list.count, sizeof(list.count));
+   for (unsigned i = 0; i < list.count; i++) {
+      _mesa_sha1_update(sha1, list.bindings[i].name,
+                        strlen(list.bindings[i].name) + 1);
+      _mesa_sha1_update(sha1, &list.bindings[i].value,
+                        sizeof(list.bindings[i].value));
+   }
+
+   ralloc_free(list.mem_ctx);
+}
+
+static bool
+has_sha1(const struct gl_shader *sh)
+{
+   for (unsigned i = 0; i < sizeof(sh->sha1); i++) {
+      if (sh->sha1[i] != 0)
+         return true;
+   }
+
+   return false;
+}
+
+/**
+ * Compute the key of a program from the keys of its shaders and the state
+ * set by the application before linking.
+ *
+ * \return false if any shader has no key, e.g. for fixed-function shaders
+ *         built directly as IR.
+ */
+static bool
+compute_program_key(struct gl_context *ctx, struct gl_shader_program *prog,
+                    GLbitfield flags, cache_key key)
+{
+   static const char tag[] = "program";
+   struct mesa_sha1 *sha1;
+
+   if (prog->NumShaders == 0)
+      return false;
+
+   for (unsigned i = 0; i < prog->NumShaders; i++) {
+      if (!has_sha1(prog->Shaders[i]))
+         return false;
+   }
+
+   sha1 = _mesa_sha1_init();
+   if (sha1 == NULL)
+      return false;
+
+   _mesa_sha1_update(sha1, tag, sizeof(tag));
+   hash_context(sha1, ctx, flags);
+
+   _mesa_sha1_update(sha1, &prog->NumShaders, sizeof(prog->NumShaders));
+   for (unsigned i = 0; i < prog->NumShaders; i++) {
+      _mesa_sha1_update(sha1, prog->Shaders[i]->sha1,
+                        sizeof(prog->Shaders[i]->sha1));
+   }
+
+   _mesa_sha1_update(sha1, &prog->SeparateShader,
+                     sizeof(prog->SeparateShader));
+   hash_bindings(sha1, prog->AttributeBindings);
+   hash_bindings(sha1, prog->FragDataBindings);
+   hash_bindings(sha1, prog->FragDataIndexBindings);
+
+   _mesa_sha1_update(sha1, &prog->TransformFeedback.BufferMode,
+                     sizeof(prog->TransformFeedback.BufferMode));
+   _mesa_sha1_update(sha1, &prog->TransformFeedback.NumVarying,
+                     sizeof(prog->TransformFeedback.NumVarying));
+   for (unsigned i = 0; i < prog->TransformFeedback.NumVarying; i++) {
+      const char *name = prog->TransformFeedback.VaryingNames[i];
+      _mesa_sha1_update(sha1, name, strlen(name) + 1);
+   }
+
+   return _mesa_sha1_final(sha1, key);
+}
+
+extern "C" bool
+_mesa_glsl_cache_skip_compile(struct gl_context *ctx, struct gl_shader *sh,
+                              GLbitfield flags)
+{
+   static const char tag[] = "shader";
+   struct disk_cache *cache = get_cache();
+   struct mesa_sha1 *sha1;
+   size_t size;
+   char *info_log;
+
+   memset(sh->sha1, 0, sizeof(sh->sha1));
+
+   if (cache == NULL || sh->Source == NULL)
+      return false;
+
+   sha1 = _mesa_sha1_init();
+   if (sha1 == NULL)
+      return false;
+
+   _mesa_sha1_update(sha1, tag, sizeof(tag));
+   hash_context(sha1, ctx, flags);
+   _mesa_sha1_update(sha1, &sh->Stage, sizeof(sh->Stage));
+   _mesa_sha1_update(sha1, sh->Source, strlen(sh->Source));
+   if (!_mesa_sha1_final(sha1, sh->sha1)) {
+      memset(sh->sha1, 0, sizeof(sh->sha1));
+      return false;
+   }
+
+   /* Dumping the shader needs its IR right away. */
+   if (flags & GLSL_DUMP)
+      return false;
+
+   /* The entry of a shader is its info log, it's only stored once a program
+    * using the shader has been cached.
+    */
+   info_log = (char *) disk_cache_get(cache, sh->sha1, &size);
+   if (info_log == NULL)
+      return false;
+
+   if (size == 0 || info_log[size - 1] != '\0') {
+      free(info_log);
+      return false;
+   }
+
+   ralloc_free(sh->ir);
+   sh->ir = NULL;
+   sh->symbols = NULL;
+
+   ralloc_free(sh->InfoLog);
+   sh->InfoLog = ralloc_strdup(sh, info_log);
+   free(info_log);
+
+   ralloc_free((void *) sh->FallbackSource);
+   sh->FallbackSource = ralloc_strdup(sh, sh->Source);
+   sh->CompileStatus = GL_TRUE;
+
+   return true;
+}
+
+extern "C" bool
+_mesa_glsl_cache_load_program(struct gl_context *ctx,
+                              struct gl_shader_program *prog,
+                              GLbitfield flags)
+{
+   struct disk_cache *cache = get_cache();
+   cache_key key;
+   size_t size;
+   void *data;
+   bool ok;
+
+   if (cache == NULL || !compute_program_key(ctx, prog, flags, key))
+      return false;
+
+   /* Programs are cached as their program binary. */
+   data = disk_cache_get(cache, key, &size);
+   if (data == NULL)
+      return false;
+
+   ok = _mesa_glsl_load_program_binary(ctx, prog, data, size);
+
+   free(data);
+   return ok;
+}
+
+extern "C" void
+_mesa_glsl_cache_store_program(struct gl_context *ctx,
+                               struct gl_shader_program *prog,
+                               GLbitfield flags)
+{
+   struct disk_cache *cache = get_cache();
+   cache_key key;
+
+   if (cache == NULL || !compute_program_key(ctx, prog, flags, key))
+      return;
+
+   if (prog->Binary != NULL) {
+      disk_cache_put(cache, key, prog->Binary, prog->BinaryLength);
+   } else {
+      struct blob *blob = write_program_binary(ctx, prog);
+      if (blob == NULL)
+         return;
+
+      disk_cache_put(cache, key, blob->data, blob->size);
+      ralloc_free(blob);
+   }
+
+   /* Now that the program is cached, compiling its shaders can be skipped
+    * next time.
+    */
+   for (unsigned i = 0; i < prog->NumShaders; i++) {
+      const struct gl_shader *sh = prog->Shaders[i];
+      const char *info_log = sh->InfoLog ? sh->InfoLog : "";
+
+      disk_cache_put(cache, sh->sha1, info_log, strlen(info_log) + 1);
+   }
+}
+
+#else /* ENABLE_SHADER_CACHE */
+
+extern "C" bool
+_mesa_glsl_cache_skip_compile(struct gl_context *ctx, struct gl_shader *sh,
+                              GLbitfield flags)
+{
+   return false;
+}
+
+extern "C" bool
+_mesa_glsl_cache_load_program(struct gl_context *ctx,
+                              struct gl_shader_program *prog,
+                              GLbitfield flags)
+{
+   return false;
+}
+
+extern "C" void
+_mesa_glsl_cache_store_program(struct gl_context *ctx,
+                               struct gl_shader_program *prog,
+                               GLbitfield flags)
+{
+}
+
+#endif /* ENABLE_SHADER_CACHE */
@@ -0,0 +1,140 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * \file shader_cache.h
+ *
+ * Program binaries and the on-disk cache of linked GLSL programs.
+ *
+ * A program binary holds the state link_shaders() leaves behind, i.e. the
+ * IR of the linked shaders plus the uniform, uniform block, atomic buffer
+ * and transform feedback tables, after a hash of the Mesa version and of
+ * the context's limits and extensions.  The driver's LinkShader hook still
+ * runs after loading one.  The cache stores programs as their binary.
+ *
+ * Each shader is keyed by the SHA-1 of its source and of the context state
+ * that affects compiling it, and each program by the keys of its shaders
+ * plus the state set through the API before linking (attribute and
+ * fragment data bindings, transform feedback varyings, ...).  When a
+ * shader that was part of a cached program is compiled again, compiling
+ * is skipped until link time, and only done then if the program turns out
+ * not to be in the cache.
+ *
+ * The cache lives in $MESA_GLSL_CACHE_DIR, $XDG_CACHE_HOME/mesa or
+ * ~/.cache/mesa, is limited to $MESA_GLSL_CACHE_MAX_SIZE megabytes (1024
+ * by default) and is disabled by setting MESA_GLSL_CACHE_DISABLE.
+ */
+
+struct blob;
+struct blob_reader;
+struct gl_context;
+struct gl_shader;
+struct gl_shader_program;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Write the result of link_shaders() for \c prog.
+ */
+void
+_mesa_glsl_serialize_program(struct blob *blob,
+                             struct gl_shader_program *prog);
+
+/**
+ * Restore the state written by _mesa_glsl_serialize_program() into \c prog,
+ * as if link_shaders() had just succeeded.
+ *
+ * \return false if the data is invalid, in which case \c prog is left
+ *         without any linked data.
+ */
+bool
+_mesa_glsl_deserialize_program(struct blob_reader *blob,
+                               struct gl_context *ctx,
+                               struct gl_shader_program *prog);
+
+/**
+ * Set prog->Binary to the program binary of \c prog, which must just have
+ * been linked by link_shaders().
+ */
+void
+_mesa_glsl_save_program_binary(struct gl_context *ctx,
+                               struct gl_shader_program *prog);
+
+/**
+ * Load a binary made by _mesa_glsl_save_program_binary() into \c prog, as
+ * if link_shaders() had just succeeded.  A copy of the binary is kept in
+ * prog->Binary.
+ *
+ * \return false if the binary is invalid or was made by a different build
+ *         of Mesa or for a different driver, in which case \c prog is left
+ *         without any linked data.
+ */
+bool
+_mesa_glsl_load_program_binary(struct gl_context *ctx,
+                               struct gl_shader_program *prog,
+                               const void *binary, size_t length);
+
+/**
+ * Compute the cache key of \c sh before compiling it with the GLSL_x
+ * \c flags.
+ *
+ * \return true if \c sh belongs to a cached program, in which case it has
+ *         been marked as successfully compiled and compiling it can be
+ *         skipped.
+ */
+bool
+_mesa_glsl_cache_skip_compile(struct gl_context *ctx, struct gl_shader *sh,
+                              GLbitfield flags);
+
+/**
+ * Try to load the linked state of \c prog from the cache.
+ *
+ * \return true on a hit, in which case link_shaders() must not be called.
+ */
+bool
+_mesa_glsl_cache_load_program(struct gl_context *ctx,
+                              struct gl_shader_program *prog,
+                              GLbitfield flags);
+
+/**
+ * Store the program binary of \c prog, which must have linked successfully.
+ */
+void
+_mesa_glsl_cache_store_program(struct gl_context *ctx,
+                               struct gl_shader_program *prog,
+                               GLbitfield flags);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* SHADER_CACHE_H */
@@ -109,6 +109,10 @@ _mesa_clear_shader_program_data(struct gl_shader_program *shProg)
    ralloc_free(shProg->AtomicBuffers);
    shProg->AtomicBuffers = NULL;
    shProg->NumAtomicBuffers = 0;
+
+   ralloc_free(shProg->Binary);
+   shProg->Binary = NULL;
+   shProg->BinaryLength = 0;
 }
 
 void initialize_context_to_defaults(struct gl_context *ctx, gl_api api)
@@ -0,0 +1,245 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file compile_bench.cpp
+ *
+ * Shader compile benchmark.
+ *
+ * Compiles a corpus of shaders, once with the linear allocator turned into
+ * plain ralloc allocations by RALLOC_NO_LINEAR and once with it as it is,
+ * each in a process of its own, and prints the time taken and the peak
+ * resident set size of each:
+ *
+ *    compile-bench [-n ITERATIONS] FILE.vert|.geom|.frag|.comp ...
+ *
+ * The corpus is compiled ITERATIONS times, once by default.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "main/compiler.h"
+#include "main/mtypes.h"
+#include "util/ralloc.h"
+#include "util/strtod.h"
+#include "ir.h"
+#include "glsl_parser_extras.h"
+#include "program.h"
+#include "standalone_scaffolding.h"
+
+static struct gl_context ctx;
+
+struct corpus_shader {
+   const char *file_name;
+   GLenum type;
+   char *source;
+};
+
+static void
+usage_fail(const char *name)
+{
+   fprintf(stderr,
+           "usage: %s [-n ITERATIONS] FILE.vert|.geom|.frag|.comp ...\n",
+           name);
+   exit(EXIT_FAILURE);
+}
+
+static char *
+load_text_file(void *mem_ctx, const char *file_name)
+{
+   FILE *fp = fopen(file_name, "rb");
+   char *text;
+   long size;
+
+   if (!fp)
+      return NULL;
+
+   fseek(fp, 0L, SEEK_END);
+   size = ftell(fp);
+   fseek(fp, 0L, SEEK_SET);
+
+   text = (char *) ralloc_size(mem_ctx, size + 1);
+   if (fread(text, 1, size, fp) != (size_t) size) {
+      ralloc_free(text);
+      text = NULL;
+   } else {
+      text[size] = '\0';
+   }
+
+   fclose(fp);
+   return text;
+}
+
+static double
+now_ms(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/**
+ * Compile the corpus \c iterations times, keeping the shaders of each
+ * iteration around until it is over, like an application would.
+ */
+static int
+run(const char *name, const struct corpus_shader *corpus, unsigned count,
+    unsigned iterations)
+{
+   struct rusage usage;
+   int status = EXIT_SUCCESS;
+
+   /* Set up the built-in functions outside of the timing. */
+   _mesa_glsl_initialize_builtin_functions();
+
+   const double start = now_ms();
+
+   for (unsigned i = 0; i < iterations; i++) {
+      void *mem_ctx = ralloc_context(NULL);
+
+      for (unsigned j = 0; j < count; j++) {
+         struct gl_shader *sh = _mesa_new_shader(&ctx, 0, corpus[j].type);
+
+         ralloc_steal(mem_ctx, sh);
+         sh->Source = corpus[j].source;
+         _mesa_glsl_compile_shader(&ctx, sh, false, false, true, 0);
+
+         if (!sh->CompileStatus && i == 0) {
+            fprintf(stderr, "%s failed to compile:\n%s\n",
+                    corpus[j].file_name, sh->InfoLog);
+            status = EXIT_FAILURE;
+         }
+      }
+
+      ralloc_free(mem_ctx);
+   }
+
+   const double ms = now_ms() - start;
+
+   getrusage(RUSAGE_SELF, &usage);
+   printf("%s: %u shaders x %u: %.1f ms, peak RSS %ld KiB\n",
+          name, count, iterations, ms, usage.ru_maxrss);
+
+   _mesa_glsl_release_types();
+   _mesa_glsl_release_builtin_functions();
+
+   return status;
+}
+
+int
+main(int argc, char **argv)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   unsigned iterations = 1;
+   int opt;
+
+   while ((opt = getopt(argc, argv, "n:")) != -1) {
+      if (opt != 'n' || (iterations = atoi(optarg)) == 0)
+         usage_fail(argv[0]);
+   }
+
+   const unsigned count = argc - optind;
+   if (count == 0)
+      usage_fail(argv[0]);
+
+   struct corpus_shader *corpus =
+      ralloc_array(mem_ctx, struct corpus_shader, count);
+
+   for (unsigned i = 0; i < count; i++) {
+      const char *const file_name = argv[optind + i];
+      const char *const ext = strrchr(file_name, '.');
+
+      if (ext == NULL)
+         usage_fail(argv[0]);
+      else if (strcmp(ext, ".vert") == 0)
+         corpus[i].type = GL_VERTEX_SHADER;
+      else if (strcmp(ext, ".geom") == 0)
+         corpus[i].type = GL_GEOMETRY_SHADER;
+      else if (strcmp(ext, ".frag") == 0)
+         corpus[i].type = GL_FRAGMENT_SHADER;
+      else if (strcmp(ext, ".comp") == 0)
+         corpus[i].type = GL_COMPUTE_SHADER;
+      else
+         usage_fail(argv[0]);
+
+      corpus[i].file_name = file_name;
+      corpus[i].source = load_text_file(mem_ctx, file_name);
+      if (corpus[i].source == NULL) {
+         fprintf(stderr, "couldn't read %s\n", file_name);
+         return EXIT_FAILURE;
+      }
+   }
+
+   initialize_context_to_defaults(&ctx, API_OPENGL_COMPAT);
+   _mesa_locale_init();
+
+   ctx.Const.GLSLVersion = 450;
+   ctx.Extensions.ARB_ES3_compatibility = true;
+   ctx.Const.MaxComputeWorkGroupCount[0] = 65535;
+   ctx.Const.MaxComputeWorkGroupCount[1] = 65535;
+   ctx.Const.MaxComputeWorkGroupCount[2] = 65535;
+   ctx.Const.MaxComputeWorkGroupSize[0] = 1024;
+   ctx.Const.MaxComputeWorkGroupSize[1] = 1024;
+   ctx.Const.MaxComputeWorkGroupSize[2] = 64;
+   ctx.Const.MaxComputeWorkGroupInvocations = 1024;
+   ctx.Driver.NewShader = _mesa_new_shader;
+
+   /* Peak RSS is per process, so each allocator gets a child of its own. */
+   static const char *const modes[2] = { "ralloc", "linear" };
+   int status = EXIT_SUCCESS;
+
+   for (unsigned m = 0; m < 2; m++) {
+      int child_status;
+
+      fflush(stdout);
+      pid_t pid = fork();
+      if (pid == -1) {
+         perror("fork");
+         return EXIT_FAILURE;
+      }
+
+      if (pid == 0) {
+         if (m == 0)
+            setenv("RALLOC_NO_LINEAR", "1", 1);
+         else
+            unsetenv("RALLOC_NO_LINEAR");
+
+         exit(run(modes[m], corpus, count, iterations));
+      }
+
+      if (waitpid(pid, &child_status, 0) == -1 ||
+          !WIFEXITED(child_status) ||
+          WEXITSTATUS(child_status) != EXIT_SUCCESS)
+         status = EXIT_FAILURE;
+   }
+
+   _mesa_locale_fini();
+   ralloc_free(mem_ctx);
+
+   return status;
+}
@@ -0,0 +1,427 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file nir_cse_bench.cpp
+ *
+ * NIR optimization compile-time benchmark.
+ *
+ * Compiles and links every shader of a corpus on its own, turns it into
+ * scalar SSA-form NIR the way the i965 backend does, runs the i965 NIR
+ * optimization loop on it and prints how long each pass takes, summed over
+ * all the iterations of the loop:
+ *
+ *    nir-cse-bench [-n ITERATIONS] [FILE.vert|.geom|.frag|.comp ...]
+ *
+ * Without any files the corpus is made of generated straight-line fragment
+ * shaders of growing size, full of repeated subexpressions.  Only the passes
+ * themselves are timed; the corpus goes through them ITERATIONS times, once
+ * by default.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "main/compiler.h"
+#include "main/mtypes.h"
+#include "util/ralloc.h"
+#include "util/strtod.h"
+#include "program/hash_table.h"
+#include "ir.h"
+#include "ir_optimization.h"
+#include "glsl_parser_extras.h"
+#include "linker.h"
+#include "program.h"
+#include "standalone_scaffolding.h"
+#include "nir/glsl_to_nir.h"
+
+static struct gl_context ctx;
+static const nir_shader_compiler_options nir_options = { };
+
+/* The passes of the i965 optimization loop, in order */
+static const struct {
+   const char *name;
+   bool (*run)(nir_shader *);
+} passes[] = {
+   { "copy_prop", nir_copy_prop },
+   { "dce", nir_opt_dce },
+   { "cse", nir_opt_cse },
+   { "peephole_select", nir_opt_peephole_select },
+   { "algebraic", nir_opt_algebraic },
+   { "constant_folding", nir_opt_constant_folding },
+   { "remove_phis", nir_opt_remove_phis },
+};
+
+struct corpus_shader {
+   const char *name;
+   GLenum type;
+   char *source;
+};
+
+static void
+usage_fail(const char *name)
+{
+   fprintf(stderr,
+           "usage: %s [-n ITERATIONS] [FILE.vert|.geom|.frag|.comp ...]\n",
+           name);
+   exit(EXIT_FAILURE);
+}
+
+static char *
+load_text_file(void *mem_ctx, const char *file_name)
+{
+   FILE *fp = fopen(file_name, "rb");
+   char *text;
+   long size;
+
+   if (!fp)
+      return NULL;
+
+   fseek(fp, 0L, SEEK_END);
+   size = ftell(fp);
+   fseek(fp, 0L, SEEK_SET);
+
+   text = (char *) ralloc_size(mem_ctx, size + 1);
+   if (fread(text, 1, size, fp) != (size_t) size) {
+      ralloc_free(text);
+      text = NULL;
+   } else {
+      text[size] = '\0';
+   }
+
+   fclose(fp);
+   return text;
+}
+
+/**
+ * A fragment shader of \c statements statements, each of which combines two
+ * earlier temporaries with expressions over a small set of uniforms, so that
+ * most of those expressions are computed many times over.
+ */
+static char *
+generate_shader(void *mem_ctx, unsigned statements)
+{
+   char *source = ralloc_strdup(mem_ctx,
+                                "#version 130\n"
+                                "uniform vec4 u[8];\n"
+                                "in vec4 v;\n"
+                                "out vec4 color;\n"
+                                "void main()\n"
+                                "{\n"
+                                "   vec4 t0 = v;\n");
+   uint32_t seed = statements;
+
+   for (unsigned i = 1; i <= statements; i++) {
+      unsigned r[5];
+
+      for (unsigned j = 0; j < 5; j++) {
+         seed = seed * 1103515245 + 12345;
+         r[j] = seed >> 16;
+      }
+
+      ralloc_asprintf_append(&source,
+                             "   vec4 t%u = t%u * (u[%u] + u[%u]) +"
+                             " t%u * (u[%u] * v.%s);\n",
+                             i, r[0] % i, r[1] % 8, r[2] % 8,
+                             r[3] % i, r[4] % 8,
+                             (r[4] & 0x100) ? "wzyx" : "xyzw");
+   }
+
+   ralloc_asprintf_append(&source, "   color = t%u;\n}\n", statements);
+   return source;
+}
+
+static void
+delete_shader(struct gl_context *, struct gl_shader *sh)
+{
+   ralloc_free(sh);
+}
+
+static bool
+count_block_instrs(nir_block *block, void *data)
+{
+   unsigned *count = (unsigned *) data;
+
+   nir_foreach_instr(block, instr)
+      (*count)++;
+
+   return true;
+}
+
+static unsigned
+count_instrs(nir_shader *nir)
+{
+   unsigned count = 0;
+
+   nir_foreach_overload(nir, overload) {
+      if (overload->impl)
+         nir_foreach_block(overload->impl, count_block_instrs, &count);
+   }
+
+   return count;
+}
+
+/**
+ * Compile and link \p shader as a program of its own and lower it to
+ * scalar SSA-form NIR, ready for the optimization loop.
+ */
+static nir_shader *
+create_nir(const struct corpus_shader *shader)
+{
+   struct gl_shader_program *prog = rzalloc(NULL, struct gl_shader_program);
+   struct gl_shader *sh = _mesa_new_shader(&ctx, 0, shader->type);
+   nir_shader *nir = NULL;
+
+   prog->InfoLog = ralloc_strdup(prog, "");
+   prog->AttributeBindings = new string_to_uint_map;
+   prog->FragDataBindings = new string_to_uint_map;
+   prog->FragDataIndexBindings = new string_to_uint_map;
+   prog->NumShaders = 1;
+   prog->Shaders = &sh;
+
+   sh->Source = shader->source;
+   _mesa_glsl_compile_shader(&ctx, sh, false, false, true, 0);
+
+   if (!sh->CompileStatus) {
+      fprintf(stderr, "%s failed to compile:\n%s\n", shader->name,
+              sh->InfoLog);
+   } else {
+      prog->LinkStatus = GL_TRUE;
+      link_shaders(&ctx, prog);
+
+      if (!prog->LinkStatus)
+         fprintf(stderr, "%s failed to link:\n%s\n", shader->name,
+                 prog->InfoLog);
+   }
+
+   if (prog->LinkStatus) {
+      const gl_shader_stage stage =
+         _mesa_shader_enum_to_shader_stage(shader->type);
+      struct gl_shader *linked = prog->_LinkedShaders[stage];
+
+      /* The generic part of the lowering brw_link_shader() does, which
+       * glsl_to_nir() relies on.
+       */
+      do_mat_op_to_vec(linked->ir);
+      lower_instructions(linked->ir, MOD_TO_FLOOR | DIV_TO_MUL_RCP |
+                                     SUB_TO_ADD_NEG | EXP_TO_EXP2 |
+                                     LOG_TO_LOG2 | LDEXP_TO_ARITH);
+      do_vec_index_to_cond_assign(linked->ir);
+      lower_vector_insert(linked->ir, true);
+      lower_offset_arrays(linked->ir);
+      lower_noise(linked->ir);
+      lower_quadop_vector(linked->ir, false);
+      do_lower_jumps(linked->ir, true, true, true, false, false);
+      lower_output_reads(linked->ir);
+
+      nir = glsl_to_nir(linked, &nir_options);
+
+      nir_lower_global_vars_to_local(nir);
+      nir_split_var_copies(nir);
+      nir_lower_var_copies(nir);
+      nir_lower_vars_to_ssa(nir);
+
+      nir_assign_var_locations_scalar_direct_first(nir, &nir->uniforms,
+                                                   &nir->num_direct_uniforms,
+                                                   &nir->num_uniforms);
+      nir_assign_var_locations_scalar(&nir->inputs, &nir->num_inputs);
+      nir_assign_var_locations_scalar(&nir->outputs, &nir->num_outputs);
+      nir_lower_io(nir);
+      nir_remove_dead_variables(nir);
+
+      nir_lower_alu_to_scalar(nir);
+      nir_lower_phis_to_scalar(nir);
+      nir_validate_shader(nir);
+   }
+
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++)
+      ralloc_free(prog->_LinkedShaders[i]);
+   ralloc_free(sh);
+   delete prog->AttributeBindings;
+   delete prog->FragDataBindings;
+   delete prog->FragDataIndexBindings;
+   delete prog->UniformHash;
+   ralloc_free(prog);
+
+   return nir;
+}
+
+static double
+now_ms(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/**
+ * Run the optimization loop on \p nir, adding the time each pass takes to
+ * \p pass_ms, and the time of the late algebraic pass after the loop to
+ * the last element of it.
+ */
+static void
+optimize(nir_shader *nir, double *pass_ms)
+{
+   bool progress;
+
+   do {
+      progress = false;
+
+      for (unsigned i = 0; i < ARRAY_SIZE(passes); i++) {
+         const double start = now_ms();
+         progress |= passes[i].run(nir);
+         pass_ms[i] += now_ms() - start;
+
+         nir_validate_shader(nir);
+      }
+   } while (progress);
+
+   const double start = now_ms();
+   nir_opt_algebraic_late(nir);
+   pass_ms[ARRAY_SIZE(passes)] += now_ms() - start;
+
+   nir_validate_shader(nir);
+}
+
+int
+main(int argc, char **argv)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   struct corpus_shader *corpus;
+   unsigned iterations = 1;
+   unsigned count;
+   int opt;
+
+   while ((opt = getopt(argc, argv, "n:")) != -1) {
+      if (opt != 'n' || (iterations = atoi(optarg)) == 0)
+         usage_fail(argv[0]);
+   }
+
+   if (optind < argc) {
+      count = argc - optind;
+      corpus = ralloc_array(mem_ctx, struct corpus_shader, count);
+
+      for (unsigned i = 0; i < count; i++) {
+         const char *const file_name = argv[optind + i];
+         const char *const ext = strrchr(file_name, '.');
+
+         if (ext == NULL)
+            usage_fail(argv[0]);
+         else if (strcmp(ext, ".vert") == 0)
+            corpus[i].type = GL_VERTEX_SHADER;
+         else if (strcmp(ext, ".geom") == 0)
+            corpus[i].type = GL_GEOMETRY_SHADER;
+         else if (strcmp(ext, ".frag") == 0)
+            corpus[i].type = GL_FRAGMENT_SHADER;
+         else if (strcmp(ext, ".comp") == 0)
+            corpus[i].type = GL_COMPUTE_SHADER;
+         else
+            usage_fail(argv[0]);
+
+         corpus[i].name = file_name;
+         corpus[i].source = load_text_file(mem_ctx, file_name);
+         if (corpus[i].source == NULL) {
+            fprintf(stderr, "couldn't read %s\n", file_name);
+            return EXIT_FAILURE;
+         }
+      }
+   } else {
+      static const unsigned sizes[] = { 250, 1000, 4000 };
+
+      count = ARRAY_SIZE(sizes);
+      corpus = ralloc_array(mem_ctx, struct corpus_shader, count);
+
+      for (unsigned i = 0; i < count; i++) {
+         corpus[i].name = ralloc_asprintf(mem_ctx, "generated-%u", sizes[i]);
+         corpus[i].type = GL_FRAGMENT_SHADER;
+         corpus[i].source = generate_shader(mem_ctx, sizes[i]);
+      }
+   }
+
+   initialize_context_to_defaults(&ctx, API_OPENGL_COMPAT);
+   _mesa_locale_init();
+
+   ctx.Const.GLSLVersion = 450;
+   ctx.Extensions.ARB_ES3_compatibility = true;
+   ctx.Const.MaxComputeWorkGroupCount[0] = 65535;
+   ctx.Const.MaxComputeWorkGroupCount[1] = 65535;
+   ctx.Const.MaxComputeWorkGroupCount[2] = 65535;
+   ctx.Const.MaxComputeWorkGroupSize[0] = 1024;
+   ctx.Const.MaxComputeWorkGroupSize[1] = 1024;
+   ctx.Const.MaxComputeWorkGroupSize[2] = 64;
+   ctx.Const.MaxComputeWorkGroupInvocations = 1024;
+   ctx.Driver.NewShader = _mesa_new_shader;
+   ctx.Driver.DeleteShader = delete_shader;
+
+   const unsigned num_passes = ARRAY_SIZE(passes) + 1;
+   double total_ms[ARRAY_SIZE(passes) + 1] = { 0 };
+   int status = EXIT_SUCCESS;
+
+   for (unsigned i = 0; i < count; i++) {
+      double pass_ms[ARRAY_SIZE(passes) + 1] = { 0 };
+      unsigned before = 0, after = 0;
+      double ms = 0;
+
+      for (unsigned n = 0; n < iterations; n++) {
+         nir_shader *nir = create_nir(&corpus[i]);
+
+         if (nir == NULL) {
+            status = EXIT_FAILURE;
+            break;
+         }
+
+         before = count_instrs(nir);
+         optimize(nir, pass_ms);
+         after = count_instrs(nir);
+         ralloc_free(nir);
+      }
+
+      for (unsigned p = 0; p < num_passes; p++) {
+         ms += pass_ms[p] / iterations;
+         total_ms[p] += pass_ms[p] / iterations;
+      }
+
+      printf("%s: %u -> %u instructions, %.2f ms\n",
+             corpus[i].name, before, after, ms);
+   }
+
+   double ms = 0;
+
+   printf("total: %u shaders\n", count);
+   for (unsigned p = 0; p < num_passes; p++) {
+      printf("   %-16s %9.2f ms\n",
+             p < ARRAY_SIZE(passes) ? passes[p].name : "algebraic_late",
+             total_ms[p]);
+      ms += total_ms[p];
+   }
+   printf("   %-16s %9.2f ms\n", "all", ms);
+
+   _mesa_glsl_release_types();
+   _mesa_glsl_release_builtin_functions();
+   _mesa_locale_fini();
+   ralloc_free(mem_ctx);
+
+   return status;
+}
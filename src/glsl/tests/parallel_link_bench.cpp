@@ -0,0 +1,292 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file parallel_link_bench.cpp
+ *
+ * Parallel shader compile benchmark.
+ *
+ * Compiles and links N programs of a vertex and a fragment shader on a
+ * util_queue of 1 to N threads, the way glCompileShader() and
+ * glLinkProgram() do when they don't have to be synchronous, and prints
+ * the wall time of each run:
+ *
+ *    parallel-link-bench [N]
+ *
+ * N is 8 by default.  The program binary of every program is checked
+ * against the one made by compiling and linking it on the main thread, so
+ * that it also serves as a test of the thread safety of the compiler.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "main/compiler.h"
+#include "main/mtypes.h"
+#include "util/ralloc.h"
+#include "util/u_queue.h"
+#include "program/hash_table.h"
+#include "ir.h"
+#include "glsl_parser_extras.h"
+#include "linker.h"
+#include "program.h"
+#include "shader_cache.h"
+#include "standalone_scaffolding.h"
+
+static const char vs_template[] =
+   "#version 130\n"
+   "#define K %u\n"
+   "uniform mat4 mvp;\n"
+   "uniform mat3 normal_matrix;\n"
+   "uniform vec4 light[8];\n"
+   "in vec4 position;\n"
+   "in vec3 normal;\n"
+   "in vec2 uv;\n"
+   "out vec3 color;\n"
+   "out vec2 tc;\n"
+   "void main()\n"
+   "{\n"
+   "   vec3 n = normalize(normal_matrix * normal);\n"
+   "   color = vec3(0.0);\n"
+   "   for (int l = 0; l < K %% 8 + 1; l++) {\n"
+   "      vec3 d = normalize(light[l].xyz - position.xyz);\n"
+   "      color += max(dot(n, d), 0.0) * light[l].w *\n"
+   "               vec3(pow(float(l + K), 0.5));\n"
+   "   }\n"
+   "   tc = uv * float(K);\n"
+   "   gl_Position = mvp * position;\n"
+   "}\n";
+
+static const char fs_template[] =
+   "#version 130\n"
+   "#define K %u\n"
+   "uniform sampler2D tex[4];\n"
+   "uniform float exposure;\n"
+   "in vec3 color;\n"
+   "in vec2 tc;\n"
+   "out vec4 frag_color;\n"
+   "void main()\n"
+   "{\n"
+   "   vec4 c = vec4(color, 1.0);\n"
+   "   for (int i = 0; i < 4; i++)\n"
+   "      c *= texture(tex[i], tc * float(i + K));\n"
+   "   c.rgb = vec3(1.0) - exp(-c.rgb * exposure);\n"
+   "   c.rgb = pow(c.rgb, vec3(1.0 / 2.2 + float(K) * 0.001));\n"
+   "   frag_color = smoothstep(0.0, 1.0, c);\n"
+   "}\n";
+
+static struct gl_context ctx;
+
+struct bench_program {
+   struct gl_shader_program *prog;
+   struct gl_shader *shaders[2];
+   struct util_queue_fence compile_fences[2];
+   struct util_queue_fence link_fence;
+};
+
+static void
+delete_shader(struct gl_context *, struct gl_shader *sh)
+{
+   ralloc_free(sh);
+}
+
+static void
+create_program(struct bench_program *p, unsigned k)
+{
+   static const GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+   static const char *const templates[2] = { vs_template, fs_template };
+
+   p->prog = rzalloc(NULL, struct gl_shader_program);
+   p->prog->InfoLog = ralloc_strdup(p->prog, "");
+   p->prog->AttributeBindings = new string_to_uint_map;
+   p->prog->FragDataBindings = new string_to_uint_map;
+   p->prog->FragDataIndexBindings = new string_to_uint_map;
+   p->prog->NumShaders = 2;
+   p->prog->Shaders = p->shaders;
+
+   for (unsigned i = 0; i < 2; i++) {
+      p->shaders[i] = _mesa_new_shader(&ctx, 0, types[i]);
+      p->shaders[i]->Source =
+         ralloc_asprintf(p->shaders[i], templates[i], k);
+      util_queue_fence_init(&p->compile_fences[i]);
+   }
+
+   util_queue_fence_init(&p->link_fence);
+}
+
+static void
+destroy_program(struct bench_program *p)
+{
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++)
+      ralloc_free(p->prog->_LinkedShaders[i]);
+
+   for (unsigned i = 0; i < 2; i++) {
+      util_queue_fence_destroy(&p->compile_fences[i]);
+      ralloc_free(p->shaders[i]);
+   }
+   util_queue_fence_destroy(&p->link_fence);
+
+   delete p->prog->AttributeBindings;
+   delete p->prog->FragDataBindings;
+   delete p->prog->FragDataIndexBindings;
+   delete p->prog->UniformHash;
+   ralloc_free(p->prog);
+}
+
+static void
+compile_job(void *data)
+{
+   _mesa_glsl_compile_shader(&ctx, (struct gl_shader *) data, false, false,
+                             true, 0);
+}
+
+/**
+ * Like link_program_job() in main/shaderapi.c.
+ */
+static void
+link_job(void *data)
+{
+   struct bench_program *p = (struct bench_program *) data;
+
+   /* The compiles were queued before the link. */
+   for (unsigned i = 0; i < 2; i++)
+      util_queue_fence_wait(&p->compile_fences[i]);
+
+   p->prog->LinkStatus = GL_TRUE;
+   for (unsigned i = 0; i < 2; i++) {
+      if (!p->shaders[i]->CompileStatus)
+         linker_error(p->prog, "linking with uncompiled shader");
+   }
+
+   if (p->prog->LinkStatus)
+      link_shaders(&ctx, p->prog);
+   if (p->prog->LinkStatus)
+      _mesa_glsl_save_program_binary(&ctx, p->prog);
+}
+
+static double
+now_ms(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+int
+main(int argc, char **argv)
+{
+   const unsigned n = argc > 1 ? atoi(argv[1]) : 8;
+   struct bench_program *programs = new bench_program[n];
+   void *mem_ctx = ralloc_context(NULL);
+   GLubyte **reference = ralloc_array(mem_ctx, GLubyte *, n);
+   GLsizei *reference_length = ralloc_array(mem_ctx, GLsizei, n);
+   int status = EXIT_SUCCESS;
+
+   if (n == 0) {
+      fprintf(stderr, "usage: %s [N]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   initialize_context_to_defaults(&ctx, API_OPENGL_COMPAT);
+   ctx.Driver.NewShader = _mesa_new_shader;
+   ctx.Driver.DeleteShader = delete_shader;
+
+   /* The binaries of the programs compiled and linked on this thread, which
+    * also keeps setting up the built-in functions out of the timings.
+    */
+   for (unsigned i = 0; i < n; i++) {
+      create_program(&programs[i], i);
+      compile_job(programs[i].shaders[0]);
+      compile_job(programs[i].shaders[1]);
+      link_job(&programs[i]);
+
+      if (!programs[i].prog->LinkStatus) {
+         fprintf(stderr, "program %u failed to link:\n%s\n", i,
+                 programs[i].prog->InfoLog);
+         return EXIT_FAILURE;
+      }
+
+      reference_length[i] = programs[i].prog->BinaryLength;
+      reference[i] = (GLubyte *) ralloc_size(mem_ctx, reference_length[i]);
+      memcpy(reference[i], programs[i].prog->Binary, reference_length[i]);
+      destroy_program(&programs[i]);
+   }
+
+   double one_thread_ms = 0;
+
+   for (unsigned threads = 1; threads <= n; threads++) {
+      struct util_queue queue;
+
+      if (!util_queue_init(&queue, threads)) {
+         fprintf(stderr, "couldn't start %u threads\n", threads);
+         return EXIT_FAILURE;
+      }
+
+      for (unsigned i = 0; i < n; i++)
+         create_program(&programs[i], i);
+
+      const double start = now_ms();
+
+      for (unsigned i = 0; i < n; i++) {
+         struct bench_program *p = &programs[i];
+
+         util_queue_add_job(&queue, p->shaders[0], &p->compile_fences[0],
+                            compile_job);
+         util_queue_add_job(&queue, p->shaders[1], &p->compile_fences[1],
+                            compile_job);
+         util_queue_add_job(&queue, p, &p->link_fence, link_job);
+      }
+      util_queue_finish(&queue);
+
+      const double ms = now_ms() - start;
+      if (threads == 1)
+         one_thread_ms = ms;
+
+      printf("%u programs, %u threads: %.1f ms, speedup %.2f\n",
+             n, threads, ms, one_thread_ms / ms);
+
+      for (unsigned i = 0; i < n; i++) {
+         const struct gl_shader_program *prog = programs[i].prog;
+
+         if (!prog->LinkStatus ||
+             prog->BinaryLength != reference_length[i] ||
+             memcmp(prog->Binary, reference[i], prog->BinaryLength) != 0) {
+            fprintf(stderr, "program %u differs with %u threads\n",
+                    i, threads);
+            status = EXIT_FAILURE;
+         }
+         destroy_program(&programs[i]);
+      }
+
+      util_queue_destroy(&queue);
+   }
+
+   ralloc_free(mem_ctx);
+   delete[] programs;
+
+   _mesa_glsl_release_types();
+   _mesa_glsl_release_builtin_functions();
+
+   return status;
+}
@@ -0,0 +1,277 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <gtest/gtest.h>
+#include "main/compiler.h"
+#include "main/mtypes.h"
+#include "main/macros.h"
+#include "util/ralloc.h"
+#include "program/hash_table.h"
+#include "ir.h"
+#include "ir_uniform.h"
+#include "shader_cache.h"
+#include "standalone_scaffolding.h"
+
+/**
+ * \file program_binary_test.cpp
+ *
+ * Test saving linked programs as program binaries and loading them back.
+ */
+
+static void
+delete_shader(struct gl_context *, struct gl_shader *sh)
+{
+   ralloc_free(sh);
+}
+
+class program_binary : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   gl_shader_program *create_program();
+   void load(const GLubyte *binary, size_t length);
+
+   struct gl_context ctx;
+   gl_shader_program *prog;
+   gl_shader_program *loaded;
+};
+
+void
+program_binary::SetUp()
+{
+   initialize_context_to_defaults(&ctx, API_OPENGL_CORE);
+   ctx.Driver.NewShader = _mesa_new_shader;
+   ctx.Driver.DeleteShader = delete_shader;
+
+   prog = create_program();
+   prog->UniformHash = new string_to_uint_map;
+   loaded = create_program();
+
+   /* A fragment shader that does
+    *
+    *    uniform vec4 u;
+    *    out vec4 color;
+    *    void main() { color = u * 2.0; }
+    */
+   gl_shader *sh = _mesa_new_shader(NULL, 0, GL_FRAGMENT_SHADER);
+   sh->ir = new(sh) exec_list;
+
+   ir_variable *const u =
+      new(sh) ir_variable(glsl_type::vec4_type, "u", ir_var_uniform);
+   ir_variable *const color =
+      new(sh) ir_variable(glsl_type::vec4_type, "color", ir_var_shader_out);
+   color->data.location = FRAG_RESULT_DATA0;
+   sh->ir->push_tail(u);
+   sh->ir->push_tail(color);
+
+   ir_function *const f = new(sh) ir_function("main");
+   ir_function_signature *const sig =
+      new(sh) ir_function_signature(glsl_type::void_type);
+   sig->is_defined = true;
+   f->add_signature(sig);
+   sh->ir->push_tail(f);
+
+   ir_expression *const mul =
+      new(sh) ir_expression(ir_binop_mul, glsl_type::vec4_type,
+                            new(sh) ir_dereference_variable(u),
+                            new(sh) ir_constant(2.0f));
+   sig->body.push_tail(
+      new(sh) ir_assignment(new(sh) ir_dereference_variable(color), mul));
+
+   prog->_LinkedShaders[MESA_SHADER_FRAGMENT] = sh;
+
+   /* The uniform storage link_assign_uniform_locations() would make for u */
+   prog->NumUniformStorage = 1;
+   prog->UniformStorage = rzalloc_array(prog, gl_uniform_storage, 1);
+   gl_uniform_storage *const uni = &prog->UniformStorage[0];
+   uni->name = ralloc_strdup(prog, "u");
+   uni->type = glsl_type::vec4_type;
+   uni->block_index = -1;
+   uni->offset = -1;
+   uni->atomic_buffer_index = -1;
+   uni->storage = rzalloc_array(prog, union gl_constant_value, 4);
+   for (unsigned i = 0; i < 4; i++)
+      uni->storage[i].f = 0.5f * i;
+
+   prog->NumUniformRemapTable = 1;
+   prog->UniformRemapTable = rzalloc_array(prog, gl_uniform_storage *, 1);
+   prog->UniformRemapTable[0] = uni;
+   prog->UniformHash->put(0, "u");
+
+   prog->LinkStatus = true;
+   ralloc_free(prog->InfoLog);
+   prog->InfoLog = ralloc_strdup(prog, "a warning");
+}
+
+void
+program_binary::TearDown()
+{
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      ralloc_free(prog->_LinkedShaders[i]);
+      ralloc_free(loaded->_LinkedShaders[i]);
+   }
+
+   delete prog->UniformHash;
+   delete loaded->UniformHash;
+   ralloc_free(prog);
+   ralloc_free(loaded);
+}
+
+gl_shader_program *
+program_binary::create_program()
+{
+   gl_shader_program *p = rzalloc(NULL, struct gl_shader_program);
+
+   p->InfoLog = ralloc_strdup(p, "");
+
+   return p;
+}
+
+void
+program_binary::load(const GLubyte *binary, size_t length)
+{
+   /* Like _mesa_glsl_program_binary() */
+   _mesa_clear_shader_program_data(loaded);
+   loaded->LinkStatus =
+      _mesa_glsl_load_program_binary(&ctx, loaded, binary, length);
+}
+
+TEST_F(program_binary, round_trip)
+{
+   _mesa_glsl_save_program_binary(&ctx, prog);
+   ASSERT_NE((GLubyte *) NULL, prog->Binary);
+   ASSERT_LT(8, prog->BinaryLength);
+
+   load(prog->Binary, prog->BinaryLength);
+   ASSERT_TRUE(loaded->LinkStatus);
+
+   EXPECT_STREQ("a warning", loaded->InfoLog);
+   EXPECT_EQ((gl_shader *) NULL, loaded->_LinkedShaders[MESA_SHADER_VERTEX]);
+
+   gl_shader *const sh = loaded->_LinkedShaders[MESA_SHADER_FRAGMENT];
+   ASSERT_NE((gl_shader *) NULL, sh);
+   EXPECT_EQ(MESA_SHADER_FRAGMENT, sh->Stage);
+   ASSERT_NE((exec_list *) NULL, sh->ir);
+
+   ir_instruction *const second = (ir_instruction *) sh->ir->get_head()->next;
+   ir_variable *const color = second->as_variable();
+   ASSERT_NE((ir_variable *) NULL, color);
+   EXPECT_STREQ("color", color->name);
+   EXPECT_EQ(int(FRAG_RESULT_DATA0), color->data.location);
+
+   ASSERT_EQ(1u, loaded->NumUniformStorage);
+   const gl_uniform_storage *const uni = &loaded->UniformStorage[0];
+   EXPECT_STREQ("u", uni->name);
+   EXPECT_EQ(glsl_type::vec4_type, uni->type);
+   EXPECT_EQ(-1, uni->block_index);
+   for (unsigned i = 0; i < 4; i++)
+      EXPECT_EQ(0.5f * i, uni->storage[i].f);
+
+   ASSERT_EQ(1u, loaded->NumUniformRemapTable);
+   EXPECT_EQ(uni, loaded->UniformRemapTable[0]);
+
+   unsigned index;
+   ASSERT_TRUE(loaded->UniformHash->get(index, "u"));
+   EXPECT_EQ(0u, index);
+
+   /* The binary of the loaded program is the one it was loaded from, and
+    * saving the loaded program gives the same binary again.
+    */
+   ASSERT_EQ(prog->BinaryLength, loaded->BinaryLength);
+   EXPECT_EQ(0, memcmp(prog->Binary, loaded->Binary, prog->BinaryLength));
+
+   _mesa_glsl_save_program_binary(&ctx, loaded);
+   ASSERT_EQ(prog->BinaryLength, loaded->BinaryLength);
+   EXPECT_EQ(0, memcmp(prog->Binary, loaded->Binary, prog->BinaryLength));
+}
+
+/**
+ * PROGRAM_BINARY_RETRIEVABLE_HINT is only a hint, the binary of a loaded
+ * program can be retrieved without it.
+ */
+TEST_F(program_binary, keep_binary_without_retrievable_hint)
+{
+   _mesa_glsl_save_program_binary(&ctx, prog);
+   ASSERT_NE((GLubyte *) NULL, prog->Binary);
+
+   loaded->BinaryRetreivableHint = false;
+   load(prog->Binary, prog->BinaryLength);
+   ASSERT_TRUE(loaded->LinkStatus);
+   ASSERT_NE((GLubyte *) NULL, loaded->Binary);
+   ASSERT_EQ(prog->BinaryLength, loaded->BinaryLength);
+   EXPECT_EQ(0, memcmp(prog->Binary, loaded->Binary, prog->BinaryLength));
+}
+
+TEST_F(program_binary, reject_other_context)
+{
+   _mesa_glsl_save_program_binary(&ctx, prog);
+   ASSERT_NE((GLubyte *) NULL, prog->Binary);
+
+   ctx.Const.MaxDrawBuffers++;
+
+   load(prog->Binary, prog->BinaryLength);
+   EXPECT_FALSE(loaded->LinkStatus);
+   EXPECT_EQ((gl_shader *) NULL, loaded->_LinkedShaders[MESA_SHADER_FRAGMENT]);
+   EXPECT_EQ((GLubyte *) NULL, loaded->Binary);
+}
+
+TEST_F(program_binary, reject_other_extensions)
+{
+   _mesa_glsl_save_program_binary(&ctx, prog);
+   ASSERT_NE((GLubyte *) NULL, prog->Binary);
+
+   ctx.Extensions.ARB_uniform_buffer_object =
+      !ctx.Extensions.ARB_uniform_buffer_object;
+
+   load(prog->Binary, prog->BinaryLength);
+   EXPECT_FALSE(loaded->LinkStatus);
+}
+
+TEST_F(program_binary, reject_truncated)
+{
+   _mesa_glsl_save_program_binary(&ctx, prog);
+   ASSERT_NE((GLubyte *) NULL, prog->Binary);
+
+   for (GLsizei length = 0; length < prog->BinaryLength; length++) {
+      load(prog->Binary, length);
+      EXPECT_FALSE(loaded->LinkStatus) << "length " << length;
+      EXPECT_EQ((gl_shader *) NULL,
+                loaded->_LinkedShaders[MESA_SHADER_FRAGMENT]);
+      EXPECT_EQ(0u, loaded->NumUniformStorage);
+   }
+}
+
+TEST_F(program_binary, reject_trailing_data)
+{
+   _mesa_glsl_save_program_binary(&ctx, prog);
+   ASSERT_NE((GLubyte *) NULL, prog->Binary);
+
+   GLubyte *const binary =
+      (GLubyte *) ralloc_size(prog, prog->BinaryLength + 4);
+   memcpy(binary, prog->Binary, prog->BinaryLength);
+   memset(binary + prog->BinaryLength, 0, 4);
+
+   load(binary, prog->BinaryLength + 4);
+   EXPECT_FALSE(loaded->LinkStatus);
+   EXPECT_EQ((gl_shader *) NULL, loaded->_LinkedShaders[MESA_SHADER_FRAGMENT]);
+}
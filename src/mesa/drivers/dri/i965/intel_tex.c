@@ -24,7 +24,7 @@ static void
 intelDeleteTextureImage(struct gl_context * ctx, struct gl_texture_image *img)
 {
    /* nothing special (yet) for intel_texture_image */
-   _mesa_delete_texture_image(ctx, img);
+   _swrast_delete_texture_image(ctx, img);
 }
 
 
@@ -97,7 +97,7 @@ static void
 radeonDeleteTextureImage(struct gl_context *ctx, struct gl_texture_image *img)
 {
 	/* nothing special (yet) for radeon_texture_image */
-	_mesa_delete_texture_image(ctx, img);
+	_swrast_delete_texture_image(ctx, img);
 }
 
 static GLboolean
@@ -30,6 +30,7 @@
 #include "imports.h"
 #include "mtypes.h"
 #include "enums.h"
+#include "state.h"
 #include "vbo/vbo.h"
 #include "transformfeedback.h"
 #include <stdbool.h>
@@ -104,6 +105,41 @@ check_valid_to_render(struct gl_context *ctx, const char *function)
 }
 
 
+/**
+ * Prepare for drawing in a context created with
+ * GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR, where the draw parameters and the state
+ * they are used with are known to be valid.  Only derived state is updated,
+ * and only the cases that are not errors but leave nothing to draw are
+ * checked.
+ * \return true if there is something to draw
+ */
+bool
+_mesa_valid_to_render_no_error(struct gl_context *ctx)
+{
+   FLUSH_CURRENT(ctx, 0);
+
+   if (ctx->NewState)
+      _mesa_update_state(ctx);
+
+   switch (ctx->API) {
+   case API_OPENGLES2:
+   case API_OPENGL_CORE:
+      return ctx->VertexProgram._Current != NULL;
+
+   case API_OPENGLES:
+      return ctx->Array.VAO->VertexAttrib[VERT_ATTRIB_POS].Enabled;
+
+   case API_OPENGL_COMPAT:
+      return ctx->VertexProgram._Current != NULL ||
+             ctx->Array.VAO->VertexAttrib[VERT_ATTRIB_POS].Enabled ||
+             ctx->Array.VAO->VertexAttrib[VERT_ATTRIB_GENERIC0].Enabled;
+
+   default:
+      unreachable("Invalid API value in _mesa_valid_to_render_no_error()");
+   }
+}
+
+
 /**
  * Is 'mode' a valid value for glBegin(), glDrawArrays(), glDrawElements(),
  * etc?  The set of legal values depends on whether geometry shaders/programs
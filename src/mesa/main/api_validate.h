@@ -35,6 +35,9 @@ struct gl_context;
 struct gl_transform_feedback_object;
 
 
+extern bool
+_mesa_valid_to_render_no_error(struct gl_context *ctx);
+
 extern bool
 _mesa_is_valid_prim_mode(struct gl_context *ctx, GLenum mode);
 
@@ -560,6 +560,21 @@ _mesa_BlendColor( GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha )
  * On a change, flushes the vertices and notifies the driver via
  * dd_function_table::AlphaFunc callback.
  */
+void
+_mesa_alpha_func(struct gl_context *ctx, GLenum func, GLclampf ref)
+{
+   if (ctx->Color.AlphaFunc == func && ctx->Color.AlphaRefUnclamped == ref)
+      return; /* no change */
+
+   FLUSH_VERTICES(ctx, _NEW_COLOR);
+   ctx->Color.AlphaFunc = func;
+   ctx->Color.AlphaRefUnclamped = ref;
+   ctx->Color.AlphaRef = CLAMP(ref, 0.0F, 1.0F);
+
+   if (ctx->Driver.AlphaFunc)
+      ctx->Driver.AlphaFunc(ctx, func, ctx->Color.AlphaRef);
+}
+
 void GLAPIENTRY
 _mesa_AlphaFunc( GLenum func, GLclampf ref )
 {
@@ -578,16 +593,7 @@ _mesa_AlphaFunc( GLenum func, GLclampf ref )
    case GL_NOTEQUAL:
    case GL_GEQUAL:
    case GL_ALWAYS:
-      if (ctx->Color.AlphaFunc == func && ctx->Color.AlphaRefUnclamped == ref)
-         return; /* no change */
-
-      FLUSH_VERTICES(ctx, _NEW_COLOR);
-      ctx->Color.AlphaFunc = func;
-      ctx->Color.AlphaRefUnclamped = ref;
-      ctx->Color.AlphaRef = CLAMP(ref, 0.0F, 1.0F);
-
-      if (ctx->Driver.AlphaFunc)
-         ctx->Driver.AlphaFunc(ctx, func, ctx->Color.AlphaRef);
+      _mesa_alpha_func(ctx, func, ref);
       return;
 
    default:
@@ -676,19 +682,14 @@ _mesa_IndexMask( GLuint mask )
  * change, flushes the vertices and notifies the driver via the
  * dd_function_table::ColorMask callback.
  */
-void GLAPIENTRY
-_mesa_ColorMask( GLboolean red, GLboolean green,
-                 GLboolean blue, GLboolean alpha )
+void
+_mesa_color_mask(struct gl_context *ctx, GLboolean red, GLboolean green,
+                 GLboolean blue, GLboolean alpha)
 {
-   GET_CURRENT_CONTEXT(ctx);
    GLubyte tmp[4];
    GLuint i;
    GLboolean flushed;
 
-   if (MESA_VERBOSE & VERBOSE_API)
-      _mesa_debug(ctx, "glColorMask(%d, %d, %d, %d)\n",
-                  red, green, blue, alpha);
-
    /* Shouldn't have any information about channel depth in core mesa
     * -- should probably store these as the native booleans:
     */
@@ -712,6 +713,19 @@ _mesa_ColorMask( GLboolean red, GLboolean green,
       ctx->Driver.ColorMask( ctx, red, green, blue, alpha );
 }
 
+void GLAPIENTRY
+_mesa_ColorMask( GLboolean red, GLboolean green,
+                 GLboolean blue, GLboolean alpha )
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (MESA_VERBOSE & VERBOSE_API)
+      _mesa_debug(ctx, "glColorMask(%d, %d, %d, %d)\n",
+                  red, green, blue, alpha);
+
+   _mesa_color_mask(ctx, red, green, blue, alpha);
+}
+
 
 /**
  * For GL_EXT_draw_buffers2 and GL3
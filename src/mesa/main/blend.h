@@ -78,6 +78,9 @@ extern void GLAPIENTRY
 _mesa_BlendColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha);
 
 
+extern void
+_mesa_alpha_func(struct gl_context *ctx, GLenum func, GLclampf ref);
+
 extern void GLAPIENTRY
 _mesa_AlphaFunc( GLenum func, GLclampf ref );
 
@@ -89,6 +92,10 @@ _mesa_LogicOp( GLenum opcode );
 extern void GLAPIENTRY
 _mesa_IndexMask( GLuint mask );
 
+extern void
+_mesa_color_mask(struct gl_context *ctx, GLboolean red, GLboolean green,
+                 GLboolean blue, GLboolean alpha);
+
 extern void GLAPIENTRY
 _mesa_ColorMask( GLboolean red, GLboolean green,
                  GLboolean blue, GLboolean alpha );
@@ -917,21 +917,15 @@ _mesa_handle_bind_buffer_gen(struct gl_context *ctx,
 }
 
 /**
- * Bind the specified target to buffer for the specified context.
- * Called by glBindBuffer() and other functions.
+ * Bind buffer to the binding point \p bindTarget, which was looked up from
+ * \p target by the caller.
  */
-static void
-bind_buffer_object(struct gl_context *ctx, GLenum target, GLuint buffer)
+static inline void
+bind_buffer(struct gl_context *ctx, struct gl_buffer_object **bindTarget,
+            GLenum target, GLuint buffer)
 {
    struct gl_buffer_object *oldBufObj;
    struct gl_buffer_object *newBufObj = NULL;
-   struct gl_buffer_object **bindTarget = NULL;
-
-   bindTarget = get_buffer_target(ctx, target);
-   if (!bindTarget) {
-      _mesa_error(ctx, GL_INVALID_ENUM, "glBindBufferARB(target 0x%x)", target);
-      return;
-   }
 
    /* Get pointer to old buffer object (to be unbound) */
    oldBufObj = *bindTarget;
@@ -960,6 +954,24 @@ bind_buffer_object(struct gl_context *ctx, GLenum target, GLuint buffer)
 }
 
 
+/**
+ * Bind the specified target to buffer for the specified context.
+ * Called by glBindBuffer() and other functions.
+ */
+static void
+bind_buffer_object(struct gl_context *ctx, GLenum target, GLuint buffer)
+{
+   struct gl_buffer_object **bindTarget = get_buffer_target(ctx, target);
+
+   if (!bindTarget) {
+      _mesa_error(ctx, GL_INVALID_ENUM, "glBindBufferARB(target 0x%x)", target);
+      return;
+   }
+
+   bind_buffer(ctx, bindTarget, target, buffer);
+}
+
+
 /**
  * Update the default buffer objects in the given context to reference those
  * specified in the shared state and release those referencing the old 
@@ -1164,6 +1176,19 @@ _mesa_BindBuffer(GLenum target, GLuint buffer)
 }
 
 
+/**
+ * glBindBuffer() for contexts created with GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR.
+ * The target is known to be valid for the context.
+ */
+void GLAPIENTRY
+_mesa_BindBuffer_no_error(GLenum target, GLuint buffer)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   bind_buffer(ctx, get_buffer_target(ctx, target), target, buffer);
+}
+
+
 /**
  * Delete a set of buffer objects.
  * 
@@ -1615,6 +1640,23 @@ _mesa_NamedBufferData(GLuint buffer, GLsizeiptr size, const GLvoid *data,
 }
 
 
+/**
+ * Store data into a range of \p bufObj, after any error checking.
+ */
+static inline void
+buffer_sub_data(struct gl_context *ctx, struct gl_buffer_object *bufObj,
+                GLintptr offset, GLsizeiptr size, const GLvoid *data)
+{
+   if (size == 0)
+      return;
+
+   bufObj->Written = GL_TRUE;
+
+   assert(ctx->Driver.BufferSubData);
+   ctx->Driver.BufferSubData(ctx, offset, size, data, bufObj);
+}
+
+
 /**
  * Implementation for glBufferSubData and glNamedBufferSubData.
  *
@@ -1643,13 +1685,7 @@ _mesa_buffer_sub_data(struct gl_context *ctx, struct gl_buffer_object *bufObj,
       return;
    }
 
-   if (size == 0)
-      return;
-
-   bufObj->Written = GL_TRUE;
-
-   assert(ctx->Driver.BufferSubData);
-   ctx->Driver.BufferSubData(ctx, offset, size, data, bufObj);
+   buffer_sub_data(ctx, bufObj, offset, size, data);
 }
 
 void GLAPIENTRY
@@ -1666,6 +1702,16 @@ _mesa_BufferSubData(GLenum target, GLintptr offset,
    _mesa_buffer_sub_data(ctx, bufObj, offset, size, data, "glBufferSubData");
 }
 
+void GLAPIENTRY
+_mesa_BufferSubData_no_error(GLenum target, GLintptr offset,
+                             GLsizeiptr size, const GLvoid *data)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   struct gl_buffer_object **bufObj = get_buffer_target(ctx, target);
+
+   buffer_sub_data(ctx, *bufObj, offset, size, data);
+}
+
 void GLAPIENTRY
 _mesa_NamedBufferSubData(GLuint buffer, GLintptr offset,
                          GLsizeiptr size, const GLvoid *data)
@@ -344,6 +344,19 @@ _mesa_has_compute_shaders(const struct gl_context *ctx)
 }
 
 
+/**
+ * Was the context created with GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR?
+ *
+ * The flag has to be set before _mesa_initialize_dispatch_tables(), which
+ * installs the entry points that skip error checking.
+ */
+static inline bool
+_mesa_is_no_error_enabled(const struct gl_context *ctx)
+{
+   return ctx->Const.ContextFlags & GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR;
+}
+
+
 #ifdef __cplusplus
 }
 #endif
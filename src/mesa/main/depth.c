@@ -57,6 +57,19 @@ _mesa_ClearDepthf( GLclampf depth )
 }
 
 
+void
+_mesa_depth_func(struct gl_context *ctx, GLenum func)
+{
+   if (ctx->Depth.Func == func)
+      return;
+
+   FLUSH_VERTICES(ctx, _NEW_DEPTH);
+   ctx->Depth.Func = func;
+
+   if (ctx->Driver.DepthFunc)
+      ctx->Driver.DepthFunc( ctx, func );
+}
+
 void GLAPIENTRY
 _mesa_DepthFunc( GLenum func )
 {
@@ -65,9 +78,6 @@ _mesa_DepthFunc( GLenum func )
    if (MESA_VERBOSE & VERBOSE_API)
       _mesa_debug(ctx, "glDepthFunc %s\n", _mesa_lookup_enum_by_nr(func));
 
-   if (ctx->Depth.Func == func)
-      return;
-
    switch (func) {
    case GL_LESS:    /* (default) pass if incoming z < stored z */
    case GL_GEQUAL:
@@ -83,23 +93,14 @@ _mesa_DepthFunc( GLenum func )
       return;
    }
 
-   FLUSH_VERTICES(ctx, _NEW_DEPTH);
-   ctx->Depth.Func = func;
-
-   if (ctx->Driver.DepthFunc)
-      ctx->Driver.DepthFunc( ctx, func );
+   _mesa_depth_func(ctx, func);
 }
 
 
 
-void GLAPIENTRY
-_mesa_DepthMask( GLboolean flag )
+void
+_mesa_depth_mask(struct gl_context *ctx, GLboolean flag)
 {
-   GET_CURRENT_CONTEXT(ctx);
-
-   if (MESA_VERBOSE & VERBOSE_API)
-      _mesa_debug(ctx, "glDepthMask %d\n", flag);
-
    /*
     * GL_TRUE indicates depth buffer writing is enabled (default)
     * GL_FALSE indicates depth buffer writing is disabled
@@ -114,6 +115,17 @@ _mesa_DepthMask( GLboolean flag )
       ctx->Driver.DepthMask( ctx, flag );
 }
 
+void GLAPIENTRY
+_mesa_DepthMask( GLboolean flag )
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (MESA_VERBOSE & VERBOSE_API)
+      _mesa_debug(ctx, "glDepthMask %d\n", flag);
+
+   _mesa_depth_mask(ctx, flag);
+}
+
 
 
 /**
@@ -43,9 +43,15 @@ _mesa_ClearDepth( GLclampd depth );
 extern void GLAPIENTRY
 _mesa_ClearDepthf( GLclampf depth );
 
+extern void
+_mesa_depth_func(struct gl_context *ctx, GLenum func);
+
 extern void GLAPIENTRY
 _mesa_DepthFunc( GLenum func );
 
+extern void
+_mesa_depth_mask(struct gl_context *ctx, GLboolean flag);
+
 extern void GLAPIENTRY
 _mesa_DepthMask( GLboolean flag );
 
@@ -38,10 +38,13 @@
 #include "api_validate.h"
 #include "atifragshader.h"
 #include "config.h"
+#include "blend.h"
 #include "bufferobj.h"
 #include "arrayobj.h"
 #include "context.h"
+#include "depth.h"
 #include "dlist.h"
+#include "enable.h"
 #include "enums.h"
 #include "eval.h"
 #include "fbobject.h"
@@ -51,9 +54,12 @@
 #include "hash.h"
 #include "image.h"
 #include "light.h"
+#include "lines.h"
 #include "macros.h"
 #include "pack.h"
 #include "pbo.h"
+#include "points.h"
+#include "polygon.h"
 #include "queryobj.h"
 #include "samplerobj.h"
 #include "shaderapi.h"
@@ -488,10 +494,29 @@ typedef enum
    /* EXT_polygon_offset_clamp */
    OPCODE_POLYGON_OFFSET_CLAMP,
 
-   /* The following three are meta instructions */
+   /* State settings checked by optimize_list(), applied through the
+    * internal setters without validation (see apply_checked_state)
+    */
+   OPCODE_CHECKED_ENABLE,
+   OPCODE_CHECKED_DISABLE,
+   OPCODE_CHECKED_ALPHA_FUNC,
+   OPCODE_CHECKED_DEPTH_FUNC,
+   OPCODE_CHECKED_CULL_FACE,
+   OPCODE_CHECKED_FRONT_FACE,
+   OPCODE_CHECKED_SHADE_MODEL,
+   OPCODE_CHECKED_POLYGON_MODE,
+   OPCODE_CHECKED_LINE_WIDTH,
+   OPCODE_CHECKED_POINT_SIZE,
+   OPCODE_CHECKED_COLOR_MASK,
+   OPCODE_CHECKED_DEPTH_MASK,
+   OPCODE_CHECKED_LINE_STIPPLE,
+   OPCODE_CHECKED_POLYGON_OFFSET,
+
+   /* The following four are meta instructions */
    OPCODE_ERROR,                /* raise compiled-in error */
    OPCODE_CONTINUE,
    OPCODE_NOP,                  /* No-op (used for 8-byte alignment */
+   OPCODE_SKIP,                 /* Skip n[1].ui nodes (see optimize_list) */
    OPCODE_END_OF_LIST,
    OPCODE_EXT_0
 } OpCode;
@@ -840,6 +865,9 @@ _mesa_delete_list(struct gl_context *ctx, struct gl_display_list *dlist)
             free(block);
             block = n;
             break;
+         case OPCODE_SKIP:
+            n += n[1].ui;
+            break;
          case OPCODE_END_OF_LIST:
             free(block);
             done = GL_TRUE;
@@ -1212,6 +1240,354 @@ trim_list(struct gl_context *ctx)
 
 
 
+/**
+ * If the instruction at \p n is a state setting that optimize_list() can
+ * fold, return GL_TRUE and a key such that the instruction only changes
+ * the state named by the key, replacing all of it.  Such an instruction
+ * must never raise an error, read any other state, or have any other
+ * side effect when executed.
+ */
+static GLboolean
+get_state_key(const Node *n, GLuint *key)
+{
+   const OpCode opcode = n[0].opcode;
+
+   switch (opcode) {
+   case OPCODE_ATTR_1F_NV:
+   case OPCODE_ATTR_2F_NV:
+   case OPCODE_ATTR_3F_NV:
+   case OPCODE_ATTR_4F_NV:
+      /* The position attribute emits a vertex */
+      *key = (OPCODE_ATTR_4F_NV << 16) | n[1].ui;
+      return n[1].ui != VERT_ATTRIB_POS;
+   case OPCODE_ATTR_1F_ARB:
+   case OPCODE_ATTR_2F_ARB:
+   case OPCODE_ATTR_3F_ARB:
+   case OPCODE_ATTR_4F_ARB:
+      /* Generic attribute 0 aliases the position */
+      *key = (OPCODE_ATTR_4F_ARB << 16) | n[1].ui;
+      return n[1].ui != 0;
+   case OPCODE_ENABLE:
+   case OPCODE_DISABLE:
+      *key = (OPCODE_ENABLE << 16) | n[1].e;
+      switch (n[1].e) {
+      case GL_ALPHA_TEST:
+      case GL_BLEND:
+      case GL_COLOR_LOGIC_OP:
+      case GL_CULL_FACE:
+      case GL_DEPTH_TEST:
+      case GL_DITHER:
+      case GL_FOG:
+      case GL_LIGHTING:
+      case GL_LIGHT0:
+      case GL_LIGHT1:
+      case GL_LIGHT2:
+      case GL_LIGHT3:
+      case GL_LIGHT4:
+      case GL_LIGHT5:
+      case GL_LIGHT6:
+      case GL_LIGHT7:
+      case GL_LINE_SMOOTH:
+      case GL_LINE_STIPPLE:
+      case GL_NORMALIZE:
+      case GL_POINT_SMOOTH:
+      case GL_POLYGON_OFFSET_FILL:
+      case GL_POLYGON_OFFSET_LINE:
+      case GL_POLYGON_OFFSET_POINT:
+      case GL_POLYGON_SMOOTH:
+      case GL_POLYGON_STIPPLE:
+      case GL_RESCALE_NORMAL:
+      case GL_SCISSOR_TEST:
+      case GL_STENCIL_TEST:
+         return GL_TRUE;
+      default:
+         /* Not known to be valid, or has side effects, like
+          * GL_COLOR_MATERIAL which picks up the current color.
+          */
+         return GL_FALSE;
+      }
+   case OPCODE_ALPHA_FUNC:
+   case OPCODE_DEPTH_FUNC:
+      *key = opcode << 16;
+      return n[1].e >= GL_NEVER && n[1].e <= GL_ALWAYS;
+   case OPCODE_CULL_FACE:
+      *key = opcode << 16;
+      return n[1].e == GL_FRONT || n[1].e == GL_BACK ||
+             n[1].e == GL_FRONT_AND_BACK;
+   case OPCODE_FRONT_FACE:
+      *key = opcode << 16;
+      return n[1].e == GL_CW || n[1].e == GL_CCW;
+   case OPCODE_SHADE_MODEL:
+      *key = opcode << 16;
+      return n[1].e == GL_FLAT || n[1].e == GL_SMOOTH;
+   case OPCODE_POLYGON_MODE:
+      /* Only when setting both faces, so that a later call covers an
+       * earlier one completely.
+       */
+      *key = opcode << 16;
+      return n[1].e == GL_FRONT_AND_BACK &&
+             (n[2].e == GL_POINT || n[2].e == GL_LINE || n[2].e == GL_FILL);
+   case OPCODE_LINE_WIDTH:
+   case OPCODE_POINT_SIZE:
+      *key = opcode << 16;
+      return n[1].f > 0.0F;
+   case OPCODE_COLOR_MASK:
+   case OPCODE_DEPTH_MASK:
+   case OPCODE_LINE_STIPPLE:
+   case OPCODE_POLYGON_OFFSET:
+      *key = opcode << 16;
+      return GL_TRUE;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+/**
+ * The opcode which applies the checked state setting of \p opcode, with
+ * the same operands, or \p opcode itself if there is none.
+ */
+static OpCode
+checked_opcode(OpCode opcode)
+{
+   switch (opcode) {
+   case OPCODE_ENABLE:
+      return OPCODE_CHECKED_ENABLE;
+   case OPCODE_DISABLE:
+      return OPCODE_CHECKED_DISABLE;
+   case OPCODE_ALPHA_FUNC:
+      return OPCODE_CHECKED_ALPHA_FUNC;
+   case OPCODE_DEPTH_FUNC:
+      return OPCODE_CHECKED_DEPTH_FUNC;
+   case OPCODE_CULL_FACE:
+      return OPCODE_CHECKED_CULL_FACE;
+   case OPCODE_FRONT_FACE:
+      return OPCODE_CHECKED_FRONT_FACE;
+   case OPCODE_SHADE_MODEL:
+      return OPCODE_CHECKED_SHADE_MODEL;
+   case OPCODE_POLYGON_MODE:
+      return OPCODE_CHECKED_POLYGON_MODE;
+   case OPCODE_LINE_WIDTH:
+      return OPCODE_CHECKED_LINE_WIDTH;
+   case OPCODE_POINT_SIZE:
+      return OPCODE_CHECKED_POINT_SIZE;
+   case OPCODE_COLOR_MASK:
+      return OPCODE_CHECKED_COLOR_MASK;
+   case OPCODE_DEPTH_MASK:
+      return OPCODE_CHECKED_DEPTH_MASK;
+   case OPCODE_LINE_STIPPLE:
+      return OPCODE_CHECKED_LINE_STIPPLE;
+   case OPCODE_POLYGON_OFFSET:
+      return OPCODE_CHECKED_POLYGON_OFFSET;
+   default:
+      /* Vertex attributes go straight to the vbo module anyway */
+      return opcode;
+   }
+}
+
+
+/**
+ * Execute a state setting that optimize_list() has checked.  Its operands
+ * are known to be valid, so past the glBegin/glEnd check this calls the
+ * setter the API entry point uses once it has validated them.
+ */
+static void
+apply_checked_state(struct gl_context *ctx, const Node *n)
+{
+   ASSERT_OUTSIDE_BEGIN_END(ctx);
+
+   switch (n[0].opcode) {
+   case OPCODE_CHECKED_ENABLE:
+      _mesa_set_enable(ctx, n[1].e, GL_TRUE);
+      break;
+   case OPCODE_CHECKED_DISABLE:
+      _mesa_set_enable(ctx, n[1].e, GL_FALSE);
+      break;
+   case OPCODE_CHECKED_ALPHA_FUNC:
+      _mesa_alpha_func(ctx, n[1].e, n[2].f);
+      break;
+   case OPCODE_CHECKED_DEPTH_FUNC:
+      _mesa_depth_func(ctx, n[1].e);
+      break;
+   case OPCODE_CHECKED_CULL_FACE:
+      _mesa_cull_face(ctx, n[1].e);
+      break;
+   case OPCODE_CHECKED_FRONT_FACE:
+      _mesa_front_face(ctx, n[1].e);
+      break;
+   case OPCODE_CHECKED_SHADE_MODEL:
+      _mesa_shade_model(ctx, n[1].e);
+      break;
+   case OPCODE_CHECKED_POLYGON_MODE:
+      _mesa_polygon_mode(ctx, n[1].e, n[2].e);
+      break;
+   case OPCODE_CHECKED_LINE_WIDTH:
+      _mesa_line_width(ctx, n[1].f);
+      break;
+   case OPCODE_CHECKED_POINT_SIZE:
+      _mesa_point_size(ctx, n[1].f);
+      break;
+   case OPCODE_CHECKED_COLOR_MASK:
+      _mesa_color_mask(ctx, n[1].b, n[2].b, n[3].b, n[4].b);
+      break;
+   case OPCODE_CHECKED_DEPTH_MASK:
+      _mesa_depth_mask(ctx, n[1].b);
+      break;
+   case OPCODE_CHECKED_LINE_STIPPLE:
+      _mesa_line_stipple(ctx, n[1].i, n[2].us);
+      break;
+   case OPCODE_CHECKED_POLYGON_OFFSET:
+      _mesa_polygon_offset_clamp(ctx, n[1].f, n[2].f, 0.0F);
+      break;
+   default:
+      unreachable("not a checked state setting");
+   }
+}
+
+
+struct state_run_entry {
+   Node *n;
+   GLuint size;
+   GLuint key;
+   GLboolean dead;
+};
+
+
+/**
+ * Remove the dead instructions of a run of state settings: those whose
+ * state is set again later in the run.  The remaining ones are turned into
+ * their checked_opcode().  Within each block, they are moved to the start
+ * of the run and the freed nodes are covered by a single OPCODE_SKIP.
+ */
+static void
+fold_state_run(struct state_run_entry *run, GLuint count,
+               GLuint *keys, GLuint *removed)
+{
+   GLuint num_keys = 0, i, j, first;
+
+   for (i = count; i-- > 0; ) {
+      if (run[i].n[0].opcode == OPCODE_NOP) {
+         run[i].dead = GL_TRUE;
+         continue;
+      }
+
+      for (j = 0; j < num_keys && keys[j] != run[i].key; j++)
+         ;
+
+      run[i].dead = j < num_keys;
+      if (!run[i].dead) {
+         const OpCode opcode = checked_opcode(run[i].n[0].opcode);
+
+         keys[num_keys++] = run[i].key;
+         assert(opcode == run[i].n[0].opcode ||
+                InstSize[opcode] == run[i].size);
+         run[i].n[0].opcode = opcode;
+      }
+   }
+
+   /* Compact each stretch of contiguous instructions */
+   for (first = 0; first < count; first = i) {
+      Node *dst = run[first].n;
+      Node *end;
+      GLboolean any_dead = GL_FALSE;
+
+      for (i = first; i < count; i++) {
+         if (i > first && run[i].n != run[i - 1].n + run[i - 1].size)
+            break;
+         any_dead |= run[i].dead;
+      }
+
+      if (!any_dead)
+         continue;
+
+      end = run[i - 1].n + run[i - 1].size;
+      for (j = first; j < i; j++) {
+         if (!run[j].dead) {
+            memmove(dst, run[j].n, run[j].size * sizeof(Node));
+            dst += run[j].size;
+         }
+      }
+
+      *removed += end - dst;
+      if (end - dst == 1) {
+         dst[0].opcode = OPCODE_NOP;
+      }
+      else {
+         dst[0].opcode = OPCODE_SKIP;
+         dst[1].ui = end - dst;
+      }
+   }
+}
+
+
+/**
+ * Called from glEndList to fold the runs of state setting instructions in
+ * the list: all the instructions of a run are known not to raise errors or
+ * depend on each other, so only the last setting of each piece of state in
+ * a run needs to be kept.  Apps often set the same state over and over.
+ */
+static void
+optimize_list(struct gl_context *ctx, struct gl_display_list *dlist)
+{
+   struct state_run_entry *run = NULL;
+   GLuint *keys = NULL;
+   GLuint count = 0, max = 0, removed = 0;
+   Node *n = dlist->Head;
+
+   for (;;) {
+      const OpCode opcode = n[0].opcode;
+      GLuint key = 0;
+
+      if (opcode == OPCODE_CONTINUE) {
+         n = (Node *) get_pointer(&n[1]);
+         continue;
+      }
+
+      if (opcode == OPCODE_NOP ||
+          (!is_ext_opcode(opcode) && get_state_key(n, &key))) {
+         if (count == max) {
+            struct state_run_entry *new_run;
+            GLuint *new_keys;
+
+            max = MAX2(2 * max, 64);
+            new_run = realloc(run, max * sizeof(*run));
+            if (new_run)
+               run = new_run;
+            new_keys = realloc(keys, max * sizeof(*keys));
+            if (new_keys)
+               keys = new_keys;
+            if (!new_run || !new_keys)
+               break;
+         }
+
+         run[count].n = n;
+         run[count].size = InstSize[opcode];
+         run[count].key = key;
+         count++;
+         n += InstSize[opcode];
+         continue;
+      }
+
+      if (count > 0)
+         fold_state_run(run, count, keys, &removed);
+      count = 0;
+
+      if (opcode == OPCODE_END_OF_LIST)
+         break;
+
+      n += is_ext_opcode(opcode) ?
+         ctx->ListExt->Opcode[opcode - OPCODE_EXT_0].Size : InstSize[opcode];
+   }
+
+   free(run);
+   free(keys);
+
+   if (removed && (MESA_VERBOSE & VERBOSE_DISPLAY_LIST))
+      _mesa_debug(ctx, "glEndList: folded away %u nodes of state settings\n",
+                  removed);
+}
+
+
 /*
  * Display List compilation functions
  */
@@ -8880,6 +9256,26 @@ execute_list(struct gl_context *ctx, GLuint list)
          case OPCODE_NOP:
             /* no-op */
             break;
+         case OPCODE_SKIP:
+            /* InstSize[OPCODE_SKIP] is zero */
+            n += n[1].ui;
+            break;
+         case OPCODE_CHECKED_ENABLE:
+         case OPCODE_CHECKED_DISABLE:
+         case OPCODE_CHECKED_ALPHA_FUNC:
+         case OPCODE_CHECKED_DEPTH_FUNC:
+         case OPCODE_CHECKED_CULL_FACE:
+         case OPCODE_CHECKED_FRONT_FACE:
+         case OPCODE_CHECKED_SHADE_MODEL:
+         case OPCODE_CHECKED_POLYGON_MODE:
+         case OPCODE_CHECKED_LINE_WIDTH:
+         case OPCODE_CHECKED_POINT_SIZE:
+         case OPCODE_CHECKED_COLOR_MASK:
+         case OPCODE_CHECKED_DEPTH_MASK:
+         case OPCODE_CHECKED_LINE_STIPPLE:
+         case OPCODE_CHECKED_POLYGON_OFFSET:
+            apply_checked_state(ctx, n);
+            break;
          case OPCODE_END_OF_LIST:
             done = GL_TRUE;
             break;
@@ -9067,6 +9463,8 @@ _mesa_EndList(void)
 
    (void) alloc_instruction(ctx, OPCODE_END_OF_LIST, 0);
 
+   optimize_list(ctx, ctx->ListState.CurrentList);
+
    trim_list(ctx);
 
    /* Destroy old list, if any */
@@ -9935,6 +10333,10 @@ print_list(struct gl_context *ctx, GLuint list, const char *fname)
          case OPCODE_NOP:
             fprintf(f, "NOP\n");
             break;
+         case OPCODE_SKIP:
+            fprintf(f, "SKIP %u\n", n[1].ui);
+            n += n[1].ui;
+            break;
          case OPCODE_END_OF_LIST:
             fprintf(f, "END-LIST %u\n", list);
             done = GL_TRUE;
@@ -10087,6 +10489,26 @@ _mesa_init_display_list(struct gl_context *ctx)
    save_vtxfmt_init(&ctx->ListState.ListVtxfmt);
 
    InstSize[OPCODE_NOP] = 1;
+   /* OPCODE_SKIP carries its own size */
+   InstSize[OPCODE_SKIP] = 0;
+   /* The checked state settings are never allocated: optimize_list()
+    * rewrites the opcode of a regular state setting in place.  Their sizes
+    * are those of the instructions they replace.
+    */
+   InstSize[OPCODE_CHECKED_ENABLE] = 2;
+   InstSize[OPCODE_CHECKED_DISABLE] = 2;
+   InstSize[OPCODE_CHECKED_ALPHA_FUNC] = 3;
+   InstSize[OPCODE_CHECKED_DEPTH_FUNC] = 2;
+   InstSize[OPCODE_CHECKED_CULL_FACE] = 2;
+   InstSize[OPCODE_CHECKED_FRONT_FACE] = 2;
+   InstSize[OPCODE_CHECKED_SHADE_MODEL] = 2;
+   InstSize[OPCODE_CHECKED_POLYGON_MODE] = 3;
+   InstSize[OPCODE_CHECKED_LINE_WIDTH] = 2;
+   InstSize[OPCODE_CHECKED_POINT_SIZE] = 2;
+   InstSize[OPCODE_CHECKED_COLOR_MASK] = 5;
+   InstSize[OPCODE_CHECKED_DEPTH_MASK] = 2;
+   InstSize[OPCODE_CHECKED_LINE_STIPPLE] = 3;
+   InstSize[OPCODE_CHECKED_POLYGON_OFFSET] = 3;
 }
 
 
@@ -38,31 +38,53 @@
 #include "imports.h"
 #include "hash.h"
 #include "util/hash_table.h"
+#include "util/u_atomic.h"
 
 /**
- * Magic GLuint object name that gets stored outside of the struct hash_table.
+ * Magic GLuint object name used as the deleted key marker of the struct
+ * hash_table.
  *
  * The hash table needs a particular pointer to be the marker for a key that
  * was deleted from the table, along with NULL for the "never allocated in the
  * table" marker.  Legacy GL allows any GLuint to be used as a GL object name,
- * and we use a 1:1 mapping from GLuints to key pointers, so we need to be
- * able to track a GLuint that happens to match the deleted key outside of
- * struct hash_table.  We tell the hash table to use "1" as the deleted key
- * value, so that we test the deleted-key-in-the-table path as best we can.
+ * and we use a 1:1 mapping from GLuints to key pointers.  Small keys are
+ * always stored in the dense array, so "1" never reaches the hash table.
  */
 #define DELETED_KEY_VALUE 1
 
+/**
+ * Initial and maximum sizes of the dense array.  Names genned with
+ * glGen*() are contiguous from 1, so most tables never need the
+ * struct hash_table at all.
+ */
+#define DENSE_MIN_SIZE 64
+#define DENSE_MAX_SIZE (64 * 1024)
+
+/**
+ * Direct-indexed storage for the keys below Size.
+ *
+ * Lookups read it without taking the table mutex.  Writers, which hold the
+ * mutex, only ever update single pointers in place; when the array grows,
+ * the new one is filled first and then published, and the old one is kept
+ * around until the table is deleted since a reader may still be using it.
+ */
+struct _mesa_HashDense {
+   GLuint Size;
+   struct _mesa_HashDense *Retired;  /**< previous, smaller array */
+   void **Data;
+};
+
 /**
  * The hash table data structure.  
  */
 struct _mesa_HashTable {
-   struct hash_table *ht;
+   struct hash_table *ht;               /**< keys >= Dense->Size */
+   struct _mesa_HashDense *Dense;       /**< keys < Dense->Size */
+   GLuint DenseCount;                   /**< non-NULL entries in Dense */
    GLuint MaxKey;                        /**< highest key inserted so far */
    mtx_t Mutex;                /**< mutual exclusion lock */
    mtx_t WalkMutex;            /**< for _mesa_HashWalk() */
    GLboolean InDeleteAll;                /**< Debug check */
-   /** Value that would be in the table for DELETED_KEY_VALUE. */
-   void *deleted_key_data;
 };
 
 /** @{
@@ -109,6 +131,54 @@ uint_key(GLuint id)
 }
 /** @} */
 
+
+static struct _mesa_HashDense *
+dense_create(GLuint size, struct _mesa_HashDense *retired)
+{
+   struct _mesa_HashDense *dense =
+      calloc(1, sizeof(struct _mesa_HashDense) + size * sizeof(void *));
+
+   if (dense) {
+      dense->Size = size;
+      dense->Retired = retired;
+      dense->Data = (void **) (dense + 1);
+   }
+
+   return dense;
+}
+
+
+/**
+ * Replace the dense array by one of twice the size, moving over the keys
+ * it now covers from the hash table.  Called with the mutex held.
+ */
+static void
+dense_grow(struct _mesa_HashTable *table)
+{
+   struct _mesa_HashDense *old = table->Dense;
+   struct _mesa_HashDense *dense = dense_create(old->Size * 2, old);
+   struct hash_entry *entry;
+
+   if (!dense)
+      return;
+
+   memcpy(dense->Data, old->Data, old->Size * sizeof(void *));
+
+   hash_table_foreach(table->ht, entry) {
+      GLuint key = (uintptr_t) entry->key;
+      if (key < dense->Size) {
+         dense->Data[key] = entry->data;
+         table->DenseCount++;
+         _mesa_hash_table_remove(table->ht, entry);
+      }
+   }
+
+   /* Publish the filled array; the compare-and-swap is a full barrier. */
+   (void) p_atomic_cmpxchg((uintptr_t *) &table->Dense,
+                           (uintptr_t) old, (uintptr_t) dense);
+}
+
+
 /**
  * Create a new hash table.
  * 
@@ -122,7 +192,11 @@ _mesa_NewHashTable(void)
    if (table) {
       table->ht = _mesa_hash_table_create(NULL, uint_key_hash,
                                           uint_key_compare);
-      if (table->ht == NULL) {
+      table->Dense = dense_create(DENSE_MIN_SIZE, NULL);
+      if (table->ht == NULL || table->Dense == NULL) {
+         if (table->ht)
+            _mesa_hash_table_destroy(table->ht, NULL);
+         free(table->Dense);
          free(table);
          _mesa_error_no_memory(__func__);
          return NULL;
@@ -152,14 +226,24 @@ _mesa_NewHashTable(void)
 void
 _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 {
+   struct _mesa_HashDense *dense;
+
    assert(table);
 
-   if (_mesa_hash_table_next_entry(table->ht, NULL) != NULL) {
+   if (_mesa_hash_table_next_entry(table->ht, NULL) != NULL ||
+       table->DenseCount != 0) {
       _mesa_problem(NULL, "In _mesa_DeleteHashTable, found non-freed data");
    }
 
    _mesa_hash_table_destroy(table->ht, NULL);
 
+   dense = table->Dense;
+   while (dense) {
+      struct _mesa_HashDense *retired = dense->Retired;
+      free(dense);
+      dense = retired;
+   }
+
    mtx_destroy(&table->Mutex);
    mtx_destroy(&table->WalkMutex);
    free(table);
@@ -179,8 +263,8 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
    assert(table);
    assert(key);
 
-   if (key == DELETED_KEY_VALUE)
-      return table->deleted_key_data;
+   if (key < table->Dense->Size)
+      return table->Dense->Data[key];
 
    entry = _mesa_hash_table_search(table->ht, uint_key(key));
    if (!entry)
@@ -192,6 +276,9 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
 
 /**
  * Lookup an entry in the hash table.
+ *
+ * Keys in the dense array are looked up without taking the mutex, only
+ * larger keys need it.
  * 
  * \param table the hash table.
  * \param key the key.
@@ -201,8 +288,18 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
 void *
 _mesa_HashLookup(struct _mesa_HashTable *table, GLuint key)
 {
+   const struct _mesa_HashDense *dense;
    void *res;
    assert(table);
+   assert(key);
+
+   dense = p_atomic_read(&table->Dense);
+   if (key < dense->Size)
+      return p_atomic_read(&dense->Data[key]);
+
+   /* The key may have moved to a grown dense array meanwhile, which the
+    * locked lookup checks again.
+    */
    mtx_lock(&table->Mutex);
    res = _mesa_HashLookup_unlocked(table, key);
    mtx_unlock(&table->Mutex);
@@ -270,8 +367,20 @@ _mesa_HashInsert_unlocked(struct _mesa_HashTable *table, GLuint key, void *data)
    if (key > table->MaxKey)
       table->MaxKey = key;
 
-   if (key == DELETED_KEY_VALUE) {
-      table->deleted_key_data = data;
+   /* Grow the dense array while the keys stay roughly contiguous. */
+   if (key >= table->Dense->Size &&
+       key < 2 * table->Dense->Size &&
+       key < DENSE_MAX_SIZE)
+      dense_grow(table);
+
+   if (key < table->Dense->Size) {
+      void **slot = &table->Dense->Data[key];
+
+      if (!*slot && data)
+         table->DenseCount++;
+      else if (*slot && !data)
+         table->DenseCount--;
+      p_atomic_set(slot, data);
    } else {
       entry = _mesa_hash_table_search_pre_hashed(table->ht, hash, uint_key(key));
       if (entry) {
@@ -344,8 +453,12 @@ _mesa_HashRemove(struct _mesa_HashTable *table, GLuint key)
    }
 
    mtx_lock(&table->Mutex);
-   if (key == DELETED_KEY_VALUE) {
-      table->deleted_key_data = NULL;
+   if (key < table->Dense->Size) {
+      void **slot = &table->Dense->Data[key];
+
+      if (*slot)
+         table->DenseCount--;
+      p_atomic_set(slot, NULL);
    } else {
       entry = _mesa_hash_table_search(table->ht, uint_key(key));
       _mesa_hash_table_remove(table->ht, entry);
@@ -370,19 +483,24 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
                     void *userData)
 {
    struct hash_entry *entry;
+   GLuint key;
 
    assert(table);
    assert(callback);
    mtx_lock(&table->Mutex);
    table->InDeleteAll = GL_TRUE;
+   for (key = 1; key < table->Dense->Size; key++) {
+      void *data = table->Dense->Data[key];
+      if (data) {
+         callback(key, data, userData);
+         p_atomic_set(&table->Dense->Data[key], NULL);
+      }
+   }
+   table->DenseCount = 0;
    hash_table_foreach(table->ht, entry) {
       callback((uintptr_t)entry->key, entry->data, userData);
       _mesa_hash_table_remove(table->ht, entry);
    }
-   if (table->deleted_key_data) {
-      callback(DELETED_KEY_VALUE, table->deleted_key_data, userData);
-      table->deleted_key_data = NULL;
-   }
    table->InDeleteAll = GL_FALSE;
    mtx_unlock(&table->Mutex);
 }
@@ -395,6 +513,14 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
  * prevent multiple threads/contexts from getting tangled up.
  * A lock-less version of this function could be used when the table will
  * not be modified.
+ *
+ * The table mutex is not held, so entries inserted or removed during the
+ * walk, by the callback or by another thread, may or may not be visited.
+ * In particular, a key that an insertion makes dense_grow() move from the
+ * hash table to the dense array is skipped: the walk goes through the
+ * dense array it started with, and the key has left the hash table by the
+ * time that is walked.  A key removed and inserted again may be visited
+ * twice.
  * \param table  the hash table to walk
  * \param callback  the callback function
  * \param userData  arbitrary pointer to pass along to the callback
@@ -408,15 +534,25 @@ _mesa_HashWalk(const struct _mesa_HashTable *table,
    /* cast-away const */
    struct _mesa_HashTable *table2 = (struct _mesa_HashTable *) table;
    struct hash_entry *entry;
+   GLuint key;
 
    assert(table);
    assert(callback);
    mtx_lock(&table2->WalkMutex);
+   /* The callback may remove entries, or insert and so grow the array; a
+    * replaced array stays valid until the table is deleted.
+    */
+   {
+      const struct _mesa_HashDense *dense = table->Dense;
+      for (key = 1; key < dense->Size; key++) {
+         void *data = dense->Data[key];
+         if (data)
+            callback(key, data, userData);
+      }
+   }
    hash_table_foreach(table->ht, entry) {
       callback((uintptr_t)entry->key, entry->data, userData);
    }
-   if (table->deleted_key_data)
-      callback(DELETED_KEY_VALUE, table->deleted_key_data, userData);
    mtx_unlock(&table2->WalkMutex);
 }
 
@@ -434,8 +570,6 @@ debug_print_entry(GLuint key, void *data, void *userData)
 void
 _mesa_HashPrint(const struct _mesa_HashTable *table)
 {
-   if (table->deleted_key_data)
-      debug_print_entry(DELETED_KEY_VALUE, table->deleted_key_data, NULL);
    _mesa_HashWalk(table, debug_print_entry, NULL);
 }
 
@@ -497,10 +631,7 @@ GLuint
 _mesa_HashNumEntries(const struct _mesa_HashTable *table)
 {
    struct hash_entry *entry;
-   GLuint count = 0;
-
-   if (table->deleted_key_data)
-      count++;
+   GLuint count = table->DenseCount;
 
    hash_table_foreach(table->ht, entry)
       count++;
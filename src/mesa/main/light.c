@@ -36,6 +36,19 @@
 #include "math/m_matrix.h"
 
 
+void
+_mesa_shade_model(struct gl_context *ctx, GLenum mode)
+{
+   if (ctx->Light.ShadeModel == mode)
+      return;
+
+   FLUSH_VERTICES(ctx, _NEW_LIGHT);
+   ctx->Light.ShadeModel = mode;
+
+   if (ctx->Driver.ShadeModel)
+      ctx->Driver.ShadeModel( ctx, mode );
+}
+
 void GLAPIENTRY
 _mesa_ShadeModel( GLenum mode )
 {
@@ -49,14 +62,7 @@ _mesa_ShadeModel( GLenum mode )
       return;
    }
 
-   if (ctx->Light.ShadeModel == mode)
-      return;
-
-   FLUSH_VERTICES(ctx, _NEW_LIGHT);
-   ctx->Light.ShadeModel = mode;
-
-   if (ctx->Driver.ShadeModel)
-      ctx->Driver.ShadeModel( ctx, mode );
+   _mesa_shade_model(ctx, mode);
 }
 
 
@@ -34,6 +34,9 @@ struct gl_context;
 struct gl_light;
 struct gl_material;
 
+extern void
+_mesa_shade_model(struct gl_context *ctx, GLenum mode);
+
 extern void GLAPIENTRY
 _mesa_ShadeModel( GLenum mode );
 
@@ -37,6 +37,19 @@
  *
  * \sa glLineWidth().
  */
+void
+_mesa_line_width(struct gl_context *ctx, GLfloat width)
+{
+   if (ctx->Line.Width == width)
+      return;
+
+   FLUSH_VERTICES(ctx, _NEW_LINE);
+   ctx->Line.Width = width;
+
+   if (ctx->Driver.LineWidth)
+      ctx->Driver.LineWidth(ctx, width);
+}
+
 void GLAPIENTRY
 _mesa_LineWidth( GLfloat width )
 {
@@ -68,14 +81,7 @@ _mesa_LineWidth( GLfloat width )
       return;
    }
 
-   if (ctx->Line.Width == width)
-      return;
-
-   FLUSH_VERTICES(ctx, _NEW_LINE);
-   ctx->Line.Width = width;
-
-   if (ctx->Driver.LineWidth)
-      ctx->Driver.LineWidth(ctx, width);
+   _mesa_line_width(ctx, width);
 }
 
 
@@ -91,14 +97,9 @@ _mesa_LineWidth( GLfloat width )
  * change flushes the vertices and notifies the driver via
  * the dd_function_table::LineStipple callback.
  */
-void GLAPIENTRY
-_mesa_LineStipple( GLint factor, GLushort pattern )
+void
+_mesa_line_stipple(struct gl_context *ctx, GLint factor, GLushort pattern)
 {
-   GET_CURRENT_CONTEXT(ctx);
-
-   if (MESA_VERBOSE & VERBOSE_API)
-      _mesa_debug(ctx, "glLineStipple %d %u\n", factor, pattern);
-
    factor = CLAMP( factor, 1, 256 );
 
    if (ctx->Line.StippleFactor == factor &&
@@ -113,6 +114,17 @@ _mesa_LineStipple( GLint factor, GLushort pattern )
       ctx->Driver.LineStipple( ctx, factor, pattern );
 }
 
+void GLAPIENTRY
+_mesa_LineStipple( GLint factor, GLushort pattern )
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (MESA_VERBOSE & VERBOSE_API)
+      _mesa_debug(ctx, "glLineStipple %d %u\n", factor, pattern);
+
+   _mesa_line_stipple(ctx, factor, pattern);
+}
+
 
 /**
  * Initialize the context line state.
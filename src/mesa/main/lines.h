@@ -37,9 +37,15 @@
 
 struct gl_context;
 
+extern void
+_mesa_line_width(struct gl_context *ctx, GLfloat width);
+
 extern void GLAPIENTRY
 _mesa_LineWidth( GLfloat width );
 
+extern void
+_mesa_line_stipple(struct gl_context *ctx, GLint factor, GLushort pattern);
+
 extern void GLAPIENTRY
 _mesa_LineStipple( GLint factor, GLushort pattern );
 
@@ -37,6 +37,7 @@
 #include <stdint.h>             /* uint32_t */
 #include <stdbool.h>
 #include "c11/threads.h"
+#include "util/u_queue.h"
 
 #include "main/glheader.h"
 #include "main/config.h"
@@ -803,6 +804,7 @@ struct gl_hint_attrib
    GLenum TextureCompression;   /**< GL_ARB_texture_compression */
    GLenum GenerateMipmap;       /**< GL_SGIS_generate_mipmap */
    GLenum FragmentShaderDerivative; /**< GL_ARB_fragment_shader */
+   GLuint MaxShaderCompilerThreads; /**< GL_ARB_parallel_shader_compile */
 };
 
 
@@ -2380,9 +2382,36 @@ struct gl_shader
    GLuint SourceChecksum;       /**< for debug/logging purposes */
    const GLchar *Source;  /**< Source code string */
 
+   /**
+    * SHA-1 of the source and of the context state that affects compiling
+    * it, used as the shader's key in the shader cache.  All zeros if the
+    * shader wasn't compiled with the cache enabled.
+    */
+   unsigned char sha1[20];
+
+   /**
+    * Copy of \c Source when the shader cache skipped compiling it.  If the
+    * program isn't found in the cache at link time, the shader is compiled
+    * from this, since \c Source may have been replaced in the meantime.
+    */
+   const GLchar *FallbackSource;
+
    struct gl_program *Program;  /**< Post-compile assembly code */
    GLchar *InfoLog;
 
+   /**
+    * Signalled once the compile started by glCompileShader has run, which
+    * may be on the share group's ShaderCompilerQueue.
+    */
+   struct util_queue_fence CompileFence;
+
+   /**
+    * Held by the links running on the ShaderCompilerQueue while they use
+    * the shader, so that programs sharing it aren't linked concurrently.
+    */
+   mtx_t Mutex;
+   GLint PendingLinks;  /**< queued links using the shader (atomic) */
+
    unsigned Version;       /**< GLSL version used for linking */
 
    /**
@@ -2620,6 +2649,25 @@ struct gl_shader_program
     */
    GLboolean BinaryRetreivableHint;
 
+   /**
+    * What glGetProgramBinary returns for this program.
+    *
+    * It is made when the program is linked with BinaryRetreivableHint set,
+    * since drivers lower the linked IR in place, and kept when the program
+    * is loaded from a binary.  NULL for other programs.
+    */
+   GLubyte *Binary;
+   GLsizei BinaryLength;
+
+   /**
+    * Signalled once the GLSL linker has run for the last glLinkProgram,
+    * which may be on the share group's ShaderCompilerQueue.  The driver's
+    * LinkShader hook is called by the first user of the program after that,
+    * on its own thread, and \c LinkPending is set until then.
+    */
+   struct util_queue_fence LinkFence;
+   bool LinkPending;
+
    /**
     * Indicates whether program can be bound for individual pipeline stages
     * using UseProgramStages after it is next linked.
@@ -3006,6 +3054,19 @@ struct gl_shared_state
    /** Table of both gl_shader and gl_shader_program objects */
    struct _mesa_HashTable *ShaderObjects;
 
+   /**
+    * Threads compiling and linking the GLSL shaders of all the contexts in
+    * the share group, created on the first compile or link that doesn't
+    * have to be synchronous (GL_ARB_parallel_shader_compile).
+    */
+   struct util_queue *ShaderCompilerQueue;
+
+   /**
+    * Threads compressing the texture images of all the contexts in the
+    * share group, created on the first image that is worth splitting.
+    */
+   struct util_queue *TextureCompressQueue;
+
    /* GL_EXT_framebuffer_object */
    struct _mesa_HashTable *RenderBuffers;
    struct _mesa_HashTable *FrameBuffers;
@@ -37,6 +37,9 @@
 struct gl_context;
 
 
+extern void
+_mesa_point_size(struct gl_context *ctx, GLfloat size);
+
 extern void GLAPIENTRY
 _mesa_PointSize( GLfloat size );
 
@@ -50,6 +50,19 @@
  * change, flushes the vertices and notifies the driver via
  * the dd_function_table::CullFace callback.
  */
+void
+_mesa_cull_face(struct gl_context *ctx, GLenum mode)
+{
+   if (ctx->Polygon.CullFaceMode == mode)
+      return;
+
+   FLUSH_VERTICES(ctx, _NEW_POLYGON);
+   ctx->Polygon.CullFaceMode = mode;
+
+   if (ctx->Driver.CullFace)
+      ctx->Driver.CullFace( ctx, mode );
+}
+
 void GLAPIENTRY
 _mesa_CullFace( GLenum mode )
 {
@@ -63,14 +76,7 @@ _mesa_CullFace( GLenum mode )
       return;
    }
 
-   if (ctx->Polygon.CullFaceMode == mode)
-      return;
-
-   FLUSH_VERTICES(ctx, _NEW_POLYGON);
-   ctx->Polygon.CullFaceMode = mode;
-
-   if (ctx->Driver.CullFace)
-      ctx->Driver.CullFace( ctx, mode );
+   _mesa_cull_face(ctx, mode);
 }
 
 
@@ -85,6 +91,19 @@ _mesa_CullFace( GLenum mode )
  * flushes the vertices and notifies the driver via
  * the dd_function_table::FrontFace callback.
  */
+void
+_mesa_front_face(struct gl_context *ctx, GLenum mode)
+{
+   if (ctx->Polygon.FrontFace == mode)
+      return;
+
+   FLUSH_VERTICES(ctx, _NEW_POLYGON);
+   ctx->Polygon.FrontFace = mode;
+
+   if (ctx->Driver.FrontFace)
+      ctx->Driver.FrontFace( ctx, mode );
+}
+
 void GLAPIENTRY
 _mesa_FrontFace( GLenum mode )
 {
@@ -98,14 +117,7 @@ _mesa_FrontFace( GLenum mode )
       return;
    }
 
-   if (ctx->Polygon.FrontFace == mode)
-      return;
-
-   FLUSH_VERTICES(ctx, _NEW_POLYGON);
-   ctx->Polygon.FrontFace = mode;
-
-   if (ctx->Driver.FrontFace)
-      ctx->Driver.FrontFace( ctx, mode );
+   _mesa_front_face(ctx, mode);
 }
 
 
@@ -121,6 +133,38 @@ _mesa_FrontFace( GLenum mode )
  * gl_polygon_attrib::BackMode. On change flushes the vertices and notifies the
  * driver via the dd_function_table::PolygonMode callback.
  */
+void
+_mesa_polygon_mode(struct gl_context *ctx, GLenum face, GLenum mode)
+{
+   switch (face) {
+   case GL_FRONT:
+      if (ctx->Polygon.FrontMode == mode)
+	 return;
+      FLUSH_VERTICES(ctx, _NEW_POLYGON);
+      ctx->Polygon.FrontMode = mode;
+      break;
+   case GL_FRONT_AND_BACK:
+      if (ctx->Polygon.FrontMode == mode &&
+	  ctx->Polygon.BackMode == mode)
+	 return;
+      FLUSH_VERTICES(ctx, _NEW_POLYGON);
+      ctx->Polygon.FrontMode = mode;
+      ctx->Polygon.BackMode = mode;
+      break;
+   case GL_BACK:
+      if (ctx->Polygon.BackMode == mode)
+	 return;
+      FLUSH_VERTICES(ctx, _NEW_POLYGON);
+      ctx->Polygon.BackMode = mode;
+      break;
+   default:
+      unreachable("invalid polygon mode face");
+   }
+
+   if (ctx->Driver.PolygonMode)
+      ctx->Driver.PolygonMode(ctx, face, mode);
+}
+
 void GLAPIENTRY
 _mesa_PolygonMode( GLenum face, GLenum mode )
 {
@@ -138,40 +182,20 @@ _mesa_PolygonMode( GLenum face, GLenum mode )
 
    switch (face) {
    case GL_FRONT:
+   case GL_BACK:
       if (ctx->API == API_OPENGL_CORE) {
          _mesa_error( ctx, GL_INVALID_ENUM, "glPolygonMode(face)" );
          return;
       }
-      if (ctx->Polygon.FrontMode == mode)
-	 return;
-      FLUSH_VERTICES(ctx, _NEW_POLYGON);
-      ctx->Polygon.FrontMode = mode;
       break;
    case GL_FRONT_AND_BACK:
-      if (ctx->Polygon.FrontMode == mode &&
-	  ctx->Polygon.BackMode == mode)
-	 return;
-      FLUSH_VERTICES(ctx, _NEW_POLYGON);
-      ctx->Polygon.FrontMode = mode;
-      ctx->Polygon.BackMode = mode;
-      break;
-   case GL_BACK:
-      if (ctx->API == API_OPENGL_CORE) {
-         _mesa_error( ctx, GL_INVALID_ENUM, "glPolygonMode(face)" );
-         return;
-      }
-      if (ctx->Polygon.BackMode == mode)
-	 return;
-      FLUSH_VERTICES(ctx, _NEW_POLYGON);
-      ctx->Polygon.BackMode = mode;
       break;
    default:
       _mesa_error( ctx, GL_INVALID_ENUM, "glPolygonMode(face)" );
       return;
    }
 
-   if (ctx->Driver.PolygonMode)
-      ctx->Driver.PolygonMode(ctx, face, mode);
+   _mesa_polygon_mode(ctx, face, mode);
 }
 
 
@@ -39,12 +39,21 @@ struct gl_context;
 extern void GLAPIENTRY
 _mesa_GetnPolygonStippleARB( GLsizei bufSize, GLubyte *dest );
 
+extern void
+_mesa_cull_face(struct gl_context *ctx, GLenum mode);
+
 extern void GLAPIENTRY
 _mesa_CullFace( GLenum mode );
 
+extern void
+_mesa_front_face(struct gl_context *ctx, GLenum mode);
+
 extern void GLAPIENTRY
 _mesa_FrontFace( GLenum mode );
 
+extern void
+_mesa_polygon_mode(struct gl_context *ctx, GLenum face, GLenum mode);
+
 extern void GLAPIENTRY
 _mesa_PolygonMode( GLenum face, GLenum mode );
 
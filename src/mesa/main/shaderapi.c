@@ -41,6 +41,7 @@
 #include "main/context.h"
 #include "main/dispatch.h"
 #include "main/enums.h"
+#include "main/errors.h"
 #include "main/hash.h"
 #include "main/mtypes.h"
 #include "main/pipelineobj.h"
@@ -53,7 +54,12 @@
 #include "program/prog_parameter.h"
 #include "util/ralloc.h"
 #include "util/hash_table.h"
+#include "util/u_atomic.h"
 #include <stdbool.h>
+#include <stdlib.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 #include "../glsl/glsl_parser_extras.h"
 #include "../glsl/ir.h"
 #include "../glsl/ir_uniform.h"
@@ -147,6 +153,10 @@ _mesa_free_shader_state(struct gl_context *ctx)
    /* Extended for ARB_separate_shader_objects */
    _mesa_reference_pipeline_object(ctx, &ctx->_Shader, NULL);
 
+   /* The queued compiles and links may be using the context. */
+   if (ctx->Shared->ShaderCompilerQueue)
+      util_queue_finish(ctx->Shared->ShaderCompilerQueue);
+
    assert(ctx->Shader.RefCount == 1);
    mtx_destroy(&ctx->Shader.Mutex);
 }
@@ -239,7 +249,8 @@ attach_shader(struct gl_context *ctx, GLuint program, GLuint shader)
    if (!shProg)
       return;
 
-   sh = _mesa_lookup_shader_err(ctx, shader, "glAttachShader");
+   /* The shader may still be compiling, link_program() waits for it. */
+   sh = _mesa_lookup_shader_err_no_wait(ctx, shader, "glAttachShader");
    if (!sh) {
       return;
    }
@@ -520,7 +531,8 @@ get_programiv(struct gl_context *ctx, GLuint program, GLenum pname,
               GLint *params)
 {
    struct gl_shader_program *shProg
-      = _mesa_lookup_shader_program_err(ctx, program, "glGetProgramiv(program)");
+      = _mesa_lookup_shader_program_err_no_wait(ctx, program,
+                                                "glGetProgramiv(program)");
 
    /* Is transform feedback available in this context?
     */
@@ -546,6 +558,19 @@ get_programiv(struct gl_context *ctx, GLuint program, GLenum pname,
       return;
    }
 
+   /* GL_ARB_parallel_shader_compile: only the driver's part of the link
+    * is left to do once the linker has run, so let it block.
+    */
+   if (pname == GL_COMPLETION_STATUS_ARB && _mesa_is_desktop_gl(ctx)) {
+      *params = !shProg->LinkPending ||
+                util_queue_fence_is_signalled(&shProg->LinkFence);
+      if (*params)
+         _mesa_wait_shader_program(ctx, shProg);
+      return;
+   }
+
+   _mesa_wait_shader_program(ctx, shProg);
+
    switch (pname) {
    case GL_DELETE_STATUS:
       *params = shProg->DeletePending;
@@ -682,7 +707,7 @@ get_programiv(struct gl_context *ctx, GLuint program, GLenum pname,
       *params = shProg->BinaryRetreivableHint;
       return;
    case GL_PROGRAM_BINARY_LENGTH:
-      *params = 0;
+      *params = shProg->LinkStatus ? shProg->BinaryLength : 0;
       return;
    case GL_ACTIVE_ATOMIC_COUNTER_BUFFERS:
       if (!ctx->Extensions.ARB_shader_atomic_counters)
@@ -720,6 +745,19 @@ get_programiv(struct gl_context *ctx, GLuint program, GLenum pname,
 }
 
 
+/**
+ * Wait for the queued links that use \p sh.  A link may recompile the
+ * shader, which updates its compile status, info log and IR.
+ */
+static void
+wait_shader_links(struct gl_context *ctx, struct gl_shader *sh)
+{
+   if (p_atomic_read(&sh->PendingLinks) > 0 &&
+       ctx->Shared->ShaderCompilerQueue)
+      util_queue_finish(ctx->Shared->ShaderCompilerQueue);
+}
+
+
 /**
  * glGetShaderiv() - get GLSL shader state
  */
@@ -727,12 +765,22 @@ static void
 get_shaderiv(struct gl_context *ctx, GLuint name, GLenum pname, GLint *params)
 {
    struct gl_shader *shader =
-      _mesa_lookup_shader_err(ctx, name, "glGetShaderiv");
+      _mesa_lookup_shader_err_no_wait(ctx, name, "glGetShaderiv");
 
    if (!shader) {
       return;
    }
 
+   /* The other queries wait for the links using the shader as well */
+   if (pname == GL_COMPLETION_STATUS_ARB && _mesa_is_desktop_gl(ctx)) {
+      *params = util_queue_fence_is_signalled(&shader->CompileFence) &&
+                p_atomic_read(&shader->PendingLinks) == 0;
+      return;
+   }
+
+   util_queue_fence_wait(&shader->CompileFence);
+   wait_shader_links(ctx, shader);
+
    switch (pname) {
    case GL_SHADER_TYPE:
       *params = shader->Type;
@@ -805,6 +853,7 @@ get_shader_info_log(struct gl_context *ctx, GLuint shader, GLsizei bufSize,
       return;
    }
 
+   wait_shader_links(ctx, sh);
    _mesa_copy_string(infoLog, bufSize, length, sh->InfoLog);
 }
 
@@ -844,6 +893,9 @@ shader_source(struct gl_context *ctx, GLuint shader, const GLchar *source)
    if (!sh)
       return;
 
+   /* Links that were started before must see the shader as it was. */
+   wait_shader_links(ctx, sh);
+
    /* free old shader source string and install new one */
    free((void *)sh->Source);
    sh->Source = source;
@@ -854,6 +906,88 @@ shader_source(struct gl_context *ctx, GLuint shader, const GLchar *source)
 }
 
 
+/**
+ * Number of threads compiling and linking shaders in the background:
+ * $MESA_GLSL_COMPILER_THREADS if set, otherwise one per CPU, or none on a
+ * single CPU.
+ */
+static unsigned
+shader_compiler_threads(struct gl_context *ctx)
+{
+   const char *env = getenv("MESA_GLSL_COMPILER_THREADS");
+   long n = 1;
+
+   if (env) {
+      n = strtol(env, NULL, 10);
+   } else {
+#ifdef _SC_NPROCESSORS_ONLN
+      n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+      if (n < 2)
+         n = 0;
+   }
+
+   if (n <= 0)
+      return 0;
+
+   return MIN2((unsigned long) n, ctx->Hint.MaxShaderCompilerThreads);
+}
+
+
+/**
+ * Return the queue on which \c ctx may compile and link shaders, or NULL if
+ * they have to be compiled and linked right away, as they do when the output
+ * of the compiler is logged or debug messages must be synchronous.
+ */
+static struct util_queue *
+get_shader_compiler_queue(struct gl_context *ctx)
+{
+   struct gl_shared_state *shared = ctx->Shared;
+   const GLbitfield sync_flags =
+      GLSL_DUMP | GLSL_LOG | GLSL_REPORT_ERRORS | GLSL_DUMP_ON_ERROR;
+   struct util_queue *queue;
+
+   if (ctx->Hint.MaxShaderCompilerThreads == 0 ||
+       (ctx->_Shader->Flags & sync_flags) ||
+       _mesa_get_debug_state_int(ctx, GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB))
+      return NULL;
+
+   mtx_lock(&shared->Mutex);
+   if (!shared->ShaderCompilerQueue) {
+      const unsigned num_threads = shader_compiler_threads(ctx);
+
+      if (num_threads > 0) {
+         queue = malloc(sizeof(*queue));
+         if (queue && util_queue_init(queue, num_threads))
+            shared->ShaderCompilerQueue = queue;
+         else
+            free(queue);
+      }
+   }
+   queue = shared->ShaderCompilerQueue;
+   mtx_unlock(&shared->Mutex);
+
+   return queue;
+}
+
+
+struct compile_shader_job {
+   struct gl_context *ctx;
+   struct gl_shader *sh;
+   GLbitfield flags; /**< ctx->_Shader->Flags when the compile was queued */
+};
+
+static void
+compile_shader_job(void *data)
+{
+   struct compile_shader_job *job = data;
+
+   _mesa_glsl_compile_shader(job->ctx, job->sh, false, false, false,
+                             job->flags);
+   free(job);
+}
+
+
 /**
  * Compile a shader.
  */
@@ -861,16 +995,33 @@ static void
 compile_shader(struct gl_context *ctx, GLuint shaderObj)
 {
    struct gl_shader *sh;
+   struct util_queue *queue;
 
    sh = _mesa_lookup_shader_err(ctx, shaderObj, "glCompileShader");
    if (!sh)
       return;
 
+   /* Links that were started before must see the shader as it was. */
+   wait_shader_links(ctx, sh);
+
    if (!sh->Source) {
       /* If the user called glCompileShader without first calling
        * glShaderSource, we should fail to compile, but not raise a GL_ERROR.
        */
       sh->CompileStatus = GL_FALSE;
+   } else if ((queue = get_shader_compiler_queue(ctx))) {
+      struct compile_shader_job *job = malloc(sizeof(*job));
+
+      if (!job) {
+         _mesa_error(ctx, GL_OUT_OF_MEMORY, "glCompileShader");
+         return;
+      }
+
+      job->ctx = ctx;
+      job->sh = sh;
+      job->flags = ctx->_Shader->Flags;
+      util_queue_add_job(queue, job, &sh->CompileFence, compile_shader_job);
+      return;
    } else {
       if (ctx->_Shader->Flags & GLSL_DUMP) {
          _mesa_log("GLSL source for %s shader %d:\n",
@@ -881,7 +1032,8 @@ compile_shader(struct gl_context *ctx, GLuint shaderObj)
       /* this call will set the shader->CompileStatus field to indicate if
        * compilation was successful.
        */
-      _mesa_glsl_compile_shader(ctx, sh, false, false);
+      _mesa_glsl_compile_shader(ctx, sh, false, false, false,
+                                ctx->_Shader->Flags);
 
       if (ctx->_Shader->Flags & GLSL_LOG) {
          _mesa_write_shader_to_file(sh);
@@ -918,6 +1070,55 @@ compile_shader(struct gl_context *ctx, GLuint shaderObj)
 }
 
 
+struct link_program_job {
+   struct gl_context *ctx;
+   struct gl_shader_program *prog;
+   GLbitfield flags; /**< ctx->_Shader->Flags when the link was queued */
+   unsigned num_shaders;
+   struct gl_shader **shaders; /**< the attached shaders, sorted */
+};
+
+static int
+compare_shaders(const void *a, const void *b)
+{
+   const struct gl_shader *sh_a = *(const struct gl_shader **) a;
+   const struct gl_shader *sh_b = *(const struct gl_shader **) b;
+
+   return sh_a < sh_b ? -1 : sh_a > sh_b;
+}
+
+/**
+ * Run the GLSL linker on \c prog, once its shaders are compiled.
+ */
+static void
+link_program_job(void *data)
+{
+   struct link_program_job *job = data;
+   unsigned i;
+
+   /* The compiles were queued before the link, so waiting for them can't
+    * deadlock the queue.
+    */
+   for (i = 0; i < job->num_shaders; i++)
+      util_queue_fence_wait(&job->shaders[i]->CompileFence);
+
+   /* Linking may update and recompile the shaders, so lock them, in
+    * address order, against the links of other programs using them.
+    */
+   for (i = 0; i < job->num_shaders; i++)
+      mtx_lock(&job->shaders[i]->Mutex);
+
+   _mesa_glsl_run_linker(job->ctx, job->prog, job->flags);
+
+   for (i = 0; i < job->num_shaders; i++) {
+      mtx_unlock(&job->shaders[i]->Mutex);
+      p_atomic_dec(&job->shaders[i]->PendingLinks);
+   }
+
+   free(job);
+}
+
+
 /**
  * Link a program's shaders.
  */
@@ -925,6 +1126,9 @@ static void
 link_program(struct gl_context *ctx, GLuint program)
 {
    struct gl_shader_program *shProg;
+   struct link_program_job *job;
+   struct util_queue *queue;
+   unsigned i;
 
    shProg = _mesa_lookup_shader_program_err(ctx, program, "glLinkProgram");
    if (!shProg)
@@ -943,7 +1147,40 @@ link_program(struct gl_context *ctx, GLuint program)
 
    FLUSH_VERTICES(ctx, _NEW_PROGRAM);
 
-   _mesa_glsl_link_shader(ctx, shProg);
+   job = malloc(sizeof(*job) + shProg->NumShaders * sizeof(*job->shaders));
+   if (!job) {
+      _mesa_error(ctx, GL_OUT_OF_MEMORY, "glLinkProgram");
+      return;
+   }
+
+   job->ctx = ctx;
+   job->prog = shProg;
+   job->flags = ctx->_Shader->Flags;
+   job->num_shaders = shProg->NumShaders;
+   job->shaders = (struct gl_shader **) (job + 1);
+   memcpy(job->shaders, shProg->Shaders,
+          shProg->NumShaders * sizeof(*job->shaders));
+   qsort(job->shaders, job->num_shaders, sizeof(*job->shaders),
+         compare_shaders);
+
+   for (i = 0; i < job->num_shaders; i++)
+      p_atomic_inc(&job->shaders[i]->PendingLinks);
+
+   _mesa_glsl_prepare_link(ctx, shProg);
+
+   /* A program that is bound somewhere must be relinked right away, since
+    * it may be used for drawing.  Otherwise the link is waited for by the
+    * first use of the program, see _mesa_wait_shader_program().
+    */
+   queue = shProg->RefCount == 1 ? get_shader_compiler_queue(ctx) : NULL;
+   if (queue) {
+      shProg->LinkPending = true;
+      util_queue_add_job(queue, job, &shProg->LinkFence, link_program_job);
+      return;
+   }
+
+   link_program_job(job);
+   _mesa_glsl_finish_link(ctx, shProg);
 
    if (shProg->LinkStatus == GL_FALSE &&
        (ctx->_Shader->Flags & GLSL_REPORT_ERRORS)) {
@@ -1552,6 +1789,45 @@ _mesa_ShaderSource(GLhandleARB shaderObj, GLsizei count,
 }
 
 
+/**
+ * Make shProg current for all stages, or unbind the current program if shProg
+ * is NULL.  Error checking has been done by the caller.
+ */
+static void
+use_program(struct gl_context *ctx, struct gl_shader_program *shProg)
+{
+   /* debug code */
+   if (shProg && (ctx->_Shader->Flags & GLSL_USE_PROG)) {
+      print_shader_info(shProg);
+   }
+
+   /* The ARB_separate_shader_object spec says:
+    *
+    *     "The executable code for an individual shader stage is taken from
+    *     the current program for that stage.  If there is a current program
+    *     object established by UseProgram, that program is considered current
+    *     for all stages.  Otherwise, if there is a bound program pipeline
+    *     object (section 2.14.PPO), the program bound to the appropriate
+    *     stage of the pipeline object is considered current."
+    */
+   if (shProg) {
+      /* Attach shader state to the binding point */
+      _mesa_reference_pipeline_object(ctx, &ctx->_Shader, &ctx->Shader);
+      /* Update the program */
+      _mesa_use_program(ctx, shProg);
+   } else {
+      /* Must be done first: detach the progam */
+      _mesa_use_program(ctx, shProg);
+      /* Unattach shader_state binding point */
+      _mesa_reference_pipeline_object(ctx, &ctx->_Shader, ctx->Pipeline.Default);
+      /* If a pipeline was bound, rebind it */
+      if (ctx->Pipeline.Current) {
+         _mesa_BindProgramPipeline(ctx->Pipeline.Current->Name);
+      }
+   }
+}
+
+
 void GLAPIENTRY
 _mesa_UseProgram(GLhandleARB program)
 {
@@ -1574,40 +1850,24 @@ _mesa_UseProgram(GLhandleARB program)
                      "glUseProgram(program %u not linked)", program);
          return;
       }
-
-      /* debug code */
-      if (ctx->_Shader->Flags & GLSL_USE_PROG) {
-         print_shader_info(shProg);
-      }
    }
    else {
       shProg = NULL;
    }
 
-   /* The ARB_separate_shader_object spec says:
-    *
-    *     "The executable code for an individual shader stage is taken from
-    *     the current program for that stage.  If there is a current program
-    *     object established by UseProgram, that program is considered current
-    *     for all stages.  Otherwise, if there is a bound program pipeline
-    *     object (section 2.14.PPO), the program bound to the appropriate
-    *     stage of the pipeline object is considered current."
-    */
-   if (program) {
-      /* Attach shader state to the binding point */
-      _mesa_reference_pipeline_object(ctx, &ctx->_Shader, &ctx->Shader);
-      /* Update the program */
-      _mesa_use_program(ctx, shProg);
-   } else {
-      /* Must be done first: detach the progam */
-      _mesa_use_program(ctx, shProg);
-      /* Unattach shader_state binding point */
-      _mesa_reference_pipeline_object(ctx, &ctx->_Shader, ctx->Pipeline.Default);
-      /* If a pipeline was bound, rebind it */
-      if (ctx->Pipeline.Current) {
-         _mesa_BindProgramPipeline(ctx->Pipeline.Current->Name);
-      }
-   }
+   use_program(ctx, shProg);
+}
+
+
+/**
+ * glUseProgram() for contexts created with GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR.
+ */
+void GLAPIENTRY
+_mesa_UseProgram_no_error(GLhandleARB program)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   use_program(ctx, _mesa_lookup_shader_program(ctx, program));
 }
 
 
@@ -1743,12 +2003,32 @@ _mesa_GetProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length,
       return;
    }
 
-   *length = 0;
-   _mesa_error(ctx, GL_INVALID_OPERATION,
-               "glGetProgramBinary(driver supports zero binary formats)");
+   /* Serializing every program at link time would cost every application,
+    * so only programs linked with PROGRAM_BINARY_RETRIEVABLE_HINT, or loaded
+    * from a binary, have one.  The others return an empty binary, which
+    * glProgramBinary rejects, as it may reject any binary.
+    */
+   if (shProg->Binary == NULL) {
+      *length = 0;
+      *binaryFormat = GL_PROGRAM_BINARY_FORMAT_MESA;
+      return;
+   }
 
-   (void) binaryFormat;
-   (void) binary;
+   /* The ARB_get_program_binary spec says:
+    *
+    *     "If <bufSize> is less than the number of bytes in the binary, then
+    *     an INVALID_OPERATION error is thrown."
+    */
+   if (bufSize < shProg->BinaryLength) {
+      _mesa_error(ctx, GL_INVALID_OPERATION,
+                  "glGetProgramBinary(bufSize too small)");
+      *length = 0;
+      return;
+   }
+
+   memcpy(binary, shProg->Binary, shProg->BinaryLength);
+   *length = shProg->BinaryLength;
+   *binaryFormat = GL_PROGRAM_BINARY_FORMAT_MESA;
 }
 
 void GLAPIENTRY
@@ -1762,9 +2042,6 @@ _mesa_ProgramBinary(GLuint program, GLenum binaryFormat,
    if (!shProg)
       return;
 
-   (void) binaryFormat;
-   (void) binary;
-
    /* Section 2.3.1 (Errors) of the OpenGL 4.5 spec says:
     *
     *     "If a negative number is provided where an argument of type sizei or
@@ -1784,11 +2061,39 @@ _mesa_ProgramBinary(GLuint program, GLenum binaryFormat,
     *     setting the LINK_STATUS of <program> to FALSE, if these conditions
     *     are not met."
     *
-    * Since any value of binaryFormat passed "is not one of those specified as
-    * allowable for [this] command, an INVALID_ENUM error is generated."
+    * Since any other value of binaryFormat passed "is not one of those
+    * specified as allowable for [this] command, an INVALID_ENUM error is
+    * generated."
+    */
+   if (binaryFormat != GL_PROGRAM_BINARY_FORMAT_MESA) {
+      shProg->LinkStatus = GL_FALSE;
+      _mesa_error(ctx, GL_INVALID_ENUM, "glProgramBinary");
+      return;
+   }
+
+   /* Section 13.2.2 (Transform Feedback Primitive Capture) of the OpenGL 4.5
+    * spec says:
+    *
+    *     "An INVALID_OPERATION error is generated by LinkProgram or
+    *     ProgramBinary if program is the name of a program being used by one
+    *     or more transform feedback objects, even if the objects are not
+    *     currently bound or are paused."
     */
-   shProg->LinkStatus = GL_FALSE;
-   _mesa_error(ctx, GL_INVALID_ENUM, "glProgramBinary");
+   if (_mesa_transform_feedback_is_using_program(ctx, shProg)) {
+      _mesa_error(ctx, GL_INVALID_OPERATION,
+                  "glProgramBinary(transform feedback is using the program)");
+      return;
+   }
+
+   FLUSH_VERTICES(ctx, _NEW_PROGRAM);
+
+   _mesa_glsl_program_binary(ctx, shProg, binary, length);
+
+   if (shProg->LinkStatus == GL_FALSE &&
+       (ctx->_Shader->Flags & GLSL_REPORT_ERRORS)) {
+      _mesa_debug(ctx, "Error loading binary of program %u:\n%s\n",
+                  shProg->Name, shProg->InfoLog);
+   }
 }
 
 
@@ -1870,6 +2175,20 @@ invalid_value:
 }
 
 
+/**
+ * GL_ARB_parallel_shader_compile.  Zero makes compiles and links of the
+ * context synchronous.  Other values only bound the number of threads of
+ * the share group's queue if it doesn't exist yet.
+ */
+void GLAPIENTRY
+_mesa_MaxShaderCompilerThreadsARB(GLuint count)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   ctx->Hint.MaxShaderCompilerThreads = count;
+}
+
+
 void
 _mesa_use_shader_program(struct gl_context *ctx, GLenum type,
                          struct gl_shader_program *shProg,
@@ -117,6 +117,9 @@ _mesa_ShaderSource(GLhandleARB, GLsizei, const GLcharARB* const *, const GLint *
 extern void GLAPIENTRY
 _mesa_UseProgram(GLhandleARB);
 
+extern void GLAPIENTRY
+_mesa_UseProgram_no_error(GLhandleARB);
+
 extern void GLAPIENTRY
 _mesa_ValidateProgram(GLhandleARB);
 
@@ -200,6 +203,9 @@ _mesa_ProgramBinary(GLuint program, GLenum binaryFormat,
 extern void GLAPIENTRY
 _mesa_ProgramParameteri(GLuint program, GLenum pname, GLint value);
 
+extern void GLAPIENTRY
+_mesa_MaxShaderCompilerThreadsARB(GLuint count);
+
 void
 _mesa_use_shader_program(struct gl_context *ctx, GLenum type,
                          struct gl_shader_program *shProg,
@@ -96,6 +96,8 @@ void
 _mesa_init_shader(struct gl_context *ctx, struct gl_shader *shader)
 {
    shader->RefCount = 1;
+   util_queue_fence_init(&shader->CompileFence);
+   mtx_init(&shader->Mutex, mtx_plain);
 }
 
 /**
@@ -125,6 +127,9 @@ _mesa_new_shader(struct gl_context *ctx, GLuint name, GLenum type)
 static void
 _mesa_delete_shader(struct gl_context *ctx, struct gl_shader *sh)
 {
+   util_queue_fence_wait(&sh->CompileFence);
+   util_queue_fence_destroy(&sh->CompileFence);
+   mtx_destroy(&sh->Mutex);
    free((void *)sh->Source);
    free(sh->Label);
    _mesa_reference_program(ctx, &sh->Program, NULL);
@@ -133,7 +138,7 @@ _mesa_delete_shader(struct gl_context *ctx, struct gl_shader *sh)
 
 
 /**
- * Lookup a GLSL shader object.
+ * Lookup a GLSL shader object, once it's done compiling.
  */
 struct gl_shader *
 _mesa_lookup_shader(struct gl_context *ctx, GLuint name)
@@ -148,6 +153,8 @@ _mesa_lookup_shader(struct gl_context *ctx, GLuint name)
       if (sh && sh->Type == GL_SHADER_PROGRAM_MESA) {
          return NULL;
       }
+      if (sh)
+         util_queue_fence_wait(&sh->CompileFence);
       return sh;
    }
    return NULL;
@@ -159,6 +166,20 @@ _mesa_lookup_shader(struct gl_context *ctx, GLuint name)
  */
 struct gl_shader *
 _mesa_lookup_shader_err(struct gl_context *ctx, GLuint name, const char *caller)
+{
+   struct gl_shader *sh = _mesa_lookup_shader_err_no_wait(ctx, name, caller);
+   if (sh)
+      util_queue_fence_wait(&sh->CompileFence);
+   return sh;
+}
+
+
+/**
+ * As above, but don't wait for the shader to be compiled.
+ */
+struct gl_shader *
+_mesa_lookup_shader_err_no_wait(struct gl_context *ctx, GLuint name,
+                                const char *caller)
 {
    if (!name) {
       _mesa_error(ctx, GL_INVALID_VALUE, "%s", caller);
@@ -241,6 +262,8 @@ init_shader_program(struct gl_shader_program *prog)
    prog->Type = GL_SHADER_PROGRAM_MESA;
    prog->RefCount = 1;
 
+   util_queue_fence_init(&prog->LinkFence);
+
    prog->AttributeBindings = string_to_uint_map_ctor();
    prog->FragDataBindings = string_to_uint_map_ctor();
    prog->FragDataIndexBindings = string_to_uint_map_ctor();
@@ -316,6 +339,10 @@ _mesa_clear_shader_program_data(struct gl_shader_program *shProg)
    shProg->AtomicBuffers = NULL;
    shProg->NumAtomicBuffers = 0;
 
+   ralloc_free(shProg->Binary);
+   shProg->Binary = NULL;
+   shProg->BinaryLength = 0;
+
    if (shProg->ProgramResourceList) {
       ralloc_free(shProg->ProgramResourceList);
       shProg->ProgramResourceList = NULL;
@@ -391,6 +418,8 @@ _mesa_free_shader_program_data(struct gl_context *ctx,
 static void
 _mesa_delete_shader_program(struct gl_context *ctx, struct gl_shader_program *shProg)
 {
+   util_queue_fence_wait(&shProg->LinkFence);
+   util_queue_fence_destroy(&shProg->LinkFence);
    _mesa_free_shader_program_data(ctx, shProg);
 
    ralloc_free(shProg);
@@ -398,7 +427,30 @@ _mesa_delete_shader_program(struct gl_context *ctx, struct gl_shader_program *sh
 
 
 /**
- * Lookup a GLSL program object.
+ * Wait for the link started by glLinkProgram() on the shader compiler queue,
+ * if any, and let the driver finish it.
+ */
+void
+_mesa_wait_shader_program(struct gl_context *ctx,
+                          struct gl_shader_program *shProg)
+{
+   if (!shProg->LinkPending)
+      return;
+
+   util_queue_fence_wait(&shProg->LinkFence);
+
+   /* Other contexts of the share group may be using the program too. */
+   mtx_lock(&ctx->Shared->Mutex);
+   if (shProg->LinkPending) {
+      _mesa_glsl_finish_link(ctx, shProg);
+      shProg->LinkPending = false;
+   }
+   mtx_unlock(&ctx->Shared->Mutex);
+}
+
+
+/**
+ * Lookup a GLSL program object, once it's done linking.
  */
 struct gl_shader_program *
 _mesa_lookup_shader_program(struct gl_context *ctx, GLuint name)
@@ -414,6 +466,8 @@ _mesa_lookup_shader_program(struct gl_context *ctx, GLuint name)
       if (shProg && shProg->Type != GL_SHADER_PROGRAM_MESA) {
          return NULL;
       }
+      if (shProg)
+         _mesa_wait_shader_program(ctx, shProg);
       return shProg;
    }
    return NULL;
@@ -426,6 +480,21 @@ _mesa_lookup_shader_program(struct gl_context *ctx, GLuint name)
 struct gl_shader_program *
 _mesa_lookup_shader_program_err(struct gl_context *ctx, GLuint name,
                                 const char *caller)
+{
+   struct gl_shader_program *shProg =
+      _mesa_lookup_shader_program_err_no_wait(ctx, name, caller);
+   if (shProg)
+      _mesa_wait_shader_program(ctx, shProg);
+   return shProg;
+}
+
+
+/**
+ * As above, but don't wait for the program to be linked.
+ */
+struct gl_shader_program *
+_mesa_lookup_shader_program_err_no_wait(struct gl_context *ctx, GLuint name,
+                                        const char *caller)
 {
    if (!name) {
       _mesa_error(ctx, GL_INVALID_VALUE, "%s", caller);
@@ -299,6 +299,17 @@ free_shared_state(struct gl_context *ctx, struct gl_shared_state *shared)
          ctx->Driver.DeleteTexture(ctx, shared->FallbackTex[i]);
    }
 
+   /* Let the shader compiler threads finish before freeing the shaders */
+   if (shared->ShaderCompilerQueue) {
+      util_queue_destroy(shared->ShaderCompilerQueue);
+      free(shared->ShaderCompilerQueue);
+   }
+
+   if (shared->TextureCompressQueue) {
+      util_queue_destroy(shared->TextureCompressQueue);
+      free(shared->TextureCompressQueue);
+   }
+
    /*
     * Free display lists
     */
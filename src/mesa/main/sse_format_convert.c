@@ -0,0 +1,373 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "main/sse_format_convert.h"
+#include <smmintrin.h>
+#include <stdint.h>
+
+/* The kernels below cover the conversions that glTexImage and glReadPixels
+ * hit most: RGBA8 <-> BGRA8, RGB8 -> RGBA8, ubyte <-> float and
+ * half <-> float.  Every one of them processes 16 bytes of source or
+ * destination per iteration and leaves the tail to the C code.
+ */
+
+/**
+ * Builds a PSHUFB mask which gathers 16 bytes worth of swizzled 4-channel
+ * pixels out of pixels with \p num_src_channels channels of \p size bytes,
+ * and the constant to OR into the shuffled result for the ZERO and ONE
+ * channels, where \p one is the bit pattern of 1 in the channel type.
+ */
+static void
+build_swizzle_mask(const uint8_t swizzle[4], int num_src_channels, int size,
+                   uint32_t one, __m128i *mask, __m128i *constant)
+{
+   const int num_pixels = 16 / (4 * size);
+   uint8_t m[16], c[16];
+   int p, i, b;
+
+   for (p = 0; p < num_pixels; p++) {
+      for (i = 0; i < 4; i++) {
+         for (b = 0; b < size; b++) {
+            const int byte = (p * 4 + i) * size + b;
+
+            if (swizzle[i] <= MESA_FORMAT_SWIZZLE_W) {
+               m[byte] = (p * num_src_channels + swizzle[i]) * size + b;
+               c[byte] = 0;
+            } else {
+               m[byte] = 0x80;
+               c[byte] = swizzle[i] == MESA_FORMAT_SWIZZLE_ONE ?
+                         (one >> (8 * b)) & 0xff : 0;
+            }
+         }
+      }
+   }
+
+   *mask = _mm_loadu_si128((const __m128i *) m);
+   *constant = _mm_loadu_si128((const __m128i *) c);
+}
+
+/* Number of source pixels a 16 byte load of ubyte pixels spans.  Only
+ * the first 4 are converted, but with 3 channels the load reads into the
+ * 6th.
+ */
+static inline int
+pixels_per_load(int num_src_channels)
+{
+   return (16 + num_src_channels - 1) / num_src_channels;
+}
+
+static bool
+swizzle_is_identity(const uint8_t swizzle[4], int num_channels)
+{
+   int i;
+
+   for (i = 0; i < num_channels; i++) {
+      if (swizzle[i] != i)
+         return false;
+   }
+
+   return true;
+}
+
+/* Same as _mesa_half_to_float(), on four halves zero-extended to 32 bits. */
+static inline __m128
+half4_to_float(__m128i h)
+{
+   const __m128i sign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)),
+                                       16);
+   const __m128i em = _mm_and_si128(h, _mm_set1_epi32(0x7fff));
+
+   /* Normal numbers only need the exponent rebiased, denormals are
+    * mantissa * 2^-24, and all NaNs get a mantissa of 1.
+    */
+   const __m128i normal = _mm_add_epi32(_mm_slli_epi32(em, 13),
+                                        _mm_set1_epi32(112 << 23));
+   const __m128i denorm =
+      _mm_castps_si128(_mm_mul_ps(_mm_cvtepi32_ps(em),
+                                  _mm_set1_ps(1.0f / (1 << 24))));
+   const __m128i is_nan = _mm_cmpgt_epi32(em, _mm_set1_epi32(0x7c00));
+   const __m128i infnan = _mm_or_si128(_mm_set1_epi32(0x7f800000),
+                                       _mm_srli_epi32(is_nan, 31));
+
+   __m128i f;
+
+   f = _mm_blendv_epi8(normal, denorm,
+                       _mm_cmplt_epi32(em, _mm_set1_epi32(0x0400)));
+   f = _mm_blendv_epi8(f, infnan,
+                       _mm_cmpgt_epi32(em, _mm_set1_epi32(0x7bff)));
+
+   return _mm_castsi128_ps(_mm_or_si128(f, sign));
+}
+
+/* Same as _mesa_float_to_half(), returning the halves zero-extended to
+ * 32 bits.
+ */
+static inline __m128i
+float4_to_half(__m128 f)
+{
+   const __m128i bits = _mm_castps_si128(f);
+   const __m128i sign = _mm_and_si128(_mm_srli_epi32(bits, 16),
+                                      _mm_set1_epi32(0x8000));
+   const __m128i abs = _mm_and_si128(bits, _mm_set1_epi32(0x7fffffff));
+   const __m128i e = _mm_srli_epi32(abs, 23);
+   const __m128i m = _mm_and_si128(abs, _mm_set1_epi32(0x7fffff));
+
+   /* The rounded mantissa can carry into the exponent, which is exactly
+    * what the C code's explicit carry does.
+    */
+   const __m128i normal =
+      _mm_add_epi32(_mm_slli_epi32(_mm_sub_epi32(e, _mm_set1_epi32(112)), 10),
+                    _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(m),
+                                               _mm_set1_ps(1.0f / 8192))));
+   const __m128i denorm =
+      _mm_cvtps_epi32(_mm_mul_ps(_mm_castsi128_ps(abs),
+                                 _mm_set1_ps((float) (1 << 24))));
+
+   __m128i h;
+
+   h = _mm_blendv_epi8(normal, denorm,
+                       _mm_cmplt_epi32(e, _mm_set1_epi32(113)));
+   h = _mm_blendv_epi8(h, _mm_set1_epi32(0x7c00),
+                       _mm_cmpgt_epi32(e, _mm_set1_epi32(142)));
+   h = _mm_blendv_epi8(h, _mm_set1_epi32(0x7c01),
+                       _mm_cmpgt_epi32(abs, _mm_set1_epi32(0x7f800000)));
+
+   return _mm_or_si128(h, sign);
+}
+
+/* RGBA8 <-> BGRA8, RGB8 -> RGBA8 and the like, which is a single PSHUFB. */
+static int
+convert_ubyte_to_ubyte(uint8_t *dst, const uint8_t *src, int num_src_channels,
+                       const uint8_t swizzle[4], bool normalized, int count)
+{
+   __m128i mask, constant;
+   int i;
+
+   build_swizzle_mask(swizzle, num_src_channels, 1, normalized ? 0xff : 1,
+                      &mask, &constant);
+
+   for (i = 0; i + pixels_per_load(num_src_channels) <= count; i += 4) {
+      __m128i v = _mm_loadu_si128((const __m128i *) (src + i * num_src_channels));
+
+      v = _mm_or_si128(_mm_shuffle_epi8(v, mask), constant);
+      _mm_storeu_si128((__m128i *) (dst + i * 4), v);
+   }
+
+   return i;
+}
+
+static int
+convert_ubyte_to_float(float *dst, const uint8_t *src, int num_src_channels,
+                       const uint8_t swizzle[4], bool normalized, int count)
+{
+   const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+   __m128i mask[4], unused, constant;
+   int i, p, c;
+
+   for (p = 0; p < 4; p++) {
+      uint8_t m[16];
+
+      for (c = 0; c < 4; c++) {
+         m[c * 4 + 0] = swizzle[c] <= MESA_FORMAT_SWIZZLE_W ?
+                        p * num_src_channels + swizzle[c] : 0x80;
+         m[c * 4 + 1] = 0x80;
+         m[c * 4 + 2] = 0x80;
+         m[c * 4 + 3] = 0x80;
+      }
+      mask[p] = _mm_loadu_si128((const __m128i *) m);
+   }
+   build_swizzle_mask(swizzle, 4, 4, 0x3f800000, &unused, &constant);
+
+   for (i = 0; i + pixels_per_load(num_src_channels) <= count; i += 4) {
+      const __m128i v =
+         _mm_loadu_si128((const __m128i *) (src + i * num_src_channels));
+
+      for (p = 0; p < 4; p++) {
+         __m128 f = _mm_cvtepi32_ps(_mm_shuffle_epi8(v, mask[p]));
+
+         if (normalized)
+            f = _mm_mul_ps(f, scale);
+         f = _mm_or_ps(f, _mm_castsi128_ps(constant));
+         _mm_storeu_ps(dst + (i + p) * 4, f);
+      }
+   }
+
+   return i;
+}
+
+/* Normalized float -> ubyte, i.e. _mesa_float_to_unorm(x, 8).  Clamping
+ * NaN to 0 with MAXPS matches the C code, which converts NaN to 0x80000000
+ * and truncates that to 0.
+ */
+static int
+convert_float_to_unorm8(uint8_t *dst, const float *src,
+                        const uint8_t swizzle[4], int count)
+{
+   const __m128 zero = _mm_setzero_ps();
+   const __m128 one = _mm_set1_ps(1.0f);
+   const __m128 scale = _mm_set1_ps(255.0f);
+   __m128i mask, constant, v[4];
+   int i, p;
+
+   build_swizzle_mask(swizzle, 4, 1, 0xff, &mask, &constant);
+
+   for (i = 0; i + 4 <= count; i += 4) {
+      __m128i b;
+
+      for (p = 0; p < 4; p++) {
+         __m128 f = _mm_loadu_ps(src + (i + p) * 4);
+
+         f = _mm_min_ps(_mm_max_ps(f, zero), one);
+         v[p] = _mm_cvtps_epi32(_mm_mul_ps(f, scale));
+      }
+
+      b = _mm_packus_epi16(_mm_packus_epi32(v[0], v[1]),
+                           _mm_packus_epi32(v[2], v[3]));
+      b = _mm_or_si128(_mm_shuffle_epi8(b, mask), constant);
+      _mm_storeu_si128((__m128i *) (dst + i * 4), b);
+   }
+
+   return i;
+}
+
+/* half <-> float with either the same number of channels on both sides and
+ * no swizzle, which is converted as a flat array, or 4 channels on both
+ * sides and any swizzle, which is applied to the converted values.
+ */
+static int
+convert_half_to_float(float *dst, const uint16_t *src, int num_channels,
+                      const uint8_t swizzle[4], int count)
+{
+   const bool flat = swizzle_is_identity(swizzle, num_channels);
+   const int num_values = count * num_channels;
+   __m128i mask, constant;
+   int i;
+
+   build_swizzle_mask(swizzle, 4, 4, 0x3f800000, &mask, &constant);
+
+   /* 4-channel pixels end on 8 value boundaries, so the flat loop never
+    * leaves a pixel half-converted for them.
+    */
+   for (i = 0; i + 8 <= num_values; i += 8) {
+      const __m128i h = _mm_loadu_si128((const __m128i *) (src + i));
+      __m128 lo = half4_to_float(_mm_cvtepu16_epi32(h));
+      __m128 hi = half4_to_float(_mm_cvtepu16_epi32(_mm_srli_si128(h, 8)));
+
+      if (!flat) {
+         lo = _mm_castsi128_ps(_mm_or_si128(
+                 _mm_shuffle_epi8(_mm_castps_si128(lo), mask), constant));
+         hi = _mm_castsi128_ps(_mm_or_si128(
+                 _mm_shuffle_epi8(_mm_castps_si128(hi), mask), constant));
+      }
+
+      _mm_storeu_ps(dst + i, lo);
+      _mm_storeu_ps(dst + i + 4, hi);
+   }
+
+   return i / num_channels;
+}
+
+static int
+convert_float_to_half(uint16_t *dst, const float *src, int num_channels,
+                      const uint8_t swizzle[4], int count)
+{
+   const bool flat = swizzle_is_identity(swizzle, num_channels);
+   const int num_values = count * num_channels;
+   __m128i mask, constant;
+   int i;
+
+   build_swizzle_mask(swizzle, 4, 2, 0x3c00, &mask, &constant);
+
+   for (i = 0; i + 8 <= num_values; i += 8) {
+      __m128i h = _mm_packus_epi32(float4_to_half(_mm_loadu_ps(src + i)),
+                                   float4_to_half(_mm_loadu_ps(src + i + 4)));
+
+      if (!flat)
+         h = _mm_or_si128(_mm_shuffle_epi8(h, mask), constant);
+
+      _mm_storeu_si128((__m128i *) (dst + i), h);
+   }
+
+   return i / num_channels;
+}
+
+int
+_mesa_swizzle_and_convert_sse41(void *dst,
+                                enum mesa_array_format_datatype dst_type,
+                                int num_dst_channels,
+                                const void *src,
+                                enum mesa_array_format_datatype src_type,
+                                int num_src_channels,
+                                const uint8_t swizzle[4], bool normalized,
+                                int count)
+{
+   int i;
+
+   /* NONE leaves the destination channel alone, which would take a
+    * read-modify-write, and swizzling from a channel the source doesn't have
+    * is undefined.
+    */
+   for (i = 0; i < num_dst_channels; i++) {
+      if (swizzle[i] == MESA_FORMAT_SWIZZLE_NONE ||
+          (swizzle[i] <= MESA_FORMAT_SWIZZLE_W &&
+           swizzle[i] >= num_src_channels))
+         return 0;
+   }
+
+   switch (src_type) {
+   case MESA_ARRAY_FORMAT_TYPE_UBYTE:
+      if (num_dst_channels != 4 || num_src_channels < 3)
+         return 0;
+      if (dst_type == MESA_ARRAY_FORMAT_TYPE_UBYTE)
+         return convert_ubyte_to_ubyte(dst, src, num_src_channels, swizzle,
+                                       normalized, count);
+      if (dst_type == MESA_ARRAY_FORMAT_TYPE_FLOAT)
+         return convert_ubyte_to_float(dst, src, num_src_channels, swizzle,
+                                       normalized, count);
+      return 0;
+
+   case MESA_ARRAY_FORMAT_TYPE_FLOAT:
+      if (dst_type == MESA_ARRAY_FORMAT_TYPE_UBYTE && normalized &&
+          num_src_channels == 4 && num_dst_channels == 4)
+         return convert_float_to_unorm8(dst, src, swizzle, count);
+      if (dst_type == MESA_ARRAY_FORMAT_TYPE_HALF &&
+          num_src_channels == num_dst_channels &&
+          (num_src_channels == 4 ||
+           swizzle_is_identity(swizzle, num_src_channels)))
+         return convert_float_to_half(dst, src, num_src_channels, swizzle,
+                                      count);
+      return 0;
+
+   case MESA_ARRAY_FORMAT_TYPE_HALF:
+      if (dst_type == MESA_ARRAY_FORMAT_TYPE_FLOAT &&
+          num_src_channels == num_dst_channels &&
+          (num_src_channels == 4 ||
+           swizzle_is_identity(swizzle, num_src_channels)))
+         return convert_half_to_float(dst, src, num_src_channels, swizzle,
+                                      count);
+      return 0;
+
+   default:
+      return 0;
+   }
+}
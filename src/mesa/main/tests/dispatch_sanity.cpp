@@ -37,6 +37,10 @@
  *
  * When adding extensions that add new functions, this test will need to be
  * modified to expect dispatch functions for the new extension functions.
+ *
+ * Contexts created with GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR must expose the same
+ * set of functions, but some of them are set to variants without error
+ * checking.  This is verified as well.
  */
 
 #include <gtest/gtest.h>
@@ -56,6 +60,14 @@
 #include "tnl/tnl.h"
 #include "swrast_setup/swrast_setup.h"
 
+extern "C" {
+#include "main/bufferobj.h"
+#include "main/shaderapi.h"
+#include "main/teximage.h"
+#include "main/texobj.h"
+#include "main/varray.h"
+}
+
 #ifndef GLAPIENTRYP
 #define GLAPIENTRYP GL_APIENTRYP
 #endif
@@ -79,7 +91,8 @@ extern const struct function gles31_functions_possible[];
 class DispatchSanity_test : public ::testing::Test {
 public:
    virtual void SetUp();
-   void SetUpCtx(gl_api api, unsigned int version);
+   void SetUpCtx(gl_api api, unsigned int version,
+                 GLbitfield context_flags = 0);
 
    struct gl_config visual;
    struct dd_function_table driver_functions;
@@ -103,7 +116,8 @@ DispatchSanity_test::SetUp()
 }
 
 void
-DispatchSanity_test::SetUpCtx(gl_api api, unsigned int version)
+DispatchSanity_test::SetUpCtx(gl_api api, unsigned int version,
+                              GLbitfield context_flags)
 {
    _mesa_initialize_context(&ctx,
                             api,
@@ -113,6 +127,7 @@ DispatchSanity_test::SetUpCtx(gl_api api, unsigned int version)
    _vbo_CreateContext(&ctx);
 
    ctx.Version = version;
+   ctx.Const.ContextFlags |= context_flags;
 
    _mesa_initialize_dispatch_tables(&ctx);
    _mesa_initialize_vbo_vtxfmt(&ctx);
@@ -175,9 +190,68 @@ validate_nops(struct gl_context *ctx, const _glapi_proc *nop_table)
    }
 }
 
+/* Functions that have a variant without error checking, with that variant.
+ */
+static const struct {
+   const char *name;
+   _glapi_proc no_error_func;
+} no_error_functions[] = {
+   { "glBindBuffer", (_glapi_proc) _mesa_BindBuffer_no_error },
+   { "glBindTexture", (_glapi_proc) _mesa_BindTexture_no_error },
+   { "glBufferSubData", (_glapi_proc) _mesa_BufferSubData_no_error },
+   { "glDisableVertexAttribArray", (_glapi_proc) _mesa_DisableVertexAttribArray_no_error },
+   { "glDrawArrays", (_glapi_proc) vbo_exec_DrawArrays_no_error },
+   { "glDrawArraysInstanced", (_glapi_proc) vbo_exec_DrawArraysInstanced_no_error },
+   { "glDrawElements", (_glapi_proc) vbo_exec_DrawElements_no_error },
+   { "glDrawElementsBaseVertex", (_glapi_proc) vbo_exec_DrawElementsBaseVertex_no_error },
+   { "glDrawElementsInstanced", (_glapi_proc) vbo_exec_DrawElementsInstanced_no_error },
+   { "glDrawRangeElements", (_glapi_proc) vbo_exec_DrawRangeElements_no_error },
+   { "glDrawRangeElementsBaseVertex", (_glapi_proc) vbo_exec_DrawRangeElementsBaseVertex_no_error },
+   { "glEnableVertexAttribArray", (_glapi_proc) _mesa_EnableVertexAttribArray_no_error },
+   { "glTexSubImage1D", (_glapi_proc) _mesa_TexSubImage1D_no_error },
+   { "glTexSubImage2D", (_glapi_proc) _mesa_TexSubImage2D_no_error },
+   { "glTexSubImage3D", (_glapi_proc) _mesa_TexSubImage3D_no_error },
+   { "glUseProgram", (_glapi_proc) _mesa_UseProgram_no_error },
+   { "glVertexAttribPointer", (_glapi_proc) _mesa_VertexAttribPointer_no_error },
+   { NULL, NULL }
+};
+
+/* Check that the functions available in the context are set to their
+ * no-error variants if, and only if, the context was created with
+ * GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR.  This must run before
+ * validate_functions(), which replaces the functions it finds with nops.
+ */
+static void
+validate_no_error_functions(struct gl_context *ctx,
+                            const _glapi_proc *nop_table)
+{
+   const _glapi_proc *table = (_glapi_proc *) ctx->Exec;
+   const bool no_error = _mesa_is_no_error_enabled(ctx);
+
+   for (unsigned i = 0; no_error_functions[i].name != NULL; i++) {
+      const int offset = _glapi_get_proc_offset(no_error_functions[i].name);
+
+      ASSERT_NE(-1, offset)
+         << "Function: " << no_error_functions[i].name;
+
+      /* Not part of this API; validate_nops() catches it otherwise. */
+      if (table[offset] == nop_table[offset])
+         continue;
+
+      if (no_error) {
+         EXPECT_EQ(no_error_functions[i].no_error_func, table[offset])
+            << "Function: " << no_error_functions[i].name;
+      } else {
+         EXPECT_NE(no_error_functions[i].no_error_func, table[offset])
+            << "Function: " << no_error_functions[i].name;
+      }
+   }
+}
+
 TEST_F(DispatchSanity_test, GL31_CORE)
 {
    SetUpCtx(API_OPENGL_CORE, 31);
+   validate_no_error_functions(&ctx, nop_table);
    validate_functions(&ctx, common_desktop_functions_possible, nop_table);
    validate_functions(&ctx, gl_core_functions_possible, nop_table);
    validate_nops(&ctx, nop_table);
@@ -186,6 +260,7 @@ TEST_F(DispatchSanity_test, GL31_CORE)
 TEST_F(DispatchSanity_test, GL30)
 {
    SetUpCtx(API_OPENGL_COMPAT, 30);
+   validate_no_error_functions(&ctx, nop_table);
    validate_functions(&ctx, common_desktop_functions_possible, nop_table);
    validate_functions(&ctx, gl_compatibility_functions_possible, nop_table);
    validate_nops(&ctx, nop_table);
@@ -194,6 +269,7 @@ TEST_F(DispatchSanity_test, GL30)
 TEST_F(DispatchSanity_test, GLES11)
 {
    SetUpCtx(API_OPENGLES, 11);
+   validate_no_error_functions(&ctx, nop_table);
    validate_functions(&ctx, gles11_functions_possible, nop_table);
    validate_nops(&ctx, nop_table);
 }
@@ -201,6 +277,7 @@ TEST_F(DispatchSanity_test, GLES11)
 TEST_F(DispatchSanity_test, GLES2)
 {
    SetUpCtx(API_OPENGLES2, 20);
+   validate_no_error_functions(&ctx, nop_table);
    validate_functions(&ctx, gles2_functions_possible, nop_table);
    validate_nops(&ctx, nop_table);
 }
@@ -208,6 +285,7 @@ TEST_F(DispatchSanity_test, GLES2)
 TEST_F(DispatchSanity_test, GLES3)
 {
    SetUpCtx(API_OPENGLES2, 30);
+   validate_no_error_functions(&ctx, nop_table);
    validate_functions(&ctx, gles2_functions_possible, nop_table);
    validate_functions(&ctx, gles3_functions_possible, nop_table);
    validate_nops(&ctx, nop_table);
@@ -216,6 +294,60 @@ TEST_F(DispatchSanity_test, GLES3)
 TEST_F(DispatchSanity_test, GLES31)
 {
    SetUpCtx(API_OPENGLES2, 31);
+   validate_no_error_functions(&ctx, nop_table);
+   validate_functions(&ctx, gles2_functions_possible, nop_table);
+   validate_functions(&ctx, gles3_functions_possible, nop_table);
+   validate_functions(&ctx, gles31_functions_possible, nop_table);
+   validate_nops(&ctx, nop_table);
+}
+
+TEST_F(DispatchSanity_test, GL31_CORE_NO_ERROR)
+{
+   SetUpCtx(API_OPENGL_CORE, 31, GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR);
+   validate_no_error_functions(&ctx, nop_table);
+   validate_functions(&ctx, common_desktop_functions_possible, nop_table);
+   validate_functions(&ctx, gl_core_functions_possible, nop_table);
+   validate_nops(&ctx, nop_table);
+}
+
+TEST_F(DispatchSanity_test, GL30_NO_ERROR)
+{
+   SetUpCtx(API_OPENGL_COMPAT, 30, GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR);
+   validate_no_error_functions(&ctx, nop_table);
+   validate_functions(&ctx, common_desktop_functions_possible, nop_table);
+   validate_functions(&ctx, gl_compatibility_functions_possible, nop_table);
+   validate_nops(&ctx, nop_table);
+}
+
+TEST_F(DispatchSanity_test, GLES11_NO_ERROR)
+{
+   SetUpCtx(API_OPENGLES, 11, GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR);
+   validate_no_error_functions(&ctx, nop_table);
+   validate_functions(&ctx, gles11_functions_possible, nop_table);
+   validate_nops(&ctx, nop_table);
+}
+
+TEST_F(DispatchSanity_test, GLES2_NO_ERROR)
+{
+   SetUpCtx(API_OPENGLES2, 20, GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR);
+   validate_no_error_functions(&ctx, nop_table);
+   validate_functions(&ctx, gles2_functions_possible, nop_table);
+   validate_nops(&ctx, nop_table);
+}
+
+TEST_F(DispatchSanity_test, GLES3_NO_ERROR)
+{
+   SetUpCtx(API_OPENGLES2, 30, GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR);
+   validate_no_error_functions(&ctx, nop_table);
+   validate_functions(&ctx, gles2_functions_possible, nop_table);
+   validate_functions(&ctx, gles3_functions_possible, nop_table);
+   validate_nops(&ctx, nop_table);
+}
+
+TEST_F(DispatchSanity_test, GLES31_NO_ERROR)
+{
+   SetUpCtx(API_OPENGLES2, 31, GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR);
+   validate_no_error_functions(&ctx, nop_table);
    validate_functions(&ctx, gles2_functions_possible, nop_table);
    validate_functions(&ctx, gles3_functions_possible, nop_table);
    validate_functions(&ctx, gles31_functions_possible, nop_table);
@@ -522,6 +654,9 @@ const struct function common_desktop_functions_possible[] = {
    { "glProgramBinary", 30, -1 },
    { "glProgramParameteri", 30, -1 },
 
+   /* GL_ARB_parallel_shader_compile */
+   { "glMaxShaderCompilerThreadsARB", 11, -1 },
+
    /* GL_EXT_transform_feedback */
    { "glBindBufferOffsetEXT", 31, -1 },
 
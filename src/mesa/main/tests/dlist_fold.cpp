@@ -0,0 +1,254 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file dlist_fold.cpp
+ * Checks that calling a display list whose state settings glEndList has
+ * folded leaves the context in the same state as making the calls the list
+ * was compiled from directly.
+ */
+
+#include <gtest/gtest.h>
+
+#include "GL/gl.h"
+#include "GL/glext.h"
+#include "main/compiler.h"
+#include "main/api_exec.h"
+#include "main/context.h"
+#include "main/mtypes.h"
+#include "main/vtxfmt.h"
+#include "glapi/glapi.h"
+#include "drivers/common/driverfuncs.h"
+
+#include "vbo/vbo.h"
+
+#ifndef GLAPIENTRYP
+#define GLAPIENTRYP GL_APIENTRYP
+#endif
+
+#include "main/dispatch.h"
+
+class dlist_fold : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   void make_current(struct gl_context *ctx);
+   void set_state(struct gl_context *ctx);
+   void expect_same_state();
+
+   struct gl_config visual;
+   struct dd_function_table driver_functions;
+   struct gl_context *direct;
+   struct gl_context *listed;
+};
+
+static struct gl_context *
+create_context(const struct gl_config *visual,
+               struct dd_function_table *driver_functions)
+{
+   struct gl_context *ctx =
+      (struct gl_context *) calloc(1, sizeof(struct gl_context));
+
+   _mesa_initialize_context(ctx, API_OPENGL_COMPAT, visual, NULL,
+                            driver_functions);
+   _vbo_CreateContext(ctx);
+
+   ctx->Version = 21;
+
+   _mesa_initialize_dispatch_tables(ctx);
+   _mesa_initialize_vbo_vtxfmt(ctx);
+   return ctx;
+}
+
+void
+dlist_fold::SetUp()
+{
+   memset(&visual, 0, sizeof(visual));
+   memset(&driver_functions, 0, sizeof(driver_functions));
+   _mesa_init_driver_functions(&driver_functions);
+
+   direct = create_context(&visual, &driver_functions);
+   listed = create_context(&visual, &driver_functions);
+}
+
+void
+dlist_fold::TearDown()
+{
+   _glapi_set_context(NULL);
+   _mesa_free_context_data(direct);
+   _mesa_free_context_data(listed);
+   free(direct);
+   free(listed);
+}
+
+void
+dlist_fold::make_current(struct gl_context *ctx)
+{
+   ctx->CurrentDispatch = ctx->Exec;
+   _glapi_set_context(ctx);
+   _glapi_set_dispatch(ctx->CurrentDispatch);
+}
+
+/**
+ * Set the same state many times, in runs split by calls which are not
+ * folded, as apps compiling their state changes into lists tend to.
+ */
+void
+dlist_fold::set_state(struct gl_context *ctx)
+{
+   struct _glapi_table *exec = GET_DISPATCH();
+   unsigned i;
+
+   for (i = 0; i < 3; i++) {
+      CALL_Enable(exec, (GL_DEPTH_TEST));
+      CALL_DepthFunc(exec, (GL_LESS + i));
+      CALL_Disable(exec, (GL_DEPTH_TEST));
+      CALL_Enable(exec, (GL_DEPTH_TEST));
+      CALL_DepthMask(exec, (i % 2));
+      CALL_Enable(exec, (GL_BLEND));
+      CALL_AlphaFunc(exec, (GL_GREATER, 0.25f * i));
+      CALL_ColorMask(exec, (GL_TRUE, i == 1, GL_TRUE, GL_FALSE));
+      CALL_Color4f(exec, (0.1f * i, 0.2f, 0.3f, 1.0f));
+      CALL_Enable(exec, (GL_LIGHTING));
+      CALL_Enable(exec, (GL_LIGHT0 + i));
+
+      /* Not folded: it picks up the current color */
+      CALL_Enable(exec, (GL_COLOR_MATERIAL));
+
+      CALL_CullFace(exec, (i == 2 ? GL_FRONT : GL_BACK));
+      CALL_FrontFace(exec, (i == 1 ? GL_CW : GL_CCW));
+      CALL_ShadeModel(exec, (GL_FLAT));
+      CALL_ShadeModel(exec, (i == 2 ? GL_SMOOTH : GL_FLAT));
+      CALL_PolygonMode(exec, (GL_FRONT_AND_BACK, GL_LINE));
+      CALL_PolygonMode(exec, (GL_FRONT, GL_POINT));
+      CALL_PolygonOffset(exec, (1.0f + i, 2.0f));
+      CALL_Enable(exec, (GL_POLYGON_OFFSET_FILL));
+      CALL_LineWidth(exec, (1.5f * (i + 1)));
+      CALL_LineStipple(exec, (300, 0xf0f0 + i));
+      CALL_PointSize(exec, (4.0f - i));
+      CALL_Disable(exec, (GL_LIGHTING));
+
+      /* Not folded: not known to be valid */
+      CALL_Enable(exec, (GL_TEXTURE_3D));
+   }
+
+   CALL_Disable(exec, (GL_COLOR_MATERIAL));
+   CALL_Disable(exec, (GL_BLEND));
+   CALL_Enable(exec, (GL_CULL_FACE));
+}
+
+void
+dlist_fold::expect_same_state()
+{
+   const struct gl_context *a = direct, *b = listed;
+   unsigned i;
+
+   EXPECT_EQ(a->ErrorValue, b->ErrorValue);
+
+   EXPECT_EQ(a->Depth.Test, b->Depth.Test);
+   EXPECT_EQ(a->Depth.Func, b->Depth.Func);
+   EXPECT_EQ(a->Depth.Mask, b->Depth.Mask);
+
+   EXPECT_EQ(a->Color.BlendEnabled, b->Color.BlendEnabled);
+   EXPECT_EQ(a->Color.AlphaEnabled, b->Color.AlphaEnabled);
+   EXPECT_EQ(a->Color.AlphaFunc, b->Color.AlphaFunc);
+   EXPECT_EQ(a->Color.AlphaRef, b->Color.AlphaRef);
+   EXPECT_EQ(a->Color.AlphaRefUnclamped, b->Color.AlphaRefUnclamped);
+   for (i = 0; i < MAX_DRAW_BUFFERS; i++)
+      EXPECT_EQ(0, memcmp(a->Color.ColorMask[i], b->Color.ColorMask[i], 4));
+
+   EXPECT_EQ(a->Light.Enabled, b->Light.Enabled);
+   EXPECT_EQ(a->Light.ColorMaterialEnabled, b->Light.ColorMaterialEnabled);
+   EXPECT_EQ(a->Light.ShadeModel, b->Light.ShadeModel);
+   for (i = 0; i < MAX_LIGHTS; i++)
+      EXPECT_EQ(a->Light.Light[i].Enabled, b->Light.Light[i].Enabled);
+
+   EXPECT_EQ(a->Polygon.CullFlag, b->Polygon.CullFlag);
+   EXPECT_EQ(a->Polygon.CullFaceMode, b->Polygon.CullFaceMode);
+   EXPECT_EQ(a->Polygon.FrontFace, b->Polygon.FrontFace);
+   EXPECT_EQ(a->Polygon.FrontMode, b->Polygon.FrontMode);
+   EXPECT_EQ(a->Polygon.BackMode, b->Polygon.BackMode);
+   EXPECT_EQ(a->Polygon.OffsetFactor, b->Polygon.OffsetFactor);
+   EXPECT_EQ(a->Polygon.OffsetUnits, b->Polygon.OffsetUnits);
+   EXPECT_EQ(a->Polygon.OffsetFill, b->Polygon.OffsetFill);
+
+   EXPECT_EQ(a->Line.Width, b->Line.Width);
+   EXPECT_EQ(a->Line.StippleFactor, b->Line.StippleFactor);
+   EXPECT_EQ(a->Line.StipplePattern, b->Line.StipplePattern);
+   EXPECT_EQ(a->Point.Size, b->Point.Size);
+
+   EXPECT_EQ(a->Texture.Unit[0].Enabled, b->Texture.Unit[0].Enabled);
+
+   EXPECT_EQ(0, memcmp(a->Current.Attrib[VERT_ATTRIB_COLOR0],
+                       b->Current.Attrib[VERT_ATTRIB_COLOR0],
+                       4 * sizeof(GLfloat)));
+}
+
+TEST_F(dlist_fold, folded_list_matches_direct_calls)
+{
+   make_current(direct);
+   set_state(direct);
+   FLUSH_CURRENT(direct, 0);
+
+   make_current(listed);
+   CALL_NewList(GET_DISPATCH(), (1, GL_COMPILE));
+   set_state(listed);
+   CALL_EndList(GET_DISPATCH(), ());
+   ASSERT_EQ((GLenum) GL_NO_ERROR, listed->ErrorValue);
+
+   /* Nothing was executed yet */
+   EXPECT_FALSE(listed->Depth.Test);
+   EXPECT_EQ((GLenum) GL_SMOOTH, listed->Light.ShadeModel);
+
+   CALL_CallList(GET_DISPATCH(), (1));
+   FLUSH_CURRENT(listed, 0);
+
+   expect_same_state();
+}
+
+/**
+ * The settings a list keeps change state that differs from the context's
+ * when it is called, not only what the folded calls changed.
+ */
+TEST_F(dlist_fold, folded_list_overrides_changed_state)
+{
+   make_current(listed);
+   CALL_NewList(GET_DISPATCH(), (1, GL_COMPILE));
+   set_state(listed);
+   CALL_EndList(GET_DISPATCH(), ());
+
+   CALL_CallList(GET_DISPATCH(), (1));
+   CALL_Disable(GET_DISPATCH(), (GL_DEPTH_TEST));
+   CALL_DepthFunc(GET_DISPATCH(), (GL_ALWAYS));
+   CALL_LineWidth(GET_DISPATCH(), (7.0f));
+   CALL_ColorMask(GET_DISPATCH(), (GL_FALSE, GL_FALSE, GL_FALSE, GL_TRUE));
+   CALL_CallList(GET_DISPATCH(), (1));
+   FLUSH_CURRENT(listed, 0);
+
+   make_current(direct);
+   set_state(direct);
+   FLUSH_CURRENT(direct, 0);
+
+   expect_same_state();
+}
@@ -0,0 +1,223 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Compiles scenes of thousands of state settings and draws into display
+ * lists, then times calling each list against making the same calls
+ * directly.  Drawing goes to a vbo draw function that does nothing, so only
+ * the work Mesa does on the way to the driver is measured:
+ *
+ *    dlist-replay-bench [ITERATIONS]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "main/glheader.h"
+#include "main/api_exec.h"
+#include "main/context.h"
+#include "main/framebuffer.h"
+#include "main/mtypes.h"
+#include "main/vtxfmt.h"
+#include "glapi/glapi.h"
+#include "drivers/common/driverfuncs.h"
+#include "vbo/vbo.h"
+
+#include "main/dispatch.h"
+
+/* Objects drawn per scene, each after its own burst of state settings */
+#define NUM_OBJECTS 1000
+
+static void
+noop_draw(struct gl_context *ctx, const struct _mesa_prim *prims,
+          GLuint nr_prims, const struct _mesa_index_buffer *ib,
+          GLboolean index_bounds_valid, GLuint min_index, GLuint max_index,
+          struct gl_transform_feedback_object *tfb_vertcount,
+          struct gl_buffer_object *indirect)
+{
+}
+
+static void
+noop_update_state(struct gl_context *ctx, GLuint new_state)
+{
+}
+
+/**
+ * The state settings of an app that sets up each object's state in full,
+ * most of which is the same as the previous object's.
+ */
+static void
+set_object_state(struct _glapi_table *exec, unsigned i)
+{
+   CALL_Enable(exec, (GL_DEPTH_TEST));
+   CALL_DepthFunc(exec, (GL_LEQUAL));
+   CALL_DepthMask(exec, (GL_TRUE));
+   CALL_Disable(exec, (GL_BLEND));
+   CALL_Enable(exec, (GL_CULL_FACE));
+   CALL_CullFace(exec, (GL_BACK));
+   CALL_FrontFace(exec, (GL_CCW));
+   CALL_ShadeModel(exec, (GL_SMOOTH));
+   CALL_PolygonMode(exec, (GL_FRONT_AND_BACK, GL_FILL));
+   CALL_ColorMask(exec, (GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE));
+   CALL_LineWidth(exec, (1.0f));
+   CALL_PointSize(exec, (1.0f));
+   CALL_Disable(exec, (GL_DEPTH_TEST));
+   CALL_Enable(exec, (GL_DEPTH_TEST));
+   CALL_AlphaFunc(exec, (GL_GREATER, (i % 4) * 0.25f));
+   CALL_Color4f(exec, ((i % 8) / 8.0f, 0.5f, 0.5f, 1.0f));
+}
+
+static void
+draw_object(struct _glapi_table *exec, unsigned i)
+{
+   const float x = (i % 32) / 16.0f - 1.0f;
+   const float y = (i / 32) / 16.0f - 1.0f;
+
+   CALL_Begin(exec, (GL_TRIANGLE_STRIP));
+   CALL_Vertex3f(exec, (x, y, 0.0f));
+   CALL_Vertex3f(exec, (x + 0.05f, y, 0.0f));
+   CALL_Vertex3f(exec, (x, y + 0.05f, 0.0f));
+   CALL_Vertex3f(exec, (x + 0.05f, y + 0.05f, 0.0f));
+   CALL_End(exec, ());
+}
+
+static void
+emit_state_scene(struct _glapi_table *exec)
+{
+   unsigned i;
+
+   for (i = 0; i < NUM_OBJECTS; i++)
+      set_object_state(exec, i);
+}
+
+static void
+emit_draw_scene(struct _glapi_table *exec)
+{
+   unsigned i;
+
+   for (i = 0; i < NUM_OBJECTS; i++) {
+      set_object_state(exec, i);
+      draw_object(exec, i);
+   }
+}
+
+static const struct {
+   const char *name;
+   void (*emit)(struct _glapi_table *exec);
+} scenes[] = {
+   { "state only", emit_state_scene },
+   { "state + draws", emit_draw_scene },
+};
+
+static struct gl_context *
+create_context(void)
+{
+   static struct gl_config visual;
+   static struct dd_function_table driver_functions;
+   struct gl_context *ctx = calloc(1, sizeof(struct gl_context));
+   struct gl_framebuffer *fb;
+
+   _mesa_init_driver_functions(&driver_functions);
+   driver_functions.UpdateState = noop_update_state;
+
+   _mesa_initialize_context(ctx, API_OPENGL_COMPAT, &visual, NULL,
+                            &driver_functions);
+   _vbo_CreateContext(ctx);
+   vbo_set_draw_func(ctx, noop_draw);
+
+   ctx->Version = 21;
+
+   _mesa_initialize_dispatch_tables(ctx);
+   _mesa_initialize_vbo_vtxfmt(ctx);
+
+   /* Drawing needs a framebuffer, though nothing is rendered to it */
+   visual.rgbMode = GL_TRUE;
+   visual.redBits = visual.greenBits = visual.blueBits = 8;
+   fb = _mesa_create_framebuffer(&visual);
+   fb->Width = fb->Height = 64;
+   _mesa_make_current(ctx, fb, fb);
+   _mesa_reference_framebuffer(&fb, NULL);
+   return ctx;
+}
+
+static double
+get_time(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned iterations = argc > 1 ? atoi(argv[1]) : 1000;
+   struct gl_context *ctx = create_context();
+   bool success = true;
+   unsigned s, i;
+
+   for (s = 0; s < sizeof(scenes) / sizeof(scenes[0]); s++) {
+      const GLuint list = s + 1;
+      double start, secs[2];
+
+      CALL_NewList(GET_DISPATCH(), (list, GL_COMPILE));
+      scenes[s].emit(GET_DISPATCH());
+      CALL_EndList(GET_DISPATCH(), ());
+
+      start = get_time();
+      for (i = 0; i < iterations; i++)
+         scenes[s].emit(GET_DISPATCH());
+      FLUSH_VERTICES(ctx, 0);
+      secs[0] = get_time() - start;
+
+      start = get_time();
+      for (i = 0; i < iterations; i++)
+         CALL_CallList(GET_DISPATCH(), (list));
+      FLUSH_VERTICES(ctx, 0);
+      secs[1] = get_time() - start;
+
+      printf("%-14s direct: %8.1f us/scene  list: %8.1f us/scene  "
+             "speedup %.2f\n", scenes[s].name,
+             secs[0] * 1e6 / iterations, secs[1] * 1e6 / iterations,
+             secs[0] / secs[1]);
+
+      if (ctx->ErrorValue != GL_NO_ERROR) {
+         printf("Failure! The scene raised GL error 0x%x.\n",
+                ctx->ErrorValue);
+         success = false;
+      }
+   }
+
+   _mesa_make_current(NULL, NULL, NULL);
+   _mesa_free_context_data(ctx);
+   free(ctx);
+
+   if (!success)
+      return 1;
+
+   printf("Success!\n");
+   return 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Converts pixels with _mesa_swizzle_and_convert() for the conversions the
+ * SSE 4.1 kernels cover, once with the C code and once with the kernels,
+ * checks that both give the same results and prints the throughput of each:
+ *
+ *    format-convert-bench [ITERATIONS]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "main/cpuinfo.h"
+#include "main/format_utils.h"
+#include "x86/common_x86_asm.h"
+
+/* Not a multiple of 4, so that the C code converts a tail after the kernels. */
+#define NUM_PIXELS (256 * 256 + 3)
+
+/* The kernels are used when the CPU features say SSE 4.1 is there, so the
+ * C code is timed by masking it out.  That can't be done when the whole
+ * tree is built with -msse4.1 or without the x86 feature detection.
+ */
+#if defined(USE_SSE41) && !defined(__SSE4_1__) && \
+    (defined(USE_X86_ASM) || defined(USE_X86_64_ASM))
+#define CAN_TOGGLE_SSE41 1
+#endif
+
+#define X MESA_FORMAT_SWIZZLE_X
+#define Y MESA_FORMAT_SWIZZLE_Y
+#define Z MESA_FORMAT_SWIZZLE_Z
+#define W MESA_FORMAT_SWIZZLE_W
+#define ONE MESA_FORMAT_SWIZZLE_ONE
+
+static const struct {
+   const char *name;
+   enum mesa_array_format_datatype dst_type;
+   int num_dst_channels;
+   enum mesa_array_format_datatype src_type;
+   int num_src_channels;
+   uint8_t swizzle[4];
+} conversions[] = {
+   { "RGBA8 -> BGRA8",
+     MESA_ARRAY_FORMAT_TYPE_UBYTE, 4, MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
+     { Z, Y, X, W } },
+   { "RGB8 -> RGBA8",
+     MESA_ARRAY_FORMAT_TYPE_UBYTE, 4, MESA_ARRAY_FORMAT_TYPE_UBYTE, 3,
+     { X, Y, Z, ONE } },
+   { "BGRA8 -> RGBA32F",
+     MESA_ARRAY_FORMAT_TYPE_FLOAT, 4, MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
+     { Z, Y, X, W } },
+   { "RGBA32F -> RGBA8",
+     MESA_ARRAY_FORMAT_TYPE_UBYTE, 4, MESA_ARRAY_FORMAT_TYPE_FLOAT, 4,
+     { X, Y, Z, W } },
+   { "RGBA16F -> RGBA32F",
+     MESA_ARRAY_FORMAT_TYPE_FLOAT, 4, MESA_ARRAY_FORMAT_TYPE_HALF, 4,
+     { X, Y, Z, W } },
+   { "RGB32F -> RGB16F",
+     MESA_ARRAY_FORMAT_TYPE_HALF, 3, MESA_ARRAY_FORMAT_TYPE_FLOAT, 3,
+     { X, Y, Z, W } },
+};
+
+static double
+get_time(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int
+main(int argc, char **argv)
+{
+   static uint32_t src[NUM_PIXELS * 4];
+   static uint32_t dst[2][NUM_PIXELS * 4];
+   unsigned iterations = argc > 1 ? atoi(argv[1]) : 100;
+   int sse41_features;
+   bool success = true;
+   unsigned c, i, m;
+
+   _mesa_get_cpu_features();
+
+#ifdef CAN_TOGGLE_SSE41
+   sse41_features = _mesa_x86_cpu_features & X86_FEATURE_SSE4_1;
+#else
+   sse41_features = 0;
+#endif
+   if (!sse41_features) {
+      printf("The SSE 4.1 kernels are not available, nothing to compare.\n");
+      return 0;
+   }
+
+   /* Random floats in [-0.25, 1.25] hit the clamping of the unorm
+    * conversions, and their upper halves make up arbitrary half floats.
+    */
+   srand(0);
+   for (i = 0; i < NUM_PIXELS * 4; i++) {
+      const float f = (float) rand() / RAND_MAX * 1.5f - 0.25f;
+
+      memcpy(&src[i], &f, sizeof(f));
+   }
+
+   for (c = 0; c < sizeof(conversions) / sizeof(conversions[0]); c++) {
+      double secs[2];
+      double mpixels = (double) NUM_PIXELS * iterations / 1e6;
+
+      for (m = 0; m < 2; m++) {
+         double start;
+
+#ifdef CAN_TOGGLE_SSE41
+         if (m == 0)
+            _mesa_x86_cpu_features &= ~X86_FEATURE_SSE4_1;
+         else
+            _mesa_x86_cpu_features |= sse41_features;
+#endif
+
+         memset(dst[m], 0, sizeof(dst[m]));
+         start = get_time();
+         for (i = 0; i < iterations; i++) {
+            _mesa_swizzle_and_convert(dst[m], conversions[c].dst_type,
+                                      conversions[c].num_dst_channels,
+                                      src, conversions[c].src_type,
+                                      conversions[c].num_src_channels,
+                                      conversions[c].swizzle, true,
+                                      NUM_PIXELS);
+         }
+         secs[m] = get_time() - start;
+      }
+
+      printf("%-20s C: %7.1f Mpixels/s  SSE 4.1: %7.1f Mpixels/s  "
+             "speedup %.2f\n", conversions[c].name,
+             mpixels / secs[0], mpixels / secs[1], secs[0] / secs[1]);
+
+      if (memcmp(dst[0], dst[1], sizeof(dst[0])) != 0) {
+         printf("Failure! The SSE 4.1 kernels gave different results.\n");
+         success = false;
+      }
+   }
+
+   if (!success)
+      return 1;
+
+   printf("Success!\n");
+   return 0;
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file hash_table.cpp
+ * Tests for the GL object name table.  hash_table_bench.c times the
+ * concurrent lookups.
+ */
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include "c11/threads.h"
+#include "util/macros.h"
+#include "util/u_atomic.h"
+
+extern "C" {
+#include "main/hash.h"
+}
+
+static void *
+object(GLuint key)
+{
+   return (void *)(uintptr_t)(key * 16 + 8);
+}
+
+static void
+count_entry(GLuint key, void *data, void *userData)
+{
+   EXPECT_EQ(object(key), data);
+   ++*(GLuint *) userData;
+}
+
+static void
+remove_entry(GLuint key, void *data, void *userData)
+{
+   EXPECT_EQ(object(key), data);
+}
+
+TEST(HashTable, InsertLookupRemove)
+{
+   struct _mesa_HashTable *table = _mesa_NewHashTable();
+   static const GLuint keys[] = { 1, 2, 63, 64, 100, 5000, 100000, ~0u - 1 };
+   GLuint walked = 0;
+   unsigned i;
+
+   for (i = 0; i < ARRAY_SIZE(keys); i++)
+      _mesa_HashInsert(table, keys[i], object(keys[i]));
+
+   for (i = 0; i < ARRAY_SIZE(keys); i++)
+      EXPECT_EQ(object(keys[i]), _mesa_HashLookup(table, keys[i]));
+   EXPECT_TRUE(_mesa_HashLookup(table, 3) == NULL);
+   EXPECT_TRUE(_mesa_HashLookup(table, 4999) == NULL);
+   EXPECT_EQ(ARRAY_SIZE(keys), _mesa_HashNumEntries(table));
+
+   _mesa_HashWalk(table, count_entry, &walked);
+   EXPECT_EQ(ARRAY_SIZE(keys), walked);
+
+   _mesa_HashRemove(table, 1);
+   _mesa_HashRemove(table, 100000);
+   EXPECT_TRUE(_mesa_HashLookup(table, 1) == NULL);
+   EXPECT_TRUE(_mesa_HashLookup(table, 100000) == NULL);
+   EXPECT_EQ(object(2), _mesa_HashLookup(table, 2));
+   EXPECT_EQ(ARRAY_SIZE(keys) - 2, _mesa_HashNumEntries(table));
+
+   _mesa_HashDeleteAll(table, remove_entry, NULL);
+   EXPECT_EQ(0u, _mesa_HashNumEntries(table));
+
+   _mesa_DeleteHashTable(table);
+}
+
+/**
+ * Keys inserted out of order end up in the hash table first and must
+ * still be found once the dense array grows over them.
+ */
+TEST(HashTable, DenseGrowth)
+{
+   struct _mesa_HashTable *table = _mesa_NewHashTable();
+   GLuint key, walked = 0;
+
+   _mesa_HashInsert(table, 3000, object(3000));
+   for (key = 1; key <= 4000; key++) {
+      if (key != 3000)
+         _mesa_HashInsert(table, key, object(key));
+   }
+
+   for (key = 1; key <= 4000; key++)
+      EXPECT_EQ(object(key), _mesa_HashLookup(table, key));
+   EXPECT_EQ(4000u, _mesa_HashNumEntries(table));
+   EXPECT_EQ(4001u, _mesa_HashFindFreeKeyBlock(table, 10));
+
+   _mesa_HashWalk(table, count_entry, &walked);
+   EXPECT_EQ(4000u, walked);
+
+   _mesa_HashDeleteAll(table, remove_entry, NULL);
+   _mesa_DeleteHashTable(table);
+}
+
+
+#define CONCURRENT_THREADS 4
+#define CONCURRENT_KEYS 4096
+#define CONCURRENT_LOOKUPS (1 << 18)
+
+struct concurrent_state {
+   struct _mesa_HashTable *table;
+   GLuint first_key;       /**< first of the CONCURRENT_KEYS looked up */
+   volatile bool stop;
+   unsigned errors;
+};
+
+static int
+concurrent_reader(void *data)
+{
+   struct concurrent_state *state = (struct concurrent_state *) data;
+   unsigned errors = 0;
+   unsigned i;
+
+   for (i = 0; i < CONCURRENT_LOOKUPS; i++) {
+      GLuint key = state->first_key + (i * 2654435761u) % CONCURRENT_KEYS;
+      if (_mesa_HashLookup(state->table, key) != object(key))
+         errors++;
+   }
+
+   p_atomic_add(&state->errors, errors);
+   return 0;
+}
+
+/* Keeps binding and deleting other names, as another context would. */
+static int
+concurrent_writer(void *data)
+{
+   struct concurrent_state *state = (struct concurrent_state *) data;
+   const GLuint first = state->first_key + CONCURRENT_KEYS;
+   GLuint key = first;
+
+   while (!state->stop) {
+      _mesa_HashInsert(state->table, key, object(key));
+      if (key >= first + 64)
+         _mesa_HashRemove(state->table, key - 64);
+      if (++key == first + 3 * CONCURRENT_KEYS)
+         key = first;
+   }
+
+   return 0;
+}
+
+static unsigned
+run_concurrent(GLuint first_key)
+{
+   struct concurrent_state state;
+   thrd_t readers[CONCURRENT_THREADS], writer;
+   GLuint key;
+   unsigned i;
+
+   state.table = _mesa_NewHashTable();
+   state.first_key = first_key;
+   state.stop = false;
+   state.errors = 0;
+
+   for (key = first_key; key < first_key + CONCURRENT_KEYS; key++)
+      _mesa_HashInsert(state.table, key, object(key));
+
+   thrd_create(&writer, concurrent_writer, &state);
+
+   for (i = 0; i < CONCURRENT_THREADS; i++)
+      thrd_create(&readers[i], concurrent_reader, &state);
+   for (i = 0; i < CONCURRENT_THREADS; i++)
+      thrd_join(readers[i], NULL);
+
+   state.stop = true;
+   thrd_join(writer, NULL);
+
+   _mesa_HashDeleteAll(state.table, remove_entry, NULL);
+   _mesa_DeleteHashTable(state.table);
+
+   return state.errors;
+}
+
+/**
+ * Lookups from several threads while another one keeps inserting and
+ * removing, once for names in the lock-free dense range and once for
+ * names only found under the table mutex.
+ */
+TEST(HashTable, ConcurrentLookup)
+{
+   EXPECT_EQ(0u, run_concurrent(1));
+   EXPECT_EQ(0u, run_concurrent(1u << 24));
+}
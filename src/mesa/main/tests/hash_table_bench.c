@@ -0,0 +1,175 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Looks up GL object names from several threads while another thread keeps
+ * inserting and removing names, as another context sharing the table would,
+ * and prints how long the lookups take.  That is done once for names in the
+ * lock-free dense range and once for names only found under the table
+ * mutex:
+ *
+ *    hash-table-bench [THREADS]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "c11/threads.h"
+#include "util/u_atomic.h"
+#include "main/hash.h"
+
+#define MAX_THREADS 64
+#define NUM_KEYS 4096
+#define NUM_LOOKUPS (1 << 22)
+
+struct bench_state {
+   struct _mesa_HashTable *table;
+   GLuint first_key;       /**< readers look up [first_key, + NUM_KEYS) */
+   volatile bool stop;
+   unsigned errors;
+};
+
+static void *
+object(GLuint key)
+{
+   return (void *)(uintptr_t)(key * 16 + 8);
+}
+
+static void
+remove_entry(GLuint key, void *data, void *userData)
+{
+}
+
+static int
+reader(void *data)
+{
+   struct bench_state *state = (struct bench_state *) data;
+   unsigned errors = 0;
+   unsigned i;
+
+   for (i = 0; i < NUM_LOOKUPS; i++) {
+      GLuint key = state->first_key + (i * 2654435761u) % NUM_KEYS;
+      if (_mesa_HashLookup(state->table, key) != object(key))
+         errors++;
+   }
+
+   p_atomic_add(&state->errors, errors);
+   return 0;
+}
+
+static int
+writer(void *data)
+{
+   struct bench_state *state = (struct bench_state *) data;
+   const GLuint first = state->first_key + NUM_KEYS;
+   GLuint key = first;
+
+   while (!state->stop) {
+      _mesa_HashInsert(state->table, key, object(key));
+      if (key >= first + 64)
+         _mesa_HashRemove(state->table, key - 64);
+      if (++key == first + 3 * NUM_KEYS)
+         key = first;
+   }
+
+   return 0;
+}
+
+static double
+get_time(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/**
+ * Time num_threads readers of the names starting at first_key.
+ */
+static double
+run(GLuint first_key, unsigned num_threads, unsigned *errors)
+{
+   struct bench_state state;
+   thrd_t readers[MAX_THREADS], writer_thread;
+   double start, end;
+   GLuint key;
+   unsigned i;
+
+   state.table = _mesa_NewHashTable();
+   state.first_key = first_key;
+   state.stop = false;
+   state.errors = 0;
+
+   for (key = first_key; key < first_key + NUM_KEYS; key++)
+      _mesa_HashInsert(state.table, key, object(key));
+
+   thrd_create(&writer_thread, writer, &state);
+
+   start = get_time();
+   for (i = 0; i < num_threads; i++)
+      thrd_create(&readers[i], reader, &state);
+   for (i = 0; i < num_threads; i++)
+      thrd_join(readers[i], NULL);
+   end = get_time();
+
+   state.stop = true;
+   thrd_join(writer_thread, NULL);
+
+   _mesa_HashDeleteAll(state.table, remove_entry, NULL);
+   _mesa_DeleteHashTable(state.table);
+
+   *errors = state.errors;
+   return end - start;
+}
+
+int
+main(int argc, char **argv)
+{
+   unsigned num_threads = argc > 1 ? atoi(argv[1]) : 4;
+   unsigned dense_errors, locked_errors;
+   double dense_ms, locked_ms;
+
+   if (num_threads < 1 || num_threads > MAX_THREADS) {
+      fprintf(stderr, "usage: %s [THREADS], at most %u threads\n",
+              argv[0], MAX_THREADS);
+      return EXIT_FAILURE;
+   }
+
+   dense_ms = run(1, num_threads, &dense_errors);
+   locked_ms = run(1u << 24, num_threads, &locked_errors);
+
+   printf("%u threads x %u lookups: %.1f ms lock-free, %.1f ms locked\n",
+          num_threads, NUM_LOOKUPS, dense_ms, locked_ms);
+
+   if (dense_errors || locked_errors) {
+      printf("%u lookups returned the wrong object\n",
+             dense_errors + locked_errors);
+      return EXIT_FAILURE;
+   }
+
+   return EXIT_SUCCESS;
+}
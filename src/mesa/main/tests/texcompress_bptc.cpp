@@ -0,0 +1,173 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file texcompress_bptc.cpp
+ * Checks that compressing BPTC images on the texture compression threads
+ * gives the same bytes as compressing them on the calling thread.
+ */
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main/mtypes.h"
+#include "util/u_queue.h"
+
+extern "C" {
+#include "main/texcompress_bptc.h"
+}
+
+/* Not a multiple of the block size, and enough block rows to be banded */
+#define WIDTH  70
+#define HEIGHT 61
+
+#define BLOCKS_WIDE ((WIDTH + 3) / 4)
+#define BLOCKS_HIGH ((HEIGHT + 3) / 4)
+#define DST_ROW_STRIDE (BLOCKS_WIDE * 16)
+#define DST_SIZE (DST_ROW_STRIDE * BLOCKS_HIGH)
+
+typedef GLboolean (*texstore_func)(TEXSTORE_PARAMS);
+
+class bptc_compress : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   void compress(texstore_func store, mesa_format format,
+                 GLenum src_format, GLenum src_type, const void *src,
+                 unsigned num_threads, GLubyte *dst);
+
+   struct gl_context *ctx;
+   struct gl_pixelstore_attrib packing;
+};
+
+void
+bptc_compress::SetUp()
+{
+   ctx = (struct gl_context *) calloc(1, sizeof(*ctx));
+   memset(&packing, 0, sizeof(packing));
+   packing.Alignment = 1;
+}
+
+void
+bptc_compress::TearDown()
+{
+   free(ctx);
+}
+
+/**
+ * Compress the image with a new share group, which compresses on the
+ * calling thread only if \p num_threads is 0.  The queue is set up here
+ * rather than from $MESA_TEXTURE_COMPRESS_THREADS so that the bands also
+ * go to other threads on machines with a single CPU.
+ */
+void
+bptc_compress::compress(texstore_func store, mesa_format format,
+                        GLenum src_format, GLenum src_type, const void *src,
+                        unsigned num_threads, GLubyte *dst)
+{
+   struct gl_shared_state *shared =
+      (struct gl_shared_state *) calloc(1, sizeof(*shared));
+   GLubyte *dst_slices[1] = { dst };
+
+   mtx_init(&shared->Mutex, mtx_plain);
+   ctx->Shared = shared;
+
+   if (num_threads > 0) {
+      shared->TextureCompressQueue =
+         (struct util_queue *) malloc(sizeof(struct util_queue));
+      ASSERT_TRUE(util_queue_init(shared->TextureCompressQueue,
+                                  num_threads));
+   } else {
+#ifdef _WIN32
+      _putenv_s("MESA_TEXTURE_COMPRESS_THREADS", "0");
+#else
+      setenv("MESA_TEXTURE_COMPRESS_THREADS", "0", 1);
+#endif
+   }
+
+   memset(dst, 0xcd, DST_SIZE);
+   EXPECT_TRUE(store(ctx, 2, GL_RGBA, format, DST_ROW_STRIDE, dst_slices,
+                     WIDTH, HEIGHT, 1, src_format, src_type, src, &packing));
+
+   if (shared->TextureCompressQueue) {
+      util_queue_destroy(shared->TextureCompressQueue);
+      free(shared->TextureCompressQueue);
+   }
+   mtx_destroy(&shared->Mutex);
+   free(shared);
+   ctx->Shared = NULL;
+}
+
+TEST_F(bptc_compress, rgba_unorm_threads_match_serial)
+{
+   GLubyte *src = (GLubyte *) malloc(WIDTH * HEIGHT * 4);
+   GLubyte serial[DST_SIZE], threaded[DST_SIZE];
+   unsigned i;
+
+   srand(1);
+   for (i = 0; i < WIDTH * HEIGHT * 4; i++) {
+      /* Smooth gradients with noise, so that blocks pick different modes */
+      src[i] = (GLubyte) ((i / 4 % WIDTH) * 3 + (i / 4 / WIDTH) * (i % 4) +
+                          rand() % 24);
+   }
+
+   compress(_mesa_texstore_bptc_rgba_unorm, MESA_FORMAT_BPTC_RGBA_UNORM,
+            GL_RGBA, GL_UNSIGNED_BYTE, src, 0, serial);
+   compress(_mesa_texstore_bptc_rgba_unorm, MESA_FORMAT_BPTC_RGBA_UNORM,
+            GL_RGBA, GL_UNSIGNED_BYTE, src, 3, threaded);
+
+   EXPECT_EQ(0, memcmp(serial, threaded, DST_SIZE));
+
+   free(src);
+}
+
+TEST_F(bptc_compress, rgb_float_threads_match_serial)
+{
+   GLfloat *src = (GLfloat *) malloc(WIDTH * HEIGHT * 3 * sizeof(GLfloat));
+   GLubyte serial[DST_SIZE], threaded[DST_SIZE];
+   unsigned i;
+
+   srand(2);
+   for (i = 0; i < WIDTH * HEIGHT * 3; i++)
+      src[i] = (rand() % 4096) / 256.0f - 4.0f;
+
+   compress(_mesa_texstore_bptc_rgb_signed_float,
+            MESA_FORMAT_BPTC_RGB_SIGNED_FLOAT,
+            GL_RGB, GL_FLOAT, src, 0, serial);
+   compress(_mesa_texstore_bptc_rgb_signed_float,
+            MESA_FORMAT_BPTC_RGB_SIGNED_FLOAT,
+            GL_RGB, GL_FLOAT, src, 3, threaded);
+   EXPECT_EQ(0, memcmp(serial, threaded, DST_SIZE));
+
+   compress(_mesa_texstore_bptc_rgb_unsigned_float,
+            MESA_FORMAT_BPTC_RGB_UNSIGNED_FLOAT,
+            GL_RGB, GL_FLOAT, src, 0, serial);
+   compress(_mesa_texstore_bptc_rgb_unsigned_float,
+            MESA_FORMAT_BPTC_RGB_UNSIGNED_FLOAT,
+            GL_RGB, GL_FLOAT, src, 3, threaded);
+   EXPECT_EQ(0, memcmp(serial, threaded, DST_SIZE));
+
+   free(src);
+}
@@ -0,0 +1,211 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file vbo_save_index.cpp
+ * Tests for the indexed primitives display list vertex lists are drawn
+ * with.
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include "main/mtypes.h"
+#include "main/imports.h"
+
+extern "C" {
+#include "vbo/vbo_save.h"
+}
+
+/* Room for three indices per vertex */
+#define MAX_VERTS   16
+#define MAX_INDICES (3 * MAX_VERTS)
+#define MAX_PRIMS   4
+
+class vbo_save_index : public ::testing::Test {
+public:
+   void add_vertices(const float *values, unsigned count);
+   void add_prim(GLenum mode, unsigned count, bool begin, bool end);
+   void index_prims();
+
+   fi_type vertices[MAX_VERTS];
+   unsigned vertex_count;
+   struct _mesa_prim prims[MAX_PRIMS];
+   unsigned prim_count;
+
+   GLuint indices[MAX_INDICES];
+   GLuint index_count;
+   struct _mesa_prim merged[MAX_PRIMS];
+   GLuint merged_count;
+   GLuint unique_count;
+   GLboolean triangulated;
+
+   virtual void SetUp()
+   {
+      vertex_count = 0;
+      prim_count = 0;
+   }
+};
+
+void
+vbo_save_index::add_vertices(const float *values, unsigned count)
+{
+   unsigned i;
+
+   for (i = 0; i < count; i++)
+      vertices[vertex_count++].f = values[i];
+}
+
+/**
+ * Add a primitive made of the \p count vertices after the previous one
+ */
+void
+vbo_save_index::add_prim(GLenum mode, unsigned count, bool begin, bool end)
+{
+   struct _mesa_prim *prim = &prims[prim_count];
+
+   memset(prim, 0, sizeof(*prim));
+   prim->mode = mode;
+   prim->begin = begin;
+   prim->end = end;
+   prim->start = prim_count ? prims[prim_count - 1].start +
+                              prims[prim_count - 1].count : 0;
+   prim->count = count;
+   prim->num_instances = 1;
+   prim_count++;
+}
+
+void
+vbo_save_index::index_prims()
+{
+   index_count = vbo_save_index_prims(vertices, 1, vertex_count,
+                                      prims, prim_count,
+                                      indices, merged, &merged_count,
+                                      &unique_count, &triangulated);
+}
+
+TEST_F(vbo_save_index, begin_end_pairs_are_merged)
+{
+   static const float values[] = { 10, 11, 12,  10, 11, 13 };
+   static const GLuint expected[] = { 0, 1, 2,  0, 1, 5 };
+
+   add_vertices(values, ARRAY_SIZE(values));
+   add_prim(GL_TRIANGLES, 3, true, true);
+   add_prim(GL_TRIANGLES, 3, true, true);
+   index_prims();
+
+   EXPECT_EQ(4u, unique_count);
+   EXPECT_FALSE(triangulated);
+   ASSERT_EQ(ARRAY_SIZE(expected), index_count);
+   EXPECT_EQ(0, memcmp(expected, indices, sizeof(expected)));
+
+   ASSERT_EQ(1u, merged_count);
+   EXPECT_EQ((GLuint) GL_TRIANGLES, merged[0].mode);
+   EXPECT_TRUE(merged[0].indexed);
+   EXPECT_TRUE(merged[0].begin);
+   EXPECT_TRUE(merged[0].end);
+   EXPECT_EQ(0u, merged[0].start);
+   EXPECT_EQ(6u, merged[0].count);
+}
+
+/**
+ * Strips, quads and triangles all end up as triangles, so a run of them is
+ * drawn as one list of triangles.
+ */
+TEST_F(vbo_save_index, triangulated_prims_are_merged)
+{
+   static const float values[] = { 0, 1, 2, 3,  4, 5, 6, 7,  8, 9, 10 };
+   static const GLuint expected[] = {
+      0, 1, 2,  2, 1, 3,
+      4, 5, 7,  5, 6, 7,
+      8, 9, 10
+   };
+
+   add_vertices(values, ARRAY_SIZE(values));
+   add_prim(GL_TRIANGLE_STRIP, 4, true, true);
+   add_prim(GL_QUADS, 4, true, true);
+   add_prim(GL_TRIANGLES, 3, true, true);
+   index_prims();
+
+   EXPECT_EQ(11u, unique_count);
+   EXPECT_TRUE(triangulated);
+   ASSERT_EQ(ARRAY_SIZE(expected), index_count);
+   EXPECT_EQ(0, memcmp(expected, indices, sizeof(expected)));
+
+   ASSERT_EQ(1u, merged_count);
+   EXPECT_EQ((GLuint) GL_TRIANGLES, merged[0].mode);
+   EXPECT_EQ(0u, merged[0].start);
+   EXPECT_EQ(15u, merged[0].count);
+}
+
+/**
+ * The tail of a strip split up by a vertex store wrap is the first
+ * primitive of its node, and is merged with the pairs that follow it.
+ */
+TEST_F(vbo_save_index, wrapped_tail_is_merged_with_next_pair)
+{
+   static const float values[] = { 2, 3, 4, 5,  6, 7, 8 };
+   static const GLuint expected[] = {
+      0, 1, 2,  2, 1, 3,  4, 5, 6
+   };
+
+   add_vertices(values, ARRAY_SIZE(values));
+   add_prim(GL_TRIANGLE_STRIP, 4, false, true);
+   add_prim(GL_TRIANGLES, 3, true, true);
+   index_prims();
+
+   ASSERT_EQ(ARRAY_SIZE(expected), index_count);
+   EXPECT_EQ(0, memcmp(expected, indices, sizeof(expected)));
+
+   ASSERT_EQ(1u, merged_count);
+   EXPECT_FALSE(merged[0].begin);
+   EXPECT_TRUE(merged[0].end);
+   EXPECT_EQ(9u, merged[0].count);
+}
+
+/**
+ * Primitives that don't end up as the same kind of independent primitives
+ * are drawn separately.
+ */
+TEST_F(vbo_save_index, different_modes_stay_separate)
+{
+   static const float values[] = { 0, 1,  2, 3, 4,  5, 6,  7, 8, 9 };
+
+   add_vertices(values, ARRAY_SIZE(values));
+   add_prim(GL_LINES, 2, true, true);
+   add_prim(GL_LINE_STRIP, 3, true, true);
+   add_prim(GL_LINE_STRIP, 2, true, true);
+   add_prim(GL_TRIANGLES, 3, true, true);
+   index_prims();
+
+   EXPECT_FALSE(triangulated);
+   EXPECT_EQ(10u, index_count);
+
+   ASSERT_EQ(4u, merged_count);
+   EXPECT_EQ((GLuint) GL_LINES, merged[0].mode);
+   EXPECT_EQ((GLuint) GL_LINE_STRIP, merged[1].mode);
+   EXPECT_EQ((GLuint) GL_LINE_STRIP, merged[2].mode);
+   EXPECT_EQ((GLuint) GL_TRIANGLES, merged[3].mode);
+   EXPECT_EQ(5u, merged[2].start);
+   EXPECT_EQ(2u, merged[2].count);
+}
@@ -34,6 +34,7 @@
 #include "imports.h"
 #include "context.h"
 #include "formats.h"
+#include "macros.h"
 #include "mtypes.h"
 #include "context.h"
 #include "texcompress.h"
@@ -42,6 +43,10 @@
 #include "texcompress_s3tc.h"
 #include "texcompress_etc.h"
 #include "texcompress_bptc.h"
+#include "util/u_queue.h"
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 
 /**
@@ -609,6 +614,16 @@ _mesa_get_compressed_fetch_func(mesa_format format)
    case MESA_FORMAT_LA_LATC2_SNORM:
       return _mesa_get_compressed_rgtc_func(format);
    case MESA_FORMAT_ETC1_RGB8:
+   case MESA_FORMAT_ETC2_RGB8:
+   case MESA_FORMAT_ETC2_SRGB8:
+   case MESA_FORMAT_ETC2_RGBA8_EAC:
+   case MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC:
+   case MESA_FORMAT_ETC2_R11_EAC:
+   case MESA_FORMAT_ETC2_RG11_EAC:
+   case MESA_FORMAT_ETC2_SIGNED_R11_EAC:
+   case MESA_FORMAT_ETC2_SIGNED_RG11_EAC:
+   case MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1:
+   case MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1:
       return _mesa_get_etc_fetch_func(format);
    case MESA_FORMAT_BPTC_RGBA_UNORM:
    case MESA_FORMAT_BPTC_SRGB_ALPHA_UNORM:
@@ -621,6 +636,73 @@ _mesa_get_compressed_fetch_func(mesa_format format)
 }
 
 
+/**
+ * Return a function decoding a whole 4x4 block at once for the given
+ * format, or NULL if there is none.  The formats which have one are the
+ * ones whose blocks are expensive to decode compared to a single texel.
+ */
+compressed_fetch_block_func
+_mesa_get_compressed_fetch_block_func(mesa_format format)
+{
+   switch (format) {
+   case MESA_FORMAT_ETC1_RGB8:
+   case MESA_FORMAT_ETC2_RGB8:
+   case MESA_FORMAT_ETC2_SRGB8:
+   case MESA_FORMAT_ETC2_RGBA8_EAC:
+   case MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC:
+   case MESA_FORMAT_ETC2_R11_EAC:
+   case MESA_FORMAT_ETC2_RG11_EAC:
+   case MESA_FORMAT_ETC2_SIGNED_R11_EAC:
+   case MESA_FORMAT_ETC2_SIGNED_RG11_EAC:
+   case MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1:
+   case MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1:
+      return _mesa_get_etc_fetch_block_func(format);
+   case MESA_FORMAT_BPTC_RGBA_UNORM:
+   case MESA_FORMAT_BPTC_SRGB_ALPHA_UNORM:
+   case MESA_FORMAT_BPTC_RGB_SIGNED_FLOAT:
+   case MESA_FORMAT_BPTC_RGB_UNSIGNED_FLOAT:
+      return _mesa_get_bptc_fetch_block_func(format);
+   default:
+      return NULL;
+   }
+}
+
+
+/**
+ * Decompress an image of 4x4 blocks one block at a time.
+ */
+static void
+decompress_image_blocks(compressed_fetch_block_func fetch_block,
+                        GLuint block_bytes, GLuint width, GLuint height,
+                        const GLubyte *src, GLint srcRowStride,
+                        GLfloat *dest)
+{
+   GLfloat texels[16][4];
+   GLuint x, y, i, j;
+
+   for (y = 0; y < height; y += 4) {
+      const GLubyte *block = src;
+      const GLuint h = MIN2(4, height - y);
+
+      for (x = 0; x < width; x += 4) {
+         const GLuint w = MIN2(4, width - x);
+
+         fetch_block(block, texels);
+
+         for (j = 0; j < h; j++) {
+            for (i = 0; i < w; i++)
+               COPY_4V(dest + ((y + j) * width + x + i) * 4,
+                       texels[j * 4 + i]);
+         }
+
+         block += block_bytes;
+      }
+
+      src += srcRowStride;
+   }
+}
+
+
 /**
  * Decompress a compressed texture image, returning a GL_RGBA/GL_FLOAT image.
  * \param srcRowStride  stride in bytes between rows of blocks in the
@@ -632,6 +714,7 @@ _mesa_decompress_image(mesa_format format, GLuint width, GLuint height,
                        GLfloat *dest)
 {
    compressed_fetch_func fetch;
+   compressed_fetch_block_func fetch_block;
    GLuint i, j;
    GLuint bytes, bw, bh;
    GLint stride;
@@ -639,6 +722,13 @@ _mesa_decompress_image(mesa_format format, GLuint width, GLuint height,
    bytes = _mesa_get_format_bytes(format);
    _mesa_get_format_block_size(format, &bw, &bh);
 
+   fetch_block = _mesa_get_compressed_fetch_block_func(format);
+   if (fetch_block) {
+      decompress_image_blocks(fetch_block, bytes, width, height,
+                              src, srcRowStride, dest);
+      return;
+   }
+
    fetch = _mesa_get_compressed_fetch_func(format);
    if (!fetch) {
       _mesa_problem(NULL, "Unexpected format in _mesa_decompress_image()");
@@ -654,3 +744,128 @@ _mesa_decompress_image(mesa_format format, GLuint width, GLuint height,
       }
    }
 }
+
+
+/**
+ * Number of threads compressing texture images besides the calling thread:
+ * $MESA_TEXTURE_COMPRESS_THREADS if set, otherwise one per other CPU.
+ * Since the calling thread compresses a band too, more threads than that
+ * would only compete for the CPUs, so the variable is clamped to it.
+ */
+static unsigned
+texture_compress_threads(void)
+{
+   const char *env = getenv("MESA_TEXTURE_COMPRESS_THREADS");
+   long num_cpus = 1;
+   long n;
+
+#ifdef _SC_NPROCESSORS_ONLN
+   num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+   n = num_cpus - 1;
+   if (env)
+      n = MIN2(strtol(env, NULL, 10), n);
+
+   return n > 0 ? n : 0;
+}
+
+
+static struct util_queue *
+get_texture_compress_queue(struct gl_context *ctx)
+{
+   struct gl_shared_state *shared = ctx->Shared;
+   struct util_queue *queue;
+
+   mtx_lock(&shared->Mutex);
+   if (!shared->TextureCompressQueue) {
+      const unsigned num_threads = texture_compress_threads();
+
+      if (num_threads > 0) {
+         queue = malloc(sizeof(*queue));
+         if (queue && util_queue_init(queue, num_threads))
+            shared->TextureCompressQueue = queue;
+         else
+            free(queue);
+      }
+   }
+   queue = shared->TextureCompressQueue;
+   mtx_unlock(&shared->Mutex);
+
+   return queue;
+}
+
+
+struct compress_block_rows_job {
+   struct util_queue_fence fence;
+   compress_block_rows_func func;
+   void *data;
+   unsigned first_row;
+   unsigned num_rows;
+};
+
+static void
+compress_block_rows_job(void *data)
+{
+   struct compress_block_rows_job *job = data;
+
+   job->func(job->data, job->first_row, job->num_rows);
+}
+
+
+/**
+ * Compress \p num_rows rows of blocks by calling \p func on bands of them,
+ * spread over the share group's texture compression threads and the
+ * calling thread.  Every block must only depend on its own texels, and
+ * \p func must not touch anything but its band of the image.
+ */
+void
+_mesa_compress_block_rows(struct gl_context *ctx, unsigned num_rows,
+                          compress_block_rows_func func, void *data)
+{
+   /* Below that, handing the bands to the threads costs more than it saves */
+   const unsigned min_band_rows = 4;
+   struct compress_block_rows_job *jobs;
+   struct util_queue *queue = NULL;
+   unsigned num_bands, band, first_row;
+
+   if (num_rows >= 2 * min_band_rows)
+      queue = get_texture_compress_queue(ctx);
+
+   if (!queue) {
+      func(data, 0, num_rows);
+      return;
+   }
+
+   num_bands = MIN2(queue->num_threads + 1, num_rows / min_band_rows);
+   jobs = malloc(num_bands * sizeof(*jobs));
+   if (!jobs) {
+      func(data, 0, num_rows);
+      return;
+   }
+
+   /* Band 0 is compressed on this thread while the others are queued */
+   first_row = 0;
+   for (band = 0; band < num_bands; band++) {
+      struct compress_block_rows_job *job = &jobs[band];
+
+      job->func = func;
+      job->data = data;
+      job->first_row = first_row;
+      job->num_rows = (num_rows * (band + 1)) / num_bands - first_row;
+      first_row += job->num_rows;
+
+      util_queue_fence_init(&job->fence);
+      if (band > 0)
+         util_queue_add_job(queue, job, &job->fence, compress_block_rows_job);
+   }
+
+   compress_block_rows_job(&jobs[0]);
+
+   for (band = 0; band < num_bands; band++) {
+      util_queue_fence_wait(&jobs[band].fence);
+      util_queue_fence_destroy(&jobs[band].fence);
+   }
+
+   free(jobs);
+}
@@ -57,6 +57,25 @@ typedef void (*compressed_fetch_func)(const GLubyte *map,
 extern compressed_fetch_func
 _mesa_get_compressed_fetch_func(mesa_format format);
 
+/**
+ * A function to decode all the texels of a 4x4 block of a compressed
+ * texture at once, in rows of four
+ */
+typedef void (*compressed_fetch_block_func)(const GLubyte *block,
+                                            GLfloat texels[16][4]);
+
+extern compressed_fetch_block_func
+_mesa_get_compressed_fetch_block_func(mesa_format format);
+
+/** Compresses \p num_rows rows of blocks, starting at \p first_row */
+typedef void (*compress_block_rows_func)(void *data,
+                                         unsigned first_row,
+                                         unsigned num_rows);
+
+extern void
+_mesa_compress_block_rows(struct gl_context *ctx, unsigned num_rows,
+                          compress_block_rows_func func, void *data);
+
 
 extern void
 _mesa_decompress_image(mesa_format format, GLuint width, GLuint height,
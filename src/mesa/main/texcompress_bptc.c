@@ -533,73 +533,93 @@ apply_rotation(int rotation,
    result[3] = t;
 }
 
-static void
-fetch_rgba_unorm_from_block(const uint8_t *block,
-                            uint8_t *result,
-                            int texel)
-{
-   int mode_num = ffs(block[0]);
+/* The part of a unorm block which is the same for all of its texels */
+struct bptc_unorm_block {
    const struct bptc_unorm_mode *mode;
-   int bit_offset, secondary_bit_offset;
    int partition_num;
-   int subset_num;
+   uint32_t subsets;
    int rotation;
    int index_selection;
-   int index_bits;
-   int indices[2];
-   int index;
-   int anchors_before_texel;
-   bool anchor;
+   int index_bit_offset;
    uint8_t endpoints[3 * 2][4];
-   uint32_t subsets;
-   int component;
+};
 
-   if (mode_num == 0) {
-      /* According to the spec this mode is reserved and shouldn't be used. */
-      memset(result, 0, 3);
-      result[3] = 0xff;
-      return;
-   }
+/* Returns false for the reserved mode */
+static bool
+parse_rgba_unorm_block(const uint8_t *block,
+                       struct bptc_unorm_block *parsed)
+{
+   int mode_num = ffs(block[0]);
+   const struct bptc_unorm_mode *mode;
+   int bit_offset;
+
+   if (mode_num == 0)
+      return false;
 
    mode = bptc_unorm_modes + mode_num - 1;
    bit_offset = mode_num;
 
-   partition_num = extract_bits(block, bit_offset, mode->n_partition_bits);
+   parsed->mode = mode;
+   parsed->partition_num = extract_bits(block, bit_offset,
+                                        mode->n_partition_bits);
    bit_offset += mode->n_partition_bits;
 
    switch (mode->n_subsets) {
    case 1:
-      subsets = 0;
+      parsed->subsets = 0;
       break;
    case 2:
-      subsets = partition_table1[partition_num];
+      parsed->subsets = partition_table1[parsed->partition_num];
       break;
    case 3:
-      subsets = partition_table2[partition_num];
+      parsed->subsets = partition_table2[parsed->partition_num];
       break;
    default:
       assert(false);
-      return;
+      return false;
    }
 
    if (mode->has_rotation_bits) {
-      rotation = extract_bits(block, bit_offset, 2);
+      parsed->rotation = extract_bits(block, bit_offset, 2);
       bit_offset += 2;
    } else {
-      rotation = 0;
+      parsed->rotation = 0;
    }
 
    if (mode->has_index_selection_bit) {
-      index_selection = extract_bits(block, bit_offset, 1);
+      parsed->index_selection = extract_bits(block, bit_offset, 1);
       bit_offset++;
    } else {
-      index_selection = 0;
+      parsed->index_selection = 0;
    }
 
-   bit_offset = extract_unorm_endpoints(mode, block, bit_offset, endpoints);
+   parsed->index_bit_offset = extract_unorm_endpoints(mode, block, bit_offset,
+                                                      parsed->endpoints);
+
+   return true;
+}
+
+static void
+fetch_rgba_unorm_texel(const uint8_t *block,
+                       const struct bptc_unorm_block *parsed,
+                       uint8_t *result,
+                       int texel)
+{
+   const struct bptc_unorm_mode *mode = parsed->mode;
+   int bit_offset, secondary_bit_offset;
+   int subset_num;
+   int index_bits;
+   int indices[2];
+   int index;
+   int anchors_before_texel;
+   bool anchor;
+   int component;
+
+   bit_offset = parsed->index_bit_offset;
 
    anchors_before_texel = count_anchors_before_texel(mode->n_subsets,
-                                                     partition_num, texel);
+                                                     parsed->partition_num,
+                                                     texel);
 
    /* Calculate the offset to the secondary index */
    secondary_bit_offset = (bit_offset +
@@ -611,9 +631,9 @@ fetch_rgba_unorm_from_block(const uint8_t *block,
    /* Calculate the offset to the primary index for this texel */
    bit_offset += mode->n_index_bits * texel - anchors_before_texel;
 
-   subset_num = (subsets >> (texel * 2)) & 3;
+   subset_num = (parsed->subsets >> (texel * 2)) & 3;
 
-   anchor = is_anchor(mode->n_subsets, partition_num, texel);
+   anchor = is_anchor(mode->n_subsets, parsed->partition_num, texel);
 
    index_bits = mode->n_index_bits;
    if (anchor)
@@ -627,19 +647,20 @@ fetch_rgba_unorm_from_block(const uint8_t *block,
       indices[1] = extract_bits(block, secondary_bit_offset, index_bits);
    }
 
-   index = indices[index_selection];
-   index_bits = (index_selection ?
+   index = indices[parsed->index_selection];
+   index_bits = (parsed->index_selection ?
                  mode->n_secondary_index_bits :
                  mode->n_index_bits);
 
    for (component = 0; component < 3; component++)
-      result[component] = interpolate(endpoints[subset_num * 2][component],
-                                      endpoints[subset_num * 2 + 1][component],
-                                      index,
-                                      index_bits);
+      result[component] =
+         interpolate(parsed->endpoints[subset_num * 2][component],
+                     parsed->endpoints[subset_num * 2 + 1][component],
+                     index,
+                     index_bits);
 
    /* Alpha uses the opposite index from the color components */
-   if (mode->n_secondary_index_bits && !index_selection) {
+   if (mode->n_secondary_index_bits && !parsed->index_selection) {
       index = indices[1];
       index_bits = mode->n_secondary_index_bits;
    } else {
@@ -647,12 +668,49 @@ fetch_rgba_unorm_from_block(const uint8_t *block,
       index_bits = mode->n_index_bits;
    }
 
-   result[3] = interpolate(endpoints[subset_num * 2][3],
-                           endpoints[subset_num * 2 + 1][3],
+   result[3] = interpolate(parsed->endpoints[subset_num * 2][3],
+                           parsed->endpoints[subset_num * 2 + 1][3],
                            index,
                            index_bits);
 
-   apply_rotation(rotation, result);
+   apply_rotation(parsed->rotation, result);
+}
+
+static void
+fetch_rgba_unorm_from_block(const uint8_t *block,
+                            uint8_t *result,
+                            int texel)
+{
+   struct bptc_unorm_block parsed;
+
+   if (!parse_rgba_unorm_block(block, &parsed)) {
+      /* According to the spec this mode is reserved and shouldn't be used. */
+      memset(result, 0, 3);
+      result[3] = 0xff;
+      return;
+   }
+
+   fetch_rgba_unorm_texel(block, &parsed, result, texel);
+}
+
+/* Decodes all 16 texels of a block, parsing its header only once */
+static void
+decompress_rgba_unorm_block(const uint8_t *block,
+                            uint8_t result[BLOCK_SIZE * BLOCK_SIZE][4])
+{
+   struct bptc_unorm_block parsed;
+   int texel;
+
+   if (!parse_rgba_unorm_block(block, &parsed)) {
+      for (texel = 0; texel < BLOCK_SIZE * BLOCK_SIZE; texel++) {
+         memset(result[texel], 0, 3);
+         result[texel][3] = 0xff;
+      }
+      return;
+   }
+
+   for (texel = 0; texel < BLOCK_SIZE * BLOCK_SIZE; texel++)
+      fetch_rgba_unorm_texel(block, &parsed, result[texel], texel);
 }
 
 static void
@@ -838,25 +896,25 @@ finish_signed_unquantize(int32_t value)
       return value * 31 / 32;
 }
 
-static void
-fetch_rgb_float_from_block(const uint8_t *block,
-                           float *result,
-                           int texel,
-                           bool is_signed)
-{
-   int mode_num;
+/* The part of a float block which is the same for all of its texels */
+struct bptc_float_block {
    const struct bptc_float_mode *mode;
-   int bit_offset;
    int partition_num;
-   int subset_num;
-   int index_bits;
-   int index;
-   int anchors_before_texel;
-   int32_t endpoints[2 * 2][3];
    uint32_t subsets;
    int n_subsets;
-   int component;
-   int32_t value;
+   int index_bit_offset;
+   int32_t endpoints[2 * 2][3];
+};
+
+/* Returns false for the reserved modes */
+static bool
+parse_rgb_float_block(const uint8_t *block,
+                      struct bptc_float_block *parsed,
+                      bool is_signed)
+{
+   int mode_num;
+   const struct bptc_float_mode *mode;
+   int bit_offset;
 
    if (block[0] & 0x2) {
       mode_num = (((block[0] >> 1) & 0xe) | (block[0] & 1)) + 2;
@@ -868,43 +926,66 @@ fetch_rgb_float_from_block(const uint8_t *block,
 
    mode = bptc_float_modes + mode_num;
 
-   if (mode->reserved) {
-      memset(result, 0, sizeof result[0] * 3);
-      result[3] = 1.0f;
-      return;
-   }
+   if (mode->reserved)
+      return false;
+
+   parsed->mode = mode;
 
    bit_offset = extract_float_endpoints(mode, block, bit_offset,
-                                        endpoints, is_signed);
+                                        parsed->endpoints, is_signed);
 
    if (mode->n_partition_bits) {
-      partition_num = extract_bits(block, bit_offset, mode->n_partition_bits);
+      parsed->partition_num = extract_bits(block, bit_offset,
+                                           mode->n_partition_bits);
       bit_offset += mode->n_partition_bits;
 
-      subsets = partition_table1[partition_num];
-      n_subsets = 2;
+      parsed->subsets = partition_table1[parsed->partition_num];
+      parsed->n_subsets = 2;
    } else {
-      partition_num = 0;
-      subsets = 0;
-      n_subsets = 1;
+      parsed->partition_num = 0;
+      parsed->subsets = 0;
+      parsed->n_subsets = 1;
    }
 
+   parsed->index_bit_offset = bit_offset;
+
+   return true;
+}
+
+static void
+fetch_rgb_float_texel(const uint8_t *block,
+                      const struct bptc_float_block *parsed,
+                      float *result,
+                      int texel,
+                      bool is_signed)
+{
+   const struct bptc_float_mode *mode = parsed->mode;
+   int bit_offset;
+   int subset_num;
+   int index_bits;
+   int index;
+   int anchors_before_texel;
+   int component;
+   int32_t value;
+
    anchors_before_texel =
-      count_anchors_before_texel(n_subsets, partition_num, texel);
+      count_anchors_before_texel(parsed->n_subsets, parsed->partition_num,
+                                 texel);
 
    /* Calculate the offset to the primary index for this texel */
-   bit_offset += mode->n_index_bits * texel - anchors_before_texel;
+   bit_offset = (parsed->index_bit_offset +
+                 mode->n_index_bits * texel - anchors_before_texel);
 
-   subset_num = (subsets >> (texel * 2)) & 3;
+   subset_num = (parsed->subsets >> (texel * 2)) & 3;
 
    index_bits = mode->n_index_bits;
-   if (is_anchor(n_subsets, partition_num, texel))
+   if (is_anchor(parsed->n_subsets, parsed->partition_num, texel))
       index_bits--;
    index = extract_bits(block, bit_offset, index_bits);
 
    for (component = 0; component < 3; component++) {
-      value = interpolate(endpoints[subset_num * 2][component],
-                          endpoints[subset_num * 2 + 1][component],
+      value = interpolate(parsed->endpoints[subset_num * 2][component],
+                          parsed->endpoints[subset_num * 2 + 1][component],
                           index,
                           mode->n_index_bits);
 
@@ -919,6 +1000,44 @@ fetch_rgb_float_from_block(const uint8_t *block,
    result[3] = 1.0f;
 }
 
+static void
+fetch_rgb_float_from_block(const uint8_t *block,
+                           float *result,
+                           int texel,
+                           bool is_signed)
+{
+   struct bptc_float_block parsed;
+
+   if (!parse_rgb_float_block(block, &parsed, is_signed)) {
+      memset(result, 0, sizeof result[0] * 3);
+      result[3] = 1.0f;
+      return;
+   }
+
+   fetch_rgb_float_texel(block, &parsed, result, texel, is_signed);
+}
+
+/* Decodes all 16 texels of a block, parsing its header only once */
+static void
+decompress_rgb_float_block(const uint8_t *block,
+                           float result[BLOCK_SIZE * BLOCK_SIZE][4],
+                           bool is_signed)
+{
+   struct bptc_float_block parsed;
+   int texel;
+
+   if (!parse_rgb_float_block(block, &parsed, is_signed)) {
+      for (texel = 0; texel < BLOCK_SIZE * BLOCK_SIZE; texel++) {
+         memset(result[texel], 0, sizeof result[texel][0] * 3);
+         result[texel][3] = 1.0f;
+      }
+      return;
+   }
+
+   for (texel = 0; texel < BLOCK_SIZE * BLOCK_SIZE; texel++)
+      fetch_rgb_float_texel(block, &parsed, result[texel], texel, is_signed);
+}
+
 static void
 fetch_bptc_rgb_float(const GLubyte *map,
                      GLint rowStride, GLint i, GLint j,
@@ -965,6 +1084,73 @@ _mesa_get_bptc_fetch_func(mesa_format format)
    }
 }
 
+static void
+fetch_bptc_rgba_unorm_block(const GLubyte *block, GLfloat texels[16][4])
+{
+   uint8_t texel_bytes[BLOCK_SIZE * BLOCK_SIZE][4];
+   int i;
+
+   decompress_rgba_unorm_block(block, texel_bytes);
+
+   for (i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++) {
+      texels[i][RCOMP] = UBYTE_TO_FLOAT(texel_bytes[i][0]);
+      texels[i][GCOMP] = UBYTE_TO_FLOAT(texel_bytes[i][1]);
+      texels[i][BCOMP] = UBYTE_TO_FLOAT(texel_bytes[i][2]);
+      texels[i][ACOMP] = UBYTE_TO_FLOAT(texel_bytes[i][3]);
+   }
+}
+
+static void
+fetch_bptc_srgb_alpha_unorm_block(const GLubyte *block,
+                                  GLfloat texels[16][4])
+{
+   uint8_t texel_bytes[BLOCK_SIZE * BLOCK_SIZE][4];
+   int i;
+
+   decompress_rgba_unorm_block(block, texel_bytes);
+
+   for (i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++) {
+      texels[i][RCOMP] =
+         util_format_srgb_8unorm_to_linear_float(texel_bytes[i][0]);
+      texels[i][GCOMP] =
+         util_format_srgb_8unorm_to_linear_float(texel_bytes[i][1]);
+      texels[i][BCOMP] =
+         util_format_srgb_8unorm_to_linear_float(texel_bytes[i][2]);
+      texels[i][ACOMP] = UBYTE_TO_FLOAT(texel_bytes[i][3]);
+   }
+}
+
+static void
+fetch_bptc_rgb_signed_float_block(const GLubyte *block,
+                                  GLfloat texels[16][4])
+{
+   decompress_rgb_float_block(block, texels, true);
+}
+
+static void
+fetch_bptc_rgb_unsigned_float_block(const GLubyte *block,
+                                    GLfloat texels[16][4])
+{
+   decompress_rgb_float_block(block, texels, false);
+}
+
+compressed_fetch_block_func
+_mesa_get_bptc_fetch_block_func(mesa_format format)
+{
+   switch (format) {
+   case MESA_FORMAT_BPTC_RGBA_UNORM:
+      return fetch_bptc_rgba_unorm_block;
+   case MESA_FORMAT_BPTC_SRGB_ALPHA_UNORM:
+      return fetch_bptc_srgb_alpha_unorm_block;
+   case MESA_FORMAT_BPTC_RGB_SIGNED_FLOAT:
+      return fetch_bptc_rgb_signed_float_block;
+   case MESA_FORMAT_BPTC_RGB_UNSIGNED_FLOAT:
+      return fetch_bptc_rgb_unsigned_float_block;
+   default:
+      return NULL;
+   }
+}
+
 static void
 write_bits(struct bit_writer *writer, int n_bits, int value)
 {
@@ -1271,12 +1457,52 @@ compress_rgba_unorm(int width, int height,
    }
 }
 
+/* A band of rows of blocks to compress on one of the texture compression
+ * threads
+ */
+struct compress_job {
+   int width, height;
+   const uint8_t *src;
+   int src_rowstride;
+   uint8_t *dst;
+   int dst_rowstride;
+   bool is_signed;
+};
+
+/* The distance from one row of blocks to the next in the destination, as
+ * compress_rgba_unorm() and compress_rgb_float() step through them.
+ */
+static int
+dst_block_row_stride(int width, int dst_rowstride)
+{
+   if (dst_rowstride >= width * 4)
+      return dst_rowstride;
+   else
+      return ((width + 3) & ~3) * 4;
+}
+
+static void
+compress_rgba_unorm_rows(void *data, unsigned first_row, unsigned num_rows)
+{
+   const struct compress_job *job = data;
+   const int y = first_row * BLOCK_SIZE;
+
+   compress_rgba_unorm(job->width,
+                       MIN2(job->height - y, (int) num_rows * BLOCK_SIZE),
+                       job->src + y * job->src_rowstride,
+                       job->src_rowstride,
+                       job->dst + first_row *
+                       dst_block_row_stride(job->width, job->dst_rowstride),
+                       job->dst_rowstride);
+}
+
 GLboolean
 _mesa_texstore_bptc_rgba_unorm(TEXSTORE_PARAMS)
 {
    const GLubyte *pixels;
    const GLubyte *tempImage = NULL;
    int rowstride;
+   struct compress_job job;
 
    if (srcFormat != GL_RGBA ||
        srcType != GL_UNSIGNED_BYTE ||
@@ -1306,9 +1532,14 @@ _mesa_texstore_bptc_rgba_unorm(TEXSTORE_PARAMS)
                                          srcFormat, srcType);
    }
 
-   compress_rgba_unorm(srcWidth, srcHeight,
-                       pixels, rowstride,
-                       dstSlices[0], dstRowStride);
+   job.width = srcWidth;
+   job.height = srcHeight;
+   job.src = pixels;
+   job.src_rowstride = rowstride;
+   job.dst = dstSlices[0];
+   job.dst_rowstride = dstRowStride;
+   _mesa_compress_block_rows(ctx, (srcHeight + BLOCK_SIZE - 1) / BLOCK_SIZE,
+                             compress_rgba_unorm_rows, &job);
 
    free((void *) tempImage);
 
@@ -1581,6 +1812,22 @@ compress_rgb_float(int width, int height,
    }
 }
 
+static void
+compress_rgb_float_rows(void *data, unsigned first_row, unsigned num_rows)
+{
+   const struct compress_job *job = data;
+   const int y = first_row * BLOCK_SIZE;
+
+   compress_rgb_float(job->width,
+                      MIN2(job->height - y, (int) num_rows * BLOCK_SIZE),
+                      (const float *) (job->src + y * job->src_rowstride),
+                      job->src_rowstride,
+                      job->dst + first_row *
+                      dst_block_row_stride(job->width, job->dst_rowstride),
+                      job->dst_rowstride,
+                      job->is_signed);
+}
+
 static GLboolean
 texstore_bptc_rgb_float(TEXSTORE_PARAMS,
                         bool is_signed)
@@ -1588,6 +1835,7 @@ texstore_bptc_rgb_float(TEXSTORE_PARAMS,
    const float *pixels;
    const float *tempImage = NULL;
    int rowstride;
+   struct compress_job job;
 
    if (srcFormat != GL_RGB ||
        srcType != GL_FLOAT ||
@@ -1617,10 +1865,15 @@ texstore_bptc_rgb_float(TEXSTORE_PARAMS,
                                          srcFormat, srcType);
    }
 
-   compress_rgb_float(srcWidth, srcHeight,
-                      pixels, rowstride,
-                      dstSlices[0], dstRowStride,
-                      is_signed);
+   job.width = srcWidth;
+   job.height = srcHeight;
+   job.src = (const uint8_t *) pixels;
+   job.src_rowstride = rowstride;
+   job.dst = dstSlices[0];
+   job.dst_rowstride = dstRowStride;
+   job.is_signed = is_signed;
+   _mesa_compress_block_rows(ctx, (srcHeight + BLOCK_SIZE - 1) / BLOCK_SIZE,
+                             compress_rgb_float_rows, &job);
 
    free((void *) tempImage);
 
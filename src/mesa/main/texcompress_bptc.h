@@ -41,4 +41,7 @@ _mesa_texstore_bptc_rgb_unsigned_float(TEXSTORE_PARAMS);
 compressed_fetch_func
 _mesa_get_bptc_fetch_func(mesa_format format);
 
+compressed_fetch_block_func
+_mesa_get_bptc_fetch_block_func(mesa_format format);
+
 #endif
@@ -1511,3 +1511,219 @@ _mesa_get_etc_fetch_func(mesa_format format)
       return NULL;
    }
 }
+
+
+/*
+ * The block fetch functions below parse the block once for all of its 16
+ * texels, which the texel fetch functions above do for every texel.
+ */
+
+static void
+fetch_etc1_rgb8_block(const GLubyte *src, GLfloat texels[16][4])
+{
+   struct etc1_block block;
+   GLubyte dst[3];
+   int x, y;
+
+   etc1_parse_block(&block, src);
+
+   for (y = 0; y < 4; y++) {
+      for (x = 0; x < 4; x++) {
+         GLfloat *texel = texels[y * 4 + x];
+
+         etc1_fetch_texel(&block, x, y, dst);
+
+         texel[RCOMP] = UBYTE_TO_FLOAT(dst[0]);
+         texel[GCOMP] = UBYTE_TO_FLOAT(dst[1]);
+         texel[BCOMP] = UBYTE_TO_FLOAT(dst[2]);
+         texel[ACOMP] = 1.0f;
+      }
+   }
+}
+
+static void
+fetch_etc2_rgb8_block_common(const GLubyte *src, GLfloat texels[16][4],
+                             bool srgb, bool punchthrough_alpha)
+{
+   struct etc2_block block;
+   uint8_t dst[4];
+   int x, y;
+
+   etc2_rgb8_parse_block(&block, src, punchthrough_alpha);
+
+   for (y = 0; y < 4; y++) {
+      for (x = 0; x < 4; x++) {
+         GLfloat *texel = texels[y * 4 + x];
+
+         etc2_rgb8_fetch_texel(&block, x, y, dst, punchthrough_alpha);
+
+         if (srgb) {
+            texel[RCOMP] = util_format_srgb_8unorm_to_linear_float(dst[0]);
+            texel[GCOMP] = util_format_srgb_8unorm_to_linear_float(dst[1]);
+            texel[BCOMP] = util_format_srgb_8unorm_to_linear_float(dst[2]);
+         } else {
+            texel[RCOMP] = UBYTE_TO_FLOAT(dst[0]);
+            texel[GCOMP] = UBYTE_TO_FLOAT(dst[1]);
+            texel[BCOMP] = UBYTE_TO_FLOAT(dst[2]);
+         }
+         texel[ACOMP] = punchthrough_alpha ? UBYTE_TO_FLOAT(dst[3]) : 1.0f;
+      }
+   }
+}
+
+static void
+fetch_etc2_rgba8_eac_block_common(const GLubyte *src, GLfloat texels[16][4],
+                                  bool srgb)
+{
+   struct etc2_block block;
+   uint8_t dst[4];
+   int x, y;
+
+   etc2_rgba8_parse_block(&block, src);
+
+   for (y = 0; y < 4; y++) {
+      for (x = 0; x < 4; x++) {
+         GLfloat *texel = texels[y * 4 + x];
+
+         etc2_rgba8_fetch_texel(&block, x, y, dst);
+
+         if (srgb) {
+            texel[RCOMP] = util_format_srgb_8unorm_to_linear_float(dst[0]);
+            texel[GCOMP] = util_format_srgb_8unorm_to_linear_float(dst[1]);
+            texel[BCOMP] = util_format_srgb_8unorm_to_linear_float(dst[2]);
+         } else {
+            texel[RCOMP] = UBYTE_TO_FLOAT(dst[0]);
+            texel[GCOMP] = UBYTE_TO_FLOAT(dst[1]);
+            texel[BCOMP] = UBYTE_TO_FLOAT(dst[2]);
+         }
+         texel[ACOMP] = UBYTE_TO_FLOAT(dst[3]);
+      }
+   }
+}
+
+/* R11 and RG11, with one 8 byte block per component */
+static void
+fetch_etc2_r11_eac_block_common(const GLubyte *src, GLfloat texels[16][4],
+                                int num_components, bool is_signed)
+{
+   struct etc2_block block;
+   int x, y, c;
+
+   for (y = 0; y < 16; y++) {
+      texels[y][GCOMP] = 0.0f;
+      texels[y][BCOMP] = 0.0f;
+      texels[y][ACOMP] = 1.0f;
+   }
+
+   for (c = 0; c < num_components; c++) {
+      etc2_r11_parse_block(&block, src + c * 8);
+
+      for (y = 0; y < 4; y++) {
+         for (x = 0; x < 4; x++) {
+            GLushort dst;
+
+            if (is_signed) {
+               etc2_signed_r11_fetch_texel(&block, x, y, (uint8_t *)&dst);
+               texels[y * 4 + x][c] = SHORT_TO_FLOAT(dst);
+            } else {
+               etc2_r11_fetch_texel(&block, x, y, (uint8_t *)&dst);
+               texels[y * 4 + x][c] = USHORT_TO_FLOAT(dst);
+            }
+         }
+      }
+   }
+}
+
+static void
+fetch_etc2_rgb8_block(const GLubyte *src, GLfloat texels[16][4])
+{
+   fetch_etc2_rgb8_block_common(src, texels, false, false);
+}
+
+static void
+fetch_etc2_srgb8_block(const GLubyte *src, GLfloat texels[16][4])
+{
+   fetch_etc2_rgb8_block_common(src, texels, true, false);
+}
+
+static void
+fetch_etc2_rgba8_eac_block(const GLubyte *src, GLfloat texels[16][4])
+{
+   fetch_etc2_rgba8_eac_block_common(src, texels, false);
+}
+
+static void
+fetch_etc2_srgb8_alpha8_eac_block(const GLubyte *src, GLfloat texels[16][4])
+{
+   fetch_etc2_rgba8_eac_block_common(src, texels, true);
+}
+
+static void
+fetch_etc2_r11_eac_block(const GLubyte *src, GLfloat texels[16][4])
+{
+   fetch_etc2_r11_eac_block_common(src, texels, 1, false);
+}
+
+static void
+fetch_etc2_rg11_eac_block(const GLubyte *src, GLfloat texels[16][4])
+{
+   fetch_etc2_r11_eac_block_common(src, texels, 2, false);
+}
+
+static void
+fetch_etc2_signed_r11_eac_block(const GLubyte *src, GLfloat texels[16][4])
+{
+   fetch_etc2_r11_eac_block_common(src, texels, 1, true);
+}
+
+static void
+fetch_etc2_signed_rg11_eac_block(const GLubyte *src, GLfloat texels[16][4])
+{
+   fetch_etc2_r11_eac_block_common(src, texels, 2, true);
+}
+
+static void
+fetch_etc2_rgb8_punchthrough_alpha1_block(const GLubyte *src,
+                                          GLfloat texels[16][4])
+{
+   fetch_etc2_rgb8_block_common(src, texels, false, true);
+}
+
+static void
+fetch_etc2_srgb8_punchthrough_alpha1_block(const GLubyte *src,
+                                           GLfloat texels[16][4])
+{
+   fetch_etc2_rgb8_block_common(src, texels, true, true);
+}
+
+
+compressed_fetch_block_func
+_mesa_get_etc_fetch_block_func(mesa_format format)
+{
+   switch (format) {
+   case MESA_FORMAT_ETC1_RGB8:
+      return fetch_etc1_rgb8_block;
+   case MESA_FORMAT_ETC2_RGB8:
+      return fetch_etc2_rgb8_block;
+   case MESA_FORMAT_ETC2_SRGB8:
+      return fetch_etc2_srgb8_block;
+   case MESA_FORMAT_ETC2_RGBA8_EAC:
+      return fetch_etc2_rgba8_eac_block;
+   case MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC:
+      return fetch_etc2_srgb8_alpha8_eac_block;
+   case MESA_FORMAT_ETC2_R11_EAC:
+      return fetch_etc2_r11_eac_block;
+   case MESA_FORMAT_ETC2_RG11_EAC:
+      return fetch_etc2_rg11_eac_block;
+   case MESA_FORMAT_ETC2_SIGNED_R11_EAC:
+      return fetch_etc2_signed_r11_eac_block;
+   case MESA_FORMAT_ETC2_SIGNED_RG11_EAC:
+      return fetch_etc2_signed_rg11_eac_block;
+   case MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1:
+      return fetch_etc2_rgb8_punchthrough_alpha1_block;
+   case MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1:
+      return fetch_etc2_srgb8_punchthrough_alpha1_block;
+   default:
+      return NULL;
+   }
+}
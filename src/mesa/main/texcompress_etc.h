@@ -82,4 +82,7 @@ _mesa_unpack_etc2_format(uint8_t *dst_row,
 compressed_fetch_func
 _mesa_get_etc_fetch_func(mesa_format format);
 
+compressed_fetch_block_func
+_mesa_get_etc_fetch_block_func(mesa_format format);
+
 #endif
@@ -254,6 +254,12 @@ _mesa_TexSubImage1D( GLenum target, GLint level, GLint xoffset,
                      GLenum format, GLenum type,
                      const GLvoid *pixels );
 
+extern void GLAPIENTRY
+_mesa_TexSubImage1D_no_error( GLenum target, GLint level, GLint xoffset,
+                              GLsizei width,
+                              GLenum format, GLenum type,
+                              const GLvoid *pixels );
+
 
 extern void GLAPIENTRY
 _mesa_TexSubImage2D( GLenum target, GLint level,
@@ -262,6 +268,13 @@ _mesa_TexSubImage2D( GLenum target, GLint level,
                      GLenum format, GLenum type,
                      const GLvoid *pixels );
 
+extern void GLAPIENTRY
+_mesa_TexSubImage2D_no_error( GLenum target, GLint level,
+                              GLint xoffset, GLint yoffset,
+                              GLsizei width, GLsizei height,
+                              GLenum format, GLenum type,
+                              const GLvoid *pixels );
+
 
 extern void GLAPIENTRY
 _mesa_TexSubImage3D( GLenum target, GLint level,
@@ -270,6 +283,13 @@ _mesa_TexSubImage3D( GLenum target, GLint level,
                      GLenum format, GLenum type,
                      const GLvoid *pixels );
 
+extern void GLAPIENTRY
+_mesa_TexSubImage3D_no_error( GLenum target, GLint level,
+                              GLint xoffset, GLint yoffset, GLint zoffset,
+                              GLsizei width, GLsizei height, GLsizei depth,
+                              GLenum format, GLenum type,
+                              const GLvoid *pixels );
+
 extern void GLAPIENTRY
 _mesa_TextureSubImage1D(GLuint texture, GLint level, GLint xoffset,
                         GLsizei width,
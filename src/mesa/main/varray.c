@@ -247,6 +247,41 @@ get_legal_types_mask(const struct gl_context *ctx)
 }
 
 
+/**
+ * Store the format of the vertex attribute given by attrib, after error
+ * checking has been done.  Size is 1, 2, 3 or 4; GL_BGRA has already been
+ * turned into format = GL_BGRA and size = 4.
+ */
+static void
+set_array_format(struct gl_context *ctx,
+                 struct gl_vertex_array_object *vao,
+                 GLuint attrib, GLint size, GLenum type, GLenum format,
+                 GLboolean normalized, GLboolean integer, GLboolean doubles,
+                 GLuint relativeOffset)
+{
+   struct gl_vertex_attrib_array *array;
+   GLint elementSize;
+
+   assert(size <= 4);
+
+   elementSize = _mesa_bytes_per_vertex_attrib(size, type);
+   assert(elementSize != -1);
+
+   array = &vao->VertexAttrib[attrib];
+   array->Size = size;
+   array->Type = type;
+   array->Format = format;
+   array->Normalized = normalized;
+   array->Integer = integer;
+   array->Doubles = doubles;
+   array->RelativeOffset = relativeOffset;
+   array->_ElementSize = elementSize;
+
+   vao->NewArrays |= VERT_BIT(attrib);
+   ctx->NewState |= _NEW_ARRAY;
+}
+
+
 /**
  * Does error checking and updates the format in an attrib array.
  *
@@ -274,9 +309,7 @@ update_array_format(struct gl_context *ctx,
                     GLboolean normalized, GLboolean integer, GLboolean doubles,
                     GLuint relativeOffset)
 {
-   struct gl_vertex_attrib_array *array;
    GLbitfield typeBit;
-   GLint elementSize;
    GLenum format = GL_RGBA;
 
    if (ctx->Array.LegalTypesMask == 0 || ctx->Array.LegalTypesMaskAPI != ctx->API) {
@@ -377,25 +410,37 @@ update_array_format(struct gl_context *ctx,
       return false;
    }
 
-   assert(size <= 4);
+   set_array_format(ctx, vao, attrib, size, type, format,
+                    normalized, integer, doubles, relativeOffset);
 
-   elementSize = _mesa_bytes_per_vertex_attrib(size, type);
-   assert(elementSize != -1);
+   return true;
+}
 
-   array = &vao->VertexAttrib[attrib];
-   array->Size = size;
-   array->Type = type;
-   array->Format = format;
-   array->Normalized = normalized;
-   array->Integer = integer;
-   array->Doubles = doubles;
-   array->RelativeOffset = relativeOffset;
-   array->_ElementSize = elementSize;
 
-   vao->NewArrays |= VERT_BIT(attrib);
-   ctx->NewState |= _NEW_ARRAY;
+/**
+ * Point the attribute array given by attrib at ptr in the current
+ * GL_ARRAY_BUFFER, after error checking and set_array_format() have been
+ * done.
+ */
+static void
+set_array_pointer(struct gl_context *ctx, GLuint attrib, GLsizei stride,
+                  const GLvoid *ptr)
+{
+   struct gl_vertex_attrib_array *array;
+   GLsizei effectiveStride;
 
-   return true;
+   /* Reset the vertex attrib binding */
+   vertex_attrib_binding(ctx, ctx->Array.VAO, attrib, attrib);
+
+   /* The Stride and Ptr fields are not set by set_array_format() */
+   array = &ctx->Array.VAO->VertexAttrib[attrib];
+   array->Stride = stride;
+   array->Ptr = (const GLvoid *) ptr;
+
+   /* Update the vertex buffer binding */
+   effectiveStride = stride != 0 ? stride : array->_ElementSize;
+   bind_vertex_buffer(ctx, ctx->Array.VAO, attrib, ctx->Array.ArrayBufferObj,
+                      (GLintptr) ptr, effectiveStride);
 }
 
 
@@ -425,9 +470,6 @@ update_array(struct gl_context *ctx,
              GLboolean normalized, GLboolean integer, GLboolean doubles,
              const GLvoid *ptr)
 {
-   struct gl_vertex_attrib_array *array;
-   GLsizei effectiveStride;
-
    /* Page 407 (page 423 of the PDF) of the OpenGL 3.0 spec says:
     *
     *     "Client vertex arrays - all vertex array attribute pointers must
@@ -481,18 +523,7 @@ update_array(struct gl_context *ctx,
       return;
    }
 
-   /* Reset the vertex attrib binding */
-   vertex_attrib_binding(ctx, ctx->Array.VAO, attrib, attrib);
-
-   /* The Stride and Ptr fields are not set by update_array_format() */
-   array = &ctx->Array.VAO->VertexAttrib[attrib];
-   array->Stride = stride;
-   array->Ptr = (const GLvoid *) ptr;
-
-   /* Update the vertex buffer binding */
-   effectiveStride = stride != 0 ? stride : array->_ElementSize;
-   bind_vertex_buffer(ctx, ctx->Array.VAO, attrib, ctx->Array.ArrayBufferObj,
-                      (GLintptr) ptr, effectiveStride);
+   set_array_pointer(ctx, attrib, stride, ptr);
 }
 
 
@@ -695,6 +726,29 @@ _mesa_VertexAttribPointer(GLuint index, GLint size, GLenum type,
 }
 
 
+/**
+ * glVertexAttribPointer() for contexts created with
+ * GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR.
+ */
+void GLAPIENTRY
+_mesa_VertexAttribPointer_no_error(GLuint index, GLint size, GLenum type,
+                                   GLboolean normalized,
+                                   GLsizei stride, const GLvoid *ptr)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   GLenum format = GL_RGBA;
+
+   if (size == GL_BGRA) {
+      format = GL_BGRA;
+      size = 4;
+   }
+
+   set_array_format(ctx, ctx->Array.VAO, VERT_ATTRIB_GENERIC(index),
+                    size, type, format, normalized, GL_FALSE, GL_FALSE, 0);
+   set_array_pointer(ctx, VERT_ATTRIB_GENERIC(index), stride, ptr);
+}
+
+
 /**
  * GL_EXT_gpu_shader4 / GL 3.0.
  * Set an integer-valued vertex attribute array.
@@ -740,16 +794,10 @@ _mesa_VertexAttribLPointer(GLuint index, GLint size, GLenum type,
 
 
 static void
-enable_vertex_array_attrib(struct gl_context *ctx,
-                           struct gl_vertex_array_object *vao,
-                           GLuint index,
-                           const char *func)
+enable_vertex_array_attrib_no_error(struct gl_context *ctx,
+                                    struct gl_vertex_array_object *vao,
+                                    GLuint index)
 {
-   if (index >= ctx->Const.Program[MESA_SHADER_VERTEX].MaxAttribs) {
-      _mesa_error(ctx, GL_INVALID_VALUE, "%s(index)", func);
-      return;
-   }
-
    assert(VERT_ATTRIB_GENERIC(index) < ARRAY_SIZE(vao->VertexAttrib));
 
    if (!vao->VertexAttrib[VERT_ATTRIB_GENERIC(index)].Enabled) {
@@ -762,6 +810,21 @@ enable_vertex_array_attrib(struct gl_context *ctx,
 }
 
 
+static void
+enable_vertex_array_attrib(struct gl_context *ctx,
+                           struct gl_vertex_array_object *vao,
+                           GLuint index,
+                           const char *func)
+{
+   if (index >= ctx->Const.Program[MESA_SHADER_VERTEX].MaxAttribs) {
+      _mesa_error(ctx, GL_INVALID_VALUE, "%s(index)", func);
+      return;
+   }
+
+   enable_vertex_array_attrib_no_error(ctx, vao, index);
+}
+
+
 void GLAPIENTRY
 _mesa_EnableVertexAttribArray(GLuint index)
 {
@@ -771,6 +834,14 @@ _mesa_EnableVertexAttribArray(GLuint index)
 }
 
 
+void GLAPIENTRY
+_mesa_EnableVertexAttribArray_no_error(GLuint index)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   enable_vertex_array_attrib_no_error(ctx, ctx->Array.VAO, index);
+}
+
+
 void GLAPIENTRY
 _mesa_EnableVertexArrayAttrib(GLuint vaobj, GLuint index)
 {
@@ -793,16 +864,10 @@ _mesa_EnableVertexArrayAttrib(GLuint vaobj, GLuint index)
 
 
 static void
-disable_vertex_array_attrib(struct gl_context *ctx,
-                            struct gl_vertex_array_object *vao,
-                            GLuint index,
-                            const char *func)
+disable_vertex_array_attrib_no_error(struct gl_context *ctx,
+                                     struct gl_vertex_array_object *vao,
+                                     GLuint index)
 {
-   if (index >= ctx->Const.Program[MESA_SHADER_VERTEX].MaxAttribs) {
-      _mesa_error(ctx, GL_INVALID_VALUE, "%s(index)", func);
-      return;
-   }
-
    assert(VERT_ATTRIB_GENERIC(index) < ARRAY_SIZE(vao->VertexAttrib));
 
    if (vao->VertexAttrib[VERT_ATTRIB_GENERIC(index)].Enabled) {
@@ -815,6 +880,21 @@ disable_vertex_array_attrib(struct gl_context *ctx,
 }
 
 
+static void
+disable_vertex_array_attrib(struct gl_context *ctx,
+                            struct gl_vertex_array_object *vao,
+                            GLuint index,
+                            const char *func)
+{
+   if (index >= ctx->Const.Program[MESA_SHADER_VERTEX].MaxAttribs) {
+      _mesa_error(ctx, GL_INVALID_VALUE, "%s(index)", func);
+      return;
+   }
+
+   disable_vertex_array_attrib_no_error(ctx, vao, index);
+}
+
+
 void GLAPIENTRY
 _mesa_DisableVertexAttribArray(GLuint index)
 {
@@ -824,6 +904,14 @@ _mesa_DisableVertexAttribArray(GLuint index)
 }
 
 
+void GLAPIENTRY
+_mesa_DisableVertexAttribArray_no_error(GLuint index)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   disable_vertex_array_attrib_no_error(ctx, ctx->Array.VAO, index);
+}
+
+
 void GLAPIENTRY
 _mesa_DisableVertexArrayAttrib(GLuint vaobj, GLuint index)
 {
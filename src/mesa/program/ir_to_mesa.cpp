@@ -41,6 +41,7 @@
 #include "ir_optimization.h"
 #include "ast.h"
 #include "linker.h"
+#include "shader_cache.h"
 
 #include "main/mtypes.h"
 #include "main/shaderapi.h"
@@ -2951,27 +2952,12 @@ _mesa_ir_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
 }
 
 /**
- * Link a GLSL shader program.  Called via glLinkProgram().
+ * Let the driver link \c prog once the linker or the program binary has set
+ * up its linked shaders.
  */
 void
-_mesa_glsl_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
+_mesa_glsl_finish_link(struct gl_context *ctx, struct gl_shader_program *prog)
 {
-   unsigned int i;
-
-   _mesa_clear_shader_program_data(prog);
-
-   prog->LinkStatus = GL_TRUE;
-
-   for (i = 0; i < prog->NumShaders; i++) {
-      if (!prog->Shaders[i]->CompileStatus) {
-	 linker_error(prog, "linking with uncompiled shader");
-      }
-   }
-
-   if (prog->LinkStatus) {
-      link_shaders(ctx, prog);
-   }
-
    if (prog->LinkStatus) {
       if (!ctx->Driver.LinkShader(ctx, prog)) {
 	 prog->LinkStatus = GL_FALSE;
@@ -2992,4 +2978,100 @@ _mesa_glsl_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
    }
 }
 
+/**
+ * Free the result of the previous link of \c prog, including the driver's
+ * programs, which must be done on the thread of \c ctx.
+ */
+void
+_mesa_glsl_prepare_link(struct gl_context *ctx, struct gl_shader_program *prog)
+{
+   _mesa_clear_shader_program_data(prog);
+
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      if (prog->_LinkedShaders[i] != NULL) {
+         ctx->Driver.DeleteShader(ctx, prog->_LinkedShaders[i]);
+         prog->_LinkedShaders[i] = NULL;
+      }
+   }
+}
+
+/**
+ * Set up the linked shaders of \c prog, from the cache or by linking its
+ * attached shaders, with the GLSL_x \c flags.
+ *
+ * This only touches \c prog and the attached shaders, and only reads
+ * constant state of \c ctx, so it may run on another thread once
+ * _mesa_glsl_prepare_link() was called.
+ */
+void
+_mesa_glsl_run_linker(struct gl_context *ctx, struct gl_shader_program *prog,
+                      GLbitfield flags)
+{
+   unsigned int i;
+
+   prog->LinkStatus = GL_TRUE;
+
+   for (i = 0; i < prog->NumShaders; i++) {
+      if (!prog->Shaders[i]->CompileStatus) {
+	 linker_error(prog, "linking with uncompiled shader");
+      }
+   }
+
+   if (prog->LinkStatus && !_mesa_glsl_cache_load_program(ctx, prog, flags)) {
+      /* Compile the shaders whose compilation the cache skipped. */
+      for (i = 0; i < prog->NumShaders; i++) {
+         if (prog->Shaders[i]->FallbackSource) {
+            _mesa_glsl_compile_shader(ctx, prog->Shaders[i], false, false,
+                                      true, flags);
+            if (!prog->Shaders[i]->CompileStatus)
+               linker_error(prog, "linking with uncompiled shader");
+         }
+      }
+
+      if (prog->LinkStatus)
+         link_shaders(ctx, prog);
+
+      if (prog->LinkStatus) {
+         /* The driver lowers the linked IR in place, so the binary can't be
+          * made later, when it is asked for.  Only pay for it when the
+          * application said it will be.
+          */
+         if (prog->BinaryRetreivableHint)
+            _mesa_glsl_save_program_binary(ctx, prog);
+         _mesa_glsl_cache_store_program(ctx, prog, flags);
+      }
+   }
+}
+
+/**
+ * Link a GLSL shader program.  Called via glLinkProgram().
+ */
+void
+_mesa_glsl_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
+{
+   _mesa_glsl_prepare_link(ctx, prog);
+   _mesa_glsl_run_linker(ctx, prog, ctx->_Shader->Flags);
+   _mesa_glsl_finish_link(ctx, prog);
+}
+
+/**
+ * Load a GLSL shader program from a binary.  Called via glProgramBinary().
+ */
+void
+_mesa_glsl_program_binary(struct gl_context *ctx,
+                          struct gl_shader_program *prog,
+                          const GLvoid *binary, GLsizei length)
+{
+   _mesa_clear_shader_program_data(prog);
+
+   prog->LinkStatus = GL_TRUE;
+
+   if (!_mesa_glsl_load_program_binary(ctx, prog, binary, length)) {
+      linker_error(prog, "program binary is invalid or was created by a "
+                   "different driver or version of Mesa\n");
+   }
+
+   _mesa_glsl_finish_link(ctx, prog);
+}
+
 } /* extern "C" */
@@ -34,6 +34,15 @@ struct gl_shader;
 struct gl_shader_program;
 
 void _mesa_glsl_link_shader(struct gl_context *ctx, struct gl_shader_program *prog);
+void _mesa_glsl_prepare_link(struct gl_context *ctx,
+                             struct gl_shader_program *prog);
+void _mesa_glsl_run_linker(struct gl_context *ctx,
+                           struct gl_shader_program *prog, GLbitfield flags);
+void _mesa_glsl_finish_link(struct gl_context *ctx,
+                            struct gl_shader_program *prog);
+void _mesa_glsl_program_binary(struct gl_context *ctx,
+                               struct gl_shader_program *prog,
+                               const GLvoid *binary, GLsizei length);
 GLboolean _mesa_ir_compile_shader(struct gl_context *ctx, struct gl_shader *shader);
 GLboolean _mesa_ir_link_shader(struct gl_context *ctx, struct gl_shader_program *prog);
 
@@ -318,7 +318,8 @@ static void st_init_driver_flags(struct gl_driver_flags *f)
 struct st_context *st_create_context(gl_api api, struct pipe_context *pipe,
                                      const struct gl_config *visual,
                                      struct st_context *share,
-                                     const struct st_config_options *options)
+                                     const struct st_config_options *options,
+                                     bool no_error)
 {
    struct gl_context *ctx;
    struct gl_context *shareCtx = share ? share->ctx : NULL;
@@ -335,6 +336,13 @@ struct st_context *st_create_context(gl_api api, struct pipe_context *pipe,
 
    st_init_driver_flags(&ctx->DriverFlags);
 
+   /* The no-error entry points are picked when the dispatch tables are
+    * built at the end of st_create_context_priv(), so the flag can't be
+    * set later along with the other context flags.
+    */
+   if (no_error)
+      ctx->Const.ContextFlags |= GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR;
+
    /* XXX: need a capability bit in gallium to query if the pipe
     * driver prefers DP4 or MUL/MAD for vertex transformation.
     */
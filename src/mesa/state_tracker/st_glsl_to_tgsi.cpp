@@ -227,7 +227,7 @@ st_dst_reg::st_dst_reg(st_src_reg reg)
 
 class glsl_to_tgsi_instruction : public exec_node {
 public:
-   DECLARE_RALLOC_CXX_OPERATORS(glsl_to_tgsi_instruction)
+   DECLARE_LINEAR_ZALLOC_CXX_OPERATORS(glsl_to_tgsi_instruction)
 
    unsigned op;
    st_dst_reg dst[2];
@@ -251,6 +251,8 @@ public:
 
 class variable_storage : public exec_node {
 public:
+   DECLARE_LINEAR_ZALLOC_CXX_OPERATORS(variable_storage)
+
    variable_storage(ir_variable *var, gl_register_file file, int index,
                     unsigned array_id = 0)
       : file(file), index(index), var(var), array_id(array_id)
@@ -266,6 +268,8 @@ public:
 
 class immediate_storage : public exec_node {
 public:
+   DECLARE_LINEAR_ZALLOC_CXX_OPERATORS(immediate_storage)
+
    immediate_storage(gl_constant_value *values, int size32, int type)
    {
       memcpy(this->values, values, size32 * sizeof(gl_constant_value));
@@ -481,6 +485,7 @@ public:
                        st_src_reg *cond, bool cond_swap);
 
    void *mem_ctx;
+   void *linalloc; /**< Linear parent of the instructions and storages */
 };
 
 static st_dst_reg address_reg = st_dst_reg(PROGRAM_ADDRESS, WRITEMASK_X, GLSL_TYPE_FLOAT, 0);
@@ -542,7 +547,7 @@ glsl_to_tgsi_visitor::emit_asm(ir_instruction *ir, unsigned op,
                                st_src_reg src0, st_src_reg src1,
                                st_src_reg src2, st_src_reg src3)
 {
-   glsl_to_tgsi_instruction *inst = new(mem_ctx) glsl_to_tgsi_instruction();
+   glsl_to_tgsi_instruction *inst = new(linalloc) glsl_to_tgsi_instruction();
    int num_reladdr = 0, i, j;
 
    op = get_opcode(ir, op, dst, src0, src1);
@@ -675,7 +680,7 @@ glsl_to_tgsi_visitor::emit_asm(ir_instruction *ir, unsigned op,
             dinst = inst;
          } else {
             /* create a new instructions for subsequent attempts */
-            dinst = new(mem_ctx) glsl_to_tgsi_instruction();
+            dinst = new(linalloc) glsl_to_tgsi_instruction();
             *dinst = *inst;
             dinst->next = NULL;
             dinst->prev = NULL;
@@ -985,7 +990,7 @@ glsl_to_tgsi_visitor::add_constant(gl_register_file file,
    for (i = 0; i * 4 < size32; i++) {
       int slot_size = MIN2(size32 - (i * 4), 4);
       /* Add this immediate to the list. */
-      entry = new(mem_ctx) immediate_storage(&values[i * 4], slot_size, datatype);
+      entry = new(linalloc) immediate_storage(&values[i * 4], slot_size, datatype);
       this->immediates.push_tail(entry);
       this->num_immediates++;
    }
@@ -1190,7 +1195,7 @@ glsl_to_tgsi_visitor::visit(ir_variable *ir)
       st_dst_reg dst;
       if (i == ir->get_num_state_slots()) {
          /* We'll set the index later. */
-         storage = new(mem_ctx) variable_storage(ir, PROGRAM_STATE_VAR, -1);
+         storage = new(linalloc) variable_storage(ir, PROGRAM_STATE_VAR, -1);
          this->variables.push_tail(storage);
 
          dst = undef_dst;
@@ -1203,7 +1208,7 @@ glsl_to_tgsi_visitor::visit(ir_variable *ir)
 
          dst = st_dst_reg(get_temp(ir->type));
 
-         storage = new(mem_ctx) variable_storage(ir, dst.file, dst.index);
+         storage = new(linalloc) variable_storage(ir, dst.file, dst.index);
 
          this->variables.push_tail(storage);
       }
@@ -2264,7 +2269,7 @@ glsl_to_tgsi_visitor::visit(ir_dereference_variable *ir)
    if (!entry) {
       switch (var->data.mode) {
       case ir_var_uniform:
-         entry = new(mem_ctx) variable_storage(var, PROGRAM_UNIFORM,
+         entry = new(linalloc) variable_storage(var, PROGRAM_UNIFORM,
                                                var->data.location);
          this->variables.push_tail(entry);
          break;
@@ -2287,13 +2292,13 @@ glsl_to_tgsi_visitor::visit(ir_dereference_variable *ir)
                decl->array_size = type_size(var->type);
             num_input_arrays++;
 
-            entry = new(mem_ctx) variable_storage(var,
+            entry = new(linalloc) variable_storage(var,
                                                   PROGRAM_INPUT,
                                                   var->data.location,
                                                   decl->array_id);
          }
          else {
-            entry = new(mem_ctx) variable_storage(var,
+            entry = new(linalloc) variable_storage(var,
                                                   PROGRAM_INPUT,
                                                   var->data.location);
          }
@@ -2313,13 +2318,13 @@ glsl_to_tgsi_visitor::visit(ir_dereference_variable *ir)
                decl->array_size = type_size(var->type);
             num_output_arrays++;
 
-            entry = new(mem_ctx) variable_storage(var,
+            entry = new(linalloc) variable_storage(var,
                                                   PROGRAM_OUTPUT,
                                                   var->data.location,
                                                   decl->array_id);
          }
          else {
-            entry = new(mem_ctx) variable_storage(var,
+            entry = new(linalloc) variable_storage(var,
                                                   PROGRAM_OUTPUT,
                                                   var->data.location
                                                   + var->data.index);
@@ -2327,7 +2332,7 @@ glsl_to_tgsi_visitor::visit(ir_dereference_variable *ir)
          this->variables.push_tail(entry);
          break;
       case ir_var_system_value:
-         entry = new(mem_ctx) variable_storage(var,
+         entry = new(linalloc) variable_storage(var,
                                                PROGRAM_SYSTEM_VALUE,
                                                var->data.location);
          break;
@@ -2335,7 +2340,7 @@ glsl_to_tgsi_visitor::visit(ir_dereference_variable *ir)
       case ir_var_temporary:
          st_src_reg src = get_temp(var->type);
 
-         entry = new(mem_ctx) variable_storage(var, src.file, src.index);
+         entry = new(linalloc) variable_storage(var, src.file, src.index);
          this->variables.push_tail(entry);
 
          break;
@@ -2930,7 +2935,7 @@ glsl_to_tgsi_visitor::get_function_signature(ir_function_signature *sig)
 
       st_src_reg src = get_temp(param->type);
 
-      storage = new(mem_ctx) variable_storage(param, src.file, src.index);
+      storage = new(linalloc) variable_storage(param, src.file, src.index);
       this->variables.push_tail(storage);
    }
 
@@ -3452,6 +3457,7 @@ glsl_to_tgsi_visitor::glsl_to_tgsi_visitor()
    glsl_version = 0;
    native_integers = false;
    mem_ctx = ralloc_context(NULL);
+   linalloc = linear_alloc_parent(mem_ctx, 0);
    ctx = NULL;
    prog = NULL;
    shader_program = NULL;
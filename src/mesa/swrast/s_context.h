@@ -123,6 +123,21 @@ typedef void (*FetchTexelFunc)(const struct swrast_texture_image *texImage,
                                GLfloat *texelOut);
 
 
+/**
+ * Number of decoded blocks each compressed texture image keeps: a 4x4
+ * neighbourhood of blocks, enough for the filter footprints of a few
+ * neighbouring fragments.
+ */
+#define SWRAST_BLOCK_CACHE_SIZE 16
+
+/** A 4x4 block of a compressed texture image, decoded to RGBA floats */
+struct swrast_decoded_block
+{
+   const GLubyte *Block;   /**< the compressed block, NULL if unused */
+   GLfloat Texels[16][4];
+};
+
+
 /**
  * Subclass of gl_texture_image.
  * We need extra fields/info to keep tracking of mapped texture buffers,
@@ -163,6 +178,15 @@ struct swrast_texture_image
 
    /** For fetching texels from compressed textures */
    compressed_fetch_func FetchCompressedTexel;
+
+   /** For decoding whole blocks of compressed textures, may be NULL */
+   compressed_fetch_block_func FetchCompressedBlock;
+
+   /**
+    * The most recently decoded blocks, indexed by the low bits of the block
+    * coordinates.  Only valid while the texture is mapped for rendering.
+    */
+   struct swrast_decoded_block *BlockCache;
 };
 
 
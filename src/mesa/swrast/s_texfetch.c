@@ -73,6 +73,26 @@ fetch_compressed(const struct swrast_texture_image *swImage,
     */
    GLuint bw, bh;
    GLuint texelBytes = _mesa_get_format_bytes(swImage->Base.TexFormat);
+
+   /* Decode the whole 4x4 block the texel is in, and keep it for the
+    * neighbouring texels which are likely to be fetched next.
+    */
+   if (swImage->BlockCache) {
+      const GLubyte *block = (const GLubyte *) swImage->ImageSlices[k] +
+                             (j / 4) * swImage->RowStride +
+                             (i / 4) * texelBytes;
+      struct swrast_decoded_block *entry =
+         &swImage->BlockCache[((j / 4) & 3) * 4 + ((i / 4) & 3)];
+
+      if (entry->Block != block) {
+         swImage->FetchCompressedBlock(block, entry->Texels);
+         entry->Block = block;
+      }
+
+      COPY_4V(texel, entry->Texels[(j % 4) * 4 + i % 4]);
+      return;
+   }
+
    _mesa_get_format_block_size(swImage->Base.TexFormat, &bw, &bh);
    assert(swImage->RowStride * bw % texelBytes == 0);
 
@@ -596,6 +616,19 @@ set_fetch_functions(const struct gl_sampler_object *samp,
    }
 
    texImage->FetchCompressedTexel = _mesa_get_compressed_fetch_func(format);
+   texImage->FetchCompressedBlock =
+      _mesa_get_compressed_fetch_block_func(format);
+
+   /* Without the cache, texels are decoded one at a time */
+   if (texImage->FetchCompressedBlock) {
+      if (!texImage->BlockCache)
+         texImage->BlockCache = malloc(SWRAST_BLOCK_CACHE_SIZE *
+                                       sizeof(*texImage->BlockCache));
+      _swrast_invalidate_block_cache(texImage);
+   } else {
+      free(texImage->BlockCache);
+      texImage->BlockCache = NULL;
+   }
 
    assert(texImage->FetchTexel);
 }
@@ -625,3 +658,20 @@ _mesa_update_fetch_functions(struct gl_context *ctx, GLuint unit)
       }
    }
 }
+
+
+/**
+ * Forget the decoded blocks of a compressed texture image, because its
+ * texels or its mapping may have changed.
+ */
+void
+_swrast_invalidate_block_cache(struct swrast_texture_image *texImage)
+{
+   GLuint i;
+
+   if (!texImage->BlockCache)
+      return;
+
+   for (i = 0; i < SWRAST_BLOCK_CACHE_SIZE; i++)
+      texImage->BlockCache[i].Block = NULL;
+}
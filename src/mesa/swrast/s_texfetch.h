@@ -32,4 +32,7 @@
 void
 _mesa_update_fetch_functions(struct gl_context *ctx, GLuint unit);
 
+void
+_swrast_invalidate_block_cache(struct swrast_texture_image *texImage);
+
 #endif /* S_TEXFETCH_H */
@@ -33,6 +33,7 @@
 #include "main/texobj.h"
 #include "swrast/swrast.h"
 #include "swrast/s_context.h"
+#include "swrast/s_texfetch.h"
 
 
 /**
@@ -49,13 +50,16 @@ _swrast_new_texture_image( struct gl_context *ctx )
 
 /**
  * Free a swrast_texture_image (a subclass of gl_texture_image).
- * Called via ctx->Driver.DeleteTextureImage().
+ * Called via ctx->Driver.DeleteTextureImage(), or by the driver's hook for
+ * texture images derived from swrast_texture_image.
  */
 void
 _swrast_delete_texture_image(struct gl_context *ctx,
                              struct gl_texture_image *texImage)
 {
-   /* Nothing special for the subclass yet */
+   struct swrast_texture_image *swImage = swrast_texture_image(texImage);
+
+   free(swImage->BlockCache);
    _mesa_delete_texture_image(ctx, texImage);
 }
 
@@ -168,6 +172,8 @@ _swrast_free_texture_image_buffer(struct gl_context *ctx,
    _mesa_align_free(swImage->Buffer);
    swImage->Buffer = NULL;
 
+   _swrast_invalidate_block_cache(swImage);
+
    free(swImage->ImageSlices);
    swImage->ImageSlices = NULL;
 }
@@ -218,6 +224,9 @@ _swrast_map_teximage(struct gl_context *ctx,
 
    check_map_teximage(texImage, slice, x, y, w, h);
 
+   if (mode & GL_MAP_WRITE_BIT)
+      _swrast_invalidate_block_cache(swImage);
+
    if (!swImage->Buffer) {
       /* Either glTexImage was called with a NULL <pixels> argument or
        * we ran out of memory when allocating texture memory,
@@ -274,6 +283,8 @@ _swrast_map_texture(struct gl_context *ctx, struct gl_texture_object *texObj)
          if (!texImage)
             continue;
 
+         _swrast_invalidate_block_cache(swImage);
+
          /* In the case of a swrast-allocated texture buffer, the ImageSlices
           * and RowStride are always available.
           */
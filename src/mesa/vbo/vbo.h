@@ -193,6 +193,42 @@ vbo_sw_primitive_restart(struct gl_context *ctx,
                          const struct _mesa_index_buffer *ib,
                          struct gl_buffer_object *indirect);
 
+/* Draw entry points of contexts created with
+ * GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR
+ */
+void GLAPIENTRY
+vbo_exec_DrawArrays_no_error(GLenum mode, GLint start, GLsizei count);
+
+void GLAPIENTRY
+vbo_exec_DrawArraysInstanced_no_error(GLenum mode, GLint start, GLsizei count,
+                                      GLsizei numInstances);
+
+void GLAPIENTRY
+vbo_exec_DrawElements_no_error(GLenum mode, GLsizei count, GLenum type,
+                               const GLvoid *indices);
+
+void GLAPIENTRY
+vbo_exec_DrawElementsBaseVertex_no_error(GLenum mode, GLsizei count,
+                                         GLenum type, const GLvoid *indices,
+                                         GLint basevertex);
+
+void GLAPIENTRY
+vbo_exec_DrawElementsInstanced_no_error(GLenum mode, GLsizei count,
+                                        GLenum type, const GLvoid *indices,
+                                        GLsizei numInstances);
+
+void GLAPIENTRY
+vbo_exec_DrawRangeElements_no_error(GLenum mode, GLuint start, GLuint end,
+                                    GLsizei count, GLenum type,
+                                    const GLvoid *indices);
+
+void GLAPIENTRY
+vbo_exec_DrawRangeElementsBaseVertex_no_error(GLenum mode,
+                                              GLuint start, GLuint end,
+                                              GLsizei count, GLenum type,
+                                              const GLvoid *indices,
+                                              GLint basevertex);
+
 void GLAPIENTRY
 _es_Color4f(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
 
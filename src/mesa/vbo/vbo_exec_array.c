@@ -801,6 +801,26 @@ vbo_exec_DrawArrays(GLenum mode, GLint start, GLsizei count)
 }
 
 
+/**
+ * Called from glDrawArrays in contexts created with
+ * GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR.
+ */
+void GLAPIENTRY
+vbo_exec_DrawArrays_no_error(GLenum mode, GLint start, GLsizei count)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (MESA_VERBOSE & VERBOSE_DRAW)
+      _mesa_debug(ctx, "glDrawArrays(%s, %d, %d)\n",
+                  _mesa_lookup_enum_by_nr(mode), start, count);
+
+   if (!_mesa_valid_to_render_no_error(ctx) || count == 0)
+      return;
+
+   vbo_draw_arrays(ctx, mode, start, count, 1, 0);
+}
+
+
 /**
  * Called from glDrawArraysInstanced when in immediate mode (not
  * display list mode).
@@ -828,6 +848,27 @@ vbo_exec_DrawArraysInstanced(GLenum mode, GLint start, GLsizei count,
 }
 
 
+/**
+ * Called from glDrawArraysInstanced in contexts created with
+ * GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR.
+ */
+void GLAPIENTRY
+vbo_exec_DrawArraysInstanced_no_error(GLenum mode, GLint start, GLsizei count,
+                                      GLsizei numInstances)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (MESA_VERBOSE & VERBOSE_DRAW)
+      _mesa_debug(ctx, "glDrawArraysInstanced(%s, %d, %d, %d)\n",
+                  _mesa_lookup_enum_by_nr(mode), start, count, numInstances);
+
+   if (!_mesa_valid_to_render_no_error(ctx) || count == 0 || numInstances == 0)
+      return;
+
+   vbo_draw_arrays(ctx, mode, start, count, numInstances, 0);
+}
+
+
 /**
  * Called from glDrawArraysInstancedBaseInstance when in immediate mode.
  */
@@ -999,14 +1040,15 @@ vbo_validated_drawrangeelements(struct gl_context *ctx, GLenum mode,
 
 
 /**
- * Called by glDrawRangeElementsBaseVertex() in immediate mode.
+ * Draw the validated glDrawRangeElementsBaseVertex() call, after making the
+ * index range safe to use.
  */
-static void GLAPIENTRY
-vbo_exec_DrawRangeElementsBaseVertex(GLenum mode,
-				     GLuint start, GLuint end,
-				     GLsizei count, GLenum type,
-				     const GLvoid *indices,
-				     GLint basevertex)
+static void
+vbo_draw_range_elements(struct gl_context *ctx, GLenum mode,
+                        GLuint start, GLuint end,
+                        GLsizei count, GLenum type,
+                        const GLvoid *indices,
+                        GLint basevertex)
 {
    static GLuint warnCount = 0;
    GLboolean index_bounds_valid = GL_TRUE;
@@ -1016,18 +1058,6 @@ vbo_exec_DrawRangeElementsBaseVertex(GLenum mode,
     */
    GLuint max_element = 2 * 1000 * 1000 * 1000; /* just a big number */
 
-   GET_CURRENT_CONTEXT(ctx);
-
-   if (MESA_VERBOSE & VERBOSE_DRAW)
-      _mesa_debug(ctx,
-                "glDrawRangeElementsBaseVertex(%s, %u, %u, %d, %s, %p, %d)\n",
-                _mesa_lookup_enum_by_nr(mode), start, end, count,
-                _mesa_lookup_enum_by_nr(type), indices, basevertex);
-
-   if (!_mesa_validate_DrawRangeElements(ctx, mode, start, end, count,
-                                         type, indices))
-      return;
-
    if ((int) end + basevertex < 0 ||
        start + basevertex >= max_element) {
       /* The application requested we draw using a range of indices that's
@@ -1088,6 +1118,60 @@ vbo_exec_DrawRangeElementsBaseVertex(GLenum mode,
 }
 
 
+/**
+ * Called by glDrawRangeElementsBaseVertex() in immediate mode.
+ */
+static void GLAPIENTRY
+vbo_exec_DrawRangeElementsBaseVertex(GLenum mode,
+				     GLuint start, GLuint end,
+				     GLsizei count, GLenum type,
+				     const GLvoid *indices,
+				     GLint basevertex)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (MESA_VERBOSE & VERBOSE_DRAW)
+      _mesa_debug(ctx,
+                "glDrawRangeElementsBaseVertex(%s, %u, %u, %d, %s, %p, %d)\n",
+                _mesa_lookup_enum_by_nr(mode), start, end, count,
+                _mesa_lookup_enum_by_nr(type), indices, basevertex);
+
+   if (!_mesa_validate_DrawRangeElements(ctx, mode, start, end, count,
+                                         type, indices))
+      return;
+
+   vbo_draw_range_elements(ctx, mode, start, end, count, type, indices,
+                           basevertex);
+}
+
+
+/**
+ * Called by glDrawRangeElementsBaseVertex() in contexts created with
+ * GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR.
+ */
+void GLAPIENTRY
+vbo_exec_DrawRangeElementsBaseVertex_no_error(GLenum mode,
+                                              GLuint start, GLuint end,
+                                              GLsizei count, GLenum type,
+                                              const GLvoid *indices,
+                                              GLint basevertex)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (MESA_VERBOSE & VERBOSE_DRAW)
+      _mesa_debug(ctx,
+                "glDrawRangeElementsBaseVertex(%s, %u, %u, %d, %s, %p, %d)\n",
+                _mesa_lookup_enum_by_nr(mode), start, end, count,
+                _mesa_lookup_enum_by_nr(type), indices, basevertex);
+
+   if (!_mesa_valid_to_render_no_error(ctx) || count == 0)
+      return;
+
+   vbo_draw_range_elements(ctx, mode, start, end, count, type, indices,
+                           basevertex);
+}
+
+
 /**
  * Called by glDrawRangeElements() in immediate mode.
  */
@@ -1108,6 +1192,20 @@ vbo_exec_DrawRangeElements(GLenum mode, GLuint start, GLuint end,
 }
 
 
+/**
+ * Called by glDrawRangeElements() in contexts created with
+ * GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR.
+ */
+void GLAPIENTRY
+vbo_exec_DrawRangeElements_no_error(GLenum mode, GLuint start, GLuint end,
+                                    GLsizei count, GLenum type,
+                                    const GLvoid *indices)
+{
+   vbo_exec_DrawRangeElementsBaseVertex_no_error(mode, start, end, count,
+                                                 type, indices, 0);
+}
+
+
 /**
  * Called by glDrawElements() in immediate mode.
  */
@@ -1130,6 +1228,29 @@ vbo_exec_DrawElements(GLenum mode, GLsizei count, GLenum type,
 }
 
 
+/**
+ * Called by glDrawElements() in contexts created with
+ * GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR.
+ */
+void GLAPIENTRY
+vbo_exec_DrawElements_no_error(GLenum mode, GLsizei count, GLenum type,
+                               const GLvoid *indices)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (MESA_VERBOSE & VERBOSE_DRAW)
+      _mesa_debug(ctx, "glDrawElements(%s, %u, %s, %p)\n",
+                  _mesa_lookup_enum_by_nr(mode), count,
+                  _mesa_lookup_enum_by_nr(type), indices);
+
+   if (!_mesa_valid_to_render_no_error(ctx) || count == 0)
+      return;
+
+   vbo_validated_drawrangeelements(ctx, mode, GL_FALSE, ~0, ~0,
+                                   count, type, indices, 0, 1, 0);
+}
+
+
 /**
  * Called by glDrawElementsBaseVertex() in immediate mode.
  */
@@ -1152,6 +1273,30 @@ vbo_exec_DrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type,
 }
 
 
+/**
+ * Called by glDrawElementsBaseVertex() in contexts created with
+ * GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR.
+ */
+void GLAPIENTRY
+vbo_exec_DrawElementsBaseVertex_no_error(GLenum mode, GLsizei count,
+                                         GLenum type, const GLvoid *indices,
+                                         GLint basevertex)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (MESA_VERBOSE & VERBOSE_DRAW)
+      _mesa_debug(ctx, "glDrawElementsBaseVertex(%s, %d, %s, %p, %d)\n",
+                  _mesa_lookup_enum_by_nr(mode), count,
+                  _mesa_lookup_enum_by_nr(type), indices, basevertex);
+
+   if (!_mesa_valid_to_render_no_error(ctx) || count == 0)
+      return;
+
+   vbo_validated_drawrangeelements(ctx, mode, GL_FALSE, ~0, ~0,
+                                   count, type, indices, basevertex, 1, 0);
+}
+
+
 /**
  * Called by glDrawElementsInstanced() in immediate mode.
  */
@@ -1175,6 +1320,30 @@ vbo_exec_DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type,
 }
 
 
+/**
+ * Called by glDrawElementsInstanced() in contexts created with
+ * GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR.
+ */
+void GLAPIENTRY
+vbo_exec_DrawElementsInstanced_no_error(GLenum mode, GLsizei count,
+                                        GLenum type, const GLvoid *indices,
+                                        GLsizei numInstances)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (MESA_VERBOSE & VERBOSE_DRAW)
+      _mesa_debug(ctx, "glDrawElementsInstanced(%s, %d, %s, %p, %d)\n",
+                  _mesa_lookup_enum_by_nr(mode), count,
+                  _mesa_lookup_enum_by_nr(type), indices, numInstances);
+
+   if (!_mesa_valid_to_render_no_error(ctx) || count == 0 || numInstances == 0)
+      return;
+
+   vbo_validated_drawrangeelements(ctx, mode, GL_FALSE, ~0, ~0,
+                                   count, type, indices, 0, numInstances, 0);
+}
+
+
 /**
  * Called by glDrawElementsInstancedBaseVertex() in immediate mode.
  */
@@ -1792,11 +1961,19 @@ void
 vbo_initialize_exec_dispatch(const struct gl_context *ctx,
                              struct _glapi_table *exec)
 {
-   SET_DrawArrays(exec, vbo_exec_DrawArrays);
-   SET_DrawElements(exec, vbo_exec_DrawElements);
+   /* Contexts created with GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR get the most
+    * common draw calls without parameter and state validation.
+    */
+   const bool no_error = _mesa_is_no_error_enabled(ctx);
+
+   SET_DrawArrays(exec, no_error ? vbo_exec_DrawArrays_no_error
+                                 : vbo_exec_DrawArrays);
+   SET_DrawElements(exec, no_error ? vbo_exec_DrawElements_no_error
+                                   : vbo_exec_DrawElements);
 
    if (_mesa_is_desktop_gl(ctx) || _mesa_is_gles3(ctx)) {
-      SET_DrawRangeElements(exec, vbo_exec_DrawRangeElements);
+      SET_DrawRangeElements(exec, no_error ? vbo_exec_DrawRangeElements_no_error
+                                           : vbo_exec_DrawRangeElements);
    }
 
    SET_MultiDrawElementsEXT(exec, vbo_exec_MultiDrawElements);
@@ -1808,8 +1985,12 @@ vbo_initialize_exec_dispatch(const struct gl_context *ctx,
    }
 
    if (_mesa_is_desktop_gl(ctx)) {
-      SET_DrawElementsBaseVertex(exec, vbo_exec_DrawElementsBaseVertex);
-      SET_DrawRangeElementsBaseVertex(exec, vbo_exec_DrawRangeElementsBaseVertex);
+      SET_DrawElementsBaseVertex(exec,
+                                 no_error ? vbo_exec_DrawElementsBaseVertex_no_error
+                                          : vbo_exec_DrawElementsBaseVertex);
+      SET_DrawRangeElementsBaseVertex(exec,
+                                      no_error ? vbo_exec_DrawRangeElementsBaseVertex_no_error
+                                               : vbo_exec_DrawRangeElementsBaseVertex);
       SET_MultiDrawElementsBaseVertex(exec, vbo_exec_MultiDrawElementsBaseVertex);
       SET_DrawArraysInstancedBaseInstance(exec, vbo_exec_DrawArraysInstancedBaseInstance);
       SET_DrawElementsInstancedBaseInstance(exec, vbo_exec_DrawElementsInstancedBaseInstance);
@@ -1828,8 +2009,12 @@ vbo_initialize_exec_dispatch(const struct gl_context *ctx,
    }
 
    if (_mesa_is_desktop_gl(ctx) || _mesa_is_gles3(ctx)) {
-      SET_DrawArraysInstancedARB(exec, vbo_exec_DrawArraysInstanced);
-      SET_DrawElementsInstancedARB(exec, vbo_exec_DrawElementsInstanced);
+      SET_DrawArraysInstancedARB(exec,
+                                 no_error ? vbo_exec_DrawArraysInstanced_no_error
+                                          : vbo_exec_DrawArraysInstanced);
+      SET_DrawElementsInstancedARB(exec,
+                                   no_error ? vbo_exec_DrawElementsInstanced_no_error
+                                            : vbo_exec_DrawElementsInstanced);
    }
 
    if (_mesa_is_desktop_gl(ctx)) {
@@ -108,6 +108,9 @@ void vbo_save_destroy( struct gl_context *ctx )
       }
    }
 
+   free(save->vertex_ram);
+   save->vertex_ram = NULL;
+
    for (i = 0; i < VBO_ATTRIB_MAX; i++) {
       _mesa_reference_buffer_object(ctx, &save->arrays[i].BufferObj, NULL);
    }
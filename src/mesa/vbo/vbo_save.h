@@ -81,22 +81,32 @@ struct vbo_save_vertex_list {
    struct _mesa_prim *prim;
    GLuint prim_count;
 
+   /* The same primitives as indexed ones, with identical vertices
+    * folded together and the parts of a primitive split up by a wrap
+    * merged into a single one.  The indices are stored in vertex_store
+    * right after the vertices.  Not set up if that doesn't buy anything.
+    */
+   struct _mesa_prim *merged_prim;
+   GLuint merged_prim_count;
+   GLuint ib_offset;            /**< byte offset of the indices */
+   GLuint ib_count;
+   GLenum ib_type;
+   GLboolean triangulated;      /* strips, fans, quads or polygons were
+                                   turned into triangles */
+
    struct vbo_save_vertex_store *vertex_store;
    struct vbo_save_primitive_store *prim_store;
 };
 
-/* These buffers should be a reasonable size to support upload to
- * hardware.  Current vbo implementation will re-upload on any
- * changes, so don't make too big or apps which dynamically create
- * dlists and use only a few times will suffer.
- *
- * Consider stategy of uploading regions from the VBO on demand in the
- * case of dynamic vbos.  Then make the dlist code signal that
- * likelyhood as it occurs.  No reason we couldn't change usage
- * internally even though this probably isn't allowed for client VBOs?
+/* These buffers are shared by all the vertex lists compiled until they
+ * fill up, so that apps which compile many small lists don't end up
+ * with as many small buffer objects.  Only the part that was used is
+ * uploaded, but each vertex store is a 1 MB buffer object that stays
+ * allocated as long as any list using it is alive, however few vertices
+ * that list has, and each context also keeps a 1 MB vertex_ram copy.
  */
-#define VBO_SAVE_BUFFER_SIZE (8*1024) /* dwords */
-#define VBO_SAVE_PRIM_SIZE   128
+#define VBO_SAVE_BUFFER_SIZE (256*1024) /* dwords */
+#define VBO_SAVE_PRIM_SIZE   1024
 #define VBO_SAVE_PRIM_MODE_MASK         0x3f
 #define VBO_SAVE_PRIM_WEAK              0x40
 #define VBO_SAVE_PRIM_NO_CURRENT_UPDATE 0x80
@@ -144,6 +154,7 @@ struct vbo_save_context {
    struct vbo_save_vertex_store *vertex_store;
    struct vbo_save_primitive_store *prim_store;
 
+   fi_type *vertex_ram;             /**< CPU copy of the vertex store */
    fi_type *buffer_ptr;		   /* cursor, points into buffer */
    fi_type vertex[VBO_ATTRIB_MAX*4];	   /* current values */
    fi_type *attrptr[VBO_ATTRIB_MAX];
@@ -194,4 +205,12 @@ void
 vbo_save_unmap_vertex_store(struct gl_context *ctx,
                             struct vbo_save_vertex_store *vertex_store);
 
+GLuint
+vbo_save_index_prims(const fi_type *vertices, GLuint vertex_size,
+                     GLuint vertex_count,
+                     const struct _mesa_prim *prims, GLuint prim_count,
+                     GLuint *indices, struct _mesa_prim *merged,
+                     GLuint *merged_count, GLuint *unique_count,
+                     GLboolean *triangulated);
+
 #endif /* VBO_SAVE_H */
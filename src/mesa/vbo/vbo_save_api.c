@@ -78,6 +78,7 @@ USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "main/api_arrayelt.h"
 #include "main/vtxfmt.h"
 #include "main/dispatch.h"
+#include "util/hash_table.h"
 
 #include "vbo_context.h"
 #include "vbo_noop.h"
@@ -192,7 +193,7 @@ alloc_vertex_store(struct gl_context *ctx)
     * buffers:
     */
    vertex_store->bufferobj = ctx->Driver.NewBufferObject(ctx, VBO_BUF_ID);
-   if (vertex_store->bufferobj) {
+   if (vertex_store->bufferobj && save->vertex_ram) {
       save->out_of_memory =
          !ctx->Driver.BufferData(ctx,
                                  GL_ARRAY_BUFFER_ARB,
@@ -309,7 +310,7 @@ _save_reset_counters(struct gl_context *ctx)
    struct vbo_save_context *save = &vbo_context(ctx)->save;
 
    save->prim = save->prim_store->buffer + save->prim_store->used;
-   save->buffer = save->vertex_store->buffer + save->vertex_store->used;
+   save->buffer = save->vertex_ram + save->vertex_store->used;
 
    assert(save->buffer == save->buffer_ptr);
 
@@ -361,6 +362,243 @@ merge_prims(struct gl_context *ctx,
    *prim_count = prev_prim - prim_list + 1;
 }
 
+/**
+ * Append to \p indices the vertices of \p prim as independent primitives,
+ * through \p remap, and return the mode of those primitives.  Strips, fans,
+ * quads and polygons become triangles whose last vertex is the one the
+ * original primitive would provoke with GL_LAST_VERTEX_CONVENTION and with
+ * the same winding; anything else is passed through as it is.
+ */
+static GLenum
+emit_prim_indices(const struct _mesa_prim *prim, const GLuint *remap,
+                  GLuint *indices, GLuint *count, GLboolean *triangulated)
+{
+   const GLuint *v = remap + prim->start;
+   const GLuint nr = prim->count;
+   GLuint n = *count;
+   GLuint i;
+
+#define TRI(a, b, c) \
+   do { indices[n++] = v[a]; indices[n++] = v[b]; indices[n++] = v[c]; } \
+   while (0)
+
+   switch (prim->mode) {
+   case GL_POINTS:
+   case GL_LINES:
+   case GL_TRIANGLES: {
+      /* Leave out any incomplete trailing primitive */
+      const GLuint verts_per_prim = prim->mode == GL_POINTS ? 1 :
+                                    prim->mode == GL_LINES ? 2 : 3;
+      for (i = 0; i < nr - nr % verts_per_prim; i++)
+         indices[n++] = v[i];
+      *count = n;
+      return prim->mode;
+   }
+   case GL_TRIANGLE_STRIP:
+      for (i = 0; i + 2 < nr; i++) {
+         if (i & 1)
+            TRI(i + 1, i, i + 2);
+         else
+            TRI(i, i + 1, i + 2);
+      }
+      break;
+   case GL_TRIANGLE_FAN:
+      for (i = 0; i + 2 < nr; i++)
+         TRI(0, i + 1, i + 2);
+      break;
+   case GL_POLYGON:
+      /* The first vertex is the provoking one */
+      for (i = 0; i + 2 < nr; i++)
+         TRI(i + 1, i + 2, 0);
+      break;
+   case GL_QUADS:
+      for (i = 0; i + 3 < nr; i += 4) {
+         TRI(i, i + 1, i + 3);
+         TRI(i + 1, i + 2, i + 3);
+      }
+      break;
+   case GL_QUAD_STRIP:
+      for (i = 0; i + 3 < nr; i += 2) {
+         TRI(i, i + 1, i + 3);
+         TRI(i + 2, i, i + 3);
+      }
+      break;
+   default:
+      for (i = 0; i < nr; i++)
+         indices[n++] = v[i];
+      *count = n;
+      return prim->mode;
+   }
+
+#undef TRI
+
+   *count = n;
+   *triangulated = GL_TRUE;
+   return GL_TRIANGLES;
+}
+
+
+/**
+ * Fold identical vertices of \p vertices together, and turn \p prims into
+ * indexed primitives.  Strips, fans, quads and polygons become triangles.
+ * Runs of primitives that end up as points, lines or triangles are merged
+ * into one, across Begin/End pairs.  This renumbers their primitives, which
+ * can_draw_merged() checks nothing observes.
+ *
+ * \p indices must have room for three indices per vertex of \p prims, and
+ * \p merged for \p prim_count primitives.  Returns the number of indices,
+ * or 0 if out of memory.
+ */
+GLuint
+vbo_save_index_prims(const fi_type *vertices, GLuint vertex_size,
+                     GLuint vertex_count,
+                     const struct _mesa_prim *prims, GLuint prim_count,
+                     GLuint *indices, struct _mesa_prim *merged,
+                     GLuint *merged_count, GLuint *unique_count,
+                     GLboolean *triangulated)
+{
+   const GLuint vertex_bytes = vertex_size * sizeof(GLfloat);
+   const GLuint table_size = _mesa_next_pow_two_32(2 * vertex_count);
+   GLuint *remap = malloc(vertex_count * sizeof(GLuint));
+   GLuint *table = calloc(table_size, sizeof(GLuint));
+   GLuint unique = 0, count = 0, i;
+
+   *merged_count = 0;
+   *triangulated = GL_FALSE;
+
+   if (!remap || !table) {
+      free(remap);
+      free(table);
+      return 0;
+   }
+
+   /* Map each vertex to the first one with the same contents, using an
+    * open-addressed table of vertex numbers plus one.
+    */
+   for (i = 0; i < vertex_count; i++) {
+      const fi_type *vertex = vertices + i * vertex_size;
+      GLuint slot = _mesa_hash_data(vertex, vertex_bytes) & (table_size - 1);
+
+      while (table[slot] &&
+             memcmp(vertices + (table[slot] - 1) * vertex_size,
+                    vertex, vertex_bytes) != 0)
+         slot = (slot + 1) & (table_size - 1);
+
+      if (!table[slot]) {
+         table[slot] = i + 1;
+         unique++;
+      }
+      remap[i] = table[slot] - 1;
+   }
+
+   for (i = 0; i < prim_count; i++) {
+      const struct _mesa_prim *prim = &prims[i];
+      const GLuint start = count;
+      const GLenum mode =
+         emit_prim_indices(prim, remap, indices, &count, triangulated);
+      struct _mesa_prim *prev =
+         *merged_count ? &merged[*merged_count - 1] : NULL;
+
+      if (count == start)
+         continue;
+
+      if (prev && prev->mode == mode &&
+          (mode == GL_POINTS || mode == GL_LINES || mode == GL_TRIANGLES)) {
+         prev->count += count - start;
+         prev->end = prim->end;
+         continue;
+      }
+
+      prev = &merged[(*merged_count)++];
+      *prev = *prim;
+      prev->mode = mode;
+      prev->indexed = 1;
+      prev->start = start;
+      prev->count = count - start;
+      prev->basevertex = 0;
+   }
+
+   *unique_count = unique;
+
+   free(remap);
+   free(table);
+
+   return count;
+}
+
+
+/**
+ * Set up the node to be drawn with indices, through vbo_save_index_prims().
+ * The indices go right after the node's vertices in the vertex store.
+ * The vertices are read back from the copy in vertex_ram, since the
+ * vertex store is mapped write-only.
+ */
+static void
+_save_compile_indices(struct gl_context *ctx,
+                      struct vbo_save_vertex_list *node)
+{
+   struct vbo_save_context *save = &vbo_context(ctx)->save;
+   struct vbo_save_vertex_store *store = save->vertex_store;
+   GLuint *indices;
+   struct _mesa_prim *merged;
+   GLuint unique, max_indices = 0, count = 0, i;
+   GLuint merged_count = 0, index_size, index_dwords;
+   GLboolean triangulated;
+
+   if (node->count == 0 || node->prim_count == 0 || !store->buffer)
+      return;
+
+   for (i = 0; i < node->prim_count; i++)
+      max_indices += 3 * node->prim[i].count;
+
+   indices = malloc(max_indices * sizeof(GLuint));
+   merged = malloc(node->prim_count * sizeof(struct _mesa_prim));
+
+   if (!indices || !merged)
+      goto done;
+
+   count = vbo_save_index_prims(save->buffer, node->vertex_size, node->count,
+                                node->prim, node->prim_count,
+                                indices, merged, &merged_count, &unique,
+                                &triangulated);
+
+   /* Only worth it if it saves vertices or draws */
+   if (merged_count == 0 ||
+       (merged_count == node->prim_count && unique == node->count))
+      goto done;
+
+   index_size = node->count > 0xffff ? sizeof(GLuint) : sizeof(GLushort);
+   index_dwords = (count * index_size + 3) / 4;
+   if (store->used + index_dwords > VBO_SAVE_BUFFER_SIZE)
+      goto done;
+
+   if (index_size == sizeof(GLuint)) {
+      memcpy(store->buffer + store->used, indices, count * sizeof(GLuint));
+   }
+   else {
+      GLushort *dst = (GLushort *) (store->buffer + store->used);
+      for (i = 0; i < count; i++)
+         dst[i] = indices[i];
+   }
+
+   node->merged_prim = merged;
+   node->merged_prim_count = merged_count;
+   node->ib_offset = store->used * sizeof(GLfloat);
+   node->ib_count = count;
+   node->ib_type = index_size == sizeof(GLuint) ? GL_UNSIGNED_INT :
+                                                  GL_UNSIGNED_SHORT;
+   node->triangulated = triangulated;
+   merged = NULL;
+
+   store->used += index_dwords;
+   save->buffer_ptr = save->vertex_ram + store->used;
+
+done:
+   free(indices);
+   free(merged);
+}
+
+
 /**
  * Insert the active immediate struct onto the display list currently
  * being built.
@@ -389,12 +627,15 @@ _save_compile_vertex_list(struct gl_context *ctx)
    memcpy(node->attrtype, save->attrtype, sizeof(node->attrtype));
    node->vertex_size = save->vertex_size;
    node->buffer_offset =
-      (save->buffer - save->vertex_store->buffer) * sizeof(GLfloat);
+      (save->buffer - save->vertex_ram) * sizeof(GLfloat);
    node->count = save->vert_count;
    node->wrap_count = save->copied.nr;
    node->dangling_attr_ref = save->dangling_attr_ref;
    node->prim = save->prim;
    node->prim_count = save->prim_count;
+   node->merged_prim = NULL;
+   node->merged_prim_count = 0;
+   node->triangulated = GL_FALSE;
    node->vertex_store = save->vertex_store;
    node->prim_store = save->prim_store;
 
@@ -415,7 +656,7 @@ _save_compile_vertex_list(struct gl_context *ctx)
           */
          node->current_data = malloc(node->current_size * sizeof(GLfloat));
          if (node->current_data) {
-            const char *buffer = (const char *) save->vertex_store->buffer;
+            const char *buffer = (const char *) save->buffer;
             unsigned attr_offset = node->attrsz[0] * sizeof(GLfloat);
             unsigned vertex_offset = 0;
 
@@ -424,7 +665,7 @@ _save_compile_vertex_list(struct gl_context *ctx)
                   (node->count - 1) * node->vertex_size * sizeof(GLfloat);
 
             memcpy(node->current_data,
-                   buffer + node->buffer_offset + vertex_offset + attr_offset,
+                   buffer + vertex_offset + attr_offset,
                    node->current_size * sizeof(GLfloat));
          }
       }
@@ -435,6 +676,13 @@ _save_compile_vertex_list(struct gl_context *ctx)
    if (save->dangling_attr_ref)
       ctx->ListState.CurrentList->Flags |= DLIST_DANGLING_REFS;
 
+   /* Upload the vertices, which were built up in vertex_ram */
+   if (save->vertex_store->buffer) {
+      memcpy(save->vertex_store->buffer + save->vertex_store->used,
+             save->buffer,
+             save->vertex_size * node->count * sizeof(GLfloat));
+   }
+
    save->vertex_store->used += save->vertex_size * node->count;
    save->prim_store->used += node->prim_count;
 
@@ -444,6 +692,8 @@ _save_compile_vertex_list(struct gl_context *ctx)
 
    merge_prims(ctx, node->prim, &node->prim_count);
 
+   _save_compile_indices(ctx, node);
+
    /* Deal with GL_COMPILE_AND_EXECUTE:
     */
    if (ctx->ExecuteFlag) {
@@ -451,10 +701,7 @@ _save_compile_vertex_list(struct gl_context *ctx)
 
       _glapi_set_dispatch(ctx->Exec);
 
-      vbo_loopback_vertex_list(ctx,
-                               (const GLfloat *) ((const char *) save->
-                                                  vertex_store->buffer +
-                                                  node->buffer_offset),
+      vbo_loopback_vertex_list(ctx, (const GLfloat *) save->buffer,
                                node->attrsz, node->prim, node->prim_count,
                                node->wrap_count, node->vertex_size);
 
@@ -480,8 +727,9 @@ _save_compile_vertex_list(struct gl_context *ctx)
       /* Allocate and map new store:
        */
       save->vertex_store = alloc_vertex_store(ctx);
-      save->buffer_ptr = vbo_save_map_vertex_store(ctx, save->vertex_store);
-      save->out_of_memory = save->buffer_ptr == NULL;
+      save->out_of_memory =
+         vbo_save_map_vertex_store(ctx, save->vertex_store) == NULL;
+      save->buffer_ptr = save->vertex_ram;
    }
 
    if (save->prim_store->used > VBO_SAVE_PRIM_SIZE - 6) {
@@ -1454,7 +1702,8 @@ vbo_save_NewList(struct gl_context *ctx, GLuint list, GLenum mode)
    if (!save->vertex_store)
       save->vertex_store = alloc_vertex_store(ctx);
 
-   save->buffer_ptr = vbo_save_map_vertex_store(ctx, save->vertex_store);
+   vbo_save_map_vertex_store(ctx, save->vertex_store);
+   save->buffer_ptr = save->vertex_ram + save->vertex_store->used;
 
    _save_reset_vertex(ctx);
    _save_reset_counters(ctx);
@@ -1532,6 +1781,9 @@ vbo_destroy_vertex_list(struct gl_context *ctx, void *data)
 
    free(node->current_data);
    node->current_data = NULL;
+
+   free(node->merged_prim);
+   node->merged_prim = NULL;
 }
 
 
@@ -1560,6 +1812,15 @@ vbo_print_vertex_list(struct gl_context *ctx, void *data, FILE *f)
              (prim->begin) ? "BEGIN" : "(wrap)",
              (prim->end) ? "END" : "(wrap)");
    }
+
+   for (i = 0; i < node->merged_prim_count; i++) {
+      struct _mesa_prim *prim = &node->merged_prim[i];
+      fprintf(f, "   indexed prim %d: %s %d..%d\n",
+             i,
+             _mesa_lookup_prim_by_nr(prim->mode),
+             prim->start,
+             prim->start + prim->count);
+   }
 }
 
 
@@ -1606,6 +1867,11 @@ vbo_save_api_init(struct vbo_save_context *save)
 
    ctx->Driver.NotifySaveBegin = vbo_save_NotifyBegin;
 
+   /* Vertices are built up here and copied to the vertex store when a
+    * vertex list is compiled, at the same offset.
+    */
+   save->vertex_ram = malloc(VBO_SAVE_BUFFER_SIZE * sizeof(fi_type));
+
    _save_vtxfmt_init(ctx);
    _save_current_init(ctx);
    _mesa_noop_vtxfmt_init(&save->vtxfmt_noop);
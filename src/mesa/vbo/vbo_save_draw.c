@@ -34,6 +34,7 @@
 #include "main/macros.h"
 #include "main/light.h"
 #include "main/state.h"
+#include "main/transformfeedback.h"
 
 #include "vbo_context.h"
 
@@ -240,6 +241,45 @@ vbo_save_loopback_vertex_list(struct gl_context *ctx,
 }
 
 
+/**
+ * Whether the node can be drawn with its indexed primitives under the
+ * current state.  Merging Begin/End pairs renumbers their primitives, so
+ * gl_PrimitiveID must not be read.  Triangles only stand in for the
+ * original primitives when they are filled, flat shaded from their last
+ * vertex and nothing counts them.  Geometry shaders and pipeline
+ * statistics see the primitives of every draw, so they always get the
+ * original ones.  The indices are never meant to be primitive restart
+ * indices.
+ */
+static GLboolean
+can_draw_merged(struct gl_context *ctx,
+                const struct vbo_save_vertex_list *node)
+{
+   const struct gl_fragment_program *fp = ctx->FragmentProgram._Current;
+   unsigned i;
+
+   if (node->merged_prim_count == 0 || ctx->Array._PrimitiveRestart ||
+       ctx->GeometryProgram._Current ||
+       (fp && (fp->Base.InputsRead & VARYING_BIT_PRIMITIVE_ID)))
+      return GL_FALSE;
+
+   for (i = 0; i < MAX_PIPELINE_STATISTICS; i++) {
+      if (ctx->Query.pipeline_stats[i])
+         return GL_FALSE;
+   }
+
+   if (node->triangulated &&
+       (ctx->Light.ProvokingVertex != GL_LAST_VERTEX_CONVENTION_EXT ||
+        ctx->Polygon.FrontMode != GL_FILL ||
+        ctx->Polygon.BackMode != GL_FILL ||
+        _mesa_is_xfb_active_and_unpaused(ctx) ||
+        ctx->Query.PrimitivesGenerated[0]))
+      return GL_FALSE;
+
+   return GL_TRUE;
+}
+
+
 /**
  * Execute the buffer and save copied verts.
  * This is called from the display list code when executing
@@ -306,7 +346,24 @@ vbo_save_playback_vertex_list(struct gl_context *ctx, void *data)
       if (ctx->NewState)
 	 _mesa_update_state( ctx );
 
-      if (node->count > 0) {
+      if (node->count > 0 && can_draw_merged(ctx, node)) {
+         struct _mesa_index_buffer ib;
+
+         ib.count = node->ib_count;
+         ib.type = node->ib_type;
+         ib.obj = node->vertex_store->bufferobj;
+         ib.ptr = (const GLubyte *) NULL + node->ib_offset;
+
+         vbo_context(ctx)->draw_prims(ctx,
+                                      node->merged_prim,
+                                      node->merged_prim_count,
+                                      &ib,
+                                      GL_TRUE,
+                                      0,
+                                      node->count - 1,
+                                      NULL, NULL);
+      }
+      else if (node->count > 0) {
          vbo_context(ctx)->draw_prims(ctx, 
                                       node->prim,
                                       node->prim_count,
@@ -324,6 +381,7 @@ vbo_save_playback_vertex_list(struct gl_context *ctx, void *data)
 
 end:
    if (remap_vertex_store) {
-      save->buffer_ptr = vbo_save_map_vertex_store(ctx, save->vertex_store);
+      /* Vertices are built up in vertex_ram, so buffer_ptr is unaffected */
+      vbo_save_map_vertex_store(ctx, save->vertex_store);
    }
 }
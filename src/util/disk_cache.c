@@ -0,0 +1,422 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifdef ENABLE_SHADER_CACHE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <utime.h>
+
+#include "util/u_atomic.h"
+#include "disk_cache.h"
+#include "mesa-sha1.h"
+
+/* Entries are stored as <path>/<first two hex digits>/<other 38 digits> */
+#define CACHE_DIR_NAME_LEN 2
+#define CACHE_FILE_NAME_LEN (2 * CACHE_KEY_SIZE - CACHE_DIR_NAME_LEN)
+
+/* When over the limit, evict entries until we are below this fraction */
+#define CACHE_EVICT_NUM 3
+#define CACHE_EVICT_DEN 4
+
+#define CACHE_MAGIC 0x4d434348 /* "MCCH" */
+
+struct cache_entry_header {
+   uint32_t magic;
+   uint32_t size;
+   cache_key key;
+};
+
+struct disk_cache {
+   char *path;
+   uint64_t max_size;
+
+   /** Estimate of the bytes stored, updated by this process only */
+   uint64_t total_size;
+};
+
+struct cache_file {
+   char *path;
+   time_t mtime;
+   off_t size;
+};
+
+
+static bool
+mkdir_if_needed(const char *path)
+{
+   struct stat sb;
+
+   if (stat(path, &sb) == 0)
+      return S_ISDIR(sb.st_mode);
+
+   return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+
+/**
+ * Create path and all its missing parents.
+ */
+static bool
+mkdir_with_parents(const char *path)
+{
+   char *copy = strdup(path);
+   char *p;
+   bool ret;
+
+   if (!copy)
+      return false;
+
+   for (p = copy + 1; *p; p++) {
+      if (*p == '/') {
+         *p = '\0';
+         if (!mkdir_if_needed(copy)) {
+            free(copy);
+            return false;
+         }
+         *p = '/';
+      }
+   }
+
+   ret = mkdir_if_needed(copy);
+   free(copy);
+   return ret;
+}
+
+
+/**
+ * Call cb for each entry file of the cache.
+ */
+static void
+for_each_file(struct disk_cache *cache,
+              void (*cb)(void *data, const char *path, const struct stat *sb),
+              void *data)
+{
+   DIR *dir, *subdir;
+   struct dirent *dent, *subdent;
+   char path[4096];
+   struct stat sb;
+
+   dir = opendir(cache->path);
+   if (!dir)
+      return;
+
+   while ((dent = readdir(dir))) {
+      if (strlen(dent->d_name) != CACHE_DIR_NAME_LEN)
+         continue;
+
+      snprintf(path, sizeof path, "%s/%s", cache->path, dent->d_name);
+      subdir = opendir(path);
+      if (!subdir)
+         continue;
+
+      while ((subdent = readdir(subdir))) {
+         if (strlen(subdent->d_name) != CACHE_FILE_NAME_LEN)
+            continue;
+
+         snprintf(path, sizeof path, "%s/%s/%s",
+                  cache->path, dent->d_name, subdent->d_name);
+         if (stat(path, &sb) == 0 && S_ISREG(sb.st_mode))
+            cb(data, path, &sb);
+      }
+
+      closedir(subdir);
+   }
+
+   closedir(dir);
+}
+
+
+static void
+add_size_cb(void *data, const char *path, const struct stat *sb)
+{
+   *(uint64_t *)data += sb->st_size;
+}
+
+
+struct file_list {
+   struct cache_file *files;
+   unsigned num_files;
+   unsigned max_files;
+};
+
+
+static void
+add_file_cb(void *data, const char *path, const struct stat *sb)
+{
+   struct file_list *list = data;
+
+   if (list->num_files == list->max_files) {
+      unsigned max_files = list->max_files ? 2 * list->max_files : 256;
+      struct cache_file *files =
+         realloc(list->files, max_files * sizeof *files);
+      if (!files)
+         return;
+      list->files = files;
+      list->max_files = max_files;
+   }
+
+   list->files[list->num_files].path = strdup(path);
+   if (!list->files[list->num_files].path)
+      return;
+   list->files[list->num_files].mtime = sb->st_mtime;
+   list->files[list->num_files].size = sb->st_size;
+   list->num_files++;
+}
+
+
+static int
+compare_mtime(const void *a, const void *b)
+{
+   const struct cache_file *fa = a, *fb = b;
+
+   return (fa->mtime > fb->mtime) - (fa->mtime < fb->mtime);
+}
+
+
+/**
+ * Delete the least recently used entries, as seen from the modification
+ * times, which are refreshed on each hit, until the cache is small enough.
+ * This rescans the directory, which also picks up what other processes
+ * stored since.
+ */
+static void
+evict_lru(struct disk_cache *cache)
+{
+   struct file_list list = { NULL, 0, 0 };
+   uint64_t target = cache->max_size / CACHE_EVICT_DEN * CACHE_EVICT_NUM;
+   uint64_t total = 0, removed = 0;
+   unsigned i;
+
+   for_each_file(cache, add_file_cb, &list);
+
+   for (i = 0; i < list.num_files; i++)
+      total += list.files[i].size;
+
+   qsort(list.files, list.num_files, sizeof *list.files, compare_mtime);
+
+   for (i = 0; i < list.num_files; i++) {
+      if (total - removed > target && unlink(list.files[i].path) == 0)
+         removed += list.files[i].size;
+      free(list.files[i].path);
+   }
+
+   free(list.files);
+
+   /* The scan also counted what other processes stored, which was never
+    * added to the estimate, so subtracting what we deleted could wrap it.
+    * Take the scanned size instead; entries other threads add meanwhile
+    * are picked up by the next scan.
+    */
+   p_atomic_set(&cache->total_size, total - removed);
+}
+
+
+static void
+get_entry_path(struct disk_cache *cache, const cache_key key,
+               char *path, size_t size, bool make_dir)
+{
+   char hex[2 * CACHE_KEY_SIZE + 1];
+
+   _mesa_sha1_format(hex, key);
+
+   snprintf(path, size, "%s/%.*s", cache->path, CACHE_DIR_NAME_LEN, hex);
+   if (make_dir)
+      mkdir_if_needed(path);
+
+   snprintf(path, size, "%s/%.*s/%s", cache->path, CACHE_DIR_NAME_LEN, hex,
+            hex + CACHE_DIR_NAME_LEN);
+}
+
+
+static bool
+write_all(int fd, const void *data, size_t size)
+{
+   const uint8_t *p = data;
+
+   while (size) {
+      ssize_t ret = write(fd, p, size);
+      if (ret < 0) {
+         if (errno == EINTR)
+            continue;
+         return false;
+      }
+      p += ret;
+      size -= ret;
+   }
+
+   return true;
+}
+
+
+static bool
+read_all(int fd, void *data, size_t size)
+{
+   uint8_t *p = data;
+
+   while (size) {
+      ssize_t ret = read(fd, p, size);
+      if (ret < 0) {
+         if (errno == EINTR)
+            continue;
+         return false;
+      }
+      if (ret == 0)
+         return false;
+      p += ret;
+      size -= ret;
+   }
+
+   return true;
+}
+
+
+struct disk_cache *
+disk_cache_create(const char *path, uint64_t max_size)
+{
+   struct disk_cache *cache;
+
+   if (!path || !*path || !max_size)
+      return NULL;
+
+   if (!mkdir_with_parents(path))
+      return NULL;
+
+   cache = calloc(1, sizeof *cache);
+   if (!cache)
+      return NULL;
+
+   cache->path = strdup(path);
+   if (!cache->path) {
+      free(cache);
+      return NULL;
+   }
+
+   cache->max_size = max_size;
+   for_each_file(cache, add_size_cb, &cache->total_size);
+
+   return cache;
+}
+
+
+void
+disk_cache_destroy(struct disk_cache *cache)
+{
+   if (!cache)
+      return;
+
+   free(cache->path);
+   free(cache);
+}
+
+
+void
+disk_cache_put(struct disk_cache *cache, const cache_key key,
+               const void *data, size_t size)
+{
+   struct cache_entry_header header;
+   char path[4096], tmp_path[4096 + 32];
+   int fd;
+
+   if (!cache || size > UINT32_MAX)
+      return;
+
+   get_entry_path(cache, key, path, sizeof path, true);
+   snprintf(tmp_path, sizeof tmp_path, "%s.tmp%ld", path, (long) getpid());
+
+   fd = open(tmp_path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+   if (fd < 0)
+      return;
+
+   header.magic = CACHE_MAGIC;
+   header.size = size;
+   memcpy(header.key, key, CACHE_KEY_SIZE);
+
+   if (!write_all(fd, &header, sizeof header) ||
+       !write_all(fd, data, size)) {
+      close(fd);
+      unlink(tmp_path);
+      return;
+   }
+
+   close(fd);
+
+   if (rename(tmp_path, path) != 0) {
+      unlink(tmp_path);
+      return;
+   }
+
+   p_atomic_add(&cache->total_size, (uint64_t)(sizeof header + size));
+   if (p_atomic_read(&cache->total_size) > cache->max_size)
+      evict_lru(cache);
+}
+
+
+void *
+disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
+{
+   struct cache_entry_header header;
+   char path[4096];
+   void *data;
+   int fd;
+
+   if (!cache)
+      return NULL;
+
+   get_entry_path(cache, key, path, sizeof path, false);
+
+   fd = open(path, O_RDONLY);
+   if (fd < 0)
+      return NULL;
+
+   if (!read_all(fd, &header, sizeof header) ||
+       header.magic != CACHE_MAGIC ||
+       memcmp(header.key, key, CACHE_KEY_SIZE) != 0) {
+      close(fd);
+      return NULL;
+   }
+
+   data = malloc(header.size ? header.size : 1);
+   if (!data || !read_all(fd, data, header.size)) {
+      free(data);
+      close(fd);
+      return NULL;
+   }
+
+   close(fd);
+
+   /* Mark the entry as recently used */
+   utime(path, NULL);
+
+   *size = header.size;
+   return data;
+}
+
+#endif /* ENABLE_SHADER_CACHE */
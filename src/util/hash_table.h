@@ -120,6 +120,25 @@ _mesa_fnv32_1a_accumulate_block(uint32_t hash, const void *data, size_t size)
 #define _mesa_fnv32_1a_accumulate(hash, expr) \
    _mesa_fnv32_1a_accumulate_block(hash, &(expr), sizeof(expr))
 
+static const uint64_t _mesa_fnv64_1a_offset_bias = 14695981039346656037ull;
+
+static inline uint64_t
+_mesa_fnv64_1a_accumulate_block(uint64_t hash, const void *data, size_t size)
+{
+   const uint8_t *bytes = (const uint8_t *)data;
+
+   while (size-- != 0) {
+      hash ^= *bytes;
+      hash = hash * 0x100000001b3ull;
+      bytes++;
+   }
+
+   return hash;
+}
+
+#define _mesa_fnv64_1a_accumulate(hash, expr) \
+   _mesa_fnv64_1a_accumulate_block(hash, &(expr), sizeof(expr))
+
 /**
  * This foreach function is safe against deletion (which just replaces
  * an entry's data with the deleted marker), but not against insertion
@@ -516,3 +516,196 @@ ralloc_vasprintf_rewrite_tail(char **str, size_t *start, const char *fmt,
    *start += new_length;
    return true;
 }
+
+/*
+ * Linear allocator: children of a linear parent are carved out of large
+ * ralloc'd buffers, without a header of their own.  The buffers are ralloc
+ * children of the first one, which the parent lives at the start of, so
+ * freeing or stealing the parent takes all of them along.
+ */
+
+#define LMAGIC 0x87b9c7d3
+
+#define MIN_LINEAR_BUFSIZE 2048
+#define SUBALLOC_ALIGNMENT 8
+
+#define ALIGN_SUBALLOC(size) \
+   (((size) + SUBALLOC_ALIGNMENT - 1) & ~(SUBALLOC_ALIGNMENT - 1))
+
+struct linear_header
+{
+#ifdef DEBUG
+   unsigned magic;
+#endif
+
+   /* The first free byte and the size of this buffer */
+   unsigned offset;
+   unsigned size;
+
+   /* Only meaningful in the first buffer: whether the children are plain
+    * ralloc allocations (RALLOC_NO_LINEAR), and the buffer that the next
+    * child is carved from.
+    */
+   bool use_ralloc;
+   struct linear_header *latest;
+};
+
+typedef struct linear_header linear_header;
+
+#define LINEAR_DATA(node) (((char *) node) + sizeof(linear_header))
+
+static linear_header *
+get_linear_header(const void *parent)
+{
+   linear_header *first = (linear_header *) (((char *) parent) -
+                                             sizeof(linear_header));
+#ifdef DEBUG
+   assert(first->magic == LMAGIC);
+#endif
+   return first;
+}
+
+static linear_header *
+create_linear_node(const void *ctx, unsigned min_size)
+{
+   unsigned size = min_size > MIN_LINEAR_BUFSIZE ? min_size
+                                                 : MIN_LINEAR_BUFSIZE;
+   linear_header *node = ralloc_size(ctx, sizeof(linear_header) + size);
+
+   if (unlikely(node == NULL))
+      return NULL;
+
+#ifdef DEBUG
+   node->magic = LMAGIC;
+#endif
+   node->offset = 0;
+   node->size = size;
+   node->use_ralloc = false;
+   node->latest = node;
+
+   return node;
+}
+
+void *
+linear_alloc_parent(const void *ctx, unsigned size)
+{
+   linear_header *first;
+
+   size = ALIGN_SUBALLOC(size);
+
+   first = create_linear_node(ctx, size);
+   if (unlikely(first == NULL))
+      return NULL;
+
+   first->offset = size;
+   first->use_ralloc = getenv("RALLOC_NO_LINEAR") != NULL;
+
+   return LINEAR_DATA(first);
+}
+
+void *
+linear_zalloc_parent(const void *ctx, unsigned size)
+{
+   void *ptr = linear_alloc_parent(ctx, size);
+   if (likely(ptr != NULL))
+      memset(ptr, 0, size);
+   return ptr;
+}
+
+void *
+linear_alloc_child(void *parent, unsigned size)
+{
+   linear_header *first = get_linear_header(parent);
+   linear_header *node = first->latest;
+   void *ptr;
+
+   if (unlikely(first->use_ralloc))
+      return ralloc_size(first, size);
+
+   size = ALIGN_SUBALLOC(size);
+
+   if (unlikely(node->offset + size > node->size)) {
+      node = create_linear_node(first, size);
+      if (unlikely(node == NULL))
+         return NULL;
+
+      /* Allocations too large to share a buffer get one of their own, and
+       * the latest buffer keeps serving the small ones.
+       */
+      if (size < MIN_LINEAR_BUFSIZE)
+         first->latest = node;
+   }
+
+   ptr = LINEAR_DATA(node) + node->offset;
+   node->offset += size;
+   return ptr;
+}
+
+void *
+linear_zalloc_child(void *parent, unsigned size)
+{
+   void *ptr = linear_alloc_child(parent, size);
+   if (likely(ptr != NULL))
+      memset(ptr, 0, size);
+   return ptr;
+}
+
+void
+linear_free_parent(void *parent)
+{
+   if (unlikely(parent == NULL))
+      return;
+
+   ralloc_free(get_linear_header(parent));
+}
+
+void
+ralloc_steal_linear_parent(const void *new_ctx, void *parent)
+{
+   if (unlikely(parent == NULL))
+      return;
+
+   ralloc_steal(new_ctx, get_linear_header(parent));
+}
+
+char *
+linear_strdup(void *parent, const char *str)
+{
+   size_t n;
+   char *ptr;
+
+   if (unlikely(str == NULL))
+      return NULL;
+
+   n = strlen(str);
+   ptr = linear_alloc_child(parent, n + 1);
+   if (unlikely(ptr == NULL))
+      return NULL;
+
+   memcpy(ptr, str, n);
+   ptr[n] = '\0';
+   return ptr;
+}
+
+char *
+linear_asprintf(void *parent, const char *fmt, ...)
+{
+   char *ptr;
+   va_list args;
+   va_start(args, fmt);
+   ptr = linear_vasprintf(parent, fmt, args);
+   va_end(args);
+   return ptr;
+}
+
+char *
+linear_vasprintf(void *parent, const char *fmt, va_list args)
+{
+   size_t size = printf_length(fmt, args) + 1;
+
+   char *ptr = linear_alloc_child(parent, size);
+   if (ptr != NULL)
+      vsnprintf(ptr, size, fmt, args);
+
+   return ptr;
+}
@@ -407,6 +407,72 @@ bool ralloc_asprintf_append (char **str, const char *fmt, ...)
 bool ralloc_vasprintf_append(char **str, const char *fmt, va_list args);
 /// @}
 
+/**
+ * \defgroup linear Linear Allocator @{
+ *
+ * A linear parent is a ralloc allocation that its linear children are
+ * carved out of, in large buffers, without ralloc's per-allocation header
+ * and \c malloc call.  Linear children can't be freed, stolen or resized
+ * one by one: they all go away when their parent is freed, or when the
+ * ralloc context the parent is chained off of is.  This suits the many
+ * small objects which live as long as some context, like the nodes of a
+ * syntax tree.  A linear parent isn't a ralloc context itself.
+ *
+ * Setting the \c RALLOC_NO_LINEAR environment variable makes every linear
+ * child a separate ralloc allocation, for the sake of memory debuggers.
+ */
+
+/**
+ * Allocate \p size bytes which are also a linear parent, chained off of
+ * the ralloc context \p ctx.
+ */
+void *linear_alloc_parent(const void *ctx, unsigned size) MALLOCLIKE;
+
+/**
+ * Like linear_alloc_parent(), with the memory zeroed.
+ */
+void *linear_zalloc_parent(const void *ctx, unsigned size) MALLOCLIKE;
+
+/**
+ * Allocate \p size bytes out of the linear parent \p parent.
+ */
+void *linear_alloc_child(void *parent, unsigned size) MALLOCLIKE;
+
+/**
+ * Like linear_alloc_child(), with the memory zeroed.
+ */
+void *linear_zalloc_child(void *parent, unsigned size) MALLOCLIKE;
+
+/**
+ * Free a linear parent along with all of its children.
+ */
+void linear_free_parent(void *parent);
+
+/**
+ * Change the ralloc context of a linear parent, like ralloc_steal().
+ */
+void ralloc_steal_linear_parent(const void *new_ctx, void *parent);
+
+/**
+ * Duplicate a string, allocating the memory out of a linear parent.
+ */
+char *linear_strdup(void *parent, const char *str) MALLOCLIKE;
+
+/**
+ * Print to a string allocated out of a linear parent.
+ *
+ * \sa ralloc_asprintf
+ */
+char *linear_asprintf(void *parent, const char *fmt, ...)
+                      PRINTFLIKE(2, 3) MALLOCLIKE;
+
+/**
+ * Print to a string allocated out of a linear parent, given a va_list.
+ */
+char *linear_vasprintf(void *parent, const char *fmt, va_list args)
+                       MALLOCLIKE;
+/// @}
+
 #ifdef __cplusplus
 } /* end of extern "C" */
 #endif
@@ -448,5 +514,26 @@ public:                                                                  \
       ralloc_free(p);                                                    \
    }
 
+/**
+ * Declare C++ new and delete operators which use the linear allocator.
+ *
+ * Like DECLARE_RALLOC_CXX_OPERATORS, except that \c mem_ctx must be a
+ * linear parent and the memory is zeroed.  Deleting an object only runs
+ * its destructor, the memory is given back along with the rest of the
+ * linear parent, which doesn't run any destructor.
+ */
+#define DECLARE_LINEAR_ZALLOC_CXX_OPERATORS(TYPE)                        \
+public:                                                                  \
+   static void* operator new(size_t size, void *mem_ctx)                 \
+   {                                                                     \
+      void *p = linear_zalloc_child(mem_ctx, size);                      \
+      assert(p != NULL);                                                 \
+      return p;                                                          \
+   }                                                                     \
+                                                                         \
+   static void operator delete(void *p)                                  \
+   {                                                                     \
+   }
+
 
 #endif
@@ -68,9 +68,21 @@
  * up front and stored in a 2-dimensional array, so that the cost of
  * coloring a node is constant with the number of registers.  We do
  * this during ra_set_finalize().
+ *
+ * Simplification uses a worklist: a node is pushed as soon as removing a
+ * neighbor makes it pass the pq test, so every edge is visited a constant
+ * number of times.  Only the optimistic choice among the remaining nodes
+ * needs ordering, and that is done with a heap which is built the first
+ * time no node is trivially colorable.
+ *
+ * Graphs with more than RA_SPARSE_NODE_COUNT nodes don't get an
+ * adjacency bitset per node, whose size is quadratic in the node count,
+ * and track which edges exist in a hash set instead.
  */
 
 #include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 #include "ralloc.h"
 #include "main/imports.h"
@@ -81,6 +93,12 @@
 
 #define NO_REG ~0U
 
+/**
+ * Above this many nodes, the interference graph stores its edges in a hash
+ * set instead of a bitset per node.
+ */
+#define RA_SPARSE_NODE_COUNT 4096
+
 struct ra_reg {
    BITSET_WORD *conflicts;
    unsigned int *conflict_list;
@@ -125,7 +143,7 @@ struct ra_node {
    /** @{
     *
     * List of which nodes this node interferes with.  This should be
-    * symmetric with the other node.
+    * symmetric with the other node.  The bitset is NULL in sparse graphs.
     */
    BITSET_WORD *adjacency;
    unsigned int *adjacency_list;
@@ -169,6 +187,26 @@ struct ra_graph {
    unsigned int *stack;
    unsigned int stack_count;
 
+   /** @{
+    * Open-addressed hash set of the edges, only used by sparse graphs.
+    * An edge is stored as (min << 32 | max) and 0 marks an empty slot.
+    */
+   bool sparse;
+   uint64_t *edges;
+   unsigned int edges_size; /**< power of two */
+   unsigned int edges_count;
+   /** @} */
+
+   /** @{
+    * Min-heap of the candidates for optimistic coloring, keyed by q total.
+    * Entries are added again when a node's q total changes, so stale
+    * entries are skipped when popping.
+    */
+   uint64_t *heap;
+   unsigned int heap_size;
+   unsigned int heap_count;
+   /** @} */
+
    /**
     * Tracks the start of the set of optimistically-colored registers in the
     * stack.
@@ -351,10 +389,63 @@ ra_set_finalize(struct ra_regs *regs, unsigned int **q_values)
    }
 }
 
+static inline uint64_t
+ra_edge_key(unsigned int n1, unsigned int n2)
+{
+   return n1 < n2 ? ((uint64_t)n1 << 32) | n2 : ((uint64_t)n2 << 32) | n1;
+}
+
+static inline unsigned int
+ra_edge_hash(const struct ra_graph *g, uint64_t key)
+{
+   return (unsigned int)((key * 0x9e3779b97f4a7c15ull) >> 32) &
+          (g->edges_size - 1);
+}
+
+/**
+ * Inserts the edge into the hash set, returning false if it was already
+ * there.
+ */
+static bool
+ra_edges_insert(struct ra_graph *g, uint64_t key)
+{
+   unsigned int i;
+
+   if (g->edges_count * 2 >= g->edges_size) {
+      uint64_t *old_edges = g->edges;
+      unsigned int old_size = g->edges_size;
+
+      g->edges_size *= 2;
+      g->edges = rzalloc_array(g, uint64_t, g->edges_size);
+      for (i = 0; i < old_size; i++) {
+         unsigned int j;
+
+         if (!old_edges[i])
+            continue;
+         for (j = ra_edge_hash(g, old_edges[i]); g->edges[j];
+              j = (j + 1) & (g->edges_size - 1))
+            ;
+         g->edges[j] = old_edges[i];
+      }
+      ralloc_free(old_edges);
+   }
+
+   for (i = ra_edge_hash(g, key); g->edges[i];
+        i = (i + 1) & (g->edges_size - 1)) {
+      if (g->edges[i] == key)
+         return false;
+   }
+
+   g->edges[i] = key;
+   g->edges_count++;
+   return true;
+}
+
 static void
 ra_add_node_adjacency(struct ra_graph *g, unsigned int n1, unsigned int n2)
 {
-   BITSET_SET(g->nodes[n1].adjacency, n2);
+   if (!g->sparse)
+      BITSET_SET(g->nodes[n1].adjacency, n2);
 
    if (n1 != n2) {
       int n1_class = g->nodes[n1].class;
@@ -387,9 +478,17 @@ ra_alloc_interference_graph(struct ra_regs *regs, unsigned int count)
 
    g->stack = rzalloc_array(g, unsigned int, count);
 
+   g->sparse = count > RA_SPARSE_NODE_COUNT;
+   if (g->sparse) {
+      g->edges_size = 1024;
+      g->edges = rzalloc_array(g, uint64_t, g->edges_size);
+   }
+
    for (i = 0; i < count; i++) {
-      int bitset_count = BITSET_WORDS(count);
-      g->nodes[i].adjacency = rzalloc_array(g, BITSET_WORD, bitset_count);
+      if (!g->sparse) {
+         int bitset_count = BITSET_WORDS(count);
+         g->nodes[i].adjacency = rzalloc_array(g, BITSET_WORD, bitset_count);
+      }
 
       g->nodes[i].adjacency_list_size = 4;
       g->nodes[i].adjacency_list =
@@ -415,10 +514,15 @@ void
 ra_add_node_interference(struct ra_graph *g,
 			 unsigned int n1, unsigned int n2)
 {
-   if (!BITSET_TEST(g->nodes[n1].adjacency, n2)) {
-      ra_add_node_adjacency(g, n1, n2);
-      ra_add_node_adjacency(g, n2, n1);
+   if (g->sparse) {
+      if (n1 == n2 || !ra_edges_insert(g, ra_edge_key(n1, n2)))
+         return;
+   } else if (BITSET_TEST(g->nodes[n1].adjacency, n2)) {
+      return;
    }
+
+   ra_add_node_adjacency(g, n1, n2);
+   ra_add_node_adjacency(g, n2, n1);
 }
 
 static bool
@@ -429,6 +533,79 @@ pq_test(struct ra_graph *g, unsigned int n)
    return g->nodes[n].q_total < g->regs->classes[n_class]->p;
 }
 
+static void
+ra_push_node(struct ra_graph *g, unsigned int n)
+{
+   g->stack[g->stack_count++] = n;
+   g->nodes[n].in_stack = true;
+}
+
+/**
+ * Adds a node to the optimistic candidate heap.  Lower q totals come
+ * first, and among equal ones the higher node number, which is the order
+ * the allocator has always picked optimistic nodes in.
+ */
+static void
+ra_heap_push(struct ra_graph *g, unsigned int n)
+{
+   uint64_t key = ((uint64_t)g->nodes[n].q_total << 32) | (~n & 0xffffffff);
+   unsigned int i;
+
+   if (g->heap_count == g->heap_size) {
+      g->heap_size = MAX2(g->heap_size * 2, 64);
+      g->heap = reralloc(g, g->heap, uint64_t, g->heap_size);
+   }
+
+   for (i = g->heap_count++; i > 0; i = (i - 1) / 2) {
+      unsigned int parent = (i - 1) / 2;
+      if (g->heap[parent] <= key)
+         break;
+      g->heap[i] = g->heap[parent];
+   }
+   g->heap[i] = key;
+}
+
+/**
+ * Returns the remaining node with the lowest q total, or NO_REG.
+ */
+static unsigned int
+ra_heap_pop(struct ra_graph *g)
+{
+   while (g->heap_count) {
+      uint64_t top = g->heap[0];
+      uint64_t last = g->heap[--g->heap_count];
+      unsigned int n = ~(unsigned int)top;
+      unsigned int i = 0;
+
+      for (;;) {
+         unsigned int child = 2 * i + 1;
+         if (child >= g->heap_count)
+            break;
+         if (child + 1 < g->heap_count && g->heap[child + 1] < g->heap[child])
+            child++;
+         if (last <= g->heap[child])
+            break;
+         g->heap[i] = g->heap[child];
+         i = child;
+      }
+      if (g->heap_count)
+         g->heap[i] = last;
+
+      /* Skip nodes which were pushed since, and entries left behind when
+       * the q total dropped.
+       */
+      if (!g->nodes[n].in_stack &&
+          g->nodes[n].q_total == (unsigned int)(top >> 32))
+         return n;
+   }
+
+   return NO_REG;
+}
+
+/**
+ * Removes node n from the graph, pushing any neighbors that become
+ * trivially colorable.
+ */
 static void
 decrement_q(struct ra_graph *g, unsigned int n)
 {
@@ -440,8 +617,18 @@ decrement_q(struct ra_graph *g, unsigned int n)
       unsigned int n2_class = g->nodes[n2].class;
 
       if (n != n2 && !g->nodes[n2].in_stack) {
-         assert(g->nodes[n2].q_total >= g->regs->classes[n2_class]->q[n_class]);
-	 g->nodes[n2].q_total -= g->regs->classes[n2_class]->q[n_class];
+         unsigned int q = g->regs->classes[n2_class]->q[n_class];
+
+         assert(g->nodes[n2].q_total >= q);
+         g->nodes[n2].q_total -= q;
+
+         if (g->nodes[n2].reg != NO_REG || q == 0)
+            continue;
+
+         if (pq_test(g, n2))
+            ra_push_node(g, n2);
+         else if (g->heap)
+            ra_heap_push(g, n2);
       }
    }
 }
@@ -451,6 +638,10 @@ decrement_q(struct ra_graph *g, unsigned int n)
  * trivially-colorable nodes into a stack of nodes to be colored,
  * removing them from the graph, and rinsing and repeating.
  *
+ * The stack doubles as the worklist: nodes are pushed as soon as they
+ * pass the pq test and their edges are removed when the simplification
+ * reaches them.
+ *
  * If we encounter a case where we can't push any nodes on the stack, then
  * we optimistically choose a node and push it on the stack. We heuristically
  * push the node with the lowest total q value, since it has the fewest
@@ -459,45 +650,45 @@ decrement_q(struct ra_graph *g, unsigned int n)
 static void
 ra_simplify(struct ra_graph *g)
 {
-   bool progress = true;
    unsigned int stack_optimistic_start = UINT_MAX;
+   unsigned int next = g->stack_count;
    int i;
 
-   while (progress) {
-      unsigned int best_optimistic_node = ~0;
-      unsigned int lowest_q_total = ~0;
-
-      progress = false;
-
-      for (i = g->count - 1; i >= 0; i--) {
-	 if (g->nodes[i].in_stack || g->nodes[i].reg != NO_REG)
-	    continue;
-
-	 if (pq_test(g, i)) {
-	    decrement_q(g, i);
-	    g->stack[g->stack_count] = i;
-	    g->stack_count++;
-	    g->nodes[i].in_stack = true;
-	    progress = true;
-	 } else {
-	    unsigned int new_q_total = g->nodes[i].q_total;
-	    if (new_q_total < lowest_q_total) {
-	       best_optimistic_node = i;
-	       lowest_q_total = new_q_total;
-	    }
-	 }
-      }
+   for (i = g->count - 1; i >= 0; i--) {
+      if (g->nodes[i].in_stack || g->nodes[i].reg != NO_REG)
+         continue;
+
+      if (pq_test(g, i))
+         ra_push_node(g, i);
+   }
 
-      if (!progress && best_optimistic_node != ~0U) {
-         if (stack_optimistic_start == UINT_MAX)
-            stack_optimistic_start = g->stack_count;
+   for (;;) {
+      unsigned int best_optimistic_node;
 
-	 decrement_q(g, best_optimistic_node);
-	 g->stack[g->stack_count] = best_optimistic_node;
-	 g->stack_count++;
-	 g->nodes[best_optimistic_node].in_stack = true;
-	 progress = true;
+      while (next < g->stack_count)
+         decrement_q(g, g->stack[next++]);
+
+      if (g->stack_count == g->count)
+         break;
+
+      /* Nothing is trivially colorable any more.  Build the heap of the
+       * remaining nodes once; decrement_q() keeps it up to date from here.
+       */
+      if (!g->heap) {
+         for (i = g->count - 1; i >= 0; i--) {
+            if (!g->nodes[i].in_stack && g->nodes[i].reg == NO_REG)
+               ra_heap_push(g, i);
+         }
       }
+
+      best_optimistic_node = ra_heap_pop(g);
+      if (best_optimistic_node == NO_REG)
+         break;
+
+      if (stack_optimistic_start == UINT_MAX)
+         stack_optimistic_start = g->stack_count;
+
+      ra_push_node(g, best_optimistic_node);
    }
 
    g->stack_optimistic_start = stack_optimistic_start;
@@ -514,6 +705,8 @@ static bool
 ra_select(struct ra_graph *g)
 {
    int start_search_reg = 0;
+   BITSET_WORD *blocked = ralloc_array(g, BITSET_WORD,
+                                       BITSET_WORDS(g->regs->count));
 
    while (g->stack_count != 0) {
       unsigned int i;
@@ -522,25 +715,30 @@ ra_select(struct ra_graph *g)
       int n = g->stack[g->stack_count - 1];
       struct ra_class *c = g->regs->classes[g->nodes[n].class];
 
+      /* Collect the registers taken by the neighbors already in the graph,
+       * including everything they conflict with.
+       */
+      memset(blocked, 0, BITSET_WORDS(g->regs->count) * sizeof(BITSET_WORD));
+      for (i = 0; i < g->nodes[n].adjacency_count; i++) {
+         unsigned int n2 = g->nodes[n].adjacency_list[i];
+         struct ra_reg *reg2;
+         unsigned int j;
+
+         if (g->nodes[n2].in_stack || g->nodes[n2].reg == NO_REG)
+            continue;
+
+         reg2 = &g->regs->regs[g->nodes[n2].reg];
+         for (j = 0; j < reg2->num_conflicts; j++)
+            BITSET_SET(blocked, reg2->conflict_list[j]);
+      }
+
       /* Find the lowest-numbered reg which is not used by a member
        * of the graph adjacent to us.
        */
       for (ri = 0; ri < g->regs->count; ri++) {
          r = (start_search_reg + ri) % g->regs->count;
-         if (!reg_belongs_to_class(r, c))
-	    continue;
-
-	 /* Check if any of our neighbors conflict with this register choice. */
-	 for (i = 0; i < g->nodes[n].adjacency_count; i++) {
-	    unsigned int n2 = g->nodes[n].adjacency_list[i];
-
-	    if (!g->nodes[n2].in_stack &&
-		BITSET_TEST(g->regs->regs[r].conflicts, g->nodes[n2].reg)) {
-	       break;
-	    }
-	 }
-	 if (i == g->nodes[n].adjacency_count)
-	    break;
+         if (reg_belongs_to_class(r, c) && !BITSET_TEST(blocked, r))
+            break;
       }
 
       /* set this to false even if we return here so that
@@ -548,8 +746,10 @@ ra_select(struct ra_graph *g)
        */
       g->nodes[n].in_stack = false;
 
-      if (ri == g->regs->count)
-	 return false;
+      if (ri == g->regs->count) {
+         ralloc_free(blocked);
+         return false;
+      }
 
       g->nodes[n].reg = r;
       g->stack_count--;
@@ -568,12 +768,72 @@ ra_select(struct ra_graph *g)
          start_search_reg = r + 1;
    }
 
+   ralloc_free(blocked);
    return true;
 }
 
+/**
+ * Writes the register set and the interference graph in a text format
+ * which src/util/tests/register_allocate/ra_replay can read back, for
+ * benchmarking the allocator on graphs from real shaders.
+ */
+void
+ra_dump_graph(struct ra_graph *g, FILE *f)
+{
+   struct ra_regs *regs = g->regs;
+   unsigned int i, j;
+
+   fprintf(f, "regs %u\n", regs->count);
+   for (i = 0; i < regs->count; i++) {
+      fprintf(f, "reg %u", i);
+      for (j = 0; j < regs->regs[i].num_conflicts; j++) {
+         if (regs->regs[i].conflict_list[j] > i)
+            fprintf(f, " %u", regs->regs[i].conflict_list[j]);
+      }
+      fprintf(f, "\n");
+   }
+
+   fprintf(f, "classes %u\n", regs->class_count);
+   for (i = 0; i < regs->class_count; i++) {
+      fprintf(f, "class %u", i);
+      for (j = 0; j < regs->count; j++) {
+         if (reg_belongs_to_class(j, regs->classes[i]))
+            fprintf(f, " %u", j);
+      }
+      fprintf(f, "\nq %u", i);
+      for (j = 0; j < regs->class_count; j++)
+         fprintf(f, " %u", regs->classes[i]->q[j]);
+      fprintf(f, "\n");
+   }
+
+   fprintf(f, "nodes %u\n", g->count);
+   for (i = 0; i < g->count; i++) {
+      fprintf(f, "node %u %u %d %g", i, g->nodes[i].class,
+              (int)g->nodes[i].reg, g->nodes[i].spill_cost);
+      for (j = 0; j < g->nodes[i].adjacency_count; j++) {
+         if (g->nodes[i].adjacency_list[j] > i)
+            fprintf(f, " %u", g->nodes[i].adjacency_list[j]);
+      }
+      fprintf(f, "\n");
+   }
+
+   fprintf(f, "end\n");
+}
+
 bool
 ra_allocate(struct ra_graph *g)
 {
+   /* MESA_RA_DUMP=<file> appends every graph we allocate to that file. */
+   const char *dump_path = getenv("MESA_RA_DUMP");
+
+   if (dump_path) {
+      FILE *f = fopen(dump_path, "a");
+      if (f) {
+         ra_dump_graph(g, f);
+         fclose(f);
+      }
+   }
+
    ra_simplify(g);
    return ra_select(g);
 }
@@ -26,6 +26,7 @@
  */
 
 #include <stdbool.h>
+#include <stdio.h>
 
 
 #ifdef __cplusplus
@@ -83,6 +84,9 @@ void ra_set_node_spill_cost(struct ra_graph *g, unsigned int n, float cost);
 int ra_get_best_spill_node(struct ra_graph *g);
 /** @} */
 
+/** Writes the graph in the format read by the ra_replay benchmark */
+void ra_dump_graph(struct ra_graph *g, FILE *f);
+
 
 #ifdef __cplusplus
 }  // extern "C"
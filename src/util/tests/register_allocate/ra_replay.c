@@ -0,0 +1,385 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file ra_replay.c
+ *
+ * Register allocator benchmark.
+ *
+ * Replays the interference graphs written by running a driver with
+ * MESA_RA_DUMP=<file>, timing ra_allocate() on each of them:
+ *
+ *    ra_replay <file>...
+ *
+ * Without arguments, it runs on synthetic graphs with the shape of large
+ * generated shaders (many short live ranges, a base register class and an
+ * aligned pair class) instead, so it can serve as a test.  Either way,
+ * every successful allocation is checked for conflicts.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* for getline */
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "ralloc.h"
+#include "register_allocate.h"
+
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+struct replay_graph {
+   unsigned reg_count;
+   unsigned *reg_conflicts;   /**< pairs */
+   unsigned reg_conflict_count;
+
+   unsigned class_count;
+   unsigned **class_regs;
+   unsigned *class_size;
+   unsigned **q;              /**< NULL to let ra_set_finalize() compute it */
+
+   unsigned node_count;
+   unsigned *node_class;
+   int *node_reg;
+   float *node_spill_cost;
+
+   unsigned *edges;           /**< pairs */
+   unsigned edge_count;
+};
+
+static void
+add_pair(void *mem_ctx, unsigned **pairs, unsigned *count,
+         unsigned a, unsigned b)
+{
+   if ((*count & (*count - 1)) == 0)
+      *pairs = reralloc(mem_ctx, *pairs, unsigned, 2 * MAX(*count * 2, 16));
+
+   (*pairs)[2 * *count] = a;
+   (*pairs)[2 * *count + 1] = b;
+   (*count)++;
+}
+
+/**
+ * Parses the unsigned numbers following the keyword on a line.
+ */
+static unsigned
+parse_list(void *mem_ctx, const char *line, unsigned **list)
+{
+   unsigned count = 0, size = 0;
+   char *end;
+
+   *list = NULL;
+   for (;;) {
+      unsigned long v = strtoul(line, &end, 10);
+      if (end == line)
+         break;
+      if (count == size) {
+         size = MAX(size * 2, 16);
+         *list = reralloc(mem_ctx, *list, unsigned, size);
+      }
+      (*list)[count++] = v;
+      line = end;
+   }
+
+   return count;
+}
+
+/**
+ * Reads the next graph from the dump, returning NULL at the end of it.
+ */
+static struct replay_graph *
+read_graph(void *mem_ctx, FILE *f)
+{
+   struct replay_graph *rg = NULL;
+   char *line = NULL;
+   size_t line_size = 0;
+   unsigned i;
+
+   while (getline(&line, &line_size, f) > 0) {
+      char keyword[16];
+      int n, args;
+      unsigned *list;
+      unsigned count;
+
+      if (sscanf(line, "%15s%n", keyword, &n) != 1)
+         continue;
+
+      if (strcmp(keyword, "end") == 0)
+         break;
+
+      if (!rg)
+         rg = rzalloc(mem_ctx, struct replay_graph);
+
+      count = parse_list(rg, line + n, &list);
+      if (count == 0)
+         goto fail;
+
+      if (strcmp(keyword, "regs") == 0) {
+         rg->reg_count = list[0];
+      } else if (strcmp(keyword, "reg") == 0) {
+         for (i = 1; i < count; i++)
+            add_pair(rg, &rg->reg_conflicts, &rg->reg_conflict_count,
+                     list[0], list[i]);
+      } else if (strcmp(keyword, "classes") == 0) {
+         rg->class_count = list[0];
+         rg->class_regs = rzalloc_array(rg, unsigned *, rg->class_count);
+         rg->class_size = rzalloc_array(rg, unsigned, rg->class_count);
+         rg->q = rzalloc_array(rg, unsigned *, rg->class_count);
+      } else if (strcmp(keyword, "class") == 0) {
+         if (list[0] >= rg->class_count)
+            goto fail;
+         rg->class_regs[list[0]] = list + 1;
+         rg->class_size[list[0]] = count - 1;
+      } else if (strcmp(keyword, "q") == 0) {
+         if (list[0] >= rg->class_count || count != rg->class_count + 1)
+            goto fail;
+         rg->q[list[0]] = list + 1;
+      } else if (strcmp(keyword, "nodes") == 0) {
+         rg->node_count = list[0];
+         rg->node_class = rzalloc_array(rg, unsigned, rg->node_count);
+         rg->node_reg = rzalloc_array(rg, int, rg->node_count);
+         rg->node_spill_cost = rzalloc_array(rg, float, rg->node_count);
+      } else if (strcmp(keyword, "node") == 0) {
+         unsigned node;
+         int reg;
+         float cost;
+
+         /* node <n> <class> <reg> <spill cost> <neighbors>... */
+         if (sscanf(line + n, "%u %u %d %f%n", &node, &i, &reg, &cost, &args) != 4 ||
+             node >= rg->node_count)
+            goto fail;
+         rg->node_class[node] = i;
+         rg->node_reg[node] = reg;
+         rg->node_spill_cost[node] = cost;
+
+         ralloc_free(list);
+         count = parse_list(rg, line + n + args, &list);
+         for (i = 0; i < count; i++)
+            add_pair(rg, &rg->edges, &rg->edge_count, node, list[i]);
+      }
+   }
+
+   free(line);
+   return rg;
+
+fail:
+   fprintf(stderr, "malformed line: %s", line);
+   free(line);
+   return NULL;
+}
+
+/**
+ * Random interval graph: each node is live for a few instructions, so the
+ * number of simultaneously live nodes stays around max_live.
+ */
+static struct replay_graph *
+make_graph(void *mem_ctx, unsigned node_count, unsigned max_live)
+{
+   struct replay_graph *rg = rzalloc(mem_ctx, struct replay_graph);
+   unsigned *start, *end;
+   unsigned length = node_count * 8 / max_live;
+   unsigned i, j;
+
+   /* 128 base registers, plus 64 aligned pairs on top of them */
+   rg->reg_count = 128 + 64;
+   for (i = 0; i < 64; i++) {
+      add_pair(rg, &rg->reg_conflicts, &rg->reg_conflict_count, 2 * i, 128 + i);
+      add_pair(rg, &rg->reg_conflicts, &rg->reg_conflict_count, 2 * i + 1, 128 + i);
+   }
+
+   rg->class_count = 2;
+   rg->class_regs = rzalloc_array(rg, unsigned *, 2);
+   rg->class_size = rzalloc_array(rg, unsigned, 2);
+   rg->class_regs[0] = rzalloc_array(rg, unsigned, 128);
+   rg->class_regs[1] = rzalloc_array(rg, unsigned, 64);
+   for (i = 0; i < 128; i++)
+      rg->class_regs[0][i] = i;
+   for (i = 0; i < 64; i++)
+      rg->class_regs[1][i] = 128 + i;
+   rg->class_size[0] = 128;
+   rg->class_size[1] = 64;
+
+   rg->node_count = node_count;
+   rg->node_class = rzalloc_array(rg, unsigned, node_count);
+   rg->node_reg = rzalloc_array(rg, int, node_count);
+   rg->node_spill_cost = rzalloc_array(rg, float, node_count);
+   start = rzalloc_array(rg, unsigned, node_count);
+   end = rzalloc_array(rg, unsigned, node_count);
+
+   /* Nodes are numbered in definition order, as in a real shader. */
+   for (i = 0; i < node_count; i++) {
+      start[i] = (unsigned)((unsigned long long)i * length / node_count);
+      end[i] = start[i] + 1 + rand() % 16;
+      rg->node_class[i] = rand() % 5 == 0;
+      rg->node_reg[i] = -1;
+      rg->node_spill_cost[i] = 1.0f + rand() % 10;
+   }
+
+   for (i = 0; i < node_count; i++) {
+      for (j = i + 1; j < node_count && start[j] < end[i]; j++)
+         add_pair(rg, &rg->edges, &rg->edge_count, i, j);
+   }
+
+   return rg;
+}
+
+static bool
+regs_conflict(const struct replay_graph *rg, const unsigned char *conflicts,
+              unsigned r1, unsigned r2)
+{
+   return r1 == r2 || conflicts[r1 * rg->reg_count + r2];
+}
+
+/**
+ * Allocates the graph, returning false if the result is invalid.
+ */
+static bool
+run_graph(const struct replay_graph *rg, unsigned index)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   struct ra_regs *regs = ra_alloc_reg_set(mem_ctx, rg->reg_count);
+   struct ra_graph *g;
+   unsigned char *conflicts;
+   clock_t t0, t1, t2;
+   bool allocated, valid = true;
+   int spill = -1;
+   unsigned i, j;
+
+   conflicts = rzalloc_array(mem_ctx, unsigned char,
+                             rg->reg_count * rg->reg_count);
+   for (i = 0; i < rg->reg_conflict_count; i++) {
+      unsigned r1 = rg->reg_conflicts[2 * i], r2 = rg->reg_conflicts[2 * i + 1];
+      ra_add_reg_conflict(regs, r1, r2);
+      conflicts[r1 * rg->reg_count + r2] = 1;
+      conflicts[r2 * rg->reg_count + r1] = 1;
+   }
+   for (i = 0; i < rg->class_count; i++) {
+      unsigned c = ra_alloc_reg_class(regs);
+      for (j = 0; j < rg->class_size[i]; j++)
+         ra_class_add_reg(regs, c, rg->class_regs[i][j]);
+   }
+   ra_set_finalize(regs, rg->q);
+
+   t0 = clock();
+
+   g = ra_alloc_interference_graph(regs, rg->node_count);
+   for (i = 0; i < rg->node_count; i++) {
+      ra_set_node_class(g, i, rg->node_class[i]);
+      if (rg->node_reg[i] >= 0)
+         ra_set_node_reg(g, i, rg->node_reg[i]);
+      ra_set_node_spill_cost(g, i, rg->node_spill_cost[i]);
+   }
+   for (i = 0; i < rg->edge_count; i++)
+      ra_add_node_interference(g, rg->edges[2 * i], rg->edges[2 * i + 1]);
+
+   t1 = clock();
+
+   allocated = ra_allocate(g);
+   if (!allocated)
+      spill = ra_get_best_spill_node(g);
+
+   t2 = clock();
+
+   if (allocated) {
+      for (i = 0; i < rg->edge_count; i++) {
+         unsigned n1 = rg->edges[2 * i], n2 = rg->edges[2 * i + 1];
+         if (regs_conflict(rg, conflicts, ra_get_node_reg(g, n1),
+                           ra_get_node_reg(g, n2))) {
+            fprintf(stderr, "graph %u: nodes %u and %u both got reg %u/%u\n",
+                    index, n1, n2, ra_get_node_reg(g, n1),
+                    ra_get_node_reg(g, n2));
+            valid = false;
+            break;
+         }
+      }
+   } else if (spill < 0) {
+      fprintf(stderr, "graph %u: allocation failed without spill candidate\n",
+              index);
+      valid = false;
+   }
+
+   printf("graph %u: %u nodes, %u edges, build %.1f ms, allocate %.1f ms, %s",
+          index, rg->node_count, rg->edge_count,
+          (t1 - t0) * 1000.0 / CLOCKS_PER_SEC,
+          (t2 - t1) * 1000.0 / CLOCKS_PER_SEC,
+          allocated ? "colored" : "spill");
+   if (!allocated)
+      printf(" node %d", spill);
+   printf("\n");
+
+   ralloc_free(g);
+   ralloc_free(mem_ctx);
+
+   return valid;
+}
+
+int
+main(int argc, char **argv)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   unsigned index = 0;
+   bool valid = true;
+   int i;
+
+   if (argc < 2) {
+      static const unsigned sizes[][2] = {
+         /* nodes, live */
+         {   1000,  40 },
+         {  20000,  60 },
+         {  50000,  60 },
+         {  10000, 200 },  /* too many live, needs optimistic coloring */
+      };
+
+      srand(1);
+      for (i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++) {
+         struct replay_graph *rg = make_graph(mem_ctx, sizes[i][0], sizes[i][1]);
+         valid &= run_graph(rg, index++);
+         ralloc_free(rg);
+      }
+   }
+
+   for (i = 1; i < argc; i++) {
+      struct replay_graph *rg;
+      FILE *f = fopen(argv[i], "r");
+
+      if (!f) {
+         fprintf(stderr, "couldn't open %s\n", argv[i]);
+         valid = false;
+         continue;
+      }
+
+      while ((rg = read_graph(mem_ctx, f))) {
+         valid &= run_graph(rg, index++);
+         ralloc_free(rg);
+      }
+
+      fclose(f);
+   }
+
+   ralloc_free(mem_ctx);
+
+   return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "u_queue.h"
+
+struct util_queue_job {
+   struct list_head link;
+   void *job;
+   struct util_queue_fence *fence;
+   util_queue_execute_func execute;
+};
+
+static void
+fence_signal(struct util_queue_fence *fence)
+{
+   mtx_lock(&fence->mutex);
+   fence->signalled = true;
+   cnd_broadcast(&fence->cond);
+   mtx_unlock(&fence->mutex);
+}
+
+void
+util_queue_fence_init(struct util_queue_fence *fence)
+{
+   mtx_init(&fence->mutex, mtx_plain);
+   cnd_init(&fence->cond);
+   fence->signalled = true;
+}
+
+void
+util_queue_fence_destroy(struct util_queue_fence *fence)
+{
+   assert(fence->signalled);
+   cnd_destroy(&fence->cond);
+   mtx_destroy(&fence->mutex);
+}
+
+void
+util_queue_fence_wait(struct util_queue_fence *fence)
+{
+   mtx_lock(&fence->mutex);
+   while (!fence->signalled)
+      cnd_wait(&fence->cond, &fence->mutex);
+   mtx_unlock(&fence->mutex);
+}
+
+static int
+util_queue_thread_func(void *data)
+{
+   struct util_queue *queue = data;
+
+   mtx_lock(&queue->lock);
+
+   for (;;) {
+      struct util_queue_job *job;
+
+      while (list_empty(&queue->jobs) && !queue->kill_threads)
+         cnd_wait(&queue->has_jobs, &queue->lock);
+
+      if (list_empty(&queue->jobs))
+         break;
+
+      job = LIST_ENTRY(struct util_queue_job, queue->jobs.next, link);
+      list_del(&job->link);
+      mtx_unlock(&queue->lock);
+
+      job->execute(job->job);
+      fence_signal(job->fence);
+      free(job);
+
+      mtx_lock(&queue->lock);
+      if (--queue->num_busy == 0)
+         cnd_broadcast(&queue->idle);
+   }
+
+   mtx_unlock(&queue->lock);
+   return 0;
+}
+
+bool
+util_queue_init(struct util_queue *queue, unsigned num_threads)
+{
+   unsigned i;
+
+   assert(num_threads > 0);
+
+   mtx_init(&queue->lock, mtx_plain);
+   cnd_init(&queue->has_jobs);
+   cnd_init(&queue->idle);
+   list_inithead(&queue->jobs);
+   queue->num_busy = 0;
+   queue->kill_threads = false;
+   queue->num_threads = 0;
+
+   queue->threads = malloc(num_threads * sizeof(*queue->threads));
+   if (!queue->threads)
+      goto fail;
+
+   for (i = 0; i < num_threads; i++) {
+      if (thrd_create(&queue->threads[i], util_queue_thread_func,
+                      queue) != thrd_success)
+         break;
+      queue->num_threads++;
+   }
+
+   if (queue->num_threads > 0)
+      return true;
+
+   free(queue->threads);
+fail:
+   cnd_destroy(&queue->idle);
+   cnd_destroy(&queue->has_jobs);
+   mtx_destroy(&queue->lock);
+   return false;
+}
+
+void
+util_queue_destroy(struct util_queue *queue)
+{
+   unsigned i;
+
+   mtx_lock(&queue->lock);
+   queue->kill_threads = true;
+   cnd_broadcast(&queue->has_jobs);
+   mtx_unlock(&queue->lock);
+
+   for (i = 0; i < queue->num_threads; i++)
+      thrd_join(queue->threads[i], NULL);
+   free(queue->threads);
+
+   assert(list_empty(&queue->jobs));
+   cnd_destroy(&queue->idle);
+   cnd_destroy(&queue->has_jobs);
+   mtx_destroy(&queue->lock);
+}
+
+void
+util_queue_add_job(struct util_queue *queue, void *job,
+                   struct util_queue_fence *fence,
+                   util_queue_execute_func execute)
+{
+   struct util_queue_job *entry = malloc(sizeof(*entry));
+
+   assert(fence->signalled);
+
+   if (!entry) {
+      /* Out of memory, so run the job on this thread instead. */
+      execute(job);
+      return;
+   }
+
+   entry->job = job;
+   entry->fence = fence;
+   entry->execute = execute;
+
+   mtx_lock(&fence->mutex);
+   fence->signalled = false;
+   mtx_unlock(&fence->mutex);
+
+   mtx_lock(&queue->lock);
+   list_addtail(&entry->link, &queue->jobs);
+   queue->num_busy++;
+   cnd_signal(&queue->has_jobs);
+   mtx_unlock(&queue->lock);
+}
+
+void
+util_queue_finish(struct util_queue *queue)
+{
+   mtx_lock(&queue->lock);
+   while (queue->num_busy > 0)
+      cnd_wait(&queue->idle, &queue->lock);
+   mtx_unlock(&queue->lock);
+}
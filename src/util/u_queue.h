@@ -0,0 +1,124 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef U_QUEUE_H
+#define U_QUEUE_H
+
+#include <stdbool.h>
+
+#include "c11/threads.h"
+#include "util/list.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A pool of worker threads running jobs in the order they were added.
+ *
+ * Jobs are started in FIFO order, so a job may wait on the fence of any job
+ * added before it without deadlocking the queue.
+ */
+
+/**
+ * Signalled when a job has run.  A fence that was never handed to
+ * util_queue_add_job() is signalled.
+ */
+struct util_queue_fence {
+   mtx_t mutex;
+   cnd_t cond;
+   bool signalled;
+};
+
+typedef void (*util_queue_execute_func)(void *job);
+
+struct util_queue {
+   mtx_t lock;
+   cnd_t has_jobs;
+   cnd_t idle;
+   struct list_head jobs;
+   unsigned num_busy;   /**< jobs queued or running */
+   bool kill_threads;
+
+   unsigned num_threads;
+   thrd_t *threads;
+};
+
+/**
+ * Start \c num_threads worker threads, which must be at least one.
+ *
+ * \return false if no thread could be started.
+ */
+bool
+util_queue_init(struct util_queue *queue, unsigned num_threads);
+
+/**
+ * Run the remaining jobs, then stop the threads.
+ */
+void
+util_queue_destroy(struct util_queue *queue);
+
+void
+util_queue_fence_init(struct util_queue_fence *fence);
+
+/**
+ * Destroy \c fence, which must be signalled.
+ */
+void
+util_queue_fence_destroy(struct util_queue_fence *fence);
+
+/**
+ * Queue a call to \c execute(job), which signals \c fence when it returns.
+ * \c fence must be signalled.
+ */
+void
+util_queue_add_job(struct util_queue *queue, void *job,
+                   struct util_queue_fence *fence,
+                   util_queue_execute_func execute);
+
+void
+util_queue_fence_wait(struct util_queue_fence *fence);
+
+/**
+ * Wait until every job added so far, and any added meanwhile, has run.
+ */
+void
+util_queue_finish(struct util_queue *queue);
+
+static inline bool
+util_queue_fence_is_signalled(struct util_queue_fence *fence)
+{
+   bool signalled;
+
+   mtx_lock(&fence->mutex);
+   signalled = fence->signalled;
+   mtx_unlock(&fence->mutex);
+
+   return signalled;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_QUEUE_H */